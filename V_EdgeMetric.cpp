@@ -19,6 +19,7 @@
  */
 
 #include "verdict.h"
+#include "V_Instrumentation.hpp"
 #include <math.h>
 
 namespace VERDICT_NAMESPACE
@@ -28,6 +29,7 @@ namespace VERDICT_NAMESPACE
  */
 double edge_length( int /*num_nodes*/, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( edge_length );
 
   double x = coordinates[1][0] - coordinates[0][0];
   double y = coordinates[1][1] - coordinates[0][1];
@@ -1089,4 +1089,96 @@ void GaussIntegration::get_node_local_coord_tet(int node_id, double &y1, double
       break;
    }
 }
+
+void make_gauss_tables(GaussElementType type, int number_gauss_points, int number_nodes,
+                       GaussTables &tables)
+{
+   // the integration object is about as large as the tables
+   ScratchFrame frame;
+   GaussIntegration &gint = *frame.create<GaussIntegration>();
+   switch (type)
+   {
+   case GAUSS_QUAD:
+      gint.initialize(number_gauss_points, number_nodes);
+      gint.calculate_shape_function_2d_quad();
+      gint.get_shape_func(tables.shapeFunction[0], tables.dndy1GaussPts[0],
+                          tables.dndy2GaussPts[0], tables.totalGaussWeight);
+      gint.calculate_derivative_at_nodes(tables.dndy1AtNodes, tables.dndy2AtNodes);
+      break;
+   case GAUSS_TRI:
+      gint.initialize(number_gauss_points, number_nodes, 2, 1);
+      gint.calculate_shape_function_2d_tri();
+      gint.get_shape_func(tables.shapeFunction[0], tables.dndy1GaussPts[0],
+                          tables.dndy2GaussPts[0], tables.totalGaussWeight);
+      gint.calculate_derivative_at_nodes_2d_tri(tables.dndy1AtNodes, tables.dndy2AtNodes);
+      break;
+   case GAUSS_HEX:
+      gint.initialize(number_gauss_points, number_nodes, 3);
+      gint.calculate_shape_function_3d_hex();
+      gint.get_shape_func(tables.shapeFunction[0], tables.dndy1GaussPts[0],
+                          tables.dndy2GaussPts[0], tables.dndy3GaussPts[0],
+                          tables.totalGaussWeight);
+      gint.calculate_derivative_at_nodes_3d(tables.dndy1AtNodes, tables.dndy2AtNodes,
+                                            tables.dndy3AtNodes);
+      break;
+   case GAUSS_TET:
+      gint.initialize(number_gauss_points, number_nodes, 3, 1);
+      gint.calculate_shape_function_3d_tet();
+      gint.get_shape_func(tables.shapeFunction[0], tables.dndy1GaussPts[0],
+                          tables.dndy2GaussPts[0], tables.dndy3GaussPts[0],
+                          tables.totalGaussWeight);
+      gint.calculate_derivative_at_nodes_3d_tet(tables.dndy1AtNodes, tables.dndy2AtNodes,
+                                                tables.dndy3AtNodes);
+      break;
+   }
+   tables.totalNumberGaussPts = gint.totalNumberGaussPts;
+}
+
+static GaussTables computed_gauss_tables(GaussElementType type, int number_gauss_points,
+                                         int number_nodes)
+{
+   GaussTables tables = GaussTables();
+   make_gauss_tables(type, number_gauss_points, number_nodes, tables);
+   return tables;
+}
+
+const GaussTables& gauss_tables(GaussElementType type, int number_gauss_points, int number_nodes,
+                                ScratchFrame &frame)
+{
+   // function scope statics are initialized once, even with concurrent callers
+   if (type == GAUSS_QUAD && number_gauss_points == 2 && number_nodes == 4)
+   {
+      static const GaussTables quad4 = computed_gauss_tables(GAUSS_QUAD, 2, 4);
+      return quad4;
+   }
+   if (type == GAUSS_QUAD && number_gauss_points == 3 && number_nodes == 8)
+   {
+      static const GaussTables quad8 = computed_gauss_tables(GAUSS_QUAD, 3, 8);
+      return quad8;
+   }
+   if (type == GAUSS_TRI && number_gauss_points == 6 && number_nodes == 6)
+   {
+      static const GaussTables tri6 = computed_gauss_tables(GAUSS_TRI, 6, 6);
+      return tri6;
+   }
+   if (type == GAUSS_HEX && number_gauss_points == 2 && number_nodes == 8)
+   {
+      static const GaussTables hex8 = computed_gauss_tables(GAUSS_HEX, 2, 8);
+      return hex8;
+   }
+   if (type == GAUSS_HEX && number_gauss_points == 3 && number_nodes == 20)
+   {
+      static const GaussTables hex20 = computed_gauss_tables(GAUSS_HEX, 3, 20);
+      return hex20;
+   }
+   if (type == GAUSS_TET && number_gauss_points == 4 && number_nodes == 10)
+   {
+      static const GaussTables tet10 = computed_gauss_tables(GAUSS_TET, 4, 10);
+      return tet10;
+   }
+
+   GaussTables &tables = *frame.create<GaussTables>();
+   make_gauss_tables(type, number_gauss_points, number_nodes, tables);
+   return tables;
+}
 } // namespace verdict
@@ -27,6 +27,7 @@
 
 
 #include "verdict.h"
+#include "V_ScratchArena.hpp"
 
 namespace VERDICT_NAMESPACE
 {
@@ -122,6 +123,40 @@ struct GaussIntegration
    double y3Volume[maxNumberGaussPointsTet];
    double y4Volume[maxNumberGaussPointsTet];
 };
+
+//! element types with shape function tables
+enum GaussElementType
+{
+   GAUSS_QUAD,
+   GAUSS_TRI,
+   GAUSS_HEX,
+   GAUSS_TET
+};
+
+//! shape functions and their derivatives at the integration points and at
+//! the nodes, for one element type, number of gauss points and number of nodes
+struct GaussTables
+{
+   int totalNumberGaussPts;
+   double shapeFunction[maxTotalNumberGaussPoints][maxNumberNodes];
+   double dndy1GaussPts[maxTotalNumberGaussPoints][maxNumberNodes];
+   double dndy2GaussPts[maxTotalNumberGaussPoints][maxNumberNodes];
+   double dndy3GaussPts[maxTotalNumberGaussPoints][maxNumberNodes];
+   double totalGaussWeight[maxTotalNumberGaussPoints];
+   double dndy1AtNodes[maxNumberNodes][maxNumberNodes];
+   double dndy2AtNodes[maxNumberNodes][maxNumberNodes];
+   double dndy3AtNodes[maxNumberNodes][maxNumberNodes];
+};
+
+void make_gauss_tables(GaussElementType type, int number_gauss_points, int number_nodes,
+                       GaussTables &tables);
+//- evaluate the tables with a GaussIntegration object
+
+const GaussTables& gauss_tables(GaussElementType type, int number_gauss_points, int number_nodes,
+                                ScratchFrame &frame);
+//- the tables of the rules used by the distortion metrics are computed once,
+//- on first use (thread safe), and shared read-only.  The tables of any other
+//- rule are computed into scratch memory of frame, which is returned.
 } // namespace verdict
 
 #endif 
@@ -18,10 +18,15 @@
  */
 
 #include "verdict.h"
+#include "verdict_fixed.h"
 #include "VerdictVector.hpp"
 #include "V_GaussIntegration.hpp"
 #include "verdict_defines.hpp"
 #include <V_HexMetric.hpp>
+#include "V_SizeMetric.hpp"
+#include "V_TimestepMetric.hpp"
+#include "V_Instrumentation.hpp"
+#include "V_NodalJacobian.hpp"
 #include <memory.h>
 #include <vector>
 #include <algorithm>
@@ -193,7 +198,7 @@ static int hex27_subtet_conn[48][4] =
   {21, 11, 8, 20}  
 };
 
-static double compute_tet_volume( VerdictVector &v1, VerdictVector &v2, VerdictVector &v3 )
+static double compute_tet_volume( const VerdictVector &v1, const VerdictVector &v2, const VerdictVector &v3 )
 {
   return  (double)((v3 % (v1*v2)) / 6.0);
 }
@@ -336,6 +341,13 @@ static void HEX27_gradients_of_the_shape_functions_for_RST(const double rst[3],
   }
 }
 
+//! the gradients of the shape functions at the nodes, tabulated on first use
+static const NodalGradients<27> &hex27_nodal_gradients()
+{
+  static const NodalGradients<27> gradients( HEX27_gradients_of_the_shape_functions_for_RST, HEX27_node_local_coord );
+  return gradients;
+}
+
 #define make_hex_nodes(coord, pos)                      \
   for (int mhcii = 0; mhcii < 8; mhcii++ )              \
   {                                                     \
@@ -545,6 +557,7 @@ static double safe_ratio( const double numerator,
     }
   else
     {
+    VERDICT_COUNT_EVENT( "hex safe_ratio: clamped" );
     return_value = VERDICT_DBL_MAX;
     }
 
@@ -866,6 +879,7 @@ static VerdictVector calc_hex_efg( int efg_index, VerdictVector coordinates[8])
 */
 double hex_edge_ratio (int /*num_nodes*/, double coordinates[][3])
 {
+  VERDICT_INSTRUMENT_METRIC( hex_edge_ratio );
 
   VerdictVector edges[12];
   make_hex_edges(coordinates, edges);
@@ -982,6 +996,7 @@ double hex_edge_ratio (int /*num_nodes*/, double coordinates[][3])
 */
 double hex_max_edge_ratio (int /*num_nodes*/, double coordinates[][3])
 {
+  VERDICT_INSTRUMENT_METRIC( hex_max_edge_ratio );
   double aspect;
   VerdictVector node_pos[8];
   make_hex_nodes ( coordinates, node_pos );
@@ -1010,6 +1025,7 @@ double hex_max_edge_ratio (int /*num_nodes*/, double coordinates[][3])
 
 double hex_equiangle_skew( int /*num_nodes*/, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( hex_equiangle_skew );
   double quad[4][3];
   double min_angle=360.0;
   double max_angle=0.0;
@@ -1153,6 +1169,7 @@ double hex_equiangle_skew( int /*num_nodes*/, double coordinates[][3] )
 */
 double hex_skew( int /*num_nodes*/, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( hex_skew );
   VerdictVector node_pos[8];
   make_hex_nodes ( coordinates, node_pos );
   
@@ -1187,6 +1204,7 @@ double hex_skew( int /*num_nodes*/, double coordinates[][3] )
 */
 double hex_taper( int /*num_nodes*/, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( hex_taper );
   VerdictVector node_pos[8];
   make_hex_nodes ( coordinates, node_pos );
   
@@ -1209,109 +1227,143 @@ double hex_taper( int /*num_nodes*/, double coordinates[][3] )
   return (double) std::max( taper, -VERDICT_DBL_MAX );
 }
 
+//! clamps a volume to the representable range
+static inline double clamp_volume( double volume )
+{
+  if (volume > 0)
+    return (double)std::min(volume, VERDICT_DBL_MAX);
+  return (double)std::max(volume, -VERDICT_DBL_MAX);
+}
+
 /*!
-  volume of a hex
-  Split the hex into 24 tets.
-  sum the volume of each tet.
+  volume of a quadratic hex, split into the NumSubtets tets of
+  subtet_conn_array around the auxillary node
 */
-double hex_volume( int num_nodes, double coordinates[][3] )
+template <int NumSubtets>
+static double higher_order_hex_volume( double coordinates[][3], int (*subtet_conn_array)[4] )
 {
   double volume = 0.0;
+  VerdictVector aux_node = hex20_auxillary_node_coordinate(coordinates);
 
-  if (num_nodes>9)
-  {    
-    int (*subtet_conn_array)[4];
-    int num_subtets = 0;
-    if (27 == num_nodes)
-    {
-      num_subtets = 48;
-      subtet_conn_array = hex27_subtet_conn;
-    }
-    else if (20 == num_nodes)
-    {
-      num_subtets = 36;
-      subtet_conn_array = hex20_subtet_conn;
-    }
-    else
-      return 0.0;
+  for (int k = 0; k < NumSubtets; k++)
+  {
+    VerdictVector v1(
+      coordinates[subtet_conn_array[k][1]][0] - coordinates[subtet_conn_array[k][0]][0],
+      coordinates[subtet_conn_array[k][1]][1] - coordinates[subtet_conn_array[k][0]][1],
+      coordinates[subtet_conn_array[k][1]][2] - coordinates[subtet_conn_array[k][0]][2]);
+    
+    VerdictVector v2(
+      coordinates[subtet_conn_array[k][2]][0] - coordinates[subtet_conn_array[k][0]][0],
+      coordinates[subtet_conn_array[k][2]][1] - coordinates[subtet_conn_array[k][0]][1],
+      coordinates[subtet_conn_array[k][2]][2] - coordinates[subtet_conn_array[k][0]][2]);
+    
+    VerdictVector v3(
+      aux_node.x() - coordinates[subtet_conn_array[k][0]][0],
+      aux_node.y() - coordinates[subtet_conn_array[k][0]][1],
+      aux_node.z() - coordinates[subtet_conn_array[k][0]][2]);        
 
-    VerdictVector aux_node = hex20_auxillary_node_coordinate(coordinates);
+    volume += compute_tet_volume( v1, v2, v3 );
+  }
+  return clamp_volume( volume );
+}
 
-    for (int k = 0; k < num_subtets; k++)
-    {
-      VerdictVector v1(
-        coordinates[subtet_conn_array[k][1]][0] - coordinates[subtet_conn_array[k][0]][0],
-        coordinates[subtet_conn_array[k][1]][1] - coordinates[subtet_conn_array[k][0]][1],
-        coordinates[subtet_conn_array[k][1]][2] - coordinates[subtet_conn_array[k][0]][2]);
-      
-      VerdictVector v2(
-        coordinates[subtet_conn_array[k][2]][0] - coordinates[subtet_conn_array[k][0]][0],
-        coordinates[subtet_conn_array[k][2]][1] - coordinates[subtet_conn_array[k][0]][1],
-        coordinates[subtet_conn_array[k][2]][2] - coordinates[subtet_conn_array[k][0]][2]);
-      
-      VerdictVector v3(
-        aux_node.x() - coordinates[subtet_conn_array[k][0]][0],
-        aux_node.y() - coordinates[subtet_conn_array[k][0]][1],
-        aux_node.z() - coordinates[subtet_conn_array[k][0]][2]);        
+namespace fixed
+{
 
-      volume += compute_tet_volume( v1, v2, v3 );
-    }
-  }  
-  else
+/*!
+  volume of a linear hex
+  Split the hex into 24 tets.
+  sum the volume of each tet.
+*/
+template <>
+double hex_volume<8>( double coordinates[][3] )
+{
+  double volume = 0.0;
+
+  VerdictVector node_pos[8];
+  make_hex_nodes(coordinates, node_pos);
+
+  //define the nodes of each face of the hex
+  int faces[6][4] =
   {
+    {0,1,5,4},
+    {1,2,6,5},
+    {2,3,7,6},
+    {3,0,4,7},
+    {3,2,1,0},
+    {4,5,6,7},
+  };
 
-    VerdictVector node_pos[8];
-    make_hex_nodes(coordinates, node_pos);
+  //calculate the center of each face
+  VerdictVector fcenter[6];
+  for (int f = 0; f < 6; f++)
+  {
+    fcenter[f] = (node_pos[faces[f][0]] + node_pos[faces[f][1]] + node_pos[faces[f][2]] + node_pos[faces[f][3]]) * 0.25;
+  }
 
-    //define the nodes of each face of the hex
-    int faces[6][4] =
-    {
-      {0,1,5,4},
-      {1,2,6,5},
-      {2,3,7,6},
-      {3,0,4,7},
-      {3,2,1,0},
-      {4,5,6,7},
-    };
-
-    //calculate the center of each face
-    VerdictVector fcenter[6];
-    for (int f = 0; f < 6; f++)
+  //calculate the center of the hex
+  VerdictVector hcenter = (node_pos[0] + node_pos[1] + node_pos[2] + node_pos[3] +
+    node_pos[4] + node_pos[5] + node_pos[6] + node_pos[7]) * 0.125;
+  
+  for (int i = 0; i < 6; i++)
+  {
+    //for each face calculate the vectors from the nodes and center of the face to the center of the hex.
+    //These vectors define three of the sides of the tets.
+    VerdictVector side[5];
+    side[4] = hcenter - fcenter[i];//vector from center of face to center of hex.
+    for (int s = 0; s < 4; s++)
     {
-      fcenter[f] = (node_pos[faces[f][0]] + node_pos[faces[f][1]] + node_pos[faces[f][2]] + node_pos[faces[f][3]]) * 0.25;
+      side[s] = hcenter - node_pos[faces[i][s]];//vector from face node to center of hex.
     }
 
-    //calculate the center of the hex
-    VerdictVector hcenter = (node_pos[0] + node_pos[1] + node_pos[2] + node_pos[3] +
-      node_pos[4] + node_pos[5] + node_pos[6] + node_pos[7]) * 0.125;
-    
-    for (int i = 0; i < 6; i++)
+    //for each of the four tets that originate from this face.
+    //calculate the volume of the tet.
+    //This is done by calculating the triple product of three vectors that originate from a corner node of the tet.
+    //This is also the jacobain at the corner node of the tet.
+    //The volume is 1/6 of jacobian at a corner node.
+    for (int j = 0; j < 3; j++)//first three tets
     {
-      //for each face calculate the vectors from the nodes and center of the face to the center of the hex.
-      //These vectors define three of the sides of the tets.
-      VerdictVector side[5];
-      side[4] = hcenter - fcenter[i];//vector from center of face to center of hex.
-      for (int s = 0; s < 4; s++)
-      {
-        side[s] = hcenter - node_pos[faces[i][s]];//vector from face node to center of hex.
-      }
-
-      //for each of the four tets that originate from this face.
-      //calculate the volume of the tet.
-      //This is done by calculating the triple product of three vectors that originate from a corner node of the tet.
-      //This is also the jacobain at the corner node of the tet.
-      //The volume is 1/6 of jacobian at a corner node.
-      for (int j = 0; j < 3; j++)//first three tets
-      {
-        volume += (double)(VerdictVector::Dot(side[4], (side[j + 1] * side[j])) / 6.0);
-      }
-      volume += (double)(VerdictVector::Dot(side[4], (side[0] * side[3])) / 6.0);//fourth tet.
+      volume += (double)(VerdictVector::Dot(side[4], (side[j + 1] * side[j])) / 6.0);
     }
+    volume += (double)(VerdictVector::Dot(side[4], (side[0] * side[3])) / 6.0);//fourth tet.
   }
 
-  if (volume > 0)
-    return (double)std::min(volume, VERDICT_DBL_MAX);
-  return (double)std::max(volume, -VERDICT_DBL_MAX);
+  return clamp_volume( volume );
+}
+
+//! volume of a 20 node hex, split into 36 tets
+template <>
+double hex_volume<20>( double coordinates[][3] )
+{
+  return higher_order_hex_volume<36>( coordinates, hex20_subtet_conn );
+}
+
+//! volume of a 27 node hex, split into 48 tets
+template <>
+double hex_volume<27>( double coordinates[][3] )
+{
+  return higher_order_hex_volume<48>( coordinates, hex27_subtet_conn );
+}
+
+} // namespace fixed
+
+/*!
+  volume of a hex
+  Split the hex into 24 tets.
+  sum the volume of each tet.
+
+  0 for a higher order hex that has neither 20 nodes nor 27
+*/
+double hex_volume( int num_nodes, double coordinates[][3] )
+{
+  VERDICT_INSTRUMENT_METRIC( hex_volume );
+  if ( num_nodes == 27 )
+    return fixed::hex_volume<27>( coordinates );
+  if ( num_nodes == 20 )
+    return fixed::hex_volume<20>( coordinates );
+  if ( num_nodes > 9 )
+    return 0.0;
+  return fixed::hex_volume<8>( coordinates );
 }
 
 /*!
@@ -1321,6 +1373,7 @@ double hex_volume( int num_nodes, double coordinates[][3] )
 */
 double hex_stretch( int /*num_nodes*/, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( hex_stretch );
   double min_edge = hex_edge_length( 0, coordinates );
   double max_diag = diag_length( 1, coordinates );  
   
@@ -1338,6 +1391,7 @@ double hex_stretch( int /*num_nodes*/, double coordinates[][3] )
 */
 double hex_diagonal( int /*num_nodes*/, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( hex_diagonal );
   
   double min_diag = diag_length( 0, coordinates ); 
   double max_diag = diag_length( 1, coordinates );
@@ -1357,9 +1411,8 @@ double hex_diagonal( int /*num_nodes*/, double coordinates[][3] )
   Pronto-specific characteristic length for stable time step calculation. 
   Char_length = Volume / 2 grad Volume
 */
-double hex_dimension( int /*num_nodes*/, double coordinates[][3] )
+static double hex_characteristic_length( double coordinates[][3] )
 {
-  
   double gradop[9][4];
 
   double x1 = coordinates[0][0];
@@ -1564,6 +1617,24 @@ double hex_dimension( int /*num_nodes*/, double coordinates[][3] )
   
 }
 
+double hex_dimension( int /*num_nodes*/, double coordinates[][3] )
+{
+  VERDICT_INSTRUMENT_METRIC( hex_dimension );
+  return hex_characteristic_length( coordinates );
+}
+
+double hex_timestep_length( double coordinates[][3], bool &inverted )
+{
+  double jacobians[8];
+  verdict::hex_nodal_jacobians( &coordinates[0][0], jacobians );
+  const double smallest = std::min( std::min( std::min( jacobians[0], jacobians[1] ),
+                                              std::min( jacobians[2], jacobians[3] ) ),
+                                    std::min( std::min( jacobians[4], jacobians[5] ),
+                                              std::min( jacobians[6], jacobians[7] ) ) );
+  inverted = !( smallest > 0 );
+  return hex_characteristic_length( coordinates );
+}
+
 /*!
   oddy of a hex
 
@@ -1571,6 +1642,7 @@ double hex_dimension( int /*num_nodes*/, double coordinates[][3] )
 */
 double hex_oddy( int /*num_nodes*/, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( hex_oddy );
   
   double oddy = 0.0, current_oddy;
   VerdictVector xxi, xet, xze;
@@ -1728,6 +1800,7 @@ double hex_oddy( int /*num_nodes*/, double coordinates[][3] )
 */
 double hex_med_aspect_frobenius( int /*num_nodes*/, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( hex_med_aspect_frobenius );
 
   VerdictVector node_pos[8];
   make_hex_nodes ( coordinates, node_pos );
@@ -1814,6 +1887,7 @@ double hex_med_aspect_frobenius( int /*num_nodes*/, double coordinates[][3] )
 */
 double hex_max_aspect_frobenius( int /*num_nodes*/, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( hex_max_aspect_frobenius );
 
   VerdictVector node_pos[8];
   make_hex_nodes ( coordinates, node_pos );
@@ -1906,191 +1980,188 @@ double hex_max_aspect_frobenius( int /*num_nodes*/, double coordinates[][3] )
 */
 double hex_condition( int /*num_nodes*/, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( hex_condition );
 
   return hex_max_aspect_frobenius(8, coordinates);
 }
 
+namespace fixed
+{
+
+//! jacobian of a 27 node hex: minimum pointwise volume of local map at the 27 nodes
+template <>
+double hex_jacobian<27>( double coordinates[][3] )
+{
+  const NodalGradients<27> &gradients = hex27_nodal_gradients();
+  double min_determinant = VERDICT_DBL_MAX;
+
+  double determinants[27];
+  nodal_jacobian_determinants( gradients, coordinates, determinants );
+  for(int i=0; i<27; i++)
+    min_determinant = std::min(determinants[i], min_determinant);
+  return min_determinant;
+}
+
 /*!
-  jacobian of a hex
+  jacobian of a linear hex
 
   Minimum pointwise volume of local map at 8 corners & center of hex
 */
-double hex_jacobian( int num_nodes, double coordinates[][3] )
+template <>
+double hex_jacobian<8>( double coordinates[][3] )
 {
-  if(num_nodes == 27)
-  {
-    double dhdr[27];
-    double dhds[27];
-    double dhdt[27];
-    double min_determinant = VERDICT_DBL_MAX;
-
-    for(int i=0; i<27; i++)
-    {
-      HEX27_gradients_of_the_shape_functions_for_RST(HEX27_node_local_coord[i], dhdr, dhds, dhdt);
-      double jacobian[3][3] = {{0,0,0},{0,0,0},{0,0,0}};
-
-      for(int j=0; j<27; j++)
-      {
-        jacobian[0][0]+=coordinates[j][0]*dhdr[j];
-        jacobian[0][1]+=coordinates[j][0]*dhds[j];
-        jacobian[0][2]+=coordinates[j][0]*dhdt[j];
-        jacobian[1][0]+=coordinates[j][1]*dhdr[j];
-        jacobian[1][1]+=coordinates[j][1]*dhds[j];
-        jacobian[1][2]+=coordinates[j][1]*dhdt[j];
-        jacobian[2][0]+=coordinates[j][2]*dhdr[j];
-        jacobian[2][1]+=coordinates[j][2]*dhds[j];
-        jacobian[2][2]+=coordinates[j][2]*dhdt[j];
-      }
-      double det = VerdictVector::Dot((VerdictVector(jacobian[0]) * VerdictVector(jacobian[1])), VerdictVector(jacobian[2]));
-      min_determinant = std::min(det, min_determinant);
-    }
-    return min_determinant;
-  }
-  else
-  {
-    VerdictVector node_pos[8];
-    make_hex_nodes ( coordinates, node_pos );
+  VerdictVector node_pos[8];
+  make_hex_nodes ( coordinates, node_pos );
 
-    double jacobian = VERDICT_DBL_MAX;
-    double current_jacobian;
-    VerdictVector xxi, xet, xze;
+  double jacobian = VERDICT_DBL_MAX;
+  double current_jacobian;
+  VerdictVector xxi, xet, xze;
 
-    xxi = calc_hex_efg(1, node_pos );
-    xet = calc_hex_efg(2, node_pos );
-    xze = calc_hex_efg(3, node_pos );
+  xxi = calc_hex_efg(1, node_pos );
+  xet = calc_hex_efg(2, node_pos );
+  xze = calc_hex_efg(3, node_pos );
 
 
-    current_jacobian = VerdictVector::Dot(xxi, (xet * xze)) / 64.0;
-    if ( current_jacobian < jacobian ) { jacobian = current_jacobian; }
+  current_jacobian = VerdictVector::Dot(xxi, (xet * xze)) / 64.0;
+  if ( current_jacobian < jacobian ) { jacobian = current_jacobian; }
 
-    // J(0,0,0):
+  // J(0,0,0):
 
-    xxi = node_pos[1] - node_pos[0];
-    xet = node_pos[3] - node_pos[0];
-    xze = node_pos[4] - node_pos[0];
+  xxi = node_pos[1] - node_pos[0];
+  xet = node_pos[3] - node_pos[0];
+  xze = node_pos[4] - node_pos[0];
 
-    current_jacobian = VerdictVector::Dot(xxi, (xet * xze));
-    if ( current_jacobian < jacobian ) { jacobian = current_jacobian; }
+  current_jacobian = VerdictVector::Dot(xxi, (xet * xze));
+  if ( current_jacobian < jacobian ) { jacobian = current_jacobian; }
 
-    // J(1,0,0):
+  // J(1,0,0):
 
-    xxi = node_pos[2] - node_pos[1];
-    xet = node_pos[0] - node_pos[1];
-    xze = node_pos[5] - node_pos[1];
+  xxi = node_pos[2] - node_pos[1];
+  xet = node_pos[0] - node_pos[1];
+  xze = node_pos[5] - node_pos[1];
 
-    current_jacobian = VerdictVector::Dot(xxi, (xet * xze));
-    if ( current_jacobian < jacobian ) { jacobian = current_jacobian; }
+  current_jacobian = VerdictVector::Dot(xxi, (xet * xze));
+  if ( current_jacobian < jacobian ) { jacobian = current_jacobian; }
 
-    // J(1,1,0):
+  // J(1,1,0):
 
-    xxi = node_pos[3] - node_pos[2];
-    xet = node_pos[1] - node_pos[2];
-    xze = node_pos[6] - node_pos[2];
+  xxi = node_pos[3] - node_pos[2];
+  xet = node_pos[1] - node_pos[2];
+  xze = node_pos[6] - node_pos[2];
 
-    current_jacobian = VerdictVector::Dot(xxi, (xet * xze));
-    if ( current_jacobian < jacobian ) { jacobian = current_jacobian; }
+  current_jacobian = VerdictVector::Dot(xxi, (xet * xze));
+  if ( current_jacobian < jacobian ) { jacobian = current_jacobian; }
 
-    // J(0,1,0):
+  // J(0,1,0):
 
-    xxi = node_pos[0] - node_pos[3];
-    xet = node_pos[2] - node_pos[3];
-    xze = node_pos[7] - node_pos[3];
+  xxi = node_pos[0] - node_pos[3];
+  xet = node_pos[2] - node_pos[3];
+  xze = node_pos[7] - node_pos[3];
 
-    current_jacobian = VerdictVector::Dot(xxi, (xet * xze));
-    if ( current_jacobian < jacobian ) { jacobian = current_jacobian; }
+  current_jacobian = VerdictVector::Dot(xxi, (xet * xze));
+  if ( current_jacobian < jacobian ) { jacobian = current_jacobian; }
 
-    // J(0,0,1):
+  // J(0,0,1):
 
-    xxi = node_pos[7] - node_pos[4];
-    xet = node_pos[5] - node_pos[4];
-    xze = node_pos[0] - node_pos[4];
+  xxi = node_pos[7] - node_pos[4];
+  xet = node_pos[5] - node_pos[4];
+  xze = node_pos[0] - node_pos[4];
 
-    current_jacobian = xxi % (xet * xze);
-    if ( current_jacobian < jacobian ) { jacobian = current_jacobian; }
+  current_jacobian = xxi % (xet * xze);
+  if ( current_jacobian < jacobian ) { jacobian = current_jacobian; }
 
-    // J(1,0,1):
+  // J(1,0,1):
 
-    xxi = node_pos[4] - node_pos[5];
-    xet = node_pos[6] - node_pos[5];
-    xze = node_pos[1] - node_pos[5];
+  xxi = node_pos[4] - node_pos[5];
+  xet = node_pos[6] - node_pos[5];
+  xze = node_pos[1] - node_pos[5];
 
-    current_jacobian = xxi % (xet * xze);
-    if ( current_jacobian < jacobian ) { jacobian = current_jacobian; }
+  current_jacobian = xxi % (xet * xze);
+  if ( current_jacobian < jacobian ) { jacobian = current_jacobian; }
 
-    // J(1,1,1):
+  // J(1,1,1):
 
-    xxi = node_pos[5] - node_pos[6];
-    xet = node_pos[7] - node_pos[6];
-    xze = node_pos[2] - node_pos[6];
+  xxi = node_pos[5] - node_pos[6];
+  xet = node_pos[7] - node_pos[6];
+  xze = node_pos[2] - node_pos[6];
 
-    current_jacobian = xxi % (xet * xze);
-    if ( current_jacobian < jacobian ) { jacobian = current_jacobian; }
+  current_jacobian = xxi % (xet * xze);
+  if ( current_jacobian < jacobian ) { jacobian = current_jacobian; }
 
-    // J(0,1,1):
+  // J(0,1,1):
 
-    xxi = node_pos[6] - node_pos[7];
-    xet = node_pos[4] - node_pos[7];
-    xze = node_pos[3] - node_pos[7];
+  xxi = node_pos[6] - node_pos[7];
+  xet = node_pos[4] - node_pos[7];
+  xze = node_pos[3] - node_pos[7];
 
-    current_jacobian = xxi % (xet * xze);
-    if ( current_jacobian < jacobian ) { jacobian = current_jacobian; }
+  current_jacobian = xxi % (xet * xze);
+  if ( current_jacobian < jacobian ) { jacobian = current_jacobian; }
 
-    if ( jacobian > 0 )
-      return (double) std::min( jacobian, VERDICT_DBL_MAX );
-    return (double) std::max( jacobian, -VERDICT_DBL_MAX );
-  }
+  if ( jacobian > 0 )
+    return (double) std::min( jacobian, VERDICT_DBL_MAX );
+  return (double) std::max( jacobian, -VERDICT_DBL_MAX );
 }
 
+} // namespace fixed
+
 /*!
-  scaled jacobian of a hex
+  jacobian of a hex
 
-  Minimum Jacobian divided by the lengths of the 3 edge vectors
+  Minimum pointwise volume of local map at 8 corners & center of hex
 */
-double hex_scaled_jacobian( int num_nodes, double coordinates[][3] )
+double hex_jacobian( int num_nodes, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( hex_jacobian );
+  if ( num_nodes == 27 )
+    return fixed::hex_jacobian<27>( coordinates );
+  return fixed::hex_jacobian<8>( coordinates );
+}
 
-  double jacobi, min_norm_jac = VERDICT_DBL_MAX;
-
-#if 0
-  if(num_nodes == 27)
+//! the trilinear shape functions of the corners of a hex
+static void hex8_linear_shape_functions( const double rst[3], double h[8] )
+{
+  for ( int c = 0; c < 8; c++ )
   {
-    double dhdr[27];
-    double dhds[27];
-    double dhdt[27];
+    const double* corner = HEX27_node_local_coord[c];
+    h[c] = 0.125 * ( 1 + rst[0] * corner[0] ) * ( 1 + rst[1] * corner[1] ) * ( 1 + rst[2] * corner[2] );
+  }
+}
 
-    for(int i=0; i<27; i++)
-    {
-      HEX27_gradients_of_the_shape_functions_for_RST(HEX27_node_local_coord[i], dhdr, dhds, dhdt);
-      double jacobian[3][3] = {{0,0,0},{0,0,0},{0,0,0}};
+//! the bounds of the hex27 jacobian estimate, tabulated on first use
+static const NodalJacobianBounds<27, 8> &hex27_jacobian_bounds()
+{
+  static const NodalJacobianBounds<27, 8> bounds( hex27_nodal_gradients(), hex8_linear_shape_functions,
+                                                  HEX27_node_local_coord );
+  return bounds;
+}
 
-      for(int j=0; j<27; j++)
-      {
-        jacobian[0][0]+=coordinates[j][0]*dhdr[j];
-        jacobian[1][0]+=coordinates[j][0]*dhds[j];
-        jacobian[2][0]+=coordinates[j][0]*dhdt[j];
-        jacobian[0][1]+=coordinates[j][1]*dhdr[j];
-        jacobian[1][1]+=coordinates[j][1]*dhds[j];
-        jacobian[2][1]+=coordinates[j][1]*dhdt[j];
-        jacobian[0][2]+=coordinates[j][2]*dhdr[j];
-        jacobian[1][2]+=coordinates[j][2]*dhds[j];
-        jacobian[2][2]+=coordinates[j][2]*dhdt[j];
-      }
-      VerdictVector xxi(jacobian[0]);
-      VerdictVector xet(jacobian[1]);
-      VerdictVector xze(jacobian[2]);
-      jacobi = xxi % ( xet * xze );
-      double scale = sqrt(xxi.length_squared() * xet.length_squared() * xze.length_squared());
-      jacobi /= scale;
-      if(jacobi < min_norm_jac)
-      {
-        min_norm_jac = jacobi;
-      }
-    }
-  }
+/*!
+  estimate of the jacobian of a hex
+
+  The jacobian of the trilinear hex of the corners at the 27 nodes, which
+  the offsets of the other 19 nodes bound
+*/
+void hex_jacobian_estimate( int num_nodes, double coordinates[][3], MetricEstimate &estimate )
+{
+  VERDICT_INSTRUMENT_METRIC( hex_jacobian_estimate );
+  if ( num_nodes == 27 )
+    nodal_jacobian_estimate( hex27_jacobian_bounds(), coordinates, estimate );
   else
-#endif
-  {
+    estimate.value = estimate.lower = estimate.upper = fixed::hex_jacobian<8>( coordinates );
+}
+
+namespace fixed
+{
+
+/*!
+  scaled jacobian of a hex
 
+  Minimum Jacobian divided by the lengths of the 3 edge vectors
+*/
+template <>
+double hex_scaled_jacobian<8>( double coordinates[][3] )
+{
+  double jacobi, min_norm_jac = VERDICT_DBL_MAX;
   double min_jacobi = VERDICT_DBL_MAX;
   double temp_norm_jac, lengths;
   double len1_sq, len2_sq, len3_sq; 
@@ -2112,7 +2183,10 @@ double hex_scaled_jacobian( int num_nodes, double coordinates[][3] )
 
   if ( len1_sq <= VERDICT_DBL_MIN || len2_sq <= VERDICT_DBL_MIN ||
       len3_sq <= VERDICT_DBL_MIN)
+  {
+    VERDICT_COUNT_EVENT( "hex_scaled_jacobian: collapsed edge" );
     return (double) VERDICT_DBL_MAX;
+  }
 
   lengths = sqrt( len1_sq * len2_sq * len3_sq );
   temp_norm_jac = jacobi / lengths;
@@ -2137,7 +2211,10 @@ double hex_scaled_jacobian( int num_nodes, double coordinates[][3] )
 
   if ( len1_sq <= VERDICT_DBL_MIN || len2_sq <= VERDICT_DBL_MIN ||
       len3_sq <= VERDICT_DBL_MIN)
+  {
+    VERDICT_COUNT_EVENT( "hex_scaled_jacobian: collapsed edge" );
     return (double) VERDICT_DBL_MAX;
+  }
 
   lengths = sqrt( len1_sq * len2_sq * len3_sq );
   temp_norm_jac = jacobi / lengths;
@@ -2162,7 +2239,10 @@ double hex_scaled_jacobian( int num_nodes, double coordinates[][3] )
 
   if ( len1_sq <= VERDICT_DBL_MIN || len2_sq <= VERDICT_DBL_MIN ||
       len3_sq <= VERDICT_DBL_MIN)
+  {
+    VERDICT_COUNT_EVENT( "hex_scaled_jacobian: collapsed edge" );
     return (double) VERDICT_DBL_MAX;
+  }
 
   lengths = sqrt( len1_sq * len2_sq * len3_sq );
   temp_norm_jac = jacobi / lengths;
@@ -2186,7 +2266,10 @@ double hex_scaled_jacobian( int num_nodes, double coordinates[][3] )
 
   if ( len1_sq <= VERDICT_DBL_MIN || len2_sq <= VERDICT_DBL_MIN ||
       len3_sq <= VERDICT_DBL_MIN)
+  {
+    VERDICT_COUNT_EVENT( "hex_scaled_jacobian: collapsed edge" );
     return (double) VERDICT_DBL_MAX;
+  }
 
   lengths = sqrt( len1_sq * len2_sq * len3_sq );
   temp_norm_jac = jacobi / lengths;
@@ -2210,7 +2293,10 @@ double hex_scaled_jacobian( int num_nodes, double coordinates[][3] )
 
   if ( len1_sq <= VERDICT_DBL_MIN || len2_sq <= VERDICT_DBL_MIN ||
       len3_sq <= VERDICT_DBL_MIN)
+  {
+    VERDICT_COUNT_EVENT( "hex_scaled_jacobian: collapsed edge" );
     return (double) VERDICT_DBL_MAX;
+  }
 
   lengths = sqrt( len1_sq * len2_sq * len3_sq );
   temp_norm_jac = jacobi / lengths;
@@ -2234,7 +2320,10 @@ double hex_scaled_jacobian( int num_nodes, double coordinates[][3] )
 
   if ( len1_sq <= VERDICT_DBL_MIN || len2_sq <= VERDICT_DBL_MIN ||
       len3_sq <= VERDICT_DBL_MIN)
+  {
+    VERDICT_COUNT_EVENT( "hex_scaled_jacobian: collapsed edge" );
     return (double) VERDICT_DBL_MAX;
+  }
 
   lengths = sqrt( len1_sq * len2_sq * len3_sq );
   temp_norm_jac = jacobi / lengths;
@@ -2258,7 +2347,10 @@ double hex_scaled_jacobian( int num_nodes, double coordinates[][3] )
 
   if ( len1_sq <= VERDICT_DBL_MIN || len2_sq <= VERDICT_DBL_MIN ||
       len3_sq <= VERDICT_DBL_MIN)
+  {
+    VERDICT_COUNT_EVENT( "hex_scaled_jacobian: collapsed edge" );
     return (double) VERDICT_DBL_MAX;
+  }
 
   lengths = sqrt( len1_sq * len2_sq * len3_sq );
   temp_norm_jac = jacobi / lengths;
@@ -2282,7 +2374,10 @@ double hex_scaled_jacobian( int num_nodes, double coordinates[][3] )
 
   if ( len1_sq <= VERDICT_DBL_MIN || len2_sq <= VERDICT_DBL_MIN ||
       len3_sq <= VERDICT_DBL_MIN)
+  {
+    VERDICT_COUNT_EVENT( "hex_scaled_jacobian: collapsed edge" );
     return (double) VERDICT_DBL_MAX;
+  }
 
   lengths = sqrt( len1_sq * len2_sq * len3_sq );
   temp_norm_jac = jacobi / lengths;
@@ -2306,7 +2401,10 @@ double hex_scaled_jacobian( int num_nodes, double coordinates[][3] )
 
   if ( len1_sq <= VERDICT_DBL_MIN || len2_sq <= VERDICT_DBL_MIN ||
       len3_sq <= VERDICT_DBL_MIN)
+  {
+    VERDICT_COUNT_EVENT( "hex_scaled_jacobian: collapsed edge" );
     return (double) VERDICT_DBL_MAX;
+  }
 
   lengths = sqrt( len1_sq * len2_sq * len3_sq );
   temp_norm_jac = jacobi / lengths;
@@ -2314,13 +2412,118 @@ double hex_scaled_jacobian( int num_nodes, double coordinates[][3] )
     min_norm_jac = temp_norm_jac;  
   else 
     temp_norm_jac = jacobi;
-  }
 
   if ( min_norm_jac> 0 )
     return (double) std::min( min_norm_jac, VERDICT_DBL_MAX );
   return (double) std::max( min_norm_jac, -VERDICT_DBL_MAX );
 }
 
+} // namespace fixed
+
+/*!
+  scaled jacobian of a hex
+
+  Minimum Jacobian divided by the lengths of the 3 edge vectors
+*/
+double hex_scaled_jacobian( int /*num_nodes*/, double coordinates[][3] )
+{
+  VERDICT_INSTRUMENT_METRIC( hex_scaled_jacobian );
+  return fixed::hex_scaled_jacobian<8>( coordinates );
+}
+
+//! the nodes at the ends of the edge vectors xxi, xet and xze at each corner of a hex
+static const int hex_corner_edge_nodes[8][3] =
+{
+  {1, 3, 4}, {2, 0, 5}, {3, 1, 6}, {0, 2, 7}, {7, 5, 0}, {4, 6, 1}, {5, 7, 2}, {6, 4, 3}
+};
+
+/*!
+  whether the jacobian of a hex is at least threshold
+
+  Evaluates the sampling points of hex_jacobian one at a time, the corners
+  first, and stops at the first one below the threshold
+*/
+bool hex_jacobian_at_least( int num_nodes, double coordinates[][3], double threshold )
+{
+  VERDICT_INSTRUMENT_METRIC( hex_jacobian_at_least );
+  if(num_nodes == 27)
+  {
+    const NodalGradients<27> &gradients = hex27_nodal_gradients();
+
+    for(int i=0; i<27; i++)
+      if ( nodal_jacobian_determinant( gradients, coordinates, i ) < threshold )
+        return false;
+    return true;
+  }
+
+  VerdictVector node_pos[8];
+  make_hex_nodes ( coordinates, node_pos );
+
+  // hex_jacobian clamps its result, which does not change the comparisons
+  // for any sensible threshold
+  for ( int i = 0; i < 8; i++ )
+  {
+    const int* ends = hex_corner_edge_nodes[i];
+    VerdictVector xxi = node_pos[ends[0]] - node_pos[i];
+    VerdictVector xet = node_pos[ends[1]] - node_pos[i];
+    VerdictVector xze = node_pos[ends[2]] - node_pos[i];
+    if ( VerdictVector::Dot(xxi, (xet * xze)) < threshold )
+      return false;
+  }
+
+  VerdictVector xxi = calc_hex_efg(1, node_pos );
+  VerdictVector xet = calc_hex_efg(2, node_pos );
+  VerdictVector xze = calc_hex_efg(3, node_pos );
+  return !( VerdictVector::Dot(xxi, (xet * xze)) / 64.0 < threshold );
+}
+
+/*!
+  whether the scaled jacobian of a hex is at least threshold
+
+  hex_scaled_jacobian returns VERDICT_DBL_MAX for a hex with a collapsed
+  edge or principal axis, whatever the other corners, so the lengths are
+  all checked before the corners are evaluated one at a time
+*/
+bool hex_scaled_jacobian_at_least( int /*num_nodes*/, double coordinates[][3], double threshold )
+{
+  VERDICT_INSTRUMENT_METRIC( hex_scaled_jacobian_at_least );
+  VerdictVector node_pos[8];
+  make_hex_nodes ( coordinates, node_pos );
+
+  VerdictVector xxi = calc_hex_efg(1, node_pos );
+  VerdictVector xet = calc_hex_efg(2, node_pos );
+  VerdictVector xze = calc_hex_efg(3, node_pos );
+  const double center_len1_sq = xxi.length_squared();
+  const double center_len2_sq = xet.length_squared();
+  const double center_len3_sq = xze.length_squared();
+  if ( center_len1_sq <= VERDICT_DBL_MIN || center_len2_sq <= VERDICT_DBL_MIN ||
+       center_len3_sq <= VERDICT_DBL_MIN )
+    return VERDICT_DBL_MAX >= threshold;
+
+  double len_sq[8][3];
+  for ( int i = 0; i < 8; i++ )
+    for ( int j = 0; j < 3; j++ )
+    {
+      len_sq[i][j] = ( node_pos[hex_corner_edge_nodes[i][j]] - node_pos[i] ).length_squared();
+      if ( len_sq[i][j] <= VERDICT_DBL_MIN )
+        return VERDICT_DBL_MAX >= threshold;
+    }
+
+  for ( int i = 0; i < 8; i++ )
+  {
+    const int* ends = hex_corner_edge_nodes[i];
+    VerdictVector cxxi = node_pos[ends[0]] - node_pos[i];
+    VerdictVector cxet = node_pos[ends[1]] - node_pos[i];
+    VerdictVector cxze = node_pos[ends[2]] - node_pos[i];
+    const double jacobi = VerdictVector::Dot(cxxi, (cxet * cxze));
+    if ( jacobi / sqrt( len_sq[i][0] * len_sq[i][1] * len_sq[i][2] ) < threshold )
+      return false;
+  }
+
+  const double jacobi = VerdictVector::Dot(xxi, (xet * xze));
+  return !( jacobi / sqrt( center_len1_sq * center_len2_sq * center_len3_sq ) < threshold );
+}
+
 /*!
   Nodal jacobian ratio of a hex
   Minimum nodal jacobian divided by the maximum.  Detects element skewness.
@@ -2338,11 +2541,13 @@ inline std::pair<double, double> minMaxValPair(const std::pair<double, double>&
 
 double hex_nodal_jacobian_ratio( int num_nodes, double coordinates[][3])
 {
+  VERDICT_INSTRUMENT_METRIC( hex_nodal_jacobian_ratio );
   return verdict::hex_nodal_jacobian_ratio2( num_nodes, (double*)coordinates);
 }
 
 double hex_nodal_jacobian_ratio2( int /*num_nodes*/, double *coordinates)
 {
+  VERDICT_INSTRUMENT_METRIC( hex_nodal_jacobian_ratio2 );
   double Jdet8x[8];
   verdict::hex_nodal_jacobians(coordinates, Jdet8x);
   //
@@ -2382,6 +2587,7 @@ double hex_nodal_jacobian_ratio2( int /*num_nodes*/, double *coordinates)
 */
 double hex_shear( int /*num_nodes*/, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( hex_shear );
 
   double shear;
   double min_shear = 1.0; 
@@ -2582,6 +2788,7 @@ double hex_shear( int /*num_nodes*/, double coordinates[][3] )
 */
 double hex_shape( int /*num_nodes*/, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( hex_shape );
 
 
   double det, shape;
@@ -2721,26 +2928,14 @@ double hex_shape( int /*num_nodes*/, double coordinates[][3] )
 }
 
 /*!
-  relative size of a hex
-
-  Min( J, 1/J ), where J is determinant of weighted Jacobian matrix
+  the sum of the determinants of the jacobians at the corners of a hex,
+  eight times the size that hex_relative_size_squared compares
 */
-double hex_relative_size_squared( int /*num_nodes*/, double coordinates[][3], double average_hex_volume )
+double hex_size_measure( double coordinates[][3] )
 {
-  double size = 0;
-  double tau; 
-
   VerdictVector xxi, xet, xze;
   double det, det_sum = 0;
 
-  hex_get_weight( xxi, xet, xze, average_hex_volume );
- 
-  //This is the average relative size 
-  double detw = VerdictVector::Dot(xxi, (xet * xze));
-
-  if ( detw < VERDICT_DBL_MIN ) 
-    return 0; 
-
   VerdictVector node_pos[8];
   make_hex_nodes ( coordinates, node_pos );
 
@@ -2820,8 +3015,25 @@ double hex_relative_size_squared( int /*num_nodes*/, double coordinates[][3], do
   xze = node_pos[3] - node_pos[7];
 
   det = VerdictVector::Dot(xxi, (xet * xze));
-  det_sum += det;  
+  det_sum += det;
+
+  return det_sum;
+}
+
+double hex_size_weight( double average_hex_volume )
+{
+  VerdictVector xxi, xet, xze;
+  hex_get_weight( xxi, xet, xze, average_hex_volume );
+  return VerdictVector::Dot(xxi, (xet * xze));
+}
 
+double hex_relative_size( double det_sum, double detw )
+{
+  double size = 0;
+  double tau; 
+
+  if ( detw < VERDICT_DBL_MIN ) 
+    return 0; 
 
   if ( det_sum > VERDICT_DBL_MIN )
   {
@@ -2837,6 +3049,23 @@ double hex_relative_size_squared( int /*num_nodes*/, double coordinates[][3], do
   return (double) std::max( size, -VERDICT_DBL_MAX );
 }
 
+/*!
+  relative size of a hex
+
+  Min( J, 1/J ), where J is determinant of weighted Jacobian matrix
+*/
+double hex_relative_size_squared( int /*num_nodes*/, double coordinates[][3], double average_hex_volume )
+{
+  VERDICT_INSTRUMENT_METRIC( hex_relative_size_squared );
+  //This is the average relative size 
+  double detw = hex_size_weight( average_hex_volume );
+
+  if ( detw < VERDICT_DBL_MIN ) 
+    return 0; 
+
+  return hex_relative_size( hex_size_measure( coordinates ), detw );
+}
+
 /*!
   shape and size of a hex
 
@@ -2844,6 +3073,7 @@ double hex_relative_size_squared( int /*num_nodes*/, double coordinates[][3], do
 */
 double hex_shape_and_size( int num_nodes, double coordinates[][3], double average_hex_volume )
 {
+  VERDICT_INSTRUMENT_METRIC( hex_shape_and_size );
   double size = hex_relative_size_squared( num_nodes, coordinates, average_hex_volume );
   double shape = hex_shape( num_nodes, coordinates );
 
@@ -2862,6 +3092,7 @@ double hex_shape_and_size( int num_nodes, double coordinates[][3], double averag
 */
 double hex_shear_and_size( int num_nodes, double coordinates[][3], double average_hex_volume )
 {
+  VERDICT_INSTRUMENT_METRIC( hex_shear_and_size );
   double size = hex_relative_size_squared( num_nodes, coordinates, average_hex_volume );
   double shear = hex_shear( num_nodes, coordinates );
 
@@ -2874,49 +3105,26 @@ double hex_shear_and_size( int num_nodes, double coordinates[][3], double averag
 }
 
 /*!
-  distortion of a hex
+  distortion of a hex with NumNodes nodes, integrated over GaussPoints^3
+  gauss points
 */
-double hex_distortion( int num_nodes, double coordinates[][3] )
+template <int NumNodes, int GaussPoints>
+static double hex_distortion_at( double coordinates[][3] )
 {
-  
-  //use 2x2 gauss points for linear hex and 3x3 for 2nd order hex
-  int number_of_gauss_points=0;
-  if (num_nodes < 20)
-  {
-    //2x2 quadrature rule
-    number_of_gauss_points = 2;
-    num_nodes = 8;
-  }
-  else if (num_nodes >= 20)
-  {
-    //3x3 quadrature rule
-    number_of_gauss_points = 3;
-    num_nodes = 20;
-  }
-  
-  int number_dimension = 3;
-  int total_number_of_gauss_points = number_of_gauss_points
+  const int num_nodes = NumNodes;
+  const int number_of_gauss_points = GaussPoints;
+  const int total_number_of_gauss_points = number_of_gauss_points
   *number_of_gauss_points*number_of_gauss_points;
   double distortion = VERDICT_DBL_MAX;
   
-  // maxTotalNumberGaussPoints =27, maxNumberNodes = 20
-  // they are defined in GaussIntegration.hpp
-  // This is used to make these arrays static.
-  // I tried dynamically allocated arrays but the new and delete
-  // was very expensive
-  
-  double shape_function[maxTotalNumberGaussPoints][maxNumberNodes];
-  double dndy1[maxTotalNumberGaussPoints][maxNumberNodes];
-  double dndy2[maxTotalNumberGaussPoints][maxNumberNodes];
-  double dndy3[maxTotalNumberGaussPoints][maxNumberNodes];
-  double weight[maxTotalNumberGaussPoints];
-  
-  
-  //create an object of GaussIntegration
-  GaussIntegration gint;
-  gint.initialize(number_of_gauss_points,num_nodes,number_dimension );
-  gint.calculate_shape_function_3d_hex();
-  gint.get_shape_func(shape_function[0], dndy1[0], dndy2[0], dndy3[0],weight);
+  // the shape function tables only depend on the quadrature rule, so
+  // they are computed once and shared by all calls
+  ScratchFrame scratch;
+  const GaussTables &tables = gauss_tables( GAUSS_HEX, number_of_gauss_points, num_nodes, scratch );
+  const double (*dndy1)[maxNumberNodes] = tables.dndy1GaussPts;
+  const double (*dndy2)[maxNumberNodes] = tables.dndy2GaussPts;
+  const double (*dndy3)[maxNumberNodes] = tables.dndy3GaussPts;
+  const double* weight = tables.totalGaussWeight;
   
   
   VerdictVector xxi, xet, xze, xin;
@@ -2949,11 +3157,9 @@ double hex_distortion( int num_nodes, double coordinates[][3] )
   }
   
   // loop through all nodes
-  double dndy1_at_node[maxNumberNodes][maxNumberNodes];
-  double dndy2_at_node[maxNumberNodes][maxNumberNodes];
-  double dndy3_at_node[maxNumberNodes][maxNumberNodes];
-  
-  gint.calculate_derivative_at_nodes_3d( dndy1_at_node, dndy2_at_node, dndy3_at_node);
+  const double (*dndy1_at_node)[maxNumberNodes] = tables.dndy1AtNodes;
+  const double (*dndy2_at_node)[maxNumberNodes] = tables.dndy2AtNodes;
+  const double (*dndy3_at_node)[maxNumberNodes] = tables.dndy3AtNodes;
   int node_id;
   for (node_id=0;node_id<num_nodes; node_id++)
   {
@@ -2983,350 +3189,276 @@ double hex_distortion( int num_nodes, double coordinates[][3] )
   
   return (double)distortion;
 }
-  
-double hex_timestep( int num_nodes, double coordinates[][3], 
-                     double density,
-                     double poissons_ratio,
-                     double youngs_modulus )
+
+namespace fixed
 {
-  double char_length = hex_dimension( num_nodes, coordinates );
-  double M = youngs_modulus*(1 - poissons_ratio) / ((1 - 2 * poissons_ratio)*(1 + poissons_ratio));
-  double denominator = sqrt(M / density);
 
-  return char_length / denominator;
+//! distortion of a linear hex, with 2x2 gauss points
+template <>
+double hex_distortion<8>( double coordinates[][3] )
+{
+  return hex_distortion_at<8, 2>( coordinates );
 }
 
-
-
-/*
-double hex_jac_normjac_oddy_cond( int choices[],
-                      double coordinates[][3],
-                      double answers[4]  )
+//! distortion of a 20 node hex, with 3x3 gauss points
+template <>
+double hex_distortion<20>( double coordinates[][3] )
 {
+  return hex_distortion_at<20, 3>( coordinates );
+}
 
-  //Define variables
-  int i;
- 
-  double xxi[3], xet[3], xze[3];
-  double norm_jacobian = 0.0, current_norm_jac = 0.0; 
-        double jacobian = 0.0, current_jacobian = 0.0;
-  double oddy = 0.0, current_oddy = 0.0;  
-  double condition = 0.0, current_condition = 0.0;
-
-
-        for( i=0; i<3; i++)
-          xxi[i] = calc_hex_efg( 2, i, coordinates );
-        for( i=0; i<3; i++)
-          xet[i] = calc_hex_efg( 3, i, coordinates );
-        for( i=0; i<3; i++)
-          xze[i] = calc_hex_efg( 6, i, coordinates );
-
-  // norm jacobian and jacobian
-  if ( choices[0] || choices[1] )
-  {
-    current_jacobian = determinant( xxi, xet, xze  );
-    current_norm_jac = normalize_jacobian( current_jacobian,
-            xxi, xet, xze );
-    
-    if (current_norm_jac < norm_jacobian) { norm_jacobian = current_norm_jac; } 
-
-    current_jacobian /= 64.0;
-    if (current_jacobian < jacobian) { jacobian = current_jacobian; }
-  }
-
-  // oddy 
-  if ( choices[2] )
-  {
-    current_oddy = oddy_comp( xxi, xet, xze );
-      if ( current_oddy > oddy ) { oddy = current_oddy; }
-  }
-
-  // condition
-  if ( choices[3] )
-  {
-    current_condition = condition_comp( xxi, xet, xze );
-    if ( current_condition > condition ) { condition = current_condition; }
-  }
-
-
-  for( i=0; i<3; i++)
-  {
-    xxi[i] = coordinates[1][i] - coordinates[0][i];
-    xet[i] = coordinates[3][i] - coordinates[0][i];
-    xze[i] = coordinates[4][i] - coordinates[0][i];
-  } 
-
-  // norm jacobian and jacobian
-  if ( choices[0] || choices[1] )
-  {
-    current_jacobian = determinant( xxi, xet, xze  );
-    current_norm_jac = normalize_jacobian( current_jacobian,
-            xxi, xet, xze );
-    
-    if (current_norm_jac < norm_jacobian) { norm_jacobian = current_norm_jac; } 
-    if (current_jacobian < jacobian) { jacobian = current_jacobian; }
-  }
-
-  // oddy 
-  if ( choices[2] )
-  {
-    current_oddy = oddy_comp( xxi, xet, xze );
-      if ( current_oddy > oddy ) { oddy = current_oddy; }
-  }
+} // namespace fixed
 
-  // condition
-  if ( choices[3] )
-  {
-    current_condition = condition_comp( xxi, xet, xze );
-    if ( current_condition > condition ) { condition = current_condition; }
-  }
+/*!
+  distortion of a hex
+*/
+double hex_distortion( int num_nodes, double coordinates[][3] )
+{
+  VERDICT_INSTRUMENT_METRIC( hex_distortion );
 
+  //use 2x2 gauss points for linear hex and 3x3 for 2nd order hex
+  if (num_nodes < 20)
+    return fixed::hex_distortion<8>( coordinates );
+  return fixed::hex_distortion<20>( coordinates );
+}
   
-  for( i=0; i<3; i++)
-  {
-          xxi[i] = coordinates[1][i] - coordinates[0][i];
-          xet[i] = coordinates[2][i] - coordinates[1][i];
-          xze[i] = coordinates[5][i] - coordinates[1][i];
-  }
-
-  // norm jacobian and jacobian
-  if ( choices[0] || choices[1] )
-  {
-    current_jacobian = determinant( xxi,  xet, xze );
-    current_norm_jac = normalize_jacobian( current_jacobian,
-            xxi, xet, xze );
-    
-    if (current_norm_jac < norm_jacobian) { norm_jacobian = current_norm_jac; } 
-    if (current_jacobian < jacobian) { jacobian = current_jacobian; }
-  }
-
-  // oddy 
-  if ( choices[2] )
-  {
-    current_oddy = oddy_comp( xxi, xet, xze );
-      if ( current_oddy > oddy ) { oddy = current_oddy; }
-  }
-
-  // condition
-  if ( choices[3] )
-  {
-    current_condition = condition_comp( xxi, xet, xze );
-    if ( current_condition > condition ) { condition = current_condition; }
-  }
-
-
-  for( i=0; i<3; i++)
-  {
-          xxi[i] = coordinates[2][i] - coordinates[3][i];
-          xet[i] = coordinates[3][i] - coordinates[0][i];
-          xze[i] = coordinates[7][i] - coordinates[3][i];
-  }
-
-  // norm jacobian and jacobian
-  if ( choices[0] || choices[1] )
-  {
-    current_jacobian = determinant( xxi, xet, xze );
-    current_norm_jac = normalize_jacobian( current_jacobian,
-            xxi, xet, xze );
-    
-    if (current_norm_jac < norm_jacobian) { norm_jacobian = current_norm_jac; } 
-    if (current_jacobian < jacobian) { jacobian = current_jacobian; }
-  }
-
-  // oddy 
-  if ( choices[2] )
-  {
-    current_oddy = oddy_comp( xxi, xet, xze );
-      if ( current_oddy > oddy ) { oddy = current_oddy; }
-  }
+double hex_timestep( int num_nodes, double coordinates[][3], 
+                     double density,
+                     double poissons_ratio,
+                     double youngs_modulus )
+{
+  VERDICT_INSTRUMENT_METRIC( hex_timestep );
+  double char_length = hex_dimension( num_nodes, coordinates );
+  return char_length / timestep_wave_speed( density, poissons_ratio, youngs_modulus );
+}
 
-  // condition
-  if ( choices[3] )
-  {
-    current_condition = condition_comp( xxi, xet, xze );
-    if ( current_condition > condition ) { condition = current_condition; }
-  }
 
-  
-  for( i=0; i<3; i++)
-  {
-          xxi[i] = coordinates[5][i] - coordinates[4][i];
-          xet[i] = coordinates[7][i] - coordinates[4][i];
-          xze[i] = coordinates[4][i] - coordinates[0][i];
-  }  
 
+//! nodes defining the Jacobian at each hex corner: corner, xi, eta and zeta neighbors
+static const int hex_corner_nodes[8][4] =
+{
+  {0, 1, 3, 4},
+  {1, 2, 0, 5},
+  {2, 3, 1, 6},
+  {3, 0, 2, 7},
+  {4, 7, 5, 0},
+  {5, 4, 6, 1},
+  {6, 5, 7, 2},
+  {7, 6, 4, 3}
+};
 
-  // norm jacobian and jacobian
-  if ( choices[0] || choices[1] )
-  {
-    current_jacobian = determinant( xxi, xet, xze );
-    current_norm_jac = normalize_jacobian( current_jacobian,
-            xxi, xet, xze );
-    
-    if (current_norm_jac < norm_jacobian) { norm_jacobian = current_norm_jac; } 
-    if (current_jacobian < jacobian) { jacobian = current_jacobian; }
-  }
+/*!
+  several metrics of a hex in one pass
 
-  // oddy 
-  if ( choices[2] )
-  {
-    current_oddy = oddy_comp( xxi, xet, xze );
-      if ( current_oddy > oddy ) { oddy = current_oddy; }
-  }
+  Every metric is computed exactly as its single metric function does,
+  but the nodal positions, the principal axes (efg vectors) and the
+  corner Jacobians are only formed once.
+*/
+void hex_quality( int num_nodes, double coordinates[][3],
+                  unsigned int metrics, HexQuality &quality )
+{
+  VERDICT_INSTRUMENT_METRIC( hex_quality );
+  VerdictVector node_pos[8];
+  make_hex_nodes ( coordinates, node_pos );
 
-  // condition
-  if ( choices[3] )
-  {
-    current_condition = condition_comp( xxi, xet, xze );
-    if ( current_condition > condition ) { condition = current_condition; }
+  // the 27 node jacobian is evaluated with the quadratic shape functions
+  const bool do_jacobian = ( metrics & HEX_JACOBIAN ) && num_nodes != 27;
+  const bool do_scaled_jacobian = ( metrics & HEX_SCALED_JACOBIAN ) != 0;
+  const bool do_shape = ( metrics & HEX_SHAPE ) != 0;
+  const bool do_shear = ( metrics & HEX_SHEAR ) != 0;
+  const bool do_oddy = ( metrics & HEX_ODDY ) != 0;
+  const bool do_condition = ( metrics & HEX_CONDITION ) != 0;
+
+  if ( ( metrics & HEX_JACOBIAN ) && !do_jacobian )
+    quality.jacobian = hex_jacobian( num_nodes, coordinates );
+
+  VerdictVector efg1, efg2, efg3;
+  if ( do_jacobian || do_scaled_jacobian || do_oddy ||
+       ( metrics & ( HEX_SKEW | HEX_TAPER ) ) )
+  {
+    efg1 = calc_hex_efg( 1, node_pos );
+    efg2 = calc_hex_efg( 2, node_pos );
+    efg3 = calc_hex_efg( 3, node_pos );
+  }
+
+  double jacobian = VERDICT_DBL_MAX;
+  double min_norm_jac = VERDICT_DBL_MAX;
+  bool scaled_jacobian_degenerate = false;
+  double min_shear = 1.0;
+  bool shear_degenerate = false;
+  double min_shape = 1.0;
+  bool shape_degenerate = false;
+  double oddy = 0.0;
+  double condition = 0.0;
+
+  // center of the hex
+  if ( do_jacobian || do_scaled_jacobian )
+  {
+    const double det = VerdictVector::Dot( efg1, ( efg2 * efg3 ) );
+    jacobian = det / 64.0;
+
+    const double len1_sq = efg1.length_squared();
+    const double len2_sq = efg2.length_squared();
+    const double len3_sq = efg3.length_squared();
+    if ( len1_sq <= VERDICT_DBL_MIN || len2_sq <= VERDICT_DBL_MIN ||
+         len3_sq <= VERDICT_DBL_MIN )
+      scaled_jacobian_degenerate = true;
+    else
+      min_norm_jac = std::min( min_norm_jac, det / sqrt( len1_sq * len2_sq * len3_sq ) );
   }
+  if ( do_oddy )
+    oddy = std::max( oddy, oddy_comp( efg1, efg2, efg3 ) );
 
-  
-  for( i=0; i<3; i++)
-  {
-          xxi[i] = coordinates[2][i] - coordinates[3][i];
-          xet[i] = coordinates[2][i] - coordinates[1][i];
-          xze[i] = coordinates[6][i] - coordinates[2][i];
-  }  
-
-  // norm jacobian and jacobian
-  if ( choices[0] || choices[1] )
+  // corners of the hex
+  if ( do_jacobian || do_scaled_jacobian || do_shape || do_shear || do_oddy || do_condition )
   {
-    current_jacobian = determinant( xxi, xet, xze );
-    current_norm_jac = normalize_jacobian( current_jacobian,
-            xxi, xet, xze );
-    
-    if (current_norm_jac < norm_jacobian) { norm_jacobian = current_norm_jac; } 
-    if (current_jacobian < jacobian) { jacobian = current_jacobian; }
-  }
+    for ( int corner = 0; corner < 8; corner++ )
+    {
+      const int* nodes = hex_corner_nodes[corner];
+      const VerdictVector xxi = node_pos[nodes[1]] - node_pos[nodes[0]];
+      const VerdictVector xet = node_pos[nodes[2]] - node_pos[nodes[0]];
+      const VerdictVector xze = node_pos[nodes[3]] - node_pos[nodes[0]];
+
+      const double det = VerdictVector::Dot( xxi, ( xet * xze ) );
+      const double len1_sq = xxi.length_squared();
+      const double len2_sq = xet.length_squared();
+      const double len3_sq = xze.length_squared();
+      const bool short_edge = len1_sq <= VERDICT_DBL_MIN || len2_sq <= VERDICT_DBL_MIN ||
+                              len3_sq <= VERDICT_DBL_MIN;
+
+      if ( do_jacobian && det < jacobian )
+        jacobian = det;
+
+      if ( do_scaled_jacobian && !scaled_jacobian_degenerate )
+      {
+        if ( short_edge )
+          scaled_jacobian_degenerate = true;
+        else
+          min_norm_jac = std::min( min_norm_jac, det / sqrt( len1_sq * len2_sq * len3_sq ) );
+      }
 
-  // oddy 
-  if ( choices[2] )
-  {
-    current_oddy = oddy_comp( xxi, xet, xze );
-      if ( current_oddy > oddy ) { oddy = current_oddy; }
-  }
+      if ( do_shear && !shear_degenerate )
+      {
+        if ( short_edge || det < VERDICT_DBL_MIN )
+          shear_degenerate = true;
+        else
+          min_shear = std::min( det / sqrt( len1_sq * len2_sq * len3_sq ), min_shear );
+      }
 
-  // condition
-  if ( choices[3] )
-  {
-    current_condition = condition_comp( xxi, xet, xze );
-    if ( current_condition > condition ) { condition = current_condition; }
-  }
+      if ( do_shape && !shape_degenerate )
+      {
+        if ( det > VERDICT_DBL_MIN )
+          min_shape = std::min( min_shape, 3 * pow( det, two_thirds ) / ( len1_sq + len2_sq + len3_sq ) );
+        else
+          shape_degenerate = true;
+      }
 
+      if ( do_oddy )
+        oddy = std::max( oddy, oddy_comp( xxi, xet, xze ) );
 
-  for( i=0; i<3; i++)
-  {
-          xxi[i] = coordinates[5][i] - coordinates[4][i];
-          xet[i] = coordinates[6][i] - coordinates[5][i];
-          xze[i] = coordinates[5][i] - coordinates[1][i];
+      if ( do_condition )
+      {
+        const double current_condition = condition_comp( xxi, xet, xze );
+        if ( corner == 0 || current_condition > condition ) { condition = current_condition; }
+      }
+    }
   }
 
-
-  // norm jacobian and jacobian
-  if ( choices[0] || choices[1] )
+  if ( do_jacobian )
   {
-    current_jacobian = determinant( xxi, xet, xze );
-    current_norm_jac = normalize_jacobian( current_jacobian,
-            xxi, xet, xze );
-    
-    if (current_norm_jac < norm_jacobian) { norm_jacobian = current_norm_jac; } 
-    if (current_jacobian < jacobian) { jacobian = current_jacobian; }
+    if ( jacobian > 0 )
+      quality.jacobian = std::min( jacobian, VERDICT_DBL_MAX );
+    else
+      quality.jacobian = std::max( jacobian, -VERDICT_DBL_MAX );
   }
 
-  // oddy 
-  if ( choices[2] )
+  if ( do_scaled_jacobian )
   {
-    current_oddy = oddy_comp( xxi, xet, xze );
-      if ( current_oddy > oddy ) { oddy = current_oddy; }
+    if ( scaled_jacobian_degenerate )
+      quality.scaled_jacobian = VERDICT_DBL_MAX;
+    else if ( min_norm_jac > 0 )
+      quality.scaled_jacobian = std::min( min_norm_jac, VERDICT_DBL_MAX );
+    else
+      quality.scaled_jacobian = std::max( min_norm_jac, -VERDICT_DBL_MAX );
   }
 
-  // condition
-  if ( choices[3] )
+  if ( do_shear )
   {
-    current_condition = condition_comp( xxi, xet, xze );
-    if ( current_condition > condition ) { condition = current_condition; }
+    if ( shear_degenerate || min_shear <= VERDICT_DBL_MIN )
+      min_shear = 0;
+    quality.shear = std::min( min_shear, VERDICT_DBL_MAX );
   }
 
-    
-  for( i=0; i<3; i++)
+  if ( do_shape )
   {
-          xxi[i] = coordinates[6][i] - coordinates[7][i];
-          xet[i] = coordinates[7][i] - coordinates[4][i];
-          xze[i] = coordinates[7][i] - coordinates[3][i];
+    if ( shape_degenerate || min_shape <= VERDICT_DBL_MIN )
+      min_shape = 0;
+    quality.shape = std::min( min_shape, VERDICT_DBL_MAX );
   }
 
-
-  // norm jacobian and jacobian
-  if ( choices[0] || choices[1] )
+  if ( do_oddy )
   {
-    current_jacobian = determinant( xxi, xet, xze );
-    current_norm_jac = normalize_jacobian( current_jacobian,
-            xxi, xet, xze );
-    
-    if (current_norm_jac < norm_jacobian) { norm_jacobian = current_norm_jac; } 
-    if (current_jacobian < jacobian) { jacobian = current_jacobian; }
+    if ( oddy > 0 )
+      quality.oddy = std::min( oddy, VERDICT_DBL_MAX );
+    else
+      quality.oddy = std::max( oddy, -VERDICT_DBL_MAX );
   }
 
-  // oddy 
-  if ( choices[2] )
+  if ( do_condition )
   {
-    current_oddy = oddy_comp( xxi, xet, xze );
-      if ( current_oddy > oddy ) { oddy = current_oddy; }
+    if ( condition >= VERDICT_DBL_MAX )
+      quality.condition = VERDICT_DBL_MAX;
+    else if ( condition <= -VERDICT_DBL_MAX )
+      quality.condition = -VERDICT_DBL_MAX;
+    else
+      quality.condition = condition / 3.;
   }
 
-  // condition
-  if ( choices[3] )
+  if ( metrics & HEX_TAPER )
   {
-    current_condition = condition_comp( xxi, xet, xze );
-    if ( current_condition > condition ) { condition = current_condition; }
-  }
+    // taper needs the unnormalized principal axes, so it goes before skew
+    const VerdictVector efg12 = calc_hex_efg( 12, node_pos );
+    const VerdictVector efg13 = calc_hex_efg( 13, node_pos );
+    const VerdictVector efg23 = calc_hex_efg( 23, node_pos );
 
-  
-  for( i=0; i<3; i++)
-  {
-          xxi[i] = coordinates[6][i] - coordinates[7][i];
-          xet[i] = coordinates[6][i] - coordinates[5][i];
-          xze[i] = coordinates[6][i] - coordinates[2][i];
-  }
+    const double len1 = efg1.length();
+    const double len2 = efg2.length();
+    const double len3 = efg3.length();
 
-  // norm jacobian and jacobian
-  if ( choices[0] || choices[1] )
-  {
-    current_jacobian = determinant( xxi, xet, xze );
-    current_norm_jac = normalize_jacobian( current_jacobian,
-            xxi, xet, xze );
-    
-    if (current_norm_jac < norm_jacobian) { norm_jacobian = current_norm_jac; } 
-    if (current_jacobian < jacobian) { jacobian = current_jacobian; }
-  }
+    const double taper_1 = fabs( safe_ratio( efg12.length(), std::min( len1, len2 ) ) );
+    const double taper_2 = fabs( safe_ratio( efg13.length(), std::min( len1, len3 ) ) );
+    const double taper_3 = fabs( safe_ratio( efg23.length(), std::min( len2, len3 ) ) );
 
-  // oddy 
-  if ( choices[2] )
-  {
-    current_oddy = oddy_comp( xxi, xet, xze );
-      if ( current_oddy > oddy ) { oddy = current_oddy; }
+    const double taper = std::max( {taper_1, taper_2, taper_3} );
+    if ( taper > 0 )
+      quality.taper = std::min( taper, VERDICT_DBL_MAX );
+    else
+      quality.taper = std::max( taper, -VERDICT_DBL_MAX );
   }
 
-  // condition
-  if ( choices[3] )
+  if ( metrics & HEX_SKEW )
   {
-    current_condition = condition_comp( xxi, xet, xze );
-    if ( current_condition > condition ) { condition = current_condition; }
-
-    condition /= 3.0;
+    if ( efg1.normalize() <= VERDICT_DBL_MIN ||
+         efg2.normalize() <= VERDICT_DBL_MIN ||
+         efg3.normalize() <= VERDICT_DBL_MIN )
+    {
+      quality.skew = VERDICT_DBL_MAX;
+    }
+    else
+    {
+      const double skew_1 = fabs( VerdictVector::Dot( efg1, efg2 ) );
+      const double skew_2 = fabs( VerdictVector::Dot( efg1, efg3 ) );
+      const double skew_3 = fabs( VerdictVector::Dot( efg2, efg3 ) );
+
+      const double skew = std::max( {skew_1, skew_2, skew_3} );
+      if ( skew > 0 )
+        quality.skew = std::min( skew, VERDICT_DBL_MAX );
+      else
+        quality.skew = std::max( skew, -VERDICT_DBL_MAX );
+    }
   }
-
-  
-  answers[0] = jacobian;
-  answers[1] = norm_jacobian;
-  answers[2] = oddy;
-  answers[3] = condition;
-
-  return 1.0;
-
 }
-*/
+
 
 } // namespace verdict
 
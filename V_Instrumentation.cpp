@@ -0,0 +1,110 @@
+/*=========================================================================
+
+  Module:    V_Instrumentation.cpp
+
+  Copyright 2003,2006,2019 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+  Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government retains certain rights in this software.
+
+  See LICENSE for details.
+
+=========================================================================*/
+
+
+/*
+ *
+ * V_Instrumentation.cpp contains the registry of the instrumentation
+ *                       counters and the functions querying and resetting
+ *                       them.  Without VERDICT_ENABLE_INSTRUMENTATION there
+ *                       are no counters and the queries report none.
+ *
+ * This file is part of VERDICT
+ *
+ */
+
+#include "V_Instrumentation.hpp"
+
+#ifdef VERDICT_ENABLE_INSTRUMENTATION
+# if defined(_MSC_VER) && ( defined(_M_X64) || defined(_M_IX86) )
+#  include <intrin.h>
+#  define VERDICT_HAVE_RDTSC
+# elif ( defined(__GNUC__) || defined(__clang__) ) && ( defined(__x86_64__) || defined(__i386__) )
+#  include <x86intrin.h>
+#  define VERDICT_HAVE_RDTSC
+# else
+#  include <chrono>
+# endif
+#endif
+
+namespace VERDICT_NAMESPACE
+{
+
+#ifdef VERDICT_ENABLE_INSTRUMENTATION
+
+// the most recently created counter
+static std::atomic<InstrumentationCounter*> first_counter( nullptr );
+
+InstrumentationCounter::InstrumentationCounter( const char* counter_name, bool metric )
+  : name( counter_name ), is_metric( metric ), count( 0 ), ticks( 0 ),
+    next( first_counter.load( std::memory_order_relaxed ) )
+{
+  while ( !first_counter.compare_exchange_weak( next, this, std::memory_order_release,
+                                                std::memory_order_relaxed ) )
+    ;
+}
+
+unsigned long long instrumentation_ticks()
+{
+#ifdef VERDICT_HAVE_RDTSC
+  return __rdtsc();
+#else
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch() ).count();
+#endif
+}
+
+#endif
+
+bool instrumentation_enabled()
+{
+#ifdef VERDICT_ENABLE_INSTRUMENTATION
+  return true;
+#else
+  return false;
+#endif
+}
+
+int instrumentation_counters( VerdictCounter* counters, int max_counters )
+{
+  int num_counters = 0;
+#ifdef VERDICT_ENABLE_INSTRUMENTATION
+  for ( InstrumentationCounter* counter = first_counter.load( std::memory_order_acquire );
+        counter; counter = counter->next, num_counters++ )
+  {
+    if ( num_counters >= max_counters )
+      continue;
+    VerdictCounter &out = counters[num_counters];
+    out.name = counter->name;
+    out.is_metric = counter->is_metric;
+    out.count = counter->count.load( std::memory_order_relaxed );
+    out.ticks = counter->ticks.load( std::memory_order_relaxed );
+  }
+#else
+  (void)counters;
+  (void)max_counters;
+#endif
+  return num_counters;
+}
+
+void reset_instrumentation()
+{
+#ifdef VERDICT_ENABLE_INSTRUMENTATION
+  for ( InstrumentationCounter* counter = first_counter.load( std::memory_order_acquire );
+        counter; counter = counter->next )
+  {
+    counter->count.store( 0, std::memory_order_relaxed );
+    counter->ticks.store( 0, std::memory_order_relaxed );
+  }
+#endif
+}
+
+} // namespace verdict
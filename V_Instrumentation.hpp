@@ -0,0 +1,93 @@
+/*=========================================================================
+
+  Module:    V_Instrumentation.hpp
+
+  Copyright 2003,2006,2019 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+  Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government retains certain rights in this software.
+
+  See LICENSE for details.
+
+=========================================================================*/
+
+/*
+ *
+ * V_Instrumentation.hpp contains the macros recording how often each
+ *                       metric runs, how long it takes and how often the
+ *                       degenerate and clamping branches are taken.  They
+ *                       expand to nothing unless verdict is configured
+ *                       with VERDICT_ENABLE_INSTRUMENTATION.
+ *
+ * This file is part of VERDICT
+ *
+ */
+
+#ifndef VERDICT_INSTRUMENTATION_HPP
+#define VERDICT_INSTRUMENTATION_HPP
+
+#include "verdict.h"
+
+#ifdef VERDICT_ENABLE_INSTRUMENTATION
+
+#include <atomic>
+
+namespace VERDICT_NAMESPACE
+{
+
+/*!
+  one counter, created at the first use of its macro.  The counters form
+  a list that instrumentation_counters walks.
+*/
+struct InstrumentationCounter
+{
+  InstrumentationCounter( const char* counter_name, bool metric );
+
+  const char* name;
+  bool is_metric;
+  std::atomic<unsigned long long> count;
+  std::atomic<unsigned long long> ticks;
+  InstrumentationCounter* next;
+};
+
+//! a timestamp, in CPU cycles where the compiler gives access to them
+unsigned long long instrumentation_ticks();
+
+//! counts a metric call and adds its duration when it returns
+class InstrumentationTimer
+{
+public:
+  explicit InstrumentationTimer( InstrumentationCounter &counter )
+    : timed( counter ), start( instrumentation_ticks() ) {}
+
+  ~InstrumentationTimer()
+  {
+    timed.ticks.fetch_add( instrumentation_ticks() - start, std::memory_order_relaxed );
+    timed.count.fetch_add( 1, std::memory_order_relaxed );
+  }
+
+private:
+  InstrumentationCounter &timed;
+  unsigned long long start;
+};
+
+} // namespace verdict
+
+//! counts and times the enclosing metric function
+# define VERDICT_INSTRUMENT_METRIC( metric ) \
+  static VERDICT_NAMESPACE::InstrumentationCounter verdict_metric_counter( #metric, true ); \
+  VERDICT_NAMESPACE::InstrumentationTimer verdict_metric_timer( verdict_metric_counter )
+
+//! counts one pass through a branch; name is a string literal
+# define VERDICT_COUNT_EVENT( name ) \
+  do { \
+    static VERDICT_NAMESPACE::InstrumentationCounter verdict_event_counter( name, false ); \
+    verdict_event_counter.count.fetch_add( 1, std::memory_order_relaxed ); \
+  } while ( 0 )
+
+#else
+
+# define VERDICT_INSTRUMENT_METRIC( metric )
+# define VERDICT_COUNT_EVENT( name ) do { } while ( 0 )
+
+#endif
+
+#endif
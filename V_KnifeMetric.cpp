@@ -20,7 +20,9 @@
 
 
 #include "verdict.h"
+#include "verdict_fixed.h"
 #include "VerdictVector.hpp"
+#include "V_Instrumentation.hpp"
 #include <memory.h> 
 
 namespace VERDICT_NAMESPACE
@@ -51,102 +53,117 @@ namespace VERDICT_NAMESPACE
 
 
 
+namespace fixed
+{
+
 /*!
   calculates the volume of a knife element
 
   this is done by dividing the knife into 4 tets
   and summing the volumes of each.
 */
-
-double knife_volume( int num_nodes, double coordinates[][3] )
+template <>
+double knife_volume<7>( double coordinates[][3] )
 {
   double volume = 0;
   VerdictVector side1, side2, side3;
+
+  // divide the knife into 4 tets and calculate the volume
   
-  if (num_nodes == 7)
-  {
-    
-    // divide the knife into 4 tets and calculate the volume
-    
-    side1.set(
-        coordinates[1][0] - coordinates[0][0],
-        coordinates[1][1] - coordinates[0][1],
-        coordinates[1][2] - coordinates[0][2]
-        );
-    side2.set(
-        coordinates[3][0] - coordinates[0][0],
-        coordinates[3][1] - coordinates[0][1],
-        coordinates[3][2] - coordinates[0][2]
-        );
-    side3.set(
-        coordinates[4][0] - coordinates[0][0],
-        coordinates[4][1] - coordinates[0][1],
-        coordinates[4][2] - coordinates[0][2]
-        );
-
-    volume = side3 % (side1 * side2) / 6;
-   
-
-    side1.set(
-        coordinates[5][0] - coordinates[1][0],
-        coordinates[5][1] - coordinates[1][1],
-        coordinates[5][2] - coordinates[1][2]
-        );
-    side2.set(
-        coordinates[3][0] - coordinates[1][0],
-        coordinates[3][1] - coordinates[1][1],
-        coordinates[3][2] - coordinates[1][2]
-        );
-    side3.set(
-        coordinates[4][0] - coordinates[1][0],
-        coordinates[4][1] - coordinates[1][1],
-        coordinates[4][2] - coordinates[1][2]
-        );
-
-    volume += side3 % (side1 * side2) / 6;
-    
-    
-    side1.set(
-        coordinates[2][0] - coordinates[1][0],
-        coordinates[2][1] - coordinates[1][1],
-        coordinates[2][2] - coordinates[1][2]
-        );
-    side2.set(
-        coordinates[3][0] - coordinates[1][0],
-        coordinates[3][1] - coordinates[1][1],
-        coordinates[3][2] - coordinates[1][2]
-        );
-    side3.set(
-        coordinates[6][0] - coordinates[1][0],
-        coordinates[6][1] - coordinates[1][1],
-        coordinates[6][2] - coordinates[1][2]
-        );
-
-    volume += side3 % (side1 * side2) / 6;
-   
-    
-    side1.set(
-        coordinates[3][0] - coordinates[1][0],
-        coordinates[3][1] - coordinates[1][1],
-        coordinates[3][2] - coordinates[1][2]
-        );
-    side2.set(
-        coordinates[5][0] - coordinates[1][0],
-        coordinates[5][1] - coordinates[1][1],
-        coordinates[5][2] - coordinates[1][2]
-        );
-    side3.set(
-        coordinates[6][0] - coordinates[1][0],
-        coordinates[6][1] - coordinates[1][1],
-        coordinates[6][2] - coordinates[1][2]
-        );
-
-    volume += side3 % (side1 * side2) / 6;
+  side1.set(
+      coordinates[1][0] - coordinates[0][0],
+      coordinates[1][1] - coordinates[0][1],
+      coordinates[1][2] - coordinates[0][2]
+      );
+  side2.set(
+      coordinates[3][0] - coordinates[0][0],
+      coordinates[3][1] - coordinates[0][1],
+      coordinates[3][2] - coordinates[0][2]
+      );
+  side3.set(
+      coordinates[4][0] - coordinates[0][0],
+      coordinates[4][1] - coordinates[0][1],
+      coordinates[4][2] - coordinates[0][2]
+      );
+
+  volume = side3 % (side1 * side2) / 6;
+ 
+
+  side1.set(
+      coordinates[5][0] - coordinates[1][0],
+      coordinates[5][1] - coordinates[1][1],
+      coordinates[5][2] - coordinates[1][2]
+      );
+  side2.set(
+      coordinates[3][0] - coordinates[1][0],
+      coordinates[3][1] - coordinates[1][1],
+      coordinates[3][2] - coordinates[1][2]
+      );
+  side3.set(
+      coordinates[4][0] - coordinates[1][0],
+      coordinates[4][1] - coordinates[1][1],
+      coordinates[4][2] - coordinates[1][2]
+      );
+
+  volume += side3 % (side1 * side2) / 6;
   
-  }
+  
+  side1.set(
+      coordinates[2][0] - coordinates[1][0],
+      coordinates[2][1] - coordinates[1][1],
+      coordinates[2][2] - coordinates[1][2]
+      );
+  side2.set(
+      coordinates[3][0] - coordinates[1][0],
+      coordinates[3][1] - coordinates[1][1],
+      coordinates[3][2] - coordinates[1][2]
+      );
+  side3.set(
+      coordinates[6][0] - coordinates[1][0],
+      coordinates[6][1] - coordinates[1][1],
+      coordinates[6][2] - coordinates[1][2]
+      );
+
+  volume += side3 % (side1 * side2) / 6;
+ 
+  
+  side1.set(
+      coordinates[3][0] - coordinates[1][0],
+      coordinates[3][1] - coordinates[1][1],
+      coordinates[3][2] - coordinates[1][2]
+      );
+  side2.set(
+      coordinates[5][0] - coordinates[1][0],
+      coordinates[5][1] - coordinates[1][1],
+      coordinates[5][2] - coordinates[1][2]
+      );
+  side3.set(
+      coordinates[6][0] - coordinates[1][0],
+      coordinates[6][1] - coordinates[1][1],
+      coordinates[6][2] - coordinates[1][2]
+      );
+
+  volume += side3 % (side1 * side2) / 6;
 
   return (double)volume;
-    
+}
+
+} // namespace fixed
+
+/*!
+  calculates the volume of a knife element
+
+  this is done by dividing the knife into 4 tets
+  and summing the volumes of each.
+
+  0 unless the knife has 7 nodes
+*/
+double knife_volume( int num_nodes, double coordinates[][3] )
+{
+  VERDICT_INSTRUMENT_METRIC( knife_volume );
+  if (num_nodes == 7)
+    return fixed::knife_volume<7>( coordinates );
+  return 0;
 }
 
 } // namespace verdict
@@ -0,0 +1,365 @@
+/*=========================================================================
+
+  Module:    V_MappedMesh.cpp
+
+  Copyright 2003,2006,2019 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+  Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government retains certain rights in this software.
+
+  See LICENSE for details.
+
+=========================================================================*/
+
+
+/*
+ *
+ * V_MappedMesh.cpp contains the reader of meshes stored in flat binary
+ *                  files, which maps the files into memory and hands out
+ *                  chunks of elements to stream_mesh_quality
+ *
+ * This file is part of VERDICT
+ *
+ */
+
+#include "verdict_mesh.h"
+
+#include <stddef.h>
+
+#if defined(_WIN32)
+# ifndef NOMINMAX
+#  define NOMINMAX
+# endif
+# include <windows.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+namespace VERDICT_NAMESPACE
+{
+
+//! a file mapped read only; data is null for an empty file
+struct MappedFile
+{
+  const void* data;
+  size_t size;
+#if defined(_WIN32)
+  HANDLE file;
+  HANDLE mapping;
+#endif
+};
+
+static bool map_file( const char* path, MappedFile &file )
+{
+  file.data = nullptr;
+  file.size = 0;
+
+#if defined(_WIN32)
+  file.mapping = nullptr;
+  file.file = CreateFileA( path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                           FILE_ATTRIBUTE_NORMAL, nullptr );
+  if ( file.file == INVALID_HANDLE_VALUE )
+    return false;
+  LARGE_INTEGER size;
+  if ( !GetFileSizeEx( file.file, &size ) )
+    return false;
+  file.size = (size_t)size.QuadPart;
+  if ( file.size == 0 )
+    return true;
+  file.mapping = CreateFileMappingA( file.file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+  if ( !file.mapping )
+    return false;
+  file.data = MapViewOfFile( file.mapping, FILE_MAP_READ, 0, 0, 0 );
+  return file.data != nullptr;
+
+#else
+  const int descriptor = open( path, O_RDONLY );
+  if ( descriptor < 0 )
+    return false;
+  struct stat status;
+  bool mapped = fstat( descriptor, &status ) == 0;
+  if ( mapped && status.st_size > 0 )
+  {
+    file.size = (size_t)status.st_size;
+    void* data = mmap( nullptr, file.size, PROT_READ, MAP_SHARED, descriptor, 0 );
+    mapped = data != MAP_FAILED;
+    if ( mapped )
+      file.data = data;
+    else
+      file.size = 0;
+  }
+  // the mapping stays valid without the descriptor
+  close( descriptor );
+  return mapped;
+#endif
+}
+
+static void unmap_file( MappedFile &file )
+{
+#if defined(_WIN32)
+  if ( file.data )
+    UnmapViewOfFile( file.data );
+  if ( file.mapping )
+    CloseHandle( file.mapping );
+  if ( file.file != INVALID_HANDLE_VALUE )
+    CloseHandle( file.file );
+  file.mapping = nullptr;
+  file.file = INVALID_HANDLE_VALUE;
+#else
+  if ( file.data )
+    munmap( const_cast<void*>( file.data ), file.size );
+#endif
+  file.data = nullptr;
+  file.size = 0;
+}
+
+#if !defined(_WIN32)
+//! the whole pages of a mapping within [begin, begin + bytes), or the pages touching it
+static void page_range( const void* base, const void* begin, size_t bytes, bool whole,
+                        char* &first, size_t &length )
+{
+  const size_t page = (size_t)sysconf( _SC_PAGESIZE );
+  const size_t from = (size_t)( static_cast<const char*>( begin ) - static_cast<const char*>( base ) );
+  const size_t to = from + bytes;
+  const size_t first_page = whole ? ( from + page - 1 ) / page : from / page;
+  const size_t end_page = whole ? to / page : ( to + page - 1 ) / page;
+  first = const_cast<char*>( static_cast<const char*>( base ) ) + first_page * page;
+  length = end_page > first_page ? ( end_page - first_page ) * page : 0;
+}
+#endif
+
+//! asks for the pages holding [begin, begin + bytes) of a mapping to be read ahead
+static void prefetch( const MappedFile &file, const void* begin, size_t bytes )
+{
+#if defined(_WIN32)
+  (void)file; (void)begin; (void)bytes;
+#else
+  char* first;
+  size_t length;
+  page_range( file.data, begin, bytes, false, first, length );
+  if ( length > 0 )
+    madvise( first, length, MADV_WILLNEED );
+#endif
+}
+
+//! lets the pages entirely within [begin, begin + bytes) of a mapping go
+static void release( const MappedFile &file, const void* begin, size_t bytes )
+{
+#if defined(_WIN32)
+  (void)file; (void)begin; (void)bytes;
+#else
+  char* first;
+  size_t length;
+  page_range( file.data, begin, bytes, true, first, length );
+  // the mapping is read only, so the pages are read again if needed
+  if ( length > 0 )
+    madvise( first, length, MADV_DONTNEED );
+#endif
+}
+
+struct MappedMesh::Internals
+{
+  MappedFile points;
+  MappedFile connectivity;
+  MappedFile offsets;  // empty for a fixed node count
+  int nodes_per_element;
+  VerdictIndex num_points;
+  VerdictIndex num_entries;
+  VerdictIndex num_elements;
+  bool open;
+
+  // the connectivity entries and elements last read into each buffer
+  VerdictIndex entries_begin[2];
+  VerdictIndex entries_end[2];
+  VerdictIndex elements_begin[2];
+  VerdictIndex elements_end[2];
+
+  const double* point_data() const { return static_cast<const double*>( points.data ); }
+  const VerdictIndex* entry_data() const { return static_cast<const VerdictIndex*>( connectivity.data ); }
+  const VerdictIndex* offset_data() const { return static_cast<const VerdictIndex*>( offsets.data ); }
+
+  Internals();
+  bool map( const char* points_file, const char* connectivity_file, const char* offsets_file );
+  void unmap();
+  void release_buffer( int buffer );
+};
+
+MappedMesh::Internals::Internals()
+  : nodes_per_element( 0 ), num_points( 0 ), num_entries( 0 ), num_elements( 0 ), open( false )
+{
+  MappedFile none = {};
+#if defined(_WIN32)
+  none.file = INVALID_HANDLE_VALUE;
+#endif
+  points = connectivity = offsets = none;
+  for ( int b = 0; b < 2; b++ )
+    entries_begin[b] = entries_end[b] = elements_begin[b] = elements_end[b] = 0;
+}
+
+bool MappedMesh::Internals::map( const char* points_file, const char* connectivity_file,
+                                 const char* offsets_file )
+{
+  if ( !map_file( points_file, points ) || !map_file( connectivity_file, connectivity ) ||
+       ( offsets_file && !map_file( offsets_file, offsets ) ) )
+    return false;
+  if ( points.size % ( 3 * sizeof( double ) ) != 0 || connectivity.size % sizeof( VerdictIndex ) != 0 )
+    return false;
+  num_points = (VerdictIndex)( points.size / ( 3 * sizeof( double ) ) );
+  num_entries = (VerdictIndex)( connectivity.size / sizeof( VerdictIndex ) );
+
+  if ( offsets_file )
+  {
+    if ( offsets.size % sizeof( VerdictIndex ) != 0 || offsets.size < sizeof( VerdictIndex ) )
+      return false;
+    num_elements = (VerdictIndex)( offsets.size / sizeof( VerdictIndex ) ) - 1;
+  }
+  else
+  {
+    if ( nodes_per_element <= 0 || nodes_per_element > VERDICT_MAX_NODES_PER_ELEMENT ||
+         num_entries % nodes_per_element != 0 )
+      return false;
+    num_elements = num_entries / nodes_per_element;
+  }
+
+#if !defined(_WIN32)
+  // the chunks go through the connectivity in order
+  if ( connectivity.data )
+    madvise( const_cast<void*>( connectivity.data ), connectivity.size, MADV_SEQUENTIAL );
+  if ( offsets.data )
+    madvise( const_cast<void*>( offsets.data ), offsets.size, MADV_SEQUENTIAL );
+#endif
+  return true;
+}
+
+void MappedMesh::Internals::unmap()
+{
+  unmap_file( points );
+  unmap_file( connectivity );
+  unmap_file( offsets );
+  num_points = num_entries = num_elements = 0;
+  open = false;
+}
+
+//! the previous chunk read into a buffer has been evaluated
+void MappedMesh::Internals::release_buffer( int buffer )
+{
+  if ( entries_end[buffer] > entries_begin[buffer] )
+    release( connectivity, entry_data() + entries_begin[buffer],
+             ( entries_end[buffer] - entries_begin[buffer] ) * sizeof( VerdictIndex ) );
+  if ( offsets.data && elements_end[buffer] > elements_begin[buffer] )
+    release( offsets, offset_data() + elements_begin[buffer],
+             ( elements_end[buffer] - elements_begin[buffer] ) * sizeof( VerdictIndex ) );
+  entries_begin[buffer] = entries_end[buffer] = elements_begin[buffer] = elements_end[buffer] = 0;
+}
+
+MappedMesh::MappedMesh( const char* points_file, const char* connectivity_file, int nodes_per_element )
+  : internals( new Internals() )
+{
+  internals->nodes_per_element = nodes_per_element;
+  internals->open = internals->map( points_file, connectivity_file, nullptr );
+  if ( !internals->open )
+    internals->unmap();
+}
+
+MappedMesh::MappedMesh( const char* points_file, const char* connectivity_file, const char* offsets_file )
+  : internals( new Internals() )
+{
+  internals->open = internals->map( points_file, connectivity_file, offsets_file );
+  if ( !internals->open )
+    internals->unmap();
+}
+
+MappedMesh::~MappedMesh()
+{
+  internals->unmap();
+  delete internals;
+}
+
+bool MappedMesh::is_open() const
+{
+  return internals->open;
+}
+
+VerdictIndex MappedMesh::num_points() const
+{
+  return internals->num_points;
+}
+
+VerdictIndex MappedMesh::num_elements() const
+{
+  return internals->num_elements;
+}
+
+bool MappedMesh::read_chunk( void* mesh, int buffer, VerdictIndex first_element,
+                             VerdictIndex max_elements, MeshChunk &chunk )
+{
+  Internals &d = *static_cast<MappedMesh*>( mesh )->internals;
+  chunk = MeshChunk();
+  if ( !d.open || buffer < 0 || buffer > 1 || first_element < 0 || max_elements < 0 )
+    return false;
+
+  d.release_buffer( buffer );
+  if ( first_element >= d.num_elements )
+    return true;
+
+  const VerdictIndex num_elements = max_elements < d.num_elements - first_element ?
+    max_elements : d.num_elements - first_element;
+  const VerdictIndex* offsets = d.offsets.data ? d.offset_data() + first_element : nullptr;
+  VerdictIndex begin, end;
+  if ( offsets )
+  {
+    for ( VerdictIndex e = 0; e < num_elements; e++ )
+      if ( offsets[e] > offsets[e+1] )
+        return false;
+    begin = offsets[0];
+    end = offsets[num_elements];
+    if ( begin < 0 || end > d.num_entries )
+      return false;
+  }
+  else
+  {
+    begin = first_element * d.nodes_per_element;
+    end = begin + num_elements * d.nodes_per_element;
+  }
+
+  // checking the connectivity also brings it into memory before the
+  // chunk is evaluated; the points it refers to are only asked for
+  const VerdictIndex* entries = d.entry_data();
+  VerdictIndex lowest = d.num_points, highest = -1;
+  for ( VerdictIndex i = begin; i < end; i++ )
+  {
+    if ( entries[i] < lowest )
+      lowest = entries[i];
+    if ( entries[i] > highest )
+      highest = entries[i];
+  }
+  if ( begin < end )
+  {
+    if ( lowest < 0 || highest >= d.num_points )
+      return false;
+    prefetch( d.points, d.point_data() + 3 * lowest,
+              ( highest - lowest + 1 ) * 3 * sizeof( double ) );
+  }
+
+  d.entries_begin[buffer] = begin;
+  d.entries_end[buffer] = end;
+  d.elements_begin[buffer] = first_element;
+  d.elements_end[buffer] = first_element + num_elements;
+
+  chunk.num_elements = num_elements;
+  chunk.points = d.point_data();
+  if ( offsets )
+  {
+    chunk.connectivity = entries;
+    chunk.offsets = offsets;
+  }
+  else
+  {
+    chunk.nodes_per_element = d.nodes_per_element;
+    chunk.connectivity = entries + begin;
+  }
+  return true;
+}
+
+} // namespace verdict
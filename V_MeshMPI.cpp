@@ -0,0 +1,201 @@
+/*=========================================================================
+
+  Module:    V_MeshMPI.cpp
+
+  Copyright 2003,2006,2019 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+  Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government retains certain rights in this software.
+
+  See LICENSE for details.
+
+=========================================================================*/
+
+
+/*
+ *
+ * V_MeshMPI.cpp contains the mesh-level functions over meshes decomposed
+ *               across MPI ranks
+ *
+ * This file is part of VERDICT
+ *
+ */
+
+#include "verdict_mpi.h"
+#include "V_MeshReduction.hpp"
+
+#include <string.h>
+
+namespace VERDICT_NAMESPACE
+{
+
+//! what each rank contributes to the reduction of the statistics
+struct StatisticsMessage
+{
+  StatisticsPartial partial;
+  MeshStatisticsRequest request;
+};
+
+//! the MPI_Op merging the statistics of the lower ranks in into those of the higher ranks in inout
+static void merge_statistics_op( void* in, void* inout, int* length, MPI_Datatype* /*type*/ )
+{
+  // the buffers of MPI need not be as aligned as the partials
+  for ( int m = 0; m < *length; m++ )
+  {
+    StatisticsMessage lower, higher;
+    memcpy( &lower, static_cast<char*>( in ) + m * sizeof( StatisticsMessage ), sizeof( StatisticsMessage ) );
+    memcpy( &higher, static_cast<char*>( inout ) + m * sizeof( StatisticsMessage ), sizeof( StatisticsMessage ) );
+    merge_statistics( lower.partial, higher.partial, lower.request );
+    memcpy( static_cast<char*>( inout ) + m * sizeof( StatisticsMessage ), &lower, sizeof( StatisticsMessage ) );
+  }
+}
+
+//! merges the partials of all ranks in one collective and fills statistics from the total
+static void reduce_partials( MPI_Comm comm, const StatisticsPartial &partial,
+                             const MeshStatisticsRequest &request, MeshStatistics &statistics )
+{
+  StatisticsMessage message;
+  message.partial = partial;
+  message.request = bounded_request( request );
+
+  MPI_Datatype type;
+  MPI_Type_contiguous( (int)sizeof( StatisticsMessage ), MPI_BYTE, &type );
+  MPI_Type_commit( &type );
+  // not commutative, so the partials are merged in rank order on every rank
+  MPI_Op op;
+  MPI_Op_create( merge_statistics_op, 0, &op );
+
+  MPI_Allreduce( MPI_IN_PLACE, &message, 1, type, op, comm );
+
+  MPI_Op_free( &op );
+  MPI_Type_free( &type );
+
+  partial_statistics( message.partial, message.request, statistics );
+}
+
+void mpi_mesh_statistics( MPI_Comm comm,
+                          VerdictFunction metric,
+                          VerdictIndex num_elements,
+                          const double* points,
+                          const VerdictIndex* connectivity,
+                          const VerdictIndex* offsets,
+                          const unsigned char* owned,
+                          const VerdictIndex* global_ids,
+                          const MeshStatisticsRequest &request,
+                          double* results,
+                          MeshStatistics &statistics,
+                          int num_threads )
+{
+  const StatisticsPartial partial = owned_statistics( metric, num_elements, 0, points, connectivity,
+                                                      offsets, owned, global_ids, request, results,
+                                                      num_threads );
+  reduce_partials( comm, partial, request, statistics );
+}
+
+void mpi_mesh_statistics( MPI_Comm comm,
+                          VerdictFunction metric,
+                          VerdictIndex num_elements,
+                          int nodes_per_element,
+                          const double* points,
+                          const VerdictIndex* connectivity,
+                          const unsigned char* owned,
+                          const VerdictIndex* global_ids,
+                          const MeshStatisticsRequest &request,
+                          double* results,
+                          MeshStatistics &statistics,
+                          int num_threads )
+{
+  const StatisticsPartial partial = owned_statistics( metric, num_elements, nodes_per_element, points,
+                                                      connectivity, nullptr, owned, global_ids, request,
+                                                      results, num_threads );
+  reduce_partials( comm, partial, request, statistics );
+}
+
+void mpi_reduce_statistics( MPI_Comm comm,
+                            const MeshStatisticsRequest &request,
+                            MeshStatistics &statistics )
+{
+  const MeshStatisticsRequest bounded = bounded_request( request );
+  StatisticsPartial partial = empty_statistics();
+  if ( statistics.count > 0 )
+  {
+    partial.count = statistics.count;
+    partial.minimum = statistics.minimum;
+    partial.maximum = statistics.maximum;
+    partial.mean = statistics.mean;
+    partial.squared_differences =
+      statistics.standard_deviation * statistics.standard_deviation * statistics.count;
+    partial.below_acceptable = statistics.below_acceptable;
+    partial.above_acceptable = statistics.above_acceptable;
+    for ( int b = 0; b < bounded.num_bins; b++ )
+      partial.histogram[b] = statistics.histogram[b];
+    partial.num_worst = statistics.num_worst < bounded.num_worst ? statistics.num_worst : bounded.num_worst;
+    for ( int w = 0; w < partial.num_worst; w++ )
+    {
+      partial.worst_elements[w] = statistics.worst_elements[w];
+      partial.worst_values[w] = statistics.worst_values[w];
+    }
+  }
+  reduce_partials( comm, partial, request, statistics );
+}
+
+//! the global average size from the sum of the sizes of the owned elements of each rank
+static double global_average_size( MPI_Comm comm, double sum, VerdictIndex num_elements,
+                                   const unsigned char* owned )
+{
+  VerdictIndex num_owned = num_elements > 0 ? num_elements : 0;
+  if ( owned )
+  {
+    num_owned = 0;
+    for ( VerdictIndex e = 0; e < num_elements; e++ )
+      num_owned += owned[e] ? 1 : 0;
+  }
+
+  // the sizes and the counts in one collective; the counts stay exact below 2^53 elements
+  double totals[2] = { sum, (double)num_owned };
+  MPI_Allreduce( MPI_IN_PLACE, totals, 2, MPI_DOUBLE, MPI_SUM, comm );
+  return totals[1] > 0 ? totals[0] / totals[1] : 0.0;
+}
+
+double mpi_mesh_size_quality( MPI_Comm comm,
+                              VerdictSizeElement type,
+                              VerdictSizeMetric metric,
+                              VerdictIndex num_elements,
+                              int nodes_per_element,
+                              const double* points,
+                              const VerdictIndex* connectivity,
+                              const unsigned char* owned,
+                              double* results,
+                              int num_threads )
+{
+  const double sum = owned_element_sizes( type, num_elements, nodes_per_element, points,
+                                          connectivity, owned, results, num_threads );
+  const double average_size = global_average_size( comm, sum, num_elements, owned );
+  mesh_size_quality( type, metric, num_elements, nodes_per_element, points, connectivity,
+                     results, average_size, results, num_threads );
+  return average_size;
+}
+
+double mpi_mesh_size_quality( MPI_Comm comm,
+                              VerdictSizeElement type,
+                              VerdictSizeMetric metric,
+                              VerdictIndex num_elements,
+                              int nodes_per_element,
+                              const double* points,
+                              const VerdictIndex* connectivity,
+                              const unsigned char* owned,
+                              const VerdictIndex* global_ids,
+                              const MeshStatisticsRequest &request,
+                              double* results,
+                              MeshStatistics &statistics,
+                              int num_threads )
+{
+  const double average_size = mpi_mesh_size_quality( comm, type, metric, num_elements, nodes_per_element,
+                                                     points, connectivity, owned, results, num_threads );
+  // the results hold the values, so nothing is evaluated again
+  const StatisticsPartial partial = owned_statistics( nullptr, num_elements, nodes_per_element, points,
+                                                      connectivity, nullptr, owned, global_ids, request,
+                                                      results, num_threads );
+  reduce_partials( comm, partial, request, statistics );
+  return average_size;
+}
+
+} // namespace verdict
@@ -0,0 +1,1862 @@
+/*=========================================================================
+
+  Module:    V_MeshMetric.cpp
+
+  Copyright 2003,2006,2019 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+  Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government retains certain rights in this software.
+
+  See LICENSE for details.
+
+=========================================================================*/
+
+
+/*
+ *
+ * V_MeshMetric.cpp contains the batched evaluation of element metrics
+ *                  over whole meshes
+ *
+ * This file is part of VERDICT
+ *
+ */
+
+#include "verdict_mesh.h"
+#include "V_MeshReduction.hpp"
+#include "V_MetricRegistry.hpp"
+#include "V_Parallel.hpp"
+#include "V_ScratchArena.hpp"
+#include "V_SizeMetric.hpp"
+#include "V_TimestepMetric.hpp"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+namespace VERDICT_NAMESPACE
+{
+
+/*!
+  calculates a metric for every element of a mesh whose elements are
+  delimited by an offsets array
+*/
+void mesh_quality( VerdictFunction metric,
+                   VerdictIndex num_elements,
+                   const double* points,
+                   const VerdictIndex* connectivity,
+                   const VerdictIndex* offsets,
+                   double* results )
+{
+  double coordinates[VERDICT_MAX_NODES_PER_ELEMENT][3];
+
+  for ( VerdictIndex e = 0; e < num_elements; e++ )
+  {
+    const VerdictIndex num_nodes = offsets[e+1] - offsets[e];
+    if ( num_nodes <= 0 || num_nodes > VERDICT_MAX_NODES_PER_ELEMENT )
+    {
+      results[e] = 0.0;
+      continue;
+    }
+
+    gather_element_nodes( points, connectivity + offsets[e], (int)num_nodes, coordinates );
+    results[e] = metric( (int)num_nodes, coordinates );
+  }
+}
+
+/*!
+  calculates a metric for every element of a block in which all elements
+  have the same number of nodes
+*/
+void mesh_quality( VerdictFunction metric,
+                   VerdictIndex num_elements,
+                   int nodes_per_element,
+                   const double* points,
+                   const VerdictIndex* connectivity,
+                   double* results )
+{
+  if ( num_elements <= 0 )
+    return;
+  const MetricBlock block = resolve_metric_block( metric, nodes_per_element );
+  block.evaluate( block, num_elements, points, connectivity, results );
+}
+
+void mesh_quality( VerdictMetric metric,
+                   VerdictIndex num_elements,
+                   int nodes_per_element,
+                   const double* points,
+                   const VerdictIndex* connectivity,
+                   double average_size,
+                   double* results )
+{
+  if ( num_elements <= 0 )
+    return;
+  const MetricBlock block = resolve_metric_block( metric, nodes_per_element, average_size );
+  block.evaluate( block, num_elements, points, connectivity, results );
+}
+
+/*!
+  number of connectivity entries per block of the parallel functions; the
+  connectivity, node coordinates and results of a block stay in cache
+*/
+static const VerdictIndex parallel_block_entries = 4096;
+
+//! elements per block, for elements with nodes_per_element nodes on average
+static VerdictIndex parallel_block_size( double nodes_per_element )
+{
+  const VerdictIndex size = nodes_per_element > 1. ?
+    (VerdictIndex)( parallel_block_entries / nodes_per_element ) : parallel_block_entries;
+  return size > 0 ? size : 1;
+}
+
+//! the arguments of mesh_quality, shared by all blocks
+struct MeshQualityArguments
+{
+  VerdictFunction metric;
+  int nodes_per_element;
+  const double* points;
+  const VerdictIndex* connectivity;
+  const VerdictIndex* offsets;
+  double* results;
+  MetricBlock block;  // the loop over the elements, for a fixed node count
+};
+
+//! resolves the loop over the elements once for all blocks
+static void resolve_block( MeshQualityArguments &args )
+{
+  if ( !args.offsets )
+    args.block = resolve_metric_block( args.metric, args.nodes_per_element );
+}
+
+//! the metric of elements begin to end into values
+static void evaluate_block( const MeshQualityArguments &args, VerdictIndex begin, VerdictIndex end,
+                            double* values )
+{
+  if ( args.offsets )
+    mesh_quality( args.metric, end - begin, args.points, args.connectivity,
+                  args.offsets + begin, values );
+  else
+    args.block.evaluate( args.block, end - begin, args.points,
+                         args.connectivity + begin*args.nodes_per_element, values );
+}
+
+static void mesh_quality_block( void* data, VerdictIndex begin, VerdictIndex end, int /*thread*/ )
+{
+  const MeshQualityArguments &args = *static_cast<const MeshQualityArguments*>( data );
+  evaluate_block( args, begin, end, args.results + begin );
+}
+
+void parallel_mesh_quality( VerdictFunction metric,
+                            VerdictIndex num_elements,
+                            const double* points,
+                            const VerdictIndex* connectivity,
+                            const VerdictIndex* offsets,
+                            double* results,
+                            int num_threads )
+{
+  if ( num_elements <= 0 )
+    return;
+
+  MeshQualityArguments args = { metric, 0, points, connectivity, offsets, results, {} };
+  const double average_nodes = (double)( offsets[num_elements] - offsets[0] ) / num_elements;
+  parallel_for_blocks( num_elements, parallel_block_size( average_nodes ), num_threads,
+                       mesh_quality_block, &args );
+}
+
+void parallel_mesh_quality( VerdictFunction metric,
+                            VerdictIndex num_elements,
+                            int nodes_per_element,
+                            const double* points,
+                            const VerdictIndex* connectivity,
+                            double* results,
+                            int num_threads )
+{
+  MeshQualityArguments args = { metric, nodes_per_element, points, connectivity, nullptr, results, {} };
+  resolve_block( args );
+  parallel_for_blocks( num_elements, parallel_block_size( nodes_per_element ), num_threads,
+                       mesh_quality_block, &args );
+}
+
+void parallel_mesh_quality( VerdictMetric metric,
+                            VerdictIndex num_elements,
+                            int nodes_per_element,
+                            const double* points,
+                            const VerdictIndex* connectivity,
+                            double average_size,
+                            double* results,
+                            int num_threads )
+{
+  MeshQualityArguments args = { nullptr, nodes_per_element, points, connectivity, nullptr, results,
+                                resolve_metric_block( metric, nodes_per_element, average_size ) };
+  parallel_for_blocks( num_elements, parallel_block_size( nodes_per_element ), num_threads,
+                       mesh_quality_block, &args );
+}
+
+//! the arguments of ordered_mesh_quality, shared by all blocks
+struct OrderedQualityArguments
+{
+  MeshQualityArguments quality;
+  const VerdictIndex* order;
+};
+
+static void ordered_quality_block( void* data, VerdictIndex begin, VerdictIndex end, int /*thread*/ )
+{
+  const OrderedQualityArguments &args = *static_cast<const OrderedQualityArguments*>( data );
+  const MeshQualityArguments &quality = args.quality;
+
+  // the elements are read in order, only the results are scattered
+  ScratchFrame scratch;
+  double* values = scratch.take<double>( end - begin );
+  evaluate_block( quality, begin, end, values );
+  for ( VerdictIndex i = begin; i < end; i++ )
+    quality.results[args.order[i]] = values[i - begin];
+}
+
+void ordered_mesh_quality( VerdictFunction metric,
+                           VerdictIndex num_elements,
+                           const double* points,
+                           const VerdictIndex* connectivity,
+                           const VerdictIndex* offsets,
+                           const VerdictIndex* order,
+                           double* results,
+                           int num_threads )
+{
+  if ( num_elements <= 0 )
+    return;
+
+  OrderedQualityArguments args = { { metric, 0, points, connectivity, offsets, results, {} }, order };
+  const double average_nodes = (double)( offsets[num_elements] - offsets[0] ) / num_elements;
+  parallel_for_blocks( num_elements, parallel_block_size( average_nodes ), num_threads,
+                       ordered_quality_block, &args );
+}
+
+void ordered_mesh_quality( VerdictFunction metric,
+                           VerdictIndex num_elements,
+                           int nodes_per_element,
+                           const double* points,
+                           const VerdictIndex* connectivity,
+                           const VerdictIndex* order,
+                           double* results,
+                           int num_threads )
+{
+  OrderedQualityArguments args =
+    { { metric, nodes_per_element, points, connectivity, nullptr, results, {} }, order };
+  resolve_block( args.quality );
+  parallel_for_blocks( num_elements, parallel_block_size( nodes_per_element ), num_threads,
+                       ordered_quality_block, &args );
+}
+
+//! the arguments of mesh_statistics, shared by all blocks
+struct MeshStatisticsArguments
+{
+  MeshQualityArguments quality;  // results, when not null, keeps the values
+  MeshStatisticsRequest request;
+  VerdictIndex first_element;  // the number of element 0 in the statistics
+  StatisticsPartial* partials;
+  const unsigned char* owned;  // when not null, only elements e with owned[e] are counted
+  const VerdictIndex* global_ids;  // when not null, the numbers of the elements
+};
+
+//! whether value a of element ea is worse than value b of element eb
+static inline bool is_worse( double a, VerdictIndex ea, double b, VerdictIndex eb,
+                             bool smaller_is_worse )
+{
+  if ( a == b )
+    return ea < eb;
+  return smaller_is_worse ? a < b : a > b;
+}
+
+//! inserts an element into the worst elements of a partial, kept worst first
+static void insert_worst( StatisticsPartial &partial, const MeshStatisticsRequest &request,
+                          double value, VerdictIndex element )
+{
+  int i = partial.num_worst;
+  if ( i == request.num_worst )
+  {
+    // most elements are not among the worst; the last one is the cutoff
+    if ( i == 0 || !is_worse( value, element, partial.worst_values[i-1],
+                              partial.worst_elements[i-1], request.smaller_is_worse ) )
+      return;
+    i--;
+  }
+  else
+    partial.num_worst++;
+
+  for ( ; i > 0 && is_worse( value, element, partial.worst_values[i-1],
+                             partial.worst_elements[i-1], request.smaller_is_worse ); i-- )
+  {
+    partial.worst_values[i] = partial.worst_values[i-1];
+    partial.worst_elements[i] = partial.worst_elements[i-1];
+  }
+  partial.worst_values[i] = value;
+  partial.worst_elements[i] = element;
+}
+
+//! the histogram bin of a value within the acceptable range
+static inline int histogram_bin( const MeshStatisticsRequest &request, double value )
+{
+  const double range = request.acceptable_max - request.acceptable_min;
+  int bin = range > 0. ?
+    (int)( request.num_bins * ( ( value - request.acceptable_min ) / range ) ) : 0;
+  return bin < request.num_bins ? bin : request.num_bins - 1;
+}
+
+//! the request with its number of bins and worst elements within the supported range
+MeshStatisticsRequest bounded_request( MeshStatisticsRequest request )
+{
+  if ( request.num_bins < 0 )
+    request.num_bins = 0;
+  else if ( request.num_bins > VERDICT_MAX_HISTOGRAM_BINS )
+    request.num_bins = VERDICT_MAX_HISTOGRAM_BINS;
+  if ( request.num_worst < 0 )
+    request.num_worst = 0;
+  else if ( request.num_worst > VERDICT_MAX_WORST_ELEMENTS )
+    request.num_worst = VERDICT_MAX_WORST_ELEMENTS;
+  return request;
+}
+
+static void add_to_statistics( StatisticsPartial &partial, const MeshStatisticsRequest &request,
+                               double value, VerdictIndex element )
+{
+  if ( value != value )
+    return;
+
+  partial.count++;
+  if ( value < partial.minimum )
+    partial.minimum = value;
+  if ( value > partial.maximum )
+    partial.maximum = value;
+  const double difference = value - partial.mean;
+  partial.mean += difference / partial.count;
+  partial.squared_differences += difference * ( value - partial.mean );
+
+  if ( value < request.acceptable_min )
+    partial.below_acceptable++;
+  else if ( value > request.acceptable_max )
+    partial.above_acceptable++;
+  else if ( request.num_bins > 0 )
+    partial.histogram[histogram_bin( request, value )]++;
+
+  insert_worst( partial, request, value, element );
+}
+
+void merge_statistics( StatisticsPartial &into, const StatisticsPartial &from,
+                       const MeshStatisticsRequest &request )
+{
+  if ( from.count == 0 )
+    return;
+
+  const VerdictIndex count = into.count + from.count;
+  const double difference = from.mean - into.mean;
+  into.mean += difference * ( (double)from.count / count );
+  into.squared_differences += from.squared_differences +
+    difference * difference * ( (double)into.count * from.count / count );
+  into.count = count;
+
+  if ( from.minimum < into.minimum )
+    into.minimum = from.minimum;
+  if ( from.maximum > into.maximum )
+    into.maximum = from.maximum;
+  into.below_acceptable += from.below_acceptable;
+  into.above_acceptable += from.above_acceptable;
+  for ( int b = 0; b < request.num_bins; b++ )
+    into.histogram[b] += from.histogram[b];
+  for ( int w = 0; w < from.num_worst; w++ )
+    insert_worst( into, request, from.worst_values[w], from.worst_elements[w] );
+}
+
+static void mesh_statistics_block( void* data, VerdictIndex begin, VerdictIndex end, int thread )
+{
+  const MeshStatisticsArguments &args = *static_cast<const MeshStatisticsArguments*>( data );
+  const MeshQualityArguments &quality = args.quality;
+
+  // without a metric the results already hold the values
+  ScratchFrame scratch;
+  double* values = quality.results ? quality.results + begin : scratch.take<double>( end - begin );
+  if ( quality.metric )
+    evaluate_block( quality, begin, end, values );
+
+  StatisticsPartial &partial = args.partials[thread];
+  for ( VerdictIndex e = begin; e < end; e++ )
+    if ( !args.owned || args.owned[e] )
+      add_to_statistics( partial, args.request, values[e - begin],
+                         args.global_ids ? args.global_ids[e] : args.first_element + e );
+}
+
+StatisticsPartial empty_statistics()
+{
+  StatisticsPartial empty = {};
+  empty.minimum = VERDICT_DBL_MAX;
+  empty.maximum = -VERDICT_DBL_MAX;
+  return empty;
+}
+
+void partial_statistics( const StatisticsPartial &total, const MeshStatisticsRequest &request,
+                         MeshStatistics &statistics )
+{
+  statistics = MeshStatistics();
+  statistics.count = total.count;
+  if ( total.count > 0 )
+  {
+    statistics.minimum = total.minimum;
+    statistics.maximum = total.maximum;
+    statistics.mean = total.mean;
+    statistics.standard_deviation = sqrt( total.squared_differences / total.count );
+  }
+  statistics.below_acceptable = total.below_acceptable;
+  statistics.above_acceptable = total.above_acceptable;
+  for ( int b = 0; b < request.num_bins; b++ )
+    statistics.histogram[b] = total.histogram[b];
+  statistics.num_worst = total.num_worst;
+  for ( int w = 0; w < total.num_worst; w++ )
+  {
+    statistics.worst_elements[w] = total.worst_elements[w];
+    statistics.worst_values[w] = total.worst_values[w];
+  }
+}
+
+//! merges the partials of all threads into the first
+static void merge_partials( std::vector<StatisticsPartial> &partials, const MeshStatisticsRequest &request )
+{
+  for ( size_t t = 1; t < partials.size(); t++ )
+    merge_statistics( partials[0], partials[t], request );
+}
+
+//! merges the partials of all threads into statistics
+static void finish_statistics( std::vector<StatisticsPartial> &partials,
+                               const MeshStatisticsRequest &request, MeshStatistics &statistics )
+{
+  merge_partials( partials, request );
+  partial_statistics( partials[0], request, statistics );
+}
+
+//! runs the blocks with one partial per thread
+static void gather_partials( MeshStatisticsArguments &args, VerdictIndex num_elements,
+                             VerdictIndex block_size, int num_threads,
+                             std::vector<StatisticsPartial> &partials )
+{
+  args.request = bounded_request( args.request );
+
+  partials.assign( parallel_thread_count( num_threads ), empty_statistics() );
+  args.partials = partials.data();
+
+  if ( num_elements > 0 )
+    parallel_for_blocks( num_elements, block_size, num_threads, mesh_statistics_block, &args );
+}
+
+//! runs the blocks with one partial per thread and merges the partials
+static void gather_statistics( MeshStatisticsArguments &args, VerdictIndex num_elements,
+                               VerdictIndex block_size, int num_threads,
+                               MeshStatistics &statistics )
+{
+  std::vector<StatisticsPartial> partials;
+  gather_partials( args, num_elements, block_size, num_threads, partials );
+  finish_statistics( partials, args.request, statistics );
+}
+
+StatisticsPartial owned_statistics( VerdictFunction metric,
+                                    VerdictIndex num_elements,
+                                    int nodes_per_element,
+                                    const double* points,
+                                    const VerdictIndex* connectivity,
+                                    const VerdictIndex* offsets,
+                                    const unsigned char* owned,
+                                    const VerdictIndex* global_ids,
+                                    const MeshStatisticsRequest &request,
+                                    double* results,
+                                    int num_threads )
+{
+  MeshStatisticsArguments args =
+    { { metric, offsets ? 0 : nodes_per_element, points, connectivity, offsets, results, {} },
+      request, 0, nullptr, owned, global_ids };
+  double average_nodes = nodes_per_element;
+  if ( metric && offsets )
+    average_nodes = num_elements > 0 ? (double)( offsets[num_elements] - offsets[0] ) / num_elements : 1.;
+  else if ( metric )
+    resolve_block( args.quality );
+
+  std::vector<StatisticsPartial> partials;
+  gather_partials( args, num_elements, parallel_block_size( average_nodes ), num_threads, partials );
+  merge_partials( partials, args.request );
+  return partials[0];
+}
+
+void mesh_statistics( VerdictFunction metric,
+                      VerdictIndex num_elements,
+                      const double* points,
+                      const VerdictIndex* connectivity,
+                      const VerdictIndex* offsets,
+                      const MeshStatisticsRequest &request,
+                      MeshStatistics &statistics,
+                      int num_threads )
+{
+  MeshStatisticsArguments args =
+    { { metric, 0, points, connectivity, offsets, nullptr, {} }, request, 0, nullptr, nullptr, nullptr };
+  const double average_nodes = num_elements > 0 ?
+    (double)( offsets[num_elements] - offsets[0] ) / num_elements : 1.;
+  gather_statistics( args, num_elements, parallel_block_size( average_nodes ), num_threads,
+                     statistics );
+}
+
+void mesh_statistics( VerdictFunction metric,
+                      VerdictIndex num_elements,
+                      int nodes_per_element,
+                      const double* points,
+                      const VerdictIndex* connectivity,
+                      const MeshStatisticsRequest &request,
+                      MeshStatistics &statistics,
+                      int num_threads )
+{
+  MeshStatisticsArguments args =
+    { { metric, nodes_per_element, points, connectivity, nullptr, nullptr, {} }, request, 0, nullptr,
+      nullptr, nullptr };
+  resolve_block( args.quality );
+  gather_statistics( args, num_elements, parallel_block_size( nodes_per_element ), num_threads,
+                     statistics );
+}
+
+//! elements per chunk of stream_mesh_quality when none is requested
+static const VerdictIndex default_stream_chunk_elements = 1 << 20;
+
+/*!
+  the input and output done while a chunk of stream_mesh_quality is
+  evaluated: the results of the previous chunk are written, then the next
+  chunk is read
+*/
+struct StreamTransfer
+{
+  MeshChunkReader reader;
+  void* reader_data;
+  MeshResultWriter writer;
+  void* writer_data;
+  VerdictIndex chunk_elements;
+
+  bool read;  // whether to read after writing
+  int buffer;
+  VerdictIndex first_element;
+  MeshChunk chunk;
+  bool read_ok;
+
+  const double* results;
+  VerdictIndex results_first_element;
+  VerdictIndex num_results;  // 0 when there is nothing to write
+  bool write_ok;
+};
+
+static void stream_transfer( void* data )
+{
+  StreamTransfer &transfer = *static_cast<StreamTransfer*>( data );
+  if ( transfer.num_results > 0 && transfer.writer )
+    transfer.write_ok = transfer.writer( transfer.writer_data, transfer.results_first_element,
+                                         transfer.num_results, transfer.results );
+  transfer.num_results = 0;
+
+  if ( !transfer.read || !transfer.write_ok )
+    return;
+  transfer.chunk = MeshChunk();
+  transfer.read_ok = transfer.reader( transfer.reader_data, transfer.buffer, transfer.first_element,
+                                      transfer.chunk_elements, transfer.chunk ) &&
+                     transfer.chunk.num_elements >= 0 &&
+                     transfer.chunk.num_elements <= transfer.chunk_elements;
+  if ( !transfer.read_ok )
+    transfer.chunk.num_elements = 0;
+}
+
+//! the evaluation of one chunk of stream_mesh_quality
+struct StreamEvaluation
+{
+  MeshStatisticsArguments* args;
+  VerdictIndex num_elements;
+  VerdictIndex block_size;
+  int num_threads;
+};
+
+static void stream_evaluation( void* data )
+{
+  const StreamEvaluation &evaluation = *static_cast<const StreamEvaluation*>( data );
+  parallel_for_blocks( evaluation.num_elements, evaluation.block_size, evaluation.num_threads,
+                       mesh_statistics_block, evaluation.args );
+}
+
+bool stream_mesh_quality( VerdictFunction metric,
+                          MeshChunkReader reader,
+                          void* reader_data,
+                          VerdictIndex chunk_elements,
+                          MeshResultWriter writer,
+                          void* writer_data,
+                          const MeshStatisticsRequest &request,
+                          MeshStatistics &statistics,
+                          int num_threads )
+{
+  if ( chunk_elements < 1 )
+    chunk_elements = default_stream_chunk_elements;
+
+  MeshStatisticsArguments args =
+    { { metric, 0, nullptr, nullptr, nullptr, nullptr, {} }, bounded_request( request ), 0, nullptr,
+      nullptr, nullptr };
+  std::vector<StatisticsPartial> partials( parallel_thread_count( num_threads ), empty_statistics() );
+  args.partials = partials.data();
+
+  // the results of the chunk being evaluated and of the one being written
+  std::vector<double> results[2];
+
+  StreamTransfer transfer = {};
+  transfer.reader = reader;
+  transfer.reader_data = reader_data;
+  transfer.writer = writer;
+  transfer.writer_data = writer_data;
+  transfer.chunk_elements = chunk_elements;
+  transfer.read = true;
+  transfer.write_ok = true;
+  stream_transfer( &transfer );
+  bool ok = transfer.read_ok;
+
+  VerdictIndex first_element = 0;
+  for ( int buffer = 0; ok && transfer.chunk.num_elements > 0; buffer ^= 1 )
+  {
+    const MeshChunk chunk = transfer.chunk;
+    results[buffer].resize( chunk.num_elements );
+
+    MeshQualityArguments quality = { metric, chunk.nodes_per_element, chunk.points,
+      chunk.connectivity, chunk.offsets, results[buffer].data(), {} };
+    resolve_block( quality );
+    args.quality = quality;
+    args.first_element = first_element;
+    const double average_nodes = chunk.offsets ?
+      (double)( chunk.offsets[chunk.num_elements] - chunk.offsets[0] ) / chunk.num_elements :
+      chunk.nodes_per_element;
+    StreamEvaluation evaluation =
+      { &args, chunk.num_elements, parallel_block_size( average_nodes ), num_threads };
+
+    // the previous chunk, read into the other buffer, has been evaluated
+    transfer.buffer = buffer ^ 1;
+    transfer.first_element = first_element + chunk.num_elements;
+    parallel_overlap( stream_transfer, &transfer, stream_evaluation, &evaluation );
+    ok = transfer.read_ok && transfer.write_ok;
+
+    transfer.results = results[buffer].data();
+    transfer.results_first_element = first_element;
+    transfer.num_results = chunk.num_elements;
+    first_element += chunk.num_elements;
+  }
+
+  // the results of the last chunk
+  if ( ok )
+  {
+    transfer.read = false;
+    stream_transfer( &transfer );
+    ok = transfer.write_ok;
+  }
+
+  finish_statistics( partials, args.request, statistics );
+  return ok;
+}
+
+bool write_results_to_file( void* file, VerdictIndex /*first_element*/,
+                            VerdictIndex num_elements, const double* results )
+{
+  return fwrite( results, sizeof( double ), (size_t)num_elements, static_cast<FILE*>( file ) ) ==
+         (size_t)num_elements;
+}
+
+/*!
+  the copy of the mesh, the cached values and the running statistics of
+  a MeshQualityCache.  The sums are of the values minus shift, the mean
+  when the statistics were last rebuilt, to limit cancellation.
+*/
+struct MeshQualityCache::Internals
+{
+  VerdictFunction metric;
+  VerdictIndex num_elements;
+  int nodes_per_element;
+  std::vector<VerdictIndex> connectivity;
+  std::vector<VerdictIndex> offsets;  // empty for a fixed node count
+  std::vector<VerdictIndex> point_offsets;  // the elements using each point
+  std::vector<VerdictIndex> point_elements;
+  std::vector<double> values;
+  MeshStatisticsRequest request;
+  int num_threads;
+
+  // the elements of the current update, and fresh values for them
+  std::vector<VerdictIndex> dirty;
+  std::vector<double> fresh;
+  std::vector<VerdictIndex> visited;  // the update that last added each element to dirty
+  VerdictIndex num_updates;
+
+  VerdictIndex count;
+  double shift;
+  double shifted_sum;
+  double shifted_squares;
+  double minimum;
+  double maximum;
+  bool extremes_stale;
+  VerdictIndex below_acceptable;
+  VerdictIndex above_acceptable;
+  VerdictIndex histogram[VERDICT_MAX_HISTOGRAM_BINS];
+  StatisticsPartial worst;  // only the worst elements are used
+  bool worst_stale;
+  MeshStatistics statistics;
+
+  const VerdictIndex* element_nodes( VerdictIndex e, VerdictIndex &num_nodes ) const
+  {
+    if ( offsets.empty() )
+    {
+      num_nodes = nodes_per_element;
+      return connectivity.data() + e*nodes_per_element;
+    }
+    num_nodes = offsets[e+1] - offsets[e];
+    return connectivity.data() + offsets[e];
+  }
+
+  void initialize( const double* points );
+  void rebuild_statistics();
+  void add( double value, int sign );
+  bool among_worst( double value, VerdictIndex element ) const;
+};
+
+struct CacheEvaluationArguments
+{
+  const MeshQualityCache::Internals* internals;
+  const double* points;
+  const VerdictIndex* elements;  // null for all elements
+  double* results;
+};
+
+static void cache_evaluation_block( void* data, VerdictIndex begin, VerdictIndex end, int /*thread*/ )
+{
+  const CacheEvaluationArguments &args = *static_cast<const CacheEvaluationArguments*>( data );
+  double coordinates[VERDICT_MAX_NODES_PER_ELEMENT][3];
+  for ( VerdictIndex i = begin; i < end; i++ )
+  {
+    VerdictIndex num_nodes;
+    const VerdictIndex* nodes =
+      args.internals->element_nodes( args.elements ? args.elements[i] : i, num_nodes );
+    if ( num_nodes <= 0 || num_nodes > VERDICT_MAX_NODES_PER_ELEMENT )
+    {
+      args.results[i] = 0.0;
+      continue;
+    }
+    gather_element_nodes( args.points, nodes, (int)num_nodes, coordinates );
+    args.results[i] = args.internals->metric( (int)num_nodes, coordinates );
+  }
+}
+
+void MeshQualityCache::Internals::initialize( const double* points )
+{
+  request = bounded_request( request );
+  values.resize( num_elements );
+  visited.assign( num_elements, -1 );
+  num_updates = 0;
+
+  // the elements using each point, grouped by point
+  VerdictIndex num_points = 0;
+  for ( VerdictIndex node : connectivity )
+    if ( node >= num_points )
+      num_points = node + 1;
+  point_offsets.assign( num_points + 1, 0 );
+  for ( VerdictIndex e = 0; e < num_elements; e++ )
+  {
+    VerdictIndex num_nodes;
+    const VerdictIndex* nodes = element_nodes( e, num_nodes );
+    for ( VerdictIndex n = 0; n < num_nodes; n++ )
+      point_offsets[nodes[n] + 1]++;
+  }
+  for ( VerdictIndex p = 0; p < num_points; p++ )
+    point_offsets[p + 1] += point_offsets[p];
+  point_elements.resize( point_offsets[num_points] );
+  std::vector<VerdictIndex> next( point_offsets.begin(), point_offsets.end() - 1 );
+  for ( VerdictIndex e = 0; e < num_elements; e++ )
+  {
+    VerdictIndex num_nodes;
+    const VerdictIndex* nodes = element_nodes( e, num_nodes );
+    for ( VerdictIndex n = 0; n < num_nodes; n++ )
+      point_elements[next[nodes[n]]++] = e;
+  }
+
+  CacheEvaluationArguments args = { this, points, nullptr, values.data() };
+  const double average_nodes = num_elements > 0 ? (double)connectivity.size() / num_elements : 1.;
+  parallel_for_blocks( num_elements, parallel_block_size( average_nodes ), num_threads,
+                       cache_evaluation_block, &args );
+  rebuild_statistics();
+}
+
+void MeshQualityCache::Internals::rebuild_statistics()
+{
+  double sum = 0.;
+  VerdictIndex valid = 0;
+  for ( double value : values )
+    if ( value == value )
+    {
+      sum += value;
+      valid++;
+    }
+  shift = valid > 0 ? sum / valid : 0.;
+
+  count = 0;
+  shifted_sum = shifted_squares = 0.;
+  minimum = VERDICT_DBL_MAX;
+  maximum = -VERDICT_DBL_MAX;
+  below_acceptable = above_acceptable = 0;
+  for ( int b = 0; b < VERDICT_MAX_HISTOGRAM_BINS; b++ )
+    histogram[b] = 0;
+  for ( double value : values )
+    add( value, 1 );
+  extremes_stale = false;
+  worst_stale = true;
+}
+
+//! adds a value to the running statistics, or removes it for sign -1
+void MeshQualityCache::Internals::add( double value, int sign )
+{
+  if ( value != value )
+    return;
+
+  count += sign;
+  shifted_sum += sign * ( value - shift );
+  shifted_squares += sign * ( value - shift ) * ( value - shift );
+  if ( value < request.acceptable_min )
+    below_acceptable += sign;
+  else if ( value > request.acceptable_max )
+    above_acceptable += sign;
+  else if ( request.num_bins > 0 )
+    histogram[histogram_bin( request, value )] += sign;
+
+  if ( sign > 0 )
+  {
+    if ( value < minimum )
+      minimum = value;
+    if ( value > maximum )
+      maximum = value;
+  }
+  else if ( value == minimum || value == maximum )
+    extremes_stale = true;
+}
+
+//! whether an element with this value would be among the worst elements
+bool MeshQualityCache::Internals::among_worst( double value, VerdictIndex element ) const
+{
+  const int last = worst.num_worst - 1;
+  return element == worst.worst_elements[last] ||
+         is_worse( value, element, worst.worst_values[last], worst.worst_elements[last],
+                   request.smaller_is_worse );
+}
+
+MeshQualityCache::MeshQualityCache( VerdictFunction metric,
+                                    VerdictIndex num_elements,
+                                    const double* points,
+                                    const VerdictIndex* connectivity,
+                                    const VerdictIndex* offsets,
+                                    const MeshStatisticsRequest &request,
+                                    int num_threads )
+  : internals( new Internals() )
+{
+  Internals &d = *internals;
+  d.metric = metric;
+  d.num_elements = num_elements > 0 ? num_elements : 0;
+  d.nodes_per_element = 0;
+  d.request = request;
+  d.num_threads = num_threads;
+
+  const VerdictIndex first = offsets[0];
+  d.connectivity.assign( connectivity + first, connectivity + offsets[d.num_elements] );
+  d.offsets.resize( d.num_elements + 1 );
+  for ( VerdictIndex e = 0; e <= d.num_elements; e++ )
+    d.offsets[e] = offsets[e] - first;
+  d.initialize( points );
+}
+
+MeshQualityCache::MeshQualityCache( VerdictFunction metric,
+                                    VerdictIndex num_elements,
+                                    int nodes_per_element,
+                                    const double* points,
+                                    const VerdictIndex* connectivity,
+                                    const MeshStatisticsRequest &request,
+                                    int num_threads )
+  : internals( new Internals() )
+{
+  Internals &d = *internals;
+  d.metric = metric;
+  d.num_elements = num_elements > 0 ? num_elements : 0;
+  d.nodes_per_element = nodes_per_element > 0 ? nodes_per_element : 0;
+  d.request = request;
+  d.num_threads = num_threads;
+  d.connectivity.assign( connectivity, connectivity + d.num_elements*d.nodes_per_element );
+  d.initialize( points );
+}
+
+MeshQualityCache::~MeshQualityCache()
+{
+  delete internals;
+}
+
+VerdictIndex MeshQualityCache::update( const double* points, const VerdictIndex* moved_points,
+                                       VerdictIndex num_moved )
+{
+  Internals &d = *internals;
+  const VerdictIndex num_points = (VerdictIndex)d.point_offsets.size() - 1;
+  const VerdictIndex pass = d.num_updates++;
+
+  d.dirty.clear();
+  for ( VerdictIndex i = 0; i < num_moved; i++ )
+  {
+    const VerdictIndex point = moved_points[i];
+    if ( point < 0 || point >= num_points )
+      continue;
+    for ( VerdictIndex j = d.point_offsets[point]; j < d.point_offsets[point + 1]; j++ )
+    {
+      const VerdictIndex e = d.point_elements[j];
+      if ( d.visited[e] != pass )
+      {
+        d.visited[e] = pass;
+        d.dirty.push_back( e );
+      }
+    }
+  }
+
+  const VerdictIndex num_dirty = (VerdictIndex)d.dirty.size();
+  d.fresh.resize( num_dirty );
+  CacheEvaluationArguments args = { &d, points, d.dirty.data(), d.fresh.data() };
+  const double average_nodes = d.num_elements > 0 ?
+    (double)d.connectivity.size() / d.num_elements : 1.;
+  parallel_for_blocks( num_dirty, parallel_block_size( average_nodes ), d.num_threads,
+                       cache_evaluation_block, &args );
+
+  for ( VerdictIndex i = 0; i < num_dirty; i++ )
+  {
+    const VerdictIndex e = d.dirty[i];
+    const double old_value = d.values[e];
+    const double value = d.fresh[i];
+    if ( d.request.num_worst > 0 && !d.worst_stale &&
+         ( d.worst.num_worst < d.request.num_worst ||
+           d.among_worst( old_value, e ) || d.among_worst( value, e ) ) )
+      d.worst_stale = true;
+
+    d.add( old_value, -1 );
+    d.add( value, 1 );
+    d.values[e] = value;
+  }
+  return num_dirty;
+}
+
+void MeshQualityCache::update_all( const double* points )
+{
+  Internals &d = *internals;
+  CacheEvaluationArguments args = { &d, points, nullptr, d.values.data() };
+  const double average_nodes = d.num_elements > 0 ?
+    (double)d.connectivity.size() / d.num_elements : 1.;
+  parallel_for_blocks( d.num_elements, parallel_block_size( average_nodes ), d.num_threads,
+                       cache_evaluation_block, &args );
+  d.rebuild_statistics();
+}
+
+VerdictIndex MeshQualityCache::num_elements() const
+{
+  return internals->num_elements;
+}
+
+const double* MeshQualityCache::values() const
+{
+  return internals->values.data();
+}
+
+const MeshStatistics& MeshQualityCache::statistics()
+{
+  Internals &d = *internals;
+  if ( d.extremes_stale )
+  {
+    d.minimum = VERDICT_DBL_MAX;
+    d.maximum = -VERDICT_DBL_MAX;
+    for ( double value : d.values )
+    {
+      if ( value < d.minimum )
+        d.minimum = value;
+      if ( value > d.maximum )
+        d.maximum = value;
+    }
+    d.extremes_stale = false;
+  }
+  if ( d.worst_stale )
+  {
+    d.worst.num_worst = 0;
+    for ( VerdictIndex e = 0; e < d.num_elements; e++ )
+      if ( d.values[e] == d.values[e] )
+        insert_worst( d.worst, d.request, d.values[e], e );
+    d.worst_stale = false;
+  }
+
+  MeshStatistics &statistics = d.statistics;
+  statistics = MeshStatistics();
+  statistics.count = d.count;
+  if ( d.count > 0 )
+  {
+    const double shifted_mean = d.shifted_sum / d.count;
+    const double variance = d.shifted_squares / d.count - shifted_mean * shifted_mean;
+    statistics.minimum = d.minimum;
+    statistics.maximum = d.maximum;
+    statistics.mean = d.shift + shifted_mean;
+    statistics.standard_deviation = variance > 0. ? sqrt( variance ) : 0.;
+  }
+  statistics.below_acceptable = d.below_acceptable;
+  statistics.above_acceptable = d.above_acceptable;
+  for ( int b = 0; b < d.request.num_bins; b++ )
+    statistics.histogram[b] = d.histogram[b];
+  statistics.num_worst = d.worst.num_worst;
+  for ( int w = 0; w < d.worst.num_worst; w++ )
+  {
+    statistics.worst_elements[w] = d.worst.worst_elements[w];
+    statistics.worst_values[w] = d.worst.worst_values[w];
+  }
+  return statistics;
+}
+
+//! a value of a MetricResultCache and the key of its element
+struct ResultCacheEntry
+{
+  unsigned long long key[2];
+  double value;
+  //! the call or load that last used the value, 0 for an empty slot; the
+  //! lookups of one call store the same stamp from several threads
+  mutable std::atomic<unsigned long long> stamp;
+};
+
+//! the values of a set, four cache lines, are searched together
+static const int result_cache_ways = 8;
+
+struct MetricResultCache::Internals
+{
+  std::vector<ResultCacheEntry> entries;  // num_sets sets of result_cache_ways values
+  VerdictIndex num_sets;
+  unsigned long long clock;
+  VerdictIndex size;
+  VerdictIndex hits;
+  VerdictIndex misses;
+
+  // the elements of the current call missing from the table, and their keys
+  std::vector<unsigned char> missing;
+  std::vector<VerdictIndex> missed;
+  std::vector<unsigned long long> missed_keys;
+
+  explicit Internals( VerdictIndex num_sets )
+    : entries( num_sets * result_cache_ways ), num_sets( num_sets ), clock( 0 ), size( 0 ),
+      hits( 0 ), misses( 0 )
+  {
+  }
+
+  //! the first entry of the set of a key
+  ResultCacheEntry* set( const unsigned long long key[2] )
+  {
+    return entries.data() + ( key[0] & ( num_sets - 1 ) ) * result_cache_ways;
+  }
+  const ResultCacheEntry* set( const unsigned long long key[2] ) const
+  {
+    return entries.data() + ( key[0] & ( num_sets - 1 ) ) * result_cache_ways;
+  }
+
+  const ResultCacheEntry* find( const unsigned long long key[2] ) const;
+  void insert( const unsigned long long key[2], double value, unsigned long long stamp );
+};
+
+//! the entry of a key, or null
+const ResultCacheEntry* MetricResultCache::Internals::find( const unsigned long long key[2] ) const
+{
+  const ResultCacheEntry* entry = set( key );
+  for ( int w = 0; w < result_cache_ways; w++ )
+    if ( entry[w].key[0] == key[0] && entry[w].key[1] == key[1] &&
+         entry[w].stamp.load( std::memory_order_relaxed ) != 0 )
+      return entry + w;
+  return nullptr;
+}
+
+//! sets the value of a key, replacing the least recently used value of a full set
+void MetricResultCache::Internals::insert( const unsigned long long key[2], double value,
+                                           unsigned long long stamp )
+{
+  ResultCacheEntry* entry = set( key );
+  ResultCacheEntry* slot = entry;
+  for ( int w = 0; w < result_cache_ways; w++ )
+  {
+    const unsigned long long used = entry[w].stamp.load( std::memory_order_relaxed );
+    if ( used != 0 && entry[w].key[0] == key[0] && entry[w].key[1] == key[1] )
+    {
+      slot = entry + w;
+      break;
+    }
+    if ( used < slot->stamp.load( std::memory_order_relaxed ) )
+      slot = entry + w;
+  }
+  if ( slot->stamp.load( std::memory_order_relaxed ) == 0 )
+    size++;
+  slot->key[0] = key[0];
+  slot->key[1] = key[1];
+  slot->value = value;
+  slot->stamp.store( stamp, std::memory_order_relaxed );
+}
+
+MetricResultCache::MetricResultCache( VerdictIndex capacity )
+{
+  VerdictIndex num_sets = 1;
+  while ( num_sets * result_cache_ways < capacity )
+    num_sets *= 2;
+  internals = new Internals( num_sets );
+}
+
+MetricResultCache::~MetricResultCache()
+{
+  delete internals;
+}
+
+VerdictIndex MetricResultCache::capacity() const
+{
+  return internals->num_sets * result_cache_ways;
+}
+
+VerdictIndex MetricResultCache::size() const
+{
+  return internals->size;
+}
+
+VerdictIndex MetricResultCache::hits() const
+{
+  return internals->hits;
+}
+
+VerdictIndex MetricResultCache::misses() const
+{
+  return internals->misses;
+}
+
+void MetricResultCache::clear()
+{
+  Internals &d = *internals;
+  for ( ResultCacheEntry &entry : d.entries )
+    entry.stamp.store( 0, std::memory_order_relaxed );
+  d.size = d.hits = d.misses = 0;
+}
+
+//! the start of the files of MetricResultCache::save; the format, written
+//! in the byte order of the machine, doubles as a byte order check
+struct ResultCacheFileHeader
+{
+  char magic[8];
+  unsigned int format;
+  unsigned int version;
+  unsigned long long num_entries;
+};
+
+struct ResultCacheRecord
+{
+  unsigned long long key[2];
+  double value;
+};
+
+static const char result_cache_magic[8] = { 'V', 'E', 'R', 'D', 'C', 'A', 'C', 'H' };
+static const unsigned int result_cache_format = 1;
+
+bool MetricResultCache::save( const char* path ) const
+{
+  const Internals &d = *internals;
+  std::vector<const ResultCacheEntry*> used;
+  used.reserve( d.size );
+  for ( const ResultCacheEntry &entry : d.entries )
+    if ( entry.stamp.load( std::memory_order_relaxed ) != 0 )
+      used.push_back( &entry );
+  // oldest first, so loading the file keeps the order of use
+  std::sort( used.begin(), used.end(), []( const ResultCacheEntry* a, const ResultCacheEntry* b ) {
+    return a->stamp.load( std::memory_order_relaxed ) < b->stamp.load( std::memory_order_relaxed );
+  } );
+
+  FILE* file = fopen( path, "wb" );
+  if ( !file )
+    return false;
+  ResultCacheFileHeader header;
+  memcpy( header.magic, result_cache_magic, sizeof( header.magic ) );
+  header.format = result_cache_format;
+  header.version = VERDICT_VERSION;
+  header.num_entries = used.size();
+  bool written = fwrite( &header, sizeof( header ), 1, file ) == 1;
+  for ( size_t i = 0; written && i < used.size(); i++ )
+  {
+    const ResultCacheRecord record = { { used[i]->key[0], used[i]->key[1] }, used[i]->value };
+    written = fwrite( &record, sizeof( record ), 1, file ) == 1;
+  }
+  return fclose( file ) == 0 && written;
+}
+
+bool MetricResultCache::load( const char* path )
+{
+  Internals &d = *internals;
+  FILE* file = fopen( path, "rb" );
+  if ( !file )
+    return false;
+  ResultCacheFileHeader header;
+  bool valid = fread( &header, sizeof( header ), 1, file ) == 1 &&
+               memcmp( header.magic, result_cache_magic, sizeof( header.magic ) ) == 0 &&
+               header.format == result_cache_format && header.version == VERDICT_VERSION;
+  for ( unsigned long long i = 0; valid && i < header.num_entries; i++ )
+  {
+    ResultCacheRecord record;
+    valid = fread( &record, sizeof( record ), 1, file ) == 1;
+    if ( valid )
+      d.insert( record.key, record.value, ++d.clock );
+  }
+  fclose( file );
+  return valid;
+}
+
+static inline unsigned long long rotate_left( unsigned long long x, int r )
+{
+  return ( x << r ) | ( x >> ( 64 - r ) );
+}
+
+//! the finalization mix of MurmurHash3
+static inline unsigned long long final_mix( unsigned long long k )
+{
+  k ^= k >> 33;
+  k *= 0xff51afd7ed558ccdULL;
+  k ^= k >> 33;
+  k *= 0xc4ceb9fe1a85ec53ULL;
+  k ^= k >> 33;
+  return k;
+}
+
+/*!
+  MurmurHash3_x64_128 of the two words of prefix followed by the bits of
+  the coordinates of the nodes of an element, read as 64 bit words
+*/
+static void element_key( const unsigned long long prefix[2], const double* points,
+                         const VerdictIndex* nodes, int num_nodes, unsigned long long key[2] )
+{
+  const unsigned long long c1 = 0x87c37b91114253d5ULL;
+  const unsigned long long c2 = 0x4cf5ad432745937fULL;
+
+  unsigned long long words[2 + 3*VERDICT_MAX_NODES_PER_ELEMENT + 1];
+  words[0] = prefix[0];
+  words[1] = prefix[1];
+  for ( int n = 0; n < num_nodes; n++ )
+    memcpy( words + 2 + 3*n, points + 3*nodes[n], 3*sizeof( double ) );
+  const int num_words = 2 + 3*num_nodes;
+
+  unsigned long long h1 = 0, h2 = 0;
+  int i = 0;
+  for ( ; i + 1 < num_words; i += 2 )
+  {
+    unsigned long long k1 = words[i], k2 = words[i + 1];
+    k1 *= c1; k1 = rotate_left( k1, 31 ); k1 *= c2; h1 ^= k1;
+    h1 = rotate_left( h1, 27 ); h1 += h2; h1 = h1*5 + 0x52dce729;
+    k2 *= c2; k2 = rotate_left( k2, 33 ); k2 *= c1; h2 ^= k2;
+    h2 = rotate_left( h2, 31 ); h2 += h1; h2 = h2*5 + 0x38495ab5;
+  }
+  if ( i < num_words )
+  {
+    unsigned long long k1 = words[i];
+    k1 *= c1; k1 = rotate_left( k1, 31 ); k1 *= c2; h1 ^= k1;
+  }
+
+  h1 ^= (unsigned long long)num_words * 8;
+  h2 ^= (unsigned long long)num_words * 8;
+  h1 += h2;
+  h2 += h1;
+  h1 = final_mix( h1 );
+  h2 = final_mix( h2 );
+  h1 += h2;
+  h2 += h1;
+  key[0] = h1;
+  key[1] = h2;
+}
+
+//! the arguments of cached_mesh_quality, shared by all blocks
+struct CachedQualityArguments
+{
+  MetricResultCache::Internals* cache;
+  unsigned long long prefix[2];  // the metric, the node count and the average size
+  MetricBlock block;
+  const double* points;
+  const VerdictIndex* connectivity;
+  double* results;
+  unsigned long long stamp;
+};
+
+//! elements whose keys are computed before their sets are searched, so the
+//! loads of the sets overlap
+static const int result_lookup_group = 16;
+
+//! the values found in the cache, marking the other elements as missing
+static void cache_lookup_block( void* data, VerdictIndex begin, VerdictIndex end, int /*thread*/ )
+{
+  const CachedQualityArguments &args = *static_cast<const CachedQualityArguments*>( data );
+  const MetricResultCache::Internals &cache = *args.cache;
+  const int num_nodes = args.block.nodes_per_element;
+  for ( VerdictIndex first = begin; first < end; first += result_lookup_group )
+  {
+    const int count = end - first < result_lookup_group ? (int)( end - first ) : result_lookup_group;
+    unsigned long long keys[result_lookup_group][2];
+    for ( int i = 0; i < count; i++ )
+    {
+      element_key( args.prefix, args.points, args.connectivity + ( first + i )*num_nodes, num_nodes, keys[i] );
+#if defined(__GNUC__)
+      __builtin_prefetch( cache.set( keys[i] ) );
+#endif
+    }
+    for ( int i = 0; i < count; i++ )
+    {
+      const VerdictIndex e = first + i;
+      const ResultCacheEntry* entry = cache.find( keys[i] );
+      args.cache->missing[e] = !entry;
+      if ( entry )
+      {
+        args.results[e] = entry->value;
+        entry->stamp.store( args.stamp, std::memory_order_relaxed );
+      }
+    }
+  }
+}
+
+//! evaluates the missing elements missed[begin] to missed[end - 1] and
+//! keeps their keys for the insertion
+static void cache_miss_block( void* data, VerdictIndex begin, VerdictIndex end, int /*thread*/ )
+{
+  const CachedQualityArguments &args = *static_cast<const CachedQualityArguments*>( data );
+  const int num_nodes = args.block.nodes_per_element;
+  const VerdictIndex* missed = args.cache->missed.data();
+
+  // the missing elements of the block next to each other, for the loop of the metric
+  ScratchFrame scratch;
+  VerdictIndex* connectivity = scratch.take<VerdictIndex>( ( end - begin )*num_nodes );
+  double* values = scratch.take<double>( end - begin );
+  for ( VerdictIndex i = begin; i < end; i++ )
+  {
+    const VerdictIndex* nodes = args.connectivity + missed[i]*num_nodes;
+    std::copy( nodes, nodes + num_nodes, connectivity + ( i - begin )*num_nodes );
+    element_key( args.prefix, args.points, nodes, num_nodes, &args.cache->missed_keys[2*i] );
+  }
+  args.block.evaluate( args.block, end - begin, args.points, connectivity, values );
+  for ( VerdictIndex i = begin; i < end; i++ )
+    args.results[missed[i]] = values[i - begin];
+}
+
+VerdictIndex MetricResultCache::mesh_quality( VerdictMetric metric,
+                                              VerdictIndex num_elements,
+                                              int nodes_per_element,
+                                              const double* points,
+                                              const VerdictIndex* connectivity,
+                                              double average_size,
+                                              double* results,
+                                              int num_threads )
+{
+  if ( num_elements <= 0 )
+    return 0;
+  const VerdictMetricInfo* info = metric_info( metric );
+  if ( !info || nodes_per_element < info->num_corners || nodes_per_element > VERDICT_MAX_NODES_PER_ELEMENT )
+  {
+    parallel_mesh_quality( metric, num_elements, nodes_per_element, points, connectivity,
+                           average_size, results, num_threads );
+    return num_elements;
+  }
+
+  Internals &d = *internals;
+  CachedQualityArguments args = { &d, { 0, 0 },
+                                  resolve_metric_block( metric, nodes_per_element, average_size ),
+                                  points, connectivity, results, ++d.clock };
+  // the metrics with no average size ignore it
+  args.prefix[0] = (unsigned long long)metric | ( (unsigned long long)nodes_per_element << 32 );
+  if ( info->sized_function )
+    memcpy( &args.prefix[1], &average_size, sizeof( double ) );
+
+  const VerdictIndex block_size = parallel_block_size( nodes_per_element );
+  d.missing.resize( num_elements );
+  parallel_for_blocks( num_elements, block_size, num_threads, cache_lookup_block, &args );
+
+  d.missed.clear();
+  for ( VerdictIndex e = 0; e < num_elements; e++ )
+    if ( d.missing[e] )
+      d.missed.push_back( e );
+  const VerdictIndex num_missed = (VerdictIndex)d.missed.size();
+  d.hits += num_elements - num_missed;
+  d.misses += num_missed;
+
+  d.missed_keys.resize( 2*num_missed );
+  parallel_for_blocks( num_missed, block_size, num_threads, cache_miss_block, &args );
+  for ( VerdictIndex i = 0; i < num_missed; i++ )
+    d.insert( &d.missed_keys[2*i], results[d.missed[i]], args.stamp );
+  return num_missed;
+}
+
+//! the arguments of mesh_failing_elements and mesh_screen_elements, shared
+//! by all blocks; the screens have an estimator and no predicate
+struct MeshFailingArguments
+{
+  VerdictPredicate predicate;
+  double threshold;
+  int nodes_per_element;
+  const double* points;
+  const VerdictIndex* connectivity;
+  const VerdictIndex* offsets;
+  unsigned long long* failing;
+
+  VerdictEstimator estimator;
+  VerdictFunction function;
+  double* results;
+  unsigned long long* exact;
+};
+
+//! whether an element passes the screen, and whether function was called
+static bool screen_element( const MeshFailingArguments &args, int num_nodes, double coordinates[][3],
+                            double &result, bool &exact )
+{
+  MetricEstimate estimate;
+  args.estimator( num_nodes, coordinates, estimate );
+  // NaN bounds fail both tests
+  exact = false;
+  result = estimate.value;
+  if ( estimate.lower >= args.threshold )
+    return true;
+  if ( estimate.upper < args.threshold )
+    return false;
+  exact = true;
+  result = args.function( num_nodes, coordinates );
+  return result >= args.threshold;
+}
+
+//! blocks start on a word of the bitmask, so no two threads write the same word
+static void failing_elements_block( void* data, VerdictIndex begin, VerdictIndex end, int /*thread*/ )
+{
+  const MeshFailingArguments &args = *static_cast<const MeshFailingArguments*>( data );
+  double coordinates[VERDICT_MAX_NODES_PER_ELEMENT][3];
+
+  for ( VerdictIndex word = begin / 64; word * 64 < end; word++ )
+  {
+    unsigned long long bits = 0, exact_bits = 0;
+    const VerdictIndex last = word * 64 + 64 < end ? word * 64 + 64 : end;
+    for ( VerdictIndex e = word * 64; e < last; e++ )
+    {
+      const VerdictIndex* element_nodes;
+      VerdictIndex num_nodes;
+      if ( args.offsets )
+      {
+        element_nodes = args.connectivity + args.offsets[e];
+        num_nodes = args.offsets[e+1] - args.offsets[e];
+      }
+      else
+      {
+        element_nodes = args.connectivity + e*args.nodes_per_element;
+        num_nodes = args.nodes_per_element;
+      }
+
+      bool pass = false, exact = false;
+      double result = 0.;
+      if ( num_nodes > 0 && num_nodes <= VERDICT_MAX_NODES_PER_ELEMENT )
+      {
+        gather_element_nodes( args.points, element_nodes, (int)num_nodes, coordinates );
+        if ( args.estimator )
+          pass = screen_element( args, (int)num_nodes, coordinates, result, exact );
+        else
+          pass = args.predicate( (int)num_nodes, coordinates, args.threshold );
+      }
+      if ( !pass )
+        bits |= 1ULL << ( e - word * 64 );
+      if ( exact )
+        exact_bits |= 1ULL << ( e - word * 64 );
+      if ( args.results )
+        args.results[e] = result;
+    }
+    args.failing[word] = bits;
+    if ( args.exact )
+      args.exact[word] = exact_bits;
+  }
+}
+
+static VerdictIndex failing_elements( MeshFailingArguments &args, VerdictIndex num_elements,
+                                      double nodes_per_element, int num_threads )
+{
+  if ( num_elements <= 0 )
+    return 0;
+
+  const VerdictIndex block_size = ( parallel_block_size( nodes_per_element ) + 63 ) / 64 * 64;
+  parallel_for_blocks( num_elements, block_size, num_threads, failing_elements_block, &args );
+
+  VerdictIndex count = 0;
+  const VerdictIndex num_words = ( num_elements + 63 ) / 64;
+  for ( VerdictIndex word = 0; word < num_words; word++ )
+    for ( unsigned long long bits = args.failing[word]; bits; bits &= bits - 1 )
+      count++;
+  return count;
+}
+
+VerdictIndex mesh_failing_elements( VerdictPredicate predicate,
+                                    double threshold,
+                                    VerdictIndex num_elements,
+                                    const double* points,
+                                    const VerdictIndex* connectivity,
+                                    const VerdictIndex* offsets,
+                                    unsigned long long* failing,
+                                    int num_threads )
+{
+  MeshFailingArguments args =
+    { predicate, threshold, 0, points, connectivity, offsets, failing, nullptr, nullptr, nullptr, nullptr };
+  const double average_nodes = num_elements > 0 ?
+    (double)( offsets[num_elements] - offsets[0] ) / num_elements : 1.;
+  return failing_elements( args, num_elements, average_nodes, num_threads );
+}
+
+VerdictIndex mesh_failing_elements( VerdictPredicate predicate,
+                                    double threshold,
+                                    VerdictIndex num_elements,
+                                    int nodes_per_element,
+                                    const double* points,
+                                    const VerdictIndex* connectivity,
+                                    unsigned long long* failing,
+                                    int num_threads )
+{
+  MeshFailingArguments args =
+    { predicate, threshold, nodes_per_element, points, connectivity, nullptr, failing,
+      nullptr, nullptr, nullptr, nullptr };
+  return failing_elements( args, num_elements, nodes_per_element, num_threads );
+}
+
+VerdictIndex mesh_screen_elements( VerdictEstimator estimator,
+                                   VerdictFunction function,
+                                   double threshold,
+                                   VerdictIndex num_elements,
+                                   const double* points,
+                                   const VerdictIndex* connectivity,
+                                   const VerdictIndex* offsets,
+                                   double* results,
+                                   unsigned long long* failing,
+                                   unsigned long long* exact,
+                                   int num_threads )
+{
+  MeshFailingArguments args =
+    { nullptr, threshold, 0, points, connectivity, offsets, failing, estimator, function, results, exact };
+  const double average_nodes = num_elements > 0 ?
+    (double)( offsets[num_elements] - offsets[0] ) / num_elements : 1.;
+  return failing_elements( args, num_elements, average_nodes, num_threads );
+}
+
+VerdictIndex mesh_screen_elements( VerdictEstimator estimator,
+                                   VerdictFunction function,
+                                   double threshold,
+                                   VerdictIndex num_elements,
+                                   int nodes_per_element,
+                                   const double* points,
+                                   const VerdictIndex* connectivity,
+                                   double* results,
+                                   unsigned long long* failing,
+                                   unsigned long long* exact,
+                                   int num_threads )
+{
+  MeshFailingArguments args =
+    { nullptr, threshold, nodes_per_element, points, connectivity, nullptr, failing,
+      estimator, function, results, exact };
+  return failing_elements( args, num_elements, nodes_per_element, num_threads );
+}
+
+/*!
+  the pieces of the size-relative metrics of one element type.  size is
+  the function whose average the single element metrics take; for tets
+  and quads it is the measure itself when the element is linear.
+*/
+struct SizeElementFunctions
+{
+  int num_corners;
+  double (*measure)( double coordinates[][3] );
+  double (*weight)( double average_size );
+  double (*relative_size)( double measure, double weight );
+  VerdictFunction size;
+  bool measure_is_size;
+  VerdictFunction shape;
+  VerdictFunction shear;
+  bool clamp;  // whether the product is clamped to +-VERDICT_DBL_MAX
+};
+
+static const SizeElementFunctions size_element_functions[] =
+{
+  { 3, tri_size_measure, tri_size_weight, tri_relative_size, tri_area, false, tri_shape, nullptr, true },
+  { 4, quad_size_measure, quad_size_weight, quad_relative_size, quad_area, true, quad_shape, quad_shear, true },
+  { 4, tet_size_measure, tet_size_weight, tet_relative_size, tet_volume, true, tet_shape, nullptr, false },
+  { 8, hex_size_measure, hex_size_weight, hex_relative_size, hex_volume, false, hex_shape, hex_shear, true }
+};
+
+//! the arguments of the size-relative functions, shared by all blocks
+struct MeshSizeArguments
+{
+  const SizeElementFunctions* functions;
+  VerdictFunction factor;  // shape or shear, null for the relative size alone
+  int nodes_per_element;
+  const double* points;
+  const VerdictIndex* connectivity;
+  const double* measures;
+  double weight;
+  double* results;
+  VerdictIndex block_size;
+  double* block_sizes;  // the sum of the sizes in each block
+  const unsigned char* owned;  // when not null, only elements e with owned[e] are summed
+};
+
+static bool valid_size_arguments( VerdictSizeElement type, int nodes_per_element )
+{
+  return type >= VERDICT_SIZE_TRI && type <= VERDICT_SIZE_HEX &&
+         nodes_per_element >= size_element_functions[type].num_corners &&
+         nodes_per_element <= VERDICT_MAX_NODES_PER_ELEMENT;
+}
+
+static void element_sizes_block( void* data, VerdictIndex begin, VerdictIndex end, int /*thread*/ )
+{
+  const MeshSizeArguments &args = *static_cast<const MeshSizeArguments*>( data );
+  const SizeElementFunctions &functions = *args.functions;
+  const int num_nodes = args.nodes_per_element;
+  const bool same = functions.measure_is_size && num_nodes == functions.num_corners;
+
+  double coordinates[VERDICT_MAX_NODES_PER_ELEMENT][3];
+  double sum = 0.;
+  for ( VerdictIndex e = begin; e < end; e++ )
+  {
+    gather_element_nodes( args.points, args.connectivity + e*num_nodes, num_nodes, coordinates );
+    const double measure = functions.measure( coordinates );
+    args.results[e] = measure;
+    if ( !args.owned || args.owned[e] )
+      sum += same ? measure : functions.size( num_nodes, coordinates );
+  }
+  args.block_sizes[begin / args.block_size] = sum;
+}
+
+double owned_element_sizes( VerdictSizeElement type,
+                            VerdictIndex num_elements,
+                            int nodes_per_element,
+                            const double* points,
+                            const VerdictIndex* connectivity,
+                            const unsigned char* owned,
+                            double* measures,
+                            int num_threads )
+{
+  if ( !valid_size_arguments( type, nodes_per_element ) )
+  {
+    for ( VerdictIndex e = 0; e < num_elements; e++ )
+      measures[e] = 0.0;
+    return 0.0;
+  }
+  if ( num_elements <= 0 )
+    return 0.0;
+
+  const VerdictIndex block_size = parallel_block_size( nodes_per_element );
+  // one sum per block, added up in order so the sum does not depend on the threads
+  std::vector<double> block_sizes( ( num_elements + block_size - 1 ) / block_size );
+  MeshSizeArguments args = { &size_element_functions[type], nullptr, nodes_per_element,
+                             points, connectivity, nullptr, 0., measures,
+                             block_size, block_sizes.data(), owned };
+  parallel_for_blocks( num_elements, block_size, num_threads, element_sizes_block, &args );
+
+  double sum = 0.;
+  for ( double block_sum : block_sizes )
+    sum += block_sum;
+  return sum;
+}
+
+double mesh_element_sizes( VerdictSizeElement type,
+                           VerdictIndex num_elements,
+                           int nodes_per_element,
+                           const double* points,
+                           const VerdictIndex* connectivity,
+                           double* measures,
+                           int num_threads )
+{
+  const double sum = owned_element_sizes( type, num_elements, nodes_per_element, points,
+                                          connectivity, nullptr, measures, num_threads );
+  return num_elements > 0 ? sum / num_elements : 0.0;
+}
+
+static void size_quality_block( void* data, VerdictIndex begin, VerdictIndex end, int /*thread*/ )
+{
+  const MeshSizeArguments &args = *static_cast<const MeshSizeArguments*>( data );
+  const SizeElementFunctions &functions = *args.functions;
+
+  if ( !args.factor )
+  {
+    for ( VerdictIndex e = begin; e < end; e++ )
+      args.results[e] = functions.relative_size( args.measures[e], args.weight );
+    return;
+  }
+
+  const int num_nodes = args.nodes_per_element;
+  double coordinates[VERDICT_MAX_NODES_PER_ELEMENT][3];
+  for ( VerdictIndex e = begin; e < end; e++ )
+  {
+    const double size = functions.relative_size( args.measures[e], args.weight );
+    gather_element_nodes( args.points, args.connectivity + e*num_nodes, num_nodes, coordinates );
+    const double product = size * args.factor( num_nodes, coordinates );
+    if ( !functions.clamp )
+      args.results[e] = product;
+    else if ( product > 0 )
+      args.results[e] = std::min( product, VERDICT_DBL_MAX );
+    else
+      args.results[e] = std::max( product, -VERDICT_DBL_MAX );
+  }
+}
+
+void mesh_size_quality( VerdictSizeElement type,
+                        VerdictSizeMetric metric,
+                        VerdictIndex num_elements,
+                        int nodes_per_element,
+                        const double* points,
+                        const VerdictIndex* connectivity,
+                        const double* measures,
+                        double average_size,
+                        double* results,
+                        int num_threads )
+{
+  const SizeElementFunctions* functions =
+    valid_size_arguments( type, nodes_per_element ) ? &size_element_functions[type] : nullptr;
+  VerdictFunction factor = nullptr;
+  if ( functions && metric == VERDICT_SHAPE_AND_SIZE )
+    factor = functions->shape;
+  else if ( functions && metric == VERDICT_SHEAR_AND_SIZE )
+    factor = functions->shear;
+
+  if ( !functions || ( metric != VERDICT_RELATIVE_SIZE_SQUARED && !factor ) )
+  {
+    for ( VerdictIndex e = 0; e < num_elements; e++ )
+      results[e] = 0.0;
+    return;
+  }
+
+  MeshSizeArguments args = { functions, factor, nodes_per_element, points, connectivity,
+                             measures, functions->weight( average_size ), results, 0, nullptr, nullptr };
+  parallel_for_blocks( num_elements, parallel_block_size( nodes_per_element ), num_threads,
+                       size_quality_block, &args );
+}
+
+double mesh_size_quality( VerdictSizeElement type,
+                          VerdictSizeMetric metric,
+                          VerdictIndex num_elements,
+                          int nodes_per_element,
+                          const double* points,
+                          const VerdictIndex* connectivity,
+                          double* results,
+                          int num_threads )
+{
+  const double average_size = mesh_element_sizes( type, num_elements, nodes_per_element, points,
+                                                  connectivity, results, num_threads );
+  mesh_size_quality( type, metric, num_elements, nodes_per_element, points, connectivity,
+                     results, average_size, results, num_threads );
+  return average_size;
+}
+
+//! the smallest timestep of the elements one thread evaluated
+struct alignas(64) TimestepPartial
+{
+  double minimum;
+  VerdictIndex element;
+  VerdictIndex num_inverted;
+};
+
+//! the arguments of mesh_timestep, shared by all blocks
+struct MeshTimestepArguments
+{
+  bool hex;
+  int nodes_per_element;
+  const double* points;
+  const VerdictIndex* connectivity;
+  const double* density;
+  const double* poissons_ratio;
+  const double* youngs_modulus;
+  double* timesteps;
+  unsigned char* inverted;
+  TimestepPartial* partials;
+};
+
+static void timestep_block( void* data, VerdictIndex begin, VerdictIndex end, int thread )
+{
+  const MeshTimestepArguments &args = *static_cast<const MeshTimestepArguments*>( data );
+  const int num_nodes = args.nodes_per_element;
+  // a hex only needs its corners, a tet its corners or its 10 nodes
+  const int used_nodes = args.hex ? 8 : ( num_nodes == 10 ? 10 : 4 );
+  TimestepPartial partial = args.partials[thread];
+
+  double coordinates[10][3];
+  for ( VerdictIndex e = begin; e < end; e++ )
+  {
+    gather_element_nodes( args.points, args.connectivity + e*num_nodes, used_nodes, coordinates );
+    bool inverted;
+    const double length = args.hex ? hex_timestep_length( coordinates, inverted )
+                                   : tet_timestep_length( num_nodes, coordinates, inverted );
+    const double timestep =
+      length / timestep_wave_speed( args.density[e], args.poissons_ratio[e], args.youngs_modulus[e] );
+
+    if ( args.timesteps )
+      args.timesteps[e] = timestep;
+    if ( args.inverted )
+      args.inverted[e] = inverted;
+    partial.num_inverted += inverted;
+    // NaN timesteps compare false and are skipped
+    if ( timestep < partial.minimum || ( timestep == partial.minimum && e < partial.element ) ||
+         ( partial.element < 0 && timestep == timestep ) )
+    {
+      partial.minimum = timestep;
+      partial.element = e;
+    }
+  }
+  args.partials[thread] = partial;
+}
+
+void mesh_timestep( VerdictElementType type,
+                    VerdictIndex num_elements,
+                    int nodes_per_element,
+                    const double* points,
+                    const VerdictIndex* connectivity,
+                    const double* density,
+                    const double* poissons_ratio,
+                    const double* youngs_modulus,
+                    double* timesteps,
+                    unsigned char* inverted,
+                    MeshTimestep &timestep,
+                    int num_threads )
+{
+  timestep.minimum = VERDICT_DBL_MAX;
+  timestep.element = -1;
+  timestep.num_inverted = 0;
+
+  const bool hex = type == VERDICT_ELEMENT_HEX;
+  if ( ( !hex && type != VERDICT_ELEMENT_TET ) || nodes_per_element < ( hex ? 8 : 4 ) ||
+       nodes_per_element > VERDICT_MAX_NODES_PER_ELEMENT )
+  {
+    for ( VerdictIndex e = 0; e < num_elements; e++ )
+    {
+      if ( timesteps )
+        timesteps[e] = 0.;
+      if ( inverted )
+        inverted[e] = 0;
+    }
+    return;
+  }
+  if ( num_elements <= 0 )
+    return;
+
+  ScratchFrame scratch;
+  const int num_partials = parallel_thread_count( num_threads );
+  TimestepPartial* partials = scratch.take<TimestepPartial>( num_partials );
+  for ( int t = 0; t < num_partials; t++ )
+  {
+    partials[t].minimum = VERDICT_DBL_MAX;
+    partials[t].element = -1;
+    partials[t].num_inverted = 0;
+  }
+
+  MeshTimestepArguments args = { hex, nodes_per_element, points, connectivity, density,
+                                 poissons_ratio, youngs_modulus, timesteps, inverted, partials };
+  parallel_for_blocks( num_elements, parallel_block_size( hex ? 8 : nodes_per_element ), num_threads,
+                       timestep_block, &args );
+
+  for ( int t = 0; t < num_partials; t++ )
+  {
+    timestep.num_inverted += partials[t].num_inverted;
+    if ( partials[t].element < 0 )
+      continue;
+    if ( timestep.element < 0 || partials[t].minimum < timestep.minimum ||
+         ( partials[t].minimum == timestep.minimum && partials[t].element < timestep.element ) )
+    {
+      timestep.minimum = partials[t].minimum;
+      timestep.element = partials[t].element;
+    }
+  }
+}
+
+} // namespace verdict
@@ -0,0 +1,310 @@
+/*=========================================================================
+
+  Module:    V_MeshOrder.cpp
+
+  Copyright 2003,2006,2019 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+  Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government retains certain rights in this software.
+
+  See LICENSE for details.
+
+=========================================================================*/
+
+
+/*
+ *
+ * V_MeshOrder.cpp contains the orderings of the elements and points of a
+ *                 mesh along space filling curves, which keep elements
+ *                 that are close in space close in the traversal
+ *
+ * This file is part of VERDICT
+ *
+ */
+
+#include "verdict_mesh.h"
+#include "V_Parallel.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace VERDICT_NAMESPACE
+{
+
+//! bits per axis of the quantized centroids, so the three fit in 63 bits
+static const int curve_bits = 21;
+
+//! elements per block of the parallel passes
+static const VerdictIndex order_block_size = 4096;
+
+//! the argument of the passes over the centroids, shared by all blocks
+struct CentroidArguments
+{
+  int nodes_per_element;
+  const double* points;
+  const VerdictIndex* connectivity;
+  const VerdictIndex* offsets;
+
+  // the bounding box of the centroids, per thread for the first pass
+  std::vector<double> lower;
+  std::vector<double> upper;
+
+  VerdictCurve curve;
+  double scale[3];
+  std::pair<unsigned long long, VerdictIndex>* keys;
+
+  //! the centroid of element e; false for an element without nodes
+  bool centroid( VerdictIndex e, double center[3] ) const
+  {
+    const VerdictIndex* nodes;
+    VerdictIndex num_nodes;
+    if ( offsets )
+    {
+      nodes = connectivity + offsets[e];
+      num_nodes = offsets[e+1] - offsets[e];
+    }
+    else
+    {
+      nodes = connectivity + e*nodes_per_element;
+      num_nodes = nodes_per_element;
+    }
+    if ( num_nodes <= 0 )
+      return false;
+
+    center[0] = center[1] = center[2] = 0.;
+    for ( VerdictIndex n = 0; n < num_nodes; n++ )
+    {
+      const double* point = points + 3*nodes[n];
+      center[0] += point[0];
+      center[1] += point[1];
+      center[2] += point[2];
+    }
+    for ( int c = 0; c < 3; c++ )
+      center[c] /= num_nodes;
+    return true;
+  }
+};
+
+static void centroid_bounds_block( void* data, VerdictIndex begin, VerdictIndex end, int thread )
+{
+  CentroidArguments &args = *static_cast<CentroidArguments*>( data );
+  double* lower = &args.lower[3*thread];
+  double* upper = &args.upper[3*thread];
+  double center[3];
+  for ( VerdictIndex e = begin; e < end; e++ )
+    if ( args.centroid( e, center ) )
+      for ( int c = 0; c < 3; c++ )
+      {
+        if ( center[c] < lower[c] )
+          lower[c] = center[c];
+        if ( center[c] > upper[c] )
+          upper[c] = center[c];
+      }
+}
+
+//! the bits of value spread to every third bit
+static inline unsigned long long spread_bits( unsigned long long value )
+{
+  value &= 0x1fffff;
+  value = ( value | value << 32 ) & 0x1f00000000ffffULL;
+  value = ( value | value << 16 ) & 0x1f0000ff0000ffULL;
+  value = ( value | value << 8 ) & 0x100f00f00f00f00fULL;
+  value = ( value | value << 4 ) & 0x10c30c30c30c30c3ULL;
+  value = ( value | value << 2 ) & 0x1249249249249249ULL;
+  return value;
+}
+
+//! the position along the Z curve, bit b of x above bit b of y above bit b of z
+static inline unsigned long long morton_key( unsigned int x[3] )
+{
+  return spread_bits( x[0] ) << 2 | spread_bits( x[1] ) << 1 | spread_bits( x[2] );
+}
+
+//! the position along the Hilbert curve, by the transpose algorithm of Skilling (2004)
+static inline unsigned long long hilbert_key( unsigned int x[3] )
+{
+  const unsigned int highest = 1u << ( curve_bits - 1 );
+  for ( unsigned int q = highest; q > 1; q >>= 1 )
+  {
+    const unsigned int p = q - 1;
+    for ( int i = 0; i < 3; i++ )
+      if ( x[i] & q )
+        x[0] ^= p;
+      else
+      {
+        const unsigned int t = ( x[0] ^ x[i] ) & p;
+        x[0] ^= t;
+        x[i] ^= t;
+      }
+  }
+
+  x[1] ^= x[0];
+  x[2] ^= x[1];
+  unsigned int t = 0;
+  for ( unsigned int q = highest; q > 1; q >>= 1 )
+    if ( x[2] & q )
+      t ^= q - 1;
+  for ( int i = 0; i < 3; i++ )
+    x[i] ^= t;
+
+  // the transposed index interleaves like a Morton key
+  return morton_key( x );
+}
+
+static void curve_keys_block( void* data, VerdictIndex begin, VerdictIndex end, int /*thread*/ )
+{
+  const CentroidArguments &args = *static_cast<const CentroidArguments*>( data );
+  const double largest = (double)( ( 1u << curve_bits ) - 1 );
+  double center[3];
+  for ( VerdictIndex e = begin; e < end; e++ )
+  {
+    unsigned int cell[3] = { 0, 0, 0 };
+    if ( args.centroid( e, center ) )
+      for ( int c = 0; c < 3; c++ )
+      {
+        const double position = ( center[c] - args.lower[c] ) * args.scale[c];
+        // also sends NaN to 0
+        cell[c] = position > 0. ? (unsigned int)( position < largest ? position : largest ) : 0;
+      }
+    const unsigned long long key =
+      args.curve == VERDICT_CURVE_HILBERT ? hilbert_key( cell ) : morton_key( cell );
+    args.keys[e] = std::make_pair( key, e );
+  }
+}
+
+//! sorts the elements by the position of their centroids along the curve
+static void element_order( CentroidArguments &args, VerdictIndex num_elements,
+                           VerdictIndex* order, int num_threads )
+{
+  if ( num_elements <= 0 )
+    return;
+
+  const int threads = parallel_thread_count( num_threads );
+  args.lower.assign( 3*threads, VERDICT_DBL_MAX );
+  args.upper.assign( 3*threads, -VERDICT_DBL_MAX );
+  parallel_for_blocks( num_elements, order_block_size, num_threads, centroid_bounds_block, &args );
+  for ( int t = 1; t < threads; t++ )
+    for ( int c = 0; c < 3; c++ )
+    {
+      args.lower[c] = std::min( args.lower[c], args.lower[3*t + c] );
+      args.upper[c] = std::max( args.upper[c], args.upper[3*t + c] );
+    }
+
+  // the cells split the bounding box of the centroids evenly along each axis
+  for ( int c = 0; c < 3; c++ )
+  {
+    const double extent = args.upper[c] - args.lower[c];
+    args.scale[c] = extent > 0. ? ( 1u << curve_bits ) / extent : 0.;
+  }
+
+  std::vector<std::pair<unsigned long long, VerdictIndex> > keys( num_elements );
+  args.keys = keys.data();
+  parallel_for_blocks( num_elements, order_block_size, num_threads, curve_keys_block, &args );
+
+  // elements in the same cell stay in their original order
+  std::sort( keys.begin(), keys.end() );
+  for ( VerdictIndex i = 0; i < num_elements; i++ )
+    order[i] = keys[i].second;
+}
+
+void mesh_element_order( VerdictCurve curve,
+                         VerdictIndex num_elements,
+                         const double* points,
+                         const VerdictIndex* connectivity,
+                         const VerdictIndex* offsets,
+                         VerdictIndex* order,
+                         int num_threads )
+{
+  CentroidArguments args;
+  args.nodes_per_element = 0;
+  args.points = points;
+  args.connectivity = connectivity;
+  args.offsets = offsets;
+  args.curve = curve;
+  element_order( args, num_elements, order, num_threads );
+}
+
+void mesh_element_order( VerdictCurve curve,
+                         VerdictIndex num_elements,
+                         int nodes_per_element,
+                         const double* points,
+                         const VerdictIndex* connectivity,
+                         VerdictIndex* order,
+                         int num_threads )
+{
+  CentroidArguments args;
+  args.nodes_per_element = nodes_per_element > 0 ? nodes_per_element : 0;
+  args.points = points;
+  args.connectivity = connectivity;
+  args.offsets = nullptr;
+  args.curve = curve;
+  element_order( args, num_elements, order, num_threads );
+}
+
+//! copies the elements in order, numbering the points in the order they are first used
+static void reorder( VerdictIndex num_elements, int nodes_per_element,
+                     const double* points, VerdictIndex num_points,
+                     const VerdictIndex* connectivity, const VerdictIndex* offsets,
+                     const VerdictIndex* order, double* new_points,
+                     VerdictIndex* new_connectivity, VerdictIndex* new_offsets )
+{
+  VerdictIndex entry = 0;
+  if ( new_offsets )
+    new_offsets[0] = 0;
+  for ( VerdictIndex i = 0; i < num_elements; i++ )
+  {
+    const VerdictIndex e = order[i];
+    const VerdictIndex begin = offsets ? offsets[e] : e*nodes_per_element;
+    const VerdictIndex end = offsets ? offsets[e+1] : begin + nodes_per_element;
+    for ( VerdictIndex n = begin; n < end; n++ )
+      new_connectivity[entry++] = connectivity[n];
+    if ( new_offsets )
+      new_offsets[i+1] = entry;
+  }
+  if ( !new_points )
+    return;
+
+  std::vector<VerdictIndex> numbers( num_points, -1 );
+  VerdictIndex next = 0;
+  for ( VerdictIndex n = 0; n < entry; n++ )
+  {
+    VerdictIndex &number = numbers[new_connectivity[n]];
+    if ( number < 0 )
+      number = next++;
+    new_connectivity[n] = number;
+  }
+  for ( VerdictIndex p = 0; p < num_points; p++ )
+  {
+    if ( numbers[p] < 0 )
+      numbers[p] = next++;
+    for ( int c = 0; c < 3; c++ )
+      new_points[3*numbers[p] + c] = points[3*p + c];
+  }
+}
+
+void mesh_reorder( VerdictIndex num_elements,
+                   const double* points,
+                   VerdictIndex num_points,
+                   const VerdictIndex* connectivity,
+                   const VerdictIndex* offsets,
+                   const VerdictIndex* order,
+                   double* new_points,
+                   VerdictIndex* new_connectivity,
+                   VerdictIndex* new_offsets )
+{
+  reorder( num_elements > 0 ? num_elements : 0, 0, points, num_points, connectivity, offsets,
+           order, new_points, new_connectivity, new_offsets );
+}
+
+void mesh_reorder( VerdictIndex num_elements,
+                   int nodes_per_element,
+                   const double* points,
+                   VerdictIndex num_points,
+                   const VerdictIndex* connectivity,
+                   const VerdictIndex* order,
+                   double* new_points,
+                   VerdictIndex* new_connectivity )
+{
+  reorder( num_elements > 0 ? num_elements : 0, nodes_per_element > 0 ? nodes_per_element : 0,
+           points, num_points, connectivity, nullptr, order, new_points, new_connectivity, nullptr );
+}
+
+} // namespace verdict
@@ -0,0 +1,231 @@
+/*=========================================================================
+
+  Module:    V_MeshQueue.cpp
+
+  Copyright 2003,2006,2019 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+  Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government retains certain rights in this software.
+
+  See LICENSE for details.
+
+=========================================================================*/
+
+
+/*
+ *
+ * V_MeshQueue.cpp contains the queue evaluating blocks of elements on a
+ *                 thread of its own while the caller goes on
+ *
+ * This file is part of VERDICT
+ *
+ */
+
+#include "verdict_mesh.h"
+
+#include <stddef.h>
+#include <vector>
+
+#if defined(VERDICT_PARALLEL_THREADS) || defined(VERDICT_PARALLEL_OPENMP) || defined(VERDICT_PARALLEL_TBB)
+# define VERDICT_QUEUE_THREAD
+# include <condition_variable>
+# include <mutex>
+# include <thread>
+#endif
+
+namespace VERDICT_NAMESPACE
+{
+
+//! a block submitted, with copies of its metrics and results pointers
+struct QueuedBlock
+{
+  QualityBlock block;
+  std::vector<VerdictMetric> metrics;
+  std::vector<double*> results;
+  QualityCallback callback;
+  void* callback_data;
+};
+
+static void evaluate_block( const QueuedBlock &queued, int num_threads )
+{
+  const QualityBlock &block = queued.block;
+  for ( size_t m = 0; m < queued.metrics.size(); m++ )
+    parallel_mesh_quality( queued.metrics[m], block.num_elements, block.nodes_per_element, block.points,
+                           block.connectivity, block.average_size, queued.results[m], num_threads );
+}
+
+/*!
+  the tickets completed + 1 ... submitted are pending, and the block of
+  ticket t is in slot (t - 1) % max_pending of the ring.  Since the blocks
+  complete in order, a ticket is complete once completed reaches it.
+*/
+struct MeshQualityQueue::Internals
+{
+  int num_threads;
+  std::vector<QueuedBlock> ring;
+  VerdictIndex submitted;
+  VerdictIndex completed;
+#if defined(VERDICT_QUEUE_THREAD)
+  mutable std::mutex mutex;
+  std::condition_variable work;     //!< a block was submitted, or the queue stops
+  std::condition_variable progress; //!< a block completed
+  bool stopping;
+  std::thread worker;
+#endif
+
+  Internals( int max_pending, int threads )
+    : num_threads( threads ), ring( max_pending ), submitted( 0 ), completed( 0 )
+#if defined(VERDICT_QUEUE_THREAD)
+    , stopping( false )
+#endif
+  {
+  }
+
+  bool is_full() const { return submitted - completed >= (VerdictIndex)ring.size(); }
+
+  //! fills the next slot and returns its ticket
+  VerdictIndex queue( const QualityBlock &block, QualityCallback callback, void* callback_data )
+  {
+    QueuedBlock &queued = ring[submitted % ring.size()];
+    queued.block = block;
+    const int num_metrics = block.num_metrics > 0 ? block.num_metrics : 0;
+    queued.metrics.assign( block.metrics, block.metrics + num_metrics );
+    queued.results.assign( block.results, block.results + num_metrics );
+    queued.block.metrics = nullptr;
+    queued.block.results = nullptr;
+    queued.callback = callback;
+    queued.callback_data = callback_data;
+    return ++submitted;
+  }
+
+  //! evaluates the block of the oldest pending ticket, which stays in its slot until completed moves on
+  void complete_oldest()
+  {
+    const QueuedBlock &queued = ring[completed % ring.size()];
+    evaluate_block( queued, num_threads );
+    if ( queued.callback )
+      queued.callback( queued.callback_data, completed + 1 );
+  }
+
+#if defined(VERDICT_QUEUE_THREAD)
+  void run()
+  {
+    std::unique_lock<std::mutex> lock( mutex );
+    for ( ;; )
+    {
+      while ( completed == submitted && !stopping )
+        work.wait( lock );
+      if ( completed == submitted )
+        return;
+
+      // submit only writes the slots of completed tickets, so this one is evaluated unlocked
+      lock.unlock();
+      complete_oldest();
+      lock.lock();
+      completed++;
+      progress.notify_all();
+    }
+  }
+#endif
+};
+
+MeshQualityQueue::MeshQualityQueue( int max_pending, int num_threads )
+{
+  internals = new Internals( max_pending > 0 ? max_pending : 1, num_threads );
+#if defined(VERDICT_QUEUE_THREAD)
+  internals->worker = std::thread( &Internals::run, internals );
+#endif
+}
+
+MeshQualityQueue::~MeshQualityQueue()
+{
+#if defined(VERDICT_QUEUE_THREAD)
+  {
+    std::lock_guard<std::mutex> lock( internals->mutex );
+    internals->stopping = true;
+  }
+  internals->work.notify_one();
+  internals->worker.join();
+#endif
+  delete internals;
+}
+
+int MeshQualityQueue::max_pending() const
+{
+  return (int)internals->ring.size();
+}
+
+int MeshQualityQueue::pending() const
+{
+#if defined(VERDICT_QUEUE_THREAD)
+  std::lock_guard<std::mutex> lock( internals->mutex );
+#endif
+  return (int)( internals->submitted - internals->completed );
+}
+
+VerdictIndex MeshQualityQueue::submit( const QualityBlock &block, QualityCallback callback, void* callback_data )
+{
+#if defined(VERDICT_QUEUE_THREAD)
+  std::unique_lock<std::mutex> lock( internals->mutex );
+  while ( internals->is_full() )
+    internals->progress.wait( lock );
+  const VerdictIndex ticket = internals->queue( block, callback, callback_data );
+  lock.unlock();
+  internals->work.notify_one();
+  return ticket;
+#else
+  const VerdictIndex ticket = internals->queue( block, callback, callback_data );
+  internals->complete_oldest();
+  internals->completed++;
+  return ticket;
+#endif
+}
+
+bool MeshQualityQueue::try_submit( const QualityBlock &block, QualityCallback callback, void* callback_data,
+                                   VerdictIndex &ticket )
+{
+#if defined(VERDICT_QUEUE_THREAD)
+  {
+    std::lock_guard<std::mutex> lock( internals->mutex );
+    if ( internals->is_full() )
+      return false;
+    ticket = internals->queue( block, callback, callback_data );
+  }
+  internals->work.notify_one();
+  return true;
+#else
+  ticket = submit( block, callback, callback_data );
+  return true;
+#endif
+}
+
+bool MeshQualityQueue::is_complete( VerdictIndex ticket ) const
+{
+#if defined(VERDICT_QUEUE_THREAD)
+  std::lock_guard<std::mutex> lock( internals->mutex );
+#endif
+  return ticket <= internals->completed;
+}
+
+void MeshQualityQueue::wait( VerdictIndex ticket )
+{
+#if defined(VERDICT_QUEUE_THREAD)
+  std::unique_lock<std::mutex> lock( internals->mutex );
+  // a ticket never handed out would wait forever
+  if ( ticket > internals->submitted )
+    ticket = internals->submitted;
+  while ( internals->completed < ticket )
+    internals->progress.wait( lock );
+#else
+  (void)ticket;
+#endif
+}
+
+void MeshQualityQueue::wait_all()
+{
+#if defined(VERDICT_QUEUE_THREAD)
+  std::unique_lock<std::mutex> lock( internals->mutex );
+  while ( internals->completed < internals->submitted )
+    internals->progress.wait( lock );
+#endif
+}
+
+} // namespace verdict
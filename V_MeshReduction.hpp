@@ -0,0 +1,100 @@
+/*=========================================================================
+
+  Module:    V_MeshReduction.hpp
+
+  Copyright 2003,2006,2019 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+  Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government retains certain rights in this software.
+
+  See LICENSE for details.
+
+=========================================================================*/
+
+/*
+ *
+ * V_MeshReduction.hpp contains the partial results of the mesh-level
+ *                     reductions, which the threads of one process merge
+ *                     and which the distributed functions merge again
+ *                     across processes.  Only the elements a process owns
+ *                     are counted, so elements shared as ghosts are
+ *                     counted once over all processes.
+ *
+ * This file is part of VERDICT
+ *
+ */
+
+#ifndef VERDICT_MESH_REDUCTION_HPP
+#define VERDICT_MESH_REDUCTION_HPP
+
+#include "verdict_mesh.h"
+
+namespace VERDICT_NAMESPACE
+{
+
+/*!
+  statistics gathered by one thread.  The mean and the sum of squared
+  differences from it are updated one value at a time, as by Welford,
+  and the partials of two threads are combined as by Chan et al.
+*/
+struct alignas(64) StatisticsPartial
+{
+  VerdictIndex count;
+  double minimum;
+  double maximum;
+  double mean;
+  double squared_differences;
+  VerdictIndex below_acceptable;
+  VerdictIndex above_acceptable;
+  VerdictIndex histogram[VERDICT_MAX_HISTOGRAM_BINS];
+  int num_worst;
+  VerdictIndex worst_elements[VERDICT_MAX_WORST_ELEMENTS];
+  double worst_values[VERDICT_MAX_WORST_ELEMENTS];
+};
+
+//! a partial of no elements
+StatisticsPartial empty_statistics();
+
+//! the request with its number of bins and worst elements within the supported range
+MeshStatisticsRequest bounded_request( MeshStatisticsRequest request );
+
+//! adds the elements of from to into; request is bounded
+void merge_statistics( StatisticsPartial &into, const StatisticsPartial &from,
+                       const MeshStatisticsRequest &request );
+
+//! the statistics of the elements of a partial; request is bounded
+void partial_statistics( const StatisticsPartial &total, const MeshStatisticsRequest &request,
+                         MeshStatistics &statistics );
+
+/*!
+  the statistics of the elements e with owned[e] of a block, all elements
+  for a null owned, merged over the threads.  The layout of the arguments
+  is that of mesh_statistics, with nodes_per_element ignored when offsets
+  is not null.  The worst elements are numbered by global_ids when it is
+  not null.  results, when not null, receives the values of all elements;
+  without a metric it holds them already.
+*/
+StatisticsPartial owned_statistics( VerdictFunction metric,
+                                    VerdictIndex num_elements,
+                                    int nodes_per_element,
+                                    const double* points,
+                                    const VerdictIndex* connectivity,
+                                    const VerdictIndex* offsets,
+                                    const unsigned char* owned,
+                                    const VerdictIndex* global_ids,
+                                    const MeshStatisticsRequest &request,
+                                    double* results,
+                                    int num_threads );
+
+//! mesh_element_sizes, returning the sum of the sizes of the elements e
+//! with owned[e], all elements for a null owned, rather than their average
+double owned_element_sizes( VerdictSizeElement type,
+                            VerdictIndex num_elements,
+                            int nodes_per_element,
+                            const double* points,
+                            const VerdictIndex* connectivity,
+                            const unsigned char* owned,
+                            double* measures,
+                            int num_threads );
+
+} // namespace verdict
+
+#endif
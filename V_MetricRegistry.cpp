@@ -0,0 +1,554 @@
+/*=========================================================================
+
+  Module:    V_MetricRegistry.cpp
+
+  Copyright 2003,2006,2019 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+  Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government retains certain rights in this software.
+
+  See LICENSE for details.
+
+=========================================================================*/
+
+
+/*
+ *
+ * V_MetricRegistry.cpp contains the registry of the single element metrics,
+ *                      with their ranges from the Verdict manual, and the
+ *                      loops each metric runs over a block of elements
+ *
+ * This file is part of VERDICT
+ *
+ */
+
+#include "V_MetricRegistry.hpp"
+#include "V_ScratchArena.hpp"
+#include "verdict_fixed.h"
+#include "verdict_kernels.h"
+
+#include <ctype.h>
+
+namespace VERDICT_NAMESPACE
+{
+
+/*!
+  the registered metrics, in the order of VerdictMetric.  The ranges are
+  acceptable, normal and full, as in the tables of the Verdict manual, but
+  for the acceptable range of quad_skew, which the manual gives as that of
+  a metric whose ideal is 1, and the full range of hex_diagonal, which it
+  gives as [1, VERDICT_DBL_MAX].  The scaled jacobians of tets and tris are
+  normalized, so their ranges are those of the other elements.
+*/
+static const VerdictMetricInfo metric_registry[] =
+{
+  { VERDICT_METRIC_EDGE_LENGTH, "edge_length", VERDICT_ELEMENT_EDGE, 2, edge_length, nullptr, true,
+    -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX },
+  { VERDICT_METRIC_TRI_EDGE_RATIO, "tri_edge_ratio", VERDICT_ELEMENT_TRI, 3, tri_edge_ratio, nullptr, false,
+    1., 1.3, 1., VERDICT_DBL_MAX, 1., VERDICT_DBL_MAX },
+  { VERDICT_METRIC_TRI_ASPECT_RATIO, "tri_aspect_ratio", VERDICT_ELEMENT_TRI, 3, tri_aspect_ratio, nullptr, false,
+    1., 1.3, 1., VERDICT_DBL_MAX, 1., VERDICT_DBL_MAX },
+  { VERDICT_METRIC_TRI_RADIUS_RATIO, "tri_radius_ratio", VERDICT_ELEMENT_TRI, 3, tri_radius_ratio, nullptr, false,
+    1., 3., 1., VERDICT_DBL_MAX, 1., VERDICT_DBL_MAX },
+  { VERDICT_METRIC_TRI_ASPECT_FROBENIUS, "tri_aspect_frobenius", VERDICT_ELEMENT_TRI, 3, tri_aspect_frobenius, nullptr, false,
+    1., 1.3, 1., VERDICT_DBL_MAX, 1., VERDICT_DBL_MAX },
+  { VERDICT_METRIC_TRI_AREA, "tri_area", VERDICT_ELEMENT_TRI, 3, tri_area, nullptr, true,
+    0., VERDICT_DBL_MAX, 0., VERDICT_DBL_MAX, 0., VERDICT_DBL_MAX },
+  { VERDICT_METRIC_TRI_MINIMUM_ANGLE, "tri_minimum_angle", VERDICT_ELEMENT_TRI, 3, tri_minimum_angle, nullptr, true,
+    30., 60., 0., 60., 0., 360. },
+  { VERDICT_METRIC_TRI_MAXIMUM_ANGLE, "tri_maximum_angle", VERDICT_ELEMENT_TRI, 3, tri_maximum_angle, nullptr, false,
+    60., 90., 60., 180., 0., 180. },
+  { VERDICT_METRIC_TRI_CONDITION, "tri_condition", VERDICT_ELEMENT_TRI, 3, tri_condition, nullptr, false,
+    1., 1.3, 1., VERDICT_DBL_MAX, 1., VERDICT_DBL_MAX },
+  { VERDICT_METRIC_TRI_SCALED_JACOBIAN, "tri_scaled_jacobian", VERDICT_ELEMENT_TRI, 3, tri_scaled_jacobian, nullptr, true,
+    0.5, 1., -1., 1., -VERDICT_DBL_MAX, VERDICT_DBL_MAX },
+  { VERDICT_METRIC_TRI_RELATIVE_SIZE_SQUARED, "tri_relative_size_squared", VERDICT_ELEMENT_TRI, 3, nullptr, tri_relative_size_squared, true,
+    0.25, 1., 0., 1., 0., 1. },
+  { VERDICT_METRIC_TRI_SHAPE, "tri_shape", VERDICT_ELEMENT_TRI, 3, tri_shape, nullptr, true,
+    0.25, 1., 0., 1., 0., 1. },
+  { VERDICT_METRIC_TRI_SHAPE_AND_SIZE, "tri_shape_and_size", VERDICT_ELEMENT_TRI, 3, nullptr, tri_shape_and_size, true,
+    0.25, 1., 0., 1., 0., 1. },
+  { VERDICT_METRIC_TRI_DISTORTION, "tri_distortion", VERDICT_ELEMENT_TRI, 3, tri_distortion, nullptr, true,
+    0.5, 1., 0., 1., -VERDICT_DBL_MAX, VERDICT_DBL_MAX },
+  { VERDICT_METRIC_TRI_EQUIANGLE_SKEW, "tri_equiangle_skew", VERDICT_ELEMENT_TRI, 3, tri_equiangle_skew, nullptr, false,
+    -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX },
+  { VERDICT_METRIC_TRI_NORMALIZED_INRADIUS, "tri_normalized_inradius", VERDICT_ELEMENT_TRI, 3, tri_normalized_inradius, nullptr, true,
+    -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX },
+  { VERDICT_METRIC_QUAD_EDGE_RATIO, "quad_edge_ratio", VERDICT_ELEMENT_QUAD, 4, quad_edge_ratio, nullptr, false,
+    1., 1.3, 1., VERDICT_DBL_MAX, 1., VERDICT_DBL_MAX },
+  { VERDICT_METRIC_QUAD_MAX_EDGE_RATIO, "quad_max_edge_ratio", VERDICT_ELEMENT_QUAD, 4, quad_max_edge_ratio, nullptr, false,
+    1., 1.3, 1., VERDICT_DBL_MAX, 1., VERDICT_DBL_MAX },
+  { VERDICT_METRIC_QUAD_ASPECT_RATIO, "quad_aspect_ratio", VERDICT_ELEMENT_QUAD, 4, quad_aspect_ratio, nullptr, false,
+    1., 1.3, 1., VERDICT_DBL_MAX, 1., VERDICT_DBL_MAX },
+  { VERDICT_METRIC_QUAD_RADIUS_RATIO, "quad_radius_ratio", VERDICT_ELEMENT_QUAD, 4, quad_radius_ratio, nullptr, false,
+    1., 1.3, 1., VERDICT_DBL_MAX, 1., VERDICT_DBL_MAX },
+  { VERDICT_METRIC_QUAD_MED_ASPECT_FROBENIUS, "quad_med_aspect_frobenius", VERDICT_ELEMENT_QUAD, 4, quad_med_aspect_frobenius, nullptr, false,
+    1., 1.3, 1., VERDICT_DBL_MAX, 1., VERDICT_DBL_MAX },
+  { VERDICT_METRIC_QUAD_MAX_ASPECT_FROBENIUS, "quad_max_aspect_frobenius", VERDICT_ELEMENT_QUAD, 4, quad_max_aspect_frobenius, nullptr, false,
+    1., 1.3, 1., VERDICT_DBL_MAX, 1., VERDICT_DBL_MAX },
+  { VERDICT_METRIC_QUAD_SKEW, "quad_skew", VERDICT_ELEMENT_QUAD, 4, quad_skew, nullptr, false,
+    0., 0.5, 0., 1., 0., 1. },
+  { VERDICT_METRIC_QUAD_TAPER, "quad_taper", VERDICT_ELEMENT_QUAD, 4, quad_taper, nullptr, false,
+    0., 0.7, 0., VERDICT_DBL_MAX, 0., VERDICT_DBL_MAX },
+  { VERDICT_METRIC_QUAD_WARPAGE, "quad_warpage", VERDICT_ELEMENT_QUAD, 4, quad_warpage, nullptr, false,
+    0., 0.7, 0., 2., 0., VERDICT_DBL_MAX },
+  { VERDICT_METRIC_QUAD_AREA, "quad_area", VERDICT_ELEMENT_QUAD, 4, quad_area, nullptr, true,
+    0., VERDICT_DBL_MAX, 0., VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX },
+  { VERDICT_METRIC_QUAD_STRETCH, "quad_stretch", VERDICT_ELEMENT_QUAD, 4, quad_stretch, nullptr, true,
+    0.25, 1., 0., 1., 0., VERDICT_DBL_MAX },
+  { VERDICT_METRIC_QUAD_MINIMUM_ANGLE, "quad_minimum_angle", VERDICT_ELEMENT_QUAD, 4, quad_minimum_angle, nullptr, true,
+    45., 90., 0., 90., 0., 360. },
+  { VERDICT_METRIC_QUAD_MAXIMUM_ANGLE, "quad_maximum_angle", VERDICT_ELEMENT_QUAD, 4, quad_maximum_angle, nullptr, false,
+    90., 135., 90., 360., 0., 360. },
+  { VERDICT_METRIC_QUAD_ODDY, "quad_oddy", VERDICT_ELEMENT_QUAD, 4, quad_oddy, nullptr, false,
+    0., 0.5, 0., VERDICT_DBL_MAX, 0., VERDICT_DBL_MAX },
+  { VERDICT_METRIC_QUAD_CONDITION, "quad_condition", VERDICT_ELEMENT_QUAD, 4, quad_condition, nullptr, false,
+    1., 4., 1., VERDICT_DBL_MAX, 1., VERDICT_DBL_MAX },
+  { VERDICT_METRIC_QUAD_JACOBIAN, "quad_jacobian", VERDICT_ELEMENT_QUAD, 4, quad_jacobian, nullptr, true,
+    0., VERDICT_DBL_MAX, 0., VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX },
+  { VERDICT_METRIC_QUAD_SCALED_JACOBIAN, "quad_scaled_jacobian", VERDICT_ELEMENT_QUAD, 4, quad_scaled_jacobian, nullptr, true,
+    0.3, 1., -1., 1., -1., 1. },
+  { VERDICT_METRIC_QUAD_SHEAR, "quad_shear", VERDICT_ELEMENT_QUAD, 4, quad_shear, nullptr, true,
+    0.3, 1., 0., 1., 0., 1. },
+  { VERDICT_METRIC_QUAD_SHAPE, "quad_shape", VERDICT_ELEMENT_QUAD, 4, quad_shape, nullptr, true,
+    0.3, 1., 0., 1., 0., 1. },
+  { VERDICT_METRIC_QUAD_RELATIVE_SIZE_SQUARED, "quad_relative_size_squared", VERDICT_ELEMENT_QUAD, 4, nullptr, quad_relative_size_squared, true,
+    0.3, 1., 0., 1., 0., 1. },
+  { VERDICT_METRIC_QUAD_SHAPE_AND_SIZE, "quad_shape_and_size", VERDICT_ELEMENT_QUAD, 4, nullptr, quad_shape_and_size, true,
+    0.2, 1., 0., 1., 0., 1. },
+  { VERDICT_METRIC_QUAD_SHEAR_AND_SIZE, "quad_shear_and_size", VERDICT_ELEMENT_QUAD, 4, nullptr, quad_shear_and_size, true,
+    0.2, 1., 0., 1., 0., 1. },
+  { VERDICT_METRIC_QUAD_DISTORTION, "quad_distortion", VERDICT_ELEMENT_QUAD, 4, quad_distortion, nullptr, true,
+    0.5, 1., 0., 1., -VERDICT_DBL_MAX, VERDICT_DBL_MAX },
+  { VERDICT_METRIC_QUAD_EQUIANGLE_SKEW, "quad_equiangle_skew", VERDICT_ELEMENT_QUAD, 4, quad_equiangle_skew, nullptr, false,
+    -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX },
+  { VERDICT_METRIC_TET_INRADIUS, "tet_inradius", VERDICT_ELEMENT_TET, 4, tet_inradius, nullptr, true,
+    -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX },
+  { VERDICT_METRIC_TET_EDGE_RATIO, "tet_edge_ratio", VERDICT_ELEMENT_TET, 4, tet_edge_ratio, nullptr, false,
+    1., 3., 1., VERDICT_DBL_MAX, 1., VERDICT_DBL_MAX },
+  { VERDICT_METRIC_TET_RADIUS_RATIO, "tet_radius_ratio", VERDICT_ELEMENT_TET, 4, tet_radius_ratio, nullptr, false,
+    1., 3., 1., VERDICT_DBL_MAX, 1., VERDICT_DBL_MAX },
+  { VERDICT_METRIC_TET_ASPECT_RATIO, "tet_aspect_ratio", VERDICT_ELEMENT_TET, 4, tet_aspect_ratio, nullptr, false,
+    1., 3., 1., VERDICT_DBL_MAX, 1., VERDICT_DBL_MAX },
+  { VERDICT_METRIC_TET_ASPECT_GAMMA, "tet_aspect_gamma", VERDICT_ELEMENT_TET, 4, tet_aspect_gamma, nullptr, false,
+    1., 3., 1., VERDICT_DBL_MAX, 1., VERDICT_DBL_MAX },
+  { VERDICT_METRIC_TET_ASPECT_FROBENIUS, "tet_aspect_frobenius", VERDICT_ELEMENT_TET, 4, tet_aspect_frobenius, nullptr, false,
+    1., 1.3, 1., VERDICT_DBL_MAX, 1., VERDICT_DBL_MAX },
+  { VERDICT_METRIC_TET_MINIMUM_ANGLE, "tet_minimum_angle", VERDICT_ELEMENT_TET, 4, tet_minimum_angle, nullptr, true,
+    40., 70.528779, 0., 70.528779, 0., 360. },
+  { VERDICT_METRIC_TET_COLLAPSE_RATIO, "tet_collapse_ratio", VERDICT_ELEMENT_TET, 4, tet_collapse_ratio, nullptr, true,
+    0.1, VERDICT_DBL_MAX, 0., VERDICT_DBL_MAX, 0., VERDICT_DBL_MAX },
+  { VERDICT_METRIC_TET_VOLUME, "tet_volume", VERDICT_ELEMENT_TET, 4, tet_volume, nullptr, true,
+    0., VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX },
+  { VERDICT_METRIC_TET_CONDITION, "tet_condition", VERDICT_ELEMENT_TET, 4, tet_condition, nullptr, false,
+    1., 3., 1., VERDICT_DBL_MAX, 1., VERDICT_DBL_MAX },
+  { VERDICT_METRIC_TET_JACOBIAN, "tet_jacobian", VERDICT_ELEMENT_TET, 4, tet_jacobian, nullptr, true,
+    0., VERDICT_DBL_MAX, 0., VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX },
+  { VERDICT_METRIC_TET_SCALED_JACOBIAN, "tet_scaled_jacobian", VERDICT_ELEMENT_TET, 4, tet_scaled_jacobian, nullptr, true,
+    0.5, 1., -1., 1., -VERDICT_DBL_MAX, VERDICT_DBL_MAX },
+  { VERDICT_METRIC_TET_MEAN_RATIO, "tet_mean_ratio", VERDICT_ELEMENT_TET, 4, tet_mean_ratio, nullptr, true,
+    -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX },
+  { VERDICT_METRIC_TET_NORMALIZED_INRADIUS, "tet_normalized_inradius", VERDICT_ELEMENT_TET, 4, tet_normalized_inradius, nullptr, true,
+    -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX },
+  { VERDICT_METRIC_TET_SHAPE, "tet_shape", VERDICT_ELEMENT_TET, 4, tet_shape, nullptr, true,
+    0.3, 1., 0., 1., 0., 1. },
+  { VERDICT_METRIC_TET_RELATIVE_SIZE_SQUARED, "tet_relative_size_squared", VERDICT_ELEMENT_TET, 4, nullptr, tet_relative_size_squared, true,
+    0.3, 1., 0., 1., 0., 1. },
+  { VERDICT_METRIC_TET_SHAPE_AND_SIZE, "tet_shape_and_size", VERDICT_ELEMENT_TET, 4, nullptr, tet_shape_and_size, true,
+    0.2, 1., 0., 1., 0., 1. },
+  { VERDICT_METRIC_TET_DISTORTION, "tet_distortion", VERDICT_ELEMENT_TET, 4, tet_distortion, nullptr, true,
+    0.5, 1., 0., 1., -VERDICT_DBL_MAX, VERDICT_DBL_MAX },
+  { VERDICT_METRIC_TET_EQUIVOLUME_SKEW, "tet_equivolume_skew", VERDICT_ELEMENT_TET, 4, tet_equivolume_skew, nullptr, false,
+    -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX },
+  { VERDICT_METRIC_TET_SQUISH_INDEX, "tet_squish_index", VERDICT_ELEMENT_TET, 4, tet_squish_index, nullptr, false,
+    -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX },
+  { VERDICT_METRIC_TET_EQUIANGLE_SKEW, "tet_equiangle_skew", VERDICT_ELEMENT_TET, 4, tet_equiangle_skew, nullptr, false,
+    -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX },
+  { VERDICT_METRIC_PYRAMID_VOLUME, "pyramid_volume", VERDICT_ELEMENT_PYRAMID, 5, pyramid_volume, nullptr, true,
+    0., VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX },
+  { VERDICT_METRIC_PYRAMID_JACOBIAN, "pyramid_jacobian", VERDICT_ELEMENT_PYRAMID, 5, pyramid_jacobian, nullptr, true,
+    -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX },
+  { VERDICT_METRIC_PYRAMID_SCALED_JACOBIAN, "pyramid_scaled_jacobian", VERDICT_ELEMENT_PYRAMID, 5, pyramid_scaled_jacobian, nullptr, true,
+    -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX },
+  { VERDICT_METRIC_PYRAMID_SHAPE, "pyramid_shape", VERDICT_ELEMENT_PYRAMID, 5, pyramid_shape, nullptr, true,
+    -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX },
+  { VERDICT_METRIC_PYRAMID_EQUIANGLE_SKEW, "pyramid_equiangle_skew", VERDICT_ELEMENT_PYRAMID, 5, pyramid_equiangle_skew, nullptr, false,
+    -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX },
+  { VERDICT_METRIC_WEDGE_VOLUME, "wedge_volume", VERDICT_ELEMENT_WEDGE, 6, wedge_volume, nullptr, true,
+    0., VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX },
+  { VERDICT_METRIC_WEDGE_EDGE_RATIO, "wedge_edge_ratio", VERDICT_ELEMENT_WEDGE, 6, wedge_edge_ratio, nullptr, false,
+    -VERDICT_DBL_MAX, VERDICT_DBL_MAX, 1., VERDICT_DBL_MAX, 1., VERDICT_DBL_MAX },
+  { VERDICT_METRIC_WEDGE_MAX_ASPECT_FROBENIUS, "wedge_max_aspect_frobenius", VERDICT_ELEMENT_WEDGE, 6, wedge_max_aspect_frobenius, nullptr, false,
+    -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX },
+  { VERDICT_METRIC_WEDGE_MEAN_ASPECT_FROBENIUS, "wedge_mean_aspect_frobenius", VERDICT_ELEMENT_WEDGE, 6, wedge_mean_aspect_frobenius, nullptr, false,
+    -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX },
+  { VERDICT_METRIC_WEDGE_JACOBIAN, "wedge_jacobian", VERDICT_ELEMENT_WEDGE, 6, wedge_jacobian, nullptr, true,
+    0., VERDICT_DBL_MAX, 0., VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX },
+  { VERDICT_METRIC_WEDGE_DISTORTION, "wedge_distortion", VERDICT_ELEMENT_WEDGE, 6, wedge_distortion, nullptr, true,
+    0.5, 1., 0., 1., -VERDICT_DBL_MAX, VERDICT_DBL_MAX },
+  { VERDICT_METRIC_WEDGE_MAX_STRETCH, "wedge_max_stretch", VERDICT_ELEMENT_WEDGE, 6, wedge_max_stretch, nullptr, true,
+    -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX, 0., VERDICT_DBL_MAX },
+  { VERDICT_METRIC_WEDGE_SCALED_JACOBIAN, "wedge_scaled_jacobian", VERDICT_ELEMENT_WEDGE, 6, wedge_scaled_jacobian, nullptr, true,
+    -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX },
+  { VERDICT_METRIC_WEDGE_SHAPE, "wedge_shape", VERDICT_ELEMENT_WEDGE, 6, wedge_shape, nullptr, true,
+    0.3, 1., 0., 1., 0., 1. },
+  { VERDICT_METRIC_WEDGE_CONDITION, "wedge_condition", VERDICT_ELEMENT_WEDGE, 6, wedge_condition, nullptr, false,
+    -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX },
+  { VERDICT_METRIC_WEDGE_EQUIANGLE_SKEW, "wedge_equiangle_skew", VERDICT_ELEMENT_WEDGE, 6, wedge_equiangle_skew, nullptr, false,
+    -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX },
+  { VERDICT_METRIC_KNIFE_VOLUME, "knife_volume", VERDICT_ELEMENT_KNIFE, 7, knife_volume, nullptr, true,
+    0., VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX },
+  { VERDICT_METRIC_HEX_EDGE_RATIO, "hex_edge_ratio", VERDICT_ELEMENT_HEX, 8, hex_edge_ratio, nullptr, false,
+    -VERDICT_DBL_MAX, VERDICT_DBL_MAX, 1., VERDICT_DBL_MAX, 1., VERDICT_DBL_MAX },
+  { VERDICT_METRIC_HEX_MAX_EDGE_RATIO, "hex_max_edge_ratio", VERDICT_ELEMENT_HEX, 8, hex_max_edge_ratio, nullptr, false,
+    1., 1.3, 1., VERDICT_DBL_MAX, 1., VERDICT_DBL_MAX },
+  { VERDICT_METRIC_HEX_SKEW, "hex_skew", VERDICT_ELEMENT_HEX, 8, hex_skew, nullptr, false,
+    0., 0.5, 0., 1., 0., VERDICT_DBL_MAX },
+  { VERDICT_METRIC_HEX_TAPER, "hex_taper", VERDICT_ELEMENT_HEX, 8, hex_taper, nullptr, false,
+    0., 0.5, 0., VERDICT_DBL_MAX, 0., VERDICT_DBL_MAX },
+  { VERDICT_METRIC_HEX_VOLUME, "hex_volume", VERDICT_ELEMENT_HEX, 8, hex_volume, nullptr, true,
+    0., VERDICT_DBL_MAX, 0., VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX },
+  { VERDICT_METRIC_HEX_STRETCH, "hex_stretch", VERDICT_ELEMENT_HEX, 8, hex_stretch, nullptr, true,
+    0.25, 1., 0., 1., 0., VERDICT_DBL_MAX },
+  { VERDICT_METRIC_HEX_DIAGONAL, "hex_diagonal", VERDICT_ELEMENT_HEX, 8, hex_diagonal, nullptr, true,
+    0.65, 1., 0., 1., 0., VERDICT_DBL_MAX },
+  { VERDICT_METRIC_HEX_DIMENSION, "hex_dimension", VERDICT_ELEMENT_HEX, 8, hex_dimension, nullptr, true,
+    -VERDICT_DBL_MAX, VERDICT_DBL_MAX, 0., VERDICT_DBL_MAX, 0., VERDICT_DBL_MAX },
+  { VERDICT_METRIC_HEX_ODDY, "hex_oddy", VERDICT_ELEMENT_HEX, 8, hex_oddy, nullptr, false,
+    0., 0.5, 0., VERDICT_DBL_MAX, 0., VERDICT_DBL_MAX },
+  { VERDICT_METRIC_HEX_MED_ASPECT_FROBENIUS, "hex_med_aspect_frobenius", VERDICT_ELEMENT_HEX, 8, hex_med_aspect_frobenius, nullptr, false,
+    1., 3., 1., VERDICT_DBL_MAX, 1., VERDICT_DBL_MAX },
+  { VERDICT_METRIC_HEX_MAX_ASPECT_FROBENIUS, "hex_max_aspect_frobenius", VERDICT_ELEMENT_HEX, 8, hex_max_aspect_frobenius, nullptr, false,
+    1., 3., 1., VERDICT_DBL_MAX, 1., VERDICT_DBL_MAX },
+  { VERDICT_METRIC_HEX_CONDITION, "hex_condition", VERDICT_ELEMENT_HEX, 8, hex_condition, nullptr, false,
+    1., 3., 1., VERDICT_DBL_MAX, 1., VERDICT_DBL_MAX },
+  { VERDICT_METRIC_HEX_JACOBIAN, "hex_jacobian", VERDICT_ELEMENT_HEX, 8, hex_jacobian, nullptr, true,
+    0., VERDICT_DBL_MAX, 0., VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX },
+  { VERDICT_METRIC_HEX_SCALED_JACOBIAN, "hex_scaled_jacobian", VERDICT_ELEMENT_HEX, 8, hex_scaled_jacobian, nullptr, true,
+    0.5, 1., -1., 1., -1., VERDICT_DBL_MAX },
+  { VERDICT_METRIC_HEX_NODAL_JACOBIAN_RATIO, "hex_nodal_jacobian_ratio", VERDICT_ELEMENT_HEX, 8, hex_nodal_jacobian_ratio, nullptr, true,
+    -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX },
+  { VERDICT_METRIC_HEX_SHEAR, "hex_shear", VERDICT_ELEMENT_HEX, 8, hex_shear, nullptr, true,
+    0.3, 1., 0., 1., 0., 1. },
+  { VERDICT_METRIC_HEX_SHAPE, "hex_shape", VERDICT_ELEMENT_HEX, 8, hex_shape, nullptr, true,
+    0.3, 1., 0., 1., 0., 1. },
+  { VERDICT_METRIC_HEX_RELATIVE_SIZE_SQUARED, "hex_relative_size_squared", VERDICT_ELEMENT_HEX, 8, nullptr, hex_relative_size_squared, true,
+    0.5, 1., 0., 1., 0., 1. },
+  { VERDICT_METRIC_HEX_SHAPE_AND_SIZE, "hex_shape_and_size", VERDICT_ELEMENT_HEX, 8, nullptr, hex_shape_and_size, true,
+    0.2, 1., 0., 1., 0., 1. },
+  { VERDICT_METRIC_HEX_SHEAR_AND_SIZE, "hex_shear_and_size", VERDICT_ELEMENT_HEX, 8, nullptr, hex_shear_and_size, true,
+    0.2, 1., 0., 1., 0., 1. },
+  { VERDICT_METRIC_HEX_DISTORTION, "hex_distortion", VERDICT_ELEMENT_HEX, 8, hex_distortion, nullptr, true,
+    0.5, 1., 0., 1., -VERDICT_DBL_MAX, VERDICT_DBL_MAX },
+  { VERDICT_METRIC_HEX_EQUIANGLE_SKEW, "hex_equiangle_skew", VERDICT_ELEMENT_HEX, 8, hex_equiangle_skew, nullptr, false,
+    -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX, -VERDICT_DBL_MAX, VERDICT_DBL_MAX },
+};
+
+static_assert( sizeof( metric_registry ) / sizeof( metric_registry[0] ) == VERDICT_NUM_METRICS,
+               "metric_registry holds one entry per VerdictMetric" );
+
+const VerdictMetricInfo* metric_info( VerdictMetric metric )
+{
+  if ( metric < 0 || metric >= VERDICT_NUM_METRICS )
+    return nullptr;
+  return &metric_registry[metric];
+}
+
+bool find_metric( const char* name, VerdictMetric &metric )
+{
+  if ( !name )
+    return false;
+  if ( tolower( (unsigned char)name[0] ) == 'v' && name[1] == '_' )
+    name += 2;
+
+  for ( int m = 0; m < VERDICT_NUM_METRICS; m++ )
+  {
+    const char* a = name;
+    const char* b = metric_registry[m].name;
+    while ( *a && tolower( (unsigned char)*a ) == *b )
+    {
+      a++;
+      b++;
+    }
+    if ( !*a && !*b )
+    {
+      metric = metric_registry[m].metric;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool find_metric( VerdictFunction function, VerdictMetric &metric )
+{
+  if ( !function )
+    return false;
+  for ( int m = 0; m < VERDICT_NUM_METRICS; m++ )
+    if ( metric_registry[m].function == function )
+    {
+      metric = metric_registry[m].metric;
+      return true;
+    }
+  return false;
+}
+
+MeshStatisticsRequest metric_statistics_request( VerdictMetric metric, int num_bins, int num_worst )
+{
+  MeshStatisticsRequest request = {};
+  request.num_bins = num_bins;
+  request.num_worst = num_worst;
+  const VerdictMetricInfo* info = metric_info( metric );
+  if ( info )
+  {
+    request.acceptable_min = info->acceptable_min;
+    request.acceptable_max = info->acceptable_max;
+    request.smaller_is_worse = info->smaller_is_worse;
+  }
+  else
+  {
+    request.acceptable_min = -VERDICT_DBL_MAX;
+    request.acceptable_max = VERDICT_DBL_MAX;
+    request.smaller_is_worse = true;
+  }
+  return request;
+}
+
+//! the loop of an unknown metric or an unsupported node count
+static void zero_block( const MetricBlock & /*block*/, VerdictIndex num_elements, const double* /*points*/,
+                        const VerdictIndex* /*connectivity*/, double* results )
+{
+  for ( VerdictIndex e = 0; e < num_elements; e++ )
+    results[e] = 0.0;
+}
+
+//! gathers each element and calls the single element function
+static void function_block( const MetricBlock &block, VerdictIndex num_elements, const double* points,
+                            const VerdictIndex* connectivity, double* results )
+{
+  double coordinates[VERDICT_MAX_NODES_PER_ELEMENT][3];
+  const int num_nodes = block.nodes_per_element;
+  const VerdictIndex* element_nodes = connectivity;
+  for ( VerdictIndex e = 0; e < num_elements; e++, element_nodes += num_nodes )
+  {
+    gather_element_nodes( points, element_nodes, num_nodes, coordinates );
+    results[e] = block.function( num_nodes, coordinates );
+  }
+}
+
+//! gathers each element and calls the single element function relative to the average size
+static void sized_function_block( const MetricBlock &block, VerdictIndex num_elements, const double* points,
+                                  const VerdictIndex* connectivity, double* results )
+{
+  double coordinates[VERDICT_MAX_NODES_PER_ELEMENT][3];
+  const int num_nodes = block.nodes_per_element;
+  const VerdictIndex* element_nodes = connectivity;
+  for ( VerdictIndex e = 0; e < num_elements; e++, element_nodes += num_nodes )
+  {
+    gather_element_nodes( points, element_nodes, num_nodes, coordinates );
+    results[e] = block.sized_function( num_nodes, coordinates, block.average_size );
+  }
+}
+
+typedef kernels::StridedNodes<double> PointNodes;
+
+//! reads the nodes in place and runs the kernel, which is inlined; the
+//! kernels perform the operations of the single element functions
+template <double (*Kernel)( const PointNodes& )>
+static void kernel_block( const MetricBlock &block, VerdictIndex num_elements, const double* points,
+                          const VerdictIndex* connectivity, double* results )
+{
+  const PointNodes nodes = { points, 3, connectivity, 0 };
+  for ( VerdictIndex e = 0; e < num_elements; e++ )
+    results[e] = Kernel( nodes.element( e*block.nodes_per_element ) );
+}
+
+//! elements per tile of the structure-of-arrays loops, so a tile of hexes
+//! stays in the L1 cache
+static const int soa_tile_elements = 64;
+
+//! gathers tiles of N node elements into structure-of-arrays form for the
+//! vectorized kernels
+template <void (*Soa)( VerdictIndex, const double*, VerdictIndex, double* ), int N>
+static void soa_block( const MetricBlock &block, VerdictIndex num_elements, const double* points,
+                       const VerdictIndex* connectivity, double* results )
+{
+  // aligned for the vector loads of the kernels
+  ScratchFrame scratch;
+  double* tile = scratch.take<double>( 3*N*soa_tile_elements );
+  for ( VerdictIndex first = 0; first < num_elements; first += soa_tile_elements )
+  {
+    const int count = num_elements - first < soa_tile_elements ?
+      (int)( num_elements - first ) : soa_tile_elements;
+    const VerdictIndex* element_nodes = connectivity + first*block.nodes_per_element;
+    for ( int i = 0; i < count; i++, element_nodes += block.nodes_per_element )
+      for ( int n = 0; n < N; n++ )
+      {
+        const double* point = points + 3*element_nodes[n];
+        for ( int c = 0; c < 3; c++ )
+          tile[( 3*n + c )*soa_tile_elements + i] = point[c];
+      }
+    Soa( count, tile, soa_tile_elements, results + first );
+  }
+}
+
+//! the loop of a MetricBlock
+typedef void (*BlockLoop)( const MetricBlock&, VerdictIndex, const double*, const VerdictIndex*, double* );
+
+/*!
+  the specialized loops of the metrics of linear elements, for blocks with
+  as many nodes as the element has corners.  exact gives the results of the
+  single element function bit for bit; fast, when set, is faster and
+  agrees with it as the structure-of-arrays functions do.  The tet_shape
+  kernel computes the cube root of 2, which the compiler may round
+  differently when it folds the constant of the single element function.
+*/
+struct MetricSpecialization
+{
+  VerdictMetric metric;
+  BlockLoop exact;
+  BlockLoop fast;
+};
+
+static const MetricSpecialization metric_specializations[] =
+{
+  { VERDICT_METRIC_TRI_EDGE_RATIO, kernel_block<kernels::tri_edge_ratio<double, PointNodes> >, nullptr },
+  { VERDICT_METRIC_TRI_AREA, kernel_block<kernels::tri_area<double, PointNodes> >, nullptr },
+  { VERDICT_METRIC_TRI_MINIMUM_ANGLE, function_block, soa_block<tri_minimum_angle_soa, 3> },
+  { VERDICT_METRIC_TRI_CONDITION, kernel_block<kernels::tri_condition<double, PointNodes> >, nullptr },
+  { VERDICT_METRIC_TRI_SCALED_JACOBIAN, kernel_block<kernels::tri_scaled_jacobian<double, PointNodes> >, nullptr },
+  { VERDICT_METRIC_TRI_SHAPE, kernel_block<kernels::tri_shape<double, PointNodes> >, nullptr },
+  { VERDICT_METRIC_QUAD_WARPAGE, function_block, soa_block<quad_warpage_soa, 4> },
+  { VERDICT_METRIC_QUAD_AREA, kernel_block<kernels::quad_area<double, PointNodes> >, nullptr },
+  { VERDICT_METRIC_QUAD_MINIMUM_ANGLE, function_block, soa_block<quad_minimum_angle_soa, 4> },
+  { VERDICT_METRIC_QUAD_CONDITION, kernel_block<kernels::quad_condition<double, PointNodes> >, nullptr },
+  { VERDICT_METRIC_QUAD_JACOBIAN, kernel_block<kernels::quad_jacobian<double, PointNodes> >, nullptr },
+  { VERDICT_METRIC_QUAD_SCALED_JACOBIAN, kernel_block<kernels::quad_scaled_jacobian<double, PointNodes> >,
+    soa_block<quad_scaled_jacobian_soa, 4> },
+  { VERDICT_METRIC_QUAD_SHEAR, kernel_block<kernels::quad_shear<double, PointNodes> >, nullptr },
+  { VERDICT_METRIC_QUAD_SHAPE, kernel_block<kernels::quad_shape<double, PointNodes> >, nullptr },
+  { VERDICT_METRIC_TET_EDGE_RATIO, kernel_block<kernels::tet_edge_ratio<double, PointNodes> >, nullptr },
+  { VERDICT_METRIC_TET_VOLUME, kernel_block<kernels::tet_volume<double, PointNodes> >,
+    soa_block<tet_volume_soa, 4> },
+  { VERDICT_METRIC_TET_CONDITION, kernel_block<kernels::tet_condition<double, PointNodes> >, nullptr },
+  { VERDICT_METRIC_TET_JACOBIAN, kernel_block<kernels::tet_jacobian<double, PointNodes> >, nullptr },
+  { VERDICT_METRIC_TET_SCALED_JACOBIAN, kernel_block<kernels::tet_scaled_jacobian<double, PointNodes> >,
+    soa_block<tet_scaled_jacobian_soa, 4> },
+  { VERDICT_METRIC_TET_MEAN_RATIO, kernel_block<kernels::tet_mean_ratio<double, PointNodes> >,
+    soa_block<tet_mean_ratio_soa, 4> },
+  { VERDICT_METRIC_TET_SHAPE, function_block, kernel_block<kernels::tet_shape<double, PointNodes> > },
+  { VERDICT_METRIC_HEX_JACOBIAN, kernel_block<kernels::hex_jacobian<double, PointNodes> >, nullptr },
+  { VERDICT_METRIC_HEX_SCALED_JACOBIAN, kernel_block<kernels::hex_scaled_jacobian<double, PointNodes> >,
+    soa_block<hex_scaled_jacobian_soa, 8> },
+  { VERDICT_METRIC_HEX_NODAL_JACOBIAN_RATIO, function_block, soa_block<hex_nodal_jacobian_ratio_soa, 8> },
+  { VERDICT_METRIC_HEX_SHEAR, kernel_block<kernels::hex_shear<double, PointNodes> >, nullptr },
+  { VERDICT_METRIC_HEX_SHAPE, kernel_block<kernels::hex_shape<double, PointNodes> >, nullptr }
+};
+
+//! gathers each element into an array of its exact size and calls the
+//! function of verdict_fixed.h for N nodes, which takes no branch on the
+//! node count
+template <int N, double (*Function)( double[][3] )>
+static void fixed_block( const MetricBlock & /*block*/, VerdictIndex num_elements, const double* points,
+                         const VerdictIndex* connectivity, double* results )
+{
+  double coordinates[N][3];
+  const VerdictIndex* element_nodes = connectivity;
+  for ( VerdictIndex e = 0; e < num_elements; e++, element_nodes += N )
+  {
+    gather_element_nodes( points, element_nodes, N, coordinates );
+    results[e] = Function( coordinates );
+  }
+}
+
+//! the loops of the metrics that depend on the element order, for the
+//! node counts of verdict_fixed.h; they give the results of the single
+//! element functions bit for bit
+struct NodeCountSpecialization
+{
+  VerdictMetric metric;
+  int nodes_per_element;
+  BlockLoop evaluate;
+};
+
+static const NodeCountSpecialization node_count_specializations[] =
+{
+  { VERDICT_METRIC_TRI_DISTORTION, 6, fixed_block<6, fixed::tri_distortion<6> > },
+  { VERDICT_METRIC_QUAD_DISTORTION, 4, fixed_block<4, fixed::quad_distortion<4> > },
+  { VERDICT_METRIC_QUAD_DISTORTION, 8, fixed_block<8, fixed::quad_distortion<8> > },
+  { VERDICT_METRIC_TET_VOLUME, 8, fixed_block<8, fixed::tet_volume<8> > },
+  { VERDICT_METRIC_TET_VOLUME, 10, fixed_block<10, fixed::tet_volume<10> > },
+  { VERDICT_METRIC_TET_VOLUME, 14, fixed_block<14, fixed::tet_volume<14> > },
+  { VERDICT_METRIC_TET_VOLUME, 15, fixed_block<15, fixed::tet_volume<15> > },
+  { VERDICT_METRIC_TET_JACOBIAN, 15, fixed_block<15, fixed::tet_jacobian<15> > },
+  { VERDICT_METRIC_TET_DISTORTION, 10, fixed_block<10, fixed::tet_distortion<10> > },
+  { VERDICT_METRIC_WEDGE_JACOBIAN, 6, fixed_block<6, fixed::wedge_jacobian<6> > },
+  { VERDICT_METRIC_WEDGE_JACOBIAN, 21, fixed_block<21, fixed::wedge_jacobian<21> > },
+  { VERDICT_METRIC_KNIFE_VOLUME, 7, fixed_block<7, fixed::knife_volume<7> > },
+  { VERDICT_METRIC_HEX_VOLUME, 8, fixed_block<8, fixed::hex_volume<8> > },
+  { VERDICT_METRIC_HEX_VOLUME, 20, fixed_block<20, fixed::hex_volume<20> > },
+  { VERDICT_METRIC_HEX_VOLUME, 27, fixed_block<27, fixed::hex_volume<27> > },
+  { VERDICT_METRIC_HEX_JACOBIAN, 27, fixed_block<27, fixed::hex_jacobian<27> > },
+  { VERDICT_METRIC_HEX_DISTORTION, 8, fixed_block<8, fixed::hex_distortion<8> > },
+  { VERDICT_METRIC_HEX_DISTORTION, 20, fixed_block<20, fixed::hex_distortion<20> > }
+};
+
+//! the specialized loops of a metric for a node count, or null
+static const MetricSpecialization* find_specialization( const VerdictMetricInfo &info, int nodes_per_element )
+{
+  if ( nodes_per_element != info.num_corners )
+    return nullptr;
+  for ( const MetricSpecialization &specialization : metric_specializations )
+    if ( specialization.metric == info.metric )
+      return &specialization;
+  return nullptr;
+}
+
+//! the loop of a metric at a node count of verdict_fixed.h, or null
+static BlockLoop find_node_count_specialization( VerdictMetric metric, int nodes_per_element )
+{
+  for ( const NodeCountSpecialization &specialization : node_count_specializations )
+    if ( specialization.metric == metric && specialization.nodes_per_element == nodes_per_element )
+      return specialization.evaluate;
+  return nullptr;
+}
+
+static MetricBlock zero_metric_block( int nodes_per_element )
+{
+  MetricBlock block = { nullptr, nullptr, 0., nodes_per_element, zero_block };
+  return block;
+}
+
+MetricBlock resolve_metric_block( VerdictFunction function, int nodes_per_element )
+{
+  if ( !function || nodes_per_element <= 0 || nodes_per_element > VERDICT_MAX_NODES_PER_ELEMENT )
+    return zero_metric_block( nodes_per_element );
+
+  MetricBlock block = { function, nullptr, 0., nodes_per_element, function_block };
+  VerdictMetric metric;
+  if ( find_metric( function, metric ) )
+  {
+    const MetricSpecialization* specialization =
+      find_specialization( metric_registry[metric], nodes_per_element );
+    if ( specialization )
+      block.evaluate = specialization->exact;
+    else if ( BlockLoop loop = find_node_count_specialization( metric, nodes_per_element ) )
+      block.evaluate = loop;
+  }
+  return block;
+}
+
+MetricBlock resolve_metric_block( VerdictMetric metric, int nodes_per_element, double average_size )
+{
+  const VerdictMetricInfo* info = metric_info( metric );
+  if ( !info || nodes_per_element < info->num_corners || nodes_per_element > VERDICT_MAX_NODES_PER_ELEMENT )
+    return zero_metric_block( nodes_per_element );
+
+  MetricBlock block = { info->function, info->sized_function, average_size, nodes_per_element,
+                        info->function ? function_block : sized_function_block };
+  const MetricSpecialization* specialization = find_specialization( *info, nodes_per_element );
+  if ( specialization )
+    block.evaluate = specialization->fast ? specialization->fast : specialization->exact;
+  else if ( BlockLoop loop = find_node_count_specialization( metric, nodes_per_element ) )
+    block.evaluate = loop;
+  return block;
+}
+
+} // namespace verdict
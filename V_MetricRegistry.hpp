@@ -0,0 +1,76 @@
+/*=========================================================================
+
+  Module:    V_MetricRegistry.hpp
+
+  Copyright 2003,2006,2019 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+  Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government retains certain rights in this software.
+
+  See LICENSE for details.
+
+=========================================================================*/
+
+/*
+ *
+ * V_MetricRegistry.hpp contains the loops the mesh functions run over the
+ *                      elements of a block.  A metric and a node count
+ *                      are resolved to a loop once per call; the loops of
+ *                      the metrics that have a kernel in verdict_kernels.h
+ *                      inline it, the others gather each element and call
+ *                      the single element function.
+ *
+ * This file is part of VERDICT
+ *
+ */
+
+#ifndef VERDICT_METRIC_REGISTRY_HPP
+#define VERDICT_METRIC_REGISTRY_HPP
+
+#include "verdict_mesh.h"
+
+namespace VERDICT_NAMESPACE
+{
+
+/*!
+  copies the coordinates of the nodes of one element into a local
+  coordinates array, in the layout expected by the element metrics
+*/
+inline void gather_element_nodes( const double* points,
+                                  const VerdictIndex* element_nodes,
+                                  int num_nodes,
+                                  double coordinates[][3] )
+{
+  for ( int i = 0; i < num_nodes; i++ )
+  {
+    const double* point = points + 3*element_nodes[i];
+    coordinates[i][0] = point[0];
+    coordinates[i][1] = point[1];
+    coordinates[i][2] = point[2];
+  }
+}
+
+//! a metric resolved for the elements of blocks with a fixed node count
+struct MetricBlock
+{
+  VerdictFunction function;
+  VerdictSizedFunction sized_function;
+  double average_size;
+  int nodes_per_element;
+
+  //! the metric of the num_elements elements whose connectivity starts at
+  //! connectivity, nodes_per_element entries each
+  void (*evaluate)( const MetricBlock &block, VerdictIndex num_elements, const double* points,
+                    const VerdictIndex* connectivity, double* results );
+};
+
+//! the loop for function, which gives the results of function bit for bit;
+//! unregistered functions are called for each element
+MetricBlock resolve_metric_block( VerdictFunction function, int nodes_per_element );
+
+//! the fastest loop for a registered metric, with the structure-of-arrays
+//! kernels where there are some; the results are 0 for an unknown metric
+//! or an unsupported node count
+MetricBlock resolve_metric_block( VerdictMetric metric, int nodes_per_element, double average_size );
+
+} // namespace verdict
+
+#endif
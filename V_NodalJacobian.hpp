@@ -0,0 +1,256 @@
+/*=========================================================================
+
+  Module:    V_NodalJacobian.hpp
+
+  Copyright 2003,2006,2019 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+  Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government retains certain rights in this software.
+
+  See LICENSE for details.
+
+=========================================================================*/
+
+/*
+ *
+ * V_NodalJacobian.hpp contains the jacobians of the higher order elements
+ *                     at their nodes.  The gradients of the shape
+ *                     functions at the reference nodes do not depend on
+ *                     the element, so they are tabulated once and the
+ *                     jacobians at all the nodes are one dense product of
+ *                     the coordinates and the table.  The estimates bound
+ *                     them from the jacobians of the linear element of
+ *                     the corners.
+ *
+ * This file is part of VERDICT
+ *
+ */
+
+#ifndef VERDICT_NODAL_JACOBIAN_HPP
+#define VERDICT_NODAL_JACOBIAN_HPP
+
+#include "verdict.h"
+#include "VerdictVector.hpp"
+
+#include <cfloat>
+#include <cmath>
+
+namespace VERDICT_NAMESPACE
+{
+
+//! the gradients of the N shape functions at P reference points
+template <int N, int P = N>
+struct NodalGradients
+{
+  //! evaluates gradients, the element's dhdr/dhds/dhdt function, at points
+  NodalGradients( void (*gradients)( const double rst[3], double dhdr[], double dhds[], double dhdt[] ),
+                  const double points[][3] )
+  {
+    double dhdr[N], dhds[N], dhdt[N];
+    for ( int i = 0; i < P; i++ )
+    {
+      gradients( points[i], dhdr, dhds, dhdt );
+      for ( int j = 0; j < N; j++ )
+      {
+        dh[j][3 * i] = dhdr[j];
+        dh[j][3 * i + 1] = dhds[j];
+        dh[j][3 * i + 2] = dhdt[j];
+      }
+    }
+  }
+
+  //! d(shape function j)/d(r, s, t) at point i is dh[j][3 i .. 3 i + 2]
+  double dh[N][3 * P];
+};
+
+//! the determinants of the jacobians at all the points of gradients
+template <int N, int P>
+inline void nodal_jacobian_determinants( const NodalGradients<N, P> &gradients,
+                                         double coordinates[][3], double determinants[P] )
+{
+  // row a of the jacobian at point i is jacobians[a][3 i .. 3 i + 2], the
+  // (3 x N) coordinates times the (N x 3P) gradients.  The rows are long
+  // contiguous updates that vectorize, and each entry is still summed in
+  // node order.
+  double jacobians[3][3 * P];
+  for ( int a = 0; a < 3; a++ )
+    for ( int k = 0; k < 3 * P; k++ )
+      jacobians[a][k] = 0;
+
+  for ( int j = 0; j < N; j++ )
+    for ( int a = 0; a < 3; a++ )
+    {
+      const double x = coordinates[j][a];
+      for ( int k = 0; k < 3 * P; k++ )
+        jacobians[a][k] += x * gradients.dh[j][k];
+    }
+
+  for ( int i = 0; i < P; i++ )
+    determinants[i] = VerdictVector::Dot( VerdictVector( jacobians[0] + 3 * i ) * VerdictVector( jacobians[1] + 3 * i ),
+                                          VerdictVector( jacobians[2] + 3 * i ) );
+}
+
+//! the determinant of the jacobian at point i of gradients, summed in the order of nodal_jacobian_determinants
+template <int N, int P>
+inline double nodal_jacobian_determinant( const NodalGradients<N, P> &gradients,
+                                          double coordinates[][3], int i )
+{
+  double jacobian[3][3] = { { 0, 0, 0 }, { 0, 0, 0 }, { 0, 0, 0 } };
+  for ( int j = 0; j < N; j++ )
+    for ( int a = 0; a < 3; a++ )
+    {
+      const double x = coordinates[j][a];
+      for ( int c = 0; c < 3; c++ )
+        jacobian[a][c] += x * gradients.dh[j][3 * i + c];
+    }
+  return VerdictVector::Dot( VerdictVector( jacobian[0] ) * VerdictVector( jacobian[1] ),
+                             VerdictVector( jacobian[2] ) );
+}
+
+/*!
+  the linear element of the C corners of NodalGradients<N, P>, for
+  nodal_jacobian_estimate.  The jacobian at point i is that of the element
+  whose other nodes are where the linear element puts them, plus the sum
+  over the other nodes of their offset from there times their gradient.
+*/
+template <int N, int C, int P = N>
+struct NodalJacobianBounds
+{
+  //! linear evaluates the C linear shape functions; points are the N
+  //! reference nodes
+  NodalJacobianBounds( const NodalGradients<N, P> &gradients,
+                       void (*linear)( const double rst[3], double h[] ),
+                       const double points[][3] )
+  {
+    for ( int n = C; n < N; n++ )
+      linear( points[n], position[n - C] );
+
+    // the gradients of the element with its other nodes on the linear one
+    for ( int c = 0; c < C; c++ )
+      for ( int k = 0; k < 3 * P; k++ )
+      {
+        dl[c][k] = gradients.dh[c][k];
+        for ( int n = C; n < N; n++ )
+          dl[c][k] += position[n - C][c] * gradients.dh[n][k];
+      }
+
+    for ( int k = 0; k < 3 * P; k++ )
+    {
+      double offsets = 0, all = 0, corners = 0;
+      for ( int n = 0; n < N; n++ )
+      {
+        all += fabs( gradients.dh[n][k] );
+        if ( n >= C )
+          offsets += fabs( gradients.dh[n][k] );
+      }
+      for ( int c = 0; c < C; c++ )
+        corners += fabs( dl[c][k] );
+      offset_weight[k] = offsets;
+      coordinate_weight[k] = corners > all ? corners : all;
+    }
+  }
+
+  //! the linear shape functions at the higher order nodes
+  double position[N - C][C];
+  //! the gradient of corner c at point i, with the other nodes on the linear
+  //! element, is dl[c][3 i .. 3 i + 2]
+  double dl[C][3 * P];
+  //! the sums over the other nodes, and the larger of the sums over all
+  //! the nodes and over the corners, of the magnitudes of the gradients,
+  //! laid out as dl
+  double offset_weight[3 * P];
+  double coordinate_weight[3 * P];
+};
+
+/*!
+  the smallest jacobian at the points of bounds of the element with its
+  other nodes on the linear one, and bounds on the smallest of
+  nodal_jacobian_determinants.  Adding E to
+  a matrix with columns of lengths a changes its determinant by at most
+  prod( a + |E columns| ) - prod( a ), and the columns of the offsets part
+  are at most the largest offset times offset_weight.  The rounding of
+  both the exact and the linear jacobians is bounded from the largest
+  coordinate.
+*/
+template <int N, int C, int P>
+inline void nodal_jacobian_estimate( const NodalJacobianBounds<N, C, P> &bounds,
+                                     double coordinates[][3], MetricEstimate &estimate )
+{
+  // a coordinate that is not finite makes the sum of the products by 0 NaN
+  double extent = 0, products = 0;
+  for ( int n = 0; n < N; n++ )
+    for ( int a = 0; a < 3; a++ )
+    {
+      const double magnitude = fabs( coordinates[n][a] );
+      extent = magnitude > extent ? magnitude : extent;
+      products += 0 * coordinates[n][a];
+    }
+  if ( products != 0 )
+  {
+    estimate.value = estimate.lower = estimate.upper = NAN;
+    return;
+  }
+
+  // the largest distance of a higher order node from where the linear
+  // element puts it
+  double squared_offset = 0;
+  for ( int n = C; n < N; n++ )
+  {
+    double difference[3] = { coordinates[n][0], coordinates[n][1], coordinates[n][2] };
+    for ( int c = 0; c < C; c++ )
+    {
+      const double weight = bounds.position[n - C][c];
+      difference[0] -= weight * coordinates[c][0];
+      difference[1] -= weight * coordinates[c][1];
+      difference[2] -= weight * coordinates[c][2];
+    }
+    const double square = difference[0] * difference[0] + difference[1] * difference[1] +
+      difference[2] * difference[2];
+    squared_offset = square > squared_offset ? square : squared_offset;
+  }
+  double offset = std::sqrt( squared_offset );
+  offset = offset * ( 1 + 8 * DBL_EPSILON ) + 4 * ( C + 2 ) * DBL_EPSILON * extent;
+
+  double jacobians[3][3 * P];
+  for ( int a = 0; a < 3; a++ )
+    for ( int k = 0; k < 3 * P; k++ )
+      jacobians[a][k] = 0;
+  for ( int c = 0; c < C; c++ )
+    for ( int a = 0; a < 3; a++ )
+    {
+      const double x = coordinates[c][a];
+      for ( int k = 0; k < 3 * P; k++ )
+        jacobians[a][k] += x * bounds.dl[c][k];
+    }
+
+  estimate.value = estimate.lower = estimate.upper = VERDICT_DBL_MAX;
+  for ( int i = 0; i < P; i++ )
+  {
+    const double determinant = VerdictVector::Dot(
+      VerdictVector( jacobians[0] + 3 * i ) * VerdictVector( jacobians[1] + 3 * i ),
+      VerdictVector( jacobians[2] + 3 * i ) );
+
+    double column_error[3], perturbed = 1, product = 1, squares = 0;
+    for ( int j = 0; j < 3; j++ )
+    {
+      column_error[j] = offset * bounds.offset_weight[3 * i + j] * ( 1 + 4 * DBL_EPSILON ) +
+        4 * ( N + 2 ) * DBL_EPSILON * extent * bounds.coordinate_weight[3 * i + j];
+      const double square = jacobians[0][3 * i + j] * jacobians[0][3 * i + j] +
+        jacobians[1][3 * i + j] * jacobians[1][3 * i + j] + jacobians[2][3 * i + j] * jacobians[2][3 * i + j];
+      const double length = sqrt( square );
+      squares += square;
+      perturbed *= length + column_error[j];
+      product *= length;
+    }
+    // the rounding of the determinants is at most a few ulps of the cube
+    // of the frobenius norm
+    const double norm = sqrt( squares ) + column_error[0] + column_error[1] + column_error[2];
+    const double error = ( perturbed - product ) * ( 1 + 8 * DBL_EPSILON ) + 16 * DBL_EPSILON * norm * norm * norm;
+
+    estimate.value = determinant < estimate.value ? determinant : estimate.value;
+    estimate.lower = determinant - error < estimate.lower ? determinant - error : estimate.lower;
+    estimate.upper = determinant + error < estimate.upper ? determinant + error : estimate.upper;
+  }
+}
+
+} // namespace verdict
+
+#endif
@@ -0,0 +1,299 @@
+/*=========================================================================
+
+  Module:    V_Parallel.cpp
+
+  Copyright 2003,2006,2019 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+  Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government retains certain rights in this software.
+
+  See LICENSE for details.
+
+=========================================================================*/
+
+
+/*
+ *
+ * V_Parallel.cpp contains the threading backends of the parallel
+ *                mesh-level functions
+ *
+ * This file is part of VERDICT
+ *
+ */
+
+#include "V_Parallel.hpp"
+
+#if defined(VERDICT_PARALLEL_THREADS)
+# include <atomic>
+# include <condition_variable>
+# include <mutex>
+# include <thread>
+# include <vector>
+#elif defined(VERDICT_PARALLEL_OPENMP)
+# include <omp.h>
+# include <thread>
+#elif defined(VERDICT_PARALLEL_TBB)
+# include <tbb/blocked_range.h>
+# include <tbb/parallel_for.h>
+# include <tbb/task_arena.h>
+# include <tbb/task_group.h>
+#endif
+
+namespace VERDICT_NAMESPACE
+{
+
+int parallel_thread_count( int num_threads )
+{
+  if ( num_threads > 0 )
+  {
+#if defined(VERDICT_PARALLEL_THREADS) || defined(VERDICT_PARALLEL_OPENMP) || defined(VERDICT_PARALLEL_TBB)
+    return num_threads;
+#else
+    return 1;
+#endif
+  }
+
+#if defined(VERDICT_PARALLEL_THREADS)
+  const unsigned int hardware_threads = std::thread::hardware_concurrency();
+  return hardware_threads > 0 ? (int)hardware_threads : 1;
+#elif defined(VERDICT_PARALLEL_OPENMP)
+  return omp_get_max_threads();
+#elif defined(VERDICT_PARALLEL_TBB)
+  return tbb::this_task_arena::max_concurrency();
+#else
+  return 1;
+#endif
+}
+
+#if defined(VERDICT_PARALLEL_THREADS)
+
+/*!
+  the blocks initially assigned to one thread.  The owner and the threads
+  that ran out of blocks of their own all claim blocks from next, so a
+  thread stuck on expensive elements gets helped with the rest of its share.
+*/
+struct alignas(64) BlockQueue
+{
+  std::atomic<VerdictIndex> next;
+  VerdictIndex end;
+};
+
+//! claims and runs blocks, first from the thread's own queue, then from the others
+static void run_blocks( BlockQueue* queues, int num_threads, int thread,
+                        VerdictIndex num_items, VerdictIndex block_size,
+                        BlockFunction work, void* data )
+{
+  for ( int i = 0; i < num_threads; i++ )
+  {
+    BlockQueue &queue = queues[( thread + i ) % num_threads];
+    for ( ;; )
+    {
+      const VerdictIndex block = queue.next.fetch_add( 1, std::memory_order_relaxed );
+      if ( block >= queue.end )
+        break;
+
+      const VerdictIndex begin = block * block_size;
+      const VerdictIndex end = begin + block_size < num_items ? begin + block_size : num_items;
+      work( data, begin, end, thread );
+    }
+  }
+}
+
+//! the arguments of run_blocks shared by the threads of one call
+struct BlockJob
+{
+  BlockQueue* queues;
+  int num_threads;
+  VerdictIndex num_items;
+  VerdictIndex block_size;
+  BlockFunction work;
+  void* data;
+};
+
+/*!
+  worker threads kept between the calls of parallel_for_blocks, so a call
+  does not pay for starting and joining threads and the workers keep their
+  scratch memory.  The pool runs one call at a time; a call made while it
+  is busy, or from within the work of a call, starts threads of its own.
+  The workers are started as calls need them and are left waiting when the
+  program exits.
+*/
+struct WorkerPool
+{
+  std::mutex busy;                  //!< held by the caller whose blocks the workers run
+  std::mutex mutex;
+  std::condition_variable start;    //!< a job was posted
+  std::condition_variable finish;   //!< the workers of the job are done
+  std::vector<std::thread> workers; //!< worker w runs as thread number w + 1
+  BlockJob job;
+  unsigned long long generation;
+  int remaining;
+
+  WorkerPool() : generation( 0 ), remaining( 0 ) {}
+
+  void run_worker( int thread );
+
+  //! runs job on the calling thread and the first job.num_threads - 1 workers
+  void run( const BlockJob &posted );
+};
+
+//! whether the thread is a worker of the pool or runs the blocks of a pool job
+static thread_local bool in_pool_job = false;
+
+void WorkerPool::run_worker( int thread )
+{
+  in_pool_job = true;
+  unsigned long long seen = 0;
+  std::unique_lock<std::mutex> lock( mutex );
+  for ( ;; )
+  {
+    while ( generation == seen )
+      start.wait( lock );
+    seen = generation;
+    // a worker not needed by a job may miss it, but every worker it needs is counted in remaining
+    if ( thread >= job.num_threads )
+      continue;
+
+    const BlockJob current = job;
+    lock.unlock();
+    run_blocks( current.queues, current.num_threads, thread, current.num_items, current.block_size,
+                current.work, current.data );
+    lock.lock();
+    if ( --remaining == 0 )
+      finish.notify_one();
+  }
+}
+
+void WorkerPool::run( const BlockJob &posted )
+{
+  {
+    std::lock_guard<std::mutex> lock( mutex );
+    while ( (int)workers.size() < posted.num_threads - 1 )
+      workers.emplace_back( &WorkerPool::run_worker, this, (int)workers.size() + 1 );
+    job = posted;
+    remaining = posted.num_threads - 1;
+    generation++;
+  }
+  start.notify_all();
+
+  in_pool_job = true;
+  run_blocks( posted.queues, posted.num_threads, 0, posted.num_items, posted.block_size,
+              posted.work, posted.data );
+  in_pool_job = false;
+
+  std::unique_lock<std::mutex> lock( mutex );
+  while ( remaining > 0 )
+    finish.wait( lock );
+}
+
+//! never destroyed, since its workers may still hold scratch memory when the program exits
+static WorkerPool &worker_pool()
+{
+  static WorkerPool* pool = new WorkerPool;
+  return *pool;
+}
+
+#endif
+
+void parallel_for_blocks( VerdictIndex num_items, VerdictIndex block_size, int num_threads,
+                          BlockFunction work, void* data )
+{
+  if ( num_items <= 0 )
+    return;
+  if ( block_size < 1 )
+    block_size = 1;
+
+  const VerdictIndex num_blocks = ( num_items + block_size - 1 ) / block_size;
+  int threads = parallel_thread_count( num_threads );
+
+  // not worth starting threads for a single block
+  if ( num_blocks == 1 || threads == 1 )
+  {
+    for ( VerdictIndex begin = 0; begin < num_items; begin += block_size )
+      work( data, begin, begin + block_size < num_items ? begin + block_size : num_items, 0 );
+    return;
+  }
+
+#if defined(VERDICT_PARALLEL_THREADS)
+  if ( num_blocks < threads )
+    threads = (int)num_blocks;
+
+  std::vector<BlockQueue> queues( threads );
+  for ( int t = 0; t < threads; t++ )
+  {
+    queues[t].next.store( num_blocks * t / threads, std::memory_order_relaxed );
+    queues[t].end = num_blocks * ( t + 1 ) / threads;
+  }
+
+  // the calling thread works too, with the workers of the pool when it is free
+  if ( !in_pool_job )
+  {
+    WorkerPool &pool = worker_pool();
+    std::unique_lock<std::mutex> busy( pool.busy, std::try_to_lock );
+    if ( busy.owns_lock() )
+    {
+      const BlockJob job = { queues.data(), threads, num_items, block_size, work, data };
+      pool.run( job );
+      return;
+    }
+  }
+
+  // the pool is busy with another call, or this call is made from the work of one
+  std::vector<std::thread> workers;
+  workers.reserve( threads - 1 );
+  for ( int t = 1; t < threads; t++ )
+    workers.emplace_back( run_blocks, queues.data(), threads, t, num_items, block_size, work, data );
+  run_blocks( queues.data(), threads, 0, num_items, block_size, work, data );
+  for ( std::thread &worker : workers )
+    worker.join();
+
+#elif defined(VERDICT_PARALLEL_OPENMP)
+#pragma omp parallel for schedule(dynamic, 1) num_threads(threads)
+  for ( VerdictIndex block = 0; block < num_blocks; block++ )
+  {
+    const VerdictIndex begin = block * block_size;
+    const VerdictIndex end = begin + block_size < num_items ? begin + block_size : num_items;
+    work( data, begin, end, omp_get_thread_num() );
+  }
+
+#elif defined(VERDICT_PARALLEL_TBB)
+  // an arena of the requested size keeps the thread indices below threads
+  tbb::task_arena arena( threads );
+  arena.execute( [&]()
+  {
+    tbb::parallel_for( tbb::blocked_range<VerdictIndex>( 0, num_blocks, 1 ),
+                       [&]( const tbb::blocked_range<VerdictIndex> &range )
+    {
+      const int thread = tbb::this_task_arena::current_thread_index();
+      for ( VerdictIndex block = range.begin(); block < range.end(); block++ )
+      {
+        const VerdictIndex begin = block * block_size;
+        const VerdictIndex end = begin + block_size < num_items ? begin + block_size : num_items;
+        work( data, begin, end, thread );
+      }
+    } );
+  } );
+#endif
+}
+
+void parallel_overlap( TaskFunction background, void* background_data,
+                       TaskFunction foreground, void* foreground_data )
+{
+#if defined(VERDICT_PARALLEL_THREADS) || defined(VERDICT_PARALLEL_OPENMP)
+  // a plain thread rather than an OpenMP task, so the parallel loops of
+  // foreground are not nested in a parallel region
+  std::thread worker( background, background_data );
+  foreground( foreground_data );
+  worker.join();
+
+#elif defined(VERDICT_PARALLEL_TBB)
+  tbb::task_group group;
+  group.run( [=]() { background( background_data ); } );
+  foreground( foreground_data );
+  group.wait();
+
+#else
+  background( background_data );
+  foreground( foreground_data );
+#endif
+}
+
+} // namespace verdict
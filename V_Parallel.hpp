@@ -0,0 +1,61 @@
+/*=========================================================================
+
+  Module:    V_Parallel.hpp
+
+  Copyright 2003,2006,2019 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+  Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government retains certain rights in this software.
+
+  See LICENSE for details.
+
+=========================================================================*/
+
+/*
+ *
+ * V_Parallel.hpp contains the loop over blocks of elements used by the
+ *                parallel mesh-level functions.  The threading backend
+ *                (std::thread, OpenMP or TBB) is chosen when verdict is
+ *                configured; all of them balance the load dynamically,
+ *                since the cost per element varies a lot between element
+ *                types and metrics.
+ *
+ * This file is part of VERDICT
+ *
+ */
+
+#ifndef VERDICT_PARALLEL_HPP
+#define VERDICT_PARALLEL_HPP
+
+#include "verdict_mesh.h"
+
+namespace VERDICT_NAMESPACE
+{
+
+//! work on the items [begin, end) from thread number thread
+typedef void (*BlockFunction)( void* data, VerdictIndex begin, VerdictIndex end, int thread );
+
+//! the number of threads used for a requested count; 0 requests the backend default
+int parallel_thread_count( int num_threads );
+
+/*!
+  calls work on consecutive blocks of block_size items covering
+  [0, num_items).  The blocks run concurrently and in no particular order,
+  and the thread argument is below parallel_thread_count( num_threads ), so
+  it can index per-thread partial results.
+*/
+void parallel_for_blocks( VerdictIndex num_items, VerdictIndex block_size, int num_threads,
+                         BlockFunction work, void* data );
+
+//! work that is not split into blocks
+typedef void (*TaskFunction)( void* data );
+
+/*!
+  runs background on another thread while the calling thread runs
+  foreground, which may itself call parallel_for_blocks, and returns once
+  both are done.  Without a threading backend background runs first.
+*/
+void parallel_overlap( TaskFunction background, void* background_data,
+                       TaskFunction foreground, void* foreground_data );
+
+} // namespace verdict
+
+#endif
@@ -22,6 +22,8 @@
 #include "verdict.h"
 #include "VerdictVector.hpp"
 #include "verdict_defines.hpp"
+#include "V_Instrumentation.hpp"
+#include "V_SimplexInvariants.hpp"
 #include <memory.h>
 #include <vector>
 #include <array>
@@ -65,16 +67,10 @@ double largest_pyramid_edge( double coordinates[][3] );
           
 */
 
-double pyramid_equiangle_skew( int num_nodes, double coordinates[][3] )
+//! the largest skew of the faces of make_pyramid_faces
+static double equiangle_skew( double base[][3], double tri1[][3], double tri2[][3],
+                              double tri3[][3], double tri4[][3] )
 {
-  double base[4][3];
-  double tri1[3][3];
-  double tri2[3][3];
-  double tri3[3][3];
-  double tri4[3][3];
-  make_pyramid_faces(coordinates, base,tri1,tri2,tri3,tri4);
-
-
   double quad_skew=quad_equiangle_skew( 4, base );
   double tri1_skew=tri_equiangle_skew(3,tri1);
   double tri2_skew=tri_equiangle_skew(3,tri2);
@@ -90,6 +86,19 @@ double pyramid_equiangle_skew( int num_nodes, double coordinates[][3] )
   return max_skew;
 }
 
+double pyramid_equiangle_skew( int num_nodes, double coordinates[][3] )
+{
+  VERDICT_INSTRUMENT_METRIC( pyramid_equiangle_skew );
+  double base[4][3];
+  double tri1[3][3];
+  double tri2[3][3];
+  double tri3[3][3];
+  double tri4[3][3];
+  make_pyramid_faces(coordinates, base,tri1,tri2,tri3,tri4);
+
+  return equiangle_skew( base, tri1, tri2, tri3, tri4 );
+}
+
 /*!
   the volume of a pyramid
 
@@ -99,6 +108,7 @@ double pyramid_equiangle_skew( int num_nodes, double coordinates[][3] )
 
 double pyramid_volume( int num_nodes, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( pyramid_volume );
     
   double center_coords[3];
   //calculate the center of the quads
@@ -176,30 +186,19 @@ double pyramid_volume( int num_nodes, double coordinates[][3] )
     
 }
 
-double pyramid_jacobian( int num_nodes, double coordinates[][3] )
+//! the smallest of the jacobians of the four tets
+static double min_jacobian( double j1, double j2, double j3, double j4 )
 {
-  // break the pyramid into four tets return the minimum jacobian of the two tets
-  double tet1_coords[4][3];
-  double tet2_coords[4][3];
-  double tet3_coords[4][3];
-  double tet4_coords[4][3];
-
-  make_pyramid_tets(coordinates, tet1_coords, tet2_coords, tet3_coords, tet4_coords);
-
-  double j1 = tet_jacobian(4, tet1_coords);
-  double j2 = tet_jacobian(4, tet2_coords);
-  double j3 = tet_jacobian(4, tet3_coords);
-  double j4 = tet_jacobian(4, tet4_coords);
-
   double p1 = j1 < j2 ? j1 : j2;
   double p2 = j3 < j4 ? j3 : j4;
 
   return p1 < p2 ? p1 : p2;
 }
 
-double pyramid_scaled_jacobian( int num_nodes, double coordinates[][3] )
+double pyramid_jacobian( int num_nodes, double coordinates[][3] )
 {
-  // break the pyramid into four tets return the minimum scaled jacobian of the tets
+  VERDICT_INSTRUMENT_METRIC( pyramid_jacobian );
+  // break the pyramid into four tets return the minimum jacobian of the two tets
   double tet1_coords[4][3];
   double tet2_coords[4][3];
   double tet3_coords[4][3];
@@ -207,11 +206,24 @@ double pyramid_scaled_jacobian( int num_nodes, double coordinates[][3] )
 
   make_pyramid_tets(coordinates, tet1_coords, tet2_coords, tet3_coords, tet4_coords);
 
+  return min_jacobian( tet_jacobian(4, tet1_coords), tet_jacobian(4, tet2_coords),
+                       tet_jacobian(4, tet3_coords), tet_jacobian(4, tet4_coords) );
+}
+
+//! the tets of make_pyramid_tets
+static void pyramid_tets( double coordinates[][3], TetInvariants tets[4] )
+{
+  double tet_coords[4][4][3];
+  make_pyramid_tets(coordinates, tet_coords[0], tet_coords[1], tet_coords[2], tet_coords[3]);
+  for ( int t = 0; t < 4; t++ )
+    tet_invariants( tet_coords[t], tets[t] );
+}
+
+static double scaled_jacobian( const TetInvariants tets[4] )
+{
   std::array<double,4> scaled_jacob;
-  scaled_jacob[0] = tet_scaled_jacobian(4, tet1_coords);
-  scaled_jacob[1] = tet_scaled_jacobian(4, tet2_coords);
-  scaled_jacob[2] = tet_scaled_jacobian(4, tet3_coords);
-  scaled_jacob[3] = tet_scaled_jacobian(4, tet4_coords);
+  for ( int t = 0; t < 4; t++ )
+    scaled_jacob[t] = tet_scaled_jacobian( tets[t] );
 
   auto iter = std::min_element(scaled_jacob.begin(), scaled_jacob.end());
 
@@ -224,18 +236,17 @@ double pyramid_scaled_jacobian( int num_nodes, double coordinates[][3] )
   return min_jac < 1.0 ? min_jac : 1.0 - (min_jac - 1.0);
 }
 
-double pyramid_shape( int num_nodes, double coordinates[][3] )
+double pyramid_scaled_jacobian( int num_nodes, double coordinates[][3] )
 {
-  // ideally there will be four equilateral triangles and one square.
-  // Test each face
-  double base[4][3];
-  double tri1[3][3];
-  double tri2[3][3];
-  double tri3[3][3];
-  double tri4[3][3];
-
-  make_pyramid_faces(coordinates, base, tri1, tri2, tri3, tri4);
+  VERDICT_INSTRUMENT_METRIC( pyramid_scaled_jacobian );
+  // break the pyramid into four tets return the minimum scaled jacobian of the tets
+  TetInvariants tets[4];
+  pyramid_tets( coordinates, tets );
+  return scaled_jacobian( tets );
+}
 
+static double shape( int num_nodes, double coordinates[][3], double base[][3] )
+{
   double s1 = quad_shape(4, base);
 
   if (s1 == 0.0)
@@ -258,6 +269,65 @@ double pyramid_shape( int num_nodes, double coordinates[][3] )
   return shape;
 }
 
+double pyramid_shape( int num_nodes, double coordinates[][3] )
+{
+  VERDICT_INSTRUMENT_METRIC( pyramid_shape );
+  // ideally there will be four equilateral triangles and one square.
+  // Test each face
+  double base[4][3];
+  double tri1[3][3];
+  double tri2[3][3];
+  double tri3[3][3];
+  double tri4[3][3];
+
+  make_pyramid_faces(coordinates, base, tri1, tri2, tri3, tri4);
+
+  return shape( num_nodes, coordinates, base );
+}
+
+/*!
+  several metrics of a pyramid in one pass
+
+  Every metric goes through the same helper as its single metric function,
+  so the results are identical, but the four tets and the five faces the
+  pyramid is split into are only formed once.
+*/
+void pyramid_quality( int num_nodes, double coordinates[][3],
+                      unsigned int metrics, PyramidQuality &quality )
+{
+  VERDICT_INSTRUMENT_METRIC( pyramid_quality );
+
+  if ( metrics & PYRAMID_VOLUME )
+    quality.volume = pyramid_volume( num_nodes, coordinates );
+
+  if ( metrics & ( PYRAMID_JACOBIAN | PYRAMID_SCALED_JACOBIAN ) )
+  {
+    TetInvariants tets[4];
+    pyramid_tets( coordinates, tets );
+    // the jacobian of the invariants is the one tet_jacobian computes
+    if ( metrics & PYRAMID_JACOBIAN )
+      quality.jacobian = min_jacobian( tets[0].jacobian, tets[1].jacobian,
+                                       tets[2].jacobian, tets[3].jacobian );
+    if ( metrics & PYRAMID_SCALED_JACOBIAN )
+      quality.scaled_jacobian = scaled_jacobian( tets );
+  }
+
+  if ( metrics & ( PYRAMID_SHAPE | PYRAMID_EQUIANGLE_SKEW ) )
+  {
+    double base[4][3];
+    double tri1[3][3];
+    double tri2[3][3];
+    double tri3[3][3];
+    double tri4[3][3];
+    make_pyramid_faces(coordinates, base, tri1, tri2, tri3, tri4);
+
+    if ( metrics & PYRAMID_SHAPE )
+      quality.shape = shape( num_nodes, coordinates, base );
+    if ( metrics & PYRAMID_EQUIANGLE_SKEW )
+      quality.equiangle_skew = equiangle_skew( base, tri1, tri2, tri3, tri4 );
+  }
+}
+
 void make_pyramid_tets(double coordinates[][3], double tet1_coords[][3], double tet2_coords[][3],
                                                   double tet3_coords[][3], double tet4_coords[][3])
 {
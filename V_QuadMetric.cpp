@@ -20,12 +20,16 @@
 
 
 #include "verdict.h"
+#include "verdict_fixed.h"
 #include "VerdictVector.hpp"
+#include "V_SizeMetric.hpp"
 #include "verdict_defines.hpp"
 #include "V_GaussIntegration.hpp"
+#include "V_Instrumentation.hpp"
 #include <memory.h>
 #include <stddef.h>
 #include <algorithm>
+#include <type_traits>
 
 namespace VERDICT_NAMESPACE
 {
@@ -61,7 +65,10 @@ static VerdictBoolean is_collapsed_quad ( double coordinates[][3] )
   if( coordinates[3][0] == coordinates[2][0] &&
       coordinates[3][1] == coordinates[2][1] &&
       coordinates[3][2] == coordinates[2][2] )
+  {
+    VERDICT_COUNT_EVENT( "quad: collapsed to a triangle" );
     return VERDICT_TRUE;
+  }
   
   else
     return VERDICT_FALSE;
@@ -397,6 +404,7 @@ void quad_minimum_maximum_angle( double min_max_angles[2], double coordinates[][
 */
 double quad_edge_ratio( int /*num_nodes*/, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( quad_edge_ratio );
   VerdictVector edges[4];
   make_quad_edges( edges, coordinates );
 
@@ -448,6 +456,7 @@ double quad_edge_ratio( int /*num_nodes*/, double coordinates[][3] )
 */
 double quad_max_edge_ratio( int /*num_nodes*/, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( quad_max_edge_ratio );
   VerdictVector quad_nodes[4];
   quad_nodes[0].set( coordinates[0][0], coordinates[0][1], coordinates[0][2] );
   quad_nodes[1].set( coordinates[1][0], coordinates[1][1], coordinates[1][2] );
@@ -480,6 +489,7 @@ double quad_max_edge_ratio( int /*num_nodes*/, double coordinates[][3] )
 */
 double quad_aspect_ratio( int /*num_nodes*/, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( quad_aspect_ratio );
 
   VerdictVector edges[4];
   make_quad_edges( edges, coordinates );
@@ -517,6 +527,7 @@ double quad_aspect_ratio( int /*num_nodes*/, double coordinates[][3] )
 */
 double quad_radius_ratio( int /*num_nodes*/, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( quad_radius_ratio );
   VerdictVector edges[4];
   make_quad_edges( edges, coordinates );
 
@@ -575,6 +586,7 @@ double quad_radius_ratio( int /*num_nodes*/, double coordinates[][3] )
 */
 double quad_med_aspect_frobenius( int /*num_nodes*/, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( quad_med_aspect_frobenius );
 
   VerdictVector edges[4];
   make_quad_edges( edges, coordinates );
@@ -621,6 +633,7 @@ double quad_med_aspect_frobenius( int /*num_nodes*/, double coordinates[][3] )
 */
 double quad_max_aspect_frobenius( int /*num_nodes*/, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( quad_max_aspect_frobenius );
 
   VerdictVector edges[4];
   make_quad_edges( edges, coordinates );
@@ -671,6 +684,7 @@ double quad_max_aspect_frobenius( int /*num_nodes*/, double coordinates[][3] )
 */
 double quad_skew( int /*num_nodes*/, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( quad_skew );
   VerdictVector node_pos[4];
   for(int i = 0; i < 4; i++ )
     node_pos[i].set(coordinates[i][0], coordinates[i][1], coordinates[i][2]);
@@ -696,6 +710,7 @@ double quad_skew( int /*num_nodes*/, double coordinates[][3] )
 */
 double quad_taper( int /*num_nodes*/, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( quad_taper );
   VerdictVector node_pos[4];
   for(int i = 0; i < 4; i++ )
     node_pos[i].set(coordinates[i][0], coordinates[i][1], coordinates[i][2]);
@@ -728,6 +743,7 @@ double quad_taper( int /*num_nodes*/, double coordinates[][3] )
 */
 double quad_warpage( int /*num_nodes*/, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( quad_warpage );
 
   VerdictVector edges[4];
   make_quad_edges( edges, coordinates );
@@ -761,6 +777,7 @@ double quad_warpage( int /*num_nodes*/, double coordinates[][3] )
 */
 double quad_area( int /*num_nodes*/, double coordinates[][3] )
 {    
+  VERDICT_INSTRUMENT_METRIC( quad_area );
 
   double corner_areas[4];
   signed_corner_areas( corner_areas, coordinates );
@@ -780,6 +797,7 @@ double quad_area( int /*num_nodes*/, double coordinates[][3] )
 */
 double quad_stretch( int /*num_nodes*/, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( quad_stretch );
   VerdictVector edges[4], temp;
   make_quad_edges( edges, coordinates );
 
@@ -823,6 +841,7 @@ double quad_stretch( int /*num_nodes*/, double coordinates[][3] )
 */
 double quad_maximum_angle( int /*num_nodes*/, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( quad_maximum_angle );
 
   // if this is a collapsed quad, just pass it on to 
   // the tri_largest_angle routine
@@ -904,6 +923,7 @@ double quad_maximum_angle( int /*num_nodes*/, double coordinates[][3] )
 */
 double quad_minimum_angle( int /*num_nodes*/, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( quad_minimum_angle );
   // if this quad is a collapsed quad, then just
   // send it to the tri_smallest_angle routine 
   if ( is_collapsed_quad(coordinates) == VERDICT_TRUE )
@@ -968,6 +988,7 @@ double quad_minimum_angle( int /*num_nodes*/, double coordinates[][3] )
 }
 double quad_equiangle_skew( int /*num_nodes*/, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( quad_equiangle_skew );
   double min_max_angle[2];
 
 
@@ -989,6 +1010,7 @@ double quad_equiangle_skew( int /*num_nodes*/, double coordinates[][3] )
 */
 double quad_oddy( int /*num_nodes*/, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( quad_oddy );
   
   double max_oddy = 0.;
   
@@ -1032,6 +1054,7 @@ double quad_oddy( int /*num_nodes*/, double coordinates[][3] )
 */
 double quad_condition( int /*num_nodes*/, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( quad_condition );
   if ( is_collapsed_quad( coordinates ) == VERDICT_TRUE ) 
     return tri_condition(3,coordinates);
 
@@ -1075,6 +1098,7 @@ double quad_condition( int /*num_nodes*/, double coordinates[][3] )
 */
 double quad_jacobian( int /*num_nodes*/, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( quad_jacobian );
    
   if ( is_collapsed_quad( coordinates ) == VERDICT_TRUE )
     return (double)(tri_area(3, coordinates) * 2.0);
@@ -1098,6 +1122,7 @@ double quad_jacobian( int /*num_nodes*/, double coordinates[][3] )
 */
 double quad_scaled_jacobian( int /*num_nodes*/, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( quad_scaled_jacobian );
   if ( is_collapsed_quad( coordinates ) == VERDICT_TRUE ) 
     return tri_scaled_jacobian(3, coordinates);
  
@@ -1145,6 +1170,7 @@ double quad_scaled_jacobian( int /*num_nodes*/, double coordinates[][3] )
 */
 double quad_shear( int /*num_nodes*/, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( quad_shear );
   double scaled_jacobian = quad_scaled_jacobian( 4, coordinates );
 
   if( scaled_jacobian <= VERDICT_DBL_MIN )
@@ -1160,6 +1186,7 @@ double quad_shear( int /*num_nodes*/, double coordinates[][3] )
 */
 double quad_shape( int /*num_nodes*/, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( quad_shape );
 
   double corner_areas[4], min_shape = VERDICT_DBL_MAX, shape; 
   signed_corner_areas( corner_areas, coordinates );
@@ -1203,25 +1230,26 @@ double quad_shape( int /*num_nodes*/, double coordinates[][3] )
 }
 
 
-/*!
-  the relative size of a quad
+double quad_size_measure( double coordinates[][3] )
+{
+  return quad_area (4, coordinates); 
+}
 
-  Min( J, 1/J ), where J is determinant of weighted Jacobian matrix
-*/
-double quad_relative_size_squared( int /*num_nodes*/, double coordinates[][3], double average_quad_area )
+double quad_size_weight( double average_quad_area )
 {
- 
-  double the_quad_area = quad_area (4, coordinates); 
-  double rel_size = 0;
-  
   double w11,w21,w12,w22;
   quad_get_weight(w11,w21,w12,w22, average_quad_area);
-  double avg_area = determinant(w11,w21,w12,w22);
+  return determinant(w11,w21,w12,w22);
+}
+
+double quad_relative_size( double the_quad_area, double avg_area )
+{
+  double rel_size = 0;
   
   if ( avg_area > VERDICT_DBL_MIN ) 
   {
     
-    w11 = the_quad_area / avg_area;
+    double w11 = the_quad_area / avg_area;
       
     if ( w11 > VERDICT_DBL_MIN )
     {
@@ -1236,6 +1264,17 @@ double quad_relative_size_squared( int /*num_nodes*/, double coordinates[][3], d
 
 }
 
+/*!
+  the relative size of a quad
+
+  Min( J, 1/J ), where J is determinant of weighted Jacobian matrix
+*/
+double quad_relative_size_squared( int /*num_nodes*/, double coordinates[][3], double average_quad_area )
+{
+  VERDICT_INSTRUMENT_METRIC( quad_relative_size_squared );
+  return quad_relative_size( quad_size_measure( coordinates ), quad_size_weight( average_quad_area ) );
+}
+
 /*!
   the relative shape and size of a quad
 
@@ -1243,6 +1282,7 @@ double quad_relative_size_squared( int /*num_nodes*/, double coordinates[][3], d
 */
 double quad_shape_and_size( int num_nodes, double coordinates[][3], double average_quad_area )
 {
+  VERDICT_INSTRUMENT_METRIC( quad_shape_and_size );
   double shape, size;
   size = quad_relative_size_squared( num_nodes, coordinates, average_quad_area );
   shape = quad_shape( num_nodes, coordinates );
@@ -1262,6 +1302,7 @@ double quad_shape_and_size( int num_nodes, double coordinates[][3], double avera
 */
 double quad_shear_and_size( int num_nodes, double coordinates[][3], double average_quad_area )
 {
+  VERDICT_INSTRUMENT_METRIC( quad_shear_and_size );
   double shear, size;
   shear = quad_shear( num_nodes, coordinates );
   size = quad_relative_size_squared( num_nodes, coordinates, average_quad_area );
@@ -1275,9 +1316,14 @@ double quad_shear_and_size( int num_nodes, double coordinates[][3], double avera
 }
 
 /*!
-  the distortion of a quad
+  the distortion of a quad with num_nodes nodes over number_of_gauss_points
+  squared integration points.  The counts are either ints or, for the
+  element orders known when compiling, std::integral_constant, which fixes
+  the length of the loops over the nodes.
 */
-double quad_distortion( int num_nodes, double coordinates[][3] )
+template <class NodeCount, class GaussCount>
+static double quad_distortion_with( NodeCount num_nodes, GaussCount number_of_gauss_points,
+                                    double coordinates[][3] )
 {
   // To calculate distortion for linear and 2nd order quads
   // distortion = {min(|J|)/actual area}*{parent area}
@@ -1290,19 +1336,7 @@ double quad_distortion( int num_nodes, double coordinates[][3] )
   VerdictVector  aa, bb, cc,normal_at_point, xin;
   
   
-  //use 2x2 gauss points for linear quads and 3x3 for 2nd order quads
-  int number_of_gauss_points = 0;
-  if ( num_nodes == 4 )
-  { //2x2 quadrature rule
-    number_of_gauss_points = 2;
-  }
-  else if ( num_nodes == 8 )
-  { //3x3 quadrature rule
-    number_of_gauss_points = 3;
-  }
-  
-  
-  int total_number_of_gauss_points = number_of_gauss_points*number_of_gauss_points;
+  const int total_number_of_gauss_points = number_of_gauss_points*number_of_gauss_points;
   
   VerdictVector face_normal = quad_normal( coordinates );
   
@@ -1334,16 +1368,14 @@ double quad_distortion( int num_nodes, double coordinates[][3] )
   }
   else
   {
-    double shape_function[maxTotalNumberGaussPoints][maxNumberNodes];
-    double dndy1[maxTotalNumberGaussPoints][maxNumberNodes];
-    double dndy2[maxTotalNumberGaussPoints][maxNumberNodes];
-    double weight[maxTotalNumberGaussPoints];
-    
-    //create an object of GaussIntegration
-    GaussIntegration gint;
-    gint.initialize(number_of_gauss_points,num_nodes );
-    gint.calculate_shape_function_2d_quad();
-    gint.get_shape_func(shape_function[0], dndy1[0], dndy2[0], weight);
+    // the shape function tables of the rule, computed once and shared;
+    // the node counts without a rule compute theirs into scratch memory
+    ScratchFrame scratch;
+    const GaussTables &tables = gauss_tables( GAUSS_QUAD, number_of_gauss_points, num_nodes, scratch );
+    const double (*shape_function)[maxNumberNodes] = tables.shapeFunction;
+    const double (*dndy1)[maxNumberNodes] = tables.dndy1GaussPts;
+    const double (*dndy2)[maxNumberNodes] = tables.dndy2GaussPts;
+    const double* weight = tables.totalGaussWeight;
     
     // calculate element area
     int ife,ja;
@@ -1364,10 +1396,8 @@ double quad_distortion( int num_nodes, double coordinates[][3] )
     }
     
     
-    double dndy1_at_node[maxNumberNodes][maxNumberNodes];
-    double dndy2_at_node[maxNumberNodes][maxNumberNodes];
-    
-    gint.calculate_derivative_at_nodes( dndy1_at_node,  dndy2_at_node);
+    const double (*dndy1_at_node)[maxNumberNodes] = tables.dndy1AtNodes;
+    const double (*dndy2_at_node)[maxNumberNodes] = tables.dndy2AtNodes;
     
     VerdictVector normal_at_nodes[9];
     
@@ -1488,4 +1518,38 @@ double quad_distortion( int num_nodes, double coordinates[][3] )
   return (double)distortion;
 }
 
+namespace fixed
+{
+
+//! the distortion of a linear quad, with 2x2 gauss points
+template <>
+double quad_distortion<4>( double coordinates[][3] )
+{
+  return quad_distortion_with( std::integral_constant<int, 4>(), std::integral_constant<int, 2>(), coordinates );
+}
+
+//! the distortion of a quadratic quad, with 3x3 gauss points
+template <>
+double quad_distortion<8>( double coordinates[][3] )
+{
+  return quad_distortion_with( std::integral_constant<int, 8>(), std::integral_constant<int, 3>(), coordinates );
+}
+
+} // namespace fixed
+
+/*!
+  the distortion of a quad
+*/
+double quad_distortion( int num_nodes, double coordinates[][3] )
+{
+  VERDICT_INSTRUMENT_METRIC( quad_distortion );
+  //use 2x2 gauss points for linear quads and 3x3 for 2nd order quads
+  if ( num_nodes == 4 )
+    return fixed::quad_distortion<4>( coordinates );
+  if ( num_nodes == 8 )
+    return fixed::quad_distortion<8>( coordinates );
+  // other node counts have no integration rule
+  return quad_distortion_with( num_nodes, 0, coordinates );
+}
+
 } // namespace verdict
@@ -0,0 +1,157 @@
+/*=========================================================================
+
+  Module:    V_ScratchArena.cpp
+
+  Copyright 2003,2006,2019 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+  Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government retains certain rights in this software.
+
+  See LICENSE for details.
+
+=========================================================================*/
+
+
+/*
+ *
+ * V_ScratchArena.cpp contains the arenas of scratch memory and the pool
+ *                    the threads take them from
+ *
+ * This file is part of VERDICT
+ *
+ */
+
+#include "V_ScratchArena.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <stdint.h>
+
+namespace VERDICT_NAMESPACE
+{
+
+//! the smallest chunk, which holds the buffers of a block loop
+static const size_t scratch_chunk_size = 64 * 1024;
+
+//! the bytes of the chunks of all arenas
+static std::atomic<unsigned long long> scratch_bytes( 0 );
+
+ScratchArena::ScratchArena()
+  : current( 0 ), used( 0 )
+{
+}
+
+ScratchArena::~ScratchArena()
+{
+  free_chunks();
+}
+
+void* ScratchArena::take( size_t bytes )
+{
+  bytes = ( bytes + scratch_alignment - 1 ) / scratch_alignment * scratch_alignment;
+
+  // the chunks past the top are free
+  for ( ; current < chunks.size(); current++, used = 0 )
+    if ( used + bytes <= chunks[current].size )
+    {
+      void* memory = chunks[current].memory + used;
+      used += bytes;
+      return memory;
+    }
+
+  // each chunk is at least as large as all the ones before
+  size_t size = chunks.empty() ? scratch_chunk_size : 2 * chunks.back().size;
+  while ( size < bytes )
+    size *= 2;
+  Chunk chunk;
+  chunk.allocation = ::operator new( size + scratch_alignment - 1 );
+  const uintptr_t address = reinterpret_cast<uintptr_t>( chunk.allocation );
+  chunk.memory = reinterpret_cast<char*>( ( address + scratch_alignment - 1 ) / scratch_alignment *
+                                          scratch_alignment );
+  chunk.size = size;
+  chunks.push_back( chunk );
+  scratch_bytes.fetch_add( size, std::memory_order_relaxed );
+
+  current = chunks.size() - 1;
+  used = bytes;
+  return chunk.memory;
+}
+
+void ScratchArena::free_chunks()
+{
+  for ( size_t c = 0; c < chunks.size(); c++ )
+  {
+    scratch_bytes.fetch_sub( chunks[c].size, std::memory_order_relaxed );
+    ::operator delete( chunks[c].allocation );
+  }
+  chunks.clear();
+  current = used = 0;
+}
+
+//! the arenas of the threads that exited
+struct ScratchPool
+{
+  std::mutex mutex;
+  std::vector<ScratchArena*> arenas;
+};
+
+//! never destroyed, since threads may exit after the static destructors ran
+static ScratchPool &scratch_pool()
+{
+  static ScratchPool* pool = new ScratchPool();
+  return *pool;
+}
+
+//! the arena of a thread, returned to the pool when the thread exits
+struct ThreadArena
+{
+  ScratchArena* arena;
+
+  ~ThreadArena()
+  {
+    if ( !arena )
+      return;
+    ScratchPool &pool = scratch_pool();
+    std::lock_guard<std::mutex> lock( pool.mutex );
+    pool.arenas.push_back( arena );
+  }
+};
+
+static thread_local ThreadArena thread_arena = { nullptr };
+
+ScratchArena& thread_scratch_arena()
+{
+  if ( !thread_arena.arena )
+  {
+    ScratchPool &pool = scratch_pool();
+    std::lock_guard<std::mutex> lock( pool.mutex );
+    if ( pool.arenas.empty() )
+      thread_arena.arena = new ScratchArena();
+    else
+    {
+      thread_arena.arena = pool.arenas.back();
+      pool.arenas.pop_back();
+    }
+  }
+  return *thread_arena.arena;
+}
+
+unsigned long long scratch_memory_size()
+{
+  return scratch_bytes.load( std::memory_order_relaxed );
+}
+
+unsigned long long release_scratch_memory()
+{
+  const unsigned long long before = scratch_memory_size();
+  if ( thread_arena.arena )
+    thread_arena.arena->free_chunks();
+
+  ScratchPool &pool = scratch_pool();
+  std::lock_guard<std::mutex> lock( pool.mutex );
+  for ( size_t a = 0; a < pool.arenas.size(); a++ )
+    delete pool.arenas[a];
+  pool.arenas.clear();
+  const unsigned long long after = scratch_memory_size();
+  return before > after ? before - after : 0;
+}
+
+} // namespace verdict
@@ -0,0 +1,143 @@
+/*=========================================================================
+
+  Module:    V_ScratchArena.hpp
+
+  Copyright 2003,2006,2019 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+  Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government retains certain rights in this software.
+
+  See LICENSE for details.
+
+=========================================================================*/
+
+/*
+ *
+ * V_ScratchArena.hpp contains the scratch memory of the metrics and the
+ *                    block loops whose temporaries are too large for the
+ *                    stacks of worker threads.  Each thread owns an arena
+ *                    of cache-aligned chunks, taken from a pool the first
+ *                    time it needs one and returned when it exits, so the
+ *                    chunks are allocated once and reused by every element
+ *                    and every parallel call after it.
+ *
+ * This file is part of VERDICT
+ *
+ */
+
+#ifndef VERDICT_SCRATCH_ARENA_HPP
+#define VERDICT_SCRATCH_ARENA_HPP
+
+#include "verdict_mesh.h"
+
+#include <new>
+#include <stddef.h>
+#include <type_traits>
+#include <vector>
+
+namespace VERDICT_NAMESPACE
+{
+
+//! the alignment of everything taken from an arena
+static const size_t scratch_alignment = 64;
+
+/*!
+  a stack of buffers: take hands out memory after the last buffer taken,
+  and release gives back everything taken since a mark.  The chunks are
+  kept until free_chunks, so an arena stops allocating once it has grown
+  to the largest stack of buffers its thread needs.
+*/
+class ScratchArena
+{
+public:
+  //! the position of the top of the stack
+  struct Mark
+  {
+    size_t chunk;
+    size_t used;
+  };
+
+  ScratchArena();
+  ~ScratchArena();
+
+  //! at least bytes, aligned to scratch_alignment, until the release of an
+  //! earlier mark
+  void* take( size_t bytes );
+
+  Mark mark() const
+  {
+    Mark top = { current, used };
+    return top;
+  }
+
+  void release( const Mark &top )
+  {
+    current = top.chunk;
+    used = top.used;
+  }
+
+  //! gives the chunks back to the system; nothing may be taken
+  void free_chunks();
+
+private:
+  ScratchArena( const ScratchArena& );
+  ScratchArena& operator=( const ScratchArena& );
+
+  struct Chunk
+  {
+    void* allocation;
+    char* memory;
+    size_t size;
+  };
+  std::vector<Chunk> chunks;
+  size_t current;
+  size_t used;
+};
+
+//! the arena of the calling thread
+ScratchArena& thread_scratch_arena();
+
+/*!
+  the buffers of one scope.  The arena of the thread is only looked up
+  when something is taken, so a frame costs nothing on the paths that do
+  not need scratch memory, and everything taken is released with the frame.
+*/
+class ScratchFrame
+{
+public:
+  ScratchFrame() : arena( nullptr ) {}
+  ~ScratchFrame()
+  {
+    if ( arena )
+      arena->release( top );
+  }
+
+  //! count values of T, uninitialized
+  template <class T>
+  T* take( size_t count )
+  {
+    static_assert( std::is_trivially_destructible<T>::value, "scratch buffers are never destroyed" );
+    if ( !arena )
+    {
+      arena = &thread_scratch_arena();
+      top = arena->mark();
+    }
+    return static_cast<T*>( arena->take( count * sizeof( T ) ) );
+  }
+
+  //! one value-initialized T
+  template <class T>
+  T* create()
+  {
+    return new ( take<T>( 1 ) ) T();
+  }
+
+private:
+  ScratchFrame( const ScratchFrame& );
+  ScratchFrame& operator=( const ScratchFrame& );
+
+  ScratchArena* arena;
+  ScratchArena::Mark top;
+};
+
+} // namespace verdict
+
+#endif
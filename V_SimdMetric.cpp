@@ -0,0 +1,537 @@
+/*=========================================================================
+
+  Module:    V_SimdMetric.cpp
+
+  Copyright 2003,2006,2019 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+  Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government retains certain rights in this software.
+
+  See LICENSE for details.
+
+=========================================================================*/
+
+
+/*
+ *
+ * V_SimdMetric.cpp contains the structure-of-arrays entry points for batches
+ *                  of linear tets, hexes, quads and tris.  It picks the vectorized
+ *                  kernels matching the CPU at runtime and finishes the
+ *                  elements that do not fill a whole pack with the single
+ *                  element functions, which remain the reference.
+ *
+ * This file is part of VERDICT
+ *
+ */
+
+#include "V_SimdMetric.hpp"
+#include "verdict_kernels.h"
+
+#include <atomic>
+
+#if defined(VERDICT_ENABLE_SIMD) && defined(__aarch64__) && defined(__ARM_NEON)
+# define VERDICT_HAVE_NEON
+# include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER) && ( defined(VERDICT_HAVE_AVX2) || defined(VERDICT_HAVE_AVX512) )
+# include <intrin.h>
+#endif
+
+namespace VERDICT_NAMESPACE
+{
+
+#ifdef VERDICT_HAVE_NEON
+namespace
+{
+
+struct MaskNEON
+{
+  MaskNEON( uint64x2_t value ) : m( value ) {}
+
+  uint64x2_t m;
+};
+
+struct PackNEON
+{
+  typedef MaskNEON mask;
+  typedef double scalar;
+  static const int width = 2;
+
+  PackNEON() {}
+  PackNEON( float64x2_t value ) : v( value ) {}
+  PackNEON( double value ) : v( vdupq_n_f64( value ) ) {}
+
+  static PackNEON load( const double* p ) { return vld1q_f64( p ); }
+  static PackNEON load( const float* p ) { return vcvt_f64_f32( vld1_f32( p ) ); }
+
+  float64x2_t v;
+};
+
+inline PackNEON operator+( PackNEON a, PackNEON b ) { return vaddq_f64( a.v, b.v ); }
+inline PackNEON operator-( PackNEON a, PackNEON b ) { return vsubq_f64( a.v, b.v ); }
+inline PackNEON operator*( PackNEON a, PackNEON b ) { return vmulq_f64( a.v, b.v ); }
+inline PackNEON operator/( PackNEON a, PackNEON b ) { return vdivq_f64( a.v, b.v ); }
+inline PackNEON operator-( PackNEON a ) { return vnegq_f64( a.v ); }
+
+inline void store( double* p, PackNEON a ) { vst1q_f64( p, a.v ); }
+inline PackNEON sqrt_p( PackNEON a ) { return vsqrtq_f64( a.v ); }
+inline PackNEON min_p( PackNEON a, PackNEON b ) { return vminq_f64( a.v, b.v ); }
+inline PackNEON max_p( PackNEON a, PackNEON b ) { return vmaxq_f64( a.v, b.v ); }
+inline PackNEON abs_p( PackNEON a ) { return vabsq_f64( a.v ); }
+
+inline MaskNEON lt( PackNEON a, PackNEON b ) { return vcltq_f64( a.v, b.v ); }
+inline MaskNEON le( PackNEON a, PackNEON b ) { return vcleq_f64( a.v, b.v ); }
+inline MaskNEON gt( PackNEON a, PackNEON b ) { return vcgtq_f64( a.v, b.v ); }
+inline MaskNEON mask_or( MaskNEON a, MaskNEON b ) { return vorrq_u64( a.m, b.m ); }
+inline bool any_of( MaskNEON a ) { return vmaxvq_u32( vreinterpretq_u32_u64( a.m ) ) != 0; }
+inline PackNEON select( MaskNEON a, PackNEON b, PackNEON c ) { return vbslq_f64( a.m, b.v, c.v ); }
+
+struct MaskNEONFloat
+{
+  MaskNEONFloat( uint32x4_t value ) : m( value ) {}
+
+  uint32x4_t m;
+};
+
+struct PackNEONFloat
+{
+  typedef MaskNEONFloat mask;
+  typedef float scalar;
+  static const int width = 4;
+
+  PackNEONFloat() {}
+  PackNEONFloat( float32x4_t value ) : v( value ) {}
+  PackNEONFloat( double value ) : v( vdupq_n_f32( (float)value ) ) {}
+
+  static PackNEONFloat load( const float* p ) { return vld1q_f32( p ); }
+
+  float32x4_t v;
+};
+
+inline PackNEONFloat operator+( PackNEONFloat a, PackNEONFloat b ) { return vaddq_f32( a.v, b.v ); }
+inline PackNEONFloat operator-( PackNEONFloat a, PackNEONFloat b ) { return vsubq_f32( a.v, b.v ); }
+inline PackNEONFloat operator*( PackNEONFloat a, PackNEONFloat b ) { return vmulq_f32( a.v, b.v ); }
+inline PackNEONFloat operator/( PackNEONFloat a, PackNEONFloat b ) { return vdivq_f32( a.v, b.v ); }
+inline PackNEONFloat operator-( PackNEONFloat a ) { return vnegq_f32( a.v ); }
+
+inline void store( float* p, PackNEONFloat a ) { vst1q_f32( p, a.v ); }
+inline PackNEONFloat sqrt_p( PackNEONFloat a ) { return vsqrtq_f32( a.v ); }
+inline PackNEONFloat min_p( PackNEONFloat a, PackNEONFloat b ) { return vminq_f32( a.v, b.v ); }
+inline PackNEONFloat max_p( PackNEONFloat a, PackNEONFloat b ) { return vmaxq_f32( a.v, b.v ); }
+inline PackNEONFloat abs_p( PackNEONFloat a ) { return vabsq_f32( a.v ); }
+
+inline MaskNEONFloat lt( PackNEONFloat a, PackNEONFloat b ) { return vcltq_f32( a.v, b.v ); }
+inline MaskNEONFloat le( PackNEONFloat a, PackNEONFloat b ) { return vcleq_f32( a.v, b.v ); }
+inline MaskNEONFloat gt( PackNEONFloat a, PackNEONFloat b ) { return vcgtq_f32( a.v, b.v ); }
+inline MaskNEONFloat mask_or( MaskNEONFloat a, MaskNEONFloat b ) { return vorrq_u32( a.m, b.m ); }
+inline bool any_of( MaskNEONFloat a ) { return vmaxvq_u32( a.m ) != 0; }
+inline PackNEONFloat select( MaskNEONFloat a, PackNEONFloat b, PackNEONFloat c ) { return vbslq_f32( a.m, b.v, c.v ); }
+
+} // namespace
+
+// NEON is part of the aarch64 baseline, so these need no runtime check
+static const SimdKernels neon_kernels =
+{
+  {
+    &simd::tet_volume<PackNEON>,
+    &simd::tet_scaled_jacobian<PackNEON>,
+    &simd::tet_mean_ratio<PackNEON>,
+    &simd::hex_scaled_jacobian<PackNEON>,
+    &simd::hex_nodal_jacobian_ratio<PackNEON>
+  },
+  {
+    &simd::tet_volume<PackNEONFloat>,
+    &simd::tet_scaled_jacobian<PackNEONFloat>,
+    &simd::tet_mean_ratio<PackNEONFloat>,
+    &simd::hex_scaled_jacobian<PackNEONFloat>,
+    &simd::hex_nodal_jacobian_ratio<PackNEONFloat>
+  },
+  {
+    &simd::tet_volume<PackNEON, float>,
+    &simd::tet_scaled_jacobian<PackNEON, float>,
+    &simd::tet_mean_ratio<PackNEON, float>,
+    &simd::hex_scaled_jacobian<PackNEON, float>,
+    &simd::hex_nodal_jacobian_ratio<PackNEON, float>
+  },
+  {
+    &simd::quad_quality<PackNEON>,
+    &simd::tri_quality<PackNEON>
+  }
+};
+#endif
+
+/*!
+  whether the kernels of an instruction set were compiled in and can run
+  on this CPU
+*/
+static bool simd_level_available( VerdictSimdLevel level )
+{
+  switch ( level )
+  {
+    case VERDICT_SIMD_SCALAR:
+      return true;
+
+    case VERDICT_SIMD_NEON:
+#ifdef VERDICT_HAVE_NEON
+      return true;
+#else
+      return false;
+#endif
+
+    case VERDICT_SIMD_AVX2:
+#if !defined(VERDICT_HAVE_AVX2)
+      return false;
+#elif defined(_MSC_VER)
+      {
+        int info[4];
+        __cpuid( info, 1 );
+        const bool os_avx = ( info[2] & ( 1 << 27 ) ) && ( info[2] & ( 1 << 28 ) ) &&
+                            ( _xgetbv( 0 ) & 0x6 ) == 0x6;
+        __cpuidex( info, 7, 0 );
+        return os_avx && ( info[1] & ( 1 << 5 ) );
+      }
+#else
+      return __builtin_cpu_supports( "avx2" );
+#endif
+
+    case VERDICT_SIMD_AVX512:
+#if !defined(VERDICT_HAVE_AVX512)
+      return false;
+#elif defined(_MSC_VER)
+      {
+        int info[4];
+        __cpuid( info, 1 );
+        const bool os_avx512 = ( info[2] & ( 1 << 27 ) ) && ( _xgetbv( 0 ) & 0xe6 ) == 0xe6;
+        __cpuidex( info, 7, 0 );
+        return os_avx512 && ( info[1] & ( 1 << 16 ) );
+      }
+#else
+      return __builtin_cpu_supports( "avx512f" );
+#endif
+  }
+  return false;
+}
+
+//! the requested level, or the next narrower one that is available
+static VerdictSimdLevel available_simd_level( VerdictSimdLevel level )
+{
+  int l = level;
+  while ( l > VERDICT_SIMD_SCALAR && !simd_level_available( (VerdictSimdLevel)l ) )
+    l--;
+  return (VerdictSimdLevel)l;
+}
+
+// -1 until the first kernel call or set_simd_level()
+static std::atomic<int> active_simd_level( -1 );
+
+VerdictSimdLevel simd_level()
+{
+  int level = active_simd_level.load( std::memory_order_relaxed );
+  if ( level < 0 )
+  {
+    level = available_simd_level( VERDICT_SIMD_AVX512 );
+    active_simd_level.store( level, std::memory_order_relaxed );
+  }
+  return (VerdictSimdLevel)level;
+}
+
+VerdictSimdLevel set_simd_level( VerdictSimdLevel level )
+{
+  const VerdictSimdLevel selected = available_simd_level( level );
+  active_simd_level.store( selected, std::memory_order_relaxed );
+  return selected;
+}
+
+//! the kernel table of the active level, or null for the scalar loop
+static const SimdKernels* active_kernels()
+{
+  switch ( simd_level() )
+  {
+#ifdef VERDICT_HAVE_NEON
+    case VERDICT_SIMD_NEON:
+      return &neon_kernels;
+#endif
+#ifdef VERDICT_HAVE_AVX2
+    case VERDICT_SIMD_AVX2:
+      return &avx2_kernels;
+#endif
+#ifdef VERDICT_HAVE_AVX512
+    case VERDICT_SIMD_AVX512:
+      return &avx512_kernels;
+#endif
+    default:
+      return nullptr;
+  }
+}
+
+/*!
+  runs the vectorized kernel over as many elements as fill whole packs
+  and the single element function over the rest
+*/
+template <typename In, typename Out, typename Metric>
+static void evaluate_soa( SimdKernelSet<In, Out> SimdKernels::*precision,
+                          typename SimdKernelSet<In, Out>::Kernel SimdKernelSet<In, Out>::*kernel,
+                          Metric metric, int num_nodes, VerdictIndex num_elements,
+                          const In* coordinates, VerdictIndex stride, Out* results )
+{
+  VerdictIndex e = 0;
+  const SimdKernels* kernels = active_kernels();
+  if ( kernels )
+    e = ( ( kernels->*precision ).*kernel )( num_elements, coordinates, stride, results );
+
+  In element[8][3];
+  for ( ; e < num_elements; e++ )
+  {
+    for ( int n = 0; n < num_nodes; n++ )
+      for ( int c = 0; c < 3; c++ )
+        element[n][c] = coordinates[( 3*n + c )*stride + e];
+    results[e] = metric( num_nodes, element );
+  }
+}
+
+/*!
+  the single precision and mixed precision versions of the single element
+  functions, for the elements left over by the vectorized kernels
+*/
+template <typename In, typename Out>
+struct ReducedPrecisionMetrics
+{
+  static Out tet_volume( int, const In coordinates[][3] )
+  { return kernels::tet_volume<In, Out>( coordinates ); }
+
+  static Out tet_scaled_jacobian( int, const In coordinates[][3] )
+  { return kernels::tet_scaled_jacobian<In, Out>( coordinates ); }
+
+  static Out tet_mean_ratio( int, const In coordinates[][3] )
+  { return kernels::tet_mean_ratio<In, Out>( coordinates ); }
+
+  static Out hex_scaled_jacobian( int, const In coordinates[][3] )
+  { return kernels::hex_scaled_jacobian<In, Out>( coordinates ); }
+
+  //! see hex_nodal_jacobian_ratio
+  static Out hex_nodal_jacobian_ratio( int, const In coordinates[][3] )
+  {
+    Out coords[24];
+    for ( int i = 0; i < 8; i++ )
+      for ( int c = 0; c < 3; c++ )
+        coords[3*i + c] = Out( coordinates[i][c] );
+
+    Out Jdet8x[8];
+    hex_nodal_jacobians( coords, Jdet8x );
+
+    Out min_det = Jdet8x[0];
+    Out max_det = Jdet8x[0];
+    for ( int i = 1; i < 8; i++ )
+    {
+      min_det = Jdet8x[i] < min_det ? Jdet8x[i] : min_det;
+      max_det = Jdet8x[i] > max_det ? Jdet8x[i] : max_det;
+    }
+    if ( max_det <= VERDICT_DBL_MIN )
+      return -VERDICT_DBL_MAX;
+    return min_det / max_det;
+  }
+};
+
+void tet_volume_soa( VerdictIndex num_elements, const double* coordinates,
+                     VerdictIndex stride, double* results )
+{
+  evaluate_soa( &SimdKernels::double_precision, &SimdKernelSet<double, double>::tet_volume,
+                tet_volume, 4, num_elements, coordinates, stride, results );
+}
+
+void tet_volume_soa( VerdictIndex num_elements, const float* coordinates,
+                     VerdictIndex stride, float* results )
+{
+  evaluate_soa( &SimdKernels::single_precision, &SimdKernelSet<float, float>::tet_volume,
+                ReducedPrecisionMetrics<float, float>::tet_volume, 4,
+                num_elements, coordinates, stride, results );
+}
+
+void tet_volume_soa( VerdictIndex num_elements, const float* coordinates,
+                     VerdictIndex stride, double* results )
+{
+  evaluate_soa( &SimdKernels::mixed_precision, &SimdKernelSet<float, double>::tet_volume,
+                ReducedPrecisionMetrics<float, double>::tet_volume, 4,
+                num_elements, coordinates, stride, results );
+}
+
+void tet_scaled_jacobian_soa( VerdictIndex num_elements, const double* coordinates,
+                              VerdictIndex stride, double* results )
+{
+  evaluate_soa( &SimdKernels::double_precision, &SimdKernelSet<double, double>::tet_scaled_jacobian,
+                tet_scaled_jacobian, 4, num_elements, coordinates, stride, results );
+}
+
+void tet_scaled_jacobian_soa( VerdictIndex num_elements, const float* coordinates,
+                              VerdictIndex stride, float* results )
+{
+  evaluate_soa( &SimdKernels::single_precision, &SimdKernelSet<float, float>::tet_scaled_jacobian,
+                ReducedPrecisionMetrics<float, float>::tet_scaled_jacobian, 4,
+                num_elements, coordinates, stride, results );
+}
+
+void tet_scaled_jacobian_soa( VerdictIndex num_elements, const float* coordinates,
+                              VerdictIndex stride, double* results )
+{
+  evaluate_soa( &SimdKernels::mixed_precision, &SimdKernelSet<float, double>::tet_scaled_jacobian,
+                ReducedPrecisionMetrics<float, double>::tet_scaled_jacobian, 4,
+                num_elements, coordinates, stride, results );
+}
+
+void tet_mean_ratio_soa( VerdictIndex num_elements, const double* coordinates,
+                         VerdictIndex stride, double* results )
+{
+  evaluate_soa( &SimdKernels::double_precision, &SimdKernelSet<double, double>::tet_mean_ratio,
+                tet_mean_ratio, 4, num_elements, coordinates, stride, results );
+}
+
+void tet_mean_ratio_soa( VerdictIndex num_elements, const float* coordinates,
+                         VerdictIndex stride, float* results )
+{
+  evaluate_soa( &SimdKernels::single_precision, &SimdKernelSet<float, float>::tet_mean_ratio,
+                ReducedPrecisionMetrics<float, float>::tet_mean_ratio, 4,
+                num_elements, coordinates, stride, results );
+}
+
+void tet_mean_ratio_soa( VerdictIndex num_elements, const float* coordinates,
+                         VerdictIndex stride, double* results )
+{
+  evaluate_soa( &SimdKernels::mixed_precision, &SimdKernelSet<float, double>::tet_mean_ratio,
+                ReducedPrecisionMetrics<float, double>::tet_mean_ratio, 4,
+                num_elements, coordinates, stride, results );
+}
+
+void hex_scaled_jacobian_soa( VerdictIndex num_elements, const double* coordinates,
+                              VerdictIndex stride, double* results )
+{
+  evaluate_soa( &SimdKernels::double_precision, &SimdKernelSet<double, double>::hex_scaled_jacobian,
+                hex_scaled_jacobian, 8, num_elements, coordinates, stride, results );
+}
+
+void hex_scaled_jacobian_soa( VerdictIndex num_elements, const float* coordinates,
+                              VerdictIndex stride, float* results )
+{
+  evaluate_soa( &SimdKernels::single_precision, &SimdKernelSet<float, float>::hex_scaled_jacobian,
+                ReducedPrecisionMetrics<float, float>::hex_scaled_jacobian, 8,
+                num_elements, coordinates, stride, results );
+}
+
+void hex_scaled_jacobian_soa( VerdictIndex num_elements, const float* coordinates,
+                              VerdictIndex stride, double* results )
+{
+  evaluate_soa( &SimdKernels::mixed_precision, &SimdKernelSet<float, double>::hex_scaled_jacobian,
+                ReducedPrecisionMetrics<float, double>::hex_scaled_jacobian, 8,
+                num_elements, coordinates, stride, results );
+}
+
+void hex_nodal_jacobian_ratio_soa( VerdictIndex num_elements, const double* coordinates,
+                                   VerdictIndex stride, double* results )
+{
+  evaluate_soa( &SimdKernels::double_precision, &SimdKernelSet<double, double>::hex_nodal_jacobian_ratio,
+                hex_nodal_jacobian_ratio, 8, num_elements, coordinates, stride, results );
+}
+
+void hex_nodal_jacobian_ratio_soa( VerdictIndex num_elements, const float* coordinates,
+                                   VerdictIndex stride, float* results )
+{
+  evaluate_soa( &SimdKernels::single_precision, &SimdKernelSet<float, float>::hex_nodal_jacobian_ratio,
+                ReducedPrecisionMetrics<float, float>::hex_nodal_jacobian_ratio, 8,
+                num_elements, coordinates, stride, results );
+}
+
+void hex_nodal_jacobian_ratio_soa( VerdictIndex num_elements, const float* coordinates,
+                                   VerdictIndex stride, double* results )
+{
+  evaluate_soa( &SimdKernels::mixed_precision, &SimdKernelSet<float, double>::hex_nodal_jacobian_ratio,
+                ReducedPrecisionMetrics<float, double>::hex_nodal_jacobian_ratio, 8,
+                num_elements, coordinates, stride, results );
+}
+
+//! the single element functions of the arrays of SurfaceQualityArrays
+struct SurfaceFunctions
+{
+  VerdictFunction scaled_jacobian;
+  VerdictFunction warpage;  //!< nullptr for tris
+  VerdictFunction minimum_angle;
+};
+
+/*!
+  runs the vectorized surface kernel over as many elements as fill whole
+  packs and the single element functions over the rest
+*/
+static void evaluate_surface_soa( SimdSurfaceKernels::Kernel SimdSurfaceKernels::*kernel,
+                                  const SurfaceFunctions &functions, int num_nodes, VerdictIndex num_elements,
+                                  const double* coordinates, VerdictIndex stride,
+                                  const SurfaceQualityArrays &results )
+{
+  VerdictIndex e = 0;
+  const SimdKernels* kernels = active_kernels();
+  if ( kernels )
+    e = ( kernels->surface.*kernel )( num_elements, coordinates, stride, results );
+
+  const bool angles = results.minimum_angle || results.minimum_angle_cosine;
+  double element[4][3];
+  for ( ; e < num_elements; e++ )
+  {
+    for ( int n = 0; n < num_nodes; n++ )
+      for ( int c = 0; c < 3; c++ )
+        element[n][c] = coordinates[( 3*n + c )*stride + e];
+    if ( results.scaled_jacobian )
+      results.scaled_jacobian[e] = functions.scaled_jacobian( num_nodes, element );
+    if ( results.warpage && functions.warpage )
+      results.warpage[e] = functions.warpage( num_nodes, element );
+    if ( angles )
+    {
+      const double degrees = functions.minimum_angle( num_nodes, element );
+      if ( results.minimum_angle )
+        results.minimum_angle[e] = degrees;
+      if ( results.minimum_angle_cosine )
+        results.minimum_angle_cosine[e] = cos( degrees * VERDICT_PI / 180. );
+    }
+  }
+}
+
+void quad_quality_soa( VerdictIndex num_elements, const double* coordinates,
+                       VerdictIndex stride, const SurfaceQualityArrays &results )
+{
+  const SurfaceFunctions functions = { quad_scaled_jacobian, quad_warpage, quad_minimum_angle };
+  evaluate_surface_soa( &SimdSurfaceKernels::quad_quality, functions, 4,
+                        num_elements, coordinates, stride, results );
+}
+
+void tri_quality_soa( VerdictIndex num_elements, const double* coordinates,
+                      VerdictIndex stride, const SurfaceQualityArrays &results )
+{
+  const SurfaceFunctions functions = { tri_scaled_jacobian, nullptr, tri_minimum_angle };
+  evaluate_surface_soa( &SimdSurfaceKernels::tri_quality, functions, 3,
+                        num_elements, coordinates, stride, results );
+}
+
+void quad_scaled_jacobian_soa( VerdictIndex num_elements, const double* coordinates,
+                               VerdictIndex stride, double* results )
+{
+  const SurfaceQualityArrays arrays = { results, nullptr, nullptr, nullptr };
+  quad_quality_soa( num_elements, coordinates, stride, arrays );
+}
+
+void quad_warpage_soa( VerdictIndex num_elements, const double* coordinates,
+                       VerdictIndex stride, double* results )
+{
+  const SurfaceQualityArrays arrays = { nullptr, results, nullptr, nullptr };
+  quad_quality_soa( num_elements, coordinates, stride, arrays );
+}
+
+void quad_minimum_angle_soa( VerdictIndex num_elements, const double* coordinates,
+                             VerdictIndex stride, double* results )
+{
+  const SurfaceQualityArrays arrays = { nullptr, nullptr, results, nullptr };
+  quad_quality_soa( num_elements, coordinates, stride, arrays );
+}
+
+void tri_minimum_angle_soa( VerdictIndex num_elements, const double* coordinates,
+                            VerdictIndex stride, double* results )
+{
+  const SurfaceQualityArrays arrays = { nullptr, nullptr, results, nullptr };
+  tri_quality_soa( num_elements, coordinates, stride, arrays );
+}
+
+} // namespace verdict
@@ -0,0 +1,584 @@
+/*=========================================================================
+
+  Module:    V_SimdMetric.hpp
+
+  Copyright 2003,2006,2019 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+  Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government retains certain rights in this software.
+
+  See LICENSE for details.
+
+=========================================================================*/
+
+/*
+ *
+ * V_SimdMetric.hpp contains the vectorized kernels for batches of linear
+ *                  tets, hexes, quads and tris stored in structure-of-arrays
+ *                  form
+ *
+ * The kernels are templates on a "pack" type P holding P::width values of
+ * type P::scalar, double or float, and on the type In of the coordinates
+ * they read, which is P::scalar or, for the mixed precision kernels, float
+ * coordinates widened into double packs.
+ * Each instruction set has its own translation unit, compiled with the
+ * matching compiler flags, which defines its pack type in an anonymous
+ * namespace and instantiates the kernels into a constant-initialized
+ * SimdKernels table, so nothing compiled for the instruction set runs
+ * before the CPU has been checked.  Since the pack types have internal
+ * linkage, so do all the instantiations, and no code compiled for one
+ * instruction set can leak into another.  For the same reason the kernels
+ * must not call inline functions on plain doubles (std::min, std::max,
+ * VerdictVector, ...).
+ *
+ * A pack type provides + - * / and unary -, a constructor from a double,
+ * a static load(const In*) for each input type it is used with, and the
+ * free functions store, sqrt_p,
+ * min_p, max_p, abs_p, lt, le, gt, any_of, mask_or and select
+ * (select(m, a, b) is m ? a : b lane-wise).  min_p(a, b) and max_p(a, b)
+ * return b unless a is smaller, respectively larger, as std::min(b, a)
+ * and std::max(b, a) do.
+ *
+ * This file is part of VERDICT
+ *
+ */
+
+#ifndef VERDICT_SIMD_METRIC_HPP
+#define VERDICT_SIMD_METRIC_HPP
+
+#include "verdict_mesh.h"
+#include "V_HexMetric.hpp"
+#include <math.h>
+
+namespace VERDICT_NAMESPACE
+{
+
+//! the vectorized kernels of one instruction set reading In coordinates
+//! and writing Out results
+template <typename In, typename Out>
+struct SimdKernelSet
+{
+  //! returns the number of elements processed, which is a multiple of the
+  //! pack width.  The caller computes the remaining elements.
+  typedef VerdictIndex (*Kernel)( VerdictIndex num_elements, const In* coordinates,
+                                  VerdictIndex stride, Out* results );
+
+  Kernel tet_volume;
+  Kernel tet_scaled_jacobian;
+  Kernel tet_mean_ratio;
+  Kernel hex_scaled_jacobian;
+  Kernel hex_nodal_jacobian_ratio;
+};
+
+//! the vectorized kernels of one instruction set filling the arrays of
+//! SurfaceQualityArrays, in double precision
+struct SimdSurfaceKernels
+{
+  //! returns the number of elements processed, as SimdKernelSet::Kernel
+  typedef VerdictIndex (*Kernel)( VerdictIndex num_elements, const double* coordinates,
+                                  VerdictIndex stride, const SurfaceQualityArrays &results );
+
+  Kernel quad_quality;
+  Kernel tri_quality;
+};
+
+//! the vectorized kernels of one instruction set
+struct SimdKernels
+{
+  SimdKernelSet<double, double> double_precision;
+  SimdKernelSet<float, float> single_precision;
+  //! float coordinates computed in double
+  SimdKernelSet<float, double> mixed_precision;
+  SimdSurfaceKernels surface;
+};
+
+#ifdef VERDICT_HAVE_AVX2
+extern const SimdKernels avx2_kernels;
+#endif
+#ifdef VERDICT_HAVE_AVX512
+extern const SimdKernels avx512_kernels;
+#endif
+
+namespace simd
+{
+
+//! three packs: the x, y and z components of P::width vectors
+template <class P>
+struct Vec3
+{
+  P x, y, z;
+};
+
+template <class P>
+inline Vec3<P> operator-( const Vec3<P> &a, const Vec3<P> &b )
+{
+  Vec3<P> r = { a.x - b.x, a.y - b.y, a.z - b.z };
+  return r;
+}
+
+//! same operation order as VerdictVector::operator*
+template <class P>
+inline Vec3<P> cross( const Vec3<P> &a, const Vec3<P> &b )
+{
+  Vec3<P> r = { a.y * b.z - a.z * b.y,
+                a.z * b.x - a.x * b.z,
+                a.x * b.y - a.y * b.x };
+  return r;
+}
+
+//! same operation order as VerdictVector::Dot
+template <class P>
+inline P dot( const Vec3<P> &a, const Vec3<P> &b )
+{
+  return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+template <class P>
+inline P length_squared( const Vec3<P> &a )
+{
+  return a.x * a.x + a.y * a.y + a.z * a.z;
+}
+
+//! m ? a : b lane-wise
+template <class P>
+inline Vec3<P> select_vec( const typename P::mask &m, const Vec3<P> &a, const Vec3<P> &b )
+{
+  Vec3<P> r = { select( m, a.x, b.x ), select( m, a.y, b.y ), select( m, a.z, b.z ) };
+  return r;
+}
+
+//! position of one node for the P::width elements starting at element e
+template <class P, typename In>
+inline Vec3<P> load_node( const In* coordinates, VerdictIndex stride, int node, VerdictIndex e )
+{
+  const In* base = coordinates + 3 * node * stride + e;
+  Vec3<P> r = { P::load( base ), P::load( base + stride ), P::load( base + 2 * stride ) };
+  return r;
+}
+
+template <class P>
+inline P clamp_max( const P &v )
+{
+  return max_p( min_p( v, P( VERDICT_DBL_MAX ) ), P( -VERDICT_DBL_MAX ) );
+}
+
+// static, so each instruction set gets its own copy
+static inline double scalar_cbrt( double x ) { return cbrt( x ); }
+static inline float scalar_cbrt( float x ) { return cbrtf( x ); }
+static inline double scalar_acos( double x ) { return acos( x ); }
+
+//! the angles in degrees of cosines clamped to [-1, 1]; there is no
+//! vector acos, so it is taken lane by lane
+template <class P>
+inline P cosine_degrees( const P &cosine )
+{
+  typedef typename P::scalar S;
+  S angle[P::width];
+  store( angle, cosine );
+  for ( int i = 0; i < P::width; i++ )
+    angle[i] = scalar_acos( angle[i] ) * 180. / VERDICT_PI;
+  return P::load( angle );
+}
+
+//! see tet_volume
+template <class P, typename In = typename P::scalar>
+VerdictIndex tet_volume( VerdictIndex num_elements, const In* coordinates,
+                         VerdictIndex stride, typename P::scalar* results )
+{
+  VerdictIndex e = 0;
+  for ( ; e + P::width <= num_elements; e += P::width )
+  {
+    const Vec3<P> n0 = load_node<P, In>( coordinates, stride, 0, e );
+    const Vec3<P> side2 = load_node<P, In>( coordinates, stride, 1, e ) - n0;
+    const Vec3<P> side0 = load_node<P, In>( coordinates, stride, 2, e ) - n0;
+    const Vec3<P> side3 = load_node<P, In>( coordinates, stride, 3, e ) - n0;
+
+    store( results + e, dot( side3, cross( side2, side0 ) ) / P( 6.0 ) );
+  }
+  return e;
+}
+
+//! see tet_scaled_jacobian
+template <class P, typename In = typename P::scalar>
+VerdictIndex tet_scaled_jacobian( VerdictIndex num_elements, const In* coordinates,
+                                  VerdictIndex stride, typename P::scalar* results )
+{
+  const P root_of_2( 1.4142135623730950488016887242097 );
+
+  VerdictIndex e = 0;
+  for ( ; e + P::width <= num_elements; e += P::width )
+  {
+    const Vec3<P> n0 = load_node<P, In>( coordinates, stride, 0, e );
+    const Vec3<P> n1 = load_node<P, In>( coordinates, stride, 1, e );
+    const Vec3<P> n2 = load_node<P, In>( coordinates, stride, 2, e );
+    const Vec3<P> n3 = load_node<P, In>( coordinates, stride, 3, e );
+
+    const Vec3<P> side0 = n1 - n0;
+    const Vec3<P> side1 = n2 - n1;
+    const Vec3<P> side2 = n0 - n2;
+    const Vec3<P> side3 = n3 - n0;
+    const Vec3<P> side4 = n3 - n1;
+    const Vec3<P> side5 = n3 - n2;
+
+    const P jacobi = dot( side3, cross( side2, side0 ) );
+
+    const P l0 = length_squared( side0 );
+    const P l1 = length_squared( side1 );
+    const P l2 = length_squared( side2 );
+    const P l3 = length_squared( side3 );
+    const P l4 = length_squared( side4 );
+    const P l5 = length_squared( side5 );
+
+    // largest product of the squared lengths of the edges attached to a node
+    const P products = max_p( max_p( l0 * l2 * l3, l0 * l1 * l4 ), max_p( l1 * l2 * l5, l3 * l4 * l5 ) );
+    const P length_product = max_p( sqrt_p( products ), abs_p( jacobi ) );
+
+    store( results + e, select( lt( length_product, P( VERDICT_DBL_MIN ) ),
+                                P( VERDICT_DBL_MAX ),
+                                root_of_2 * jacobi / length_product ) );
+  }
+  return e;
+}
+
+//! see tet_mean_ratio
+template <class P, typename In = typename P::scalar>
+VerdictIndex tet_mean_ratio( VerdictIndex num_elements, const In* coordinates,
+                             VerdictIndex stride, typename P::scalar* results )
+{
+  VerdictIndex e = 0;
+  for ( ; e + P::width <= num_elements; e += P::width )
+  {
+    const Vec3<P> n0 = load_node<P, In>( coordinates, stride, 0, e );
+    const Vec3<P> n1 = load_node<P, In>( coordinates, stride, 1, e );
+    const Vec3<P> n2 = load_node<P, In>( coordinates, stride, 2, e );
+    const Vec3<P> n3 = load_node<P, In>( coordinates, stride, 3, e );
+
+    const Vec3<P> side0 = n1 - n0;
+    const Vec3<P> side1 = n2 - n1;
+    const Vec3<P> side2 = n0 - n2;
+    const Vec3<P> side3 = n3 - n0;
+    const Vec3<P> side4 = n3 - n1;
+    const Vec3<P> side5 = n3 - n2;
+
+    const P jacobian = dot( side3, cross( side2, side0 ) );
+    const P sum = length_squared( side0 ) + length_squared( side1 ) + length_squared( side2 ) +
+                  length_squared( side3 ) + length_squared( side4 ) + length_squared( side5 );
+
+    // there is no vector cbrt, so it is taken lane by lane
+    typedef typename P::scalar S;
+    S root[P::width];
+    store( root, abs_p( jacobian ) );
+    for ( int i = 0; i < P::width; i++ )
+      root[i] = scalar_cbrt( root[i] );
+    const P cbrt_jacobian = P::load( root );
+
+    const P sign = select( lt( jacobian, P( 0. ) ), P( -1. ), P( 1. ) );
+    store( results + e, select( lt( abs_p( jacobian / P( 6.0 ) ), P( VERDICT_DBL_MIN ) ),
+                                P( 0. ),
+                                sign * P( 12. / cbrt( 4. ) ) * cbrt_jacobian * cbrt_jacobian / sum ) );
+  }
+  return e;
+}
+
+//! see hex_scaled_jacobian; the 8 node branch
+template <class P, typename In = typename P::scalar>
+VerdictIndex hex_scaled_jacobian( VerdictIndex num_elements, const In* coordinates,
+                                  VerdictIndex stride, typename P::scalar* results )
+{
+  // corner, xi, eta and zeta neighbors of the Jacobian at each corner
+  static const int corner_nodes[8][4] =
+  {
+    {0, 1, 3, 4}, {1, 2, 0, 5}, {2, 3, 1, 6}, {3, 0, 2, 7},
+    {4, 7, 5, 0}, {5, 4, 6, 1}, {6, 5, 7, 2}, {7, 6, 4, 3}
+  };
+
+  const P dbl_min( VERDICT_DBL_MIN );
+
+  VerdictIndex e = 0;
+  for ( ; e + P::width <= num_elements; e += P::width )
+  {
+    Vec3<P> node_pos[8];
+    for ( int i = 0; i < 8; i++ )
+      node_pos[i] = load_node<P, In>( coordinates, stride, i, e );
+
+    // principal axes, summed in the order used by calc_hex_efg
+    Vec3<P> efg1 = node_pos[1];
+    Vec3<P> efg2 = node_pos[2];
+    Vec3<P> efg3 = node_pos[4];
+    const int efg_plus[3][3] = { {2, 5, 6}, {3, 6, 7}, {5, 6, 7} };
+    const int efg_minus[3][4] = { {0, 3, 4, 7}, {0, 1, 4, 5}, {0, 1, 2, 3} };
+    Vec3<P>* efg[3] = { &efg1, &efg2, &efg3 };
+    for ( int a = 0; a < 3; a++ )
+    {
+      for ( int i = 0; i < 3; i++ )
+      {
+        const Vec3<P> &n = node_pos[efg_plus[a][i]];
+        efg[a]->x = efg[a]->x + n.x;
+        efg[a]->y = efg[a]->y + n.y;
+        efg[a]->z = efg[a]->z + n.z;
+      }
+      for ( int i = 0; i < 4; i++ )
+      {
+        *efg[a] = *efg[a] - node_pos[efg_minus[a][i]];
+      }
+    }
+
+    P len1_sq = length_squared( efg1 );
+    P len2_sq = length_squared( efg2 );
+    P len3_sq = length_squared( efg3 );
+    typename P::mask degenerate = mask_or( mask_or( le( len1_sq, dbl_min ), le( len2_sq, dbl_min ) ),
+                                           le( len3_sq, dbl_min ) );
+    P min_norm_jac = dot( efg1, cross( efg2, efg3 ) ) / sqrt_p( len1_sq * len2_sq * len3_sq );
+
+    for ( int c = 0; c < 8; c++ )
+    {
+      const Vec3<P> &origin = node_pos[corner_nodes[c][0]];
+      const Vec3<P> xxi = node_pos[corner_nodes[c][1]] - origin;
+      const Vec3<P> xet = node_pos[corner_nodes[c][2]] - origin;
+      const Vec3<P> xze = node_pos[corner_nodes[c][3]] - origin;
+
+      len1_sq = length_squared( xxi );
+      len2_sq = length_squared( xet );
+      len3_sq = length_squared( xze );
+      degenerate = mask_or( degenerate, mask_or( mask_or( le( len1_sq, dbl_min ), le( len2_sq, dbl_min ) ),
+                                                 le( len3_sq, dbl_min ) ) );
+      min_norm_jac = min_p( min_norm_jac, dot( xxi, cross( xet, xze ) ) / sqrt_p( len1_sq * len2_sq * len3_sq ) );
+    }
+
+    store( results + e, select( degenerate, P( VERDICT_DBL_MAX ), clamp_max( min_norm_jac ) ) );
+  }
+  return e;
+}
+
+//! see hex_nodal_jacobian_ratio
+template <class P, typename In = typename P::scalar>
+VerdictIndex hex_nodal_jacobian_ratio( VerdictIndex num_elements, const In* coordinates,
+                                       VerdictIndex stride, typename P::scalar* results )
+{
+  VerdictIndex e = 0;
+  for ( ; e + P::width <= num_elements; e += P::width )
+  {
+    P coords[24];
+    for ( int i = 0; i < 24; i++ )
+      coords[i] = P::load( coordinates + i * stride + e );
+
+    P Jdet8x[8];
+    verdict::hex_nodal_jacobians( coords, Jdet8x );
+
+    P min_det = Jdet8x[0];
+    P max_det = Jdet8x[0];
+    for ( int i = 1; i < 8; i++ )
+    {
+      min_det = min_p( min_det, Jdet8x[i] );
+      max_det = max_p( max_det, Jdet8x[i] );
+    }
+
+    store( results + e, select( le( max_det, P( VERDICT_DBL_MIN ) ),
+                                P( -VERDICT_DBL_MAX ),
+                                min_det / max_det ) );
+  }
+  return e;
+}
+
+/*!
+  tri_scaled_jacobian and the cosine of the angle tri_minimum_angle takes,
+  clamped to [-1, 1], of the tris n0 n1 n2; each only when asked for.
+  Tris with a side of length zero have an angle of 0 degrees.
+*/
+template <class P>
+inline void tri_quality_packs( const Vec3<P> &n0, const Vec3<P> &n1, const Vec3<P> &n2,
+                               P* scaled_jacobian, P* minimum_angle_cosine )
+{
+  const Vec3<P> edge0 = n1 - n0;
+  const Vec3<P> edge1 = n2 - n0;
+  const Vec3<P> edge2 = n2 - n1;
+  const P length_squared0 = length_squared( edge0 );
+  const P length_squared1 = length_squared( edge1 );
+  const P length_squared2 = length_squared( edge2 );
+  const P length0 = sqrt_p( length_squared0 );
+  const P length1 = sqrt_p( length_squared1 );
+  const P length2 = sqrt_p( length_squared2 );
+
+  if ( scaled_jacobian )
+  {
+    const P jacobian = sqrt_p( length_squared( cross( edge1 - edge0, edge2 - edge0 ) ) );
+    const P max_edge_length_product = max_p( length0 * length1,
+                                             max_p( length1 * length2, length0 * length2 ) );
+    *scaled_jacobian = select( lt( max_edge_length_product, P( VERDICT_DBL_MIN ) ), P( 0. ),
+                               clamp_max( jacobian * P( 2. / sqrt( 3.0 ) ) / max_edge_length_product ) );
+  }
+
+  if ( minimum_angle_cosine )
+  {
+    // the smallest angle is opposite the shortest side, found with the
+    // comparisons of tri_minimum_angle
+    const typename P::mask side1_shorter = lt( length_squared2, length_squared0 );
+    const P shortest = select( side1_shorter, length_squared2, length_squared0 );
+    const typename P::mask side2_shortest = lt( length_squared1, shortest );
+    const Vec3<P> minus_edge2 = { -edge2.x, -edge2.y, -edge2.z };
+    const Vec3<P> a = select_vec( mask_or( side1_shorter, side2_shortest ), edge0, edge1 );
+    const Vec3<P> b = select_vec( side2_shortest, minus_edge2, select_vec( side1_shorter, edge1, edge2 ) );
+    const P length_a = select( mask_or( side1_shorter, side2_shortest ), length0, length1 );
+    const P length_b = select( side2_shortest, length2, select( side1_shorter, length1, length2 ) );
+
+    const P cosine = max_p( min_p( dot( a, b ) / ( length_a * length_b ), P( 1. ) ), P( -1. ) );
+    const typename P::mask degenerate = mask_or( mask_or( le( length_squared0, P( 0. ) ),
+                                                          le( length_squared1, P( 0. ) ) ),
+                                                 le( length_squared2, P( 0. ) ) );
+    *minimum_angle_cosine = select( degenerate, P( 1. ), cosine );
+  }
+}
+
+//! stores the arrays of SurfaceQualityArrays other than warpage for one pack
+template <class P>
+inline void store_angles( const SurfaceQualityArrays &results, VerdictIndex e,
+                          const P &cosine, const P &degrees )
+{
+  if ( results.minimum_angle )
+    store( results.minimum_angle + e, degrees );
+  if ( results.minimum_angle_cosine )
+    store( results.minimum_angle_cosine + e, cosine );
+}
+
+//! see tri_quality_soa
+template <class P>
+VerdictIndex tri_quality( VerdictIndex num_elements, const double* coordinates,
+                          VerdictIndex stride, const SurfaceQualityArrays &results )
+{
+  const bool angles = results.minimum_angle || results.minimum_angle_cosine;
+
+  VerdictIndex e = 0;
+  for ( ; e + P::width <= num_elements; e += P::width )
+  {
+    const Vec3<P> n0 = load_node<P, double>( coordinates, stride, 0, e );
+    const Vec3<P> n1 = load_node<P, double>( coordinates, stride, 1, e );
+    const Vec3<P> n2 = load_node<P, double>( coordinates, stride, 2, e );
+
+    P scaled_jacobian, cosine;
+    tri_quality_packs( n0, n1, n2, results.scaled_jacobian ? &scaled_jacobian : nullptr,
+                       angles ? &cosine : nullptr );
+    if ( results.scaled_jacobian )
+      store( results.scaled_jacobian + e, scaled_jacobian );
+    if ( angles )
+      store_angles( results, e, cosine, results.minimum_angle ? cosine_degrees( cosine ) : cosine );
+  }
+  return e;
+}
+
+/*!
+  see quad_quality_soa.  The edges and their lengths are shared by the
+  scaled jacobian and the angles, the corner normals by the scaled
+  jacobian and the warpage.  Quads with node 3 on node 2 are collapsed to
+  tris, as by is_collapsed_quad, except for the warpage.
+*/
+template <class P>
+VerdictIndex quad_quality( VerdictIndex num_elements, const double* coordinates,
+                           VerdictIndex stride, const SurfaceQualityArrays &results )
+{
+  const P dbl_min( VERDICT_DBL_MIN );
+  const bool angles = results.minimum_angle || results.minimum_angle_cosine;
+
+  VerdictIndex e = 0;
+  for ( ; e + P::width <= num_elements; e += P::width )
+  {
+    Vec3<P> node_pos[4];
+    for ( int i = 0; i < 4; i++ )
+      node_pos[i] = load_node<P, double>( coordinates, stride, i, e );
+
+    Vec3<P> edges[4];
+    P lengths[4];
+    for ( int i = 0; i < 4; i++ )
+    {
+      edges[i] = node_pos[( i + 1 ) % 4] - node_pos[i];
+      lengths[i] = sqrt_p( length_squared( edges[i] ) );
+    }
+
+    Vec3<P> corner_normals[4];
+    for ( int i = 0; i < 4; i++ )
+      corner_normals[i] = cross( edges[( i + 3 ) % 4], edges[i] );
+
+    const typename P::mask collapsed =
+      le( max_p( max_p( abs_p( edges[2].x ), abs_p( edges[2].y ) ), abs_p( edges[2].z ) ), P( 0. ) );
+    P tri_scaled_jacobian( 0. ), tri_cosine( 1. );
+    if ( any_of( collapsed ) )
+      tri_quality_packs( node_pos[0], node_pos[1], node_pos[2],
+                         results.scaled_jacobian ? &tri_scaled_jacobian : nullptr,
+                         angles ? &tri_cosine : nullptr );
+
+    if ( results.scaled_jacobian )
+    {
+      // the corner areas of signed_corner_areas
+      Vec3<P> center_normal = cross( edges[0] - edges[2], edges[1] - edges[3] );
+      const P center_length = sqrt_p( length_squared( center_normal ) );
+      const P divisor = select( gt( center_length, P( 0. ) ), center_length, P( 1. ) );
+      center_normal.x = center_normal.x / divisor;
+      center_normal.y = center_normal.y / divisor;
+      center_normal.z = center_normal.z / divisor;
+
+      typename P::mask degenerate = lt( lengths[0], dbl_min );
+      for ( int i = 1; i < 4; i++ )
+        degenerate = mask_or( degenerate, lt( lengths[i], dbl_min ) );
+      P min_scaled_jac( VERDICT_DBL_MAX );
+      for ( int i = 0; i < 4; i++ )
+      {
+        min_scaled_jac = min_p( min_scaled_jac, dot( center_normal, corner_normals[i] ) /
+                                                ( lengths[i] * lengths[( i + 3 ) % 4] ) );
+      }
+      store( results.scaled_jacobian + e,
+             select( collapsed, tri_scaled_jacobian,
+                     select( degenerate, P( 0. ), clamp_max( min_scaled_jac ) ) ) );
+    }
+
+    if ( results.warpage )
+    {
+      P normal_lengths[4];
+      for ( int i = 0; i < 4; i++ )
+        normal_lengths[i] = sqrt_p( length_squared( corner_normals[i] ) );
+      typename P::mask degenerate = lt( normal_lengths[0], dbl_min );
+      for ( int i = 1; i < 4; i++ )
+        degenerate = mask_or( degenerate, lt( normal_lengths[i], dbl_min ) );
+
+      // the lanes of degenerate quads divide by zero but are not stored
+      Vec3<P> unit_normals[4];
+      for ( int i = 0; i < 4; i++ )
+      {
+        unit_normals[i].x = corner_normals[i].x / normal_lengths[i];
+        unit_normals[i].y = corner_normals[i].y / normal_lengths[i];
+        unit_normals[i].z = corner_normals[i].z / normal_lengths[i];
+      }
+      // cubed by multiplication rather than by pow, which may differ in the last bit
+      const P warpage = min_p( dot( unit_normals[1], unit_normals[3] ),
+                               dot( unit_normals[0], unit_normals[2] ) );
+      store( results.warpage + e, select( degenerate, dbl_min, clamp_max( warpage * warpage * warpage ) ) );
+    }
+
+    if ( angles )
+    {
+      // the smallest angle has the largest cosine
+      typename P::mask degenerate = le( lengths[0], dbl_min );
+      for ( int i = 1; i < 4; i++ )
+        degenerate = mask_or( degenerate, le( lengths[i], dbl_min ) );
+      P max_cosine( -1. );
+      for ( int i = 0; i < 4; i++ )
+      {
+        const int next = ( i + 1 ) % 4;
+        max_cosine = max_p( max_cosine, -dot( edges[i], edges[next] ) / ( lengths[i] * lengths[next] ) );
+      }
+      // quads with a degenerate edge have an angle of 360 degrees
+      const P cosine = select( collapsed, tri_cosine,
+                               select( degenerate, P( 1. ), min_p( max_cosine, P( 1. ) ) ) );
+      P degrees = cosine;
+      if ( results.minimum_angle )
+      {
+        const P from_cosine = cosine_degrees( cosine );
+        degrees = select( collapsed, from_cosine, select( degenerate, P( 360. ), from_cosine ) );
+      }
+      store_angles( results, e, cosine, degrees );
+    }
+  }
+  return e;
+}
+
+} // namespace simd
+
+} // namespace verdict
+
+#endif
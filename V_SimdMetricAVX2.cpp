@@ -0,0 +1,147 @@
+/*=========================================================================
+
+  Module:    V_SimdMetricAVX2.cpp
+
+  Copyright 2003,2006,2019 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+  Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government retains certain rights in this software.
+
+  See LICENSE for details.
+
+=========================================================================*/
+
+
+/*
+ *
+ * V_SimdMetricAVX2.cpp instantiates the vectorized kernels of
+ *                      V_SimdMetric.hpp for AVX2, 4 elements at a time.
+ *                      It is compiled with the AVX2 compiler flags and only
+ *                      called when the CPU supports AVX2.
+ *
+ * This file is part of VERDICT
+ *
+ */
+
+#include "V_SimdMetric.hpp"
+#include <immintrin.h>
+
+namespace VERDICT_NAMESPACE
+{
+
+namespace
+{
+
+struct MaskAVX2
+{
+  MaskAVX2( __m256d value ) : m( value ) {}
+
+  __m256d m;
+};
+
+struct PackAVX2
+{
+  typedef MaskAVX2 mask;
+  typedef double scalar;
+  static const int width = 4;
+
+  PackAVX2() {}
+  PackAVX2( __m256d value ) : v( value ) {}
+  PackAVX2( double value ) : v( _mm256_set1_pd( value ) ) {}
+
+  static PackAVX2 load( const double* p ) { return _mm256_loadu_pd( p ); }
+  static PackAVX2 load( const float* p ) { return _mm256_cvtps_pd( _mm_loadu_ps( p ) ); }
+
+  __m256d v;
+};
+
+inline PackAVX2 operator+( PackAVX2 a, PackAVX2 b ) { return _mm256_add_pd( a.v, b.v ); }
+inline PackAVX2 operator-( PackAVX2 a, PackAVX2 b ) { return _mm256_sub_pd( a.v, b.v ); }
+inline PackAVX2 operator*( PackAVX2 a, PackAVX2 b ) { return _mm256_mul_pd( a.v, b.v ); }
+inline PackAVX2 operator/( PackAVX2 a, PackAVX2 b ) { return _mm256_div_pd( a.v, b.v ); }
+inline PackAVX2 operator-( PackAVX2 a ) { return _mm256_xor_pd( a.v, _mm256_set1_pd( -0.0 ) ); }
+
+inline void store( double* p, PackAVX2 a ) { _mm256_storeu_pd( p, a.v ); }
+inline PackAVX2 sqrt_p( PackAVX2 a ) { return _mm256_sqrt_pd( a.v ); }
+inline PackAVX2 min_p( PackAVX2 a, PackAVX2 b ) { return _mm256_min_pd( a.v, b.v ); }
+inline PackAVX2 max_p( PackAVX2 a, PackAVX2 b ) { return _mm256_max_pd( a.v, b.v ); }
+inline PackAVX2 abs_p( PackAVX2 a ) { return _mm256_andnot_pd( _mm256_set1_pd( -0.0 ), a.v ); }
+
+inline MaskAVX2 lt( PackAVX2 a, PackAVX2 b ) { return _mm256_cmp_pd( a.v, b.v, _CMP_LT_OQ ); }
+inline MaskAVX2 le( PackAVX2 a, PackAVX2 b ) { return _mm256_cmp_pd( a.v, b.v, _CMP_LE_OQ ); }
+inline MaskAVX2 gt( PackAVX2 a, PackAVX2 b ) { return _mm256_cmp_pd( a.v, b.v, _CMP_GT_OQ ); }
+inline MaskAVX2 mask_or( MaskAVX2 a, MaskAVX2 b ) { return _mm256_or_pd( a.m, b.m ); }
+inline bool any_of( MaskAVX2 a ) { return _mm256_movemask_pd( a.m ) != 0; }
+inline PackAVX2 select( MaskAVX2 a, PackAVX2 b, PackAVX2 c ) { return _mm256_blendv_pd( c.v, b.v, a.m ); }
+
+struct MaskAVX2Float
+{
+  MaskAVX2Float( __m256 value ) : m( value ) {}
+
+  __m256 m;
+};
+
+struct PackAVX2Float
+{
+  typedef MaskAVX2Float mask;
+  typedef float scalar;
+  static const int width = 8;
+
+  PackAVX2Float() {}
+  PackAVX2Float( __m256 value ) : v( value ) {}
+  PackAVX2Float( double value ) : v( _mm256_set1_ps( (float)value ) ) {}
+
+  static PackAVX2Float load( const float* p ) { return _mm256_loadu_ps( p ); }
+
+  __m256 v;
+};
+
+inline PackAVX2Float operator+( PackAVX2Float a, PackAVX2Float b ) { return _mm256_add_ps( a.v, b.v ); }
+inline PackAVX2Float operator-( PackAVX2Float a, PackAVX2Float b ) { return _mm256_sub_ps( a.v, b.v ); }
+inline PackAVX2Float operator*( PackAVX2Float a, PackAVX2Float b ) { return _mm256_mul_ps( a.v, b.v ); }
+inline PackAVX2Float operator/( PackAVX2Float a, PackAVX2Float b ) { return _mm256_div_ps( a.v, b.v ); }
+inline PackAVX2Float operator-( PackAVX2Float a ) { return _mm256_xor_ps( a.v, _mm256_set1_ps( -0.0f ) ); }
+
+inline void store( float* p, PackAVX2Float a ) { _mm256_storeu_ps( p, a.v ); }
+inline PackAVX2Float sqrt_p( PackAVX2Float a ) { return _mm256_sqrt_ps( a.v ); }
+inline PackAVX2Float min_p( PackAVX2Float a, PackAVX2Float b ) { return _mm256_min_ps( a.v, b.v ); }
+inline PackAVX2Float max_p( PackAVX2Float a, PackAVX2Float b ) { return _mm256_max_ps( a.v, b.v ); }
+inline PackAVX2Float abs_p( PackAVX2Float a ) { return _mm256_andnot_ps( _mm256_set1_ps( -0.0f ), a.v ); }
+
+inline MaskAVX2Float lt( PackAVX2Float a, PackAVX2Float b ) { return _mm256_cmp_ps( a.v, b.v, _CMP_LT_OQ ); }
+inline MaskAVX2Float le( PackAVX2Float a, PackAVX2Float b ) { return _mm256_cmp_ps( a.v, b.v, _CMP_LE_OQ ); }
+inline MaskAVX2Float gt( PackAVX2Float a, PackAVX2Float b ) { return _mm256_cmp_ps( a.v, b.v, _CMP_GT_OQ ); }
+inline MaskAVX2Float mask_or( MaskAVX2Float a, MaskAVX2Float b ) { return _mm256_or_ps( a.m, b.m ); }
+inline bool any_of( MaskAVX2Float a ) { return _mm256_movemask_ps( a.m ) != 0; }
+inline PackAVX2Float select( MaskAVX2Float a, PackAVX2Float b, PackAVX2Float c ) { return _mm256_blendv_ps( c.v, b.v, a.m ); }
+
+} // namespace
+
+const SimdKernels avx2_kernels =
+{
+  {
+    &simd::tet_volume<PackAVX2>,
+    &simd::tet_scaled_jacobian<PackAVX2>,
+    &simd::tet_mean_ratio<PackAVX2>,
+    &simd::hex_scaled_jacobian<PackAVX2>,
+    &simd::hex_nodal_jacobian_ratio<PackAVX2>
+  },
+  {
+    &simd::tet_volume<PackAVX2Float>,
+    &simd::tet_scaled_jacobian<PackAVX2Float>,
+    &simd::tet_mean_ratio<PackAVX2Float>,
+    &simd::hex_scaled_jacobian<PackAVX2Float>,
+    &simd::hex_nodal_jacobian_ratio<PackAVX2Float>
+  },
+  {
+    &simd::tet_volume<PackAVX2, float>,
+    &simd::tet_scaled_jacobian<PackAVX2, float>,
+    &simd::tet_mean_ratio<PackAVX2, float>,
+    &simd::hex_scaled_jacobian<PackAVX2, float>,
+    &simd::hex_nodal_jacobian_ratio<PackAVX2, float>
+  },
+  {
+    &simd::quad_quality<PackAVX2>,
+    &simd::tri_quality<PackAVX2>
+  }
+};
+
+} // namespace verdict
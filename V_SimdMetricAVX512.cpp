@@ -0,0 +1,147 @@
+/*=========================================================================
+
+  Module:    V_SimdMetricAVX512.cpp
+
+  Copyright 2003,2006,2019 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+  Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government retains certain rights in this software.
+
+  See LICENSE for details.
+
+=========================================================================*/
+
+
+/*
+ *
+ * V_SimdMetricAVX512.cpp instantiates the vectorized kernels of
+ *                        V_SimdMetric.hpp for AVX-512, 8 elements at a time.
+ *                        It is compiled with the AVX-512 compiler flags and
+ *                        only called when the CPU supports AVX-512F.
+ *
+ * This file is part of VERDICT
+ *
+ */
+
+#include "V_SimdMetric.hpp"
+#include <immintrin.h>
+
+namespace VERDICT_NAMESPACE
+{
+
+namespace
+{
+
+struct MaskAVX512
+{
+  MaskAVX512( __mmask8 value ) : m( value ) {}
+
+  __mmask8 m;
+};
+
+struct PackAVX512
+{
+  typedef MaskAVX512 mask;
+  typedef double scalar;
+  static const int width = 8;
+
+  PackAVX512() {}
+  PackAVX512( __m512d value ) : v( value ) {}
+  PackAVX512( double value ) : v( _mm512_set1_pd( value ) ) {}
+
+  static PackAVX512 load( const double* p ) { return _mm512_loadu_pd( p ); }
+  static PackAVX512 load( const float* p ) { return _mm512_cvtps_pd( _mm256_loadu_ps( p ) ); }
+
+  __m512d v;
+};
+
+inline PackAVX512 operator+( PackAVX512 a, PackAVX512 b ) { return _mm512_add_pd( a.v, b.v ); }
+inline PackAVX512 operator-( PackAVX512 a, PackAVX512 b ) { return _mm512_sub_pd( a.v, b.v ); }
+inline PackAVX512 operator*( PackAVX512 a, PackAVX512 b ) { return _mm512_mul_pd( a.v, b.v ); }
+inline PackAVX512 operator/( PackAVX512 a, PackAVX512 b ) { return _mm512_div_pd( a.v, b.v ); }
+inline PackAVX512 operator-( PackAVX512 a ) { return _mm512_sub_pd( _mm512_set1_pd( -0.0 ), a.v ); }
+
+inline void store( double* p, PackAVX512 a ) { _mm512_storeu_pd( p, a.v ); }
+inline PackAVX512 sqrt_p( PackAVX512 a ) { return _mm512_sqrt_pd( a.v ); }
+inline PackAVX512 min_p( PackAVX512 a, PackAVX512 b ) { return _mm512_min_pd( a.v, b.v ); }
+inline PackAVX512 max_p( PackAVX512 a, PackAVX512 b ) { return _mm512_max_pd( a.v, b.v ); }
+inline PackAVX512 abs_p( PackAVX512 a ) { return _mm512_abs_pd( a.v ); }
+
+inline MaskAVX512 lt( PackAVX512 a, PackAVX512 b ) { return _mm512_cmp_pd_mask( a.v, b.v, _CMP_LT_OQ ); }
+inline MaskAVX512 le( PackAVX512 a, PackAVX512 b ) { return _mm512_cmp_pd_mask( a.v, b.v, _CMP_LE_OQ ); }
+inline MaskAVX512 gt( PackAVX512 a, PackAVX512 b ) { return _mm512_cmp_pd_mask( a.v, b.v, _CMP_GT_OQ ); }
+inline MaskAVX512 mask_or( MaskAVX512 a, MaskAVX512 b ) { return (__mmask8)( a.m | b.m ); }
+inline bool any_of( MaskAVX512 a ) { return a.m != 0; }
+inline PackAVX512 select( MaskAVX512 a, PackAVX512 b, PackAVX512 c ) { return _mm512_mask_blend_pd( a.m, c.v, b.v ); }
+
+struct MaskAVX512Float
+{
+  MaskAVX512Float( __mmask16 value ) : m( value ) {}
+
+  __mmask16 m;
+};
+
+struct PackAVX512Float
+{
+  typedef MaskAVX512Float mask;
+  typedef float scalar;
+  static const int width = 16;
+
+  PackAVX512Float() {}
+  PackAVX512Float( __m512 value ) : v( value ) {}
+  PackAVX512Float( double value ) : v( _mm512_set1_ps( (float)value ) ) {}
+
+  static PackAVX512Float load( const float* p ) { return _mm512_loadu_ps( p ); }
+
+  __m512 v;
+};
+
+inline PackAVX512Float operator+( PackAVX512Float a, PackAVX512Float b ) { return _mm512_add_ps( a.v, b.v ); }
+inline PackAVX512Float operator-( PackAVX512Float a, PackAVX512Float b ) { return _mm512_sub_ps( a.v, b.v ); }
+inline PackAVX512Float operator*( PackAVX512Float a, PackAVX512Float b ) { return _mm512_mul_ps( a.v, b.v ); }
+inline PackAVX512Float operator/( PackAVX512Float a, PackAVX512Float b ) { return _mm512_div_ps( a.v, b.v ); }
+inline PackAVX512Float operator-( PackAVX512Float a ) { return _mm512_sub_ps( _mm512_set1_ps( -0.0f ), a.v ); }
+
+inline void store( float* p, PackAVX512Float a ) { _mm512_storeu_ps( p, a.v ); }
+inline PackAVX512Float sqrt_p( PackAVX512Float a ) { return _mm512_sqrt_ps( a.v ); }
+inline PackAVX512Float min_p( PackAVX512Float a, PackAVX512Float b ) { return _mm512_min_ps( a.v, b.v ); }
+inline PackAVX512Float max_p( PackAVX512Float a, PackAVX512Float b ) { return _mm512_max_ps( a.v, b.v ); }
+inline PackAVX512Float abs_p( PackAVX512Float a ) { return _mm512_abs_ps( a.v ); }
+
+inline MaskAVX512Float lt( PackAVX512Float a, PackAVX512Float b ) { return _mm512_cmp_ps_mask( a.v, b.v, _CMP_LT_OQ ); }
+inline MaskAVX512Float le( PackAVX512Float a, PackAVX512Float b ) { return _mm512_cmp_ps_mask( a.v, b.v, _CMP_LE_OQ ); }
+inline MaskAVX512Float gt( PackAVX512Float a, PackAVX512Float b ) { return _mm512_cmp_ps_mask( a.v, b.v, _CMP_GT_OQ ); }
+inline MaskAVX512Float mask_or( MaskAVX512Float a, MaskAVX512Float b ) { return (__mmask16)( a.m | b.m ); }
+inline bool any_of( MaskAVX512Float a ) { return a.m != 0; }
+inline PackAVX512Float select( MaskAVX512Float a, PackAVX512Float b, PackAVX512Float c ) { return _mm512_mask_blend_ps( a.m, c.v, b.v ); }
+
+} // namespace
+
+const SimdKernels avx512_kernels =
+{
+  {
+    &simd::tet_volume<PackAVX512>,
+    &simd::tet_scaled_jacobian<PackAVX512>,
+    &simd::tet_mean_ratio<PackAVX512>,
+    &simd::hex_scaled_jacobian<PackAVX512>,
+    &simd::hex_nodal_jacobian_ratio<PackAVX512>
+  },
+  {
+    &simd::tet_volume<PackAVX512Float>,
+    &simd::tet_scaled_jacobian<PackAVX512Float>,
+    &simd::tet_mean_ratio<PackAVX512Float>,
+    &simd::hex_scaled_jacobian<PackAVX512Float>,
+    &simd::hex_nodal_jacobian_ratio<PackAVX512Float>
+  },
+  {
+    &simd::tet_volume<PackAVX512, float>,
+    &simd::tet_scaled_jacobian<PackAVX512, float>,
+    &simd::tet_mean_ratio<PackAVX512, float>,
+    &simd::hex_scaled_jacobian<PackAVX512, float>,
+    &simd::hex_nodal_jacobian_ratio<PackAVX512, float>
+  },
+  {
+    &simd::quad_quality<PackAVX512>,
+    &simd::tri_quality<PackAVX512>
+  }
+};
+
+} // namespace verdict
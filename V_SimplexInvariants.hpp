@@ -0,0 +1,84 @@
+/*=========================================================================
+
+  Module:    V_SimplexInvariants.hpp
+
+  Copyright 2003,2006,2019 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+  Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government retains certain rights in this software.
+
+  See LICENSE for details.
+
+=========================================================================*/
+
+/*
+ *
+ * V_SimplexInvariants.hpp contains the geometric quantities shared by the
+ *                         linear tet and tri metrics: the edge vectors,
+ *                         their squared lengths, the face normals and the
+ *                         jacobian.  They are computed once per element,
+ *                         without square roots, and the metrics, the
+ *                         quality bundles and the radii are built on top.
+ *
+ * This file is part of VERDICT
+ *
+ */
+
+#ifndef VERDICT_SIMPLEX_INVARIANTS_HPP
+#define VERDICT_SIMPLEX_INVARIANTS_HPP
+
+#include "verdict.h"
+#include "VerdictVector.hpp"
+
+namespace VERDICT_NAMESPACE
+{
+
+//! the invariants of a linear tet
+struct TetInvariants
+{
+  //! node 1 - 0, 2 - 1, 0 - 2, 3 - 0, 3 - 1 and 3 - 2
+  VerdictVector side[6];
+  double length_squared[6];
+  //! the sum of length_squared
+  double length_squared_sum;
+  //! side[2] * side[0], side[3] * side[0], side[3] * side[2] and
+  //! side[4] * side[1]: the normals of the faces 012, 013, 023 and 123, each
+  //! as long as twice the face area.  Only face_normal[0] is set by
+  //! tet_invariants, the others by tet_face_normals.
+  VerdictVector face_normal[4];
+  //! side[3] % face_normal[0], six times the volume
+  double jacobian;
+};
+
+//! fills everything but face_normal[1..3]; no square roots or divisions
+void tet_invariants( double coordinates[][3], TetInvariants &tet );
+//! fills face_normal[1..3]
+void tet_face_normals( TetInvariants &tet );
+//! twice the surface area; needs all the face normals
+double tet_twice_surface_area( const TetInvariants &tet );
+//! the radius of the circumsphere, negative for inverted tets; needs all the face normals
+double tet_circumradius( const TetInvariants &tet );
+//! see tet_scaled_jacobian; shared with the pyramid metrics, which split into tets
+double tet_scaled_jacobian( const TetInvariants &tet );
+
+//! the invariants of a linear tri
+struct TriInvariants
+{
+  //! node 1 - 0, 2 - 1 and 0 - 2
+  VerdictVector side[3];
+  double length_squared[3];
+  //! the lengths of the sides; only set by tri_edge_lengths
+  double length[3];
+  //! side[0] * side[1], a normal as long as twice the area
+  VerdictVector normal;
+  double normal_length_squared;
+  //! the length of normal, which is the one square root tri_invariants takes
+  double twice_area;
+};
+
+//! fills everything but length
+void tri_invariants( double coordinates[][3], TriInvariants &tri );
+//! fills length; three square roots
+void tri_edge_lengths( TriInvariants &tri );
+
+} // namespace verdict
+
+#endif
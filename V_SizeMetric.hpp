@@ -0,0 +1,60 @@
+/*=========================================================================
+
+  Module:    V_SizeMetric.hpp
+
+  Copyright 2003,2006,2019 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+  Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government retains certain rights in this software.
+
+  See LICENSE for details.
+
+=========================================================================*/
+
+/*
+ *
+ * V_SizeMetric.hpp contains the two halves of the relative size metrics:
+ *                  the size measure of one element, which needs its
+ *                  coordinates, and the relative size computed from that
+ *                  measure and the weight derived from the average size,
+ *                  which does not.  The mesh-level size functions cache
+ *                  the measures so the second half runs without another
+ *                  pass over the coordinates.
+ *
+ * This file is part of VERDICT
+ *
+ */
+
+#ifndef VERDICT_SIZE_METRIC_HPP
+#define VERDICT_SIZE_METRIC_HPP
+
+#include "verdict.h"
+
+namespace VERDICT_NAMESPACE
+{
+
+//! the sum of the corner jacobians of a linear hex
+double hex_size_measure( double coordinates[][3] );
+//! the volume of the weighted jacobian for the average hex volume
+double hex_size_weight( double average_hex_volume );
+double hex_relative_size( double measure, double weight );
+
+//! the volume of a linear tet
+double tet_size_measure( double coordinates[][3] );
+//! the volume of the weighted tet for the average tet volume
+double tet_size_weight( double average_tet_volume );
+double tet_relative_size( double measure, double weight );
+
+//! twice the area of a linear tri
+double tri_size_measure( double coordinates[][3] );
+//! the determinant of the weights for the average tri area
+double tri_size_weight( double average_tri_area );
+double tri_relative_size( double measure, double weight );
+
+//! the area of a linear quad
+double quad_size_measure( double coordinates[][3] );
+//! the determinant of the weights for the average quad area
+double quad_size_weight( double average_quad_area );
+double quad_relative_size( double measure, double weight );
+
+} // namespace verdict
+
+#endif
@@ -20,9 +20,15 @@
 
 
 #include "verdict.h"
+#include "verdict_fixed.h"
 #include "verdict_defines.hpp"
 #include "VerdictVector.hpp"
+#include "V_SizeMetric.hpp"
+#include "V_TimestepMetric.hpp"
 #include "V_GaussIntegration.hpp"
+#include "V_Instrumentation.hpp"
+#include "V_NodalJacobian.hpp"
+#include "V_SimplexInvariants.hpp"
 #include <memory.h>
 #include <algorithm>
 #include <cmath> // for std::isnan
@@ -37,7 +43,10 @@ static const double rt3 = sqrt(3.0);
 static const double root_of_2 = sqrt(2.0);
 static const double normal_coeff = 180. * .3183098861837906715377675267450287;
 static const double aspect_ratio_normal_coeff = sqrt(6.) / 12.;
-static const double two_thirds = 2.0/3.0;
+// these times cbrt(|jacobian|)^2 over the sum of the squared edge lengths
+// give the shape and the mean ratio
+static const double shape_coeff = 6. * cbrt(2.);
+static const double mean_ratio_coeff = 12. / cbrt(4.);
 double tet10_characteristic_length( double coordinates[][3] );
 
 static const int tet10_subtet_conn[12][4] =
@@ -58,14 +67,253 @@ static const int tet10_subtet_conn[12][4] =
 
 static double fix_range( double v )
 {
-  if ( std::isnan(v)) return VERDICT_DBL_MAX;
-  if ( v >=  VERDICT_DBL_MAX ) return  VERDICT_DBL_MAX;
-  if ( v <= -VERDICT_DBL_MAX ) return -VERDICT_DBL_MAX;
+  if ( std::isnan(v) || v >= VERDICT_DBL_MAX || v <= -VERDICT_DBL_MAX )
+  {
+    VERDICT_COUNT_EVENT( "tet fix_range: clamped" );
+    if ( v <= -VERDICT_DBL_MAX ) return -VERDICT_DBL_MAX;
+    return VERDICT_DBL_MAX;
+  }
   return v;
 }
 
+void tet_invariants( double coordinates[][3], TetInvariants &tet )
+{
+  tet.side[0].set( coordinates[1][0] - coordinates[0][0],
+                   coordinates[1][1] - coordinates[0][1],
+                   coordinates[1][2] - coordinates[0][2] );
+  tet.side[1].set( coordinates[2][0] - coordinates[1][0],
+                   coordinates[2][1] - coordinates[1][1],
+                   coordinates[2][2] - coordinates[1][2] );
+  tet.side[2].set( coordinates[0][0] - coordinates[2][0],
+                   coordinates[0][1] - coordinates[2][1],
+                   coordinates[0][2] - coordinates[2][2] );
+  tet.side[3].set( coordinates[3][0] - coordinates[0][0],
+                   coordinates[3][1] - coordinates[0][1],
+                   coordinates[3][2] - coordinates[0][2] );
+  tet.side[4].set( coordinates[3][0] - coordinates[1][0],
+                   coordinates[3][1] - coordinates[1][1],
+                   coordinates[3][2] - coordinates[1][2] );
+  tet.side[5].set( coordinates[3][0] - coordinates[2][0],
+                   coordinates[3][1] - coordinates[2][1],
+                   coordinates[3][2] - coordinates[2][2] );
+
+  tet.length_squared_sum = 0;
+  for ( int i = 0; i < 6; i++ )
+  {
+    tet.length_squared[i] = tet.side[i].length_squared();
+    tet.length_squared_sum += tet.length_squared[i];
+  }
+
+  tet.face_normal[0] = tet.side[2] * tet.side[0];
+  tet.jacobian = tet.side[3] % tet.face_normal[0];
+}
+
+void tet_face_normals( TetInvariants &tet )
+{
+  tet.face_normal[1] = tet.side[3] * tet.side[0];
+  tet.face_normal[2] = tet.side[3] * tet.side[2];
+  tet.face_normal[3] = tet.side[4] * tet.side[1];
+}
+
+double tet_twice_surface_area( const TetInvariants &tet )
+{
+  return tet.face_normal[0].length() + tet.face_normal[1].length() +
+         tet.face_normal[2].length() + tet.face_normal[3].length();
+}
+
+double tet_circumradius( const TetInvariants &tet )
+{
+  // the circumcenter relative to node 0 is this vector over twice the jacobian
+  const VerdictVector numerator = tet.length_squared[3] * tet.face_normal[0] +
+                                  tet.length_squared[2] * tet.face_normal[1] +
+                                  tet.length_squared[0] * tet.face_normal[2];
+  return numerator.length() / ( 2 * tet.jacobian );
+}
+
+//! see tet_edge_ratio
+static double tet_edge_ratio( const TetInvariants &tet )
+{
+  const double a2 = tet.length_squared[0];
+  const double b2 = tet.length_squared[1];
+  const double c2 = tet.length_squared[2];
+  const double d2 = tet.length_squared[3];
+  const double e2 = tet.length_squared[4];
+  const double f2 = tet.length_squared[5];
+
+  const double mab = a2 < b2 ? a2 : b2, Mab = a2 < b2 ? b2 : a2;
+  const double mcd = c2 < d2 ? c2 : d2, Mcd = c2 < d2 ? d2 : c2;
+  const double mef = e2 < f2 ? e2 : f2, Mef = e2 < f2 ? f2 : e2;
+
+  double m2 = mab < mcd ? mab : mcd;
+  m2 = m2  < mef ? m2  : mef;
+
+  if( m2 < VERDICT_DBL_MIN )
+  {
+    VERDICT_COUNT_EVENT( "tet_edge_ratio: zero length edge" );
+    return (double)VERDICT_DBL_MAX;
+  }
+
+  double M2 = Mab > Mcd ? Mab : Mcd;
+  M2 = M2  > Mef ? M2  : Mef;
+
+  return fix_range( sqrt( M2 / m2 ) );
+}
+
+//! see tet_scaled_jacobian
+double tet_scaled_jacobian( const TetInvariants &tet )
+{
+  const double* l = tet.length_squared;
+
+  // products of lengths squared of each edge attached to a node.
+  const double length_squared[4] = {
+    l[0] * l[2] * l[3],
+    l[0] * l[1] * l[4],
+    l[1] * l[2] * l[5],
+    l[3] * l[4] * l[5]
+  };
+  int which_node = 0;
+  if(length_squared[1] > length_squared[which_node])
+    which_node = 1;
+  if(length_squared[2] > length_squared[which_node])
+    which_node = 2;
+  if(length_squared[3] > length_squared[which_node])
+    which_node = 3;
+
+  double length_product = sqrt( length_squared[which_node] );
+  if(length_product < fabs(tet.jacobian))
+    length_product = fabs(tet.jacobian);
+
+  if( length_product < VERDICT_DBL_MIN )
+  {
+    VERDICT_COUNT_EVENT( "tet_scaled_jacobian: zero length edge" );
+    return (double) VERDICT_DBL_MAX;
+  }
+
+  return (double)(root_of_2 * tet.jacobian / length_product);
+}
+
+/*!
+  see tet_radius_ratio; needs all the face normals
+
+  With J the jacobian and F the sum of the face normal lengths, the
+  circumradius is |numerator| / 2J and the inradius J / F.
+*/
+static double tet_radius_ratio( const TetInvariants &tet )
+{
+  if( fabs( tet.jacobian ) < 6 * VERDICT_DBL_MIN )
+    return (double)VERDICT_DBL_MAX;
+
+  const VerdictVector numerator = tet.length_squared[3] * tet.face_normal[0] +
+                                  tet.length_squared[2] * tet.face_normal[1] +
+                                  tet.length_squared[0] * tet.face_normal[2];
+
+  const double radius_ratio = numerator.length() * tet_twice_surface_area( tet ) /
+                              ( 6 * tet.jacobian * tet.jacobian );
+  return fix_range(radius_ratio);
+}
+
+//! see tet_aspect_ratio; needs all the face normals
+static double tet_aspect_ratio( const TetInvariants &tet )
+{
+  if( fabs( tet.jacobian ) < VERDICT_DBL_MIN )
+  {
+    VERDICT_COUNT_EVENT( "tet_aspect_ratio: zero volume" );
+    return (double)VERDICT_DBL_MAX;
+  }
+
+  double max_length_squared = tet.length_squared[0];
+  for ( int i = 1; i < 6; i++ )
+    if ( tet.length_squared[i] > max_length_squared )
+      max_length_squared = tet.length_squared[i];
+
+  const double aspect_ratio = aspect_ratio_normal_coeff * sqrt( max_length_squared ) *
+                              tet_twice_surface_area( tet ) / fabs( tet.jacobian );
+  return fix_range(aspect_ratio);
+}
+
+//! see tet_aspect_gamma
+static double tet_aspect_gamma( const TetInvariants &tet )
+{
+  const double volume = fabs( tet.jacobian / 6.0 );
+  if( volume < VERDICT_DBL_MIN )
+    return (double)VERDICT_DBL_MAX;
+
+  // srms^3, with srms the root mean square edge length
+  const double mean_squares = tet.length_squared_sum / 6.0;
+  return mean_squares * sqrt( mean_squares ) / ( 8.48528137423857 * volume );
+}
+
+/*!
+  see tet_aspect_frobenius
+
+  The frobenius norm of the weighted jacobian works out to half the sum of
+  the squared edge lengths.
+*/
+static double tet_aspect_frobenius( const TetInvariants &tet )
+{
+  const double cbrt_jacobian = cbrt( fabs( tet.jacobian ) );
+  const double denominator = shape_coeff * cbrt_jacobian * cbrt_jacobian;
+  if( denominator < VERDICT_DBL_MIN )
+    return (double)VERDICT_DBL_MAX;
+
+  return fix_range( tet.length_squared_sum / denominator );
+}
+
+//! see tet_shape; the same as the mean ratio for positive jacobians
+static double tet_shape( const TetInvariants &tet )
+{
+  if( tet.jacobian < VERDICT_DBL_MIN || 0.5 * tet.length_squared_sum < VERDICT_DBL_MIN )
+    return 0.0;
+
+  const double cbrt_jacobian = cbrt( tet.jacobian );
+  const double shape = shape_coeff * cbrt_jacobian * cbrt_jacobian / tet.length_squared_sum;
+  return fix_range(shape);
+}
+
+//! see tet_mean_ratio
+static double tet_mean_ratio( const TetInvariants &tet )
+{
+  if( fabs( tet.jacobian / 6.0 ) < VERDICT_DBL_MIN )
+  {
+    VERDICT_COUNT_EVENT( "tet_mean_ratio: zero volume" );
+    return 0.0;
+  }
+
+  const double sign = tet.jacobian < 0. ? -1. : 1.;
+  const double cbrt_jacobian = cbrt( fabs( tet.jacobian ) );
+  return sign * mean_ratio_coeff * cbrt_jacobian * cbrt_jacobian / tet.length_squared_sum;
+}
+
+//! see tet_condition
+static double tet_condition( const TetInvariants &tet )
+{
+  const double rt6 = sqrt(6.0);
+  const VerdictVector &side0 = tet.side[0];
+  const VerdictVector &side2 = tet.side[2];
+  const VerdictVector &side3 = tet.side[3];
+
+  VerdictVector c_1, c_2, c_3;
+  c_1 = side0;
+  c_2 = (-2*side2-side0)/rt3;
+  c_3 = (3*side3+side2-side0)/rt6;
+
+  double term1 = c_1 % c_1 + c_2 % c_2 + c_3 % c_3;
+  double term2 = ( c_1 * c_2 ) % ( c_1 * c_2 ) +
+                 ( c_2 * c_3 ) % ( c_2 * c_3 ) +
+                 ( c_1 * c_3 ) % ( c_1 * c_3 );
+  double det = c_1 % ( c_2 * c_3 );
+
+  if ( fabs( det ) <= VERDICT_DBL_MIN )
+  {
+    VERDICT_COUNT_EVENT( "tet_condition: zero volume" );
+    return VERDICT_DBL_MAX;
+  }
+  return sqrt( term1 * term2 ) /(3.0* det);
+}
+
 double tet_equiangle_skew( int /*num_nodes*/, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( tet_equiangle_skew );
   VerdictVector ab,ac,bc,bd, ad, cd;
 
   ab.set( coordinates[1][0] - coordinates[0][0],
@@ -201,84 +449,10 @@ static int tet_get_weight (VerdictVector &w1, VerdictVector &w2, VerdictVector &
 */
 double tet_edge_ratio( int /*num_nodes*/, double coordinates[][3] )
 {
-  VerdictVector a, b, c, d, e, f;
-
-  a.set( coordinates[1][0] - coordinates[0][0],
-         coordinates[1][1] - coordinates[0][1],
-         coordinates[1][2] - coordinates[0][2] );
-
-  b.set( coordinates[2][0] - coordinates[1][0],
-         coordinates[2][1] - coordinates[1][1],
-         coordinates[2][2] - coordinates[1][2] );
-
-  c.set( coordinates[0][0] - coordinates[2][0],
-         coordinates[0][1] - coordinates[2][1],
-         coordinates[0][2] - coordinates[2][2] );
-
-  d.set( coordinates[3][0] - coordinates[0][0],
-         coordinates[3][1] - coordinates[0][1],
-         coordinates[3][2] - coordinates[0][2] );
-
-  e.set( coordinates[3][0] - coordinates[1][0],
-         coordinates[3][1] - coordinates[1][1],
-         coordinates[3][2] - coordinates[1][2] );
-
-  f.set( coordinates[3][0] - coordinates[2][0],
-         coordinates[3][1] - coordinates[2][1],
-         coordinates[3][2] - coordinates[2][2] );
-
-  double a2 = a.length_squared();
-  double b2 = b.length_squared();
-  double c2 = c.length_squared();
-  double d2 = d.length_squared();
-  double e2 = e.length_squared();
-  double f2 = f.length_squared();
-
-  double m2,M2,mab,mcd,mef,Mab,Mcd,Mef;
-
-  if ( a2 < b2 )
-    {
-    mab = a2;
-    Mab = b2;
-    }
-  else // b2 <= a2
-    {
-    mab = b2;
-    Mab = a2;
-    }
-  if ( c2 < d2 )
-    {
-    mcd = c2;
-    Mcd = d2;
-    }
-  else // d2 <= c2
-    {
-    mcd = d2;
-    Mcd = c2;
-    }
-  if ( e2 < f2 )
-    {
-    mef = e2;
-    Mef = f2;
-    }
-  else // f2 <= e2
-    {
-    mef = f2;
-    Mef = e2;
-    }
-
-  m2 = mab < mcd ? mab : mcd;
-  m2 = m2  < mef ? m2  : mef;
-
-  if( m2 < VERDICT_DBL_MIN )
-    return (double)VERDICT_DBL_MAX;
-
-  M2 = Mab > Mcd ? Mab : Mcd;
-  M2 = M2  > Mef ? M2  : Mef;
-
-  const double edge_ratio = sqrt( M2 / m2 );
-
-  return fix_range(edge_ratio);
+  VERDICT_INSTRUMENT_METRIC( tet_edge_ratio );
+  TetInvariants tet;
+  tet_invariants( coordinates, tet );
+  return tet_edge_ratio( tet );
 }
 
 /*!
@@ -289,58 +463,10 @@ double tet_edge_ratio( int /*num_nodes*/, double coordinates[][3] )
 */
 double tet_scaled_jacobian( int /*num_nodes*/, double coordinates[][3] )
 {
-  const VerdictVector side0( coordinates[1][0] - coordinates[0][0],
-                             coordinates[1][1] - coordinates[0][1],
-                             coordinates[1][2] - coordinates[0][2] );
-  const VerdictVector side1( coordinates[2][0] - coordinates[1][0],
-                             coordinates[2][1] - coordinates[1][1],
-                             coordinates[2][2] - coordinates[1][2] );
-  const VerdictVector side2( coordinates[0][0] - coordinates[2][0],
-                             coordinates[0][1] - coordinates[2][1],
-                             coordinates[0][2] - coordinates[2][2] );
-  const VerdictVector side3( coordinates[3][0] - coordinates[0][0],
-                             coordinates[3][1] - coordinates[0][1],
-                             coordinates[3][2] - coordinates[0][2] );
-  const VerdictVector side4( coordinates[3][0] - coordinates[1][0],
-                             coordinates[3][1] - coordinates[1][1],
-                             coordinates[3][2] - coordinates[1][2] );
-  const VerdictVector side5( coordinates[3][0] - coordinates[2][0],
-                             coordinates[3][1] - coordinates[2][1],
-                             coordinates[3][2] - coordinates[2][2] );
-
-  const double jacobi = side3 % ( side2 * side0 );
-
-  // products of lengths squared of each edge attached to a node.
-  const double side0_length_squared = side0.length_squared();
-  const double side1_length_squared = side1.length_squared();
-  const double side2_length_squared = side2.length_squared();
-  const double side3_length_squared = side3.length_squared();
-  const double side4_length_squared = side4.length_squared();
-  const double side5_length_squared = side5.length_squared();
-
-  const double length_squared[4] = {
-    side0_length_squared * side2_length_squared * side3_length_squared,
-    side0_length_squared * side1_length_squared * side4_length_squared,
-    side1_length_squared * side2_length_squared * side5_length_squared,
-    side3_length_squared * side4_length_squared * side5_length_squared
-  };
-  int which_node = 0;
-  if(length_squared[1] > length_squared[which_node])
-    which_node = 1;
-  if(length_squared[2] > length_squared[which_node])
-    which_node = 2;
-  if(length_squared[3] > length_squared[which_node])
-    which_node = 3;
-
-  double length_product = sqrt( length_squared[which_node] );
-  if(length_product < fabs(jacobi))
-    length_product = fabs(jacobi);
-
-  if( length_product < VERDICT_DBL_MIN )
-    return (double) VERDICT_DBL_MAX;
-
-  return (double)(root_of_2 * jacobi / length_product);
-
+  VERDICT_INSTRUMENT_METRIC( tet_scaled_jacobian );
+  TetInvariants tet;
+  tet_invariants( coordinates, tet );
+  return tet_scaled_jacobian( tet );
 }
 
 /*!
@@ -354,54 +480,11 @@ double tet_scaled_jacobian( int /*num_nodes*/, double coordinates[][3] )
 */
 double tet_radius_ratio( int /*num_nodes*/, double coordinates[][3] )
 {
-
-  //Determine side vectors
-  VerdictVector side[6];
-
-  side[0].set( coordinates[1][0] - coordinates[0][0],
-               coordinates[1][1] - coordinates[0][1],
-               coordinates[1][2] - coordinates[0][2] );
-
-  side[1].set( coordinates[2][0] - coordinates[1][0],
-               coordinates[2][1] - coordinates[1][1],
-               coordinates[2][2] - coordinates[1][2] );
-
-  side[2].set( coordinates[0][0] - coordinates[2][0],
-               coordinates[0][1] - coordinates[2][1],
-               coordinates[0][2] - coordinates[2][2] );
-
-  side[3].set( coordinates[3][0] - coordinates[0][0],
-               coordinates[3][1] - coordinates[0][1],
-               coordinates[3][2] - coordinates[0][2] );
-
-  side[4].set( coordinates[3][0] - coordinates[1][0],
-               coordinates[3][1] - coordinates[1][1],
-               coordinates[3][2] - coordinates[1][2] );
-
-  side[5].set( coordinates[3][0] - coordinates[2][0],
-               coordinates[3][1] - coordinates[2][1],
-               coordinates[3][2] - coordinates[2][2] );
-
-  VerdictVector numerator = side[3].length_squared() * ( side[2] * side[0]) +
-                            side[2].length_squared() * ( side[3] * side[0]) +
-                            side[0].length_squared() * ( side[3] * side[2]);
-
-  double area_sum;
-  area_sum = ((side[2] * side[0]).length() +
-              (side[3] * side[0]).length() +
-              (side[4] * side[1]).length() +
-              (side[3] * side[2]).length() ) * 0.5;
-
-  double volume = tet_volume(4, coordinates);
-
-  if( fabs( volume ) < VERDICT_DBL_MIN )
-    return (double)VERDICT_DBL_MAX;
-  else
-  {
-    const double radius_ratio = numerator.length() * area_sum / (108 * volume * volume);
-    return fix_range(radius_ratio);
-  }
-
+  VERDICT_INSTRUMENT_METRIC( tet_radius_ratio );
+  TetInvariants tet;
+  tet_invariants( coordinates, tet );
+  tet_face_normals( tet );
+  return tet_radius_ratio( tet );
 }
 
 /*!
@@ -417,64 +500,11 @@ double tet_radius_ratio( int /*num_nodes*/, double coordinates[][3] )
 */
 double tet_aspect_ratio( int /*num_nodes*/, double coordinates[][3] )
 {
-
-  //Determine side vectors
-  VerdictVector ab, bc, ac, ad, bd, cd;
-
-  ab.set( coordinates[1][0] - coordinates[0][0],
-          coordinates[1][1] - coordinates[0][1],
-          coordinates[1][2] - coordinates[0][2] );
-
-  ac.set( coordinates[2][0] - coordinates[0][0],
-          coordinates[2][1] - coordinates[0][1],
-          coordinates[2][2] - coordinates[0][2] );
-
-  ad.set( coordinates[3][0] - coordinates[0][0],
-          coordinates[3][1] - coordinates[0][1],
-          coordinates[3][2] - coordinates[0][2] );
-
-  double detTet = ab % ( ac * ad );
-
-  if( fabs( detTet ) < VERDICT_DBL_MIN )
-    return (double)VERDICT_DBL_MAX;
-
-  bc.set( coordinates[2][0] - coordinates[1][0],
-          coordinates[2][1] - coordinates[1][1],
-          coordinates[2][2] - coordinates[1][2] );
-
-  bd.set( coordinates[3][0] - coordinates[1][0],
-          coordinates[3][1] - coordinates[1][1],
-          coordinates[3][2] - coordinates[1][2] );
-
-  cd.set( coordinates[3][0] - coordinates[2][0],
-          coordinates[3][1] - coordinates[2][1],
-          coordinates[3][2] - coordinates[2][2] );
-
-  double ab2 = ab.length_squared();
-  double bc2 = bc.length_squared();
-  double ac2 = ac.length_squared();
-  double ad2 = ad.length_squared();
-  double bd2 = bd.length_squared();
-  double cd2 = cd.length_squared();
-
-  double A = ab2 > bc2 ? ab2 : bc2;
-  double B = ac2 > ad2 ? ac2 : ad2;
-  double C = bd2 > cd2 ? bd2 : cd2;
-  double D = A > B ? A : B;
-  double hm = D > C ? sqrt( D ) : sqrt( C );
-
-  bd = ab * bc;
-  A = bd.length();
-  bd = ab * ad;
-  B = bd.length();
-  bd = ac * ad;
-  C = bd.length();
-  bd = bc * cd;
-  D = bd.length();
-
-  const double aspect_ratio = aspect_ratio_normal_coeff * hm * ( A + B + C + D ) / fabs( detTet );
-
-  return fix_range(aspect_ratio);
+  VERDICT_INSTRUMENT_METRIC( tet_aspect_ratio );
+  TetInvariants tet;
+  tet_invariants( coordinates, tet );
+  tet_face_normals( tet );
+  return tet_aspect_ratio( tet );
 }
 
 /*!
@@ -484,48 +514,10 @@ double tet_aspect_ratio( int /*num_nodes*/, double coordinates[][3] )
 */
 double tet_aspect_gamma( int /*num_nodes*/, double coordinates[][3] )
 {
-
-  //Determine side vectors
-  VerdictVector side0, side1, side2, side3, side4, side5;
-
-  side0.set( coordinates[1][0] - coordinates[0][0],
-             coordinates[1][1] - coordinates[0][1],
-             coordinates[1][2] - coordinates[0][2] );
-
-  side1.set( coordinates[2][0] - coordinates[1][0],
-             coordinates[2][1] - coordinates[1][1],
-             coordinates[2][2] - coordinates[1][2] );
-
-  side2.set( coordinates[0][0] - coordinates[2][0],
-             coordinates[0][1] - coordinates[2][1],
-             coordinates[0][2] - coordinates[2][2] );
-
-  side3.set( coordinates[3][0] - coordinates[0][0],
-             coordinates[3][1] - coordinates[0][1],
-             coordinates[3][2] - coordinates[0][2] );
-
-  side4.set( coordinates[3][0] - coordinates[1][0],
-             coordinates[3][1] - coordinates[1][1],
-             coordinates[3][2] - coordinates[1][2] );
-
-  side5.set( coordinates[3][0] - coordinates[2][0],
-             coordinates[3][1] - coordinates[2][1],
-             coordinates[3][2] - coordinates[2][2] );
-
-
-  double volume = fabs( tet_volume(4, coordinates) );
-
-  if( volume  < VERDICT_DBL_MIN )
-    return (double)VERDICT_DBL_MAX;
-  else
-  {
-    double srms = sqrt((side0.length_squared() + side1.length_squared() +
-                        side2.length_squared() + side3.length_squared() +
-                        side4.length_squared() + side5.length_squared()) / 6.0 );
-
-    double aspect_ratio_gamma = pow(srms, 3) / (8.48528137423857 * volume );
-    return (double)aspect_ratio_gamma;
-  }
+  VERDICT_INSTRUMENT_METRIC( tet_aspect_gamma );
+  TetInvariants tet;
+  tet_invariants( coordinates, tet );
+  return tet_aspect_gamma( tet );
 }
 
 /*!
@@ -536,47 +528,10 @@ double tet_aspect_gamma( int /*num_nodes*/, double coordinates[][3] )
 */
 double tet_aspect_frobenius( int /*num_nodes*/, double coordinates[][3] )
 {
-
-  VerdictVector ab, ac, ad;
-
-  ab.set( coordinates[1][0] - coordinates[0][0],
-          coordinates[1][1] - coordinates[0][1],
-          coordinates[1][2] - coordinates[0][2] );
-
-  ac.set( coordinates[2][0] - coordinates[0][0],
-          coordinates[2][1] - coordinates[0][1],
-          coordinates[2][2] - coordinates[0][2] );
-
-  ad.set( coordinates[3][0] - coordinates[0][0],
-          coordinates[3][1] - coordinates[0][1],
-          coordinates[3][2] - coordinates[0][2] );
-
-  double denominator = ab % ( ac * ad );
-  denominator *= denominator;
-  denominator *= 2.;
-  denominator = 3. * pow( denominator, one_third );
-
-  if( denominator < VERDICT_DBL_MIN )
-    return (double)VERDICT_DBL_MAX;
-
-  double u[3];
-  ab.get_xyz( u );
-  double v[3];
-  ac.get_xyz( v );
-  double w[3];
-  ad.get_xyz( w );
-
-  double numerator = u[0] * u[0] + u[1] * u[1] + u[2] * u[2];
-  numerator += v[0] * v[0] + v[1] * v[1] + v[2] * v[2];
-  numerator += w[0] * w[0] + w[1] * w[1] + w[2] * w[2];
-  numerator *= 1.5;
-  numerator -= v[0] * u[0] + v[1] * u[1] + v[2] * u[2];
-  numerator -= w[0] * u[0] + w[1] * u[1] + w[2] * u[2];
-  numerator -= w[0] * v[0] + w[1] * v[1] + w[2] * v[2];
-
-  double aspect_frobenius = numerator / denominator;
-
-  return fix_range(aspect_frobenius);
+  VERDICT_INSTRUMENT_METRIC( tet_aspect_frobenius );
+  TetInvariants tet;
+  tet_invariants( coordinates, tet );
+  return tet_aspect_frobenius( tet );
 }
 
 /*!
@@ -587,6 +542,7 @@ double tet_aspect_frobenius( int /*num_nodes*/, double coordinates[][3] )
 */
 double tet_minimum_angle( int /*num_nodes*/, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( tet_minimum_angle );
 
   //Determine side vectors
   VerdictVector ab, bc, ad, cd;
@@ -643,6 +599,7 @@ double tet_minimum_angle( int /*num_nodes*/, double coordinates[][3] )
 */
 double tet_collapse_ratio( int /*num_nodes*/, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( tet_collapse_ratio );
   //Determine side vectors
   VerdictVector e01, e02, e03, e12, e13, e23;
 
@@ -718,6 +675,7 @@ double tet_collapse_ratio( int /*num_nodes*/, double coordinates[][3] )
 
 double tet_equivolume_skew( int num_nodes, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( tet_equivolume_skew );
 
     //- Find the vectors from the origin to each of the nodes on the tet.
   VerdictVector vectA(coordinates[0][0],coordinates[0][1],coordinates[0][2]);
@@ -756,6 +714,7 @@ double tet_equivolume_skew( int num_nodes, double coordinates[][3] )
 
 double tet_squish_index( int /*num_nodes*/, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( tet_squish_index );
   VerdictVector vectA(coordinates[0][0],coordinates[0][1],coordinates[0][2]);
  VerdictVector vectB(coordinates[1][0],coordinates[1][1],coordinates[1][2]);
   VerdictVector vectC(coordinates[2][0],coordinates[2][1],coordinates[2][2]);
@@ -966,208 +925,283 @@ static void TET15_gradients_of_the_shape_functions_for_R_S_T(const double rst[3]
   dhdt[3] =  dhdt[3] - .5*(dhdt[7]+dhdt[8]+dhdt[9])- one_third*(dhdt[14]+dhdt[12]+dhdt[13]) - .25*dhdt[10];
 }
 
+//! the gradients of the shape functions at the nodes, tabulated on first use
+static const NodalGradients<15> &tet15_nodal_gradients()
+{
+  static const NodalGradients<15> gradients( TET15_gradients_of_the_shape_functions_for_R_S_T, TET15_node_local_coord );
+  return gradients;
+}
+
 double calculate_tet_volume_using_sides(const VerdictVector &side0, const VerdictVector &side2, const VerdictVector &side3)
 {
     return  (double)((side3 % (side2 * side0)) / 6.0);
 }
 
 /*!
-  the volume of a tet
+  the nodes of a higher order tet, and the centroid of the nodes past
+  the corners
+*/
+template <int NumNodes>
+static void tet_higher_order_points( double coordinates[][3], VerdictVector tet_pts[NumNodes],
+                                     VerdictVector &centroid )
+{
+  //create a vector for each point
+  for (int k = 0; k < NumNodes; k++)    
+    tet_pts[k].set(coordinates[k][0], coordinates[k][1], coordinates[k][2]);    
+
+  //determine center point of the higher-order nodes      
+  centroid.set(0, 0, 0);
+  for( int k=4; k<NumNodes; k++ )
+    centroid += VerdictVector(coordinates[k][0], coordinates[k][1], coordinates[k][2]);
+  centroid /= (NumNodes - 4);
+}
+
+/*!
+  the volume of a tet with a node on each face, 14 or 15 nodes; the 15th
+  is the center node, which comes before the face nodes
+*/
+template <int NumNodes>
+static double tet_volume_with_face_nodes( double coordinates[][3] )
+{
+  VerdictVector side0, side2, side3;
+  VerdictVector tet_pts[NumNodes];
+  VerdictVector centroid;
+  tet_higher_order_points<NumNodes>( coordinates, tet_pts, centroid );
+
+  double tet_volume = 0;
+
+  int tet_face_conn[4][7] = 
+  {
+    {0,3,2,7,9,6,12},
+    {0,2,1,6,5,4,10},
+    {0,1,3,4,8,7,13},
+    {1,2,3,5,9,8,11}
+  };
+
+  if (NumNodes == 15)
+  {
+    tet_face_conn[0][6]++;
+    tet_face_conn[1][6]++;
+    tet_face_conn[2][6]++;
+    tet_face_conn[3][6]++;
+  }
+
+  for (int i = 0; i<4; i++)
+  {        
+    VerdictVector &node0 = tet_pts[tet_face_conn[i][0]];
+    VerdictVector &node1 = tet_pts[tet_face_conn[i][1]];
+    VerdictVector &node2 = tet_pts[tet_face_conn[i][2]];
+    VerdictVector &node3 = tet_pts[tet_face_conn[i][3]];
+    VerdictVector &node4 = tet_pts[tet_face_conn[i][4]];
+    VerdictVector &node5 = tet_pts[tet_face_conn[i][5]];
+    VerdictVector &node6 = tet_pts[tet_face_conn[i][6]];
+
+    //056
+    side2 = node5 - node0;
+    side0 = node6 - node0;
+    side3 = centroid - node0;
+    tet_volume += calculate_tet_volume_using_sides(side0, side2, side3);        
+
+    //063
+    side2 = node6 - node0;
+    side0 = node3 - node0;
+    side3 = centroid - node0;
+    tet_volume += calculate_tet_volume_using_sides(side0, side2, side3);        
+
+    //136
+    side2 = node3 - node1;
+    side0 = node6 - node1;
+    side3 = centroid - node1;
+    tet_volume += calculate_tet_volume_using_sides(side0, side2, side3);        
+
+    //164
+    side2 = node6 - node1;
+    side0 = node4 - node1;
+    side3 = centroid - node1;
+    tet_volume += calculate_tet_volume_using_sides(side0, side2, side3);
+    
+    //246
+    side2 = node4 - node2;
+    side0 = node6 - node2;
+    side3 = centroid - node2;
+    tet_volume += calculate_tet_volume_using_sides(side0, side2, side3);
+    
+    //265
+    side2 = node6 - node2;
+    side0 = node5 - node2;
+    side3 = centroid - node2;
+    tet_volume += calculate_tet_volume_using_sides(side0, side2, side3);
+  }
+
+  return tet_volume;
+}
+
+namespace fixed
+{
+
+/*!
+  the volume of a linear tet
 
   1/6 * jacobian at a corner node
 */
-double tet_volume( int num_nodes, double coordinates[][3] )
+template <>
+double tet_volume<4>( double coordinates[][3] )
 {
   //Determine side vectors
   VerdictVector side0, side2, side3;
-  if (4 == num_nodes)
+
+  side2.set(coordinates[1][0] - coordinates[0][0],
+            coordinates[1][1] - coordinates[0][1],
+            coordinates[1][2] - coordinates[0][2]);
+
+  side0.set(coordinates[2][0] - coordinates[0][0],
+            coordinates[2][1] - coordinates[0][1],
+            coordinates[2][2] - coordinates[0][2]);
+
+  side3.set(coordinates[3][0] - coordinates[0][0],
+            coordinates[3][1] - coordinates[0][1],
+            coordinates[3][2] - coordinates[0][2]);
+  return  calculate_tet_volume_using_sides(side0, side2, side3);
+}
+
+//! the volume of an 8 node tet, with a node on each face
+template <>
+double tet_volume<8>( double coordinates[][3] )
+{
+  VerdictVector side0, side2, side3;
+  VerdictVector tet_pts[8];
+  VerdictVector centroid;
+  tet_higher_order_points<8>( coordinates, tet_pts, centroid );
+
+  double tet_volume = 0;
+
+  int tet_face_conn[4][4] = 
   {
-    side2.set(coordinates[1][0] - coordinates[0][0],
-              coordinates[1][1] - coordinates[0][1],
-              coordinates[1][2] - coordinates[0][2]);
-
-    side0.set(coordinates[2][0] - coordinates[0][0],
-              coordinates[2][1] - coordinates[0][1],
-              coordinates[2][2] - coordinates[0][2]);
-
-    side3.set(coordinates[3][0] - coordinates[0][0],
-              coordinates[3][1] - coordinates[0][1],
-              coordinates[3][2] - coordinates[0][2]);
-    return  calculate_tet_volume_using_sides(side0, side2, side3);
+    {0,2,1,4},
+    {0,1,3,7},
+    {1,2,3,5},
+    {0,3,2,6}
+  };
+
+  for (int i = 0; i<4; i++)
+  {        
+    const VerdictVector &node0 = tet_pts[tet_face_conn[i][0]];
+    const VerdictVector &node1 = tet_pts[tet_face_conn[i][1]];
+    const VerdictVector &node2 = tet_pts[tet_face_conn[i][2]];
+    const VerdictVector &node3 = tet_pts[tet_face_conn[i][3]];
+
+    //012
+    side2 = node3 - node0;
+    side0 = node1 - node0;
+    side3 = centroid - node0;
+    tet_volume += calculate_tet_volume_using_sides(side0, side2, side3);
+
+    //123
+    side2 = node3 - node1;
+    side0 = node2 - node1;
+    side3 = centroid - node1;
+    tet_volume += calculate_tet_volume_using_sides(side0, side2, side3);
+
+    //032
+    side2 = node2 - node0;
+    side0 = node3 - node0;
+    side3 = centroid - node0;
+    tet_volume += calculate_tet_volume_using_sides(side0, side2, side3);
   }
-  else
-  {   
-    VerdictVector tet_pts[15];
 
-    //create a vector for each point
-    for (int k = 0; k < num_nodes; k++)    
-      tet_pts[k].set(coordinates[k][0], coordinates[k][1], coordinates[k][2]);    
+  return tet_volume;
+}
 
-    //determine center point of the higher-order nodes      
-    VerdictVector centroid(0, 0, 0);
-    for( int k=4; k<num_nodes; k++ )
-      centroid += VerdictVector(coordinates[k][0], coordinates[k][1], coordinates[k][2]);
-    centroid /= (num_nodes - 4);
+//! the volume of a quadratic tet
+template <>
+double tet_volume<10>( double coordinates[][3] )
+{
+  VerdictVector side0, side2, side3;
+  VerdictVector tet_pts[10];
+  VerdictVector centroid;
+  tet_higher_order_points<10>( coordinates, tet_pts, centroid );
 
-    if (8 == num_nodes)
-    {
-      double tet_volume = 0;
+  double tet_volume = 0;
 
-      int tet_face_conn[4][4] = 
-      {
-        {0,2,1,4},
-        {0,1,3,7},
-        {1,2,3,5},
-        {0,3,2,6}
-      };
-
-      for (int i = 0; i<4; i++)
-      {        
-        VerdictVector &node0 = tet_pts[tet_face_conn[i][0]];
-        VerdictVector &node1 = tet_pts[tet_face_conn[i][1]];
-        VerdictVector &node2 = tet_pts[tet_face_conn[i][2]];
-        VerdictVector &node3 = tet_pts[tet_face_conn[i][3]];
-
-        //012
-        side2 = node3 - node0;
-        side0 = node1 - node0;
-        side3 = centroid - node0;
-        tet_volume += calculate_tet_volume_using_sides(side0, side2, side3);
-
-        //123
-        side2 = node3 - node1;
-        side0 = node2 - node1;
-        side3 = centroid - node1;
-        tet_volume += calculate_tet_volume_using_sides(side0, side2, side3);
-
-        //032
-        side2 = node2 - node0;
-        side0 = node3 - node0;
-        side3 = centroid - node0;
-        tet_volume += calculate_tet_volume_using_sides(side0, side2, side3);
-      }
+  int tet_face_conn[4][6] = 
+  {
+    {0,2,1,6,5,4},
+    {0,1,3,4,8,7},
+    {1,2,3,5,9,8},
+    {0,3,2,7,9,6}
+  };
 
-      return tet_volume;
-    }
-    if (10 == num_nodes)
-    {
-      double tet_volume = 0;
+  for (int i = 0; i<4; i++)
+  {        
+    VerdictVector &node0 = tet_pts[tet_face_conn[i][0]];
+    VerdictVector &node1 = tet_pts[tet_face_conn[i][1]];
+    VerdictVector &node2 = tet_pts[tet_face_conn[i][2]];
+    VerdictVector &node3 = tet_pts[tet_face_conn[i][3]];
+    VerdictVector &node4 = tet_pts[tet_face_conn[i][4]];
+    VerdictVector &node5 = tet_pts[tet_face_conn[i][5]];
+
+    //053
+    side2 = node5 - node0;
+    side0 = node3 - node0;
+    side3 = centroid - node0;
+    tet_volume += calculate_tet_volume_using_sides(side0, side2, side3);        
+
+    //134
+    side2 = node3 - node1;
+    side0 = node4 - node1;
+    side3 = centroid - node1;
+    tet_volume += calculate_tet_volume_using_sides(side0, side2, side3);        
+
+    //254
+    side2 = node4 - node2;
+    side0 = node5 - node2;
+    side3 = centroid - node2;
+    tet_volume += calculate_tet_volume_using_sides(side0, side2, side3);        
+
+    //345
+    side2 = node5 - node3;
+    side0 = node4 - node3;
+    side3 = centroid - node3;
+    tet_volume += calculate_tet_volume_using_sides(side0, side2, side3);
+  }
 
-      int tet_face_conn[4][6] = 
-      {
-        {0,2,1,6,5,4},
-        {0,1,3,4,8,7},
-        {1,2,3,5,9,8},
-        {0,3,2,7,9,6}
-      };
-
-      for (int i = 0; i<4; i++)
-      {        
-        VerdictVector &node0 = tet_pts[tet_face_conn[i][0]];
-        VerdictVector &node1 = tet_pts[tet_face_conn[i][1]];
-        VerdictVector &node2 = tet_pts[tet_face_conn[i][2]];
-        VerdictVector &node3 = tet_pts[tet_face_conn[i][3]];
-        VerdictVector &node4 = tet_pts[tet_face_conn[i][4]];
-        VerdictVector &node5 = tet_pts[tet_face_conn[i][5]];
-
-        //053
-        side2 = node5 - node0;
-        side0 = node3 - node0;
-        side3 = centroid - node0;
-        tet_volume += calculate_tet_volume_using_sides(side0, side2, side3);        
-
-        //134
-        side2 = node3 - node1;
-        side0 = node4 - node1;
-        side3 = centroid - node1;
-        tet_volume += calculate_tet_volume_using_sides(side0, side2, side3);        
-
-        //254
-        side2 = node4 - node2;
-        side0 = node5 - node2;
-        side3 = centroid - node2;
-        tet_volume += calculate_tet_volume_using_sides(side0, side2, side3);        
-
-        //345
-        side2 = node5 - node3;
-        side0 = node4 - node3;
-        side3 = centroid - node3;
-        tet_volume += calculate_tet_volume_using_sides(side0, side2, side3);
-      }
+  return tet_volume;
+}
 
-      return tet_volume;
-    }
-    if ( num_nodes >= 14)
-    {
-      double tet_volume = 0;
+//! the volume of a tet with a node on each edge and each face
+template <>
+double tet_volume<14>( double coordinates[][3] )
+{
+  return tet_volume_with_face_nodes<14>( coordinates );
+}
 
-      int tet_face_conn[4][7] = 
-      {
-        {0,3,2,7,9,6,12},
-        {0,2,1,6,5,4,10},
-        {0,1,3,4,8,7,13},
-        {1,2,3,5,9,8,11}
-      };
+//! the volume of a tet with a node on each edge and each face, and one at the center
+template <>
+double tet_volume<15>( double coordinates[][3] )
+{
+  return tet_volume_with_face_nodes<15>( coordinates );
+}
 
-      if (num_nodes == 15)
-      {
-        tet_face_conn[0][6]++;
-        tet_face_conn[1][6]++;
-        tet_face_conn[2][6]++;
-        tet_face_conn[3][6]++;
-      }
+} // namespace fixed
 
-      for (int i = 0; i<4; i++)
-      {        
-        VerdictVector &node0 = tet_pts[tet_face_conn[i][0]];
-        VerdictVector &node1 = tet_pts[tet_face_conn[i][1]];
-        VerdictVector &node2 = tet_pts[tet_face_conn[i][2]];
-        VerdictVector &node3 = tet_pts[tet_face_conn[i][3]];
-        VerdictVector &node4 = tet_pts[tet_face_conn[i][4]];
-        VerdictVector &node5 = tet_pts[tet_face_conn[i][5]];
-        VerdictVector &node6 = tet_pts[tet_face_conn[i][6]];
-
-        //056
-        side2 = node5 - node0;
-        side0 = node6 - node0;
-        side3 = centroid - node0;
-        tet_volume += calculate_tet_volume_using_sides(side0, side2, side3);        
-
-        //063
-        side2 = node6 - node0;
-        side0 = node3 - node0;
-        side3 = centroid - node0;
-        tet_volume += calculate_tet_volume_using_sides(side0, side2, side3);        
-
-        //136
-        side2 = node3 - node1;
-        side0 = node6 - node1;
-        side3 = centroid - node1;
-        tet_volume += calculate_tet_volume_using_sides(side0, side2, side3);        
-
-        //164
-        side2 = node6 - node1;
-        side0 = node4 - node1;
-        side3 = centroid - node1;
-        tet_volume += calculate_tet_volume_using_sides(side0, side2, side3);
-        
-        //246
-        side2 = node4 - node2;
-        side0 = node6 - node2;
-        side3 = centroid - node2;
-        tet_volume += calculate_tet_volume_using_sides(side0, side2, side3);
-        
-        //265
-        side2 = node6 - node2;
-        side0 = node5 - node2;
-        side3 = centroid - node2;
-        tet_volume += calculate_tet_volume_using_sides(side0, side2, side3);
-      }
+/*!
+  the volume of a tet
 
-      return tet_volume;
-    }
+  1/6 * jacobian at a corner node; 0 for node counts other than 4, 8,
+  10, 14 and 15
+*/
+double tet_volume( int num_nodes, double coordinates[][3] )
+{
+  VERDICT_INSTRUMENT_METRIC( tet_volume );
+  switch ( num_nodes )
+  {
+    case 4:  return fixed::tet_volume<4>( coordinates );
+    case 8:  return fixed::tet_volume<8>( coordinates );
+    case 10: return fixed::tet_volume<10>( coordinates );
+    case 14: return fixed::tet_volume<14>( coordinates );
+    case 15: return fixed::tet_volume<15>( coordinates );
+    default: return 0;
   }
-  return 0;
 }
 
 /*!
@@ -1182,44 +1216,52 @@ double tet_volume( int num_nodes, double coordinates[][3] )
 */
 double tet_condition( int /*num_nodes*/, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( tet_condition );
+  TetInvariants tet;
+  tet_invariants( coordinates, tet );
+  return tet_condition( tet );
+}
 
-  double condition, term1, term2, det;
-  const double rt6 = sqrt(6.0);
-
-  VerdictVector side0, side2, side3;
 
-  side0.set(coordinates[1][0] - coordinates[0][0],
-            coordinates[1][1] - coordinates[0][1],
-            coordinates[1][2] - coordinates[0][2]);
-
-  side2.set(coordinates[0][0] - coordinates[2][0],
-            coordinates[0][1] - coordinates[2][1],
-            coordinates[0][2] - coordinates[2][2]);
+namespace fixed
+{
 
-  side3.set(coordinates[3][0] - coordinates[0][0],
-            coordinates[3][1] - coordinates[0][1],
-            coordinates[3][2] - coordinates[0][2]);
+//! the jacobian of a 15 node tet: the minimum determinant at the nodes
+template <>
+double tet_jacobian<15>( double coordinates[][3] )
+{
+  const NodalGradients<15> &gradients = tet15_nodal_gradients();
+  double min_determinant = VERDICT_DBL_MAX;
+
+  double determinants[15];
+  nodal_jacobian_determinants( gradients, coordinates, determinants );
+  for(int i=0; i<15; i++)
+    min_determinant = std::min(determinants[i], min_determinant);
+  return min_determinant;
+}
 
-  VerdictVector c_1, c_2, c_3;
+//! the jacobian of a linear tet
+template <>
+double tet_jacobian<4>( double coordinates[][3] )
+{
+  VerdictVector side0, side2, side3;
 
-  c_1 = side0;
-  c_2 = (-2*side2-side0)/rt3;
-  c_3 = (3*side3+side2-side0)/rt6;
+  side0.set( coordinates[1][0] - coordinates[0][0],
+             coordinates[1][1] - coordinates[0][1],
+             coordinates[1][2] - coordinates[0][2] );
 
-  term1 = c_1 % c_1 + c_2 % c_2 + c_3 % c_3;
-  term2 = ( c_1 * c_2 ) % ( c_1 * c_2 ) +
-          ( c_2 * c_3 ) % ( c_2 * c_3 ) +
-          ( c_1 * c_3 ) % ( c_1 * c_3 );
-  det = c_1 % ( c_2 * c_3 );
+  side2.set( coordinates[0][0] - coordinates[2][0],
+             coordinates[0][1] - coordinates[2][1],
+             coordinates[0][2] - coordinates[2][2] );
 
-  if ( fabs( det ) <= VERDICT_DBL_MIN )
-    return VERDICT_DBL_MAX;
-  else
-    condition = sqrt( term1 * term2 ) /(3.0* det);
+  side3.set( coordinates[3][0] - coordinates[0][0],
+             coordinates[3][1] - coordinates[0][1],
+             coordinates[3][2] - coordinates[0][2] );
 
-  return (double)condition;
+  return (double)(side3 % (side2 * side0));
 }
 
+} // namespace fixed
 
 /*!
   the jacobian of a tet
@@ -1228,53 +1270,42 @@ double tet_condition( int /*num_nodes*/, double coordinates[][3] )
 */
 double tet_jacobian( int num_nodes, double coordinates[][3] )
 {
-  if(num_nodes == 15)
-  {
-    double dhdr[15];
-    double dhds[15];
-    double dhdt[15];
-    double min_determinant = VERDICT_DBL_MAX;
-
-    for(int i=0; i<15; i++)
-    {
-      TET15_gradients_of_the_shape_functions_for_R_S_T(TET15_node_local_coord[i], dhdr, dhds, dhdt);
-      double jacobian[3][3] = {{0,0,0},{0,0,0},{0,0,0}};
-
-      for(int j=0; j<15; j++)
-      {
-        jacobian[0][0]+=coordinates[j][0]*dhdr[j];
-        jacobian[0][1]+=coordinates[j][0]*dhds[j];
-        jacobian[0][2]+=coordinates[j][0]*dhdt[j];
-        jacobian[1][0]+=coordinates[j][1]*dhdr[j];
-        jacobian[1][1]+=coordinates[j][1]*dhds[j];
-        jacobian[1][2]+=coordinates[j][1]*dhdt[j];
-        jacobian[2][0]+=coordinates[j][2]*dhdr[j];
-        jacobian[2][1]+=coordinates[j][2]*dhds[j];
-        jacobian[2][2]+=coordinates[j][2]*dhdt[j];
-      }
-      double det = (VerdictVector(jacobian[0]) * VerdictVector(jacobian[1])) % VerdictVector(jacobian[2]);
-      min_determinant = std::min(det, min_determinant);
-    }
-    return min_determinant;
-  }
-  else
-  {
-    VerdictVector side0, side2, side3;
+  VERDICT_INSTRUMENT_METRIC( tet_jacobian );
+  if ( num_nodes == 15 )
+    return fixed::tet_jacobian<15>( coordinates );
+  return fixed::tet_jacobian<4>( coordinates );
+}
 
-    side0.set( coordinates[1][0] - coordinates[0][0],
-               coordinates[1][1] - coordinates[0][1],
-               coordinates[1][2] - coordinates[0][2] );
+//! the linear shape functions of the corners of a tet
+static void tet4_linear_shape_functions( const double rst[3], double h[4] )
+{
+  h[0] = 1 - rst[0] - rst[1] - rst[2];
+  h[1] = rst[0];
+  h[2] = rst[1];
+  h[3] = rst[2];
+}
 
-    side2.set( coordinates[0][0] - coordinates[2][0],
-               coordinates[0][1] - coordinates[2][1],
-               coordinates[0][2] - coordinates[2][2] );
+//! the bounds of the tet15 jacobian estimate, tabulated on first use
+static const NodalJacobianBounds<15, 4> &tet15_jacobian_bounds()
+{
+  static const NodalJacobianBounds<15, 4> bounds( tet15_nodal_gradients(), tet4_linear_shape_functions,
+                                                  TET15_node_local_coord );
+  return bounds;
+}
 
-    side3.set( coordinates[3][0] - coordinates[0][0],
-               coordinates[3][1] - coordinates[0][1],
-               coordinates[3][2] - coordinates[0][2] );
+/*!
+  estimate of the jacobian of a tet
 
-    return (double)(side3 % (side2 * side0));
-  }
+  The jacobian of the linear tet of the corners, which the offsets of the
+  other 11 nodes bound
+*/
+void tet_jacobian_estimate( int num_nodes, double coordinates[][3], MetricEstimate &estimate )
+{
+  VERDICT_INSTRUMENT_METRIC( tet_jacobian_estimate );
+  if ( num_nodes == 15 )
+    nodal_jacobian_estimate( tet15_jacobian_bounds(), coordinates, estimate );
+  else
+    estimate.value = estimate.lower = estimate.upper = fixed::tet_jacobian<4>( coordinates );
 }
 
 
@@ -1285,51 +1316,27 @@ double tet_jacobian( int num_nodes, double coordinates[][3] )
 */
 double tet_shape( int /*num_nodes*/, double coordinates[][3] )
 {
-
-   VerdictVector edge0, edge2, edge3;
-
-  edge0.set(coordinates[1][0] - coordinates[0][0],
-            coordinates[1][1] - coordinates[0][1],
-            coordinates[1][2] - coordinates[0][2]);
-
-  edge2.set(coordinates[0][0] - coordinates[2][0],
-            coordinates[0][1] - coordinates[2][1],
-            coordinates[0][2] - coordinates[2][2]);
-
-  edge3.set(coordinates[3][0] - coordinates[0][0],
-            coordinates[3][1] - coordinates[0][1],
-            coordinates[3][2] - coordinates[0][2]);
-
-  double jacobian = edge3 % (edge2 * edge0);
-  if(jacobian < VERDICT_DBL_MIN){
-    return (double)0.0;
-  }
-  double num = 3 * pow( root_of_2 * jacobian, two_thirds );
-  double den = 1.5*(edge0%edge0  + edge2%edge2  + edge3%edge3)-
-                   (edge0%-edge2 + -edge2%edge3 + edge3%edge0);
-
-  if ( den < VERDICT_DBL_MIN )
-    return (double)0.0;
-
-  double shape = num / den;
-  if (shape < 0) shape = 0;
-  return fix_range(shape);
+  VERDICT_INSTRUMENT_METRIC( tet_shape );
+  TetInvariants tet;
+  tet_invariants( coordinates, tet );
+  return tet_shape( tet );
 }
 
-/*!
-  the relative size of a tet
+double tet_size_measure( double coordinates[][3] )
+{
+  return tet_volume(4, coordinates);
+}
 
-  Min(J,1/J), where J is the determinant of the weighted Jacobian matrix
-*/
-double tet_relative_size_squared( int /*num_nodes*/, double coordinates[][3], double average_tet_volume )
+double tet_size_weight( double average_tet_volume )
 {
-  double size;
   VerdictVector w1, w2, w3;
   tet_get_weight(w1,w2,w3, average_tet_volume);
-  double avg_volume = (w1 % (w2 *w3))/6.0;
-
-  double volume = tet_volume(4, coordinates);
+  return (w1 % (w2 *w3))/6.0;
+}
 
+double tet_relative_size( double volume, double avg_volume )
+{
+  double size;
   if( avg_volume < VERDICT_DBL_MIN )
     return 0.0;
   else
@@ -1343,6 +1350,17 @@ double tet_relative_size_squared( int /*num_nodes*/, double coordinates[][3], do
   return (double)(size*size);
 }
 
+/*!
+  the relative size of a tet
+
+  Min(J,1/J), where J is the determinant of the weighted Jacobian matrix
+*/
+double tet_relative_size_squared( int /*num_nodes*/, double coordinates[][3], double average_tet_volume )
+{
+  VERDICT_INSTRUMENT_METRIC( tet_relative_size_squared );
+  return tet_relative_size( tet_size_measure( coordinates ), tet_size_weight( average_tet_volume ) );
+}
+
 
 /*!
   the shape and size of a tet
@@ -1351,6 +1369,7 @@ double tet_relative_size_squared( int /*num_nodes*/, double coordinates[][3], do
 */
 double tet_shape_and_size( int num_nodes, double coordinates[][3], double average_tet_volume )
 {
+  VERDICT_INSTRUMENT_METRIC( tet_shape_and_size );
 
   double shape, size;
   shape = tet_shape( num_nodes, coordinates );
@@ -1362,41 +1381,37 @@ double tet_shape_and_size( int num_nodes, double coordinates[][3], double averag
 
 
 
+namespace fixed
+{
+
 /*!
-  the distortion of a tet
+  the distortion of a linear tet
+
+  always 1, because straight edge tets are the target shape for tet
 */
-double tet_distortion( int num_nodes, double coordinates[][3] )
+template <>
+double tet_distortion<4>( double /*coordinates*/[][3] )
 {
+  return 1.0;
+}
 
+//! the distortion of a quadratic tet, with four integration points
+template <>
+double tet_distortion<10>( double coordinates[][3] )
+{
    double distortion = VERDICT_DBL_MAX;
-   int   number_of_gauss_points=0;
-   if (num_nodes < 10)
-      // for linear tet, the distortion is always 1 because
-      // straight edge tets are the target shape for tet
-      return 1.0;
-
-   else if (num_nodes >=10)
-      //use four integration points for quadratic tet
-      number_of_gauss_points = 4;
-
-   num_nodes = 10;
-
-   int number_dims = 3;
-   int total_number_of_gauss_points = number_of_gauss_points;
-   // use is_tri=1 to indicate this is for tet in 3D
-   int is_tri =1;
-
-   double shape_function[maxTotalNumberGaussPoints][maxNumberNodes];
-   double dndy1[maxTotalNumberGaussPoints][maxNumberNodes];
-   double dndy2[maxTotalNumberGaussPoints][maxNumberNodes];
-   double dndy3[maxTotalNumberGaussPoints][maxNumberNodes];
-   double weight[maxTotalNumberGaussPoints];
-
-   // create an object of GaussIntegration for tet
-   GaussIntegration gint;
-   gint.initialize(number_of_gauss_points,num_nodes, number_dims, is_tri);
-   gint.calculate_shape_function_3d_tet();
-   gint.get_shape_func(shape_function[0], dndy1[0], dndy2[0], dndy3[0],weight);
+   const int number_of_gauss_points = 4;
+   const int num_nodes = 10;
+
+   const int total_number_of_gauss_points = number_of_gauss_points;
+
+   // the shape function tables of the rule, computed once and shared
+   ScratchFrame scratch;
+   const GaussTables &tables = gauss_tables( GAUSS_TET, number_of_gauss_points, num_nodes, scratch );
+   const double (*dndy1)[maxNumberNodes] = tables.dndy1GaussPts;
+   const double (*dndy2)[maxNumberNodes] = tables.dndy2GaussPts;
+   const double (*dndy3)[maxNumberNodes] = tables.dndy3GaussPts;
+   const double* weight = tables.totalGaussWeight;
 
    // vector xxi is the derivative vector of coordinates w.r.t local xi coordinate in the
    // computation space
@@ -1435,14 +1450,9 @@ double tet_distortion( int num_nodes, double coordinates[][3] )
       }//element_volume is 6 times the actual volume
 
    // loop through all nodes
-   double dndy1_at_node[maxNumberNodes][maxNumberNodes];
-   double dndy2_at_node[maxNumberNodes][maxNumberNodes];
-   double dndy3_at_node[maxNumberNodes][maxNumberNodes];
-
-
-   gint.calculate_derivative_at_nodes_3d_tet( dndy1_at_node,
-                                                           dndy2_at_node,
-                                                           dndy3_at_node);
+   const double (*dndy1_at_node)[maxNumberNodes] = tables.dndy1AtNodes;
+   const double (*dndy2_at_node)[maxNumberNodes] = tables.dndy2AtNodes;
+   const double (*dndy3_at_node)[maxNumberNodes] = tables.dndy3AtNodes;
    int node_id;
    for (node_id=0;node_id<num_nodes; node_id++)
    {
@@ -1469,8 +1479,22 @@ double tet_distortion( int num_nodes, double coordinates[][3] )
    return fix_range(distortion);
 }
 
+} // namespace fixed
+
+/*!
+  the distortion of a tet
+*/
+double tet_distortion( int num_nodes, double coordinates[][3] )
+{
+  VERDICT_INSTRUMENT_METRIC( tet_distortion );
+  if (num_nodes < 10)
+    return fixed::tet_distortion<4>( coordinates );
+  return fixed::tet_distortion<10>( coordinates );
+}
+
 double tet_inradius( int num_nodes, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( tet_inradius );
   // avoid access beyond the end of the array
   if (num_nodes < 4)
     return 0.;
@@ -1478,56 +1502,11 @@ double tet_inradius( int num_nodes, double coordinates[][3] )
   if (num_nodes == 10)
     return tet10_characteristic_length( coordinates );
   
-  //area1 (0,1,2)
-  double a1 = verdict::tri_area(3, coordinates);
-
-  //area2 (0,3,1)
-  double tmp_coords[3][3];
-  tmp_coords[0][0] = coordinates[0][0];
-  tmp_coords[0][1] = coordinates[0][1];
-  tmp_coords[0][2] = coordinates[0][2];
-
-  tmp_coords[1][0] = coordinates[3][0];
-  tmp_coords[1][1] = coordinates[3][1];
-  tmp_coords[1][2] = coordinates[3][2];
-
-  tmp_coords[2][0] = coordinates[1][0];
-  tmp_coords[2][1] = coordinates[1][1];
-  tmp_coords[2][2] = coordinates[1][2];
-
-  double a2 = verdict::tri_area(3, tmp_coords);
-
-  //area3 (0,2,3)
-  tmp_coords[1][0] = coordinates[2][0];
-  tmp_coords[1][1] = coordinates[2][1];
-  tmp_coords[1][2] = coordinates[2][2];
-
-  tmp_coords[2][0] = coordinates[3][0];
-  tmp_coords[2][1] = coordinates[3][1];
-  tmp_coords[2][2] = coordinates[3][2];
-
-  double a3 = verdict::tri_area(3, tmp_coords);
-
-  //area4 (1,3,2)
-  tmp_coords[0][0] = coordinates[1][0];
-  tmp_coords[0][1] = coordinates[1][1];
-  tmp_coords[0][2] = coordinates[1][2];
-
-  tmp_coords[1][0] = coordinates[3][0];
-  tmp_coords[1][1] = coordinates[3][1];
-  tmp_coords[1][2] = coordinates[3][2];
-
-  tmp_coords[2][0] = coordinates[2][0];
-  tmp_coords[2][1] = coordinates[2][1];
-  tmp_coords[2][2] = coordinates[2][2];
-
-  double a4 = verdict::tri_area(3, tmp_coords);
-
-  double tet_volume = verdict::tet_volume(4, coordinates);
-
-  double inradius = 3*tet_volume/(a1 + a2 + a3 + a4);
-
-  return inradius;
+  // 3 V / surface area
+  TetInvariants tet;
+  tet_invariants( coordinates, tet );
+  tet_face_normals( tet );
+  return tet.jacobian / tet_twice_surface_area( tet );
 }
 
 double tet_timestep( int num_nodes, double coordinates[][3], 
@@ -1535,16 +1514,35 @@ double tet_timestep( int num_nodes, double coordinates[][3],
                      double poissons_ratio,
                      double youngs_modulus )
 {
+  VERDICT_INSTRUMENT_METRIC( tet_timestep );
   double char_length = 0;
   if( 10 == num_nodes )
     char_length = 2*tet10_characteristic_length( coordinates );
   else
     char_length = 2*tet_inradius( num_nodes, coordinates );
   
-  double M = youngs_modulus*(1 - poissons_ratio) / ((1 - 2 * poissons_ratio)*(1 + poissons_ratio));
-  double denominator = sqrt(M / density);
+  return char_length / timestep_wave_speed( density, poissons_ratio, youngs_modulus );
+}
 
-  return char_length / denominator;
+double tet_timestep_length( int num_nodes, double coordinates[][3], bool &inverted )
+{
+  inverted = false;
+  if( num_nodes < 4 )
+    return 0.;
+
+  // the corner jacobian gives both the inversion and the inradius of a linear tet
+  TetInvariants tet;
+  tet_invariants( coordinates, tet );
+  inverted = !( tet.jacobian > 0 );
+  if( 10 == num_nodes )
+  {
+    const double char_length = 2*tet10_characteristic_length( coordinates );
+    // an inverted subtet has a negative inradius
+    inverted = inverted || !( char_length > 0 );
+    return char_length;
+  }
+  tet_face_normals( tet );
+  return 2*( tet.jacobian / tet_twice_surface_area( tet ) );
 }
 
 VerdictVector tet10_auxillary_node_coordinate(double coordinates[][3] )
@@ -1615,21 +1613,10 @@ double tet10_characteristic_length( double coordinates[][3])
 }
 double calculate_tet4_outer_radius(double coordinates[][3] )
 {
-    verdict::VerdictVector nE[4];
-     for(int i{0};i<4;i++)
-         nE[i].set(coordinates[i]);
-
-    double aC = (nE[1] - nE[0]).length();
-    double bC = (nE[2] - nE[0]).length();
-    double cC = (nE[3] - nE[0]).length();
-    double AC = (nE[3] - nE[2]).length();
-    double BC = (nE[3] - nE[1]).length();
-    double CC = (nE[2] - nE[1]).length();
-    double VP = ((nE[1] - nE[0])*(nE[2] - nE[0]))%(nE[3] - nE[0]) / 6;
-    double outer_radius = sqrt((aC * AC + bC * BC + cC * CC) *
-    (aC * AC + bC * BC - cC * CC) * (aC * AC - bC * BC + cC * CC) * (-aC * AC + bC * BC + cC * CC)) / 24 / VP;
-
-    return outer_radius;
+  TetInvariants tet;
+  tet_invariants( coordinates, tet );
+  tet_face_normals( tet );
+  return tet_circumradius( tet );
 }
   
 
@@ -1674,6 +1661,7 @@ double tet4_normalized_inradius(double coordinates[][3] )
 
 double tet_normalized_inradius(int num_nodes, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( tet_normalized_inradius );
   if(num_nodes==4)
     return tet4_normalized_inradius(coordinates);
   else if(num_nodes>=10)
@@ -1681,45 +1669,66 @@ double tet_normalized_inradius(int num_nodes, double coordinates[][3] )
   return 0.0;
 }
 
-double tet_mean_ratio( int num_nodes, double coordinates[][3] )
+double tet_mean_ratio( int /*num_nodes*/, double coordinates[][3] )
+{
+  VERDICT_INSTRUMENT_METRIC( tet_mean_ratio );
+  TetInvariants tet;
+  tet_invariants( coordinates, tet );
+  return tet_mean_ratio( tet );
+}
+
+/*!
+  several metrics of a tet in one pass
+
+  Every metric goes through the same TetInvariants helper as its single
+  metric function, so the results are identical, but the edge vectors,
+  their squared lengths and the jacobian are only formed once.
+*/
+void tet_quality( int num_nodes, double coordinates[][3],
+                  unsigned int metrics, TetQuality &quality )
 {
-    const VerdictVector side0(coordinates[1][0] - coordinates[0][0],
-                              coordinates[1][1] - coordinates[0][1],
-                              coordinates[1][2] - coordinates[0][2]);
+  VERDICT_INSTRUMENT_METRIC( tet_quality );
+  TetInvariants tet;
+  tet_invariants( coordinates, tet );
 
-    const VerdictVector side2(coordinates[0][0] - coordinates[2][0],
-                              coordinates[0][1] - coordinates[2][1],
-                              coordinates[0][2] - coordinates[2][2]);
+  if ( metrics & TET_VOLUME )
+  {
+    // the higher order volumes are sums over sub-tets
+    if ( num_nodes == 4 )
+      quality.volume = tet.jacobian / 6.0;
+    else
+      quality.volume = tet_volume( num_nodes, coordinates );
+  }
 
-    const VerdictVector side3(coordinates[3][0] - coordinates[0][0],
-                              coordinates[3][1] - coordinates[0][1],
-                              coordinates[3][2] - coordinates[0][2]);
+  if ( metrics & TET_JACOBIAN )
+  {
+    if ( num_nodes == 15 )
+      quality.jacobian = tet_jacobian( num_nodes, coordinates );
+    else
+      quality.jacobian = tet.jacobian;
+  }
 
-    const double tetVolume = calculate_tet_volume_using_sides(side0, side2, side3);
-    if( fabs( tetVolume ) < VERDICT_DBL_MIN )
-        return 0.0;
+  if ( metrics & TET_SCALED_JACOBIAN )
+    quality.scaled_jacobian = tet_scaled_jacobian( tet );
 
-    const VerdictVector side1(coordinates[2][0] - coordinates[1][0],
-                              coordinates[2][1] - coordinates[1][1],
-                              coordinates[2][2] - coordinates[1][2]);
+  if ( metrics & TET_SHAPE )
+    quality.shape = tet_shape( tet );
 
-    const VerdictVector side4(coordinates[3][0] - coordinates[1][0],
-                              coordinates[3][1] - coordinates[1][1],
-                              coordinates[3][2] - coordinates[1][2]);
+  if ( metrics & TET_MEAN_RATIO )
+    quality.mean_ratio = tet_mean_ratio( tet );
 
-    const VerdictVector side5(coordinates[3][0] - coordinates[2][0],
-                              coordinates[3][1] - coordinates[2][1],
-                              coordinates[3][2] - coordinates[2][2]);
+  if ( metrics & TET_CONDITION )
+    quality.condition = tet_condition( tet );
 
-    const double side0_length_squared = side0.length_squared();
-    const double side1_length_squared = side1.length_squared();
-    const double side2_length_squared = side2.length_squared();
-    const double side3_length_squared = side3.length_squared();
-    const double side4_length_squared = side4.length_squared();
-    const double side5_length_squared = side5.length_squared();
+  if ( metrics & TET_EDGE_RATIO )
+    quality.edge_ratio = tet_edge_ratio( tet );
 
-    const int sign = tetVolume < 0. ? -1 : 1;
-    return sign * 12. * std::pow(3.*fabs(tetVolume), 2./3.) / (side0_length_squared + side1_length_squared + side2_length_squared + side3_length_squared + side4_length_squared + side5_length_squared);
+  if ( metrics & TET_ASPECT_RATIO )
+  {
+    tet_face_normals( tet );
+    quality.aspect_ratio = tet_aspect_ratio( tet );
+  }
 }
 
+
 } // namespace verdict
@@ -0,0 +1,52 @@
+/*=========================================================================
+
+  Module:    V_TimestepMetric.hpp
+
+  Copyright 2003,2006,2019 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+  Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government retains certain rights in this software.
+
+  See LICENSE for details.
+
+=========================================================================*/
+
+/*
+ *
+ * V_TimestepMetric.hpp contains the two factors of the timestep metrics:
+ *                      the characteristic length of an element, found
+ *                      together with whether the element is inverted,
+ *                      and the wave speed of its material.  The mesh-level
+ *                      timestep function evaluates both in one pass
+ *                      instead of a timestep pass and a scaled jacobian
+ *                      pass over the same coordinates.
+ *
+ * This file is part of VERDICT
+ *
+ */
+
+#ifndef VERDICT_TIMESTEP_METRIC_HPP
+#define VERDICT_TIMESTEP_METRIC_HPP
+
+#include "verdict.h"
+
+#include <math.h>
+
+namespace VERDICT_NAMESPACE
+{
+
+//! the dilatational wave speed, sqrt(M / density), of hex_timestep and tet_timestep
+inline double timestep_wave_speed( double density, double poissons_ratio, double youngs_modulus )
+{
+  double M = youngs_modulus*(1 - poissons_ratio) / ((1 - 2 * poissons_ratio)*(1 + poissons_ratio));
+  return sqrt(M / density);
+}
+
+//! hex_dimension; inverted tells whether a corner jacobian of the linear hex is not positive
+double hex_timestep_length( double coordinates[][3], bool &inverted );
+
+//! the char_length of tet_timestep; inverted tells whether the jacobian of the
+//! corners, or for 10 nodes the inradius of a subtet, is not positive
+double tet_timestep_length( int num_nodes, double coordinates[][3], bool &inverted );
+
+} // namespace verdict
+
+#endif
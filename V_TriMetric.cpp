@@ -20,12 +20,17 @@
 
 
 #include "verdict.h"
+#include "verdict_fixed.h"
 #include "verdict_defines.hpp"
 #include "V_GaussIntegration.hpp"
 #include "VerdictVector.hpp"
+#include "V_SizeMetric.hpp"
+#include "V_Instrumentation.hpp"
+#include "V_SimplexInvariants.hpp"
 #include <memory.h>
 #include <stddef.h>
 #include <algorithm>
+#include <type_traits>
 
 namespace VERDICT_NAMESPACE
 {
@@ -56,6 +61,32 @@ static int tri_get_weight ( double &m11, double &m21,
   return 1;
 }
 
+void tri_invariants( double coordinates[][3], TriInvariants &tri )
+{
+  tri.side[0].set( coordinates[1][0] - coordinates[0][0],
+                   coordinates[1][1] - coordinates[0][1],
+                   coordinates[1][2] - coordinates[0][2] );
+  tri.side[1].set( coordinates[2][0] - coordinates[1][0],
+                   coordinates[2][1] - coordinates[1][1],
+                   coordinates[2][2] - coordinates[1][2] );
+  tri.side[2].set( coordinates[0][0] - coordinates[2][0],
+                   coordinates[0][1] - coordinates[2][1],
+                   coordinates[0][2] - coordinates[2][2] );
+
+  for ( int i = 0; i < 3; i++ )
+    tri.length_squared[i] = tri.side[i].length_squared();
+
+  tri.normal = tri.side[0] * tri.side[1];
+  tri.normal_length_squared = tri.normal.length_squared();
+  tri.twice_area = sqrt( tri.normal_length_squared );
+}
+
+void tri_edge_lengths( TriInvariants &tri )
+{
+  for ( int i = 0; i < 3; i++ )
+    tri.length[i] = sqrt( tri.length_squared[i] );
+}
+
 /*!
    the edge ratio of a triangle
 
@@ -66,80 +97,28 @@ static int tri_get_weight ( double &m11, double &m21,
 */
 double tri_edge_ratio( int /*num_nodes*/, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( tri_edge_ratio );
 
-  // three vectors for each side 
-  VerdictVector a( coordinates[1][0] - coordinates[0][0],
-                   coordinates[1][1] - coordinates[0][1],
-                   coordinates[1][2] - coordinates[0][2] );
-  
-  VerdictVector b( coordinates[2][0] - coordinates[1][0],
-                   coordinates[2][1] - coordinates[1][1],
-                   coordinates[2][2] - coordinates[1][2] );
-  
-  VerdictVector c( coordinates[0][0] - coordinates[2][0],
-                   coordinates[0][1] - coordinates[2][1],
-                   coordinates[0][2] - coordinates[2][2] );
+  TriInvariants tri;
+  tri_invariants( coordinates, tri );
 
-  double a2 = a.length_squared();
-  double b2 = b.length_squared();
-  double c2 = c.length_squared();
- 
-  double m2, M2;
-  if ( a2 < b2 )
-    {
-      if ( b2 < c2 )
-        {
-          m2 = a2;
-          M2 = c2;
-        }
-      else // b2 <= a2
-        {
-          if ( a2 < c2 )
-            {
-              m2 = a2;
-              M2 = b2;
-            }
-          else // c2 <= a2
-            {
-              m2 = c2;
-              M2 = b2;
-            }
-        }
-    }
-  else // b2 <= a2
-    {
-      if ( a2 < c2 )
-        {
-          m2 = b2;
-          M2 = c2;
-        }
-      else // c2 <= a2
-        {
-          if ( b2 < c2 )
-            {
-              m2 = b2;
-              M2 = a2;
-            }
-          else // c2 <= b2
-            {
-              m2 = c2;
-              M2 = a2;
-            }
-        }
-    }
+  const double a2 = tri.length_squared[0];
+  const double b2 = tri.length_squared[1];
+  const double c2 = tri.length_squared[2];
+
+  double m2 = a2 < b2 ? a2 : b2;
+  m2 = m2 < c2 ? m2 : c2;
 
   if( m2 < VERDICT_DBL_MIN ) 
     return (double)VERDICT_DBL_MAX;
-  else
-  {
-    double edge_ratio;
-    edge_ratio = sqrt(M2 / m2);
-    
-    if( edge_ratio > 0 )
-      return (double) std::min( edge_ratio, VERDICT_DBL_MAX );
-    return (double) std::max( edge_ratio, -VERDICT_DBL_MAX );
-  }
 
+  double M2 = a2 > b2 ? a2 : b2;
+  M2 = M2 > c2 ? M2 : c2;
+
+  double edge_ratio = sqrt(M2 / m2);
+  if( edge_ratio > 0 )
+    return (double) std::min( edge_ratio, VERDICT_DBL_MAX );
+  return (double) std::max( edge_ratio, -VERDICT_DBL_MAX );
 }
 
 /*!
@@ -155,41 +134,26 @@ double tri_edge_ratio( int /*num_nodes*/, double coordinates[][3] )
 */
 double tri_aspect_ratio( int /*num_nodes*/, double coordinates[][3] )
 {
-  // three vectors for each side 
-  VerdictVector a( coordinates[1][0] - coordinates[0][0],
-                   coordinates[1][1] - coordinates[0][1],
-                   coordinates[1][2] - coordinates[0][2] );
-  
-  VerdictVector b( coordinates[2][0] - coordinates[1][0],
-                   coordinates[2][1] - coordinates[1][1],
-                   coordinates[2][2] - coordinates[1][2] );
-  
-  VerdictVector c( coordinates[0][0] - coordinates[2][0],
-                   coordinates[0][1] - coordinates[2][1],
-                   coordinates[0][2] - coordinates[2][2] );
+  VERDICT_INSTRUMENT_METRIC( tri_aspect_ratio );
+
+  TriInvariants tri;
+  tri_invariants( coordinates, tri );
+
+  if( tri.twice_area < VERDICT_DBL_MIN ) 
+    return (double)VERDICT_DBL_MAX;
 
-  double a1 = a.length();
-  double b1 = b.length();
-  double c1 = c.length();
+  tri_edge_lengths( tri );
+  const double a1 = tri.length[0];
+  const double b1 = tri.length[1];
+  const double c1 = tri.length[2];
  
   double hm = a1 > b1 ? a1 : b1;
   hm = hm > c1 ? hm : c1;
 
-  VerdictVector ab = a * b;
-  double denominator = ab.length();
-
-  if( denominator < VERDICT_DBL_MIN ) 
-    return (double)VERDICT_DBL_MAX;
-  else
-  {
-    double aspect_ratio;
-    aspect_ratio = aspect_ratio_normal_coeff * hm * (a1 + b1 + c1) / denominator;
-    
-    if( aspect_ratio > 0 )
-      return (double) std::min( aspect_ratio, VERDICT_DBL_MAX );
-    return (double) std::max( aspect_ratio, -VERDICT_DBL_MAX );
-  }
-
+  double aspect_ratio = aspect_ratio_normal_coeff * hm * (a1 + b1 + c1) / tri.twice_area;
+  if( aspect_ratio > 0 )
+    return (double) std::min( aspect_ratio, VERDICT_DBL_MAX );
+  return (double) std::max( aspect_ratio, -VERDICT_DBL_MAX );
 }
 
 /*!
@@ -204,33 +168,20 @@ double tri_aspect_ratio( int /*num_nodes*/, double coordinates[][3] )
 */
 double tri_radius_ratio( int /*num_nodes*/, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( tri_radius_ratio );
 
-  // three vectors for each side 
-  VerdictVector a( coordinates[1][0] - coordinates[0][0],
-                   coordinates[1][1] - coordinates[0][1],
-                   coordinates[1][2] - coordinates[0][2] );
-  
-  VerdictVector b( coordinates[2][0] - coordinates[1][0],
-                   coordinates[2][1] - coordinates[1][1],
-                   coordinates[2][2] - coordinates[1][2] );
-  
-  VerdictVector c( coordinates[0][0] - coordinates[2][0],
-                   coordinates[0][1] - coordinates[2][1],
-                   coordinates[0][2] - coordinates[2][2] );
+  TriInvariants tri;
+  tri_invariants( coordinates, tri );
 
-  double a1 = a.length();
-  double b1 = b.length();
-  double c1 = c.length();
- 
-  VerdictVector ab = a * b;
-  double denominator = ab.length_squared();
-
-  if( denominator < VERDICT_DBL_MIN ) 
+  if( tri.normal_length_squared < VERDICT_DBL_MIN ) 
     return (double)VERDICT_DBL_MAX;
 
-  double radius_ratio;
-  radius_ratio = .25 * a1 * b1 * c1 * ( a1 + b1 + c1 ) / denominator;
-  
+  tri_edge_lengths( tri );
+  const double a1 = tri.length[0];
+  const double b1 = tri.length[1];
+  const double c1 = tri.length[2];
+
+  double radius_ratio = .25 * a1 * b1 * c1 * ( a1 + b1 + c1 ) / tri.normal_length_squared;
   if( radius_ratio > 0 )
     return (double) std::min( radius_ratio, VERDICT_DBL_MAX );
   return (double) std::max( radius_ratio, -VERDICT_DBL_MAX );
@@ -249,31 +200,18 @@ double tri_radius_ratio( int /*num_nodes*/, double coordinates[][3] )
 
 double tri_aspect_frobenius( int /*num_nodes*/, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( tri_aspect_frobenius );
 
-  // three vectors for each side 
-  VerdictVector side1( coordinates[1][0] - coordinates[0][0],
-                       coordinates[1][1] - coordinates[0][1],
-                       coordinates[1][2] - coordinates[0][2] );
-  
-  VerdictVector side2( coordinates[2][0] - coordinates[1][0],
-                       coordinates[2][1] - coordinates[1][1],
-                       coordinates[2][2] - coordinates[1][2] );
-  
-  VerdictVector side3( coordinates[0][0] - coordinates[2][0],
-                       coordinates[0][1] - coordinates[2][1],
-                       coordinates[0][2] - coordinates[2][2] );
- 
-  //sum the lengths squared of each side
-  double srms = (side1.length_squared() + side2.length_squared() 
-      + side3.length_squared());
-  
-  // find two times the area of the triangle by cross product
-  double areaX2 = ((side1 * (-side3)).length());
+  TriInvariants tri;
+  tri_invariants( coordinates, tri );
 
-  if(areaX2 == 0.0)
+  if(tri.twice_area == 0.0)
     return (double)VERDICT_DBL_MAX;
  
-  double aspect = (double)(srms / (two_times_root_of_3 * (areaX2)));
+  //sum the lengths squared of each side
+  const double srms = tri.length_squared[0] + tri.length_squared[1] + tri.length_squared[2];
+
+  double aspect = (double)(srms / (two_times_root_of_3 * tri.twice_area));
   if( aspect > 0 )
     return (double) std::min( aspect, VERDICT_DBL_MAX );
   return (double) std::max( aspect, -VERDICT_DBL_MAX );
@@ -286,6 +224,7 @@ double tri_aspect_frobenius( int /*num_nodes*/, double coordinates[][3] )
 */
 double tri_area( int /*num_nodes*/, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( tri_area );
   // two vectors for two sides
   VerdictVector side1( coordinates[1][0] - coordinates[0][0],
                        coordinates[1][1] - coordinates[0][1],
@@ -316,6 +255,7 @@ double tri_area( int /*num_nodes*/, double coordinates[][3] )
 */
 double tri_minimum_angle( int /*num_nodes*/, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( tri_minimum_angle );
 
   // vectors for all the sides
   VerdictVector sides[4];
@@ -389,6 +329,7 @@ double tri_minimum_angle( int /*num_nodes*/, double coordinates[][3] )
 */
 double tri_maximum_angle( int /*num_nodes*/, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( tri_maximum_angle );
 
   // vectors for all the sides
   VerdictVector sides[4];
@@ -459,6 +400,7 @@ double tri_maximum_angle( int /*num_nodes*/, double coordinates[][3] )
 
 double tri_equiangle_skew( int num_nodes, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( tri_equiangle_skew );
   double min_angle=360.0;
   double max_angle=0.0;
 
@@ -483,6 +425,7 @@ double tri_equiangle_skew( int num_nodes, double coordinates[][3] )
 */
 double tri_condition( int /*num_nodes*/, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( tri_condition );
   VerdictVector v1(coordinates[1][0] - coordinates[0][0],
                    coordinates[1][1] - coordinates[0][1],
                    coordinates[1][2] - coordinates[0][2] );
@@ -509,6 +452,7 @@ double tri_condition( int /*num_nodes*/, double coordinates[][3] )
 */
 double tri_scaled_jacobian( int /*num_nodes*/, double coordinates[][3])
 {
+  VERDICT_INSTRUMENT_METRIC( tri_scaled_jacobian );
   VerdictVector first, second;
   double jacobian; 
   
@@ -554,6 +498,7 @@ double tri_scaled_jacobian( int /*num_nodes*/, double coordinates[][3])
 */
 double tri_shape( int num_nodes, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( tri_shape );
   double condition = tri_condition( num_nodes, coordinates );
 
   double shape;
@@ -568,22 +513,11 @@ double tri_shape( int num_nodes, double coordinates[][3] )
 }
 
 /*!
-  The relative size of a tri
-
-  Min(J,1/J) where J is the determinant of the weighted jacobian matrix.
+  twice the area of a tri, the size that tri_relative_size_squared compares
 */
-double tri_relative_size_squared( int /*num_nodes*/, double coordinates[][3], double average_tri_area )
+double tri_size_measure( double coordinates[][3] )
 {
-  double w11, w21, w12, w22;
-
   VerdictVector xxi, xet, tri_normal;
-  
-  tri_get_weight(w11,w21,w12,w22, average_tri_area);
-
-  double detw = determinant(w11,w21,w12,w22);
-
-  if(detw == 0.0)
-    return 0.0;
 
   xxi.set(coordinates[0][0] - coordinates[1][0],
     coordinates[0][1] - coordinates[1][1],
@@ -595,7 +529,18 @@ double tri_relative_size_squared( int /*num_nodes*/, double coordinates[][3], do
 
   tri_normal = xxi * xet;
 
-  double deta = tri_normal.length();
+  return tri_normal.length();
+}
+
+double tri_size_weight( double average_tri_area )
+{
+  double w11, w21, w12, w22;
+  tri_get_weight(w11,w21,w12,w22, average_tri_area);
+  return determinant(w11,w21,w12,w22);
+}
+
+double tri_relative_size( double deta, double detw )
+{
   if( deta == 0.0  || detw == 0.0 )
     return 0.0;
     
@@ -606,7 +551,22 @@ double tri_relative_size_squared( int /*num_nodes*/, double coordinates[][3], do
   if( rel_size > 0 )
     return (double) std::min( rel_size, VERDICT_DBL_MAX );
   return (double) std::max( rel_size, -VERDICT_DBL_MAX );
-  
+}
+
+/*!
+  The relative size of a tri
+
+  Min(J,1/J) where J is the determinant of the weighted jacobian matrix.
+*/
+double tri_relative_size_squared( int /*num_nodes*/, double coordinates[][3], double average_tri_area )
+{
+  VERDICT_INSTRUMENT_METRIC( tri_relative_size_squared );
+  double detw = tri_size_weight( average_tri_area );
+
+  if(detw == 0.0)
+    return 0.0;
+
+  return tri_relative_size( tri_size_measure( coordinates ), detw );
 }
 
 /*!
@@ -616,6 +576,7 @@ double tri_relative_size_squared( int /*num_nodes*/, double coordinates[][3], do
 */
 double tri_shape_and_size( int num_nodes, double coordinates[][3], double average_tri_area )
 {
+  VERDICT_INSTRUMENT_METRIC( tri_shape_and_size );
   double size, shape;  
 
   size = tri_relative_size_squared( num_nodes, coordinates, average_tri_area );
@@ -631,15 +592,17 @@ double tri_shape_and_size( int num_nodes, double coordinates[][3], double averag
 
 
 /*!
-  The distortion of a tri
-
-TODO:  make a short definition of the distortion and comment below
+  The distortion of a tri with num_nodes nodes over number_of_gauss_points
+  integration points.  The counts are either ints or, for the element
+  orders known when compiling, std::integral_constant, which fixes the
+  length of the loops over the nodes.
 */
-double tri_distortion( int num_nodes, double coordinates[][3] )
+template <class NodeCount, class GaussCount>
+static double tri_distortion_with( NodeCount num_nodes, GaussCount number_of_gauss_points,
+                                   double coordinates[][3] )
 {
-  
   double distortion;
-  int total_number_of_gauss_points=0;
+  const int total_number_of_gauss_points = number_of_gauss_points;
   VerdictVector  aa, bb, cc,normal_at_point, xin;
   double element_area = 0.;
   
@@ -654,32 +617,15 @@ double tri_distortion( int num_nodes, double coordinates[][3] )
   
   VerdictVector tri_normal = aa * bb;
   
-  int number_of_gauss_points=0;
-  if (num_nodes ==3)
-  {
-    distortion = 1.0;
-    return (double)distortion;
-  }
-  
-  else if (num_nodes ==6)
-  {
-    total_number_of_gauss_points = 6;
-    number_of_gauss_points = 6;
-  }
-  
   distortion = VERDICT_DBL_MAX;
-  double shape_function[maxTotalNumberGaussPoints][maxNumberNodes];
-  double dndy1[maxTotalNumberGaussPoints][maxNumberNodes];
-  double dndy2[maxTotalNumberGaussPoints][maxNumberNodes];
-  double weight[maxTotalNumberGaussPoints];
-  
-  //create an object of GaussIntegration
-  int number_dims = 2;
-  int is_tri = 1;
-  GaussIntegration gint;
-  gint.initialize(number_of_gauss_points,num_nodes, number_dims, is_tri);
-  gint.calculate_shape_function_2d_tri();
-  gint.get_shape_func(shape_function[0], dndy1[0], dndy2[0], weight);
+  // the shape function tables of the rule, computed once and shared;
+  // the node counts without a rule compute theirs into scratch memory
+  ScratchFrame scratch;
+  const GaussTables &tables = gauss_tables( GAUSS_TRI, number_of_gauss_points, num_nodes, scratch );
+  const double (*shape_function)[maxNumberNodes] = tables.shapeFunction;
+  const double (*dndy1)[maxNumberNodes] = tables.dndy1GaussPts;
+  const double (*dndy2)[maxNumberNodes] = tables.dndy2GaussPts;
+  const double* weight = tables.totalGaussWeight;
   
   // calculate element area
   int ife, ja;
@@ -700,11 +646,8 @@ double tri_distortion( int num_nodes, double coordinates[][3] )
   }
   
   element_area *= 0.8660254;
-  double dndy1_at_node[maxNumberNodes][maxNumberNodes];
-  double dndy2_at_node[maxNumberNodes][maxNumberNodes];
-  
-  
-  gint.calculate_derivative_at_nodes_2d_tri( dndy1_at_node,  dndy2_at_node);
+  const double (*dndy1_at_node)[maxNumberNodes] = tables.dndy1AtNodes;
+  const double (*dndy2_at_node)[maxNumberNodes] = tables.dndy2AtNodes;
   
   VerdictVector normal_at_nodes[7];
   
@@ -825,25 +768,48 @@ double tri_distortion( int num_nodes, double coordinates[][3] )
   return (double) std::max( distortion, -VERDICT_DBL_MAX );
 }
 
+namespace fixed
+{
+
+//! the distortion of a linear tri, which is always 1
+template <>
+double tri_distortion<3>( double /*coordinates*/[][3] )
+{
+  return 1.0;
+}
+
+//! the distortion of a quadratic tri, with 6 integration points
+template <>
+double tri_distortion<6>( double coordinates[][3] )
+{
+  return tri_distortion_with( std::integral_constant<int, 6>(), std::integral_constant<int, 6>(), coordinates );
+}
+
+} // namespace fixed
+
+/*!
+  The distortion of a tri
+
+TODO:  make a short definition of the distortion and comment below
+*/
+double tri_distortion( int num_nodes, double coordinates[][3] )
+{
+  VERDICT_INSTRUMENT_METRIC( tri_distortion );
+  if (num_nodes ==3)
+    return fixed::tri_distortion<3>( coordinates );
+  if (num_nodes ==6)
+    return fixed::tri_distortion<6>( coordinates );
+  // other node counts have no integration rule
+  return tri_distortion_with( num_nodes, 0, coordinates );
+}
+
 double tri_inradius(double coordinates[][3])
 {
-  double sp = 0.0;
-  VerdictVector sides[3];
-  for (int i=0; i<3; i++)
-  {
-    int j = (i+1)%3;
-    sides[i].set(coordinates[j][0] - coordinates[i][0],
-                 coordinates[j][1] - coordinates[i][1],
-                 coordinates[j][2] - coordinates[i][2]);
-    sp += sides[i].length();
-  }
-  sp /= 2.0;
-  
-  VerdictVector cross = sides[1] * sides[0];
-  double area = cross.length() / 2.0;
-  
-  double ir = area/sp;
-  return ir;
+  // area over the semi-perimeter
+  TriInvariants tri;
+  tri_invariants( coordinates, tri );
+  tri_edge_lengths( tri );
+  return tri.twice_area / ( tri.length[0] + tri.length[1] + tri.length[2] );
 }
   
 double tri6_min_inradius(double coordinates[][3])
@@ -869,26 +835,11 @@ double tri6_min_inradius(double coordinates[][3])
   
 double calculate_tri3_outer_radius(double coordinates[][3])
 {
-  double sp = 0.0;
-  VerdictVector sides[3];
-  double slen[3];
-  for (int i=0; i<3; i++)
-  {
-    int j = (i+1)%3;
-    sides[i].set(coordinates[j][0] - coordinates[i][0],
-                 coordinates[j][1] - coordinates[i][1],
-                 coordinates[j][2] - coordinates[i][2]);
-    slen[i] = sides[i].length();
-    sp += slen[i];
-  }
-  sp /= 2.0;
-  
-  VerdictVector cross = sides[1] * sides[0];
-  double area = cross.length() / 2.0;
-  double ir = area/sp;
-  
-  double cr = (slen[0]*slen[1]*slen[2]) / (4.0 * ir * sp);
-  return cr;
+  // the product of the sides over four times the area
+  TriInvariants tri;
+  tri_invariants( coordinates, tri );
+  tri_edge_lengths( tri );
+  return ( tri.length[0] * tri.length[1] * tri.length[2] ) / ( 2.0 * tri.twice_area );
 }
   
 double tri6_normalized_inradius(double coordinates[][3] )
@@ -927,6 +878,7 @@ double tri3_normalized_inradius(double coordinates[][3] )
   /* Currently supports tri 6 and 3.*/
 double tri_normalized_inradius( int num_nodes, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( tri_normalized_inradius );
   if(num_nodes==3)
     return tri3_normalized_inradius(coordinates);
   else if(num_nodes==6)
@@ -20,6 +20,7 @@
 
 
 #include "verdict.h"
+#include "verdict_fixed.h"
 #include "VerdictVector.hpp"
 #include <memory.h> 
 #include <algorithm>
@@ -27,6 +28,8 @@
 
 #include "verdict_defines.hpp"
 #include "V_GaussIntegration.hpp"
+#include "V_Instrumentation.hpp"
+#include "V_NodalJacobian.hpp"
 
 extern double tri_equiangle_skew( int num_nodes, double coordinates[][3] );
 extern double quad_equiangle_skew( int num_nodes, double coordinates[][3] );
@@ -40,6 +43,7 @@ void make_wedge_faces(double coordinates[][3], double tri1[][3], double tri2[][3
 
 static const double one_third = 1.0/3.0;
 static const double two_thirds = 2.0/3.0;
+static const double root_of_2 = sqrt(2.0);
 
 /*
    the wedge element
@@ -167,9 +171,17 @@ static void WEDGE21_gradients_of_the_shape_functions_for_RST(const double rst[3]
   dhdt[15]  = -2.0*27.0*rst[2]*RSM*RS;
 }
 
+//! the gradients of the shape functions at the first 15 nodes, tabulated on first use
+static const NodalGradients<21, 15> &wedge21_nodal_gradients()
+{
+  static const NodalGradients<21, 15> gradients( WEDGE21_gradients_of_the_shape_functions_for_RST, WEDGE21_node_local_coord );
+  return gradients;
+}
+
 
 double wedge_equiangle_skew( int num_nodes, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( wedge_equiangle_skew );
   double tri1[3][3];
   double tri2[3][3];
   double quad1[4][3];
@@ -206,6 +218,7 @@ double wedge_equiangle_skew( int num_nodes, double coordinates[][3] )
 
 double wedge_volume( int /*num_nodes*/, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( wedge_volume );
 
   // We need to divide the wedge into 11 tets.
   // This is a better solution than 3 tets or 3 hexes because
@@ -400,171 +413,255 @@ double wedge_volume( int /*num_nodes*/, double coordinates[][3] )
   return (double)volume;
 }
 
-/* Edge ratio
-   The edge ratio quality metric is the ratio of the longest to shortest edge of
-   a wedge.
-   q = L_max / L_min
+//! the other ends of the three edges at each corner, as vec1, vec2 and
+//! vec3 of the corner jacobian vec2 % (vec1 * vec3)
+static const int wedge_corner_nodes[6][3] =
+{
+  { 1, 3, 2 }, { 2, 4, 0 }, { 0, 5, 1 }, { 0, 4, 5 }, { 1, 5, 3 }, { 3, 4, 2 }
+};
 
-   Dimension : 1
-   Acceptable range : --
-   Normal range : [1,DBL_MAX]
-   Full range : [1,DBL_MAX]
-   q for right, unit wedge : 1
-   Reference : -
-   */
-double wedge_edge_ratio( int /*num_nodes*/, double coordinates[][3] )
+//! the nine edges, in the order of the edge ratio
+static const int wedge_edges[9][2] =
 {
-  VerdictVector a,b,c,d,e,f,g,h,i;
+  { 0, 1 }, { 1, 2 }, { 2, 0 }, { 3, 4 }, { 4, 5 }, { 5, 3 }, { 0, 3 }, { 1, 4 }, { 2, 5 }
+};
 
-  a.set( coordinates[1][0] - coordinates[0][0],
-      coordinates[1][1] - coordinates[0][1],
-      coordinates[1][2] - coordinates[0][2] );
+//! the quadrilateral faces, in the order of the stretch
+static const int wedge_quad_faces[3][4] =
+{
+  { 0, 1, 4, 3 }, { 1, 2, 5, 4 }, { 2, 0, 3, 5 }
+};
 
-  b.set( coordinates[2][0] - coordinates[1][0],
-      coordinates[2][1] - coordinates[1][1],
-      coordinates[2][2] - coordinates[1][2] );
+//! the corner tets of the aspect Frobenius
+static const int wedge_corner_tets[6][4] =
+{
+  { 0, 1, 2, 3 }, { 1, 2, 0, 4 }, { 2, 0, 1, 5 }, { 3, 5, 4, 0 }, { 4, 3, 5, 1 }, { 5, 4, 3, 2 }
+};
 
-  c.set( coordinates[0][0] - coordinates[2][0],
-      coordinates[0][1] - coordinates[2][1],
-      coordinates[0][2] - coordinates[2][2] );
+//! the edges at the six corners of a linear wedge.  Every node has three
+//! neighbours, so the corners hold each of the nine edges twice, once from
+//! each end.
+struct WedgeCorners
+{
+  //! node wedge_corner_nodes[k][j] - node k
+  VerdictVector edge[6][3];
+  double length_squared[6][3];
+  //! edge[k][1] % (edge[k][0] * edge[k][2])
+  double jacobian[6];
+};
 
-  d.set( coordinates[4][0] - coordinates[3][0],
-      coordinates[4][1] - coordinates[3][1],
-      coordinates[4][2] - coordinates[3][2] );
+static void wedge_corners( double coordinates[][3], WedgeCorners &corners )
+{
+  for ( int k = 0; k < 6; k++ )
+  {
+    for ( int j = 0; j < 3; j++ )
+    {
+      const int n = wedge_corner_nodes[k][j];
+      corners.edge[k][j].set( coordinates[n][0] - coordinates[k][0],
+                              coordinates[n][1] - coordinates[k][1],
+                              coordinates[n][2] - coordinates[k][2] );
+      corners.length_squared[k][j] = corners.edge[k][j].length_squared();
+    }
+    corners.jacobian[k] = corners.edge[k][1] % ( corners.edge[k][0] * corners.edge[k][2] );
+  }
+}
 
-  e.set( coordinates[5][0] - coordinates[4][0],
-      coordinates[5][1] - coordinates[4][1],
-      coordinates[5][2] - coordinates[4][2] );
+//! the squared length of the edge between node a and its neighbour b
+static double edge_length_squared( const WedgeCorners &corners, int a, int b )
+{
+  const int* nodes = wedge_corner_nodes[a];
+  return corners.length_squared[a][nodes[0] == b ? 0 : ( nodes[1] == b ? 1 : 2 )];
+}
 
-  f.set( coordinates[3][0] - coordinates[5][0],
-      coordinates[3][1] - coordinates[5][1],
-      coordinates[3][2] - coordinates[5][2] );
+static double edge_ratio( const WedgeCorners &corners )
+{
+  double max = edge_length_squared( corners, wedge_edges[0][0], wedge_edges[0][1] ), min = max;
+  for ( int e = 1; e < 9; e++ )
+  {
+    const double length_squared = edge_length_squared( corners, wedge_edges[e][0], wedge_edges[e][1] );
+    if (max <= length_squared){max = length_squared;}
+    if (length_squared <= min){min = length_squared;}
+  }
 
-  g.set( coordinates[3][0] - coordinates[0][0],
-      coordinates[3][1] - coordinates[0][1],
-      coordinates[3][2] - coordinates[0][2] );
+  double edge_ratio = sqrt( max / min );
 
-  h.set( coordinates[4][0] - coordinates[1][0],
-      coordinates[4][1] - coordinates[1][1],
-      coordinates[4][2] - coordinates[1][2] );
+  if (std::isnan(edge_ratio))
+    return VERDICT_DBL_MAX;
+  if (edge_ratio < 1.)
+    return 1.;
+  return  (double) std::min( edge_ratio, VERDICT_DBL_MAX );
+}
 
-  i.set( coordinates[5][0] - coordinates[2][0],
-      coordinates[5][1] - coordinates[2][1],
-      coordinates[5][2] - coordinates[2][2] );
+static void aspects( int num_nodes, double coordinates[][3], double aspect[6] )
+{
+  if ( num_nodes < 6 )
+  {
+    for ( int t = 0; t < 6; t++ )
+      aspect[t] = 0;
+    return;
+  }
 
-  double a2 = a.length_squared();
-  double b2 = b.length_squared();
-  double c2 = c.length_squared();
-  double d2 = d.length_squared();
-  double e2 = e.length_squared();
-  double f2 = f.length_squared();
-  double g2 = g.length_squared();
-  double h2 = h.length_squared();
-  double i2 = i.length_squared();
+  double mini_tris[4][3];
+  for ( int t = 0; t < 6; t++ )
+  {
+    for ( int n = 0; n < 4; n++ )
+      for ( int i = 0; i < 3; i++ )
+        mini_tris[n][i] = coordinates[wedge_corner_tets[t][n]][i];
+    aspect[t] = tet_aspect_frobenius(4,mini_tris);
+  }
+}
 
-  double max = a2, min = a2;
+static double max_aspect_frobenius( const double aspect[6] )
+{
+  double max_aspect = std::max( {aspect[0],aspect[1],aspect[2],aspect[3],aspect[4],aspect[5]} );
 
-  if (max <= b2){max = b2;}
-  if (b2 <= min){min = b2;}
+  if (max_aspect >= VERDICT_DBL_MAX )
+    return VERDICT_DBL_MAX;
+  max_aspect /= 1.16477;
+  return std::max(max_aspect, 1.);
+}
 
-  if (max <= c2){max = c2;}
-  if (c2 <= min){min = c2;}
+static double mean_aspect_frobenius( const double aspect[6] )
+{
+  double mean_aspect = (aspect[0] + aspect[1] + aspect[2] + aspect[3] + aspect[4] + aspect[5]);
+  if (mean_aspect >= VERDICT_DBL_MAX)
+    return VERDICT_DBL_MAX;
 
-  if (max <= d2){max = d2;}
-  if (d2 <= min){min = d2;}
+  mean_aspect /= (6. * 1.16477);
+  return std::max(mean_aspect, 1.);
+}
 
-  if (max <= e2){max = e2;}
-  if (e2 <= min){min = e2;}
+//! the jacobian of a linear wedge
+static double corner_jacobian( const WedgeCorners &corners )
+{
+  double min_jacobian = corners.jacobian[0];
+  for ( int k = 1; k < 6; k++ )
+    min_jacobian = std::min(corners.jacobian[k],min_jacobian);
 
-  if (max <= f2){max = f2;}
-  if (f2 <= min){min = f2;}
+  if ( min_jacobian > 0 )
+    return (double) std::min( min_jacobian, VERDICT_DBL_MAX );
+  return (double) std::max( min_jacobian, -VERDICT_DBL_MAX );
+}
 
-  if (max <= g2){max = g2;}
-  if (g2 <= min){min = g2;}
+static double distortion( double jacobian, double current_volume )
+{
+  double master_volume = 0.433013;
+  double distortion = VERDICT_DBL_MAX;
+  if (fabs(current_volume) > 0.0)
+    distortion = jacobian*master_volume/current_volume/0.866025;
 
-  if (max <= h2){max = h2;}
-  if (h2 <= min){min = h2;}
+  if (std::isnan(distortion)) return VERDICT_DBL_MAX;
+  if ( distortion >= VERDICT_DBL_MAX ) return VERDICT_DBL_MAX;
+  if ( distortion <= -VERDICT_DBL_MAX ) return -VERDICT_DBL_MAX;
+  return distortion;
+}
 
-  if (max <= i2){max = i2;}
-  if (i2 <= min){min = i2;}
+//! the quad stretch of each quadrilateral face, from the edges of the corners
+static double max_stretch( const WedgeCorners &corners, double coordinates[][3] )
+{
+  double stretches[3];
+  for ( int f = 0; f < 3; f++ )
+  {
+    const int* face = wedge_quad_faces[f];
+    double lengths_squared[4];
+    for ( int i = 0; i < 4; i++ )
+      lengths_squared[i] = edge_length_squared( corners, face[i], face[(i+1)%4] );
+
+    VerdictVector temp;
+    temp.set( coordinates[face[2]][0] - coordinates[face[0]][0],
+              coordinates[face[2]][1] - coordinates[face[0]][1],
+              coordinates[face[2]][2] - coordinates[face[0]][2]);
+    double diag02 = temp.length_squared();
+
+    temp.set( coordinates[face[3]][0] - coordinates[face[1]][0],
+              coordinates[face[3]][1] - coordinates[face[1]][1],
+              coordinates[face[3]][2] - coordinates[face[1]][2]);
+    double diag13 = temp.length_squared();
+
+    diag02 = std::max( diag02, diag13 );
+
+    if( diag02 < VERDICT_DBL_MIN )
+      stretches[f] = (double) VERDICT_DBL_MAX;
+    else
+    {
+      double stretch = (double) ( root_of_2 *
+                             sqrt( std::min(
+                                    std::min( lengths_squared[0], lengths_squared[1] ),
+                                    std::min( lengths_squared[2], lengths_squared[3] ) ) /
+                                  diag02 ));
+      stretches[f] = (double) std::min( stretch, VERDICT_DBL_MAX );
+    }
+  }
 
-  double edge_ratio = sqrt( max / min );
+  double stretch = std::max( {stretches[0],stretches[1],stretches[2]} );
 
-  if (std::isnan(edge_ratio))
-    return VERDICT_DBL_MAX;
-  if (edge_ratio < 1.)
-    return 1.;
-  return  (double) std::min( edge_ratio, VERDICT_DBL_MAX );
+  if ( stretch > 0 )
+    return (double) std::min( stretch, VERDICT_DBL_MAX );
+  return (double) std::max( stretch, -VERDICT_DBL_MAX );
+}
 
+static double scaled_jacobian( const WedgeCorners &corners )
+{
+  double min_jacobian = 0;
+  for ( int k = 0; k < 6; k++ )
+  {
+    const double* l = corners.length_squared[k];
+    double lengths = sqrt(l[0] * l[1] * l[2]);
+    double current_jacobian = corners.jacobian[k]/lengths;
+    min_jacobian = k == 0 ? current_jacobian : std::min(current_jacobian,min_jacobian);
+  }
+
+  min_jacobian *= 2/sqrt(3.0);
+
+  if ( min_jacobian > 0 )
+    return (double) std::min( min_jacobian, VERDICT_DBL_MAX );
+  return (double) std::max( min_jacobian, -VERDICT_DBL_MAX );
 }
 
-static void aspects( int num_nodes, double coordinates[][3],
-                    double &aspect1, double &aspect2, double &aspect3, double &aspect4, double &aspect5, double &aspect6)
+static double shape( const WedgeCorners &corners )
 {
-  if ( num_nodes < 6 )
+  double min_shape = 1.0;
+  for ( int k = 0; k < 6; k++ )
   {
-    aspect1 = 0;
-    aspect2 = 0;
-    aspect3 = 0;
-    aspect4 = 0;
-    aspect5 = 0;
-    aspect6 = 0;
-    return;
+    double current_jacobian = corners.jacobian[k];
+    if(current_jacobian > VERDICT_DBL_MIN)
+    {
+      const double* l = corners.length_squared[k];
+      double norm_jacobi = current_jacobian*2.0/sqrt(3.0);
+      double current_shape = 3*pow(norm_jacobi,two_thirds)/(l[0] + l[1] + l[2]);
+      min_shape = std::min(current_shape,min_shape);
+    }
+    else
+    {
+      return 0;
+    }
   }
-  
-  double mini_tris[4][3];
-  int i = 0;
-  // Take first tetrahedron
-  for (i = 0; i < 3; i++){mini_tris[0][i] = coordinates[0][i];}
-  for (i = 0; i < 3; i++){mini_tris[1][i] = coordinates[1][i];}
-  for (i = 0; i < 3; i++){mini_tris[2][i] = coordinates[2][i];}
-  for (i = 0; i < 3; i++){mini_tris[3][i] = coordinates[3][i];}
-  
-  aspect1 = tet_aspect_frobenius(4,mini_tris);
-  
-  //Take second tet
-  for (i = 0; i < 3; i++){mini_tris[0][i] = coordinates[1][i];}
-  for (i = 0; i < 3; i++){mini_tris[1][i] = coordinates[2][i];}
-  for (i = 0; i < 3; i++){mini_tris[2][i] = coordinates[0][i];}
-  for (i = 0; i < 3; i++){mini_tris[3][i] = coordinates[4][i];}
-  
-  aspect2 = tet_aspect_frobenius(4,mini_tris);
-  
-  //3rd tet
-  for (i = 0; i < 3; i++){mini_tris[0][i] = coordinates[2][i];}
-  for (i = 0; i < 3; i++){mini_tris[1][i] = coordinates[0][i];}
-  for (i = 0; i < 3; i++){mini_tris[2][i] = coordinates[1][i];}
-  for (i = 0; i < 3; i++){mini_tris[3][i] = coordinates[5][i];}
-  
-  aspect3 = tet_aspect_frobenius(4,mini_tris);
-  
-  //4th tet
-  for (i = 0; i < 3; i++){mini_tris[0][i] = coordinates[3][i];}
-  for (i = 0; i < 3; i++){mini_tris[1][i] = coordinates[5][i];}
-  for (i = 0; i < 3; i++){mini_tris[2][i] = coordinates[4][i];}
-  for (i = 0; i < 3; i++){mini_tris[3][i] = coordinates[0][i];}
-  
-  aspect4 = tet_aspect_frobenius(4,mini_tris);
-  
-  //5th tet
-  for (i = 0; i < 3; i++){mini_tris[0][i] = coordinates[4][i];}
-  for (i = 0; i < 3; i++){mini_tris[1][i] = coordinates[3][i];}
-  for (i = 0; i < 3; i++){mini_tris[2][i] = coordinates[5][i];}
-  for (i = 0; i < 3; i++){mini_tris[3][i] = coordinates[1][i];}
-  
-  aspect5 = tet_aspect_frobenius(4,mini_tris);
-  
-  //6th tet
-  for (i = 0; i < 3; i++){mini_tris[0][i] = coordinates[5][i];}
-  for (i = 0; i < 3; i++){mini_tris[1][i] = coordinates[4][i];}
-  for (i = 0; i < 3; i++){mini_tris[2][i] = coordinates[3][i];}
-  for (i = 0; i < 3; i++){mini_tris[3][i] = coordinates[2][i];}
-  
-  aspect6 = tet_aspect_frobenius(4,mini_tris);
-  
+
+  if (min_shape < VERDICT_DBL_MIN)
+    return 0;
+  return min_shape;
 }
-  
-  
+
+/* Edge ratio
+   The edge ratio quality metric is the ratio of the longest to shortest edge of
+   a wedge.
+   q = L_max / L_min
+
+   Dimension : 1
+   Acceptable range : --
+   Normal range : [1,DBL_MAX]
+   Full range : [1,DBL_MAX]
+   q for right, unit wedge : 1
+   Reference : -
+   */
+double wedge_edge_ratio( int /*num_nodes*/, double coordinates[][3] )
+{
+  VERDICT_INSTRUMENT_METRIC( wedge_edge_ratio );
+  WedgeCorners corners;
+  wedge_corners( coordinates, corners );
+  return edge_ratio( corners );
+}
+
 /* For wedges, there is not a unique definition of the aspect Frobenius. Rather,
  * this metric uses the aspect Frobenius defined for tetrahedral (see section
  * 6.4) and is comparable in methodology to the maximum aspect Frobenius defined
@@ -586,16 +683,10 @@ static void aspects( int num_nodes, double coordinates[][3],
 
 double wedge_max_aspect_frobenius( int num_nodes, double coordinates[][3] )
 {
-  double aspect1, aspect2, aspect3, aspect4, aspect5, aspect6;
-  aspects( num_nodes, coordinates, aspect1, aspect2, aspect3, aspect4, aspect5, aspect6 );
-
-  double max_aspect = std::max( {aspect1,aspect2,aspect3,aspect4,aspect5,aspect6} );
-  
-  if (max_aspect >= VERDICT_DBL_MAX )
-    return VERDICT_DBL_MAX;
-  max_aspect /= 1.16477;
-  return std::max(max_aspect, 1.);
-
+  VERDICT_INSTRUMENT_METRIC( wedge_max_aspect_frobenius );
+  double aspect[6];
+  aspects( num_nodes, coordinates, aspect );
+  return max_aspect_frobenius( aspect );
 }
 /*
    For wedges, there is not a unique definition of the aspect Frobenius. Rather,
@@ -617,15 +708,10 @@ double wedge_max_aspect_frobenius( int num_nodes, double coordinates[][3] )
 
 double wedge_mean_aspect_frobenius( int num_nodes, double coordinates[][3] )
 {
-  double aspect1, aspect2, aspect3, aspect4, aspect5, aspect6;
-  aspects( num_nodes, coordinates, aspect1, aspect2, aspect3, aspect4, aspect5, aspect6 );
-
-  double mean_aspect = (aspect1 + aspect2 + aspect3 + aspect4 + aspect5 + aspect6);
-  if (mean_aspect >= VERDICT_DBL_MAX)
-    return VERDICT_DBL_MAX;
-  
-  mean_aspect /= (6. * 1.16477);
-  return std::max(mean_aspect, 1.);
+  VERDICT_INSTRUMENT_METRIC( wedge_mean_aspect_frobenius );
+  double aspect[6];
+  aspects( num_nodes, coordinates, aspect );
+  return mean_aspect_frobenius( aspect );
 }
 
 /* This is the minimum determinant of the Jacobian matrix evaluated at each
@@ -645,142 +731,72 @@ double wedge_mean_aspect_frobenius( int num_nodes, double coordinates[][3] )
  Verdict Function : wedge_jacobian
  */
 
-double wedge_jacobian( int num_nodes, double coordinates[][3] )
+namespace fixed
 {
-  if(num_nodes == 21)
-  {
-    double dhdr[21];
-    double dhds[21];
-    double dhdt[21];
-    double min_determinant = VERDICT_DBL_MAX;
-
-    for(int i=0; i<15; i++)
-    {
-      WEDGE21_gradients_of_the_shape_functions_for_RST(WEDGE21_node_local_coord[i], dhdr, dhds, dhdt);
-      double jacobian[3][3] = {{0,0,0},{0,0,0},{0,0,0}};
-
-      for(int j=0; j<21; j++)
-      {
-        jacobian[0][0]+=coordinates[j][0]*dhdr[j];
-        jacobian[0][1]+=coordinates[j][0]*dhds[j];
-        jacobian[0][2]+=coordinates[j][0]*dhdt[j];
-        jacobian[1][0]+=coordinates[j][1]*dhdr[j];
-        jacobian[1][1]+=coordinates[j][1]*dhds[j];
-        jacobian[1][2]+=coordinates[j][1]*dhdt[j];
-        jacobian[2][0]+=coordinates[j][2]*dhdr[j];
-        jacobian[2][1]+=coordinates[j][2]*dhds[j];
-        jacobian[2][2]+=coordinates[j][2]*dhdt[j];
-      }
-      double det = (VerdictVector(jacobian[0]) * VerdictVector(jacobian[1])) % VerdictVector(jacobian[2]);
-      min_determinant = std::min(det, min_determinant);
-    }
-    return min_determinant;
-  }
-  else
-  {
-    double min_jacobian = 0, current_jacobian = 0;
-    VerdictVector vec1,vec2,vec3;
-
-    // Node 0
-    vec1.set( coordinates[1][0] - coordinates[0][0],
-        coordinates[1][1] - coordinates[0][1],
-        coordinates[1][2] - coordinates[0][2] );
-
-    vec2.set( coordinates[3][0] - coordinates[0][0],
-        coordinates[3][1] - coordinates[0][1],
-        coordinates[3][2] - coordinates[0][2] );
-
-    vec3.set( coordinates[2][0] - coordinates[0][0],
-        coordinates[2][1] - coordinates[0][1],
-        coordinates[2][2] - coordinates[0][2] );
-
-    current_jacobian = vec2 % (vec1 * vec3);
-    min_jacobian = current_jacobian;
-
-    //node 1
-    vec1.set( coordinates[2][0] - coordinates[1][0],
-        coordinates[2][1] - coordinates[1][1],
-        coordinates[2][2] - coordinates[1][2] );
-
-    vec2.set( coordinates[4][0] - coordinates[1][0],
-        coordinates[4][1] - coordinates[1][1],
-        coordinates[4][2] - coordinates[1][2] );
-
-    vec3.set( coordinates[0][0] - coordinates[1][0],
-        coordinates[0][1] - coordinates[1][1],
-        coordinates[0][2] - coordinates[1][2] );
-
-    current_jacobian = vec2 % (vec1 * vec3);
-    min_jacobian = std::min(current_jacobian,min_jacobian);
-
-    //node 2
-    vec1.set( coordinates[0][0] - coordinates[2][0],
-        coordinates[0][1] - coordinates[2][1],
-        coordinates[0][2] - coordinates[2][2] );
-
-    vec2.set( coordinates[5][0] - coordinates[2][0],
-        coordinates[5][1] - coordinates[2][1],
-        coordinates[5][2] - coordinates[2][2] );
-
-    vec3.set( coordinates[1][0] - coordinates[2][0],
-        coordinates[1][1] - coordinates[2][1],
-        coordinates[1][2] - coordinates[2][2] );
-
-    current_jacobian = vec2 % (vec1 * vec3);
-    min_jacobian = std::min(current_jacobian,min_jacobian);
 
-    //node 3
-    vec1.set( coordinates[0][0] - coordinates[3][0],
-        coordinates[0][1] - coordinates[3][1],
-        coordinates[0][2] - coordinates[3][2] );
-
-    vec2.set( coordinates[4][0] - coordinates[3][0],
-        coordinates[4][1] - coordinates[3][1],
-        coordinates[4][2] - coordinates[3][2] );
-
-    vec3.set( coordinates[5][0] - coordinates[3][0],
-        coordinates[5][1] - coordinates[3][1],
-        coordinates[5][2] - coordinates[3][2] );
-
-    current_jacobian = vec2 % (vec1 * vec3);
-    min_jacobian = std::min(current_jacobian,min_jacobian);
-
-    //node 4
-    vec1.set( coordinates[1][0] - coordinates[4][0],
-        coordinates[1][1] - coordinates[4][1],
-        coordinates[1][2] - coordinates[4][2] );
-
-    vec2.set( coordinates[5][0] - coordinates[4][0],
-        coordinates[5][1] - coordinates[4][1],
-        coordinates[5][2] - coordinates[4][2] );
+//! the jacobian of a 21 node wedge: the minimum determinant at the 15 nodes of its edges
+template <>
+double wedge_jacobian<21>( double coordinates[][3] )
+{
+  const NodalGradients<21, 15> &gradients = wedge21_nodal_gradients();
+  double min_determinant = VERDICT_DBL_MAX;
+
+  double determinants[15];
+  nodal_jacobian_determinants( gradients, coordinates, determinants );
+  for(int i=0; i<15; i++)
+    min_determinant = std::min(determinants[i], min_determinant);
+  return min_determinant;
+}
 
-    vec3.set( coordinates[3][0] - coordinates[4][0],
-        coordinates[3][1] - coordinates[4][1],
-        coordinates[3][2] - coordinates[4][2] );
+//! the jacobian of a linear wedge: the minimum determinant at the corners
+template <>
+double wedge_jacobian<6>( double coordinates[][3] )
+{
+  WedgeCorners corners;
+  wedge_corners( coordinates, corners );
+  return corner_jacobian( corners );
+}
 
-    current_jacobian = vec2 % (vec1 * vec3);
-    min_jacobian = std::min(current_jacobian,min_jacobian);
+} // namespace fixed
 
-    //node 5
-    vec1.set( coordinates[3][0] - coordinates[5][0],
-        coordinates[3][1] - coordinates[5][1],
-        coordinates[3][2] - coordinates[5][2] );
+double wedge_jacobian( int num_nodes, double coordinates[][3] )
+{
+  VERDICT_INSTRUMENT_METRIC( wedge_jacobian );
+  if(num_nodes == 21)
+    return fixed::wedge_jacobian<21>( coordinates );
+  return fixed::wedge_jacobian<6>( coordinates );
+}
 
-    vec2.set( coordinates[4][0] - coordinates[5][0],
-        coordinates[4][1] - coordinates[5][1],
-        coordinates[4][2] - coordinates[5][2] );
+//! the linear shape functions of the corners of a wedge
+static void wedge6_linear_shape_functions( const double rst[3], double h[6] )
+{
+  const double triangle[3] = { 1 - rst[0] - rst[1], rst[0], rst[1] };
+  // corners 0 to 2 are at t = -1, corners 3 to 5 at t = 1
+  for ( int c = 0; c < 6; c++ )
+    h[c] = triangle[c % 3] * 0.5 * ( c < 3 ? 1 - rst[2] : 1 + rst[2] );
+}
 
-    vec3.set( coordinates[2][0] - coordinates[5][0],
-        coordinates[2][1] - coordinates[5][1],
-        coordinates[2][2] - coordinates[5][2] );
+//! the bounds of the wedge21 jacobian estimate, tabulated on first use
+static const NodalJacobianBounds<21, 6, 15> &wedge21_jacobian_bounds()
+{
+  static const NodalJacobianBounds<21, 6, 15> bounds( wedge21_nodal_gradients(), wedge6_linear_shape_functions,
+                                                      WEDGE21_node_local_coord );
+  return bounds;
+}
 
-    current_jacobian = vec2 % (vec1 * vec3);
-    min_jacobian = std::min(current_jacobian,min_jacobian);
+/*!
+  estimate of the jacobian of a wedge
 
-    if ( min_jacobian > 0 )
-      return (double) std::min( min_jacobian, VERDICT_DBL_MAX );
-    return (double) std::max( min_jacobian, -VERDICT_DBL_MAX );
-  }
+  The jacobian of the linear wedge of the corners at the 15 edge nodes,
+  which the offsets of the other 15 nodes bound
+*/
+void wedge_jacobian_estimate( int num_nodes, double coordinates[][3], MetricEstimate &estimate )
+{
+  VERDICT_INSTRUMENT_METRIC( wedge_jacobian_estimate );
+  if ( num_nodes == 21 )
+    nodal_jacobian_estimate( wedge21_jacobian_bounds(), coordinates, estimate );
+  else
+    estimate.value = estimate.lower = estimate.upper = fixed::wedge_jacobian<6>( coordinates );
 }
 
 /* distortion is a measure of how well a particular wedge element maps to a
@@ -807,17 +823,10 @@ double wedge_jacobian( int num_nodes, double coordinates[][3] )
 
 double wedge_distortion( int num_nodes, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( wedge_distortion );
   double jacobian = wedge_jacobian( num_nodes, coordinates );
-  double master_volume = 0.433013;
   double current_volume = wedge_volume( num_nodes, coordinates);
-  double distortion = VERDICT_DBL_MAX;
-  if (fabs(current_volume) > 0.0)
-    distortion = jacobian*master_volume/current_volume/0.866025;
-
-  if (std::isnan(distortion)) return VERDICT_DBL_MAX;
-  if ( distortion >= VERDICT_DBL_MAX ) return VERDICT_DBL_MAX;
-  if ( distortion <= -VERDICT_DBL_MAX ) return -VERDICT_DBL_MAX;
-  return distortion;
+  return distortion( jacobian, current_volume );
 }
 
 /*
@@ -836,38 +845,11 @@ double wedge_distortion( int num_nodes, double coordinates[][3] )
 
 double wedge_max_stretch( int /*num_nodes*/, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( wedge_max_stretch );
   //This function finds the stretch of the 3 quadrilateral faces and returns the maximum value
-
-  double stretch = 42, quad_face[4][3], stretch1 = 42, stretch2 = 42, stretch3 = 42;
-  int i = 0;
-
-  //first face
-  for (i = 0; i < 3; i++){quad_face[0][i] = coordinates[0][i];}
-  for (i = 0; i < 3; i++){quad_face[1][i] = coordinates[1][i];}
-  for (i = 0; i < 3; i++){quad_face[2][i] = coordinates[4][i];}
-  for (i = 0; i < 3; i++){quad_face[3][i] = coordinates[3][i];}
-  stretch1 = quad_stretch(4,quad_face);
-
-  //second face
-  for (i = 0; i < 3; i++){quad_face[0][i] = coordinates[1][i];}
-  for (i = 0; i < 3; i++){quad_face[1][i] = coordinates[2][i];}
-  for (i = 0; i < 3; i++){quad_face[2][i] = coordinates[5][i];}
-  for (i = 0; i < 3; i++){quad_face[3][i] = coordinates[4][i];}
-  stretch2 = quad_stretch(4,quad_face);
-
-  //third face
-  for (i = 0; i < 3; i++){quad_face[0][i] = coordinates[2][i];}
-  for (i = 0; i < 3; i++){quad_face[1][i] = coordinates[0][i];}
-  for (i = 0; i < 3; i++){quad_face[2][i] = coordinates[3][i];}
-  for (i = 0; i < 3; i++){quad_face[3][i] = coordinates[5][i];}
-  stretch3 = quad_stretch(4,quad_face);
-
-  stretch = std::max( {stretch1,stretch2,stretch3} );
-
-  if ( stretch > 0 )
-    return (double) std::min( stretch, VERDICT_DBL_MAX );
-  return (double) std::max( stretch, -VERDICT_DBL_MAX );
-
+  WedgeCorners corners;
+  wedge_corners( coordinates, corners );
+  return max_stretch( corners, coordinates );
 }
 
 /*
@@ -890,123 +872,10 @@ double wedge_max_stretch( int /*num_nodes*/, double coordinates[][3] )
 
 double wedge_scaled_jacobian( int /*num_nodes*/, double coordinates[][3] )
 {
-  double min_jacobian = 0, current_jacobian = 0,lengths = 42;
-  VerdictVector vec1,vec2,vec3;
-
-  // Node 0
-  vec1.set( coordinates[1][0] - coordinates[0][0],
-      coordinates[1][1] - coordinates[0][1],
-      coordinates[1][2] - coordinates[0][2] );
-
-  vec2.set( coordinates[3][0] - coordinates[0][0],
-      coordinates[3][1] - coordinates[0][1],
-      coordinates[3][2] - coordinates[0][2] );
-
-  vec3.set( coordinates[2][0] - coordinates[0][0],
-      coordinates[2][1] - coordinates[0][1],
-      coordinates[2][2] - coordinates[0][2] );
-
-  lengths = sqrt(vec1.length_squared() * vec2.length_squared() * vec3.length_squared());
-
-  current_jacobian = (vec2 % (vec1 * vec3));
-  min_jacobian = current_jacobian/lengths;
-
-  //node 1
-  vec1.set( coordinates[2][0] - coordinates[1][0],
-      coordinates[2][1] - coordinates[1][1],
-      coordinates[2][2] - coordinates[1][2] );
-
-  vec2.set( coordinates[4][0] - coordinates[1][0],
-      coordinates[4][1] - coordinates[1][1],
-      coordinates[4][2] - coordinates[1][2] );
-
-  vec3.set( coordinates[0][0] - coordinates[1][0],
-      coordinates[0][1] - coordinates[1][1],
-      coordinates[0][2] - coordinates[1][2] );
-
-  lengths = sqrt(vec1.length_squared() * vec2.length_squared() * vec3.length_squared());
-
-  current_jacobian = vec2 % (vec1 * vec3);
-  min_jacobian = std::min(current_jacobian/lengths,min_jacobian);
-
-  //node 2
-  vec1.set( coordinates[0][0] - coordinates[2][0],
-      coordinates[0][1] - coordinates[2][1],
-      coordinates[0][2] - coordinates[2][2] );
-
-  vec2.set( coordinates[5][0] - coordinates[2][0],
-      coordinates[5][1] - coordinates[2][1],
-      coordinates[5][2] - coordinates[2][2] );
-
-  vec3.set( coordinates[1][0] - coordinates[2][0],
-      coordinates[1][1] - coordinates[2][1],
-      coordinates[1][2] - coordinates[2][2] );
-
-  lengths = sqrt(vec1.length_squared() * vec2.length_squared() * vec3.length_squared());
-
-  current_jacobian = vec2 % (vec1 * vec3);
-  min_jacobian = std::min(current_jacobian/lengths,min_jacobian);
-
-  //node 3
-  vec1.set( coordinates[0][0] - coordinates[3][0],
-      coordinates[0][1] - coordinates[3][1],
-      coordinates[0][2] - coordinates[3][2] );
-
-  vec2.set( coordinates[4][0] - coordinates[3][0],
-      coordinates[4][1] - coordinates[3][1],
-      coordinates[4][2] - coordinates[3][2] );
-
-  vec3.set( coordinates[5][0] - coordinates[3][0],
-      coordinates[5][1] - coordinates[3][1],
-      coordinates[5][2] - coordinates[3][2] );
-
-  lengths = sqrt(vec1.length_squared() * vec2.length_squared() * vec3.length_squared());
-
-  current_jacobian = vec2 % (vec1 * vec3);
-  min_jacobian = std::min(current_jacobian/lengths,min_jacobian);
-
-  //node 4
-  vec1.set( coordinates[1][0] - coordinates[4][0],
-      coordinates[1][1] - coordinates[4][1],
-      coordinates[1][2] - coordinates[4][2] );
-
-  vec2.set( coordinates[5][0] - coordinates[4][0],
-      coordinates[5][1] - coordinates[4][1],
-      coordinates[5][2] - coordinates[4][2] );
-
-  vec3.set( coordinates[3][0] - coordinates[4][0],
-      coordinates[3][1] - coordinates[4][1],
-      coordinates[3][2] - coordinates[4][2] );
-
-  lengths = sqrt(vec1.length_squared() * vec2.length_squared() * vec3.length_squared());
-
-  current_jacobian = vec2 % (vec1 * vec3);
-  min_jacobian = std::min(current_jacobian/lengths,min_jacobian);
-
-  //node 5
-  vec1.set( coordinates[3][0] - coordinates[5][0],
-      coordinates[3][1] - coordinates[5][1],
-      coordinates[3][2] - coordinates[5][2] );
-
-  vec2.set( coordinates[4][0] - coordinates[5][0],
-      coordinates[4][1] - coordinates[5][1],
-      coordinates[4][2] - coordinates[5][2] );
-
-  vec3.set( coordinates[2][0] - coordinates[5][0],
-      coordinates[2][1] - coordinates[5][1],
-      coordinates[2][2] - coordinates[5][2] );
-
-  lengths = sqrt(vec1.length_squared() * vec2.length_squared() * vec3.length_squared());
-
-  current_jacobian = vec2 % (vec1 * vec3);
-  min_jacobian = std::min(current_jacobian/lengths,min_jacobian);
-
-  min_jacobian *= 2/sqrt(3.0);
-
-  if ( min_jacobian > 0 )
-    return (double) std::min( min_jacobian, VERDICT_DBL_MAX );
-  return (double) std::max( min_jacobian, -VERDICT_DBL_MAX );
-
+  VERDICT_INSTRUMENT_METRIC( wedge_scaled_jacobian );
+  WedgeCorners corners;
+  wedge_corners( coordinates, corners );
+  return scaled_jacobian( corners );
 }
 
 /*
@@ -1027,164 +896,10 @@ double wedge_scaled_jacobian( int /*num_nodes*/, double coordinates[][3] )
 
 double wedge_shape( int /*num_nodes*/, double coordinates[][3] )
 {
-  double current_jacobian = 0, current_shape, norm_jacobi = 0;
-  double min_shape = 1.0;
-  VerdictVector vec1,vec2,vec3;
-
-  // Node 0
-  vec1.set( coordinates[1][0] - coordinates[0][0],
-      coordinates[1][1] - coordinates[0][1],
-      coordinates[1][2] - coordinates[0][2] );
-
-  vec2.set( coordinates[3][0] - coordinates[0][0],
-      coordinates[3][1] - coordinates[0][1],
-      coordinates[3][2] - coordinates[0][2] );
-
-  vec3.set( coordinates[2][0] - coordinates[0][0],
-      coordinates[2][1] - coordinates[0][1],
-      coordinates[2][2] - coordinates[0][2] );
-
-  current_jacobian = vec2 % (vec1 * vec3);
-  if(current_jacobian > VERDICT_DBL_MIN)
-  {
-    norm_jacobi = current_jacobian*2.0/sqrt(3.0);
-    current_shape = 3*pow(norm_jacobi,two_thirds)/(vec1.length_squared() + vec2.length_squared() + vec3.length_squared());
-    min_shape = std::min(current_shape,min_shape);
-  }
-  else
-  {
-    return 0;
-  }
-
-  //node 1
-  vec1.set( coordinates[2][0] - coordinates[1][0],
-      coordinates[2][1] - coordinates[1][1],
-      coordinates[2][2] - coordinates[1][2] );
-
-  vec2.set( coordinates[4][0] - coordinates[1][0],
-      coordinates[4][1] - coordinates[1][1],
-      coordinates[4][2] - coordinates[1][2] );
-
-  vec3.set( coordinates[0][0] - coordinates[1][0],
-      coordinates[0][1] - coordinates[1][1],
-      coordinates[0][2] - coordinates[1][2] );
-
-  current_jacobian = vec2 % (vec1 * vec3);
-  if(current_jacobian > VERDICT_DBL_MIN)
-  {
-    norm_jacobi = current_jacobian*2.0/sqrt(3.0);
-    current_shape = 3*pow(norm_jacobi,two_thirds)/(vec1.length_squared() + vec2.length_squared() + vec3.length_squared());
-    min_shape = std::min(current_shape,min_shape);
-  }
-  else
-  {
-    return 0;
-  }
-
-  //node 2
-  vec1.set( coordinates[0][0] - coordinates[2][0],
-      coordinates[0][1] - coordinates[2][1],
-      coordinates[0][2] - coordinates[2][2] );
-
-  vec2.set( coordinates[5][0] - coordinates[2][0],
-      coordinates[5][1] - coordinates[2][1],
-      coordinates[5][2] - coordinates[2][2] );
-
-  vec3.set( coordinates[1][0] - coordinates[2][0],
-      coordinates[1][1] - coordinates[2][1],
-      coordinates[1][2] - coordinates[2][2] );
-
-  current_jacobian = vec2 % (vec1 * vec3);
-  if(current_jacobian > VERDICT_DBL_MIN)
-  {
-    norm_jacobi = current_jacobian*2.0/sqrt(3.0);
-    current_shape = 3*pow(norm_jacobi,two_thirds)/(vec1.length_squared() + vec2.length_squared() + vec3.length_squared());
-    min_shape = std::min(current_shape,min_shape);
-  }
-  else
-  {
-    return 0;
-  }
-
-  //node 3
-  vec1.set( coordinates[0][0] - coordinates[3][0],
-      coordinates[0][1] - coordinates[3][1],
-      coordinates[0][2] - coordinates[3][2] );
-
-  vec2.set( coordinates[4][0] - coordinates[3][0],
-      coordinates[4][1] - coordinates[3][1],
-      coordinates[4][2] - coordinates[3][2] );
-
-  vec3.set( coordinates[5][0] - coordinates[3][0],
-      coordinates[5][1] - coordinates[3][1],
-      coordinates[5][2] - coordinates[3][2] );
-
-  current_jacobian = vec2 % (vec1 * vec3);
-  if(current_jacobian > VERDICT_DBL_MIN)
-  {
-    norm_jacobi = current_jacobian*2.0/sqrt(3.0);
-    current_shape = 3*pow(norm_jacobi,two_thirds)/(vec1.length_squared() + vec2.length_squared() + vec3.length_squared());
-    min_shape = std::min(current_shape,min_shape);
-  }
-  else
-  {
-    return 0;
-  }
-
-  //node 4
-  vec1.set( coordinates[1][0] - coordinates[4][0],
-      coordinates[1][1] - coordinates[4][1],
-      coordinates[1][2] - coordinates[4][2] );
-
-  vec2.set( coordinates[5][0] - coordinates[4][0],
-      coordinates[5][1] - coordinates[4][1],
-      coordinates[5][2] - coordinates[4][2] );
-
-  vec3.set( coordinates[3][0] - coordinates[4][0],
-      coordinates[3][1] - coordinates[4][1],
-      coordinates[3][2] - coordinates[4][2] );
-
-  current_jacobian = vec2 % (vec1 * vec3);
-  if(current_jacobian > VERDICT_DBL_MIN)
-  {
-    norm_jacobi = current_jacobian*2.0/sqrt(3.0);
-    current_shape = 3*pow(norm_jacobi,two_thirds)/(vec1.length_squared() + vec2.length_squared() + vec3.length_squared());
-    min_shape = std::min(current_shape,min_shape);
-  }
-  else
-  {
-    return 0;
-  }
-
-  //node 5
-  vec1.set( coordinates[3][0] - coordinates[5][0],
-      coordinates[3][1] - coordinates[5][1],
-      coordinates[3][2] - coordinates[5][2] );
-
-  vec2.set( coordinates[4][0] - coordinates[5][0],
-      coordinates[4][1] - coordinates[5][1],
-      coordinates[4][2] - coordinates[5][2] );
-
-  vec3.set( coordinates[2][0] - coordinates[5][0],
-      coordinates[2][1] - coordinates[5][1],
-      coordinates[2][2] - coordinates[5][2] );
-
-  current_jacobian = vec2 % (vec1 * vec3);
-  if(current_jacobian > VERDICT_DBL_MIN)
-  {
-    norm_jacobi = current_jacobian*2.0/sqrt(3.0);
-    current_shape = 3*pow(norm_jacobi,two_thirds)/(vec1.length_squared() + vec2.length_squared() + vec3.length_squared());
-    min_shape = std::min(current_shape,min_shape);
-  }
-  else
-  {
-    return 0;
-  }
-
-  if (min_shape < VERDICT_DBL_MIN)
-    return 0;
-  return min_shape;
-
+  VERDICT_INSTRUMENT_METRIC( wedge_shape );
+  WedgeCorners corners;
+  wedge_corners( coordinates, corners );
+  return shape( corners );
 }
 
 /* For wedges, there is not a unique definition of the aspect Frobenius. Rather,
@@ -1207,6 +922,7 @@ double wedge_shape( int /*num_nodes*/, double coordinates[][3] )
  */
 double wedge_condition( int /*num_nodes*/, double coordinates[][3] )
 {
+  VERDICT_INSTRUMENT_METRIC( wedge_condition );
   return wedge_max_aspect_frobenius(6,coordinates);
 }
 
@@ -1291,4 +1007,74 @@ void make_wedge_faces(double coordinates[][3], double tri1[][3], double tri2[][3
   quad3[3][1] = coordinates[5][1];
   quad3[3][2] = coordinates[5][2];
 }
+
+/*!
+  several metrics of a wedge in one pass
+
+  Every metric goes through the same helper as its single metric function,
+  so the results are identical, but the corner edges and jacobians, the
+  corner tet aspects and the volume are only formed once.
+*/
+void wedge_quality( int num_nodes, double coordinates[][3],
+                    unsigned int metrics, WedgeQuality &quality )
+{
+  VERDICT_INSTRUMENT_METRIC( wedge_quality );
+  WedgeCorners corners;
+  if ( metrics & ( WEDGE_EDGE_RATIO | WEDGE_JACOBIAN | WEDGE_DISTORTION | WEDGE_MAX_STRETCH |
+                   WEDGE_SCALED_JACOBIAN | WEDGE_SHAPE ) )
+    wedge_corners( coordinates, corners );
+
+  if ( metrics & WEDGE_EDGE_RATIO )
+    quality.edge_ratio = edge_ratio( corners );
+
+  if ( metrics & ( WEDGE_MAX_ASPECT_FROBENIUS | WEDGE_MEAN_ASPECT_FROBENIUS | WEDGE_CONDITION ) )
+  {
+    double aspect[6];
+    aspects( num_nodes, coordinates, aspect );
+    if ( metrics & WEDGE_MAX_ASPECT_FROBENIUS )
+      quality.max_aspect_frobenius = max_aspect_frobenius( aspect );
+    if ( metrics & WEDGE_MEAN_ASPECT_FROBENIUS )
+      quality.mean_aspect_frobenius = mean_aspect_frobenius( aspect );
+    if ( metrics & WEDGE_CONDITION )
+    {
+      // the condition always takes the aspects of the six corners
+      if ( num_nodes < 6 )
+        aspects( 6, coordinates, aspect );
+      quality.condition = max_aspect_frobenius( aspect );
+    }
+  }
+
+  double jacobian = 0;
+  if ( metrics & ( WEDGE_JACOBIAN | WEDGE_DISTORTION ) )
+  {
+    // the higher order jacobian comes from the nodal gradients
+    if ( num_nodes == 21 )
+      jacobian = wedge_jacobian( num_nodes, coordinates );
+    else
+      jacobian = corner_jacobian( corners );
+    if ( metrics & WEDGE_JACOBIAN )
+      quality.jacobian = jacobian;
+  }
+
+  if ( metrics & ( WEDGE_VOLUME | WEDGE_DISTORTION ) )
+  {
+    double volume = wedge_volume( num_nodes, coordinates );
+    if ( metrics & WEDGE_VOLUME )
+      quality.volume = volume;
+    if ( metrics & WEDGE_DISTORTION )
+      quality.distortion = distortion( jacobian, volume );
+  }
+
+  if ( metrics & WEDGE_MAX_STRETCH )
+    quality.max_stretch = max_stretch( corners, coordinates );
+
+  if ( metrics & WEDGE_SCALED_JACOBIAN )
+    quality.scaled_jacobian = scaled_jacobian( corners );
+
+  if ( metrics & WEDGE_SHAPE )
+    quality.shape = shape( corners );
+
+  if ( metrics & WEDGE_EQUIANGLE_SKEW )
+    quality.equiangle_skew = wedge_equiangle_skew( num_nodes, coordinates );
+}
 } // namespace verdict
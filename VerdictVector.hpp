@@ -14,6 +14,11 @@
  *
  * VerdictVector.hpp contains declarations of vector operations
  *
+ * VerdictVector is trivially copyable and every operation is inline, so
+ * arrays of them in the metric kernels can live in registers and be
+ * vectorized.  The operations without square roots are constexpr; the
+ * compound assignments only under C++14.
+ *
  * This file is part of VERDICT
  *
  */
@@ -28,6 +33,14 @@
 #include "verdict.h"
 #include <assert.h>
 #include <math.h>
+#include <type_traits>
+
+// constexpr for the functions with statements, which needs C++14
+#if __cplusplus >= 201402L || ( defined(_MSVC_LANG) && _MSVC_LANG >= 201402L )
+# define VERDICT_VECTOR_CONSTEXPR constexpr
+#else
+# define VERDICT_VECTOR_CONSTEXPR inline
+#endif
 
 namespace VERDICT_NAMESPACE
 {
@@ -37,38 +50,36 @@ class VerdictVector
 public:
   
     //- Heading: Constructors and Destructor
-  VerdictVector();  //- Default constructor.
+  constexpr VerdictVector();  //- Default constructor.
   
-  VerdictVector(const double x, const double y, const double z);
+  constexpr VerdictVector(const double x, const double y, const double z);
     //- Constructor: create vector from three components
   
-  VerdictVector( const double xyz[3] );
+  constexpr VerdictVector( const double xyz[3] );
     //- Constructor: create vector from tuple
 
-  VerdictVector (const VerdictVector& tail, const VerdictVector& head);
+  constexpr VerdictVector (const VerdictVector& tail, const VerdictVector& head);
     //- Constructor for a VerdictVector starting at tail and pointing
     //- to head.
   
-  VerdictVector(const VerdictVector& copy_from);  //- Copy Constructor
-  
     //- Heading: Set and Inquire Functions
-  void set( const double xv, const double yv, const double zv );
+  VERDICT_VECTOR_CONSTEXPR void set( const double xv, const double yv, const double zv );
     //- Change vector components to {x}, {y}, and {z}
   
-  void set( const double xyz[3] );
+  VERDICT_VECTOR_CONSTEXPR void set( const double xyz[3] );
     //- Change vector components to xyz[0], xyz[1], xyz[2]
 
-  void set(const VerdictVector& tail, const VerdictVector& head);
+  VERDICT_VECTOR_CONSTEXPR void set(const VerdictVector& tail, const VerdictVector& head);
     //- Change vector to go from tail to head.
   
-  void set(const VerdictVector& to_copy);
+  VERDICT_VECTOR_CONSTEXPR void set(const VerdictVector& to_copy);
     //- Same as operator=(const VerdictVector&)
   
-  double x() const; //- Return x component of vector
+  constexpr double x() const; //- Return x component of vector
   
-  double y() const; //- Return y component of vector
+  constexpr double y() const; //- Return y component of vector
   
-  double z() const; //- Return z component of vector
+  constexpr double z() const; //- Return z component of vector
   
   void get_xyz( double &x, double &y, double &z ); //- Get x, y, z components
   void get_xyz( double xyz[3] ); //- Get xyz tuple
@@ -99,7 +110,7 @@ public:
     //- Calculate the length of the vector.
     //- Use {length_squared()} if only comparing lengths, not adding.
   
-  double length_squared() const;
+  constexpr double length_squared() const;
     //- Calculate the squared length of the vector.
     //- Faster than {length()} since it eliminates the square root if
     //- only comparing other lengths.
@@ -113,64 +124,65 @@ public:
     //- z-component alone. Rotates clockwise about the z-axis by pi/2.
 
     //- Heading: Operator Overloads  *****************************
-  VerdictVector&  operator+=(const VerdictVector &vec);
+  VERDICT_VECTOR_CONSTEXPR VerdictVector&  operator+=(const VerdictVector &vec);
     //- Compound Assignment: addition: {this = this + vec}
   
-  VerdictVector& operator-=(const VerdictVector &vec);
+  VERDICT_VECTOR_CONSTEXPR VerdictVector& operator-=(const VerdictVector &vec);
     //- Compound Assignment: subtraction: {this = this - vec}
   
-  VerdictVector& operator*=(const VerdictVector &vec);
+  VERDICT_VECTOR_CONSTEXPR VerdictVector& operator*=(const VerdictVector &vec);
     //- Compound Assignment: cross product: {this = this * vec},
     //- non-commutative
   
-  VerdictVector& operator*=(const double scalar);
+  VERDICT_VECTOR_CONSTEXPR VerdictVector& operator*=(const double scalar);
     //- Compound Assignment: multiplication: {this = this * scalar}
   
-  VerdictVector& operator/=(const double scalar);
+  VERDICT_VECTOR_CONSTEXPR VerdictVector& operator/=(const double scalar);
     //- Compound Assignment: division: {this = this / scalar}
   
-  VerdictVector operator-() const;
+  constexpr VerdictVector operator-() const;
     //- unary negation.
   
   friend VerdictVector operator~(const VerdictVector &vec);
     //- normalize. Returns a new vector which is a copy of {vec},
     //- scaled such that {|vec|=1}. Uses overloaded bitwise NOT operator.
   
-  friend VerdictVector operator+(const VerdictVector &v1, 
+  friend constexpr VerdictVector operator+(const VerdictVector &v1, 
                                const VerdictVector &v2);
     //- vector addition
   
-  friend VerdictVector operator-(const VerdictVector &v1, 
+  friend constexpr VerdictVector operator-(const VerdictVector &v1, 
                                const VerdictVector &v2);
     //- vector subtraction
   
-  friend VerdictVector operator*(const VerdictVector &v1, 
+  friend constexpr VerdictVector operator*(const VerdictVector &v1, 
                                const VerdictVector &v2);
     //- vector cross product, non-commutative
   
-  friend VerdictVector operator*(const VerdictVector &v1, const double sclr);
+  friend constexpr VerdictVector operator*(const VerdictVector &v1, const double sclr);
     //- vector * scalar
   
-  friend VerdictVector operator*(const double sclr, const VerdictVector &v1);
+  friend constexpr VerdictVector operator*(const double sclr, const VerdictVector &v1);
     //- scalar * vector
   
-  friend double operator%(const VerdictVector &v1, const VerdictVector &v2);
+  friend constexpr double operator%(const VerdictVector &v1, const VerdictVector &v2);
     //- dot product
   
-  static double Dot(const VerdictVector &v1, const VerdictVector &v2);
+  static constexpr double Dot(const VerdictVector &v1, const VerdictVector &v2);
   //- dot product
 
-  friend VerdictVector operator/(const VerdictVector &v1, const double sclr);
+  friend VERDICT_VECTOR_CONSTEXPR VerdictVector operator/(const VerdictVector &v1, const double sclr);
     //- vector / scalar
   
-  friend int operator==(const VerdictVector &v1, const VerdictVector &v2);
+  friend constexpr int operator==(const VerdictVector &v1, const VerdictVector &v2);
     //- Equality operator
   
-  friend int operator!=(const VerdictVector &v1, const VerdictVector &v2);
+  friend constexpr int operator!=(const VerdictVector &v1, const VerdictVector &v2);
     //- Inequality operator
   
-  VerdictVector &operator=(const VerdictVector& from);
-  
+  // the implicit copy constructor and assignment keep the class trivially
+  // copyable
+
 private:
   
   double xVal;  //- x component of vector.
@@ -178,11 +190,11 @@ private:
   double zVal;  //- z component of vector.
 };
 
-inline double VerdictVector::x() const
+constexpr double VerdictVector::x() const
 { return xVal; }
-inline double VerdictVector::y() const
+constexpr double VerdictVector::y() const
 { return yVal; }
-inline double VerdictVector::z() const
+constexpr double VerdictVector::z() const
 { return zVal; }
 inline void VerdictVector::get_xyz(double xyz[3])
 {
@@ -210,7 +222,7 @@ inline void VerdictVector::r( const double xv )
 { xVal = xv; }
 inline void VerdictVector::theta( const double yv )
 { yVal = yv; }
-inline VerdictVector& VerdictVector::operator+=(const VerdictVector &vector)
+VERDICT_VECTOR_CONSTEXPR VerdictVector& VerdictVector::operator+=(const VerdictVector &vector)
 {
   xVal += vector.x();
   yVal += vector.y();
@@ -218,7 +230,7 @@ inline VerdictVector& VerdictVector::operator+=(const VerdictVector &vector)
   return *this;
 }
 
-inline VerdictVector& VerdictVector::operator-=(const VerdictVector &vector)
+VERDICT_VECTOR_CONSTEXPR VerdictVector& VerdictVector::operator-=(const VerdictVector &vector)
 {
   xVal -= vector.x();
   yVal -= vector.y();
@@ -226,39 +238,38 @@ inline VerdictVector& VerdictVector::operator-=(const VerdictVector &vector)
   return *this;
 }
 
-inline VerdictVector& VerdictVector::operator*=(const VerdictVector &vector)
+VERDICT_VECTOR_CONSTEXPR VerdictVector& VerdictVector::operator*=(const VerdictVector &vector)
 {
-  double xcross, ycross, zcross;
-  xcross = yVal * vector.z() - zVal * vector.y();
-  ycross = zVal * vector.x() - xVal * vector.z();
-  zcross = xVal * vector.y() - yVal * vector.x();
+  const double xcross = yVal * vector.z() - zVal * vector.y();
+  const double ycross = zVal * vector.x() - xVal * vector.z();
+  const double zcross = xVal * vector.y() - yVal * vector.x();
   xVal = xcross;
   yVal = ycross;
   zVal = zcross;
   return *this;
 }
 
-inline VerdictVector::VerdictVector(const VerdictVector& copy_from)
-    : xVal(copy_from.xVal), yVal(copy_from.yVal), zVal(copy_from.zVal)
-{}
-
-inline VerdictVector::VerdictVector()
+constexpr VerdictVector::VerdictVector()
     : xVal(0), yVal(0), zVal(0)
 {}
 
-inline VerdictVector::VerdictVector (const VerdictVector& tail,
+constexpr VerdictVector::VerdictVector (const VerdictVector& tail,
                                  const VerdictVector& head)
     : xVal(head.xVal - tail.xVal),
       yVal(head.yVal - tail.yVal),
       zVal(head.zVal - tail.zVal)
 {}
 
-inline VerdictVector::VerdictVector(const double xIn,
+constexpr VerdictVector::VerdictVector(const double xIn,
                                 const double yIn,
                                 const double zIn)
     : xVal(xIn), yVal(yIn), zVal(zIn)
 {}
 
+constexpr VerdictVector::VerdictVector(const double xyz[3])
+    : xVal(xyz[0]), yVal(xyz[1]), zVal(xyz[2])
+{}
+
 // This sets the vector to be perpendicular to it's current direction.
 // NOTE:
 //      This is a 2D function.  It only works in the XY Plane.
@@ -269,7 +280,7 @@ inline void VerdictVector::perpendicular_z()
   y( -temp );
 }
 
-inline void VerdictVector::set( const double xv,
+VERDICT_VECTOR_CONSTEXPR void VerdictVector::set( const double xv,
                                 const double yv,
                                 const double zv )
 {
@@ -278,14 +289,14 @@ inline void VerdictVector::set( const double xv,
   zVal = zv;
 }
 
-inline void VerdictVector::set(const double xyz[3])
+VERDICT_VECTOR_CONSTEXPR void VerdictVector::set(const double xyz[3])
 {
   xVal = xyz[0];
   yVal = xyz[1];
   zVal = xyz[2];
 }
 
-inline void VerdictVector::set(const VerdictVector& tail,
+VERDICT_VECTOR_CONSTEXPR void VerdictVector::set(const VerdictVector& tail,
                              const VerdictVector& head)
 {
   xVal = head.xVal - tail.xVal;
@@ -293,21 +304,13 @@ inline void VerdictVector::set(const VerdictVector& tail,
   zVal = head.zVal - tail.zVal;
 }
 
-inline VerdictVector& VerdictVector::operator=(const VerdictVector &from)  
-{
-  xVal = from.xVal; 
-  yVal = from.yVal; 
-  zVal = from.zVal; 
-  return *this;
-}
-
-inline void VerdictVector::set(const VerdictVector& to_copy)
+VERDICT_VECTOR_CONSTEXPR void VerdictVector::set(const VerdictVector& to_copy)
 {
   *this = to_copy;
 }
 
 // Scale all values by scalar.
-inline VerdictVector& VerdictVector::operator*=(const double scalar)
+VERDICT_VECTOR_CONSTEXPR VerdictVector& VerdictVector::operator*=(const double scalar)
 {
   xVal *= scalar;
   yVal *= scalar;
@@ -316,7 +319,7 @@ inline VerdictVector& VerdictVector::operator*=(const double scalar)
 }
 
 // Scales all values by 1/scalar
-inline VerdictVector& VerdictVector::operator/=(const double scalar)
+VERDICT_VECTOR_CONSTEXPR VerdictVector& VerdictVector::operator/=(const double scalar)
 {
   assert (scalar != 0);
   xVal /= scalar;
@@ -341,71 +344,70 @@ inline VerdictVector operator~(const VerdictVector &vec)
 }
 
 // Unary minus.  Negates all values in vector.
-inline VerdictVector VerdictVector::operator-() const
+constexpr VerdictVector VerdictVector::operator-() const
 {
   return VerdictVector(-xVal, -yVal, -zVal);
 }
 
-inline VerdictVector operator+(const VerdictVector &vector1,
+constexpr VerdictVector operator+(const VerdictVector &vector1,
                       const VerdictVector &vector2)
 {
-  double xv = vector1.x() + vector2.x();
-  double yv = vector1.y() + vector2.y();
-  double zv = vector1.z() + vector2.z();
-  return VerdictVector(xv,yv,zv);
-//  return VerdictVector(vector1) += vector2;
+  return VerdictVector(vector1.x() + vector2.x(),
+                       vector1.y() + vector2.y(),
+                       vector1.z() + vector2.z());
 }
 
-inline VerdictVector operator-(const VerdictVector &vector1,
+constexpr VerdictVector operator-(const VerdictVector &vector1,
                       const VerdictVector &vector2)
 {
-  double xv = vector1.x() - vector2.x();
-  double yv = vector1.y() - vector2.y();
-  double zv = vector1.z() - vector2.z();
-  return VerdictVector(xv,yv,zv);
-//  return VerdictVector(vector1) -= vector2;
+  return VerdictVector(vector1.x() - vector2.x(),
+                       vector1.y() - vector2.y(),
+                       vector1.z() - vector2.z());
 }
 
 // Cross products.
 // vector1 cross vector2
-inline VerdictVector operator*(const VerdictVector &vector1,
+constexpr VerdictVector operator*(const VerdictVector &vector1,
                       const VerdictVector &vector2)
 {
-  return VerdictVector(vector1) *= vector2;
+  return VerdictVector(vector1.y() * vector2.z() - vector1.z() * vector2.y(),
+                       vector1.z() * vector2.x() - vector1.x() * vector2.z(),
+                       vector1.x() * vector2.y() - vector1.y() * vector2.x());
 }
 
 // Returns a scaled vector.
-inline VerdictVector operator*(const VerdictVector &vector1,
+constexpr VerdictVector operator*(const VerdictVector &vector1,
                       const double scalar)
 {
-  return VerdictVector(vector1) *= scalar;
+  return VerdictVector(vector1.x() * scalar, vector1.y() * scalar, vector1.z() * scalar);
 }
 
 // Returns a scaled vector
-inline VerdictVector operator*(const double scalar,
+constexpr VerdictVector operator*(const double scalar,
                              const VerdictVector &vector1)
 {
-  return VerdictVector(vector1) *= scalar;
+  return VerdictVector(vector1.x() * scalar, vector1.y() * scalar, vector1.z() * scalar);
 }
 
 // Returns a vector scaled by 1/scalar
-inline VerdictVector operator/(const VerdictVector &vector1,
+VERDICT_VECTOR_CONSTEXPR VerdictVector operator/(const VerdictVector &vector1,
                              const double scalar)
 {
-  return VerdictVector(vector1) /= scalar;
+  assert (scalar != 0);
+  return VerdictVector(vector1.x() / scalar, vector1.y() / scalar, vector1.z() / scalar);
 }
 
-inline int operator==(const VerdictVector &v1, const VerdictVector &v2)
+constexpr int operator==(const VerdictVector &v1, const VerdictVector &v2)
 {
   return (v1.xVal == v2.xVal && v1.yVal == v2.yVal && v1.zVal == v2.zVal);
 }
 
-inline int operator!=(const VerdictVector &v1, const VerdictVector &v2)
+constexpr int operator!=(const VerdictVector &v1, const VerdictVector &v2)
 {
   return (v1.xVal != v2.xVal || v1.yVal != v2.yVal || v1.zVal != v2.zVal);
 }
 
-inline double VerdictVector::length_squared() const
+constexpr double VerdictVector::length_squared() const
 {
   return( xVal*xVal + yVal*yVal + zVal*zVal );
 }
@@ -428,18 +430,53 @@ inline double VerdictVector::normalize()
 }
 
 // Dot Product.
-inline double operator%(const VerdictVector &vector1,
-                        const VerdictVector &vector2)
-{
-  return VerdictVector::Dot(vector1, vector2);
-}
-inline double VerdictVector::Dot(const VerdictVector &vector1,
+constexpr double VerdictVector::Dot(const VerdictVector &vector1,
                                  const VerdictVector &vector2)
 {
   return( vector1.xVal * vector2.xVal +
           vector1.yVal * vector2.yVal +
           vector1.zVal * vector2.zVal );
 }
+constexpr double operator%(const VerdictVector &vector1,
+                        const VerdictVector &vector2)
+{
+  return VerdictVector::Dot(vector1, vector2);
+}
+
+inline double VerdictVector::interior_angle(const VerdictVector &otherVector)
+{
+  double cosAngle=0., angleRad=0., len1, len2=0.;
+  
+  if (((len1 = this->length()) > 0) && ((len2 = otherVector.length()) > 0))
+    cosAngle = VerdictVector::Dot(*this , otherVector)/(len1 * len2);
+  else
+  {
+    assert(len1 > 0);
+    assert(len2 > 0);
+  }
+  
+  if ((cosAngle > 1.0) && (cosAngle < 1.0001))
+  {
+    cosAngle = 1.0;
+    angleRad = acos(cosAngle);
+  }
+  else if (cosAngle < -1.0 && cosAngle > -1.0001)
+  {
+    cosAngle = -1.0;
+    angleRad = acos(cosAngle);
+  }
+  else if (cosAngle >= -1.0 && cosAngle <= 1.0)
+    angleRad = acos(cosAngle);
+  else
+  {
+    assert(cosAngle < 1.0001 && cosAngle > -1.0001);
+  }
+  
+  return( (angleRad * 180.) / VERDICT_PI );
+}
+
+static_assert( std::is_trivially_copyable<VerdictVector>::value,
+               "VerdictVector is copied by value through the metric kernels" );
 } // namespace verdict
 
 #endif
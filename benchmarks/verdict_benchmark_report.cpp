@@ -0,0 +1,310 @@
+/*!
+ * \brief Roofline report of the verdict benchmarks and comparison against a baseline
+ *
+ * The report is written one benchmark per line, so the comparison reads
+ * back its own reports without a JSON library.
+ */
+
+#include "verdict_benchmark_report.h"
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <verdict.h>
+#include <verdict_mesh.h>
+
+namespace
+{
+
+bool take_value(const char* arg, const char* option, std::string& value)
+{
+  const size_t length = strlen(option);
+  if (strncmp(arg, option, length) != 0 || arg[length] != '=')
+    return false;
+  value = arg + length + 1;
+  return true;
+}
+
+double mean(const std::vector<double>& values)
+{
+  double sum = 0;
+  for (double value : values)
+    sum += value;
+  return values.empty() ? 0 : sum / values.size();
+}
+
+double standard_deviation(const std::vector<double>& values)
+{
+  if (values.size() < 2)
+    return 0;
+  const double average = mean(values);
+  double sum = 0;
+  for (double value : values)
+    sum += (value - average) * (value - average);
+  return sqrt(sum / (values.size() - 1));
+}
+
+const char* simd_level_name(verdict::VerdictSimdLevel level)
+{
+  return level == verdict::VERDICT_SIMD_SCALAR ? "scalar" :
+    level == verdict::VERDICT_SIMD_NEON ? "neon" :
+    level == verdict::VERDICT_SIMD_AVX2 ? "avx2" : "avx512";
+}
+
+// bytes per second of a = b + s * c over arrays much larger than the caches, the best of a few passes
+double stream_bandwidth()
+{
+  const size_t n = 1 << 23;
+  std::vector<double> a(n, 0.0), b(n, 1.0), c(n, 2.0);
+  double best = 0;
+  for (int pass = 0; pass < 5; pass++)
+  {
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    const double s = 0.5 + pass;
+    for (size_t i = 0; i < n; i++)
+      a[i] = b[i] + s * c[i];
+    benchmark::DoNotOptimize(a.data());
+    benchmark::ClobberMemory();
+    const double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (seconds > 0)
+      best = std::max(best, 3 * sizeof(double) * n / seconds);
+  }
+  return best;
+}
+
+// a benchmark of a report
+struct Entry
+{
+  double time_per_element;
+  double stddev;
+};
+
+// the value of a numeric field of a report line, or false when it has none
+bool read_field(const char* line, const char* field, double& value)
+{
+  const std::string key = std::string("\"") + field + "\": ";
+  const char* at = strstr(line, key.c_str());
+  if (!at)
+    return false;
+  value = strtod(at + key.size(), nullptr);
+  return true;
+}
+
+bool read_report(const std::string& path, std::map<std::string, Entry>& entries, std::string& simd_level)
+{
+  FILE* file = fopen(path.c_str(), "r");
+  if (!file)
+    return false;
+  char line[4096];
+  while (fgets(line, sizeof(line), file))
+  {
+    const char* level = strstr(line, "\"simd_level\": \"");
+    if (level)
+    {
+      level += strlen("\"simd_level\": \"");
+      simd_level.assign(level, strcspn(level, "\""));
+    }
+
+    const char* name = strstr(line, "{\"name\": \"");
+    Entry entry;
+    if (!name || !read_field(line, "time_per_element", entry.time_per_element) ||
+        !read_field(line, "stddev", entry.stddev))
+      continue;
+    name += strlen("{\"name\": \"");
+    entries[std::string(name, strcspn(name, "\""))] = entry;
+  }
+  fclose(file);
+  return true;
+}
+
+bool write_report(const std::string& path, const ReportRecorder& recorder)
+{
+  FILE* file = fopen(path.c_str(), "w");
+  if (!file)
+    return false;
+
+  const double bandwidth = stream_bandwidth();
+  fprintf(file, "{\n  \"verdict_version\": %d,\n  \"simd_level\": \"%s\",\n  \"stream_bandwidth\": %.6g,\n",
+          VERDICT_VERSION, simd_level_name(verdict::simd_level()), bandwidth);
+
+  fprintf(file, "  \"benchmarks\": [\n");
+  for (size_t b = 0; b < recorder.names.size(); b++)
+  {
+    const ReportRecorder::Samples& samples = recorder.samples.find(recorder.names[b])->second;
+    const double time = samples.mean();
+    fprintf(file, "    {\"name\": \"%s\", \"repetitions\": %d, \"time_per_element\": %.6g, \"stddev\": %.6g",
+            recorder.names[b].c_str(), samples.repetitions(), time, samples.stddev());
+    if (samples.bytes_per_element > 0 && time > 0)
+    {
+      const double bytes_per_second = samples.bytes_per_element / time;
+      fprintf(file, ", \"bytes_per_element\": %g, \"bytes_per_second\": %.6g, \"bandwidth_fraction\": %.3f",
+              samples.bytes_per_element, bytes_per_second, bandwidth > 0 ? bytes_per_second / bandwidth : 0.);
+      if (samples.flops_per_element > 0)
+      {
+        // a kernel moving at least half the bandwidth of the triad is taken as limited by memory
+        fprintf(file, ", \"flops_per_element\": %g, \"flops_per_second\": %.6g, \"arithmetic_intensity\": %.3f, "
+                "\"bound\": \"%s\"",
+                samples.flops_per_element, samples.flops_per_element / time,
+                samples.flops_per_element / samples.bytes_per_element,
+                bytes_per_second >= 0.5 * bandwidth ? "memory" : "compute");
+      }
+    }
+    fprintf(file, "}%s\n", b + 1 < recorder.names.size() ? "," : "");
+  }
+  fprintf(file, "  ]");
+
+  if (verdict::instrumentation_enabled())
+  {
+    std::vector<verdict::VerdictCounter> counters(verdict::instrumentation_counters(nullptr, 0));
+    const int num_counters =
+      std::min(verdict::instrumentation_counters(counters.data(), (int)counters.size()), (int)counters.size());
+    fprintf(file, ",\n  \"counters\": [\n");
+    for (int c = 0; c < num_counters; c++)
+      fprintf(file, "    {\"counter\": \"%s\", \"calls\": %llu, \"ticks\": %llu}%s\n", counters[c].name,
+              counters[c].count, counters[c].is_metric ? counters[c].ticks : 0ull,
+              c + 1 < num_counters ? "," : "");
+    fprintf(file, "  ]");
+  }
+  fprintf(file, "\n}\n");
+  return fclose(file) == 0;
+}
+
+// prints the change of each benchmark and returns the number of regressions
+int compare_with_baseline(const ReportRecorder& recorder, const std::map<std::string, Entry>& baseline,
+                          double threshold)
+{
+  size_t width = 9;
+  for (const std::string& name : recorder.names)
+    width = std::max(width, name.size());
+
+  printf("\n%-*s %12s %12s %8s\n", (int)width, "benchmark", "baseline", "current", "change");
+  int regressions = 0, compared = 0;
+  for (const std::string& name : recorder.names)
+  {
+    const std::map<std::string, Entry>::const_iterator found = baseline.find(name);
+    if (found == baseline.end())
+      continue;
+    const ReportRecorder::Samples& samples = recorder.samples.find(name)->second;
+    const double before = found->second.time_per_element, after = samples.mean();
+    if (before <= 0)
+      continue;
+
+    const double stddev = samples.stddev();
+    const double noise = 2 * sqrt(stddev * stddev + found->second.stddev * found->second.stddev);
+    const bool slower = after - before > threshold * before && after - before > noise;
+    compared++;
+    regressions += slower ? 1 : 0;
+    printf("%-*s %9.3f ns %9.3f ns %+7.1f%%%s\n", (int)width, name.c_str(), 1e9 * before, 1e9 * after,
+           100 * (after - before) / before, slower ? "  slower" : "");
+  }
+  printf("%d of %d benchmarks slower than the baseline by more than %.1f%%\n", regressions, compared,
+         100 * threshold);
+  return regressions;
+}
+
+} // namespace
+
+bool parse_report_options(int& argc, char** argv, ReportOptions& options)
+{
+  int kept = 1;
+  bool valid = true;
+  for (int i = 1; i < argc; i++)
+  {
+    std::string threshold;
+    if (take_value(argv[i], "--verdict_report", options.report_path) ||
+        take_value(argv[i], "--verdict_baseline", options.baseline_path))
+      continue;
+    if (take_value(argv[i], "--verdict_threshold", threshold))
+    {
+      char* end;
+      options.threshold = strtod(threshold.c_str(), &end) / 100;
+      valid = valid && *end == 0 && options.threshold >= 0;
+      continue;
+    }
+    argv[kept++] = argv[i];
+  }
+  argc = kept;
+  return valid;
+}
+
+int ReportRecorder::Samples::repetitions() const
+{
+  return times.empty() ? aggregated : (int)times.size();
+}
+
+double ReportRecorder::Samples::mean() const
+{
+  return times.empty() ? aggregate_mean : ::mean(times);
+}
+
+double ReportRecorder::Samples::stddev() const
+{
+  return times.empty() ? aggregate_stddev : standard_deviation(times);
+}
+
+void ReportRecorder::ReportRuns(const std::vector<Run>& reports)
+{
+  benchmark::ConsoleReporter::ReportRuns(reports);
+  for (const Run& run : reports)
+  {
+    const benchmark::UserCounters::const_iterator time = run.counters.find("time_per_element");
+    if (run.error_occurred || time == run.counters.end())
+      continue;
+    const bool is_mean = run.run_type == Run::RT_Aggregate && run.aggregate_name == "mean";
+    const bool is_stddev = run.run_type == Run::RT_Aggregate && run.aggregate_name == "stddev";
+    if (run.run_type != Run::RT_Iteration && !is_mean && !is_stddev)
+      continue;
+
+    // the name without the suffix of the aggregates
+    const std::string name = run.run_name.str();
+    if (samples.find(name) == samples.end())
+      names.push_back(name);
+    Samples& entry = samples[name];
+    if (is_stddev)
+    {
+      entry.aggregate_stddev = time->second.value;
+      continue;
+    }
+    if (is_mean)
+    {
+      entry.aggregated = (int)run.repetitions;
+      entry.aggregate_mean = time->second.value;
+    }
+    else
+      entry.times.push_back(time->second.value);
+    const benchmark::UserCounters::const_iterator bytes = run.counters.find("bytes_per_element");
+    const benchmark::UserCounters::const_iterator flops = run.counters.find("flops_per_element");
+    if (bytes != run.counters.end())
+      entry.bytes_per_element = bytes->second.value;
+    if (flops != run.counters.end())
+      entry.flops_per_element = flops->second.value;
+  }
+}
+
+int finish_report(const ReportRecorder& recorder, const ReportOptions& options)
+{
+  if (!options.report_path.empty() && !write_report(options.report_path, recorder))
+  {
+    fprintf(stderr, "cannot write the report %s\n", options.report_path.c_str());
+    return 1;
+  }
+  if (options.baseline_path.empty())
+    return 0;
+
+  std::map<std::string, Entry> baseline;
+  std::string simd_level;
+  if (!read_report(options.baseline_path, baseline, simd_level))
+  {
+    fprintf(stderr, "cannot read the baseline %s\n", options.baseline_path.c_str());
+    return 1;
+  }
+  if (simd_level != simd_level_name(verdict::simd_level()))
+    printf("\nthe baseline ran at simd level %s, this run at %s\n", simd_level.c_str(),
+           simd_level_name(verdict::simd_level()));
+  return compare_with_baseline(recorder, baseline, options.threshold) > 0 ? 2 : 0;
+}
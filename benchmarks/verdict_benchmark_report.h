@@ -0,0 +1,74 @@
+/*!
+ * \brief Roofline report of the verdict benchmarks and comparison against a baseline
+ *
+ * With --verdict_report=<file> the benchmarks are also written to a JSON
+ * report: the time per element of each benchmark, averaged over its
+ * repetitions, with the bytes and floating point operations per element
+ * of the kernels that declare them and the bandwidth and operation rates
+ * they reach.  The bandwidth is compared with that of a STREAM triad
+ * measured by the report, which tells the kernels limited by memory from
+ * those limited by their arithmetic.  The instrumentation counters are
+ * added when verdict was built with them.
+ *
+ * With --verdict_baseline=<file>, a report from an earlier run, each
+ * benchmark is compared with its baseline and the benchmarks slower by
+ * more than --verdict_threshold=<percent>, 5 by default, and by more than
+ * twice their combined standard deviation are listed as regressions, so
+ * runs with --benchmark_repetitions only flag differences beyond their
+ * noise.  The benchmark binary then exits with status 2.
+ */
+
+#ifndef VERDICT_BENCHMARK_REPORT_H
+#define VERDICT_BENCHMARK_REPORT_H
+
+#include <benchmark/benchmark.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+struct ReportOptions
+{
+  std::string report_path;
+  std::string baseline_path;
+  double threshold = 0.05;
+
+  bool enabled() const { return !report_path.empty() || !baseline_path.empty(); }
+};
+
+// takes the --verdict_ options out of argv, returning false for a malformed one
+bool parse_report_options(int& argc, char** argv, ReportOptions& options);
+
+// the runs of each benchmark reporting time_per_element, printed to the console as they finish
+class ReportRecorder : public benchmark::ConsoleReporter
+{
+public:
+  struct Samples
+  {
+    std::vector<double> times;  // seconds per element, one per repetition
+    // the mean and standard deviation of the repetitions when only those are reported,
+    // as with --benchmark_report_aggregates_only
+    int aggregated = 0;
+    double aggregate_mean = 0;
+    double aggregate_stddev = 0;
+    double bytes_per_element = 0;
+    double flops_per_element = 0;
+
+    int repetitions() const;
+    double mean() const;
+    double stddev() const;
+  };
+
+  ReportRecorder() : benchmark::ConsoleReporter(OO_Tabular) {}
+
+  void ReportRuns(const std::vector<Run>& reports) override;
+
+  // the benchmarks in the order they ran, with their samples
+  std::vector<std::string> names;
+  std::map<std::string, Samples> samples;
+};
+
+// writes the report and compares it with the baseline; returns the exit status
+int finish_report(const ReportRecorder& recorder, const ReportOptions& options);
+
+#endif
@@ -0,0 +1,976 @@
+/*!
+ * \brief Benchmarks of the verdict metrics and mesh-level drivers
+ *
+ * Every metric of verdict.h is timed on batches of elements for each node
+ * count of its element type, once on well-shaped elements and once on a
+ * mix of flattened, collapsed and inverted ones, since the degenerate
+ * branches often cost differently.  The mesh scenarios time the batched,
+ * parallel and structure-of-arrays functions on a perturbed hex grid.
+ *
+ * Each benchmark reports time_per_element, printed in ns, and elements per
+ * second (items_per_second).  The kernels that declare them also report
+ * the bytes they move and the floating point operations they do per
+ * element, from which --verdict_report writes a roofline report; see
+ * verdict_benchmark_report.h.
+ */
+
+#include <benchmark/benchmark.h>
+#include "verdict_benchmark_report.h"
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+#include <math.h>
+#include <stdio.h>
+
+#include <verdict.h>
+#include <verdict_mesh.h>
+
+namespace
+{
+
+enum ElementType { TRI, QUAD, TET, PYRAMID, WEDGE, KNIFE, HEX, EDGE };
+
+const char* const element_names[] = { "tri", "quad", "tet", "pyramid", "wedge", "knife", "hex", "edge" };
+
+// the node counts of each element type that the metrics handle
+const std::vector<int> element_orders[] =
+{
+  { 3, 6, 7 },
+  { 4, 8, 9 },
+  { 4, 10, 15 },
+  { 5, 13 },
+  { 6, 15, 21 },
+  { 7 },
+  { 8, 20, 27 },
+  { 2, 3 }
+};
+
+const double one_third = 1.0 / 3.0;
+
+// parametric coordinates of the highest order nodes; lower orders use a prefix
+const double tri_nodes[7][3] =
+{
+  {0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {0.5, 0, 0}, {0.5, 0.5, 0}, {0, 0.5, 0}, {one_third, one_third, 0}
+};
+
+const double quad_nodes[9][3] =
+{
+  {-1, -1, 0}, {1, -1, 0}, {1, 1, 0}, {-1, 1, 0}, {0, -1, 0}, {1, 0, 0}, {0, 1, 0}, {-1, 0, 0}, {0, 0, 0}
+};
+
+const double tet_nodes[15][3] =
+{
+  {0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {0, 0, 1}, {0.5, 0, 0}, {0.5, 0.5, 0}, {0, 0.5, 0}, {0, 0, 0.5},
+  {0.5, 0, 0.5}, {0, 0.5, 0.5}, {one_third, one_third, 0}, {one_third, 0, one_third},
+  {one_third, one_third, one_third}, {0, one_third, one_third}, {0.25, 0.25, 0.25}
+};
+
+const double wedge_nodes[21][3] =
+{
+  {0, 0, -1}, {1, 0, -1}, {0, 1, -1}, {0, 0, 1}, {1, 0, 1}, {0, 1, 1},
+  {0.5, 0, -1}, {0.5, 0.5, -1}, {0, 0.5, -1}, {0, 0, 0}, {1, 0, 0}, {0, 1, 0},
+  {0.5, 0, 1}, {0.5, 0.5, 1}, {0, 0.5, 1},
+  {one_third, one_third, 0}, {one_third, one_third, -1}, {one_third, one_third, 1},
+  {0.5, 0.5, 0}, {0, 0.5, 0}, {0.5, 0, 0}
+};
+
+const double hex_nodes[27][3] =
+{
+  {-1, -1, -1}, {1, -1, -1}, {1, 1, -1}, {-1, 1, -1}, {-1, -1, 1}, {1, -1, 1}, {1, 1, 1}, {-1, 1, 1},
+  {0, -1, -1}, {1, 0, -1}, {0, 1, -1}, {-1, 0, -1}, {-1, -1, 0}, {1, -1, 0}, {1, 1, 0}, {-1, 1, 0},
+  {0, -1, 1}, {1, 0, 1}, {0, 1, 1}, {-1, 0, 1},
+  {0, 0, 0}, {0, 0, -1}, {0, 0, 1}, {-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}
+};
+
+// pyramid nodes: the corners, then the midpoints of the base edges and of the edges to the apex
+const double pyramid_corners[5][3] =
+{
+  {-1, -1, 0}, {1, -1, 0}, {1, 1, 0}, {-1, 1, 0}, {0, 0, 1}
+};
+const int pyramid_edges[8][2] = { {0, 1}, {1, 2}, {2, 3}, {3, 0}, {0, 4}, {1, 4}, {2, 4}, {3, 4} };
+
+// the knife is a hex with nodes 5 and 7 merged, numbered as in V_KnifeMetric.cpp
+const double knife_nodes[7][3] =
+{
+  {0, 0, 1}, {0.5, 0.5, 1}, {1, 0, 1}, {0.5, 1, 0.5}, {0, 0, 0}, {0.5, 0.5, 0}, {1, 0, 0}
+};
+
+// the node of a straight-sided element at a parametric position
+void map_node(ElementType type, const double local[3], double node[3])
+{
+  const double r = local[0], s = local[1], t = local[2];
+  switch (type)
+  {
+    case TRI:
+    case TET:
+      node[0] = r + 0.5 * s + 0.5 * t;
+      node[1] = 0.866025 * s + 0.288675 * t;
+      node[2] = 0.816497 * t;
+      return;
+    case QUAD:
+    case HEX:
+      node[0] = 0.5 * (r + 1);
+      node[1] = 0.5 * (s + 1);
+      node[2] = 0.5 * (t + 1);
+      return;
+    case WEDGE:
+      node[0] = r + 0.5 * s;
+      node[1] = 0.866025 * s;
+      node[2] = 0.5 * (t + 1);
+      return;
+    default:
+      node[0] = r;
+      node[1] = s;
+      node[2] = t;
+  }
+}
+
+struct ElementBatch
+{
+  int num_nodes;
+  int num_elements;
+  std::vector<double> coordinates;
+
+  double (*element(int e))[3]
+  {
+    return reinterpret_cast<double(*)[3]>(coordinates.data() + 3 * num_nodes * e);
+  }
+};
+
+// a reference element of the given type and node count
+std::vector<double> reference_element(ElementType type, int num_nodes)
+{
+  std::vector<double> nodes(3 * num_nodes);
+  for (int n = 0; n < num_nodes; n++)
+  {
+    double* node = &nodes[3 * n];
+    switch (type)
+    {
+      case TRI: map_node(type, tri_nodes[n], node); break;
+      case QUAD: map_node(type, quad_nodes[n], node); break;
+      case TET: map_node(type, tet_nodes[n], node); break;
+      case WEDGE: map_node(type, wedge_nodes[n], node); break;
+      case HEX: map_node(type, hex_nodes[n], node); break;
+      case KNIFE:
+        for (int c = 0; c < 3; c++)
+          node[c] = knife_nodes[n][c];
+        break;
+      case PYRAMID:
+        for (int c = 0; c < 3; c++)
+          node[c] = n < 5 ? pyramid_corners[n][c] :
+            0.5 * (pyramid_corners[pyramid_edges[n - 5][0]][c] + pyramid_corners[pyramid_edges[n - 5][1]][c]);
+        break;
+      case EDGE:
+        node[0] = n == 2 ? 0.5 : n;
+        node[1] = node[2] = 0;
+        break;
+    }
+  }
+  return nodes;
+}
+
+// deterministic perturbation in [-amplitude, amplitude]
+double perturbation(int i, double amplitude)
+{
+  return amplitude * sin(12.9898 * i + 78.233 * (i % 7));
+}
+
+/*
+  perturbed copies of the reference element, or for degenerate batches a
+  mix of flattened, collapsed to a point and inverted elements
+*/
+ElementBatch make_batch(ElementType type, int num_nodes, bool degenerate)
+{
+  const std::vector<double> reference = reference_element(type, num_nodes);
+  ElementBatch batch;
+  batch.num_nodes = num_nodes;
+  batch.num_elements = 256;
+  batch.coordinates.resize(3 * num_nodes * batch.num_elements);
+  for (int e = 0; e < batch.num_elements; e++)
+  {
+    double (*element)[3] = batch.element(e);
+    for (int n = 0; n < num_nodes; n++)
+      for (int c = 0; c < 3; c++)
+        element[n][c] = reference[3 * n + c] + perturbation((e * num_nodes + n) * 3 + c, 0.05);
+
+    if (!degenerate)
+      continue;
+    switch (e % 3)
+    {
+      case 0: // flattened onto a plane, or a line for surface elements
+        for (int n = 0; n < num_nodes; n++)
+          element[n][type == TRI || type == QUAD ? 1 : 2] = 0;
+        break;
+      case 1: // collapsed to a point
+        for (int n = 0; n < num_nodes; n++)
+          for (int c = 0; c < 3; c++)
+            element[n][c] = 1;
+        break;
+      case 2: // inverted by mirroring
+        for (int n = 0; n < num_nodes; n++)
+          element[n][0] = -element[n][0];
+        break;
+    }
+  }
+  return batch;
+}
+
+void set_element_counters(benchmark::State& state, long long elements_per_iteration)
+{
+  state.SetItemsProcessed(state.iterations() * elements_per_iteration);
+  state.counters["time_per_element"] = benchmark::Counter(
+    (double)elements_per_iteration, benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+}
+
+/*
+  the memory traffic and arithmetic of a kernel per element for the roofline
+  report.  The operations are the additions, multiplications, divisions and
+  square roots of the structure-of-arrays kernel, which the single element
+  function matches; comparisons and selections are not counted.
+*/
+void set_kernel_counters(benchmark::State& state, double bytes_per_element, double flops_per_element)
+{
+  state.counters["bytes_per_element"] = bytes_per_element;
+  if (flops_per_element > 0)
+    state.counters["flops_per_element"] = flops_per_element;
+}
+
+// the operations per element of the kernels of hex_scaled_jacobian for hex8 and of
+// tet_mean_ratio for tet4, counted in V_SimdMetric.hpp
+const double hex_scaled_jacobian_flops = 432;
+const double tet_mean_ratio_flops = 73;
+
+// the arrays a mesh-level function streams per hex of the grid: the connectivity, the result
+// and about one point, since each point is shared by eight hexes
+const double hex_mesh_bytes = 8 * sizeof(verdict::VerdictIndex) + sizeof(double) + 3 * sizeof(double);
+
+template <class Metric>
+void time_batch(benchmark::State& state, ElementBatch& batch, Metric metric)
+{
+  for (auto _ : state)
+  {
+    for (int e = 0; e < batch.num_elements; e++)
+      benchmark::DoNotOptimize(metric(batch.num_nodes, batch.element(e)));
+    benchmark::ClobberMemory();
+  }
+  set_element_counters(state, batch.num_elements);
+  set_kernel_counters(state, 3 * sizeof(double) * batch.num_nodes, 0);
+}
+
+struct NamedMetric
+{
+  const char* name;
+  ElementType type;
+  verdict::VerdictFunction function;
+};
+
+#define VERDICT_METRIC(type, name) { #name, type, verdict::name }
+
+const NamedMetric metrics[] =
+{
+  VERDICT_METRIC(EDGE, edge_length),
+
+  VERDICT_METRIC(TRI, tri_edge_ratio), VERDICT_METRIC(TRI, tri_aspect_ratio),
+  VERDICT_METRIC(TRI, tri_radius_ratio), VERDICT_METRIC(TRI, tri_aspect_frobenius),
+  VERDICT_METRIC(TRI, tri_area), VERDICT_METRIC(TRI, tri_minimum_angle),
+  VERDICT_METRIC(TRI, tri_maximum_angle), VERDICT_METRIC(TRI, tri_condition),
+  VERDICT_METRIC(TRI, tri_scaled_jacobian), VERDICT_METRIC(TRI, tri_shape),
+  VERDICT_METRIC(TRI, tri_distortion), VERDICT_METRIC(TRI, tri_equiangle_skew),
+  // tri_shear is declared in verdict.h but has no definition
+
+  VERDICT_METRIC(QUAD, quad_edge_ratio), VERDICT_METRIC(QUAD, quad_max_edge_ratio),
+  VERDICT_METRIC(QUAD, quad_aspect_ratio), VERDICT_METRIC(QUAD, quad_radius_ratio),
+  VERDICT_METRIC(QUAD, quad_med_aspect_frobenius), VERDICT_METRIC(QUAD, quad_max_aspect_frobenius),
+  VERDICT_METRIC(QUAD, quad_skew), VERDICT_METRIC(QUAD, quad_taper),
+  VERDICT_METRIC(QUAD, quad_warpage), VERDICT_METRIC(QUAD, quad_area),
+  VERDICT_METRIC(QUAD, quad_stretch), VERDICT_METRIC(QUAD, quad_minimum_angle),
+  VERDICT_METRIC(QUAD, quad_maximum_angle), VERDICT_METRIC(QUAD, quad_oddy),
+  VERDICT_METRIC(QUAD, quad_condition), VERDICT_METRIC(QUAD, quad_jacobian),
+  VERDICT_METRIC(QUAD, quad_scaled_jacobian), VERDICT_METRIC(QUAD, quad_shear),
+  VERDICT_METRIC(QUAD, quad_shape), VERDICT_METRIC(QUAD, quad_distortion),
+  VERDICT_METRIC(QUAD, quad_equiangle_skew),
+
+  VERDICT_METRIC(TET, tet_inradius), VERDICT_METRIC(TET, tet_edge_ratio),
+  VERDICT_METRIC(TET, tet_radius_ratio), VERDICT_METRIC(TET, tet_aspect_ratio),
+  VERDICT_METRIC(TET, tet_aspect_gamma), VERDICT_METRIC(TET, tet_aspect_frobenius),
+  VERDICT_METRIC(TET, tet_minimum_angle), VERDICT_METRIC(TET, tet_collapse_ratio),
+  VERDICT_METRIC(TET, tet_volume), VERDICT_METRIC(TET, tet_condition),
+  VERDICT_METRIC(TET, tet_jacobian), VERDICT_METRIC(TET, tet_scaled_jacobian),
+  VERDICT_METRIC(TET, tet_mean_ratio), VERDICT_METRIC(TET, tet_shape),
+  VERDICT_METRIC(TET, tet_distortion), VERDICT_METRIC(TET, tet_equivolume_skew),
+  VERDICT_METRIC(TET, tet_squish_index), VERDICT_METRIC(TET, tet_equiangle_skew),
+
+  VERDICT_METRIC(PYRAMID, pyramid_volume), VERDICT_METRIC(PYRAMID, pyramid_jacobian),
+  VERDICT_METRIC(PYRAMID, pyramid_scaled_jacobian), VERDICT_METRIC(PYRAMID, pyramid_shape),
+  VERDICT_METRIC(PYRAMID, pyramid_equiangle_skew),
+
+  VERDICT_METRIC(WEDGE, wedge_volume), VERDICT_METRIC(WEDGE, wedge_edge_ratio),
+  VERDICT_METRIC(WEDGE, wedge_max_aspect_frobenius), VERDICT_METRIC(WEDGE, wedge_mean_aspect_frobenius),
+  VERDICT_METRIC(WEDGE, wedge_jacobian), VERDICT_METRIC(WEDGE, wedge_distortion),
+  VERDICT_METRIC(WEDGE, wedge_max_stretch), VERDICT_METRIC(WEDGE, wedge_scaled_jacobian),
+  VERDICT_METRIC(WEDGE, wedge_shape), VERDICT_METRIC(WEDGE, wedge_condition),
+  VERDICT_METRIC(WEDGE, wedge_equiangle_skew),
+
+  VERDICT_METRIC(KNIFE, knife_volume),
+
+  VERDICT_METRIC(HEX, hex_edge_ratio), VERDICT_METRIC(HEX, hex_max_edge_ratio),
+  VERDICT_METRIC(HEX, hex_skew), VERDICT_METRIC(HEX, hex_taper),
+  VERDICT_METRIC(HEX, hex_volume), VERDICT_METRIC(HEX, hex_stretch),
+  VERDICT_METRIC(HEX, hex_diagonal), VERDICT_METRIC(HEX, hex_dimension),
+  VERDICT_METRIC(HEX, hex_oddy), VERDICT_METRIC(HEX, hex_med_aspect_frobenius),
+  VERDICT_METRIC(HEX, hex_max_aspect_frobenius), VERDICT_METRIC(HEX, hex_condition),
+  VERDICT_METRIC(HEX, hex_jacobian), VERDICT_METRIC(HEX, hex_scaled_jacobian),
+  VERDICT_METRIC(HEX, hex_nodal_jacobian_ratio), VERDICT_METRIC(HEX, hex_shear),
+  VERDICT_METRIC(HEX, hex_shape), VERDICT_METRIC(HEX, hex_distortion),
+  VERDICT_METRIC(HEX, hex_equiangle_skew)
+};
+
+// the metrics taking the average size of the mesh
+struct NamedSizeMetric
+{
+  const char* name;
+  ElementType type;
+  double (*function)(int, double[][3], double);
+};
+
+#define VERDICT_SIZE_METRIC(type, name) { #name, type, verdict::name }
+
+const NamedSizeMetric size_metrics[] =
+{
+  VERDICT_SIZE_METRIC(TRI, tri_relative_size_squared), VERDICT_SIZE_METRIC(TRI, tri_shape_and_size),
+  VERDICT_SIZE_METRIC(QUAD, quad_relative_size_squared), VERDICT_SIZE_METRIC(QUAD, quad_shape_and_size),
+  VERDICT_SIZE_METRIC(QUAD, quad_shear_and_size),
+  VERDICT_SIZE_METRIC(TET, tet_relative_size_squared), VERDICT_SIZE_METRIC(TET, tet_shape_and_size),
+  VERDICT_SIZE_METRIC(HEX, hex_relative_size_squared), VERDICT_SIZE_METRIC(HEX, hex_shape_and_size),
+  VERDICT_SIZE_METRIC(HEX, hex_shear_and_size)
+};
+
+// the metric name, element type and order, and input shape of a benchmark
+std::string element_benchmark_name(const char* metric, ElementType type, int num_nodes, bool degenerate)
+{
+  return std::string(metric) + "/" + element_names[type] + std::to_string(num_nodes) +
+    (degenerate ? "/degenerate" : "/well_shaped");
+}
+
+template <class Register>
+void for_each_input(ElementType type, Register register_input)
+{
+  for (int num_nodes : element_orders[type])
+    for (bool degenerate : { false, true })
+      register_input(num_nodes, degenerate);
+}
+
+void register_element_benchmarks()
+{
+  for (const NamedMetric& metric : metrics)
+    for_each_input(metric.type, [&](int num_nodes, bool degenerate)
+    {
+      verdict::VerdictFunction function = metric.function;
+      const ElementType type = metric.type;
+      const double flops =
+        function == verdict::hex_scaled_jacobian && num_nodes == 8 ? hex_scaled_jacobian_flops :
+        function == verdict::tet_mean_ratio && num_nodes == 4 ? tet_mean_ratio_flops : 0;
+      benchmark::RegisterBenchmark(
+        element_benchmark_name(metric.name, type, num_nodes, degenerate).c_str(),
+        [=](benchmark::State& state)
+        {
+          ElementBatch batch = make_batch(type, num_nodes, degenerate);
+          time_batch(state, batch, function);
+          set_kernel_counters(state, 3 * sizeof(double) * num_nodes, flops);
+        });
+    });
+
+  for (const NamedSizeMetric& metric : size_metrics)
+    for_each_input(metric.type, [&](int num_nodes, bool degenerate)
+    {
+      double (*function)(int, double[][3], double) = metric.function;
+      const ElementType type = metric.type;
+      benchmark::RegisterBenchmark(
+        element_benchmark_name(metric.name, type, num_nodes, degenerate).c_str(),
+        [=](benchmark::State& state)
+        {
+          ElementBatch batch = make_batch(type, num_nodes, degenerate);
+          const double average = type == HEX || type == QUAD ? 1.0 : 0.5;
+          time_batch(state, batch, [=](int n, double coordinates[][3])
+                     { return function(n, coordinates, average); });
+        });
+    });
+
+  // the one pass bundles and the threshold predicates
+  for_each_input(HEX, [](int num_nodes, bool degenerate)
+  {
+    benchmark::RegisterBenchmark(
+      element_benchmark_name("hex_quality", HEX, num_nodes, degenerate).c_str(),
+      [=](benchmark::State& state)
+      {
+        ElementBatch batch = make_batch(HEX, num_nodes, degenerate);
+        time_batch(state, batch, [](int n, double coordinates[][3])
+        {
+          verdict::HexQuality quality;
+          verdict::hex_quality(n, coordinates, verdict::HEX_ALL_METRICS, quality);
+          return quality.scaled_jacobian;
+        });
+      });
+    benchmark::RegisterBenchmark(
+      element_benchmark_name("hex_jacobian_at_least", HEX, num_nodes, degenerate).c_str(),
+      [=](benchmark::State& state)
+      {
+        ElementBatch batch = make_batch(HEX, num_nodes, degenerate);
+        time_batch(state, batch, [](int n, double coordinates[][3])
+                   { return verdict::hex_jacobian_at_least(n, coordinates, 0.0); });
+      });
+    benchmark::RegisterBenchmark(
+      element_benchmark_name("hex_scaled_jacobian_at_least", HEX, num_nodes, degenerate).c_str(),
+      [=](benchmark::State& state)
+      {
+        ElementBatch batch = make_batch(HEX, num_nodes, degenerate);
+        time_batch(state, batch, [](int n, double coordinates[][3])
+                   { return verdict::hex_scaled_jacobian_at_least(n, coordinates, 0.2); });
+      });
+    benchmark::RegisterBenchmark(
+      element_benchmark_name("hex_jacobian_estimate", HEX, num_nodes, degenerate).c_str(),
+      [=](benchmark::State& state)
+      {
+        ElementBatch batch = make_batch(HEX, num_nodes, degenerate);
+        time_batch(state, batch, [](int n, double coordinates[][3])
+        {
+          verdict::MetricEstimate estimate;
+          verdict::hex_jacobian_estimate(n, coordinates, estimate);
+          return estimate.lower;
+        });
+      });
+  });
+
+  for_each_input(TET, [](int num_nodes, bool degenerate)
+  {
+    benchmark::RegisterBenchmark(
+      element_benchmark_name("tet_quality", TET, num_nodes, degenerate).c_str(),
+      [=](benchmark::State& state)
+      {
+        ElementBatch batch = make_batch(TET, num_nodes, degenerate);
+        time_batch(state, batch, [](int n, double coordinates[][3])
+        {
+          verdict::TetQuality quality;
+          verdict::tet_quality(n, coordinates, verdict::TET_ALL_METRICS, quality);
+          return quality.scaled_jacobian;
+        });
+      });
+    benchmark::RegisterBenchmark(
+      element_benchmark_name("tet_jacobian_estimate", TET, num_nodes, degenerate).c_str(),
+      [=](benchmark::State& state)
+      {
+        ElementBatch batch = make_batch(TET, num_nodes, degenerate);
+        time_batch(state, batch, [](int n, double coordinates[][3])
+        {
+          verdict::MetricEstimate estimate;
+          verdict::tet_jacobian_estimate(n, coordinates, estimate);
+          return estimate.lower;
+        });
+      });
+  });
+
+  for_each_input(PYRAMID, [](int num_nodes, bool degenerate)
+  {
+    benchmark::RegisterBenchmark(
+      element_benchmark_name("pyramid_quality", PYRAMID, num_nodes, degenerate).c_str(),
+      [=](benchmark::State& state)
+      {
+        ElementBatch batch = make_batch(PYRAMID, num_nodes, degenerate);
+        time_batch(state, batch, [](int n, double coordinates[][3])
+        {
+          verdict::PyramidQuality quality;
+          verdict::pyramid_quality(n, coordinates, verdict::PYRAMID_ALL_METRICS, quality);
+          return quality.scaled_jacobian;
+        });
+      });
+  });
+
+  for_each_input(WEDGE, [](int num_nodes, bool degenerate)
+  {
+    benchmark::RegisterBenchmark(
+      element_benchmark_name("wedge_quality", WEDGE, num_nodes, degenerate).c_str(),
+      [=](benchmark::State& state)
+      {
+        ElementBatch batch = make_batch(WEDGE, num_nodes, degenerate);
+        time_batch(state, batch, [](int n, double coordinates[][3])
+        {
+          verdict::WedgeQuality quality;
+          verdict::wedge_quality(n, coordinates, verdict::WEDGE_ALL_METRICS, quality);
+          return quality.scaled_jacobian;
+        });
+      });
+    benchmark::RegisterBenchmark(
+      element_benchmark_name("wedge_jacobian_estimate", WEDGE, num_nodes, degenerate).c_str(),
+      [=](benchmark::State& state)
+      {
+        ElementBatch batch = make_batch(WEDGE, num_nodes, degenerate);
+        time_batch(state, batch, [](int n, double coordinates[][3])
+        {
+          verdict::MetricEstimate estimate;
+          verdict::wedge_jacobian_estimate(n, coordinates, estimate);
+          return estimate.lower;
+        });
+      });
+  });
+}
+
+// a structured block of n x n x n perturbed hexes
+struct HexGrid
+{
+  std::vector<double> points;
+  std::vector<verdict::VerdictIndex> connectivity;
+  std::vector<double> soa;  // the corners of each hex, structure of arrays
+  std::vector<float> soa_float;
+  std::vector<double> tet_soa;  // the corner tets at node 0 of the hexes, nodes 0, 1, 3 and 4
+  verdict::VerdictIndex num_elements;
+
+  explicit HexGrid(int n)
+  {
+    const int np = n + 1;
+    for (int k = 0; k < np; k++)
+      for (int j = 0; j < np; j++)
+        for (int i = 0; i < np; i++)
+        {
+          const int id = (k * np + j) * np + i;
+          points.push_back(i + 0.2 * sin(1.7 * id));
+          points.push_back(j + 0.2 * sin(2.3 * id + 1.0));
+          points.push_back(k + 0.2 * sin(3.1 * id + 2.0));
+        }
+    for (int k = 0; k < n; k++)
+      for (int j = 0; j < n; j++)
+        for (int i = 0; i < n; i++)
+        {
+          const verdict::VerdictIndex p0 = (k * np + j) * np + i;
+          const verdict::VerdictIndex corners[8] =
+          {
+            p0, p0 + 1, p0 + np + 1, p0 + np,
+            p0 + np * np, p0 + np * np + 1, p0 + np * np + np + 1, p0 + np * np + np
+          };
+          connectivity.insert(connectivity.end(), corners, corners + 8);
+        }
+    num_elements = (verdict::VerdictIndex)connectivity.size() / 8;
+
+    soa.resize(24 * num_elements);
+    for (verdict::VerdictIndex e = 0; e < num_elements; e++)
+      for (int c = 0; c < 8; c++)
+        for (int d = 0; d < 3; d++)
+          soa[(3 * c + d) * num_elements + e] = points[3 * connectivity[8 * e + c] + d];
+    soa_float.assign(soa.begin(), soa.end());
+
+    const int tet_corners[4] = { 0, 1, 3, 4 };
+    tet_soa.resize(12 * num_elements);
+    for (int c = 0; c < 4; c++)
+      for (int d = 0; d < 3; d++)
+        std::copy(soa.begin() + (3 * tet_corners[c] + d) * num_elements,
+                  soa.begin() + (3 * tet_corners[c] + d + 1) * num_elements,
+                  tet_soa.begin() + (3 * c + d) * num_elements);
+  }
+
+  const double* soa_of(double) const { return soa.data(); }
+  const float* soa_of(float) const { return soa_float.data(); }
+};
+
+const HexGrid& mesh()
+{
+  static const HexGrid grid(64);
+  return grid;
+}
+
+void BM_mesh_quality(benchmark::State& state)
+{
+  const HexGrid& grid = mesh();
+  std::vector<double> results(grid.num_elements);
+  for (auto _ : state)
+  {
+    verdict::mesh_quality(verdict::hex_scaled_jacobian, grid.num_elements, 8, grid.points.data(),
+                          grid.connectivity.data(), results.data());
+    benchmark::ClobberMemory();
+  }
+  set_element_counters(state, grid.num_elements);
+  set_kernel_counters(state, hex_mesh_bytes, hex_scaled_jacobian_flops);
+}
+BENCHMARK(BM_mesh_quality)->Unit(benchmark::kMillisecond);
+
+// through the registry: the SoA kernels of hex_scaled_jacobian (0), the inlined hex_shape kernel
+// (1) and hex_oddy, which has no specialized loop (2)
+void BM_registered_mesh_quality(benchmark::State& state)
+{
+  const verdict::VerdictMetric metrics[] =
+  {
+    verdict::VERDICT_METRIC_HEX_SCALED_JACOBIAN, verdict::VERDICT_METRIC_HEX_SHAPE,
+    verdict::VERDICT_METRIC_HEX_ODDY
+  };
+  const HexGrid& grid = mesh();
+  std::vector<double> results(grid.num_elements);
+  for (auto _ : state)
+  {
+    verdict::mesh_quality(metrics[state.range(0)], grid.num_elements, 8, grid.points.data(),
+                          grid.connectivity.data(), 0., results.data());
+    benchmark::ClobberMemory();
+  }
+  set_element_counters(state, grid.num_elements);
+  set_kernel_counters(state, hex_mesh_bytes, state.range(0) == 0 ? hex_scaled_jacobian_flops : 0);
+}
+BENCHMARK(BM_registered_mesh_quality)->ArgName("metric")->DenseRange(0, 2)->Unit(benchmark::kMillisecond);
+
+// a report rerun on an unchanged mesh: hex_distortion evaluated (0) and found in a warm
+// MetricResultCache (1)
+void BM_cached_mesh_quality(benchmark::State& state)
+{
+  const HexGrid& grid = mesh();
+  std::vector<double> results(grid.num_elements);
+  verdict::MetricResultCache cache(2 * grid.num_elements);
+  const bool cached = state.range(0) != 0;
+  if (cached)
+    cache.mesh_quality(verdict::VERDICT_METRIC_HEX_DISTORTION, grid.num_elements, 8, grid.points.data(),
+                       grid.connectivity.data(), 0., results.data(), 1);
+  for (auto _ : state)
+  {
+    if (cached)
+      cache.mesh_quality(verdict::VERDICT_METRIC_HEX_DISTORTION, grid.num_elements, 8, grid.points.data(),
+                         grid.connectivity.data(), 0., results.data(), 1);
+    else
+      verdict::mesh_quality(verdict::VERDICT_METRIC_HEX_DISTORTION, grid.num_elements, 8, grid.points.data(),
+                            grid.connectivity.data(), 0., results.data());
+    benchmark::ClobberMemory();
+  }
+  set_element_counters(state, grid.num_elements);
+}
+BENCHMARK(BM_cached_mesh_quality)->ArgName("cached")->DenseRange(0, 1)->Unit(benchmark::kMillisecond);
+
+// a generator copying out the grid in blocks, as it would produce them, and checking each
+// block for two metrics before (0) or while (1) it produces the next, through a MeshQualityQueue
+void BM_mesh_quality_queue(benchmark::State& state)
+{
+  const HexGrid& grid = mesh();
+  const verdict::VerdictMetric metrics[2] = { verdict::VERDICT_METRIC_HEX_SCALED_JACOBIAN,
+                                              verdict::VERDICT_METRIC_HEX_SHAPE };
+  const int num_blocks = 16, num_buffers = 3;
+  const verdict::VerdictIndex block_elements = grid.num_elements / num_blocks;
+  std::vector<verdict::VerdictIndex> buffers[num_buffers];
+  std::vector<double> results[2];
+  for (int b = 0; b < num_buffers; b++)
+    buffers[b].resize(8 * block_elements);
+  for (int m = 0; m < 2; m++)
+    results[m].resize(grid.num_elements);
+
+  const bool queued = state.range(0) != 0;
+  verdict::MeshQualityQueue queue(num_buffers - 1, 0);
+  for (auto _ : state)
+  {
+    verdict::VerdictIndex tickets[num_buffers] = { 0, 0, 0 };
+    for (int b = 0; b < num_blocks; b++)
+    {
+      // a buffer is produced again once its last block completed
+      std::vector<verdict::VerdictIndex>& buffer = buffers[b % num_buffers];
+      queue.wait(tickets[b % num_buffers]);
+      std::copy(grid.connectivity.begin() + 8 * block_elements * b,
+                grid.connectivity.begin() + 8 * block_elements * (b + 1), buffer.begin());
+
+      double* const block_results[2] = { results[0].data() + block_elements * b,
+                                         results[1].data() + block_elements * b };
+      const verdict::QualityBlock block = { block_elements, 8, grid.points.data(), buffer.data(), 0., 2,
+                                            metrics, block_results };
+      if (queued)
+        tickets[b % num_buffers] = queue.submit(block, nullptr, nullptr);
+      else
+        for (int m = 0; m < 2; m++)
+          verdict::parallel_mesh_quality(metrics[m], block_elements, 8, grid.points.data(), buffer.data(),
+                                         0., block_results[m], 0);
+    }
+    queue.wait_all();
+    benchmark::ClobberMemory();
+  }
+  set_element_counters(state, num_blocks * block_elements);
+}
+BENCHMARK(BM_mesh_quality_queue)->ArgName("queued")->DenseRange(0, 1)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+void BM_parallel_mesh_quality(benchmark::State& state)
+{
+  const HexGrid& grid = mesh();
+  std::vector<double> results(grid.num_elements);
+  for (auto _ : state)
+  {
+    verdict::parallel_mesh_quality(verdict::hex_scaled_jacobian, grid.num_elements, 8,
+                                   grid.points.data(), grid.connectivity.data(), results.data(),
+                                   (int)state.range(0));
+    benchmark::ClobberMemory();
+  }
+  set_element_counters(state, grid.num_elements);
+  set_kernel_counters(state, hex_mesh_bytes, hex_scaled_jacobian_flops);
+}
+BENCHMARK(BM_parallel_mesh_quality)->ArgName("threads")->RangeMultiplier(2)
+  ->Range(1, 2 * (int)std::thread::hardware_concurrency())->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// the grid with its elements and points shuffled, evaluated in file order (0), along the
+// Hilbert curve (1) and along the curve with the points renumbered (2)
+void BM_ordered_mesh_quality(benchmark::State& state)
+{
+  const HexGrid& grid = mesh();
+  const verdict::VerdictIndex num_points = (verdict::VerdictIndex)grid.points.size() / 3;
+  std::vector<double> points(grid.points.size());
+  for (verdict::VerdictIndex p = 0; p < num_points; p++)
+    for (int c = 0; c < 3; c++)
+      points[3 * ((p * 7919) % num_points) + c] = grid.points[3 * p + c];
+  std::vector<verdict::VerdictIndex> connectivity(grid.connectivity.size());
+  for (verdict::VerdictIndex e = 0; e < grid.num_elements; e++)
+    for (int i = 0; i < 8; i++)
+      connectivity[8 * ((e * 104729) % grid.num_elements) + i] =
+        (grid.connectivity[8 * e + i] * 7919) % num_points;
+
+  std::vector<verdict::VerdictIndex> order(grid.num_elements);
+  for (verdict::VerdictIndex e = 0; e < grid.num_elements; e++)
+    order[e] = e;
+  if (state.range(0) > 0)
+  {
+    verdict::mesh_element_order(verdict::VERDICT_CURVE_HILBERT, grid.num_elements, 8, points.data(),
+                                connectivity.data(), order.data(), 0);
+    std::vector<double> new_points(state.range(0) > 1 ? points.size() : 0);
+    std::vector<verdict::VerdictIndex> new_connectivity(connectivity.size());
+    verdict::mesh_reorder(grid.num_elements, 8, points.data(), num_points, connectivity.data(),
+                          order.data(), state.range(0) > 1 ? new_points.data() : nullptr,
+                          new_connectivity.data());
+    if (state.range(0) > 1)
+      points.swap(new_points);
+    connectivity.swap(new_connectivity);
+  }
+
+  std::vector<double> results(grid.num_elements);
+  for (auto _ : state)
+  {
+    verdict::ordered_mesh_quality(verdict::hex_scaled_jacobian, grid.num_elements, 8, points.data(),
+                                  connectivity.data(), order.data(), results.data(), 1);
+    benchmark::ClobberMemory();
+  }
+  set_element_counters(state, grid.num_elements);
+}
+BENCHMARK(BM_ordered_mesh_quality)->ArgName("order")->DenseRange(0, 2)->Unit(benchmark::kMillisecond);
+
+void BM_mesh_statistics(benchmark::State& state)
+{
+  const HexGrid& grid = mesh();
+  const verdict::MeshStatisticsRequest request = { 0.5, 1.0, 10, 16, true };
+  verdict::MeshStatistics statistics;
+  for (auto _ : state)
+  {
+    verdict::mesh_statistics(verdict::hex_scaled_jacobian, grid.num_elements, 8, grid.points.data(),
+                             grid.connectivity.data(), request, statistics, (int)state.range(0));
+    benchmark::DoNotOptimize(statistics.mean);
+  }
+  set_element_counters(state, grid.num_elements);
+}
+BENCHMARK(BM_mesh_statistics)->ArgName("threads")->Arg(1)->Arg(0)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+void BM_mesh_failing_elements(benchmark::State& state)
+{
+  const HexGrid& grid = mesh();
+  std::vector<unsigned long long> failing((grid.num_elements + 63) / 64);
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(verdict::mesh_failing_elements(
+      verdict::hex_scaled_jacobian_at_least, 0.2, grid.num_elements, 8, grid.points.data(),
+      grid.connectivity.data(), failing.data(), (int)state.range(0)));
+  }
+  set_element_counters(state, grid.num_elements);
+}
+BENCHMARK(BM_mesh_failing_elements)->ArgName("threads")->Arg(1)->Arg(0)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+void BM_mesh_size_quality(benchmark::State& state)
+{
+  const HexGrid& grid = mesh();
+  std::vector<double> results(grid.num_elements);
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(verdict::mesh_size_quality(
+      verdict::VERDICT_SIZE_HEX, verdict::VERDICT_SHAPE_AND_SIZE, grid.num_elements, 8,
+      grid.points.data(), grid.connectivity.data(), results.data(), 1));
+  }
+  set_element_counters(state, grid.num_elements);
+}
+BENCHMARK(BM_mesh_size_quality)->Unit(benchmark::kMillisecond);
+
+// a hex_timestep pass followed by a hex_scaled_jacobian pass (0), against the fused sweep (1)
+void BM_mesh_timestep(benchmark::State& state)
+{
+  const HexGrid& grid = mesh();
+  const std::vector<double> density(grid.num_elements, 7800.0);
+  const std::vector<double> poissons_ratio(grid.num_elements, 0.3);
+  const std::vector<double> youngs_modulus(grid.num_elements, 2e11);
+  std::vector<double> timesteps(grid.num_elements), scaled_jacobians(grid.num_elements);
+  std::vector<unsigned char> inverted(grid.num_elements);
+  for (auto _ : state)
+  {
+    if (state.range(0) == 0)
+    {
+      double minimum = verdict::VERDICT_DBL_MAX;
+      for (verdict::VerdictIndex e = 0; e < grid.num_elements; e++)
+      {
+        double coordinates[8][3];
+        for (int c = 0; c < 8; c++)
+          for (int d = 0; d < 3; d++)
+            coordinates[c][d] = grid.points[3 * grid.connectivity[8 * e + c] + d];
+        timesteps[e] = verdict::hex_timestep(8, coordinates, density[e], poissons_ratio[e], youngs_modulus[e]);
+        minimum = std::min(minimum, timesteps[e]);
+      }
+      verdict::mesh_quality(verdict::hex_scaled_jacobian, grid.num_elements, 8, grid.points.data(),
+                            grid.connectivity.data(), scaled_jacobians.data());
+      benchmark::DoNotOptimize(minimum);
+    }
+    else
+    {
+      verdict::MeshTimestep timestep;
+      verdict::mesh_timestep(verdict::VERDICT_ELEMENT_HEX, grid.num_elements, 8, grid.points.data(),
+                             grid.connectivity.data(), density.data(), poissons_ratio.data(),
+                             youngs_modulus.data(), timesteps.data(), inverted.data(), timestep, 1);
+      benchmark::DoNotOptimize(timestep.minimum);
+    }
+    benchmark::ClobberMemory();
+  }
+  set_element_counters(state, grid.num_elements);
+}
+BENCHMARK(BM_mesh_timestep)->ArgName("fused")->DenseRange(0, 1)->Unit(benchmark::kMillisecond);
+
+// rescoring after a few hundred points move, against a full mesh_quality pass
+void BM_mesh_quality_cache_update(benchmark::State& state)
+{
+  const HexGrid& grid = mesh();
+  std::vector<double> points = grid.points;
+  const verdict::MeshStatisticsRequest request = { 0.5, 1.0, 10, 16, true };
+  verdict::MeshQualityCache cache(verdict::hex_scaled_jacobian, grid.num_elements, 8, points.data(),
+                                  grid.connectivity.data(), request, 1);
+
+  const verdict::VerdictIndex num_points = (verdict::VerdictIndex)points.size() / 3;
+  std::vector<verdict::VerdictIndex> moved;
+  for (verdict::VerdictIndex i = 0; i < 500; i++)
+    moved.push_back((7919 * i) % num_points);
+
+  long long evaluated = 0;
+  for (auto _ : state)
+  {
+    evaluated += cache.update(points.data(), moved.data(), (verdict::VerdictIndex)moved.size());
+    benchmark::DoNotOptimize(cache.statistics().minimum);
+  }
+  state.SetItemsProcessed(evaluated);
+}
+BENCHMARK(BM_mesh_quality_cache_update)->Unit(benchmark::kMicrosecond);
+
+// In coordinates and Out results: double, float or mixed precision
+template <typename In, typename Out>
+void BM_hex_scaled_jacobian_soa(benchmark::State& state)
+{
+  const HexGrid& grid = mesh();
+  const In* soa = grid.soa_of(In());
+  std::vector<Out> results(grid.num_elements);
+  const verdict::VerdictSimdLevel level = verdict::set_simd_level((verdict::VerdictSimdLevel)state.range(0));
+  state.SetLabel(level == verdict::VERDICT_SIMD_SCALAR ? "scalar" :
+                 level == verdict::VERDICT_SIMD_NEON ? "neon" :
+                 level == verdict::VERDICT_SIMD_AVX2 ? "avx2" : "avx512");
+  for (auto _ : state)
+  {
+    verdict::hex_scaled_jacobian_soa(grid.num_elements, soa, grid.num_elements, results.data());
+    benchmark::ClobberMemory();
+  }
+  verdict::set_simd_level(verdict::VERDICT_SIMD_AVX512);
+  set_element_counters(state, grid.num_elements);
+  set_kernel_counters(state, 24 * sizeof(In) + sizeof(Out), hex_scaled_jacobian_flops);
+}
+BENCHMARK_TEMPLATE2(BM_hex_scaled_jacobian_soa, double, double)->ArgName("simd_level")
+  ->Arg(verdict::VERDICT_SIMD_SCALAR)->Arg(verdict::VERDICT_SIMD_AVX2)->Arg(verdict::VERDICT_SIMD_AVX512)
+  ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE2(BM_hex_scaled_jacobian_soa, float, float)->ArgName("simd_level")
+  ->Arg(verdict::VERDICT_SIMD_SCALAR)->Arg(verdict::VERDICT_SIMD_AVX2)->Arg(verdict::VERDICT_SIMD_AVX512)
+  ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE2(BM_hex_scaled_jacobian_soa, float, double)->ArgName("simd_level")
+  ->Arg(verdict::VERDICT_SIMD_SCALAR)->Arg(verdict::VERDICT_SIMD_AVX2)->Arg(verdict::VERDICT_SIMD_AVX512)
+  ->Unit(benchmark::kMillisecond);
+
+void BM_tet_mean_ratio_soa(benchmark::State& state)
+{
+  const HexGrid& grid = mesh();
+  std::vector<double> results(grid.num_elements);
+  const verdict::VerdictSimdLevel level = verdict::set_simd_level((verdict::VerdictSimdLevel)state.range(0));
+  state.SetLabel(level == verdict::VERDICT_SIMD_SCALAR ? "scalar" :
+                 level == verdict::VERDICT_SIMD_NEON ? "neon" :
+                 level == verdict::VERDICT_SIMD_AVX2 ? "avx2" : "avx512");
+  for (auto _ : state)
+  {
+    verdict::tet_mean_ratio_soa(grid.num_elements, grid.tet_soa.data(), grid.num_elements, results.data());
+    benchmark::ClobberMemory();
+  }
+  verdict::set_simd_level(verdict::VERDICT_SIMD_AVX512);
+  set_element_counters(state, grid.num_elements);
+  set_kernel_counters(state, 12 * sizeof(double) + sizeof(double), tet_mean_ratio_flops);
+}
+BENCHMARK(BM_tet_mean_ratio_soa)->ArgName("simd_level")
+  ->Arg(verdict::VERDICT_SIMD_SCALAR)->Arg(verdict::VERDICT_SIMD_AVX2)->Arg(verdict::VERDICT_SIMD_AVX512)
+  ->Unit(benchmark::kMillisecond);
+
+// the bottom faces of the hexes, whose nodes are the first four of the hex
+// batch: the three single element functions per quad (0) against the
+// batched surface kernels at the widest level (1)
+void BM_quad_quality_soa(benchmark::State& state)
+{
+  const HexGrid& grid = mesh();
+  const double* soa = grid.soa_of(double());
+  const verdict::VerdictIndex stride = grid.num_elements;
+  std::vector<double> scaled_jacobian(grid.num_elements), warpage(grid.num_elements),
+    minimum_angle(grid.num_elements);
+  const bool batched = state.range(0) != 0;
+  for (auto _ : state)
+  {
+    if (batched)
+    {
+      const verdict::SurfaceQualityArrays arrays =
+        { scaled_jacobian.data(), warpage.data(), minimum_angle.data(), nullptr };
+      verdict::quad_quality_soa(grid.num_elements, soa, stride, arrays);
+    }
+    else
+    {
+      double coordinates[4][3];
+      for (verdict::VerdictIndex e = 0; e < grid.num_elements; e++)
+      {
+        for (int n = 0; n < 4; n++)
+          for (int c = 0; c < 3; c++)
+            coordinates[n][c] = soa[(3 * n + c) * stride + e];
+        scaled_jacobian[e] = verdict::quad_scaled_jacobian(4, coordinates);
+        warpage[e] = verdict::quad_warpage(4, coordinates);
+        minimum_angle[e] = verdict::quad_minimum_angle(4, coordinates);
+      }
+    }
+    benchmark::ClobberMemory();
+  }
+  set_element_counters(state, grid.num_elements);
+  // the corners of the quad in, its three metrics out
+  set_kernel_counters(state, 15 * sizeof(double), 0);
+}
+BENCHMARK(BM_quad_quality_soa)->ArgName("batched")->DenseRange(0, 1)->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  ReportOptions options;
+  if (!parse_report_options(argc, argv, options))
+  {
+    fprintf(stderr, "--verdict_threshold takes a percentage\n");
+    return 1;
+  }
+  register_element_benchmarks();
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    return 1;
+
+  int status = 0;
+  if (options.enabled())
+  {
+    ReportRecorder recorder;
+    benchmark::RunSpecifiedBenchmarks(&recorder);
+    status = finish_report(recorder, options);
+  }
+  else
+    benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return status;
+}
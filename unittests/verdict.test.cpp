@@ -10,12 +10,16 @@
 #include <stdexcept>
 #include <iostream>
 #include <fstream>
+#include <string>
 #include <vector>
 #include <array>
 #include <functional>
+#include <thread>
 #include <math.h>
+#include <string.h>
 
 #include <verdict.h>
+#include <verdict_fixed.h>
 #include "V_HexMetric.hpp"
 
 #define MAX_NODES_PER_ELEMENT 27
@@ -1419,3 +1423,418 @@ TEST(verdict, hex27_volume)
 }
 
 
+
+TEST(verdict, hex_quality_bundle)
+{
+  double hexes[4][8][3] =
+  {
+    // unit cube
+    { {0,0,0}, {1,0,0}, {1,1,0}, {0,1,0}, {0,0,1}, {1,0,1}, {1,1,1}, {0,1,1} },
+    // distorted hex
+    { {-0.2,0.1,0}, {1.1,0,0.1}, {1.3,1.2,0}, {0,0.9,-0.1},
+      {0.1,0,1.2}, {0.9,0.1,1}, {1.2,1,0.8}, {-0.1,1.1,1} },
+    // inverted corner
+    { {0,0,0}, {1,0,0}, {1,1,0}, {0,1,0}, {0,0,1}, {1,0,1}, {0.2,0.2,-0.5}, {0,1,1} },
+    // collapsed edge
+    { {0,0,0}, {0,0,0}, {1,1,0}, {0,1,0}, {0,0,1}, {1,0,1}, {1,1,1}, {0,1,1} }
+  };
+
+  for (auto& coords : hexes)
+  {
+    verdict::HexQuality q;
+    verdict::hex_quality(8, coords, verdict::HEX_ALL_METRICS, q);
+    EXPECT_DOUBLE_EQ(q.jacobian, verdict::hex_jacobian(8, coords));
+    EXPECT_DOUBLE_EQ(q.scaled_jacobian, verdict::hex_scaled_jacobian(8, coords));
+    EXPECT_DOUBLE_EQ(q.shape, verdict::hex_shape(8, coords));
+    EXPECT_DOUBLE_EQ(q.shear, verdict::hex_shear(8, coords));
+    EXPECT_DOUBLE_EQ(q.oddy, verdict::hex_oddy(8, coords));
+    EXPECT_DOUBLE_EQ(q.condition, verdict::hex_condition(8, coords));
+    EXPECT_DOUBLE_EQ(q.skew, verdict::hex_skew(8, coords));
+    EXPECT_DOUBLE_EQ(q.taper, verdict::hex_taper(8, coords));
+  }
+
+  // unrequested fields are left alone
+  verdict::HexQuality q = { -1, -1, -1, -1, -1, -1, -1, -1 };
+  verdict::hex_quality(8, hexes[1], verdict::HEX_SHAPE | verdict::HEX_SKEW, q);
+  EXPECT_DOUBLE_EQ(q.shape, verdict::hex_shape(8, hexes[1]));
+  EXPECT_DOUBLE_EQ(q.skew, verdict::hex_skew(8, hexes[1]));
+  EXPECT_EQ(q.jacobian, -1);
+  EXPECT_EQ(q.oddy, -1);
+  EXPECT_EQ(q.taper, -1);
+}
+
+TEST(verdict, tet_quality_bundle)
+{
+  double tets[4][4][3] =
+  {
+    { {0,0,0}, {1,0,0}, {0.5,0.866025,0}, {0.5,0.288675,0.816497} },
+    { {0,0,0}, {1,0.1,0}, {0.2,0.7,0.1}, {0.3,0.3,1.6} },
+    // inverted
+    { {0,0,0}, {0,1,0}, {1,0,0}, {0,0,1} },
+    // flat
+    { {0,0,0}, {1,0,0}, {0,1,0}, {1,1,0} }
+  };
+
+  for (auto& coords : tets)
+  {
+    verdict::TetQuality q;
+    verdict::tet_quality(4, coords, verdict::TET_ALL_METRICS, q);
+    EXPECT_DOUBLE_EQ(q.volume, verdict::tet_volume(4, coords));
+    EXPECT_DOUBLE_EQ(q.jacobian, verdict::tet_jacobian(4, coords));
+    EXPECT_DOUBLE_EQ(q.scaled_jacobian, verdict::tet_scaled_jacobian(4, coords));
+    EXPECT_DOUBLE_EQ(q.shape, verdict::tet_shape(4, coords));
+    EXPECT_DOUBLE_EQ(q.mean_ratio, verdict::tet_mean_ratio(4, coords));
+    EXPECT_DOUBLE_EQ(q.condition, verdict::tet_condition(4, coords));
+    EXPECT_DOUBLE_EQ(q.edge_ratio, verdict::tet_edge_ratio(4, coords));
+    EXPECT_DOUBLE_EQ(q.aspect_ratio, verdict::tet_aspect_ratio(4, coords));
+  }
+}
+
+TEST(verdict, wedge_quality_bundle)
+{
+  double wedges[4][6][3] =
+  {
+    // right unit wedge
+    { {0,0,0}, {1,0,0}, {0.5,0.866025,0}, {0,0,1}, {1,0,1}, {0.5,0.866025,1} },
+    // distorted wedge
+    { {-0.1,0,0.1}, {1.2,0.1,0}, {0.4,0.9,-0.1}, {0.1,-0.1,1.3}, {0.9,0.1,0.8}, {0.6,1.1,1.1} },
+    // inverted
+    { {0,0,0}, {0.5,0.866025,0}, {1,0,0}, {0,0,1}, {0.5,0.866025,1}, {1,0,1} },
+    // collapsed edge
+    { {0,0,0}, {0,0,0}, {0.5,0.866025,0}, {0,0,1}, {1,0,1}, {0.5,0.866025,1} }
+  };
+
+  for (auto& coords : wedges)
+  {
+    verdict::WedgeQuality q;
+    verdict::wedge_quality(6, coords, verdict::WEDGE_ALL_METRICS, q);
+    EXPECT_EQ(q.volume, verdict::wedge_volume(6, coords));
+    EXPECT_EQ(q.edge_ratio, verdict::wedge_edge_ratio(6, coords));
+    EXPECT_EQ(q.max_aspect_frobenius, verdict::wedge_max_aspect_frobenius(6, coords));
+    EXPECT_EQ(q.mean_aspect_frobenius, verdict::wedge_mean_aspect_frobenius(6, coords));
+    EXPECT_EQ(q.jacobian, verdict::wedge_jacobian(6, coords));
+    EXPECT_EQ(q.distortion, verdict::wedge_distortion(6, coords));
+    EXPECT_EQ(q.max_stretch, verdict::wedge_max_stretch(6, coords));
+    EXPECT_EQ(q.scaled_jacobian, verdict::wedge_scaled_jacobian(6, coords));
+    EXPECT_EQ(q.shape, verdict::wedge_shape(6, coords));
+    EXPECT_EQ(q.condition, verdict::wedge_condition(6, coords));
+    EXPECT_EQ(q.equiangle_skew, verdict::wedge_equiangle_skew(6, coords));
+  }
+
+  // unrequested fields are left alone
+  verdict::WedgeQuality q = { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 };
+  verdict::wedge_quality(6, wedges[1], verdict::WEDGE_DISTORTION | verdict::WEDGE_CONDITION, q);
+  EXPECT_EQ(q.distortion, verdict::wedge_distortion(6, wedges[1]));
+  EXPECT_EQ(q.condition, verdict::wedge_condition(6, wedges[1]));
+  EXPECT_EQ(q.volume, -1);
+  EXPECT_EQ(q.jacobian, -1);
+  EXPECT_EQ(q.max_aspect_frobenius, -1);
+}
+
+TEST(verdict, pyramid_quality_bundle)
+{
+  double pyramids[4][5][3] =
+  {
+    // unit pyramid
+    { {0,0,0}, {1,0,0}, {1,1,0}, {0,1,0}, {0.5,0.5,0.707107} },
+    // distorted pyramid
+    { {-0.1,0,0.1}, {1.2,0.1,0}, {1.1,0.9,-0.1}, {0.1,1.1,0}, {0.3,0.6,1.2} },
+    // peak below the base
+    { {0,0,0}, {1,0,0}, {1,1,0}, {0,1,0}, {0.5,0.5,-0.5} },
+    // collapsed base edge
+    { {0,0,0}, {0,0,0}, {1,1,0}, {0,1,0}, {0.5,0.5,1} }
+  };
+
+  for (auto& coords : pyramids)
+  {
+    verdict::PyramidQuality q;
+    verdict::pyramid_quality(5, coords, verdict::PYRAMID_ALL_METRICS, q);
+    EXPECT_EQ(q.volume, verdict::pyramid_volume(5, coords));
+    EXPECT_EQ(q.jacobian, verdict::pyramid_jacobian(5, coords));
+    EXPECT_EQ(q.scaled_jacobian, verdict::pyramid_scaled_jacobian(5, coords));
+    EXPECT_EQ(q.shape, verdict::pyramid_shape(5, coords));
+    EXPECT_EQ(q.equiangle_skew, verdict::pyramid_equiangle_skew(5, coords));
+  }
+
+  verdict::PyramidQuality q = { -1, -1, -1, -1, -1 };
+  verdict::pyramid_quality(5, pyramids[1], verdict::PYRAMID_JACOBIAN, q);
+  EXPECT_EQ(q.jacobian, verdict::pyramid_jacobian(5, pyramids[1]));
+  EXPECT_EQ(q.scaled_jacobian, -1);
+  EXPECT_EQ(q.shape, -1);
+}
+
+TEST(verdict, distortion_concurrent)
+{
+  // the shape function tables are built on first use; concurrent first
+  // calls must all see complete tables
+  double coords[27][3];
+  for (int i = 0; i < 27; i++)
+  {
+    coords[i][0] = 0.5 * (i % 3) + 0.05 * sin(1.3 * i);
+    coords[i][1] = 0.5 * ((i / 3) % 3) + 0.05 * cos(0.7 * i);
+    coords[i][2] = 0.5 * (i / 9) + 0.05 * sin(2.1 * i);
+  }
+
+  const int num_threads = 4;
+  double results[num_threads][6];
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++)
+  {
+    threads.emplace_back([&coords, &results, t]() {
+      results[t][0] = verdict::hex_distortion(8, coords);
+      results[t][1] = verdict::hex_distortion(20, coords);
+      results[t][2] = verdict::tet_distortion(10, coords);
+      results[t][3] = verdict::tri_distortion(6, coords);
+      results[t][4] = verdict::quad_distortion(4, coords);
+      results[t][5] = verdict::quad_distortion(8, coords);
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+
+  for (int t = 1; t < num_threads; t++)
+    for (int m = 0; m < 6; m++)
+      EXPECT_EQ(results[t][m], results[0][m]);
+  EXPECT_EQ(results[0][0], verdict::hex_distortion(8, coords));
+  EXPECT_EQ(results[0][1], verdict::hex_distortion(20, coords));
+}
+
+// parametric coordinates of the hex27 nodes
+static const double hex27_local_coordinates[27][3] =
+{
+  {-1,-1,-1}, {1,-1,-1}, {1,1,-1}, {-1,1,-1}, {-1,-1,1}, {1,-1,1}, {1,1,1}, {-1,1,1},
+  {0,-1,-1}, {1,0,-1}, {0,1,-1}, {-1,0,-1}, {-1,-1,0}, {1,-1,0}, {1,1,0}, {-1,1,0},
+  {0,-1,1}, {1,0,1}, {0,1,1}, {-1,0,1},
+  {0,0,0}, {0,0,-1}, {0,0,1}, {-1,0,0}, {1,0,0}, {0,-1,0}, {0,1,0}
+};
+
+TEST(verdict, hex_jacobian_at_least)
+{
+  // perturbed hex27s; the linear checks use their first 8 nodes
+  std::vector<std::array<std::array<double, 3>, 27>> hexes;
+  for (int h = 0; h < 40; h++)
+  {
+    const double amplitude = (h % 4 == 3) ? 0.45 : 0.12;
+    std::array<std::array<double, 3>, 27> hex;
+    for (int i = 0; i < 27; i++)
+      for (int c = 0; c < 3; c++)
+        hex[i][c] = hex27_local_coordinates[i][c] + amplitude * sin(3.7 * (27 * h + i) + 1.9 * c);
+    hexes.push_back(hex);
+  }
+  // a hex with a collapsed edge and an inverted corner elsewhere
+  std::array<std::array<double, 3>, 27> collapsed = hexes[0];
+  collapsed[6] = collapsed[7];
+  collapsed[0] = { 0.5, 0.5, 0.5 };
+  hexes.push_back(collapsed);
+
+  const double thresholds[] = { -1.0, 0.0, 0.2, 0.5, 0.9, 1.0 };
+  for (size_t h = 0; h < hexes.size(); h++)
+  {
+    double coordinates[27][3];
+    for (int i = 0; i < 27; i++)
+      for (int c = 0; c < 3; c++)
+        coordinates[i][c] = hexes[h][i][c];
+
+    const double jacobian8 = verdict::hex_jacobian(8, coordinates);
+    const double jacobian27 = verdict::hex_jacobian(27, coordinates);
+    const double scaled = verdict::hex_scaled_jacobian(8, coordinates);
+    for (double threshold : thresholds)
+    {
+      EXPECT_EQ(verdict::hex_jacobian_at_least(8, coordinates, threshold), jacobian8 >= threshold)
+        << "hex " << h << " threshold " << threshold;
+      EXPECT_EQ(verdict::hex_jacobian_at_least(27, coordinates, threshold), jacobian27 >= threshold)
+        << "hex " << h << " threshold " << threshold;
+      EXPECT_EQ(verdict::hex_scaled_jacobian_at_least(8, coordinates, threshold), scaled >= threshold)
+        << "hex " << h << " threshold " << threshold;
+    }
+  }
+}
+
+// whether two results are the same double, bit for bit
+static bool same_bits(double a, double b)
+{
+  return memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+TEST(verdict, fixed_node_counts)
+{
+  // the templates of verdict_fixed.h give what the runtime functions give
+  // for the same node count, on perturbed elements of every order
+  typedef double (*Fixed)(double[][3]);
+  struct fixed_case
+  {
+    const char* name;
+    std::function<double(int, double[][3])> function;
+    int num_nodes;
+    Fixed fixed;
+  };
+  const fixed_case cases[] = {
+    { "hex_volume", verdict::hex_volume, 8, verdict::fixed::hex_volume<8> },
+    { "hex_volume", verdict::hex_volume, 20, verdict::fixed::hex_volume<20> },
+    { "hex_volume", verdict::hex_volume, 27, verdict::fixed::hex_volume<27> },
+    { "hex_jacobian", verdict::hex_jacobian, 8, verdict::fixed::hex_jacobian<8> },
+    { "hex_jacobian", verdict::hex_jacobian, 27, verdict::fixed::hex_jacobian<27> },
+    { "hex_scaled_jacobian", verdict::hex_scaled_jacobian, 8, verdict::fixed::hex_scaled_jacobian<8> },
+    { "hex_distortion", verdict::hex_distortion, 8, verdict::fixed::hex_distortion<8> },
+    { "hex_distortion", verdict::hex_distortion, 20, verdict::fixed::hex_distortion<20> },
+    { "tet_volume", verdict::tet_volume, 4, verdict::fixed::tet_volume<4> },
+    { "tet_volume", verdict::tet_volume, 8, verdict::fixed::tet_volume<8> },
+    { "tet_volume", verdict::tet_volume, 10, verdict::fixed::tet_volume<10> },
+    { "tet_volume", verdict::tet_volume, 14, verdict::fixed::tet_volume<14> },
+    { "tet_volume", verdict::tet_volume, 15, verdict::fixed::tet_volume<15> },
+    { "tet_jacobian", verdict::tet_jacobian, 4, verdict::fixed::tet_jacobian<4> },
+    { "tet_jacobian", verdict::tet_jacobian, 15, verdict::fixed::tet_jacobian<15> },
+    { "tet_distortion", verdict::tet_distortion, 4, verdict::fixed::tet_distortion<4> },
+    { "tet_distortion", verdict::tet_distortion, 10, verdict::fixed::tet_distortion<10> },
+    { "wedge_jacobian", verdict::wedge_jacobian, 6, verdict::fixed::wedge_jacobian<6> },
+    { "wedge_jacobian", verdict::wedge_jacobian, 21, verdict::fixed::wedge_jacobian<21> },
+    { "knife_volume", verdict::knife_volume, 7, verdict::fixed::knife_volume<7> },
+    { "quad_distortion", verdict::quad_distortion, 4, verdict::fixed::quad_distortion<4> },
+    { "quad_distortion", verdict::quad_distortion, 8, verdict::fixed::quad_distortion<8> },
+    { "tri_distortion", verdict::tri_distortion, 3, verdict::fixed::tri_distortion<3> },
+    { "tri_distortion", verdict::tri_distortion, 6, verdict::fixed::tri_distortion<6> },
+  };
+
+  for (int h = 0; h < 20; h++)
+  {
+    // the hex27 nodes, perturbed; the other elements read the first nodes
+    const double amplitude = (h % 4 == 3) ? 0.45 : 0.12;
+    double coordinates[27][3];
+    for (int i = 0; i < 27; i++)
+      for (int c = 0; c < 3; c++)
+        coordinates[i][c] = hex27_local_coordinates[i][c] + amplitude * sin(2.3 * (27 * h + i) + 1.1 * c);
+
+    for (const fixed_case& test : cases)
+      EXPECT_TRUE(same_bits(test.fixed(coordinates), test.function(test.num_nodes, coordinates)))
+        << test.name << " with " << test.num_nodes << " nodes, element " << h;
+  }
+
+  // the counts without an integration rule or a volume decomposition
+  double coordinates[27][3];
+  for (int i = 0; i < 27; i++)
+    for (int c = 0; c < 3; c++)
+      coordinates[i][c] = hex27_local_coordinates[i][c];
+  EXPECT_EQ(verdict::hex_volume(12, coordinates), 0.0);
+  EXPECT_EQ(verdict::tet_volume(11, coordinates), 0.0);
+  EXPECT_EQ(verdict::knife_volume(8, coordinates), 0.0);
+}
+
+TEST(verdict, jacobian_estimates)
+{
+  typedef void (*Estimator)(int, double[][3], verdict::MetricEstimate&);
+  typedef double (*Function)(int, double[][3]);
+  const struct
+  {
+    const char* name;
+    Estimator estimator;
+    Function function;
+    int num_nodes;
+  } cases[] = {
+    { "hex", verdict::hex_jacobian_estimate, verdict::hex_jacobian, 27 },
+    { "hex", verdict::hex_jacobian_estimate, verdict::hex_jacobian, 8 },
+    { "tet", verdict::tet_jacobian_estimate, verdict::tet_jacobian, 15 },
+    { "tet", verdict::tet_jacobian_estimate, verdict::tet_jacobian, 4 },
+    { "wedge", verdict::wedge_jacobian_estimate, verdict::wedge_jacobian, 21 },
+    { "wedge", verdict::wedge_jacobian_estimate, verdict::wedge_jacobian, 6 },
+  };
+
+  for (int h = 0; h < 40; h++)
+  {
+    // the hex27 nodes, perturbed and far from the origin; the other
+    // elements read the first nodes
+    const double amplitude = (h % 4 == 3) ? 0.45 : 0.05;
+    const double shift = (h % 3) * 1000.0;
+    double coordinates[27][3];
+    for (int i = 0; i < 27; i++)
+      for (int c = 0; c < 3; c++)
+        coordinates[i][c] =
+          shift + hex27_local_coordinates[i][c] + amplitude * sin(2.9 * (27 * h + i) + 1.3 * c);
+
+    for (const auto& test : cases)
+    {
+      verdict::MetricEstimate estimate;
+      test.estimator(test.num_nodes, coordinates, estimate);
+      const double exact = test.function(test.num_nodes, coordinates);
+      EXPECT_LE(estimate.lower, exact) << test.name << test.num_nodes << " element " << h;
+      EXPECT_GE(estimate.upper, exact) << test.name << test.num_nodes << " element " << h;
+      EXPECT_LE(estimate.lower, estimate.value) << test.name << test.num_nodes << " element " << h;
+      EXPECT_GE(estimate.upper, estimate.value) << test.name << test.num_nodes << " element " << h;
+      // the linear elements have nothing to estimate
+      if (test.num_nodes <= 8)
+      {
+        EXPECT_TRUE(same_bits(estimate.value, exact)) << test.name << test.num_nodes << " element " << h;
+        EXPECT_TRUE(same_bits(estimate.lower, exact)) << test.name << test.num_nodes << " element " << h;
+        EXPECT_TRUE(same_bits(estimate.upper, exact)) << test.name << test.num_nodes << " element " << h;
+      }
+    }
+  }
+
+  // a trilinear hex27, whose other nodes are on the hex of the corners,
+  // only leaves the rounding between the bounds
+  double coordinates[27][3];
+  for (int i = 0; i < 27; i++)
+    for (int c = 0; c < 3; c++)
+      coordinates[i][c] = 2.0 * hex27_local_coordinates[i][c] + 0.3 * hex27_local_coordinates[i][(c + 1) % 3];
+  verdict::MetricEstimate estimate;
+  verdict::hex_jacobian_estimate(27, coordinates, estimate);
+  const double exact = verdict::hex_jacobian(27, coordinates);
+  EXPECT_NEAR(estimate.lower, exact, 1e-10 * exact);
+  EXPECT_NEAR(estimate.upper, exact, 1e-10 * exact);
+
+  coordinates[13][1] = NAN;
+  verdict::hex_jacobian_estimate(27, coordinates, estimate);
+  EXPECT_TRUE(estimate.lower != estimate.lower && estimate.upper != estimate.upper);
+}
+
+// finds a counter by name; returns null if it does not exist
+static const verdict::VerdictCounter* find_counter(const std::vector<verdict::VerdictCounter>& counters,
+                                                   const std::string& name)
+{
+  for (const verdict::VerdictCounter& counter : counters)
+    if (name == counter.name)
+      return &counter;
+  return nullptr;
+}
+
+static std::vector<verdict::VerdictCounter> all_counters()
+{
+  std::vector<verdict::VerdictCounter> counters(verdict::instrumentation_counters(nullptr, 0));
+  counters.resize(verdict::instrumentation_counters(counters.data(), (int)counters.size()));
+  return counters;
+}
+
+TEST(verdict, instrumentation)
+{
+  double tet[4][3] = { { 0, 0, 0 }, { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } };
+  double flat_tet[4][3] = { { 0, 0, 0 }, { 1, 0, 0 }, { 0, 1, 0 }, { 1, 1, 0 } };
+
+  verdict::reset_instrumentation();
+  for (int i = 0; i < 3; i++)
+    verdict::tet_scaled_jacobian(4, tet);
+  verdict::tet_mean_ratio(4, flat_tet);
+
+  const std::vector<verdict::VerdictCounter> counters = all_counters();
+  if (!verdict::instrumentation_enabled())
+  {
+    EXPECT_TRUE(counters.empty());
+    return;
+  }
+
+  const verdict::VerdictCounter* scaled_jacobian = find_counter(counters, "tet_scaled_jacobian");
+  ASSERT_NE(scaled_jacobian, nullptr);
+  EXPECT_TRUE(scaled_jacobian->is_metric);
+  EXPECT_EQ(scaled_jacobian->count, 3u);
+  EXPECT_GT(scaled_jacobian->ticks, 0u);
+
+  const verdict::VerdictCounter* degenerate = find_counter(counters, "tet_mean_ratio: zero volume");
+  ASSERT_NE(degenerate, nullptr);
+  EXPECT_FALSE(degenerate->is_metric);
+  EXPECT_EQ(degenerate->count, 1u);
+
+  verdict::reset_instrumentation();
+  for (const verdict::VerdictCounter& counter : all_counters())
+  {
+    EXPECT_EQ(counter.count, 0u) << counter.name;
+    EXPECT_EQ(counter.ticks, 0u) << counter.name;
+  }
+}
@@ -0,0 +1,234 @@
+/*!
+ * \brief Unittests for the header-only verdict kernels
+ *
+ * The double instantiation of each kernel must give the same answer as
+ * the library function of the same name, and the float instantiation
+ * must agree with it to single precision on reasonable elements.  The
+ * mixed instantiation, float coordinates computed in double, must give
+ * the answer of the library function on the rounded coordinates.
+ */
+
+#include "gtest/gtest.h"
+#include <vector>
+#include <math.h>
+
+#include <verdict.h>
+#include <verdict_kernels.h>
+
+// deterministic perturbation in [-amplitude, amplitude]
+static double kernel_perturbation(int i, double amplitude)
+{
+  return amplitude * sin(7.5311 * i + 41.17 * (i % 5));
+}
+
+struct kernel_element
+{
+  double coordinates[8][3];
+  bool well_shaped;
+};
+
+// perturbed copies of a reference element, plus inverted and degenerate ones
+static std::vector<kernel_element> make_kernel_elements(const double reference[][3], int num_nodes)
+{
+  std::vector<kernel_element> elements;
+  for (int e = 0; e < 24; e++)
+  {
+    // every sixth element is badly distorted, often inverted
+    const double amplitude = (e % 6 == 5) ? 1.2 : 0.15;
+    kernel_element element = {};
+    for (int n = 0; n < num_nodes; n++)
+      for (int c = 0; c < 3; c++)
+        element.coordinates[n][c] =
+          reference[n][c] + kernel_perturbation((e * num_nodes + n) * 3 + c, amplitude);
+    element.well_shaped = e % 6 != 5;
+    elements.push_back(element);
+  }
+
+  // the reference element with nodes 0 and 1 swapped
+  kernel_element inverted = {};
+  for (int n = 0; n < num_nodes; n++)
+    for (int c = 0; c < 3; c++)
+      inverted.coordinates[n][c] = reference[n < 2 ? 1 - n : n][c];
+  elements.push_back(inverted);
+
+  // the last node moved onto the one before it; a collapsed quad is a tri
+  kernel_element collapsed = {};
+  for (int n = 0; n < num_nodes; n++)
+    for (int c = 0; c < 3; c++)
+      collapsed.coordinates[n][c] = reference[n == num_nodes - 1 ? n - 1 : n][c];
+  elements.push_back(collapsed);
+
+  // all nodes at the origin
+  kernel_element point = {};
+  elements.push_back(point);
+  return elements;
+}
+
+static void check_kernel(double (*kernel_double)(const double[][3]),
+                         float (*kernel_float)(const float[][3]),
+                         double (*kernel_mixed)(const float[][3]),
+                         double (*metric)(int, double[][3]),
+                         const double reference[][3], int num_nodes)
+{
+  const std::vector<kernel_element> elements = make_kernel_elements(reference, num_nodes);
+  for (size_t e = 0; e < elements.size(); e++)
+  {
+    double coordinates[8][3];
+    float coordinates_float[8][3];
+    for (int n = 0; n < num_nodes; n++)
+      for (int c = 0; c < 3; c++)
+      {
+        coordinates[n][c] = elements[e].coordinates[n][c];
+        coordinates_float[n][c] = (float)elements[e].coordinates[n][c];
+      }
+
+    const double expected = metric(num_nodes, coordinates);
+    EXPECT_DOUBLE_EQ(kernel_double(coordinates), expected) << "element " << e;
+
+    // computing in double from float coordinates only rounds the input
+    double rounded[8][3];
+    for (int n = 0; n < num_nodes; n++)
+      for (int c = 0; c < 3; c++)
+        rounded[n][c] = coordinates_float[n][c];
+    EXPECT_DOUBLE_EQ(kernel_mixed(coordinates_float), metric(num_nodes, rounded)) << "element " << e;
+
+    if (elements[e].well_shaped)
+    {
+      EXPECT_NEAR(kernel_float(coordinates_float), expected, 1e-4 * fabs(expected) + 1e-5)
+        << "element " << e;
+    }
+  }
+}
+
+static const double kernel_tet[4][3] =
+{
+  {0, 0, 0}, {1, 0, 0}, {0.5, 0.866025, 0}, {0.5, 0.288675, 0.816497}
+};
+
+static const double kernel_hex[8][3] =
+{
+  {0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0},
+  {0, 0, 1}, {1, 0, 1}, {1, 1, 1}, {0, 1, 1}
+};
+
+static const double kernel_tri[3][3] =
+{
+  {0, 0, 0}, {1, 0, 0}, {0.5, 0.866025, 0}
+};
+
+static const double kernel_quad[4][3] =
+{
+  {0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0}
+};
+
+#define CHECK_KERNEL(name, reference, num_nodes) \
+  check_kernel(verdict::kernels::name<double>, verdict::kernels::name<float>, \
+               verdict::kernels::name<float, double>, verdict::name, reference, num_nodes)
+
+TEST(verdict, kernels_tet)
+{
+  CHECK_KERNEL(tet_volume, kernel_tet, 4);
+  CHECK_KERNEL(tet_jacobian, kernel_tet, 4);
+  CHECK_KERNEL(tet_scaled_jacobian, kernel_tet, 4);
+  CHECK_KERNEL(tet_shape, kernel_tet, 4);
+  CHECK_KERNEL(tet_mean_ratio, kernel_tet, 4);
+  CHECK_KERNEL(tet_condition, kernel_tet, 4);
+  CHECK_KERNEL(tet_edge_ratio, kernel_tet, 4);
+}
+
+TEST(verdict, kernels_hex)
+{
+  CHECK_KERNEL(hex_jacobian, kernel_hex, 8);
+  CHECK_KERNEL(hex_scaled_jacobian, kernel_hex, 8);
+  CHECK_KERNEL(hex_shear, kernel_hex, 8);
+  CHECK_KERNEL(hex_shape, kernel_hex, 8);
+}
+
+TEST(verdict, kernels_tri)
+{
+  CHECK_KERNEL(tri_area, kernel_tri, 3);
+  CHECK_KERNEL(tri_condition, kernel_tri, 3);
+  CHECK_KERNEL(tri_shape, kernel_tri, 3);
+  CHECK_KERNEL(tri_scaled_jacobian, kernel_tri, 3);
+  CHECK_KERNEL(tri_edge_ratio, kernel_tri, 3);
+}
+
+TEST(verdict, kernels_quad)
+{
+  CHECK_KERNEL(quad_area, kernel_quad, 4);
+  CHECK_KERNEL(quad_jacobian, kernel_quad, 4);
+  CHECK_KERNEL(quad_scaled_jacobian, kernel_quad, 4);
+  CHECK_KERNEL(quad_shear, kernel_quad, 4);
+  CHECK_KERNEL(quad_shape, kernel_quad, 4);
+  CHECK_KERNEL(quad_condition, kernel_quad, 4);
+}
+
+#if __cplusplus >= 201402L
+TEST(verdict, kernels_constexpr)
+{
+  static constexpr double unit_tet[4][3] = { {0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {0, 0, 1} };
+  static constexpr double unit_hex[8][3] =
+  {
+    {0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0},
+    {0, 0, 1}, {1, 0, 1}, {1, 1, 1}, {0, 1, 1}
+  };
+  static_assert(verdict::kernels::tet_volume(unit_tet) == 1.0 / 6.0, "tet_volume is not constexpr");
+  static_assert(verdict::kernels::tet_jacobian(unit_tet) == 1.0, "tet_jacobian is not constexpr");
+  static_assert(verdict::kernels::hex_jacobian(unit_hex) == 1.0, "hex_jacobian is not constexpr");
+  EXPECT_EQ(verdict::kernels::hex_jacobian(unit_hex), 1.0);
+}
+#endif
+
+// the perturbed hexes as a mesh: 1-based int connectivity into a stride 4
+// point array, with the points stored in reverse order, and the same points
+// as separate x, y and z arrays
+TEST(verdict, kernels_in_place)
+{
+  const std::vector<kernel_element> elements = make_kernel_elements(kernel_hex, 8);
+  const int num_elements = static_cast<int>(elements.size());
+  const int num_points = num_elements * 8;
+
+  std::vector<double> points(4 * num_points), x(num_points), y(num_points), z(num_points);
+  std::vector<int> connectivity(num_points);
+  for (int e = 0; e < num_elements; e++)
+    for (int n = 0; n < 8; n++)
+    {
+      const int point = num_points - 1 - (e * 8 + n);
+      connectivity[e * 8 + n] = point + 1;
+      for (int c = 0; c < 3; c++)
+        points[4 * point + c] = elements[e].coordinates[n][c];
+      points[4 * point + 3] = -1;
+      x[point] = elements[e].coordinates[n][0];
+      y[point] = elements[e].coordinates[n][1];
+      z[point] = elements[e].coordinates[n][2];
+    }
+
+  const verdict::kernels::StridedNodes<double, int> strided = { points.data(), 4, connectivity.data(), 1 };
+  const verdict::kernels::SoaNodes<double, int> soa = { x.data(), y.data(), z.data(), connectivity.data(), 1 };
+
+  std::vector<double> strided_results(num_elements), soa_results(num_elements);
+  verdict::kernels::mesh_quality(
+    [](const verdict::kernels::StridedNodes<double, int>& hex) { return verdict::kernels::hex_shape<double>(hex); },
+    num_elements, 8, strided, strided_results.data());
+  verdict::kernels::mesh_quality(
+    [](const verdict::kernels::SoaNodes<double, int>& hex) { return verdict::kernels::hex_scaled_jacobian<double>(hex); },
+    num_elements, 8, soa, soa_results.data());
+
+  for (int e = 0; e < num_elements; e++)
+  {
+    double coordinates[8][3];
+    for (int n = 0; n < 8; n++)
+      for (int c = 0; c < 3; c++)
+        coordinates[n][c] = elements[e].coordinates[n][c];
+    EXPECT_DOUBLE_EQ(strided_results[e], verdict::hex_shape(8, coordinates)) << "element " << e;
+    EXPECT_DOUBLE_EQ(soa_results[e], verdict::hex_scaled_jacobian(8, coordinates)) << "element " << e;
+
+    // one element through the VTK style offsets, computed in single precision
+    const verdict::VerdictIndex offsets[1] = { e * 8 };
+    float mixed = 0;
+    verdict::kernels::mesh_quality(
+      [](const verdict::kernels::SoaNodes<double, int>& hex) { return verdict::kernels::hex_jacobian<float>(hex); },
+      1, soa, offsets, &mixed);
+    EXPECT_FLOAT_EQ(mixed, (verdict::kernels::hex_jacobian<double, float>(coordinates))) << "element " << e;
+  }
+}
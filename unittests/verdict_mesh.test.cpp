@@ -0,0 +1,1730 @@
+/*!
+ * \brief Unittests for the mesh-level verdict interface
+ *
+ * The batched functions must give exactly the same answers as calling
+ * the single element functions one element at a time.
+ */
+
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+
+#include <verdict.h>
+#include <verdict_mesh.h>
+
+// two hexes sharing the face 4,5,6,7 ; the second one is sheared
+static const double two_hex_points[12][3] =
+{
+  {0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0},
+  {0, 0, 1}, {1, 0, 1}, {1, 1, 1}, {0, 1, 1},
+  {0.3, 0.1, 2.2}, {1.4, 0, 2}, {1.2, 1.1, 2.1}, {0.2, 0.9, 1.8}
+};
+static const verdict::VerdictIndex two_hex_conn[16] =
+{
+  0, 1, 2, 3, 4, 5, 6, 7,
+  4, 5, 6, 7, 8, 9, 10, 11
+};
+
+// compute the metric element by element, the reference for the batched calls
+static double single_element( verdict::VerdictFunction metric, const double points[][3],
+                              const verdict::VerdictIndex* nodes, int num_nodes )
+{
+  double coordinates[verdict::VERDICT_MAX_NODES_PER_ELEMENT][3];
+  for (int i = 0; i < num_nodes; i++)
+    for (int j = 0; j < 3; j++)
+      coordinates[i][j] = points[nodes[i]][j];
+  return metric(num_nodes, coordinates);
+}
+
+TEST(verdict, mesh_quality_hex_block)
+{
+  verdict::VerdictFunction metrics[] =
+  {
+    verdict::hex_volume, verdict::hex_scaled_jacobian, verdict::hex_shape,
+    verdict::hex_oddy, verdict::hex_skew, verdict::hex_taper
+  };
+
+  for (verdict::VerdictFunction metric : metrics)
+  {
+    double results[2];
+    verdict::mesh_quality(metric, 2, 8, &two_hex_points[0][0], two_hex_conn, results);
+    for (int e = 0; e < 2; e++)
+    {
+      EXPECT_EQ(results[e], single_element(metric, two_hex_points, two_hex_conn + 8*e, 8));
+    }
+  }
+}
+
+TEST(verdict, mesh_quality_mixed_offsets)
+{
+  // one hex, one tet, one wedge, one pyramid, one quad and one tri sharing points
+  const verdict::VerdictIndex conn[] =
+  {
+    0, 1, 2, 3, 4, 5, 6, 7,
+    4, 5, 7, 8,
+    4, 5, 7, 8, 9, 11,
+    4, 5, 6, 7, 10,
+    0, 1, 2, 3,
+    0, 1, 2
+  };
+  const verdict::VerdictIndex offsets[] = { 0, 8, 12, 18, 23, 27, 30 };
+  verdict::VerdictFunction volume_metrics[] =
+  {
+    verdict::hex_volume, verdict::tet_volume, verdict::wedge_volume,
+    verdict::pyramid_volume, verdict::quad_area, verdict::tri_area
+  };
+
+  for (int e = 0; e < 6; e++)
+  {
+    // evaluate a single element of the mixed mesh through the offsets interface
+    double result;
+    verdict::mesh_quality(volume_metrics[e], 1, &two_hex_points[0][0], conn, offsets + e, &result);
+    const int num_nodes = (int)(offsets[e+1] - offsets[e]);
+    EXPECT_EQ(result, single_element(volume_metrics[e], two_hex_points, conn + offsets[e], num_nodes));
+    EXPECT_GT(result, 0.0);
+  }
+
+  double tet_result;
+  verdict::mesh_quality(verdict::tet_volume, 1, &two_hex_points[0][0], conn, offsets + 1, &tet_result);
+  EXPECT_NEAR(tet_result, 1.2 / 6.0, 1e-12);
+}
+
+TEST(verdict, mesh_quality_too_many_nodes)
+{
+  std::vector<verdict::VerdictIndex> conn(2 * 28, 0);
+  double results[2] = { -1.0, -1.0 };
+  verdict::mesh_quality(verdict::hex_volume, 2, 28, &two_hex_points[0][0], conn.data(), results);
+  EXPECT_EQ(results[0], 0.0);
+  EXPECT_EQ(results[1], 0.0);
+
+  const verdict::VerdictIndex offsets[] = { 0, 8, 36 };
+  verdict::mesh_quality(verdict::hex_volume, 2, &two_hex_points[0][0], two_hex_conn, offsets, results);
+  EXPECT_DOUBLE_EQ(results[0], 1.0);
+  EXPECT_EQ(results[1], 0.0);
+}
+
+// a structured block of n x n x n perturbed hexes, connectivity in Exodus order
+static void make_hex_grid(int n, std::vector<double>& points, std::vector<verdict::VerdictIndex>& conn)
+{
+  const int np = n + 1;
+  points.clear();
+  for (int k = 0; k < np; k++)
+    for (int j = 0; j < np; j++)
+      for (int i = 0; i < np; i++)
+      {
+        const int id = (k * np + j) * np + i;
+        points.push_back(i + 0.3 * sin(1.7 * id));
+        points.push_back(j + 0.3 * sin(2.3 * id + 1.0));
+        points.push_back(k + 0.3 * sin(3.1 * id + 2.0));
+      }
+
+  conn.clear();
+  for (int k = 0; k < n; k++)
+    for (int j = 0; j < n; j++)
+      for (int i = 0; i < n; i++)
+      {
+        const verdict::VerdictIndex p0 = (k * np + j) * np + i;
+        const verdict::VerdictIndex corners[8] =
+        {
+          p0, p0 + 1, p0 + np + 1, p0 + np,
+          p0 + np * np, p0 + np * np + 1, p0 + np * np + np + 1, p0 + np * np + np
+        };
+        conn.insert(conn.end(), corners, corners + 8);
+      }
+}
+
+TEST(verdict, parallel_mesh_quality_block)
+{
+  std::vector<double> points;
+  std::vector<verdict::VerdictIndex> conn;
+  make_hex_grid(24, points, conn);
+  const verdict::VerdictIndex num_elements = (verdict::VerdictIndex)conn.size() / 8;
+
+  std::vector<double> expected(num_elements);
+  verdict::mesh_quality(verdict::hex_scaled_jacobian, num_elements, 8, points.data(), conn.data(),
+                        expected.data());
+
+  for (int num_threads : { 0, 1, 3, 64 })
+  {
+    std::vector<double> results(num_elements, -2.0);
+    verdict::parallel_mesh_quality(verdict::hex_scaled_jacobian, num_elements, 8, points.data(),
+                                   conn.data(), results.data(), num_threads);
+    for (verdict::VerdictIndex e = 0; e < num_elements; e++)
+    {
+      ASSERT_EQ(results[e], expected[e]) << "element " << e << " threads " << num_threads;
+    }
+  }
+
+  // nothing to do
+  verdict::parallel_mesh_quality(verdict::hex_volume, 0, 8, points.data(), conn.data(), nullptr, 4);
+}
+
+TEST(verdict, scratch_memory)
+{
+  // 9 node quads on the hex faces: the shape function tables of a node
+  // count without an integration rule go to scratch memory, and so do the
+  // values of the blocks of mesh_statistics
+  std::vector<double> points;
+  std::vector<verdict::VerdictIndex> hex_conn;
+  make_hex_grid(12, points, hex_conn);
+  std::vector<verdict::VerdictIndex> conn;
+  for (size_t h = 0; h < hex_conn.size(); h += 8)
+    for (int n = 0; n < 9; n++)
+      conn.push_back(hex_conn[h + n % 8]);
+  const verdict::VerdictIndex num_elements = (verdict::VerdictIndex)conn.size() / 9;
+
+  std::vector<double> expected(num_elements);
+  for (verdict::VerdictIndex e = 0; e < num_elements; e++)
+  {
+    double coordinates[9][3];
+    for (int n = 0; n < 9; n++)
+      for (int c = 0; c < 3; c++)
+        coordinates[n][c] = points[3 * conn[9 * e + n] + c];
+    expected[e] = verdict::quad_distortion(9, coordinates);
+  }
+
+  // which threads take an arena depends on which of them claim blocks, so the
+  // memory is only compared over passes on the calling thread
+  const verdict::MeshStatisticsRequest request = { 0.5, 1.0, 4, 2, true };
+  unsigned long long used = 0;
+  for (int pass = 0; pass < 3; pass++)
+  {
+    const int num_threads = pass == 0 ? 3 : 1;
+    std::vector<double> results(num_elements, -2.0);
+    verdict::parallel_mesh_quality(verdict::quad_distortion, num_elements, 9, points.data(), conn.data(),
+                                   results.data(), num_threads);
+    for (verdict::VerdictIndex e = 0; e < num_elements; e++)
+      ASSERT_TRUE(results[e] == expected[e] || (results[e] != results[e] && expected[e] != expected[e]))
+        << "element " << e;
+    verdict::MeshStatistics statistics;
+    verdict::mesh_statistics(verdict::quad_distortion, num_elements, 9, points.data(), conn.data(),
+                             request, statistics, num_threads);
+
+    // the third pass reuses the memory of the second
+    if (pass == 1)
+    {
+      used = verdict::scratch_memory_size();
+    }
+    else if (pass == 2)
+    {
+      EXPECT_EQ(verdict::scratch_memory_size(), used);
+    }
+  }
+  EXPECT_GT(used, 0ULL);
+
+  const unsigned long long freed = verdict::release_scratch_memory();
+  EXPECT_GT(freed, 0ULL);
+  EXPECT_LE(verdict::scratch_memory_size(), used);
+}
+
+// the volume of a tet or a hex, chosen by node count
+static double tet_or_hex_volume(int num_nodes, double coordinates[][3])
+{
+  return num_nodes == 4 ? verdict::tet_volume(num_nodes, coordinates)
+                        : verdict::hex_volume(num_nodes, coordinates);
+}
+
+TEST(verdict, parallel_mesh_quality_mixed_offsets)
+{
+  std::vector<double> points;
+  std::vector<verdict::VerdictIndex> hex_conn;
+  make_hex_grid(16, points, hex_conn);
+
+  // alternate hexes with the tets formed by their first four nodes, so the
+  // cost per element varies along the mesh
+  std::vector<verdict::VerdictIndex> conn;
+  std::vector<verdict::VerdictIndex> offsets(1, 0);
+  for (size_t h = 0; h < hex_conn.size() / 8; h++)
+  {
+    const int num_nodes = (h % 3 == 0) ? 4 : 8;
+    conn.insert(conn.end(), hex_conn.begin() + 8 * h, hex_conn.begin() + 8 * h + num_nodes);
+    offsets.push_back((verdict::VerdictIndex)conn.size());
+  }
+  const verdict::VerdictIndex num_elements = (verdict::VerdictIndex)offsets.size() - 1;
+
+  std::vector<double> expected(num_elements);
+  verdict::mesh_quality(tet_or_hex_volume, num_elements, points.data(), conn.data(), offsets.data(),
+                        expected.data());
+
+  std::vector<double> results(num_elements, -2.0);
+  verdict::parallel_mesh_quality(tet_or_hex_volume, num_elements, points.data(), conn.data(),
+                                 offsets.data(), results.data(), 4);
+  for (verdict::VerdictIndex e = 0; e < num_elements; e++)
+  {
+    ASSERT_EQ(results[e], expected[e]) << "element " << e;
+  }
+}
+
+// the hex grid with its elements and points shuffled, as in a mesh in file order
+static void make_shuffled_hex_grid(int n, std::vector<double>& points,
+                                   std::vector<verdict::VerdictIndex>& conn)
+{
+  std::vector<double> grid_points;
+  std::vector<verdict::VerdictIndex> grid_conn;
+  make_hex_grid(n, grid_points, grid_conn);
+  const verdict::VerdictIndex num_points = (verdict::VerdictIndex)grid_points.size() / 3;
+  const verdict::VerdictIndex num_elements = (verdict::VerdictIndex)grid_conn.size() / 8;
+
+  // deterministic permutations, coprime strides
+  std::vector<verdict::VerdictIndex> point_numbers(num_points);
+  for (verdict::VerdictIndex p = 0; p < num_points; p++)
+    point_numbers[p] = (p * 7919) % num_points;
+  points.resize(grid_points.size());
+  for (verdict::VerdictIndex p = 0; p < num_points; p++)
+    for (int c = 0; c < 3; c++)
+      points[3 * point_numbers[p] + c] = grid_points[3 * p + c];
+  conn.resize(grid_conn.size());
+  for (verdict::VerdictIndex e = 0; e < num_elements; e++)
+    for (int i = 0; i < 8; i++)
+      conn[8 * ((e * 104729) % num_elements) + i] = point_numbers[grid_conn[8 * e + i]];
+}
+
+// the distance between the centroids of consecutive elements of an order, on average
+static double average_step(const std::vector<double>& points,
+                           const std::vector<verdict::VerdictIndex>& conn,
+                           const std::vector<verdict::VerdictIndex>& order)
+{
+  double step = 0.0, previous[3] = { 0, 0, 0 };
+  for (size_t i = 0; i < order.size(); i++)
+  {
+    double center[3] = { 0, 0, 0 };
+    for (int n = 0; n < 8; n++)
+      for (int c = 0; c < 3; c++)
+        center[c] += points[3 * conn[8 * order[i] + n] + c] / 8;
+    if (i > 0)
+      step += sqrt((center[0] - previous[0]) * (center[0] - previous[0]) +
+                   (center[1] - previous[1]) * (center[1] - previous[1]) +
+                   (center[2] - previous[2]) * (center[2] - previous[2]));
+    std::copy(center, center + 3, previous);
+  }
+  return step / (order.size() - 1);
+}
+
+TEST(verdict, mesh_element_order)
+{
+  std::vector<double> points;
+  std::vector<verdict::VerdictIndex> conn;
+  make_shuffled_hex_grid(16, points, conn);
+  const verdict::VerdictIndex num_elements = (verdict::VerdictIndex)conn.size() / 8;
+  const verdict::VerdictIndex num_points = (verdict::VerdictIndex)points.size() / 3;
+
+  std::vector<verdict::VerdictIndex> file_order(num_elements);
+  for (verdict::VerdictIndex e = 0; e < num_elements; e++)
+    file_order[e] = e;
+  const double file_step = average_step(points, conn, file_order);
+
+  std::vector<double> expected(num_elements);
+  verdict::mesh_quality(verdict::hex_scaled_jacobian, num_elements, 8, points.data(), conn.data(),
+                        expected.data());
+
+  for (verdict::VerdictCurve curve : { verdict::VERDICT_CURVE_MORTON, verdict::VERDICT_CURVE_HILBERT })
+  {
+    std::vector<verdict::VerdictIndex> order(num_elements);
+    verdict::mesh_element_order(curve, num_elements, 8, points.data(), conn.data(), order.data(), 3);
+
+    std::vector<verdict::VerdictIndex> sorted(order);
+    std::sort(sorted.begin(), sorted.end());
+    ASSERT_EQ(sorted, file_order);
+
+    // the same order whatever the number of threads
+    std::vector<verdict::VerdictIndex> serial(num_elements);
+    verdict::mesh_element_order(curve, num_elements, 8, points.data(), conn.data(), serial.data(), 1);
+    EXPECT_EQ(serial, order);
+
+    const double step = average_step(points, conn, order);
+    EXPECT_LT(step, curve == verdict::VERDICT_CURVE_HILBERT ? 1.05 : 1.6);
+    EXPECT_LT(step, file_step / 5);
+
+    // the elements reordered, with the original points
+    std::vector<verdict::VerdictIndex> new_conn(conn.size());
+    verdict::mesh_reorder(num_elements, 8, points.data(), num_points, conn.data(), order.data(),
+                          nullptr, new_conn.data());
+    for (verdict::VerdictIndex i = 0; i < num_elements; i++)
+      for (int n = 0; n < 8; n++)
+        ASSERT_EQ(new_conn[8 * i + n], conn[8 * order[i] + n]);
+    std::vector<double> results(num_elements, -2.0);
+    verdict::ordered_mesh_quality(verdict::hex_scaled_jacobian, num_elements, 8, points.data(),
+                                  new_conn.data(), order.data(), results.data(), 4);
+    ASSERT_EQ(results, expected);
+
+    // the renumbered points are used in order and give the same results
+    std::vector<double> new_points(points.size());
+    verdict::mesh_reorder(num_elements, 8, points.data(), num_points, conn.data(), order.data(),
+                          new_points.data(), new_conn.data());
+    verdict::VerdictIndex next = 0;
+    for (verdict::VerdictIndex entry : new_conn)
+    {
+      ASSERT_LE(entry, next);
+      if (entry == next)
+        next++;
+    }
+    EXPECT_EQ(next, num_points);
+    std::fill(results.begin(), results.end(), -2.0);
+    verdict::ordered_mesh_quality(verdict::hex_scaled_jacobian, num_elements, 8, new_points.data(),
+                                  new_conn.data(), order.data(), results.data(), 0);
+    ASSERT_EQ(results, expected);
+  }
+}
+
+TEST(verdict, mesh_element_order_mixed_offsets)
+{
+  std::vector<double> points;
+  std::vector<verdict::VerdictIndex> hex_conn;
+  make_shuffled_hex_grid(10, points, hex_conn);
+  const verdict::VerdictIndex num_points = (verdict::VerdictIndex)points.size() / 3;
+
+  // one element without nodes, which goes first
+  std::vector<verdict::VerdictIndex> conn;
+  std::vector<verdict::VerdictIndex> offsets(2, 0);
+  for (size_t h = 0; h < hex_conn.size() / 8; h++)
+  {
+    const int num_nodes = (h % 3 == 0) ? 4 : 8;
+    conn.insert(conn.end(), hex_conn.begin() + 8 * h, hex_conn.begin() + 8 * h + num_nodes);
+    offsets.push_back((verdict::VerdictIndex)conn.size());
+  }
+  const verdict::VerdictIndex num_elements = (verdict::VerdictIndex)offsets.size() - 1;
+
+  std::vector<double> expected(num_elements);
+  verdict::mesh_quality(tet_or_hex_volume, num_elements, points.data(), conn.data(), offsets.data(),
+                        expected.data());
+
+  std::vector<verdict::VerdictIndex> order(num_elements);
+  verdict::mesh_element_order(verdict::VERDICT_CURVE_HILBERT, num_elements, points.data(),
+                              conn.data(), offsets.data(), order.data(), 0);
+  EXPECT_EQ(order[0], 0);
+  std::vector<verdict::VerdictIndex> sorted(order);
+  std::sort(sorted.begin(), sorted.end());
+  for (verdict::VerdictIndex e = 0; e < num_elements; e++)
+    ASSERT_EQ(sorted[e], e);
+
+  std::vector<double> new_points(points.size());
+  std::vector<verdict::VerdictIndex> new_conn(conn.size());
+  std::vector<verdict::VerdictIndex> new_offsets(num_elements + 1);
+  verdict::mesh_reorder(num_elements, points.data(), num_points, conn.data(), offsets.data(),
+                        order.data(), new_points.data(), new_conn.data(), new_offsets.data());
+  for (verdict::VerdictIndex i = 0; i < num_elements; i++)
+    ASSERT_EQ(new_offsets[i + 1] - new_offsets[i], offsets[order[i] + 1] - offsets[order[i]]);
+  std::vector<double> results(num_elements, -2.0);
+  verdict::ordered_mesh_quality(tet_or_hex_volume, num_elements, new_points.data(), new_conn.data(),
+                                new_offsets.data(), order.data(), results.data(), 3);
+  ASSERT_EQ(results, expected);
+}
+
+// reduce an array of results the straightforward way, the reference for mesh_statistics
+static void check_statistics(const std::vector<double>& results,
+                             const verdict::MeshStatisticsRequest& request,
+                             const verdict::MeshStatistics& statistics)
+{
+  const verdict::VerdictIndex count = (verdict::VerdictIndex)results.size();
+  ASSERT_EQ(statistics.count, count);
+
+  double sum = 0.0;
+  for (double value : results)
+    sum += value;
+  const double mean = sum / count;
+  double squares = 0.0;
+  for (double value : results)
+    squares += (value - mean) * (value - mean);
+
+  EXPECT_EQ(statistics.minimum, *std::min_element(results.begin(), results.end()));
+  EXPECT_EQ(statistics.maximum, *std::max_element(results.begin(), results.end()));
+  EXPECT_NEAR(statistics.mean, mean, 1e-12 * fabs(mean));
+  EXPECT_NEAR(statistics.standard_deviation, sqrt(squares / count), 1e-10);
+
+  std::vector<verdict::VerdictIndex> histogram(request.num_bins, 0);
+  verdict::VerdictIndex below = 0, above = 0;
+  for (double value : results)
+  {
+    if (value < request.acceptable_min)
+      below++;
+    else if (value > request.acceptable_max)
+      above++;
+    else
+    {
+      const double range = request.acceptable_max - request.acceptable_min;
+      const int bin = (int)(request.num_bins * ((value - request.acceptable_min) / range));
+      histogram[std::min(bin, request.num_bins - 1)]++;
+    }
+  }
+  EXPECT_EQ(statistics.below_acceptable, below);
+  EXPECT_EQ(statistics.above_acceptable, above);
+  for (int b = 0; b < request.num_bins; b++)
+    EXPECT_EQ(statistics.histogram[b], histogram[b]) << "bin " << b;
+
+  std::vector<verdict::VerdictIndex> order(count);
+  for (verdict::VerdictIndex e = 0; e < count; e++)
+    order[e] = e;
+  std::stable_sort(order.begin(), order.end(), [&](verdict::VerdictIndex a, verdict::VerdictIndex b)
+  {
+    return request.smaller_is_worse ? results[a] < results[b] : results[a] > results[b];
+  });
+  ASSERT_EQ(statistics.num_worst, (int)std::min<verdict::VerdictIndex>(request.num_worst, count));
+  for (int w = 0; w < statistics.num_worst; w++)
+  {
+    EXPECT_EQ(statistics.worst_elements[w], order[w]) << "worst " << w;
+    EXPECT_EQ(statistics.worst_values[w], results[order[w]]) << "worst " << w;
+  }
+}
+
+TEST(verdict, mesh_statistics_block)
+{
+  std::vector<double> points;
+  std::vector<verdict::VerdictIndex> conn;
+  make_hex_grid(20, points, conn);
+  const verdict::VerdictIndex num_elements = (verdict::VerdictIndex)conn.size() / 8;
+
+  std::vector<double> results(num_elements);
+  verdict::mesh_quality(verdict::hex_scaled_jacobian, num_elements, 8, points.data(), conn.data(),
+                        results.data());
+
+  const verdict::MeshStatisticsRequest request = { 0.5, 1.0, 10, 12, true };
+  for (int num_threads : { 1, 0, 3 })
+  {
+    verdict::MeshStatistics statistics;
+    verdict::mesh_statistics(verdict::hex_scaled_jacobian, num_elements, 8, points.data(),
+                             conn.data(), request, statistics, num_threads);
+    check_statistics(results, request, statistics);
+  }
+
+  // nothing to do
+  verdict::MeshStatistics statistics;
+  verdict::mesh_statistics(verdict::hex_volume, 0, 8, points.data(), conn.data(), request,
+                           statistics, 4);
+  EXPECT_EQ(statistics.count, 0);
+  EXPECT_EQ(statistics.num_worst, 0);
+  EXPECT_EQ(statistics.mean, 0.0);
+}
+
+TEST(verdict, mesh_statistics_mixed_offsets)
+{
+  std::vector<double> points;
+  std::vector<verdict::VerdictIndex> hex_conn;
+  make_hex_grid(12, points, hex_conn);
+
+  std::vector<verdict::VerdictIndex> conn;
+  std::vector<verdict::VerdictIndex> offsets(1, 0);
+  for (size_t h = 0; h < hex_conn.size() / 8; h++)
+  {
+    const int num_nodes = (h % 3 == 0) ? 4 : 8;
+    conn.insert(conn.end(), hex_conn.begin() + 8 * h, hex_conn.begin() + 8 * h + num_nodes);
+    offsets.push_back((verdict::VerdictIndex)conn.size());
+  }
+  const verdict::VerdictIndex num_elements = (verdict::VerdictIndex)offsets.size() - 1;
+
+  std::vector<double> results(num_elements);
+  verdict::mesh_quality(tet_or_hex_volume, num_elements, points.data(), conn.data(), offsets.data(),
+                        results.data());
+
+  // the largest volumes are the worst, and the bins cover part of the range
+  const verdict::MeshStatisticsRequest request = { 0.2, 1.0, 7, verdict::VERDICT_MAX_WORST_ELEMENTS, false };
+  verdict::MeshStatistics statistics;
+  verdict::mesh_statistics(tet_or_hex_volume, num_elements, points.data(), conn.data(),
+                           offsets.data(), request, statistics, 4);
+  check_statistics(results, request, statistics);
+}
+
+// write an array to a flat binary file
+template <typename T>
+static void write_file(const char* path, const std::vector<T>& values)
+{
+  FILE* file = fopen(path, "wb");
+  ASSERT_NE(file, nullptr);
+  EXPECT_EQ(fwrite(values.data(), sizeof(T), values.size(), file), values.size());
+  fclose(file);
+}
+
+// a MeshResultWriter collecting the results in order
+static bool collect_results(void* data, verdict::VerdictIndex first_element,
+                            verdict::VerdictIndex num_elements, const double* results)
+{
+  std::vector<double>& collected = *static_cast<std::vector<double>*>(data);
+  if (first_element != (verdict::VerdictIndex)collected.size())
+    return false;
+  collected.insert(collected.end(), results, results + num_elements);
+  return true;
+}
+
+TEST(verdict, stream_mesh_quality_mapped_block)
+{
+  std::vector<double> points;
+  std::vector<verdict::VerdictIndex> conn;
+  make_hex_grid(12, points, conn);
+  const verdict::VerdictIndex num_elements = (verdict::VerdictIndex)conn.size() / 8;
+  write_file("stream_block_points.bin", points);
+  write_file("stream_block_conn.bin", conn);
+
+  std::vector<double> expected(num_elements);
+  verdict::mesh_quality(verdict::hex_scaled_jacobian, num_elements, 8, points.data(), conn.data(),
+                        expected.data());
+
+  {
+    verdict::MappedMesh mesh("stream_block_points.bin", "stream_block_conn.bin", 8);
+    ASSERT_TRUE(mesh.is_open());
+    EXPECT_EQ(mesh.num_points(), (verdict::VerdictIndex)points.size() / 3);
+    EXPECT_EQ(mesh.num_elements(), num_elements);
+
+    // chunks that do not divide the mesh, a single chunk and the default
+    const verdict::MeshStatisticsRequest request = { 0.5, 1.0, 10, 12, true };
+    for (verdict::VerdictIndex chunk_elements : { 100, 5000, 0 })
+      for (int num_threads : { 1, 3 })
+      {
+        std::vector<double> results;
+        verdict::MeshStatistics statistics;
+        EXPECT_TRUE(verdict::stream_mesh_quality(verdict::hex_scaled_jacobian,
+                                                 verdict::MappedMesh::read_chunk, &mesh,
+                                                 chunk_elements, collect_results, &results,
+                                                 request, statistics, num_threads));
+        ASSERT_EQ(results, expected) << chunk_elements << " elements per chunk";
+        check_statistics(expected, request, statistics);
+      }
+
+    // the results streamed to a file
+    FILE* file = tmpfile();
+    ASSERT_NE(file, nullptr);
+    verdict::MeshStatistics statistics;
+    EXPECT_TRUE(verdict::stream_mesh_quality(verdict::hex_scaled_jacobian,
+                                             verdict::MappedMesh::read_chunk, &mesh, 333,
+                                             verdict::write_results_to_file, file, request,
+                                             statistics, 2));
+    rewind(file);
+    std::vector<double> results(num_elements + 1);
+    EXPECT_EQ(fread(results.data(), sizeof(double), results.size(), file), (size_t)num_elements);
+    fclose(file);
+    results.pop_back();
+    EXPECT_EQ(results, expected);
+  }
+
+  // a connectivity referring to a point past the end of the points file
+  conn[8 * 1000 + 3] = (verdict::VerdictIndex)points.size();
+  write_file("stream_block_conn.bin", conn);
+  {
+    verdict::MappedMesh mesh("stream_block_points.bin", "stream_block_conn.bin", 8);
+    ASSERT_TRUE(mesh.is_open());
+    const verdict::MeshStatisticsRequest request = { 0.5, 1.0, 0, 0, true };
+    verdict::MeshStatistics statistics;
+    EXPECT_FALSE(verdict::stream_mesh_quality(verdict::hex_scaled_jacobian,
+                                              verdict::MappedMesh::read_chunk, &mesh, 100,
+                                              nullptr, nullptr, request, statistics, 1));
+    EXPECT_EQ(statistics.count, 1000);
+  }
+
+  // missing files and inconsistent sizes
+  EXPECT_FALSE(verdict::MappedMesh("stream_missing.bin", "stream_block_conn.bin", 8).is_open());
+  EXPECT_FALSE(verdict::MappedMesh("stream_block_points.bin", "stream_block_conn.bin", 7).is_open());
+  remove("stream_block_points.bin");
+  remove("stream_block_conn.bin");
+}
+
+TEST(verdict, stream_mesh_quality_mapped_offsets)
+{
+  std::vector<double> points;
+  std::vector<verdict::VerdictIndex> hex_conn;
+  make_hex_grid(10, points, hex_conn);
+
+  std::vector<verdict::VerdictIndex> conn;
+  std::vector<verdict::VerdictIndex> offsets(1, 0);
+  for (size_t h = 0; h < hex_conn.size() / 8; h++)
+  {
+    const int num_nodes = (h % 3 == 0) ? 4 : 8;
+    conn.insert(conn.end(), hex_conn.begin() + 8 * h, hex_conn.begin() + 8 * h + num_nodes);
+    offsets.push_back((verdict::VerdictIndex)conn.size());
+  }
+  const verdict::VerdictIndex num_elements = (verdict::VerdictIndex)offsets.size() - 1;
+  write_file("stream_mixed_points.bin", points);
+  write_file("stream_mixed_conn.bin", conn);
+  write_file("stream_mixed_offsets.bin", offsets);
+
+  std::vector<double> expected(num_elements);
+  verdict::mesh_quality(tet_or_hex_volume, num_elements, points.data(), conn.data(), offsets.data(),
+                        expected.data());
+
+  {
+    verdict::MappedMesh mesh("stream_mixed_points.bin", "stream_mixed_conn.bin",
+                             "stream_mixed_offsets.bin");
+    ASSERT_TRUE(mesh.is_open());
+    EXPECT_EQ(mesh.num_elements(), num_elements);
+
+    const verdict::MeshStatisticsRequest request = { 0.2, 1.0, 7, verdict::VERDICT_MAX_WORST_ELEMENTS, false };
+    std::vector<double> results;
+    verdict::MeshStatistics statistics;
+    EXPECT_TRUE(verdict::stream_mesh_quality(tet_or_hex_volume, verdict::MappedMesh::read_chunk,
+                                             &mesh, 77, collect_results, &results, request,
+                                             statistics, 0));
+    ASSERT_EQ(results, expected);
+    check_statistics(expected, request, statistics);
+  }
+
+  // offsets out of order
+  std::swap(offsets[500], offsets[501]);
+  write_file("stream_mixed_offsets.bin", offsets);
+  {
+    verdict::MappedMesh mesh("stream_mixed_points.bin", "stream_mixed_conn.bin",
+                             "stream_mixed_offsets.bin");
+    const verdict::MeshStatisticsRequest request = { 0.2, 1.0, 0, 0, false };
+    verdict::MeshStatistics statistics;
+    EXPECT_FALSE(verdict::stream_mesh_quality(tet_or_hex_volume, verdict::MappedMesh::read_chunk,
+                                              &mesh, 77, nullptr, nullptr, request, statistics, 1));
+  }
+  remove("stream_mixed_points.bin");
+  remove("stream_mixed_conn.bin");
+  remove("stream_mixed_offsets.bin");
+}
+
+TEST(verdict, mesh_quality_cache)
+{
+  std::vector<double> points;
+  std::vector<verdict::VerdictIndex> conn;
+  make_hex_grid(12, points, conn);
+  const verdict::VerdictIndex num_elements = (verdict::VerdictIndex)conn.size() / 8;
+  const verdict::VerdictIndex num_points = (verdict::VerdictIndex)points.size() / 3;
+
+  const verdict::MeshStatisticsRequest request = { 0.5, 1.0, 8, 10, true };
+  verdict::MeshQualityCache cache(verdict::hex_scaled_jacobian, num_elements, 8, points.data(),
+                                  conn.data(), request, 3);
+  ASSERT_EQ(cache.num_elements(), num_elements);
+
+  std::vector<double> results(num_elements);
+  verdict::mesh_quality(verdict::hex_scaled_jacobian, num_elements, 8, points.data(), conn.data(),
+                        results.data());
+  check_statistics(results, request, cache.statistics());
+
+  for (int iteration = 0; iteration < 4; iteration++)
+  {
+    // move a few points, some far enough to invert their elements
+    std::vector<verdict::VerdictIndex> moved;
+    for (int i = 0; i < 25; i++)
+    {
+      const verdict::VerdictIndex point = (137 * i + 61 * iteration) % num_points;
+      moved.push_back(point);
+      for (int c = 0; c < 3; c++)
+        points[3 * point + c] += (i % 4 == 0 ? 0.9 : 0.1) * sin(5.3 * i + 2.9 * c + iteration);
+    }
+    moved.push_back(moved[0]);
+    moved.push_back(num_points + 5);
+
+    std::vector<double> previous(cache.values(), cache.values() + num_elements);
+    verdict::mesh_quality(verdict::hex_scaled_jacobian, num_elements, 8, points.data(), conn.data(),
+                 results.data());
+
+    // the elements using a moved point
+    verdict::VerdictIndex touching = 0;
+    for (verdict::VerdictIndex e = 0; e < num_elements; e++)
+    {
+      bool uses_moved = false;
+      for (int n = 0; n < 8; n++)
+        uses_moved |= std::find(moved.begin(), moved.end(), conn[8 * e + n]) != moved.end();
+      touching += uses_moved;
+      if (!uses_moved)
+      {
+        ASSERT_EQ(results[e], previous[e]);
+      }
+    }
+
+    EXPECT_EQ(cache.update(points.data(), moved.data(), (verdict::VerdictIndex)moved.size()), touching);
+    for (verdict::VerdictIndex e = 0; e < num_elements; e++)
+    {
+      ASSERT_EQ(cache.values()[e], results[e]) << "element " << e << " iteration " << iteration;
+    }
+    check_statistics(results, request, cache.statistics());
+  }
+
+  for (double& coordinate : points)
+    coordinate *= 1.5;
+  cache.update_all(points.data());
+  verdict::mesh_quality(verdict::hex_scaled_jacobian, num_elements, 8, points.data(), conn.data(),
+               results.data());
+  check_statistics(results, request, cache.statistics());
+}
+
+TEST(verdict, mesh_quality_cache_offsets)
+{
+  std::vector<double> points;
+  std::vector<verdict::VerdictIndex> hex_conn;
+  make_hex_grid(6, points, hex_conn);
+
+  std::vector<verdict::VerdictIndex> conn;
+  std::vector<verdict::VerdictIndex> offsets(1, 0);
+  for (size_t h = 0; h < hex_conn.size() / 8; h++)
+  {
+    const int num_nodes = (h % 3 == 0) ? 4 : 8;
+    conn.insert(conn.end(), hex_conn.begin() + 8 * h, hex_conn.begin() + 8 * h + num_nodes);
+    offsets.push_back((verdict::VerdictIndex)conn.size());
+  }
+  const verdict::VerdictIndex num_elements = (verdict::VerdictIndex)offsets.size() - 1;
+
+  const verdict::MeshStatisticsRequest request = { 0.0, 1.0, 4, 5, false };
+  verdict::MeshQualityCache cache(tet_or_hex_volume, num_elements, points.data(), conn.data(),
+                                  offsets.data(), request, 1);
+
+  const verdict::VerdictIndex moved[] = { 0, 100, 200 };
+  for (verdict::VerdictIndex point : moved)
+    points[3 * point + 2] += 0.4;
+  cache.update(points.data(), moved, 3);
+
+  std::vector<double> results(num_elements);
+  verdict::mesh_quality(tet_or_hex_volume, num_elements, points.data(), conn.data(), offsets.data(),
+                        results.data());
+  for (verdict::VerdictIndex e = 0; e < num_elements; e++)
+  {
+    ASSERT_EQ(cache.values()[e], results[e]) << "element " << e;
+  }
+  check_statistics(results, request, cache.statistics());
+}
+
+TEST(verdict, metric_result_cache)
+{
+  std::vector<double> points;
+  std::vector<verdict::VerdictIndex> conn;
+  make_hex_grid(5, points, conn);
+  const verdict::VerdictIndex num_elements = conn.size() / 8;
+  const verdict::VerdictMetric metric = verdict::VERDICT_METRIC_HEX_SCALED_JACOBIAN;
+
+  std::vector<double> expected(num_elements);
+  verdict::mesh_quality(metric, num_elements, 8, points.data(), conn.data(), 0., expected.data());
+
+  verdict::MetricResultCache cache(1000);
+  EXPECT_EQ(cache.capacity(), 1024);
+  std::vector<double> results(num_elements, -1.0);
+  EXPECT_EQ(cache.mesh_quality(metric, num_elements, 8, points.data(), conn.data(), 0.,
+                               results.data(), 0), num_elements);
+  EXPECT_EQ(cache.size(), num_elements);
+  EXPECT_EQ(results, expected);
+
+  // everything is found, and the average size of a metric without one is ignored
+  results.assign(num_elements, -1.0);
+  EXPECT_EQ(cache.mesh_quality(metric, num_elements, 8, points.data(), conn.data(), 2.,
+                               results.data(), 2), 0);
+  EXPECT_EQ(results, expected);
+  EXPECT_EQ(cache.hits(), num_elements);
+  EXPECT_EQ(cache.misses(), num_elements);
+
+  // a moved point changes the keys of the elements using it
+  points[3 * 43 + 1] += 0.05;
+  verdict::mesh_quality(metric, num_elements, 8, points.data(), conn.data(), 0., expected.data());
+  EXPECT_EQ(cache.mesh_quality(metric, num_elements, 8, points.data(), conn.data(), 0.,
+                               results.data(), 1), 8);
+  EXPECT_EQ(results, expected);
+
+  // the sized metrics are keyed by the average size
+  const verdict::VerdictMetric sized = verdict::VERDICT_METRIC_HEX_RELATIVE_SIZE_SQUARED;
+  const double average_sizes[3] = { 0.9, 1.1, 0.9 };
+  const verdict::VerdictIndex evaluated[3] = { num_elements, num_elements, 0 };
+  for (int i = 0; i < 3; i++)
+  {
+    verdict::mesh_quality(sized, num_elements, 8, points.data(), conn.data(), average_sizes[i],
+                          expected.data());
+    EXPECT_EQ(cache.mesh_quality(sized, num_elements, 8, points.data(), conn.data(), average_sizes[i],
+                                 results.data(), 0), evaluated[i]);
+    EXPECT_EQ(results, expected);
+  }
+  EXPECT_EQ(cache.size(), 3 * num_elements + 8);
+
+  // a later run loads the values
+  const char* path = "metric_result_cache.bin";
+  ASSERT_TRUE(cache.save(path));
+  verdict::MetricResultCache loaded(cache.capacity());
+  ASSERT_TRUE(loaded.load(path));
+  EXPECT_EQ(loaded.size(), cache.size());
+  EXPECT_EQ(loaded.mesh_quality(sized, num_elements, 8, points.data(), conn.data(), 1.1,
+                                results.data(), 0), 0);
+  EXPECT_EQ(loaded.mesh_quality(metric, num_elements, 8, points.data(), conn.data(), 0.,
+                                results.data(), 0), 0);
+  remove(path);
+  EXPECT_FALSE(loaded.load(path));
+
+  // a small table keeps the values it last used and still gives the right results
+  verdict::MetricResultCache small(16);
+  verdict::mesh_quality(metric, num_elements, 8, points.data(), conn.data(), 0., expected.data());
+  for (int pass = 0; pass < 2; pass++)
+  {
+    results.assign(num_elements, -1.0);
+    EXPECT_GE(small.mesh_quality(metric, num_elements, 8, points.data(), conn.data(), 0.,
+                                 results.data(), 0), num_elements - 16);
+    EXPECT_EQ(results, expected);
+    EXPECT_EQ(small.size(), small.capacity());
+  }
+
+  small.clear();
+  EXPECT_EQ(small.size(), 0);
+  EXPECT_EQ(small.mesh_quality(metric, 8, 8, points.data(), conn.data(), 0., results.data(), 0), 8);
+  EXPECT_EQ(small.mesh_quality(metric, 8, 8, points.data(), conn.data(), 0., results.data(), 0), 0);
+}
+
+// records the tickets in the order their callbacks are called
+static void record_ticket(void* tickets, verdict::VerdictIndex ticket)
+{
+  static_cast<std::vector<verdict::VerdictIndex>*>(tickets)->push_back(ticket);
+}
+
+#if defined(VERDICT_PARALLEL_THREADS) || defined(VERDICT_PARALLEL_OPENMP) || defined(VERDICT_PARALLEL_TBB)
+// holds the thread of the queue until released
+static void hold_queue(void* released, verdict::VerdictIndex)
+{
+  while (!static_cast<std::atomic<bool>*>(released)->load())
+    std::this_thread::yield();
+}
+#endif
+
+TEST(verdict, mesh_quality_queue)
+{
+  std::vector<double> points;
+  std::vector<verdict::VerdictIndex> conn;
+  make_hex_grid(6, points, conn);
+  const verdict::VerdictIndex num_elements = conn.size() / 8;
+  const verdict::VerdictMetric metrics[2] = { verdict::VERDICT_METRIC_HEX_SCALED_JACOBIAN,
+                                              verdict::VERDICT_METRIC_HEX_RELATIVE_SIZE_SQUARED };
+
+  std::vector<double> expected[2];
+  for (int m = 0; m < 2; m++)
+  {
+    expected[m].resize(num_elements);
+    verdict::mesh_quality(metrics[m], num_elements, 8, points.data(), conn.data(), 1.1,
+                          expected[m].data());
+  }
+
+  // the grid in five blocks of consecutive elements, through a queue of two
+  std::vector<double> results[2];
+  results[0].assign(num_elements, -1.0);
+  results[1].assign(num_elements, -1.0);
+  std::vector<verdict::VerdictIndex> tickets;
+  {
+    verdict::MeshQualityQueue queue(2, 2);
+    EXPECT_EQ(queue.max_pending(), 2);
+    const int num_blocks = 5;
+    for (int b = 0; b < num_blocks; b++)
+    {
+      const verdict::VerdictIndex first = num_elements * b / num_blocks;
+      const verdict::VerdictIndex last = num_elements * (b + 1) / num_blocks;
+      double* const block_results[2] = { results[0].data() + first, results[1].data() + first };
+      const verdict::QualityBlock block = { last - first, 8, points.data(), conn.data() + 8 * first,
+                                            1.1, 2, metrics, block_results };
+      EXPECT_EQ(queue.submit(block, record_ticket, &tickets), b + 1);
+      EXPECT_LE(queue.pending(), 2);
+    }
+    queue.wait(3);
+    EXPECT_TRUE(queue.is_complete(3));
+    queue.wait_all();
+    EXPECT_EQ(queue.pending(), 0);
+    EXPECT_TRUE(queue.is_complete(5));
+  }
+  const std::vector<verdict::VerdictIndex> in_order = { 1, 2, 3, 4, 5 };
+  EXPECT_EQ(tickets, in_order);
+  EXPECT_EQ(results[0], expected[0]);
+  EXPECT_EQ(results[1], expected[1]);
+
+#if defined(VERDICT_PARALLEL_THREADS) || defined(VERDICT_PARALLEL_OPENMP) || defined(VERDICT_PARALLEL_TBB)
+  // a full queue turns blocks away until its oldest one completes
+  std::atomic<bool> released(false);
+  verdict::MeshQualityQueue queue(1, 1);
+  double* const first_results[1] = { results[0].data() };
+  const verdict::QualityBlock block = { num_elements, 8, points.data(), conn.data(), 0., 1, metrics,
+                                        first_results };
+  const verdict::VerdictIndex held = queue.submit(block, hold_queue, &released);
+  verdict::VerdictIndex ticket = 0;
+  EXPECT_FALSE(queue.try_submit(block, nullptr, nullptr, ticket));
+  EXPECT_EQ(queue.pending(), 1);
+  EXPECT_FALSE(queue.is_complete(held));
+  released = true;
+  queue.wait(held);
+  EXPECT_TRUE(queue.try_submit(block, nullptr, nullptr, ticket));
+  EXPECT_EQ(ticket, held + 1);
+#endif
+}
+
+TEST(verdict, mesh_failing_elements)
+{
+  std::vector<double> points;
+  std::vector<verdict::VerdictIndex> conn;
+  make_hex_grid(15, points, conn);
+  const verdict::VerdictIndex num_elements = (verdict::VerdictIndex)conn.size() / 8;
+
+  std::vector<double> results(num_elements);
+  verdict::mesh_quality(verdict::hex_scaled_jacobian, num_elements, 8, points.data(), conn.data(),
+                        results.data());
+
+  const double threshold = 0.6;
+  verdict::VerdictIndex expected_count = 0;
+  for (double value : results)
+    expected_count += value < threshold;
+  ASSERT_GT(expected_count, 0);
+  ASSERT_LT(expected_count, num_elements);
+
+  for (int num_threads : { 1, 3 })
+  {
+    std::vector<unsigned long long> failing((num_elements + 63) / 64, ~0ULL);
+    EXPECT_EQ(verdict::mesh_failing_elements(verdict::hex_scaled_jacobian_at_least, threshold,
+                                             num_elements, 8, points.data(), conn.data(),
+                                             failing.data(), num_threads),
+              expected_count);
+    for (verdict::VerdictIndex e = 0; e < num_elements; e++)
+    {
+      const bool fails = (failing[e / 64] >> (e % 64)) & 1;
+      ASSERT_EQ(fails, results[e] < threshold) << "element " << e;
+    }
+    // the bits past the last element are cleared
+    EXPECT_EQ(failing.back() >> (num_elements % 64), 0ULL);
+  }
+
+  // the same elements through offsets, plus one with too many nodes, which
+  // fails whatever the threshold
+  std::vector<verdict::VerdictIndex> offsets;
+  for (verdict::VerdictIndex e = 0; e <= num_elements; e++)
+    offsets.push_back(8 * e);
+  offsets.push_back(8 * num_elements + 28);
+  conn.resize(conn.size() + 28, 0);
+  std::vector<unsigned long long> failing((num_elements + 64) / 64);
+  EXPECT_EQ(verdict::mesh_failing_elements(verdict::hex_jacobian_at_least, -1e300, num_elements + 1,
+                                           points.data(), conn.data(), offsets.data(),
+                                           failing.data(), 4),
+            1);
+  EXPECT_EQ((failing[num_elements / 64] >> (num_elements % 64)) & 1, 1ULL);
+}
+
+TEST(verdict, mesh_screen_elements)
+{
+  // hex27s whose nodes are on a 3x3x3 lattice in the hex27 order: the
+  // flattened ones fail on their estimate, most of the others pass on it and
+  // the ones with curved edges are evaluated exactly
+  const double local[27][3] = {
+    {-1,-1,-1}, {1,-1,-1}, {1,1,-1}, {-1,1,-1}, {-1,-1,1}, {1,-1,1}, {1,1,1}, {-1,1,1},
+    {0,-1,-1}, {1,0,-1}, {0,1,-1}, {-1,0,-1}, {-1,-1,0}, {1,-1,0}, {1,1,0}, {-1,1,0},
+    {0,-1,1}, {1,0,1}, {0,1,1}, {-1,0,1},
+    {0,0,0}, {0,0,-1}, {0,0,1}, {-1,0,0}, {1,0,0}, {0,-1,0}, {0,1,0}
+  };
+  const int num_elements = 150;
+  std::vector<double> points(3 * 27 * num_elements);
+  std::vector<verdict::VerdictIndex> conn(27 * num_elements);
+  for (int e = 0; e < num_elements; e++)
+  {
+    const double height = e % 5 == 0 ? 0.5 : 1.0;
+    const double amplitude = e % 7 == 0 ? 0.3 : 0.01;
+    for (int n = 0; n < 27; n++)
+    {
+      const int point = 27 * e + n;
+      conn[point] = point;
+      for (int c = 0; c < 3; c++)
+        points[3 * point + c] = 3.0 * e + (c == 2 ? height : 1.0) * local[n][c] +
+          amplitude * sin(1.3 * (3 * point + c));
+    }
+  }
+
+  std::vector<double> expected(num_elements);
+  verdict::mesh_quality(verdict::hex_jacobian, num_elements, 27, points.data(), conn.data(),
+                        expected.data());
+  const double threshold = 6.0;
+  verdict::VerdictIndex expected_count = 0;
+  for (double value : expected)
+    expected_count += value < threshold;
+  ASSERT_GT(expected_count, 0);
+  ASSERT_LT(expected_count, num_elements);
+
+  std::vector<verdict::VerdictIndex> offsets;
+  for (verdict::VerdictIndex e = 0; e <= num_elements; e++)
+    offsets.push_back(27 * e);
+
+  for (int num_threads : { 1, 3 })
+    for (bool mixed : { false, true })
+    {
+      std::vector<double> results(num_elements, -1.0);
+      std::vector<unsigned long long> failing((num_elements + 63) / 64, ~0ULL);
+      std::vector<unsigned long long> exact((num_elements + 63) / 64, ~0ULL);
+      const verdict::VerdictIndex count = mixed ?
+        verdict::mesh_screen_elements(verdict::hex_jacobian_estimate, verdict::hex_jacobian, threshold,
+                                      num_elements, points.data(), conn.data(), offsets.data(),
+                                      results.data(), failing.data(), exact.data(), num_threads) :
+        verdict::mesh_screen_elements(verdict::hex_jacobian_estimate, verdict::hex_jacobian, threshold,
+                                      num_elements, 27, points.data(), conn.data(), results.data(),
+                                      failing.data(), exact.data(), num_threads);
+      EXPECT_EQ(count, expected_count);
+
+      int num_exact = 0;
+      for (int e = 0; e < num_elements; e++)
+      {
+        ASSERT_EQ((failing[e / 64] >> (e % 64)) & 1, expected[e] < threshold ? 1ULL : 0ULL) << "element " << e;
+        if ((exact[e / 64] >> (e % 64)) & 1)
+        {
+          num_exact++;
+          EXPECT_EQ(results[e], expected[e]) << "element " << e;
+        }
+        else
+        {
+          verdict::MetricEstimate estimate;
+          double coordinates[27][3];
+          for (int n = 0; n < 27; n++)
+            for (int c = 0; c < 3; c++)
+              coordinates[n][c] = points[3 * (27 * e + n) + c];
+          verdict::hex_jacobian_estimate(27, coordinates, estimate);
+          EXPECT_EQ(results[e], estimate.value) << "element " << e;
+        }
+      }
+      EXPECT_GT(num_exact, 0);
+      EXPECT_LT(num_exact, num_elements / 2);
+      EXPECT_EQ(failing.back() >> (num_elements % 64), 0ULL);
+      EXPECT_EQ(exact.back() >> (num_elements % 64), 0ULL);
+    }
+
+  // without results nor exact bits, and an element with too many nodes
+  offsets.push_back(27 * num_elements + 28);
+  conn.resize(conn.size() + 28, 0);
+  std::vector<unsigned long long> failing((num_elements + 64) / 64);
+  EXPECT_EQ(verdict::mesh_screen_elements(verdict::hex_jacobian_estimate, verdict::hex_jacobian, threshold,
+                                          num_elements + 1, points.data(), conn.data(), offsets.data(),
+                                          nullptr, failing.data(), nullptr, 2),
+            expected_count + 1);
+  EXPECT_EQ((failing[num_elements / 64] >> (num_elements % 64)) & 1, 1ULL);
+}
+
+typedef double (*SizeFunction)(int, double[][3], double);
+
+// compare both passes with the single element metrics given the mesh average
+static void check_size_quality(verdict::VerdictSizeElement type, int num_nodes,
+                               verdict::VerdictFunction size, const SizeFunction metrics[3])
+{
+  std::vector<double> points;
+  std::vector<verdict::VerdictIndex> hex_conn;
+  make_hex_grid(10, points, hex_conn);
+
+  // the first corners of each hex, picked so tets have a positive volume
+  const int corners[8] = { 0, 1, 3, 4, 0, 0, 0, 0 };
+  const bool tet = type == verdict::VERDICT_SIZE_TET;
+  std::vector<verdict::VerdictIndex> conn;
+  for (size_t h = 0; h < hex_conn.size() / 8; h++)
+    for (int n = 0; n < num_nodes; n++)
+      conn.push_back(hex_conn[8 * h + (tet ? corners[n] : n)]);
+  const verdict::VerdictIndex num_elements = (verdict::VerdictIndex)conn.size() / num_nodes;
+
+  double sum = 0.0;
+  for (verdict::VerdictIndex e = 0; e < num_elements; e++)
+    sum += single_element(size, reinterpret_cast<const double(*)[3]>(points.data()),
+                          conn.data() + num_nodes * e, num_nodes);
+
+  for (int num_threads : { 1, 3 })
+  {
+    std::vector<double> measures(num_elements);
+    const double average = verdict::mesh_element_sizes(type, num_elements, num_nodes, points.data(),
+                                                       conn.data(), measures.data(), num_threads);
+    EXPECT_NEAR(average, sum / num_elements, 1e-12 * fabs(average));
+
+    const verdict::VerdictSizeMetric size_metrics[3] =
+    {
+      verdict::VERDICT_RELATIVE_SIZE_SQUARED, verdict::VERDICT_SHAPE_AND_SIZE,
+      verdict::VERDICT_SHEAR_AND_SIZE
+    };
+    for (int m = 0; m < 3; m++)
+    {
+      std::vector<double> results(num_elements, -2.0);
+      verdict::mesh_size_quality(type, size_metrics[m], num_elements, num_nodes, points.data(),
+                                 conn.data(), measures.data(), average, results.data(), num_threads);
+
+      // both passes in one call, through the results array
+      std::vector<double> in_place(num_elements, -2.0);
+      EXPECT_EQ(verdict::mesh_size_quality(type, size_metrics[m], num_elements, num_nodes,
+                                           points.data(), conn.data(), in_place.data(), num_threads),
+                average);
+
+      for (verdict::VerdictIndex e = 0; e < num_elements; e++)
+      {
+        double coordinates[8][3];
+        for (int n = 0; n < num_nodes; n++)
+          for (int c = 0; c < 3; c++)
+            coordinates[n][c] = points[3 * conn[num_nodes * e + n] + c];
+        const double expected = metrics[m] ? metrics[m](num_nodes, coordinates, average) : 0.0;
+        ASSERT_EQ(results[e], expected) << "element " << e << " metric " << m;
+        ASSERT_EQ(in_place[e], expected) << "element " << e << " metric " << m;
+      }
+    }
+  }
+}
+
+TEST(verdict, mesh_size_quality)
+{
+  const SizeFunction hex_metrics[3] =
+    { verdict::hex_relative_size_squared, verdict::hex_shape_and_size, verdict::hex_shear_and_size };
+  check_size_quality(verdict::VERDICT_SIZE_HEX, 8, verdict::hex_volume, hex_metrics);
+
+  const SizeFunction tet_metrics[3] =
+    { verdict::tet_relative_size_squared, verdict::tet_shape_and_size, nullptr };
+  check_size_quality(verdict::VERDICT_SIZE_TET, 4, verdict::tet_volume, tet_metrics);
+
+  const SizeFunction quad_metrics[3] =
+    { verdict::quad_relative_size_squared, verdict::quad_shape_and_size, verdict::quad_shear_and_size };
+  check_size_quality(verdict::VERDICT_SIZE_QUAD, 4, verdict::quad_area, quad_metrics);
+
+  const SizeFunction tri_metrics[3] =
+    { verdict::tri_relative_size_squared, verdict::tri_shape_and_size, nullptr };
+  check_size_quality(verdict::VERDICT_SIZE_TRI, 3, verdict::tri_area, tri_metrics);
+}
+
+// one sweep against hex_timestep or tet_timestep and the sign of the jacobian
+static void check_timestep(verdict::VerdictElementType type, int num_nodes,
+                           const std::vector<double>& points, const std::vector<verdict::VerdictIndex>& conn,
+                           verdict::VerdictFunction jacobian)
+{
+  const verdict::VerdictIndex num_elements = (verdict::VerdictIndex)conn.size() / num_nodes;
+  std::vector<double> density(num_elements), poissons_ratio(num_elements), youngs_modulus(num_elements);
+  for (verdict::VerdictIndex e = 0; e < num_elements; e++)
+  {
+    density[e] = 7800.0 + 10.0 * (e % 13);
+    poissons_ratio[e] = 0.25 + 0.01 * (e % 7);
+    youngs_modulus[e] = 2e11 * (1.0 + 0.1 * (e % 3));
+  }
+
+  std::vector<double> expected(num_elements);
+  std::vector<unsigned char> expected_flags(num_elements);
+  verdict::VerdictIndex expected_inverted = 0, expected_element = 0;
+  for (verdict::VerdictIndex e = 0; e < num_elements; e++)
+  {
+    double coordinates[10][3];
+    for (int n = 0; n < num_nodes; n++)
+      for (int c = 0; c < 3; c++)
+        coordinates[n][c] = points[3 * conn[num_nodes * e + n] + c];
+    expected[e] = type == verdict::VERDICT_ELEMENT_HEX
+      ? verdict::hex_timestep(num_nodes, coordinates, density[e], poissons_ratio[e], youngs_modulus[e])
+      : verdict::tet_timestep(num_nodes, coordinates, density[e], poissons_ratio[e], youngs_modulus[e]);
+    expected_flags[e] = jacobian(num_nodes, coordinates) <= 0;
+    expected_inverted += expected_flags[e];
+    if (expected[e] < expected[expected_element])
+      expected_element = e;
+  }
+  ASSERT_GT(expected_inverted, 0);
+
+  for (int num_threads : { 1, 3 })
+  {
+    std::vector<double> timesteps(num_elements, -1.0);
+    std::vector<unsigned char> inverted(num_elements, 2);
+    verdict::MeshTimestep timestep;
+    verdict::mesh_timestep(type, num_elements, num_nodes, points.data(), conn.data(), density.data(),
+                           poissons_ratio.data(), youngs_modulus.data(), timesteps.data(),
+                           inverted.data(), timestep, num_threads);
+    EXPECT_EQ(timestep.minimum, expected[expected_element]);
+    EXPECT_EQ(timestep.element, expected_element);
+    EXPECT_EQ(timestep.num_inverted, expected_inverted);
+    for (verdict::VerdictIndex e = 0; e < num_elements; e++)
+    {
+      ASSERT_EQ(timesteps[e], expected[e]) << "element " << e;
+      ASSERT_EQ(inverted[e], expected_flags[e]) << "element " << e;
+    }
+
+    // only the smallest timestep
+    verdict::MeshTimestep minimum;
+    verdict::mesh_timestep(type, num_elements, num_nodes, points.data(), conn.data(), density.data(),
+                           poissons_ratio.data(), youngs_modulus.data(), nullptr, nullptr, minimum,
+                           num_threads);
+    EXPECT_EQ(minimum.minimum, timestep.minimum);
+    EXPECT_EQ(minimum.element, timestep.element);
+    EXPECT_EQ(minimum.num_inverted, timestep.num_inverted);
+  }
+}
+
+TEST(verdict, mesh_timestep)
+{
+  std::vector<double> points;
+  std::vector<verdict::VerdictIndex> hex_conn;
+  make_hex_grid(6, points, hex_conn);
+  // push a corner of the first hex through the opposite face
+  for (int c = 0; c < 3; c++)
+    points[3 * hex_conn[0] + c] = points[3 * hex_conn[6] + c] + 0.5;
+  check_timestep(verdict::VERDICT_ELEMENT_HEX, 8, points, hex_conn, verdict::hex_jacobian);
+
+  // the tets at the first corners of the hexes, with every fourth one turned inside out
+  std::vector<verdict::VerdictIndex> tet_conn;
+  for (size_t h = 0; h < hex_conn.size() / 8; h++)
+  {
+    const int corners[4] = { 0, 1, 3, 4 };
+    for (int n = 0; n < 4; n++)
+      tet_conn.push_back(hex_conn[8 * h + corners[h % 4 == 3 ? 3 - n : n]]);
+  }
+  check_timestep(verdict::VERDICT_ELEMENT_TET, 4, points, tet_conn, verdict::tet_jacobian);
+
+  // the same tets with nodes at the midpoints of their edges
+  const int edges[6][2] = { {0, 1}, {1, 2}, {2, 0}, {0, 3}, {1, 3}, {2, 3} };
+  std::vector<verdict::VerdictIndex> tet10_conn;
+  for (size_t t = 0; t < tet_conn.size() / 4; t++)
+  {
+    for (int n = 0; n < 4; n++)
+      tet10_conn.push_back(tet_conn[4 * t + n]);
+    for (int m = 0; m < 6; m++)
+    {
+      tet10_conn.push_back((verdict::VerdictIndex)points.size() / 3);
+      for (int c = 0; c < 3; c++)
+        points.push_back(0.5 * (points[3 * tet_conn[4 * t + edges[m][0]] + c] +
+                                points[3 * tet_conn[4 * t + edges[m][1]] + c]));
+    }
+  }
+  check_timestep(verdict::VERDICT_ELEMENT_TET, 10, points, tet10_conn, verdict::tet_jacobian);
+
+  // unsupported element types measure nothing
+  std::vector<double> timesteps(4, -1.0);
+  verdict::MeshTimestep timestep;
+  verdict::mesh_timestep(verdict::VERDICT_ELEMENT_QUAD, 4, 4, points.data(), tet_conn.data(), nullptr,
+                         nullptr, nullptr, timesteps.data(), nullptr, timestep, 1);
+  EXPECT_EQ(timestep.element, -1);
+  EXPECT_EQ(timestep.num_inverted, 0);
+  EXPECT_EQ(timesteps[3], 0.0);
+}
+
+// deterministic perturbation in [-amplitude, amplitude]
+static double perturbation(int i, double amplitude)
+{
+  return amplitude * sin(12.9898 * i + 78.233 * (i % 7));
+}
+
+// fill a structure-of-arrays batch from perturbed copies of a reference element
+static void make_soa_batch(const double reference[][3], int num_nodes, int num_elements,
+                           std::vector<double>& soa)
+{
+  soa.assign(3 * num_nodes * num_elements, 0.0);
+  for (int e = 0; e < num_elements; e++)
+  {
+    // every fifth element is badly distorted to exercise the degenerate branches
+    const double amplitude = (e % 5 == 4) ? 1.5 : 0.2;
+    for (int n = 0; n < num_nodes; n++)
+      for (int c = 0; c < 3; c++)
+        soa[(3 * n + c) * num_elements + e] =
+          reference[n][c] + perturbation((e * num_nodes + n) * 3 + c, amplitude);
+  }
+  // an element collapsed to a point
+  for (int n = 0; n < num_nodes; n++)
+    for (int c = 0; c < 3; c++)
+      soa[(3 * n + c) * num_elements + 1] = 0.0;
+}
+
+static void check_soa(void (*soa_metric)(verdict::VerdictIndex, const double*, verdict::VerdictIndex, double*),
+                      verdict::VerdictFunction metric, const double reference[][3], int num_nodes)
+{
+  const int num_elements = 37;
+  std::vector<double> soa;
+  make_soa_batch(reference, num_nodes, num_elements, soa);
+
+  const verdict::VerdictSimdLevel default_level = verdict::simd_level();
+  const verdict::VerdictSimdLevel levels[] =
+  {
+    verdict::VERDICT_SIMD_SCALAR, verdict::VERDICT_SIMD_NEON,
+    verdict::VERDICT_SIMD_AVX2, verdict::VERDICT_SIMD_AVX512
+  };
+  for (verdict::VerdictSimdLevel level : levels)
+  {
+    const verdict::VerdictSimdLevel selected = verdict::set_simd_level(level);
+    EXPECT_LE(selected, level);
+
+    std::vector<double> results(num_elements);
+    soa_metric(num_elements, soa.data(), num_elements, results.data());
+
+    for (int e = 0; e < num_elements; e++)
+    {
+      double coordinates[8][3];
+      for (int n = 0; n < num_nodes; n++)
+        for (int c = 0; c < 3; c++)
+          coordinates[n][c] = soa[(3 * n + c) * num_elements + e];
+      const double expected = metric(num_nodes, coordinates);
+      EXPECT_NEAR(results[e], expected, 1e-12 * fabs(expected) + 1e-14)
+        << "element " << e << " simd level " << selected;
+    }
+  }
+  verdict::set_simd_level(default_level);
+}
+
+typedef void (*SoaFunctionFloat)(verdict::VerdictIndex, const float*, verdict::VerdictIndex, float*);
+typedef void (*SoaFunctionMixed)(verdict::VerdictIndex, const float*, verdict::VerdictIndex, double*);
+
+// the float overloads against the double metric evaluated on the rounded coordinates
+static void check_soa_float(SoaFunctionFloat soa_float, SoaFunctionMixed soa_mixed,
+                            verdict::VerdictFunction metric, const double reference[][3], int num_nodes)
+{
+  const int num_elements = 53;
+  std::vector<double> soa;
+  make_soa_batch(reference, num_nodes, num_elements, soa);
+  const std::vector<float> soa_single(soa.begin(), soa.end());
+
+  const verdict::VerdictSimdLevel default_level = verdict::simd_level();
+  const verdict::VerdictSimdLevel levels[] =
+  {
+    verdict::VERDICT_SIMD_SCALAR, verdict::VERDICT_SIMD_NEON,
+    verdict::VERDICT_SIMD_AVX2, verdict::VERDICT_SIMD_AVX512
+  };
+  for (verdict::VerdictSimdLevel level : levels)
+  {
+    const verdict::VerdictSimdLevel selected = verdict::set_simd_level(level);
+
+    std::vector<float> results_float(num_elements);
+    std::vector<double> results_mixed(num_elements);
+    soa_float(num_elements, soa_single.data(), num_elements, results_float.data());
+    soa_mixed(num_elements, soa_single.data(), num_elements, results_mixed.data());
+
+    for (int e = 0; e < num_elements; e++)
+    {
+      double coordinates[8][3];
+      for (int n = 0; n < num_nodes; n++)
+        for (int c = 0; c < 3; c++)
+          coordinates[n][c] = soa_single[(3 * n + c) * num_elements + e];
+      const double expected = metric(num_nodes, coordinates);
+
+      // the mixed precision path only rounds the input
+      EXPECT_NEAR(results_mixed[e], expected, 1e-12 * fabs(expected) + 1e-14)
+        << "element " << e << " simd level " << selected;
+
+      // the badly distorted elements may be nearly flat, where float loses everything
+      if (e % 5 != 4)
+      {
+        EXPECT_NEAR(results_float[e], expected, 1e-4 * fabs(expected) + 1e-5)
+          << "element " << e << " simd level " << selected;
+      }
+    }
+  }
+  verdict::set_simd_level(default_level);
+}
+
+static const double reference_tet[4][3] =
+{
+  {0, 0, 0}, {1, 0, 0}, {0.5, 0.866025, 0}, {0.5, 0.288675, 0.816497}
+};
+
+TEST(verdict, soa_tet_volume)
+{
+  check_soa(verdict::tet_volume_soa, verdict::tet_volume, reference_tet, 4);
+}
+
+TEST(verdict, soa_tet_scaled_jacobian)
+{
+  check_soa(verdict::tet_scaled_jacobian_soa, verdict::tet_scaled_jacobian, reference_tet, 4);
+}
+
+TEST(verdict, soa_tet_mean_ratio)
+{
+  check_soa(verdict::tet_mean_ratio_soa, verdict::tet_mean_ratio, reference_tet, 4);
+}
+
+TEST(verdict, soa_hex_scaled_jacobian)
+{
+  check_soa(verdict::hex_scaled_jacobian_soa, verdict::hex_scaled_jacobian, two_hex_points, 8);
+}
+
+TEST(verdict, soa_hex_nodal_jacobian_ratio)
+{
+  check_soa(verdict::hex_nodal_jacobian_ratio_soa, verdict::hex_nodal_jacobian_ratio, two_hex_points, 8);
+}
+
+static const double reference_quad[4][3] =
+{
+  {0, 0, 0}, {1, 0, 0}, {1, 1, 0.1}, {0, 1, 0}
+};
+
+static const double reference_tri[3][3] =
+{
+  {0, 0, 0}, {1, 0, 0}, {0.5, 0.866025, 0}
+};
+
+TEST(verdict, soa_quad_scaled_jacobian)
+{
+  check_soa(verdict::quad_scaled_jacobian_soa, verdict::quad_scaled_jacobian, reference_quad, 4);
+}
+
+TEST(verdict, soa_quad_warpage)
+{
+  check_soa(verdict::quad_warpage_soa, verdict::quad_warpage, reference_quad, 4);
+}
+
+TEST(verdict, soa_quad_minimum_angle)
+{
+  check_soa(verdict::quad_minimum_angle_soa, verdict::quad_minimum_angle, reference_quad, 4);
+}
+
+TEST(verdict, soa_tri_minimum_angle)
+{
+  check_soa(verdict::tri_minimum_angle_soa, verdict::tri_minimum_angle, reference_tri, 3);
+}
+
+TEST(verdict, soa_surface_quality)
+{
+  const int num_elements = 23;
+  std::vector<double> quads, tris;
+  make_soa_batch(reference_quad, 4, num_elements, quads);
+  make_soa_batch(reference_tri, 3, num_elements, tris);
+  // a quad collapsed to a tri and one with a zero length edge
+  for (int c = 0; c < 3; c++)
+  {
+    quads[(3 * 3 + c) * num_elements + 6] = quads[(3 * 2 + c) * num_elements + 6];
+    quads[(3 * 1 + c) * num_elements + 7] = quads[(3 * 0 + c) * num_elements + 7];
+  }
+
+  const verdict::VerdictSimdLevel default_level = verdict::simd_level();
+  const verdict::VerdictSimdLevel levels[] =
+  {
+    verdict::VERDICT_SIMD_SCALAR, verdict::VERDICT_SIMD_NEON,
+    verdict::VERDICT_SIMD_AVX2, verdict::VERDICT_SIMD_AVX512
+  };
+  for (verdict::VerdictSimdLevel level : levels)
+  {
+    const verdict::VerdictSimdLevel selected = verdict::set_simd_level(level);
+
+    std::vector<double> scaled_jacobian(num_elements), warpage(num_elements, -1.0),
+      minimum_angle(num_elements), cosine(num_elements);
+    const verdict::SurfaceQualityArrays quad_arrays =
+      { scaled_jacobian.data(), warpage.data(), minimum_angle.data(), cosine.data() };
+    verdict::quad_quality_soa(num_elements, quads.data(), num_elements, quad_arrays);
+    for (int e = 0; e < num_elements; e++)
+    {
+      double coordinates[4][3];
+      for (int n = 0; n < 4; n++)
+        for (int c = 0; c < 3; c++)
+          coordinates[n][c] = quads[(3 * n + c) * num_elements + e];
+      const double expected_jacobian = verdict::quad_scaled_jacobian(4, coordinates);
+      const double expected_warpage = verdict::quad_warpage(4, coordinates);
+      const double expected_angle = verdict::quad_minimum_angle(4, coordinates);
+      EXPECT_NEAR(scaled_jacobian[e], expected_jacobian, 1e-12 * fabs(expected_jacobian) + 1e-14)
+        << "element " << e << " simd level " << selected;
+      EXPECT_NEAR(warpage[e], expected_warpage, 1e-12 * fabs(expected_warpage) + 1e-14)
+        << "element " << e << " simd level " << selected;
+      EXPECT_NEAR(minimum_angle[e], expected_angle, 1e-10)
+        << "element " << e << " simd level " << selected;
+      EXPECT_NEAR(cosine[e], cos(minimum_angle[e] * verdict::VERDICT_PI / 180.), 1e-12)
+        << "element " << e << " simd level " << selected;
+    }
+
+    // the tris skip the warpage, and the arrays not asked for are left alone
+    const verdict::SurfaceQualityArrays tri_arrays =
+      { scaled_jacobian.data(), warpage.data(), nullptr, cosine.data() };
+    minimum_angle.assign(num_elements, -1.0);
+    verdict::tri_quality_soa(num_elements, tris.data(), num_elements, tri_arrays);
+    for (int e = 0; e < num_elements; e++)
+    {
+      double coordinates[3][3];
+      for (int n = 0; n < 3; n++)
+        for (int c = 0; c < 3; c++)
+          coordinates[n][c] = tris[(3 * n + c) * num_elements + e];
+      const double expected_jacobian = verdict::tri_scaled_jacobian(3, coordinates);
+      const double expected_angle = verdict::tri_minimum_angle(3, coordinates);
+      EXPECT_NEAR(scaled_jacobian[e], expected_jacobian, 1e-12 * fabs(expected_jacobian) + 1e-14)
+        << "element " << e << " simd level " << selected;
+      EXPECT_NEAR(cosine[e], cos(expected_angle * verdict::VERDICT_PI / 180.), 1e-12)
+        << "element " << e << " simd level " << selected;
+      EXPECT_EQ(minimum_angle[e], -1.0);
+    }
+  }
+  verdict::set_simd_level(default_level);
+}
+
+TEST(verdict, soa_float)
+{
+  check_soa_float(verdict::tet_volume_soa, verdict::tet_volume_soa, verdict::tet_volume, reference_tet, 4);
+  check_soa_float(verdict::tet_scaled_jacobian_soa, verdict::tet_scaled_jacobian_soa,
+                  verdict::tet_scaled_jacobian, reference_tet, 4);
+  check_soa_float(verdict::tet_mean_ratio_soa, verdict::tet_mean_ratio_soa,
+                  verdict::tet_mean_ratio, reference_tet, 4);
+  check_soa_float(verdict::hex_scaled_jacobian_soa, verdict::hex_scaled_jacobian_soa,
+                  verdict::hex_scaled_jacobian, two_hex_points, 8);
+  check_soa_float(verdict::hex_nodal_jacobian_ratio_soa, verdict::hex_nodal_jacobian_ratio_soa,
+                  verdict::hex_nodal_jacobian_ratio, two_hex_points, 8);
+}
+
+TEST(verdict, metric_registry)
+{
+  for (int m = 0; m < verdict::VERDICT_NUM_METRICS; m++)
+  {
+    const verdict::VerdictMetric metric = static_cast<verdict::VerdictMetric>(m);
+    const verdict::VerdictMetricInfo* info = verdict::metric_info(metric);
+    ASSERT_NE(info, nullptr);
+    EXPECT_EQ(info->metric, metric);
+    EXPECT_TRUE((info->function == nullptr) != (info->sized_function == nullptr)) << info->name;
+    EXPECT_LE(info->acceptable_min, info->acceptable_max) << info->name;
+    EXPECT_LE(info->normal_min, info->normal_max) << info->name;
+    EXPECT_LE(info->full_min, info->full_max) << info->name;
+
+    verdict::VerdictMetric found = verdict::VERDICT_NUM_METRICS;
+    EXPECT_TRUE(verdict::find_metric(info->name, found));
+    EXPECT_EQ(found, metric);
+
+    // the names of the old C interface
+    std::string name = std::string("V_") + info->name;
+    std::transform(name.begin(), name.end(), name.begin(), ::toupper);
+    found = verdict::VERDICT_NUM_METRICS;
+    EXPECT_TRUE(verdict::find_metric(name.c_str(), found)) << name;
+    EXPECT_EQ(found, metric);
+
+    if (info->function)
+    {
+      found = verdict::VERDICT_NUM_METRICS;
+      EXPECT_TRUE(verdict::find_metric(info->function, found)) << info->name;
+      EXPECT_EQ(found, metric);
+    }
+  }
+
+  const verdict::VerdictMetricInfo* info = verdict::metric_info(verdict::VERDICT_METRIC_HEX_SCALED_JACOBIAN);
+  EXPECT_EQ(info->function, verdict::hex_scaled_jacobian);
+  EXPECT_EQ(info->element, verdict::VERDICT_ELEMENT_HEX);
+  EXPECT_EQ(info->num_corners, 8);
+  info = verdict::metric_info(verdict::VERDICT_METRIC_TET_SHAPE_AND_SIZE);
+  EXPECT_EQ(info->sized_function, verdict::tet_shape_and_size);
+  EXPECT_EQ(verdict::metric_info(verdict::VERDICT_NUM_METRICS), nullptr);
+
+  verdict::VerdictMetric found;
+  EXPECT_FALSE(verdict::find_metric("hex_scaled", found));
+  EXPECT_FALSE(verdict::find_metric("hex_scaled_jacobians", found));
+  EXPECT_FALSE(verdict::find_metric(static_cast<const char*>(nullptr), found));
+  EXPECT_FALSE(verdict::find_metric(tet_or_hex_volume, found));
+
+  const verdict::MeshStatisticsRequest request =
+    verdict::metric_statistics_request(verdict::VERDICT_METRIC_QUAD_SKEW, 10, 5);
+  EXPECT_EQ(request.acceptable_min, 0.0);
+  EXPECT_EQ(request.acceptable_max, 0.5);
+  EXPECT_EQ(request.num_bins, 10);
+  EXPECT_EQ(request.num_worst, 5);
+  EXPECT_FALSE(request.smaller_is_worse);
+  EXPECT_TRUE(verdict::metric_statistics_request(verdict::VERDICT_METRIC_HEX_SHAPE, 10, 5).smaller_is_worse);
+}
+
+// the linear element of each VerdictElementType
+static const double reference_elements[8][8][3] =
+{
+  { {0, 0, 0}, {1, 0, 0} },
+  { {0, 0, 0}, {1, 0, 0}, {0.5, 0.866, 0} },
+  { {0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0} },
+  { {0, 0, 0}, {1, 0, 0}, {0.5, 0.866, 0}, {0.5, 0.289, 0.816} },
+  { {0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0}, {0.5, 0.5, 0.7} },
+  { {0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {0, 0, 1}, {1, 0, 1}, {0, 1, 1} },
+  { {0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0}, {0, 0, 1}, {0.5, 0.5, 1}, {1, 1, 1} },
+  { {0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0}, {0, 0, 1}, {1, 0, 1}, {1, 1, 1}, {0, 1, 1} }
+};
+
+static bool same_value(double a, double b)
+{
+  return a == b || (a != a && b != b);
+}
+
+TEST(verdict, metric_registry_mesh_quality)
+{
+  // more than two tiles of the structure-of-arrays loops
+  const int num_elements = 150;
+  const double average_size = 0.7;
+  for (int m = 0; m < verdict::VERDICT_NUM_METRICS; m++)
+  {
+    const verdict::VerdictMetric metric = static_cast<verdict::VerdictMetric>(m);
+    const verdict::VerdictMetricInfo* info = verdict::metric_info(metric);
+    const int num_nodes = info->num_corners;
+
+    // separate, perturbed copies of the reference element, numbered backwards
+    std::vector<double> points(3 * num_nodes * num_elements);
+    std::vector<verdict::VerdictIndex> conn(num_nodes * num_elements);
+    for (int e = 0; e < num_elements; e++)
+    {
+      const double amplitude = (e % 5 == 4) ? 1.5 : 0.2;
+      for (int n = 0; n < num_nodes; n++)
+      {
+        const int point = num_nodes * (num_elements - 1 - e) + n;
+        conn[e * num_nodes + n] = point;
+        for (int c = 0; c < 3; c++)
+          points[3 * point + c] = reference_elements[info->element][n][c] +
+            perturbation((e * num_nodes + n) * 3 + c, amplitude);
+      }
+    }
+
+    std::vector<double> expected(num_elements);
+    for (int e = 0; e < num_elements; e++)
+    {
+      double coordinates[8][3];
+      for (int n = 0; n < num_nodes; n++)
+        for (int c = 0; c < 3; c++)
+          coordinates[n][c] = points[3 * conn[e * num_nodes + n] + c];
+      expected[e] = info->function ? info->function(num_nodes, coordinates)
+                                   : info->sized_function(num_nodes, coordinates, average_size);
+    }
+
+    // the loops resolved from a function give its results bit for bit
+    std::vector<double> results(num_elements, -1.0);
+    if (info->function)
+    {
+      verdict::mesh_quality(info->function, num_elements, num_nodes, points.data(), conn.data(),
+                            results.data());
+      for (int e = 0; e < num_elements; e++)
+        EXPECT_TRUE(same_value(results[e], expected[e]))
+          << info->name << " element " << e << ": " << results[e] << " != " << expected[e];
+    }
+
+    verdict::mesh_quality(metric, num_elements, num_nodes, points.data(), conn.data(), average_size,
+                          results.data());
+    std::vector<double> parallel_results(num_elements, -1.0);
+    verdict::parallel_mesh_quality(metric, num_elements, num_nodes, points.data(), conn.data(),
+                                   average_size, parallel_results.data(), 0);
+    for (int e = 0; e < num_elements; e++)
+    {
+      if (expected[e] != expected[e])
+        EXPECT_TRUE(results[e] != results[e]) << info->name << " element " << e;
+      else
+        EXPECT_NEAR(results[e], expected[e], 1e-12 * fabs(expected[e]) + 1e-14)
+          << info->name << " element " << e;
+      EXPECT_TRUE(same_value(parallel_results[e], results[e])) << info->name << " element " << e;
+    }
+
+    // too few nodes for the element
+    verdict::mesh_quality(metric, num_elements, num_nodes - 1, points.data(), conn.data(), average_size,
+                          results.data());
+    for (int e = 0; e < num_elements; e++)
+      EXPECT_EQ(results[e], 0.0) << info->name;
+  }
+}
+
+TEST(verdict, metric_registry_node_counts)
+{
+  // the blocks of the metrics that depend on the element order run the
+  // templates of verdict_fixed.h, which match the functions bit for bit
+  const struct
+  {
+    verdict::VerdictMetric metric;
+    int num_nodes;
+  } blocks[] = {
+    { verdict::VERDICT_METRIC_TRI_DISTORTION, 6 }, { verdict::VERDICT_METRIC_QUAD_DISTORTION, 4 },
+    { verdict::VERDICT_METRIC_QUAD_DISTORTION, 8 }, { verdict::VERDICT_METRIC_TET_VOLUME, 10 },
+    { verdict::VERDICT_METRIC_TET_VOLUME, 15 }, { verdict::VERDICT_METRIC_TET_JACOBIAN, 15 },
+    { verdict::VERDICT_METRIC_TET_DISTORTION, 10 }, { verdict::VERDICT_METRIC_WEDGE_JACOBIAN, 21 },
+    { verdict::VERDICT_METRIC_KNIFE_VOLUME, 7 }, { verdict::VERDICT_METRIC_HEX_VOLUME, 20 },
+    { verdict::VERDICT_METRIC_HEX_VOLUME, 27 }, { verdict::VERDICT_METRIC_HEX_JACOBIAN, 27 },
+    { verdict::VERDICT_METRIC_HEX_DISTORTION, 8 }, { verdict::VERDICT_METRIC_HEX_DISTORTION, 20 },
+  };
+  const int num_elements = 40;
+  for (const auto& block : blocks)
+  {
+    const verdict::VerdictMetricInfo* info = verdict::metric_info(block.metric);
+    const int num_nodes = block.num_nodes;
+
+    // nodes on a perturbed 3x3x3 lattice, each element with its own points
+    std::vector<double> points(3 * num_nodes * num_elements);
+    std::vector<verdict::VerdictIndex> conn(num_nodes * num_elements);
+    for (int e = 0; e < num_elements; e++)
+      for (int n = 0; n < num_nodes; n++)
+      {
+        const int point = e * num_nodes + n;
+        conn[point] = point;
+        const int lattice[3] = { n % 3, (n / 3) % 3, n / 9 };
+        for (int c = 0; c < 3; c++)
+          points[3 * point + c] = 0.5 * lattice[c] + perturbation(3 * point + c, 0.1);
+      }
+
+    std::vector<double> expected(num_elements);
+    for (int e = 0; e < num_elements; e++)
+    {
+      double coordinates[27][3];
+      for (int n = 0; n < num_nodes; n++)
+        for (int c = 0; c < 3; c++)
+          coordinates[n][c] = points[3 * conn[e * num_nodes + n] + c];
+      expected[e] = info->function(num_nodes, coordinates);
+    }
+
+    std::vector<double> results(num_elements, -1.0);
+    verdict::mesh_quality(info->function, num_elements, num_nodes, points.data(), conn.data(),
+                          results.data());
+    for (int e = 0; e < num_elements; e++)
+      EXPECT_TRUE(same_value(results[e], expected[e])) << info->name << " " << num_nodes << " element " << e;
+
+    std::fill(results.begin(), results.end(), -1.0);
+    verdict::mesh_quality(block.metric, num_elements, num_nodes, points.data(), conn.data(), 1.0,
+                          results.data());
+    for (int e = 0; e < num_elements; e++)
+      EXPECT_TRUE(same_value(results[e], expected[e])) << info->name << " " << num_nodes << " element " << e;
+  }
+}
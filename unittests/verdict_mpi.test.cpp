@@ -0,0 +1,224 @@
+/*!
+ * \brief Unittests for the distributed-memory verdict interface
+ *
+ * Each rank holds a slab of a block of hexes with a layer of ghost
+ * elements on either side.  The distributed functions must give the
+ * statistics and averages of the serial functions over the whole block.
+ */
+
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <vector>
+#include <math.h>
+
+#include <verdict.h>
+#include <verdict_mesh.h>
+#include <verdict_mpi.h>
+
+static const int nx = 7, ny = 3, nz = 2;
+
+static verdict::VerdictIndex grid_point( int i, int j, int k )
+{
+  return ( k * ( ny + 1 ) + j ) * ( nx + 1 ) + i;
+}
+
+// a perturbed grid of nx*ny*nz hexes, numbered with i fastest
+struct HexBlock
+{
+  std::vector<double> points;
+  std::vector<verdict::VerdictIndex> connectivity;
+
+  HexBlock()
+  {
+    for ( int k = 0; k <= nz; k++ )
+      for ( int j = 0; j <= ny; j++ )
+        for ( int i = 0; i <= nx; i++ )
+        {
+          const double c = i + 3 * j + 5 * k;
+          points.push_back( i + 0.2 * sin( 1.3 * c ) );
+          points.push_back( j + 0.2 * sin( 2.1 * c ) );
+          points.push_back( k + 0.2 * sin( 0.7 * c ) );
+        }
+    for ( int k = 0; k < nz; k++ )
+      for ( int j = 0; j < ny; j++ )
+        for ( int i = 0; i < nx; i++ )
+        {
+          const verdict::VerdictIndex nodes[8] = {
+            grid_point( i, j, k ), grid_point( i + 1, j, k ),
+            grid_point( i + 1, j + 1, k ), grid_point( i, j + 1, k ),
+            grid_point( i, j, k + 1 ), grid_point( i + 1, j, k + 1 ),
+            grid_point( i + 1, j + 1, k + 1 ), grid_point( i, j + 1, k + 1 ) };
+          connectivity.insert( connectivity.end(), nodes, nodes + 8 );
+        }
+  }
+
+  verdict::VerdictIndex num_elements() const { return connectivity.size() / 8; }
+};
+
+// the elements of a rank: its slab of columns i, then the ghost columns next to it
+struct RankPart
+{
+  std::vector<verdict::VerdictIndex> connectivity;
+  std::vector<unsigned char> owned;
+  std::vector<verdict::VerdictIndex> global_ids;
+
+  RankPart( const HexBlock &block, MPI_Comm comm )
+  {
+    int rank, size;
+    MPI_Comm_rank( comm, &rank );
+    MPI_Comm_size( comm, &size );
+    const int first = rank * nx / size, last = ( rank + 1 ) * nx / size;
+    for ( int pass = 0; pass < 2; pass++ )
+      for ( verdict::VerdictIndex e = 0; e < block.num_elements(); e++ )
+      {
+        const int i = e % nx;
+        const bool mine = first <= i && i < last;
+        const bool ghost = !mine && ( i == first - 1 || i == last );
+        if ( pass == 0 ? !mine : !ghost )
+          continue;
+        connectivity.insert( connectivity.end(), block.connectivity.begin() + 8 * e,
+                             block.connectivity.begin() + 8 * e + 8 );
+        owned.push_back( mine );
+        global_ids.push_back( e );
+      }
+  }
+
+  verdict::VerdictIndex num_elements() const { return owned.size(); }
+};
+
+static verdict::MeshStatisticsRequest scaled_jacobian_request()
+{
+  verdict::MeshStatisticsRequest request = { 0.5, 1.0, 5, 4, true };
+  return request;
+}
+
+static void expect_same_statistics( const verdict::MeshStatistics &serial,
+                                    const verdict::MeshStatistics &distributed, int num_bins )
+{
+  EXPECT_EQ( serial.count, distributed.count );
+  EXPECT_EQ( serial.minimum, distributed.minimum );
+  EXPECT_EQ( serial.maximum, distributed.maximum );
+  EXPECT_NEAR( serial.mean, distributed.mean, 1e-13 );
+  EXPECT_NEAR( serial.standard_deviation, distributed.standard_deviation, 1e-13 );
+  EXPECT_EQ( serial.below_acceptable, distributed.below_acceptable );
+  EXPECT_EQ( serial.above_acceptable, distributed.above_acceptable );
+  for ( int b = 0; b < num_bins; b++ )
+    EXPECT_EQ( serial.histogram[b], distributed.histogram[b] );
+  EXPECT_EQ( serial.num_worst, distributed.num_worst );
+  for ( int w = 0; w < serial.num_worst && w < distributed.num_worst; w++ )
+  {
+    EXPECT_EQ( serial.worst_elements[w], distributed.worst_elements[w] );
+    EXPECT_EQ( serial.worst_values[w], distributed.worst_values[w] );
+  }
+}
+
+TEST(verdict_mpi, mesh_statistics)
+{
+  const HexBlock block;
+  const RankPart part( block, MPI_COMM_WORLD );
+  const verdict::MeshStatisticsRequest request = scaled_jacobian_request();
+
+  verdict::MeshStatistics serial;
+  verdict::mesh_statistics( verdict::hex_scaled_jacobian, block.num_elements(), 8,
+                            block.points.data(), block.connectivity.data(), request, serial, 1 );
+
+  verdict::MeshStatistics distributed;
+  std::vector<double> results( part.num_elements() );
+  verdict::mpi_mesh_statistics( MPI_COMM_WORLD, verdict::hex_scaled_jacobian, part.num_elements(), 8,
+                                block.points.data(), part.connectivity.data(), part.owned.data(),
+                                part.global_ids.data(), request, results.data(), distributed, 2 );
+  expect_same_statistics( serial, distributed, request.num_bins );
+
+  // the ghosts are evaluated too
+  for ( verdict::VerdictIndex e = 0; e < part.num_elements(); e++ )
+  {
+    double coordinates[8][3];
+    for ( int n = 0; n < 8; n++ )
+      for ( int d = 0; d < 3; d++ )
+        coordinates[n][d] = block.points[3 * part.connectivity[8 * e + n] + d];
+    EXPECT_EQ( verdict::hex_scaled_jacobian( 8, coordinates ), results[e] );
+  }
+
+  std::vector<verdict::VerdictIndex> offsets( part.num_elements() + 1 );
+  for ( size_t e = 0; e < offsets.size(); e++ )
+    offsets[e] = 8 * e;
+  verdict::mpi_mesh_statistics( MPI_COMM_WORLD, verdict::hex_scaled_jacobian, part.num_elements(),
+                                block.points.data(), part.connectivity.data(), offsets.data(),
+                                part.owned.data(), part.global_ids.data(), request, nullptr,
+                                distributed, 1 );
+  expect_same_statistics( serial, distributed, request.num_bins );
+}
+
+TEST(verdict_mpi, reduce_statistics)
+{
+  const HexBlock block;
+  const RankPart part( block, MPI_COMM_WORLD );
+  verdict::MeshStatisticsRequest request = scaled_jacobian_request();
+  request.num_worst = 0;
+
+  verdict::MeshStatistics serial;
+  verdict::mesh_statistics( verdict::hex_scaled_jacobian, block.num_elements(), 8,
+                            block.points.data(), block.connectivity.data(), request, serial, 1 );
+
+  // the owned elements only, as a rank streaming its own elements would see them
+  std::vector<verdict::VerdictIndex> owned_connectivity;
+  for ( verdict::VerdictIndex e = 0; e < part.num_elements(); e++ )
+    if ( part.owned[e] )
+      owned_connectivity.insert( owned_connectivity.end(), part.connectivity.begin() + 8 * e,
+                                 part.connectivity.begin() + 8 * e + 8 );
+  verdict::MeshStatistics distributed;
+  verdict::mesh_statistics( verdict::hex_scaled_jacobian, owned_connectivity.size() / 8, 8,
+                            block.points.data(), owned_connectivity.data(), request, distributed, 1 );
+  verdict::mpi_reduce_statistics( MPI_COMM_WORLD, request, distributed );
+  expect_same_statistics( serial, distributed, request.num_bins );
+}
+
+TEST(verdict_mpi, mesh_size_quality)
+{
+  const HexBlock block;
+  const RankPart part( block, MPI_COMM_WORLD );
+
+  std::vector<double> serial( block.num_elements() );
+  const double average = verdict::mesh_size_quality( verdict::VERDICT_SIZE_HEX, verdict::VERDICT_SHAPE_AND_SIZE,
+                                                     block.num_elements(), 8, block.points.data(),
+                                                     block.connectivity.data(), serial.data(), 1 );
+
+  std::vector<double> results( part.num_elements() );
+  const double distributed = verdict::mpi_mesh_size_quality(
+    MPI_COMM_WORLD, verdict::VERDICT_SIZE_HEX, verdict::VERDICT_SHAPE_AND_SIZE, part.num_elements(), 8,
+    block.points.data(), part.connectivity.data(), part.owned.data(), results.data(), 2 );
+  EXPECT_NEAR( average, distributed, 1e-14 * average );
+  for ( verdict::VerdictIndex e = 0; e < part.num_elements(); e++ )
+    EXPECT_NEAR( serial[part.global_ids[e]], results[e], 1e-13 );
+
+  // the statistics of the results in a second collective
+  verdict::MeshStatisticsRequest request = { 0.2, 1.0, 4, 3, true };
+  verdict::MeshStatistics statistics;
+  verdict::mpi_mesh_size_quality( MPI_COMM_WORLD, verdict::VERDICT_SIZE_HEX, verdict::VERDICT_SHAPE_AND_SIZE,
+                                  part.num_elements(), 8, block.points.data(), part.connectivity.data(),
+                                  part.owned.data(), part.global_ids.data(), request, results.data(),
+                                  statistics, 1 );
+  EXPECT_EQ( block.num_elements(), statistics.count );
+  double minimum = serial[0], maximum = serial[0], sum = 0;
+  for ( double value : serial )
+  {
+    minimum = std::min( minimum, value );
+    maximum = std::max( maximum, value );
+    sum += value;
+  }
+  EXPECT_NEAR( minimum, statistics.minimum, 1e-13 );
+  EXPECT_NEAR( maximum, statistics.maximum, 1e-13 );
+  EXPECT_NEAR( sum / serial.size(), statistics.mean, 1e-13 );
+  ASSERT_EQ( 3, statistics.num_worst );
+  EXPECT_NEAR( serial[statistics.worst_elements[0]], statistics.worst_values[0], 1e-13 );
+  EXPECT_NEAR( minimum, serial[statistics.worst_elements[0]], 1e-13 );
+}
+
+int main( int argc, char** argv )
+{
+  MPI_Init( &argc, &argv );
+  ::testing::InitGoogleTest( &argc, argv );
+  const int status = RUN_ALL_TESTS();
+  MPI_Finalize();
+  return status;
+}
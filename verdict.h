@@ -202,6 +202,34 @@ namespace VERDICT_NAMESPACE
        Intl. J. Numer. Meth. Engng. 2000, 48:1165-1185. */ 
     VERDICT_EXPORT double hex_scaled_jacobian( int num_nodes, double coordinates[][3] );
 
+    //! Whether the hex jacobian metric is at least a threshold
+    /** Same as hex_jacobian( num_nodes, coordinates ) >= threshold, but
+       returns false at the first sampling point below the threshold. */
+    VERDICT_EXPORT bool hex_jacobian_at_least( int num_nodes, double coordinates[][3], double threshold );
+
+    //! Whether the hex scaled jacobian metric is at least a threshold
+    /** Same as hex_scaled_jacobian( num_nodes, coordinates ) >= threshold, but
+       returns false at the first corner below the threshold. */
+    VERDICT_EXPORT bool hex_scaled_jacobian_at_least( int num_nodes, double coordinates[][3], double threshold );
+
+    //! A cheap estimate of a metric, with bounds on its exact value.
+    /** The metric function returns a value in [lower, upper], its rounding
+        included.  The fields are NaN when a coordinate is not finite. */
+    struct MetricEstimate
+    {
+      double value;
+      double lower;
+      double upper;
+    };
+
+    //! Estimates the hex jacobian metric.
+    /** For 27 nodes, the smallest jacobian at the nodes of the trilinear hex
+       of the corners, bounded by how far the other nodes are from it; the
+       bounds are tight for hexes with nearly straight edges and the
+       estimate takes about half the time of hex_jacobian.  The
+       estimates of other node counts are exact. */
+    VERDICT_EXPORT void hex_jacobian_estimate( int num_nodes, double coordinates[][3], MetricEstimate &estimate );
+
     //! Return min(Jacobian) / max(Jacobian) over all nodes
     /** Turn the Jacobian determinates into a normalized quality ratio. Detects element skewness.
         If the maximum nodal jacobian is negative the element is fully inverted, and return a huge 
@@ -248,6 +276,43 @@ namespace VERDICT_NAMESPACE
 
     VERDICT_EXPORT double hex_equiangle_skew( int num_nodes, double coordinates[][3] );
 
+    //! Flags selecting the metrics calculated by \ref hex_quality.
+    enum HexQualityFlags
+    {
+      HEX_JACOBIAN        = 1 << 0,
+      HEX_SCALED_JACOBIAN = 1 << 1,
+      HEX_SHAPE           = 1 << 2,
+      HEX_SHEAR           = 1 << 3,
+      HEX_ODDY            = 1 << 4,
+      HEX_CONDITION       = 1 << 5,
+      HEX_SKEW            = 1 << 6,
+      HEX_TAPER           = 1 << 7,
+      HEX_ALL_METRICS     = ( 1 << 8 ) - 1
+    };
+
+    //! Metric values written by \ref hex_quality.
+    /** Each field holds the value the corresponding single metric function
+        (hex_jacobian, hex_scaled_jacobian, ...) would return.  Fields of
+        metrics that were not requested are left unchanged. */
+    struct HexQuality
+    {
+      double jacobian;
+      double scaled_jacobian;
+      double shape;
+      double shear;
+      double oddy;
+      double condition;
+      double skew;
+      double taper;
+    };
+
+    //! Calculates several hex metrics in one pass.
+    /** metrics is a bitwise or of HexQualityFlags.  The selected metrics share
+        the nodal positions, the principal axes and the eight corner Jacobians
+        instead of each recomputing them. */
+    VERDICT_EXPORT void hex_quality( int num_nodes, double coordinates[][3],
+                                     unsigned int metrics, HexQuality &quality );
+
     VERDICT_EXPORT double tet_inradius( int num_nodes, double coordinates[][3] );
     
     //! Calculates hex timestep metric
@@ -321,6 +386,12 @@ namespace VERDICT_NAMESPACE
        Intl. J. Numer. Meth. Engng. 2000, 48:1165-1185. */
     VERDICT_EXPORT double tet_jacobian( int num_nodes, double coordinates[][3] );
 
+    //! Estimates the tet jacobian metric.
+    /** For 15 nodes, the jacobian of the linear tet of the corners, bounded
+       by how far the other nodes are from it.  The estimates of other node
+       counts are exact.  See hex_jacobian_estimate. */
+    VERDICT_EXPORT void tet_jacobian_estimate( int num_nodes, double coordinates[][3], MetricEstimate &estimate );
+
     //! Calculates tet scaled jacobian. 
     /** Minimum Jacobian divided by the lengths of 3 edge vectors 
        Reference --- P. Knupp, Achieving Finite Element Mesh Quality via 
@@ -370,6 +441,42 @@ namespace VERDICT_NAMESPACE
 
     //! Calculates tet equiangle skew metric.
     VERDICT_EXPORT double tet_equiangle_skew( int num_nodes, double coordinates[][3] );
+
+    //! Flags selecting the metrics calculated by \ref tet_quality.
+    enum TetQualityFlags
+    {
+      TET_VOLUME          = 1 << 0,
+      TET_JACOBIAN        = 1 << 1,
+      TET_SCALED_JACOBIAN = 1 << 2,
+      TET_SHAPE           = 1 << 3,
+      TET_MEAN_RATIO      = 1 << 4,
+      TET_CONDITION       = 1 << 5,
+      TET_EDGE_RATIO      = 1 << 6,
+      TET_ASPECT_RATIO    = 1 << 7,
+      TET_ALL_METRICS     = ( 1 << 8 ) - 1
+    };
+
+    //! Metric values written by \ref tet_quality.
+    /** Each field holds the value the corresponding single metric function
+        (tet_volume, tet_jacobian, ...) would return.  Fields of metrics that
+        were not requested are left unchanged. */
+    struct TetQuality
+    {
+      double volume;
+      double jacobian;
+      double scaled_jacobian;
+      double shape;
+      double mean_ratio;
+      double condition;
+      double edge_ratio;
+      double aspect_ratio;
+    };
+
+    //! Calculates several tet metrics in one pass.
+    /** metrics is a bitwise or of TetQualityFlags.  The selected metrics share
+        the six edge vectors, their squared lengths and the corner Jacobian. */
+    VERDICT_EXPORT void tet_quality( int num_nodes, double coordinates[][3],
+                                     unsigned int metrics, TetQuality &quality );
     
 /* quality functions for pyramid elements */ 
 
@@ -390,6 +497,36 @@ namespace VERDICT_NAMESPACE
     //! Calculates the pyramid equiangle skew metric.
     VERDICT_EXPORT double pyramid_equiangle_skew( int num_nodes, double coordinates[][3] );
 
+    //! Flags selecting the metrics calculated by \ref pyramid_quality.
+    enum PyramidQualityFlags
+    {
+      PYRAMID_VOLUME          = 1 << 0,
+      PYRAMID_JACOBIAN        = 1 << 1,
+      PYRAMID_SCALED_JACOBIAN = 1 << 2,
+      PYRAMID_SHAPE           = 1 << 3,
+      PYRAMID_EQUIANGLE_SKEW  = 1 << 4,
+      PYRAMID_ALL_METRICS     = ( 1 << 5 ) - 1
+    };
+
+    //! Metric values written by \ref pyramid_quality.
+    /** Each field holds the value the corresponding single metric function
+        (pyramid_volume, pyramid_jacobian, ...) would return.  Fields of
+        metrics that were not requested are left unchanged. */
+    struct PyramidQuality
+    {
+      double volume;
+      double jacobian;
+      double scaled_jacobian;
+      double shape;
+      double equiangle_skew;
+    };
+
+    //! Calculates several pyramid metrics in one pass.
+    /** metrics is a bitwise or of PyramidQualityFlags.  The selected metrics
+        share the four corner tets and the five faces. */
+    VERDICT_EXPORT void pyramid_quality( int num_nodes, double coordinates[][3],
+                                         unsigned int metrics, PyramidQuality &quality );
+
 
 /* quality functions for wedge elements */
 
@@ -416,6 +553,13 @@ namespace VERDICT_NAMESPACE
        Reference --- Adaptation of Tet jacobian metric. */
     VERDICT_EXPORT double wedge_jacobian( int num_nodes, double coordinates[][3]);
 
+    //! Estimates the wedge jacobian metric.
+    /** For 21 nodes, the smallest jacobian at the edge nodes of the linear
+       wedge of the corners, bounded by how far the other nodes are from
+       it.  The estimates of other node counts are exact.  See
+       hex_jacobian_estimate. */
+    VERDICT_EXPORT void wedge_jacobian_estimate( int num_nodes, double coordinates[][3], MetricEstimate &estimate );
+
     //! Calculates wedge distortion metric.
     /** {min(|J|)/actual volume}*parent volume.
        Reference --- Adaptation of Hex distortion metric. */
@@ -444,6 +588,49 @@ namespace VERDICT_NAMESPACE
     //! Calculates wedge equiangle skew metric
     VERDICT_EXPORT double wedge_equiangle_skew( int num_nodes, double coordinates[][3] );
 
+    //! Flags selecting the metrics calculated by \ref wedge_quality.
+    enum WedgeQualityFlags
+    {
+      WEDGE_VOLUME                = 1 << 0,
+      WEDGE_EDGE_RATIO            = 1 << 1,
+      WEDGE_MAX_ASPECT_FROBENIUS  = 1 << 2,
+      WEDGE_MEAN_ASPECT_FROBENIUS = 1 << 3,
+      WEDGE_JACOBIAN              = 1 << 4,
+      WEDGE_DISTORTION            = 1 << 5,
+      WEDGE_MAX_STRETCH           = 1 << 6,
+      WEDGE_SCALED_JACOBIAN       = 1 << 7,
+      WEDGE_SHAPE                 = 1 << 8,
+      WEDGE_CONDITION             = 1 << 9,
+      WEDGE_EQUIANGLE_SKEW        = 1 << 10,
+      WEDGE_ALL_METRICS           = ( 1 << 11 ) - 1
+    };
+
+    //! Metric values written by \ref wedge_quality.
+    /** Each field holds the value the corresponding single metric function
+        (wedge_volume, wedge_edge_ratio, ...) would return.  Fields of metrics
+        that were not requested are left unchanged. */
+    struct WedgeQuality
+    {
+      double volume;
+      double edge_ratio;
+      double max_aspect_frobenius;
+      double mean_aspect_frobenius;
+      double jacobian;
+      double distortion;
+      double max_stretch;
+      double scaled_jacobian;
+      double shape;
+      double condition;
+      double equiangle_skew;
+    };
+
+    //! Calculates several wedge metrics in one pass.
+    /** metrics is a bitwise or of WedgeQualityFlags.  The selected metrics
+        share the edge vectors and Jacobians at the six corners, the six
+        corner tet aspects and the volume. */
+    VERDICT_EXPORT void wedge_quality( int num_nodes, double coordinates[][3],
+                                       unsigned int metrics, WedgeQuality &quality );
+
 
 /* quality functions for knife elements */
 
@@ -681,6 +868,29 @@ namespace VERDICT_NAMESPACE
     /* Currently supports tri 6 and 3.*/
     VERDICT_EXPORT double tri_normalized_inradius(int num_nodes, double coordinates[][3] );
 
+  //! One counter of the optional instrumentation.
+  /** Metric counters count the calls of a function and the ticks spent in
+      it, including the functions it calls.  Ticks are CPU cycles on x86
+      and nanoseconds elsewhere.  Event counters only count how often a
+      degenerate or clamping branch was taken. */
+  struct VerdictCounter
+  {
+    const char* name;
+    bool is_metric;
+    unsigned long long count;
+    unsigned long long ticks;
+  };
+
+    //! Whether verdict was configured with VERDICT_ENABLE_INSTRUMENTATION.
+    VERDICT_EXPORT bool instrumentation_enabled();
+
+    //! Copies up to max_counters counters and returns how many there are.
+    /** A counter exists once its function or branch has run. */
+    VERDICT_EXPORT int instrumentation_counters( VerdictCounter* counters, int max_counters );
+
+    //! Sets all counters back to zero.
+    VERDICT_EXPORT void reset_instrumentation();
+
 } // namespace verdict
 
 #endif  /* __verdict_h */
@@ -0,0 +1,172 @@
+/*=========================================================================
+
+  Module:    verdict_fixed.h
+
+  Copyright 2003,2006,2019 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+  Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government retains certain rights in this software.
+
+  See LICENSE for details.
+
+=========================================================================*/
+
+/*! \file verdict_fixed.h
+  \brief The metrics that depend on the element order, at a node count fixed at compile time.
+ *
+ * verdict_fixed.h declares the single element functions of verdict.h that
+ *           treat linear and higher order elements differently as
+ *           templates on the number of nodes, e.g. fixed::tet_volume<10>.
+ *           The element order is resolved when compiling, so the calls
+ *           take no branch on the node count, the loops over the nodes
+ *           have a fixed length and the nodes are held in arrays of the
+ *           exact size.  The functions of verdict.h forward to them.
+ *
+ * Each function returns what the function of the same name in verdict.h
+ *           returns for that node count.  Node counts the function does
+ *           not distinguish fail to compile.  The metrics that only read
+ *           the corners, whatever the node count, have no template here,
+ *           but for hex_scaled_jacobian<8>, the most used of them.
+ *
+ * This file is part of VERDICT
+ *
+ */
+
+#ifndef __verdict_fixed_h
+#define __verdict_fixed_h
+
+#include "verdict.h"
+
+namespace VERDICT_NAMESPACE
+{
+namespace fixed
+{
+  //! false, for the static assertions of the node counts that have no specialization
+  template <int NumNodes>
+  struct unsupported_node_count
+  {
+    static const bool value = false;
+  };
+
+/* hexes */
+
+    //! Calculates hex volume; NumNodes is 8, 20 or 27.
+    template <int NumNodes>
+    double hex_volume( double /*coordinates*/[][3] )
+    {
+      static_assert( unsupported_node_count<NumNodes>::value, "hex_volume takes 8, 20 or 27 nodes" );
+      return 0.0;
+    }
+    template <> VERDICT_EXPORT double hex_volume<8>( double coordinates[][3] );
+    template <> VERDICT_EXPORT double hex_volume<20>( double coordinates[][3] );
+    template <> VERDICT_EXPORT double hex_volume<27>( double coordinates[][3] );
+
+    //! Calculates hex jacobian; NumNodes is 8 or 27.
+    template <int NumNodes>
+    double hex_jacobian( double /*coordinates*/[][3] )
+    {
+      static_assert( unsupported_node_count<NumNodes>::value, "hex_jacobian takes 8 or 27 nodes" );
+      return 0.0;
+    }
+    template <> VERDICT_EXPORT double hex_jacobian<8>( double coordinates[][3] );
+    template <> VERDICT_EXPORT double hex_jacobian<27>( double coordinates[][3] );
+
+    //! Calculates hex scaled jacobian; NumNodes is 8, the corners of any hex.
+    template <int NumNodes>
+    double hex_scaled_jacobian( double /*coordinates*/[][3] )
+    {
+      static_assert( unsupported_node_count<NumNodes>::value, "hex_scaled_jacobian takes the 8 corners" );
+      return 0.0;
+    }
+    template <> VERDICT_EXPORT double hex_scaled_jacobian<8>( double coordinates[][3] );
+
+    //! Calculates hex distortion; NumNodes is 8 or 20.
+    template <int NumNodes>
+    double hex_distortion( double /*coordinates*/[][3] )
+    {
+      static_assert( unsupported_node_count<NumNodes>::value, "hex_distortion takes 8 or 20 nodes" );
+      return 0.0;
+    }
+    template <> VERDICT_EXPORT double hex_distortion<8>( double coordinates[][3] );
+    template <> VERDICT_EXPORT double hex_distortion<20>( double coordinates[][3] );
+
+/* tets */
+
+    //! Calculates tet volume; NumNodes is 4, 8, 10, 14 or 15.
+    template <int NumNodes>
+    double tet_volume( double /*coordinates*/[][3] )
+    {
+      static_assert( unsupported_node_count<NumNodes>::value, "tet_volume takes 4, 8, 10, 14 or 15 nodes" );
+      return 0.0;
+    }
+    template <> VERDICT_EXPORT double tet_volume<4>( double coordinates[][3] );
+    template <> VERDICT_EXPORT double tet_volume<8>( double coordinates[][3] );
+    template <> VERDICT_EXPORT double tet_volume<10>( double coordinates[][3] );
+    template <> VERDICT_EXPORT double tet_volume<14>( double coordinates[][3] );
+    template <> VERDICT_EXPORT double tet_volume<15>( double coordinates[][3] );
+
+    //! Calculates tet jacobian; NumNodes is 4 or 15.
+    template <int NumNodes>
+    double tet_jacobian( double /*coordinates*/[][3] )
+    {
+      static_assert( unsupported_node_count<NumNodes>::value, "tet_jacobian takes 4 or 15 nodes" );
+      return 0.0;
+    }
+    template <> VERDICT_EXPORT double tet_jacobian<4>( double coordinates[][3] );
+    template <> VERDICT_EXPORT double tet_jacobian<15>( double coordinates[][3] );
+
+    //! Calculates tet distortion; NumNodes is 4 or 10.
+    template <int NumNodes>
+    double tet_distortion( double /*coordinates*/[][3] )
+    {
+      static_assert( unsupported_node_count<NumNodes>::value, "tet_distortion takes 4 or 10 nodes" );
+      return 0.0;
+    }
+    template <> VERDICT_EXPORT double tet_distortion<4>( double coordinates[][3] );
+    template <> VERDICT_EXPORT double tet_distortion<10>( double coordinates[][3] );
+
+/* wedges and knives */
+
+    //! Calculates wedge jacobian; NumNodes is 6 or 21.
+    template <int NumNodes>
+    double wedge_jacobian( double /*coordinates*/[][3] )
+    {
+      static_assert( unsupported_node_count<NumNodes>::value, "wedge_jacobian takes 6 or 21 nodes" );
+      return 0.0;
+    }
+    template <> VERDICT_EXPORT double wedge_jacobian<6>( double coordinates[][3] );
+    template <> VERDICT_EXPORT double wedge_jacobian<21>( double coordinates[][3] );
+
+    //! Calculates knife volume; NumNodes is 7.
+    template <int NumNodes>
+    double knife_volume( double /*coordinates*/[][3] )
+    {
+      static_assert( unsupported_node_count<NumNodes>::value, "knife_volume takes 7 nodes" );
+      return 0.0;
+    }
+    template <> VERDICT_EXPORT double knife_volume<7>( double coordinates[][3] );
+
+/* quads and tris */
+
+    //! Calculates quad distortion; NumNodes is 4 or 8.
+    template <int NumNodes>
+    double quad_distortion( double /*coordinates*/[][3] )
+    {
+      static_assert( unsupported_node_count<NumNodes>::value, "quad_distortion takes 4 or 8 nodes" );
+      return 0.0;
+    }
+    template <> VERDICT_EXPORT double quad_distortion<4>( double coordinates[][3] );
+    template <> VERDICT_EXPORT double quad_distortion<8>( double coordinates[][3] );
+
+    //! Calculates tri distortion; NumNodes is 3 or 6.
+    template <int NumNodes>
+    double tri_distortion( double /*coordinates*/[][3] )
+    {
+      static_assert( unsupported_node_count<NumNodes>::value, "tri_distortion takes 3 or 6 nodes" );
+      return 0.0;
+    }
+    template <> VERDICT_EXPORT double tri_distortion<3>( double coordinates[][3] );
+    template <> VERDICT_EXPORT double tri_distortion<6>( double coordinates[][3] );
+
+} // namespace fixed
+} // namespace verdict
+
+#endif
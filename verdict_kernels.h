@@ -0,0 +1,964 @@
+/*=========================================================================
+
+  Module:    verdict_kernels.h
+
+  Copyright 2003,2006,2019 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+  Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government retains certain rights in this software.
+
+  See LICENSE for details.
+
+=========================================================================*/
+
+/*! \file verdict_kernels.h
+  \brief Header-only templates of the core tet, hex, tri and quad metrics.
+ *
+ * verdict_kernels.h contains inline versions of the most used metrics of
+ *           linear elements, templated on the scalar type, which can be
+ *           called from CUDA, HIP or Kokkos device code and inlined into
+ *           vectorized loops.  None of them allocate, use VerdictVector or
+ *           depend on file scope constants.
+ *
+ * Every kernel performs the same floating point operations, in the same
+ * order, as the function of the same name in verdict.h, so the double
+ * instantiation returns the same value on the same compiler settings.
+ * The kernels without square roots or powers are constexpr under C++14.
+ *
+ * The second template parameter R is the type the kernel computes and
+ * returns in; it defaults to the coordinate type T.  kernel<float> halves
+ * the coordinate bandwidth and doubles the SIMD width of a vectorized
+ * loop, at single precision.  kernel<float, double> reads float
+ * coordinates but forms the edge vectors, and so the determinants of
+ * nearly flat elements, in double.
+ *
+ * Besides coordinates[][3] arrays, every kernel takes any node accessor
+ * for which coordinates[i][c] is component c of node i.  StridedNodes and
+ * SoaNodes read the nodes of an element in place, through its
+ * connectivity, from a strided x,y,z point array (VTK) or from separate
+ * x, y and z arrays; mesh_quality applies a kernel to every element of a
+ * mesh without gathering any coordinates.
+ *
+ * Define VERDICT_HOST_DEVICE before including this file to use another
+ * annotation (e.g. KOKKOS_INLINE_FUNCTION without the inline).
+ *
+ * This file is part of VERDICT
+ *
+ */
+
+#ifndef __verdict_kernels_h
+#define __verdict_kernels_h
+
+#include "verdict.h"
+#include "verdict_mesh.h"
+#include <cmath>
+
+#ifndef VERDICT_HOST_DEVICE
+# if defined(__CUDACC__) || defined(__HIPCC__)
+#  define VERDICT_HOST_DEVICE __host__ __device__
+# else
+#  define VERDICT_HOST_DEVICE
+# endif
+#endif
+
+// constexpr for the kernels with loops and local variables, which needs C++14
+#if __cplusplus >= 201402L || ( defined(_MSVC_LANG) && _MSVC_LANG >= 201402L )
+# define VERDICT_CONSTEXPR constexpr
+#else
+# define VERDICT_CONSTEXPR inline
+#endif
+
+namespace VERDICT_NAMESPACE
+{
+namespace kernels
+{
+
+  //! VERDICT_DBL_MAX as a constant expression of type T
+  template <typename T>
+  VERDICT_HOST_DEVICE constexpr T dbl_max() { return T( 1.0E+30 ); }
+
+  //! VERDICT_DBL_MIN as a constant expression of type T
+  template <typename T>
+  VERDICT_HOST_DEVICE constexpr T dbl_min() { return T( 1.0E-30 ); }
+
+  //! A 3-vector of T; the same operation order as VerdictVector.
+  template <typename T>
+  struct Vector3
+  {
+    T x, y, z;
+  };
+
+/* node accessors */
+
+  //! The nodes of a coordinates[][3] array; what the kernels taking arrays use.
+  template <typename T>
+  struct ArrayNodes
+  {
+    const T (*coordinates)[3];
+
+    VERDICT_HOST_DEVICE constexpr const T* operator[]( int node ) const { return coordinates[node]; }
+  };
+
+  //! The nodes of an element, read in place from a strided x,y,z point array.
+  /** Node i of the element is point p = connectivity[i] - base, whose
+      coordinates are points[p*stride], points[p*stride+1] and points[p*stride+2].
+      stride is 3 for packed triples and larger for point arrays with more
+      components or interleaved fields; base is 1 for Exodus style
+      connectivity.  I is the type of the connectivity entries. */
+  template <typename T, typename I = VerdictIndex>
+  struct StridedNodes
+  {
+    const T* points;
+    VerdictIndex stride;
+    const I* connectivity;
+    I base;
+
+    VERDICT_HOST_DEVICE constexpr const T* operator[]( int node ) const
+    {
+      return points + stride * VerdictIndex( connectivity[node] - base );
+    }
+
+    //! the nodes of the element whose connectivity starts at offset
+    VERDICT_HOST_DEVICE constexpr StridedNodes element( VerdictIndex offset ) const
+    {
+      return StridedNodes{ points, stride, connectivity + offset, base };
+    }
+  };
+
+  //! The nodes of an element, read in place from separate x, y and z arrays.
+  /** Node i of the element is point p = connectivity[i] - base, whose
+      coordinates are x[p], y[p] and z[p]. */
+  template <typename T, typename I = VerdictIndex>
+  struct SoaNodes
+  {
+    const T* x;
+    const T* y;
+    const T* z;
+    const I* connectivity;
+    I base;
+
+    //! one node; component 0, 1 or 2 is its x, y or z
+    struct Node
+    {
+      const T* x;
+      const T* y;
+      const T* z;
+      VerdictIndex point;
+
+      VERDICT_HOST_DEVICE constexpr T operator[]( int component ) const
+      {
+        return component == 0 ? x[point] : component == 1 ? y[point] : z[point];
+      }
+    };
+
+    VERDICT_HOST_DEVICE constexpr Node operator[]( int node ) const
+    {
+      return Node{ x, y, z, VerdictIndex( connectivity[node] - base ) };
+    }
+
+    //! the nodes of the element whose connectivity starts at offset
+    VERDICT_HOST_DEVICE constexpr SoaNodes element( VerdictIndex offset ) const
+    {
+      return SoaNodes{ x, y, z, connectivity + offset, base };
+    }
+  };
+
+  //! the vector from node "from" to node "to", in the compute type R
+  template <typename R, class Nodes>
+  VERDICT_HOST_DEVICE constexpr Vector3<R> edge( const Nodes &coordinates, int from, int to )
+  {
+    return Vector3<R>{ R( coordinates[to][0] ) - R( coordinates[from][0] ),
+                       R( coordinates[to][1] ) - R( coordinates[from][1] ),
+                       R( coordinates[to][2] ) - R( coordinates[from][2] ) };
+  }
+
+  template <typename T>
+  VERDICT_HOST_DEVICE constexpr Vector3<T> operator+( const Vector3<T> &a, const Vector3<T> &b )
+  {
+    return Vector3<T>{ a.x + b.x, a.y + b.y, a.z + b.z };
+  }
+
+  template <typename T>
+  VERDICT_HOST_DEVICE constexpr Vector3<T> operator-( const Vector3<T> &a, const Vector3<T> &b )
+  {
+    return Vector3<T>{ a.x - b.x, a.y - b.y, a.z - b.z };
+  }
+
+  template <typename T>
+  VERDICT_HOST_DEVICE constexpr Vector3<T> operator-( const Vector3<T> &a )
+  {
+    return Vector3<T>{ -a.x, -a.y, -a.z };
+  }
+
+  template <typename T>
+  VERDICT_HOST_DEVICE constexpr Vector3<T> operator*( T s, const Vector3<T> &a )
+  {
+    return Vector3<T>{ a.x * s, a.y * s, a.z * s };
+  }
+
+  template <typename T>
+  VERDICT_HOST_DEVICE constexpr Vector3<T> operator/( const Vector3<T> &a, T s )
+  {
+    return Vector3<T>{ a.x / s, a.y / s, a.z / s };
+  }
+
+  template <typename T>
+  VERDICT_HOST_DEVICE constexpr Vector3<T> cross( const Vector3<T> &a, const Vector3<T> &b )
+  {
+    return Vector3<T>{ a.y * b.z - a.z * b.y,
+                       a.z * b.x - a.x * b.z,
+                       a.x * b.y - a.y * b.x };
+  }
+
+  template <typename T>
+  VERDICT_HOST_DEVICE constexpr T dot( const Vector3<T> &a, const Vector3<T> &b )
+  {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+  }
+
+  template <typename T>
+  VERDICT_HOST_DEVICE constexpr T length_squared( const Vector3<T> &a )
+  {
+    return a.x * a.x + a.y * a.y + a.z * a.z;
+  }
+
+namespace detail
+{
+  // unqualified calls, so that argument dependent lookup finds the math
+  // functions of user scalar types (SIMD packs, automatic differentiation, ...)
+  template <typename T>
+  VERDICT_HOST_DEVICE inline T sqrt_of( T x ) { using std::sqrt; return sqrt( x ); }
+
+  template <typename T>
+  VERDICT_HOST_DEVICE inline T pow_of( T x, T y ) { using std::pow; return pow( x, y ); }
+
+  template <typename T>
+  VERDICT_HOST_DEVICE inline T cbrt_of( T x ) { using std::cbrt; return cbrt( x ); }
+
+  template <typename T>
+  VERDICT_HOST_DEVICE inline T fabs_of( T x ) { using std::fabs; return fabs( x ); }
+
+  //! std::min, which is not available in device code
+  template <typename T>
+  VERDICT_HOST_DEVICE constexpr T min_of( T a, T b ) { return b < a ? b : a; }
+
+  //! std::max, which is not available in device code
+  template <typename T>
+  VERDICT_HOST_DEVICE constexpr T max_of( T a, T b ) { return a < b ? b : a; }
+
+  //! the clamping to +-VERDICT_DBL_MAX done at the end of most metrics
+  template <typename T>
+  VERDICT_HOST_DEVICE constexpr T clamp( T v )
+  {
+    return v > 0 ? min_of( v, dbl_max<T>() ) : max_of( v, -dbl_max<T>() );
+  }
+
+  //! clamping that also maps NaN to VERDICT_DBL_MAX, as the tet metrics do
+  template <typename T>
+  VERDICT_HOST_DEVICE constexpr T fix_range( T v )
+  {
+    return v != v ? dbl_max<T>() :
+           v >= dbl_max<T>() ? dbl_max<T>() :
+           v <= -dbl_max<T>() ? -dbl_max<T>() : v;
+  }
+
+  //! edges of the Jacobian at one of the eight corners of a hex
+  template <typename R, class Nodes>
+  VERDICT_HOST_DEVICE VERDICT_CONSTEXPR void hex_corner_edges( const Nodes &coordinates, int corner,
+                                                              Vector3<R> &xxi, Vector3<R> &xet,
+                                                              Vector3<R> &xze )
+  {
+    // corner, xi, eta and zeta neighbors
+    const int corner_nodes[8][4] =
+    {
+      {0, 1, 3, 4}, {1, 2, 0, 5}, {2, 3, 1, 6}, {3, 0, 2, 7},
+      {4, 7, 5, 0}, {5, 4, 6, 1}, {6, 5, 7, 2}, {7, 6, 4, 3}
+    };
+    const int* nodes = corner_nodes[corner];
+    xxi = edge<R>( coordinates, nodes[0], nodes[1] );
+    xet = edge<R>( coordinates, nodes[0], nodes[2] );
+    xze = edge<R>( coordinates, nodes[0], nodes[3] );
+  }
+
+  //! sum of the nodes a, b, c, d minus the nodes e, f, g, h, summed left to right
+  template <typename R, class Nodes>
+  VERDICT_HOST_DEVICE VERDICT_CONSTEXPR Vector3<R> hex_axis( const Nodes &coordinates,
+                                                            int a, int b, int c, int d,
+                                                            int e, int f, int g, int h )
+  {
+    const int nodes[8] = { a, b, c, d, e, f, g, h };
+    Vector3<R> axis{ R( coordinates[a][0] ), R( coordinates[a][1] ), R( coordinates[a][2] ) };
+    for ( int i = 1; i < 8; i++ )
+    {
+      const int n = nodes[i];
+      if ( i < 4 )
+        axis = Vector3<R>{ axis.x + R( coordinates[n][0] ), axis.y + R( coordinates[n][1] ), axis.z + R( coordinates[n][2] ) };
+      else
+        axis = Vector3<R>{ axis.x - R( coordinates[n][0] ), axis.y - R( coordinates[n][1] ), axis.z - R( coordinates[n][2] ) };
+    }
+    return axis;
+  }
+
+  //! the three principal axes of a hex (calc_hex_efg 1, 2 and 3)
+  template <typename R, class Nodes>
+  VERDICT_HOST_DEVICE VERDICT_CONSTEXPR void hex_principal_axes( const Nodes &coordinates,
+                                                                Vector3<R> &efg1, Vector3<R> &efg2,
+                                                                Vector3<R> &efg3 )
+  {
+    efg1 = hex_axis<R>( coordinates, 1, 2, 5, 6, 0, 3, 4, 7 );
+    efg2 = hex_axis<R>( coordinates, 2, 3, 6, 7, 0, 1, 4, 5 );
+    efg3 = hex_axis<R>( coordinates, 4, 5, 6, 7, 0, 1, 2, 3 );
+  }
+
+  //! whether the last two nodes of a quad coincide
+  template <class Nodes>
+  VERDICT_HOST_DEVICE constexpr bool is_collapsed_quad( const Nodes &coordinates )
+  {
+    return coordinates[3][0] == coordinates[2][0] &&
+           coordinates[3][1] == coordinates[2][1] &&
+           coordinates[3][2] == coordinates[2][2];
+  }
+
+  //! the Jacobians at the corners of a quad, projected on its center normal
+  template <typename R, class Nodes>
+  VERDICT_HOST_DEVICE inline void quad_signed_corner_areas( const Nodes &coordinates, R areas[4] )
+  {
+    const Vector3<R> e0 = edge<R>( coordinates, 0, 1 );
+    const Vector3<R> e1 = edge<R>( coordinates, 1, 2 );
+    const Vector3<R> e2 = edge<R>( coordinates, 2, 3 );
+    const Vector3<R> e3 = edge<R>( coordinates, 3, 0 );
+
+    Vector3<R> normal = cross( e0 - e2, e1 - e3 );
+    const R magnitude = sqrt_of( length_squared( normal ) );
+    if ( magnitude != 0 )
+      normal = normal / magnitude;
+
+    areas[0] = dot( normal, cross( e3, e0 ) );
+    areas[1] = dot( normal, cross( e0, e1 ) );
+    areas[2] = dot( normal, cross( e1, e2 ) );
+    areas[3] = dot( normal, cross( e2, e3 ) );
+  }
+} // namespace detail
+
+/* tet kernels; 4 nodes */
+
+  //! see tet_volume
+  template <typename R, class Nodes>
+  VERDICT_HOST_DEVICE VERDICT_CONSTEXPR R tet_volume( const Nodes &coordinates )
+  {
+    const Vector3<R> side2 = edge<R>( coordinates, 0, 1 );
+    const Vector3<R> side0 = edge<R>( coordinates, 0, 2 );
+    const Vector3<R> side3 = edge<R>( coordinates, 0, 3 );
+    return dot( side3, cross( side2, side0 ) ) / R( 6.0 );
+  }
+
+  template <typename T, typename R = T>
+  VERDICT_HOST_DEVICE VERDICT_CONSTEXPR R tet_volume( const T coordinates[][3] )
+  {
+    return tet_volume<R>( ArrayNodes<T>{ coordinates } );
+  }
+
+  //! see tet_jacobian
+  template <typename R, class Nodes>
+  VERDICT_HOST_DEVICE VERDICT_CONSTEXPR R tet_jacobian( const Nodes &coordinates )
+  {
+    const Vector3<R> side0 = edge<R>( coordinates, 0, 1 );
+    const Vector3<R> side2 = edge<R>( coordinates, 2, 0 );
+    const Vector3<R> side3 = edge<R>( coordinates, 0, 3 );
+    return dot( side3, cross( side2, side0 ) );
+  }
+
+  template <typename T, typename R = T>
+  VERDICT_HOST_DEVICE VERDICT_CONSTEXPR R tet_jacobian( const T coordinates[][3] )
+  {
+    return tet_jacobian<R>( ArrayNodes<T>{ coordinates } );
+  }
+
+  //! see tet_scaled_jacobian
+  template <typename R, class Nodes>
+  VERDICT_HOST_DEVICE inline R tet_scaled_jacobian( const Nodes &coordinates )
+  {
+    const R root_of_2( 1.4142135623730950488016887242097 );
+
+    const Vector3<R> side0 = edge<R>( coordinates, 0, 1 );
+    const Vector3<R> side1 = edge<R>( coordinates, 1, 2 );
+    const Vector3<R> side2 = edge<R>( coordinates, 2, 0 );
+    const Vector3<R> side3 = edge<R>( coordinates, 0, 3 );
+    const Vector3<R> side4 = edge<R>( coordinates, 1, 3 );
+    const Vector3<R> side5 = edge<R>( coordinates, 2, 3 );
+
+    const R jacobi = dot( side3, cross( side2, side0 ) );
+
+    const R l0 = length_squared( side0 );
+    const R l1 = length_squared( side1 );
+    const R l2 = length_squared( side2 );
+    const R l3 = length_squared( side3 );
+    const R l4 = length_squared( side4 );
+    const R l5 = length_squared( side5 );
+
+    // largest product of the squared lengths of the edges attached to a node
+    R products = l0 * l2 * l3;
+    if ( l0 * l1 * l4 > products ) products = l0 * l1 * l4;
+    if ( l1 * l2 * l5 > products ) products = l1 * l2 * l5;
+    if ( l3 * l4 * l5 > products ) products = l3 * l4 * l5;
+
+    R length_product = detail::sqrt_of( products );
+    if ( length_product < detail::fabs_of( jacobi ) )
+      length_product = detail::fabs_of( jacobi );
+
+    if ( length_product < dbl_min<R>() )
+      return dbl_max<R>();
+
+    return root_of_2 * jacobi / length_product;
+  }
+
+  template <typename T, typename R = T>
+  VERDICT_HOST_DEVICE inline R tet_scaled_jacobian( const T coordinates[][3] )
+  {
+    return tet_scaled_jacobian<R>( ArrayNodes<T>{ coordinates } );
+  }
+
+  //! see tet_shape
+  template <typename R, class Nodes>
+  VERDICT_HOST_DEVICE inline R tet_shape( const Nodes &coordinates )
+  {
+    const Vector3<R> side0 = edge<R>( coordinates, 0, 1 );
+    const Vector3<R> side1 = edge<R>( coordinates, 1, 2 );
+    const Vector3<R> side2 = edge<R>( coordinates, 2, 0 );
+    const Vector3<R> side3 = edge<R>( coordinates, 0, 3 );
+    const Vector3<R> side4 = edge<R>( coordinates, 1, 3 );
+    const Vector3<R> side5 = edge<R>( coordinates, 2, 3 );
+
+    const R jacobian = dot( side3, cross( side2, side0 ) );
+    const R sum = length_squared( side0 ) + length_squared( side1 ) + length_squared( side2 ) +
+                  length_squared( side3 ) + length_squared( side4 ) + length_squared( side5 );
+    if ( jacobian < dbl_min<R>() || R( 0.5 ) * sum < dbl_min<R>() )
+      return R( 0 );
+
+    // 3 (sqrt(2) J)^(2/3) over half the sum of the squared edge lengths
+    const R cbrt_jacobian = detail::cbrt_of( jacobian );
+    const R shape = R( 6 ) * detail::cbrt_of( R( 2 ) ) * cbrt_jacobian * cbrt_jacobian / sum;
+    return detail::fix_range( shape );
+  }
+
+  template <typename T, typename R = T>
+  VERDICT_HOST_DEVICE inline R tet_shape( const T coordinates[][3] )
+  {
+    return tet_shape<R>( ArrayNodes<T>{ coordinates } );
+  }
+
+  //! see tet_mean_ratio
+  template <typename R, class Nodes>
+  VERDICT_HOST_DEVICE inline R tet_mean_ratio( const Nodes &coordinates )
+  {
+    const Vector3<R> side0 = edge<R>( coordinates, 0, 1 );
+    const Vector3<R> side2 = edge<R>( coordinates, 2, 0 );
+    const Vector3<R> side3 = edge<R>( coordinates, 0, 3 );
+
+    const R jacobian = dot( side3, cross( side2, side0 ) );
+    if ( detail::fabs_of( jacobian / R( 6.0 ) ) < dbl_min<R>() )
+      return R( 0 );
+
+    const Vector3<R> side1 = edge<R>( coordinates, 1, 2 );
+    const Vector3<R> side4 = edge<R>( coordinates, 1, 3 );
+    const Vector3<R> side5 = edge<R>( coordinates, 2, 3 );
+
+    const R sum = length_squared( side0 ) + length_squared( side1 ) + length_squared( side2 ) +
+                  length_squared( side3 ) + length_squared( side4 ) + length_squared( side5 );
+    // 12 (3 |V|)^(2/3) over the sum of the squared edge lengths
+    const R sign = jacobian < 0 ? R( -1 ) : R( 1 );
+    const R cbrt_jacobian = detail::cbrt_of( detail::fabs_of( jacobian ) );
+    return sign * ( R( 12 ) / detail::cbrt_of( R( 4 ) ) ) * cbrt_jacobian * cbrt_jacobian / sum;
+  }
+
+  template <typename T, typename R = T>
+  VERDICT_HOST_DEVICE inline R tet_mean_ratio( const T coordinates[][3] )
+  {
+    return tet_mean_ratio<R>( ArrayNodes<T>{ coordinates } );
+  }
+
+  //! see tet_condition
+  template <typename R, class Nodes>
+  VERDICT_HOST_DEVICE inline R tet_condition( const Nodes &coordinates )
+  {
+    const R rt3( 1.7320508075688772935274463415059 );
+    const R rt6( 2.4494897427831780981972840747059 );
+
+    const Vector3<R> side0 = edge<R>( coordinates, 0, 1 );
+    const Vector3<R> side2 = edge<R>( coordinates, 2, 0 );
+    const Vector3<R> side3 = edge<R>( coordinates, 0, 3 );
+
+    const Vector3<R> c_1 = side0;
+    const Vector3<R> c_2 = ( R( -2 ) * side2 - side0 ) / rt3;
+    const Vector3<R> c_3 = ( R( 3 ) * side3 + side2 - side0 ) / rt6;
+
+    const Vector3<R> c_12 = cross( c_1, c_2 );
+    const Vector3<R> c_23 = cross( c_2, c_3 );
+    const Vector3<R> c_13 = cross( c_1, c_3 );
+    const R term1 = dot( c_1, c_1 ) + dot( c_2, c_2 ) + dot( c_3, c_3 );
+    const R term2 = dot( c_12, c_12 ) + dot( c_23, c_23 ) + dot( c_13, c_13 );
+    const R det = dot( c_1, c_23 );
+
+    if ( detail::fabs_of( det ) <= dbl_min<R>() )
+      return dbl_max<R>();
+    return detail::sqrt_of( term1 * term2 ) / ( R( 3.0 ) * det );
+  }
+
+  template <typename T, typename R = T>
+  VERDICT_HOST_DEVICE inline R tet_condition( const T coordinates[][3] )
+  {
+    return tet_condition<R>( ArrayNodes<T>{ coordinates } );
+  }
+
+  //! see tet_edge_ratio
+  template <typename R, class Nodes>
+  VERDICT_HOST_DEVICE inline R tet_edge_ratio( const Nodes &coordinates )
+  {
+    const R a2 = length_squared( edge<R>( coordinates, 0, 1 ) );
+    const R b2 = length_squared( edge<R>( coordinates, 1, 2 ) );
+    const R c2 = length_squared( edge<R>( coordinates, 2, 0 ) );
+    const R d2 = length_squared( edge<R>( coordinates, 0, 3 ) );
+    const R e2 = length_squared( edge<R>( coordinates, 1, 3 ) );
+    const R f2 = length_squared( edge<R>( coordinates, 2, 3 ) );
+
+    const R mab = a2 < b2 ? a2 : b2;
+    const R Mab = a2 < b2 ? b2 : a2;
+    const R mcd = c2 < d2 ? c2 : d2;
+    const R Mcd = c2 < d2 ? d2 : c2;
+    const R mef = e2 < f2 ? e2 : f2;
+    const R Mef = e2 < f2 ? f2 : e2;
+
+    R m2 = mab < mcd ? mab : mcd;
+    m2 = m2 < mef ? m2 : mef;
+    if ( m2 < dbl_min<R>() )
+      return dbl_max<R>();
+
+    R M2 = Mab > Mcd ? Mab : Mcd;
+    M2 = M2 > Mef ? M2 : Mef;
+
+    return detail::fix_range( detail::sqrt_of( M2 / m2 ) );
+  }
+
+  template <typename T, typename R = T>
+  VERDICT_HOST_DEVICE inline R tet_edge_ratio( const T coordinates[][3] )
+  {
+    return tet_edge_ratio<R>( ArrayNodes<T>{ coordinates } );
+  }
+
+/* hex kernels; 8 nodes */
+
+  //! see hex_jacobian
+  template <typename R, class Nodes>
+  VERDICT_HOST_DEVICE VERDICT_CONSTEXPR R hex_jacobian( const Nodes &coordinates )
+  {
+    Vector3<R> xxi{}, xet{}, xze{};
+    detail::hex_principal_axes( coordinates, xxi, xet, xze );
+    R jacobian = dbl_max<R>();
+    const R center = dot( xxi, cross( xet, xze ) ) / R( 64.0 );
+    if ( center < jacobian ) jacobian = center;
+
+    for ( int corner = 0; corner < 8; corner++ )
+    {
+      detail::hex_corner_edges( coordinates, corner, xxi, xet, xze );
+      const R current = dot( xxi, cross( xet, xze ) );
+      if ( current < jacobian ) jacobian = current;
+    }
+    return detail::clamp( jacobian );
+  }
+
+  template <typename T, typename R = T>
+  VERDICT_HOST_DEVICE VERDICT_CONSTEXPR R hex_jacobian( const T coordinates[][3] )
+  {
+    return hex_jacobian<R>( ArrayNodes<T>{ coordinates } );
+  }
+
+  //! see hex_scaled_jacobian
+  template <typename R, class Nodes>
+  VERDICT_HOST_DEVICE inline R hex_scaled_jacobian( const Nodes &coordinates )
+  {
+    Vector3<R> xxi{}, xet{}, xze{};
+    detail::hex_principal_axes( coordinates, xxi, xet, xze );
+
+    R min_norm_jac = dbl_max<R>();
+    // the center, then the eight corners
+    for ( int corner = -1; corner < 8; corner++ )
+    {
+      if ( corner >= 0 )
+        detail::hex_corner_edges( coordinates, corner, xxi, xet, xze );
+
+      const R jacobi = dot( xxi, cross( xet, xze ) );
+      const R len1_sq = length_squared( xxi );
+      const R len2_sq = length_squared( xet );
+      const R len3_sq = length_squared( xze );
+      if ( len1_sq <= dbl_min<R>() || len2_sq <= dbl_min<R>() || len3_sq <= dbl_min<R>() )
+        return dbl_max<R>();
+
+      const R norm_jac = jacobi / detail::sqrt_of( len1_sq * len2_sq * len3_sq );
+      if ( norm_jac < min_norm_jac ) min_norm_jac = norm_jac;
+    }
+    return detail::clamp( min_norm_jac );
+  }
+
+  template <typename T, typename R = T>
+  VERDICT_HOST_DEVICE inline R hex_scaled_jacobian( const T coordinates[][3] )
+  {
+    return hex_scaled_jacobian<R>( ArrayNodes<T>{ coordinates } );
+  }
+
+  //! see hex_shear
+  template <typename R, class Nodes>
+  VERDICT_HOST_DEVICE inline R hex_shear( const Nodes &coordinates )
+  {
+    R min_shear = R( 1.0 );
+    for ( int corner = 0; corner < 8; corner++ )
+    {
+      Vector3<R> xxi{}, xet{}, xze{};
+      detail::hex_corner_edges( coordinates, corner, xxi, xet, xze );
+
+      const R len1_sq = length_squared( xxi );
+      const R len2_sq = length_squared( xet );
+      const R len3_sq = length_squared( xze );
+      if ( len1_sq <= dbl_min<R>() || len2_sq <= dbl_min<R>() || len3_sq <= dbl_min<R>() )
+        return R( 0 );
+
+      const R lengths = detail::sqrt_of( len1_sq * len2_sq * len3_sq );
+      const R det = dot( xxi, cross( xet, xze ) );
+      if ( det < dbl_min<R>() )
+        return R( 0 );
+
+      min_shear = detail::min_of( det / lengths, min_shear );
+    }
+    if ( min_shear <= dbl_min<R>() )
+      min_shear = 0;
+    return detail::clamp( min_shear );
+  }
+
+  template <typename T, typename R = T>
+  VERDICT_HOST_DEVICE inline R hex_shear( const T coordinates[][3] )
+  {
+    return hex_shear<R>( ArrayNodes<T>{ coordinates } );
+  }
+
+  //! see hex_shape
+  template <typename R, class Nodes>
+  VERDICT_HOST_DEVICE inline R hex_shape( const Nodes &coordinates )
+  {
+    R min_shape = R( 1.0 );
+    for ( int corner = 0; corner < 8; corner++ )
+    {
+      Vector3<R> xxi{}, xet{}, xze{};
+      detail::hex_corner_edges( coordinates, corner, xxi, xet, xze );
+
+      const R det = dot( xxi, cross( xet, xze ) );
+      if ( !( det > dbl_min<R>() ) )
+        return R( 0 );
+
+      const R shape = R( 3 ) * detail::pow_of( det, R( 2.0 ) / R( 3.0 ) ) /
+                      ( dot( xxi, xxi ) + dot( xet, xet ) + dot( xze, xze ) );
+      if ( shape < min_shape ) min_shape = shape;
+    }
+    if ( min_shape <= dbl_min<R>() )
+      min_shape = 0;
+    return detail::clamp( min_shape );
+  }
+
+  template <typename T, typename R = T>
+  VERDICT_HOST_DEVICE inline R hex_shape( const T coordinates[][3] )
+  {
+    return hex_shape<R>( ArrayNodes<T>{ coordinates } );
+  }
+
+/* tri kernels; 3 nodes */
+
+  //! see tri_area
+  template <typename R, class Nodes>
+  VERDICT_HOST_DEVICE inline R tri_area( const Nodes &coordinates )
+  {
+    const Vector3<R> side1 = edge<R>( coordinates, 0, 1 );
+    const Vector3<R> side3 = edge<R>( coordinates, 0, 2 );
+    return detail::clamp( R( 0.5 ) * detail::sqrt_of( length_squared( cross( side1, side3 ) ) ) );
+  }
+
+  template <typename T, typename R = T>
+  VERDICT_HOST_DEVICE inline R tri_area( const T coordinates[][3] )
+  {
+    return tri_area<R>( ArrayNodes<T>{ coordinates } );
+  }
+
+  //! see tri_condition
+  template <typename R, class Nodes>
+  VERDICT_HOST_DEVICE inline R tri_condition( const Nodes &coordinates )
+  {
+    const R root_of_3( 1.7320508075688772935274463415059 );
+
+    const Vector3<R> v1 = edge<R>( coordinates, 0, 1 );
+    const Vector3<R> v2 = edge<R>( coordinates, 0, 2 );
+
+    const R areax2 = detail::sqrt_of( length_squared( cross( v1, v2 ) ) );
+    if ( areax2 == 0 )
+      return dbl_max<R>();
+
+    const R condition = ( dot( v1, v1 ) + dot( v2, v2 ) - dot( v1, v2 ) ) / ( areax2 * root_of_3 );
+    return detail::min_of( condition, dbl_max<R>() );
+  }
+
+  template <typename T, typename R = T>
+  VERDICT_HOST_DEVICE inline R tri_condition( const T coordinates[][3] )
+  {
+    return tri_condition<R>( ArrayNodes<T>{ coordinates } );
+  }
+
+  //! see tri_shape
+  template <typename R, class Nodes>
+  VERDICT_HOST_DEVICE inline R tri_shape( const Nodes &coordinates )
+  {
+    const R condition = tri_condition<R>( coordinates );
+    const R shape = condition <= dbl_min<R>() ? dbl_max<R>() : R( 1 ) / condition;
+    return detail::clamp( shape );
+  }
+
+  template <typename T, typename R = T>
+  VERDICT_HOST_DEVICE inline R tri_shape( const T coordinates[][3] )
+  {
+    return tri_shape<R>( ArrayNodes<T>{ coordinates } );
+  }
+
+  //! see tri_scaled_jacobian
+  template <typename R, class Nodes>
+  VERDICT_HOST_DEVICE inline R tri_scaled_jacobian( const Nodes &coordinates )
+  {
+    const R two_over_root_of_3 = R( 2.0 ) / R( 1.7320508075688772935274463415059 );
+
+    const Vector3<R> edge0 = edge<R>( coordinates, 0, 1 );
+    const Vector3<R> edge1 = edge<R>( coordinates, 0, 2 );
+    const Vector3<R> edge2 = edge<R>( coordinates, 1, 2 );
+
+    R jacobian = detail::sqrt_of( length_squared( cross( edge1 - edge0, edge2 - edge0 ) ) );
+
+    const R l0 = detail::sqrt_of( length_squared( edge0 ) );
+    const R l1 = detail::sqrt_of( length_squared( edge1 ) );
+    const R l2 = detail::sqrt_of( length_squared( edge2 ) );
+    const R max_edge_length_product = detail::max_of( l0 * l1, detail::max_of( l1 * l2, l0 * l2 ) );
+    if ( max_edge_length_product < dbl_min<R>() )
+      return R( 0 );
+
+    jacobian *= two_over_root_of_3;
+    jacobian /= max_edge_length_product;
+    return detail::clamp( jacobian );
+  }
+
+  template <typename T, typename R = T>
+  VERDICT_HOST_DEVICE inline R tri_scaled_jacobian( const T coordinates[][3] )
+  {
+    return tri_scaled_jacobian<R>( ArrayNodes<T>{ coordinates } );
+  }
+
+  //! see tri_edge_ratio
+  template <typename R, class Nodes>
+  VERDICT_HOST_DEVICE inline R tri_edge_ratio( const Nodes &coordinates )
+  {
+    const R a2 = length_squared( edge<R>( coordinates, 0, 1 ) );
+    const R b2 = length_squared( edge<R>( coordinates, 1, 2 ) );
+    const R c2 = length_squared( edge<R>( coordinates, 2, 0 ) );
+
+    R m2 = a2, M2 = a2;
+    if ( a2 < b2 )
+    {
+      if ( b2 < c2 ) { m2 = a2; M2 = c2; }
+      else if ( a2 < c2 ) { m2 = a2; M2 = b2; }
+      else { m2 = c2; M2 = b2; }
+    }
+    else
+    {
+      if ( a2 < c2 ) { m2 = b2; M2 = c2; }
+      else if ( b2 < c2 ) { m2 = b2; M2 = a2; }
+      else { m2 = c2; M2 = a2; }
+    }
+
+    if ( m2 < dbl_min<R>() )
+      return dbl_max<R>();
+    return detail::clamp( detail::sqrt_of( M2 / m2 ) );
+  }
+
+  template <typename T, typename R = T>
+  VERDICT_HOST_DEVICE inline R tri_edge_ratio( const T coordinates[][3] )
+  {
+    return tri_edge_ratio<R>( ArrayNodes<T>{ coordinates } );
+  }
+
+/* quad kernels; 4 nodes, a quad whose last two nodes coincide is a tri */
+
+  //! see quad_area
+  template <typename R, class Nodes>
+  VERDICT_HOST_DEVICE inline R quad_area( const Nodes &coordinates )
+  {
+    R areas[4] = { 0, 0, 0, 0 };
+    detail::quad_signed_corner_areas( coordinates, areas );
+    return detail::clamp( R( 0.25 ) * ( areas[0] + areas[1] + areas[2] + areas[3] ) );
+  }
+
+  template <typename T, typename R = T>
+  VERDICT_HOST_DEVICE inline R quad_area( const T coordinates[][3] )
+  {
+    return quad_area<R>( ArrayNodes<T>{ coordinates } );
+  }
+
+  //! see quad_jacobian
+  template <typename R, class Nodes>
+  VERDICT_HOST_DEVICE inline R quad_jacobian( const Nodes &coordinates )
+  {
+    if ( detail::is_collapsed_quad( coordinates ) )
+      return tri_area<R>( coordinates ) * R( 2.0 );
+
+    R areas[4] = { 0, 0, 0, 0 };
+    detail::quad_signed_corner_areas( coordinates, areas );
+    return detail::clamp( detail::min_of( detail::min_of( areas[0], areas[1] ),
+                                          detail::min_of( areas[2], areas[3] ) ) );
+  }
+
+  template <typename T, typename R = T>
+  VERDICT_HOST_DEVICE inline R quad_jacobian( const T coordinates[][3] )
+  {
+    return quad_jacobian<R>( ArrayNodes<T>{ coordinates } );
+  }
+
+  //! see quad_scaled_jacobian
+  template <typename R, class Nodes>
+  VERDICT_HOST_DEVICE inline R quad_scaled_jacobian( const Nodes &coordinates )
+  {
+    if ( detail::is_collapsed_quad( coordinates ) )
+      return tri_scaled_jacobian<R>( coordinates );
+
+    R areas[4] = { 0, 0, 0, 0 };
+    detail::quad_signed_corner_areas( coordinates, areas );
+
+    const R l0 = detail::sqrt_of( length_squared( edge<R>( coordinates, 0, 1 ) ) );
+    const R l1 = detail::sqrt_of( length_squared( edge<R>( coordinates, 1, 2 ) ) );
+    const R l2 = detail::sqrt_of( length_squared( edge<R>( coordinates, 2, 3 ) ) );
+    const R l3 = detail::sqrt_of( length_squared( edge<R>( coordinates, 3, 0 ) ) );
+    if ( l0 < dbl_min<R>() || l1 < dbl_min<R>() || l2 < dbl_min<R>() || l3 < dbl_min<R>() )
+      return R( 0 );
+
+    R min_scaled_jac = dbl_max<R>();
+    min_scaled_jac = detail::min_of( areas[0] / ( l0 * l3 ), min_scaled_jac );
+    min_scaled_jac = detail::min_of( areas[1] / ( l1 * l0 ), min_scaled_jac );
+    min_scaled_jac = detail::min_of( areas[2] / ( l2 * l1 ), min_scaled_jac );
+    min_scaled_jac = detail::min_of( areas[3] / ( l3 * l2 ), min_scaled_jac );
+    return detail::clamp( min_scaled_jac );
+  }
+
+  template <typename T, typename R = T>
+  VERDICT_HOST_DEVICE inline R quad_scaled_jacobian( const T coordinates[][3] )
+  {
+    return quad_scaled_jacobian<R>( ArrayNodes<T>{ coordinates } );
+  }
+
+  //! see quad_shear
+  template <typename R, class Nodes>
+  VERDICT_HOST_DEVICE inline R quad_shear( const Nodes &coordinates )
+  {
+    const R scaled_jacobian = quad_scaled_jacobian<R>( coordinates );
+    if ( scaled_jacobian <= dbl_min<R>() )
+      return R( 0 );
+    return detail::min_of( scaled_jacobian, dbl_max<R>() );
+  }
+
+  template <typename T, typename R = T>
+  VERDICT_HOST_DEVICE inline R quad_shear( const T coordinates[][3] )
+  {
+    return quad_shear<R>( ArrayNodes<T>{ coordinates } );
+  }
+
+  //! see quad_shape
+  template <typename R, class Nodes>
+  VERDICT_HOST_DEVICE inline R quad_shape( const Nodes &coordinates )
+  {
+    R areas[4] = { 0, 0, 0, 0 };
+    detail::quad_signed_corner_areas( coordinates, areas );
+
+    const R l0 = length_squared( edge<R>( coordinates, 0, 1 ) );
+    const R l1 = length_squared( edge<R>( coordinates, 1, 2 ) );
+    const R l2 = length_squared( edge<R>( coordinates, 2, 3 ) );
+    const R l3 = length_squared( edge<R>( coordinates, 3, 0 ) );
+    if ( l0 <= dbl_min<R>() || l1 <= dbl_min<R>() || l2 <= dbl_min<R>() || l3 <= dbl_min<R>() )
+      return R( 0 );
+
+    R min_shape = dbl_max<R>();
+    min_shape = detail::min_of( areas[0] / ( l0 + l3 ), min_shape );
+    min_shape = detail::min_of( areas[1] / ( l1 + l0 ), min_shape );
+    min_shape = detail::min_of( areas[2] / ( l2 + l1 ), min_shape );
+    min_shape = detail::min_of( areas[3] / ( l3 + l2 ), min_shape );
+    min_shape *= 2;
+
+    if ( min_shape < dbl_min<R>() )
+      min_shape = 0;
+    return detail::clamp( min_shape );
+  }
+
+  template <typename T, typename R = T>
+  VERDICT_HOST_DEVICE inline R quad_shape( const T coordinates[][3] )
+  {
+    return quad_shape<R>( ArrayNodes<T>{ coordinates } );
+  }
+
+  //! see quad_condition
+  template <typename R, class Nodes>
+  VERDICT_HOST_DEVICE inline R quad_condition( const Nodes &coordinates )
+  {
+    if ( detail::is_collapsed_quad( coordinates ) )
+      return tri_condition<R>( coordinates );
+
+    R areas[4] = { 0, 0, 0, 0 };
+    detail::quad_signed_corner_areas( coordinates, areas );
+
+    R max_condition = 0;
+    for ( int i = 0; i < 4; i++ )
+    {
+      const Vector3<R> xxi = edge<R>( coordinates, ( i + 1 ) % 4, i );
+      const Vector3<R> xet = edge<R>( coordinates, ( i + 3 ) % 4, i );
+      const R condition = areas[i] < dbl_min<R>() ? dbl_max<R>() :
+                          ( dot( xxi, xxi ) + dot( xet, xet ) ) / areas[i];
+      max_condition = detail::max_of( max_condition, condition );
+    }
+
+    if ( max_condition >= dbl_max<R>() ) return dbl_max<R>();
+    if ( max_condition <= -dbl_max<R>() ) return -dbl_max<R>();
+    return max_condition / R( 2. );
+  }
+
+  template <typename T, typename R = T>
+  VERDICT_HOST_DEVICE inline R quad_condition( const T coordinates[][3] )
+  {
+    return quad_condition<R>( ArrayNodes<T>{ coordinates } );
+  }
+
+/* whole meshes, read in place */
+
+  //! Applies a kernel to every element of a block with a fixed node count.
+  /** nodes is a StridedNodes or SoaNodes over the connectivity of the whole
+      block, and element i is nodes.element( i * nodes_per_element ), as in
+      the Exodus style verdict::mesh_quality.  kernel is called with the
+      nodes of each element, e.g.
+      [] ( const StridedNodes<double> &hex ) { return hex_shape<double>( hex ); } */
+  template <class Kernel, class Nodes, typename R>
+  inline void mesh_quality( Kernel kernel, VerdictIndex num_elements, int nodes_per_element,
+                            const Nodes &nodes, R* results )
+  {
+    for ( VerdictIndex i = 0; i < num_elements; i++ )
+      results[i] = kernel( nodes.element( i * nodes_per_element ) );
+  }
+
+  //! Applies a kernel to every element of a mesh whose elements start at offsets.
+  /** Element i is nodes.element( offsets[i] ), as in the VTK style
+      verdict::mesh_quality.  The kernels have a fixed node count, so every
+      element must have the node count kernel expects. */
+  template <class Kernel, class Nodes, typename R>
+  inline void mesh_quality( Kernel kernel, VerdictIndex num_elements, const Nodes &nodes,
+                            const VerdictIndex* offsets, R* results )
+  {
+    for ( VerdictIndex i = 0; i < num_elements; i++ )
+      results[i] = kernel( nodes.element( offsets[i] ) );
+  }
+
+} // namespace kernels
+} // namespace verdict
+
+#endif
@@ -0,0 +1,1121 @@
+/*=========================================================================
+
+  Module:    verdict_mesh.h
+
+  Copyright 2003,2006,2019 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+  Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government retains certain rights in this software.
+
+  See LICENSE for details.
+
+=========================================================================*/
+
+/*! \file verdict_mesh.h
+  \brief Header file for the mesh-level (batched) interface to the verdict library.
+ *
+ * verdict_mesh.h declares functions that evaluate a quality metric over
+ *           every element of a mesh in a single call.  The mesh is given
+ *           as a global point array plus a connectivity array, in the
+ *           style used by VTK unstructured grids and Exodus element blocks.
+ *
+ * This file is part of VERDICT
+ *
+ */
+
+#ifndef __verdict_mesh_h
+#define __verdict_mesh_h
+
+#include "verdict.h"
+
+namespace VERDICT_NAMESPACE
+{
+  //! Signature shared by the single element quality functions in verdict.h.
+  typedef double (*VerdictFunction)( int num_nodes, double coordinates[][3] );
+
+  //! Integer type used for point ids, connectivity entries and offsets.
+  /** 64 bits wide so that connectivity arrays of very large meshes can be
+      addressed directly. */
+  typedef long long VerdictIndex;
+
+  //! Largest number of nodes per element accepted by the mesh-level functions.
+  const int VERDICT_MAX_NODES_PER_ELEMENT = 27;
+
+/* quality functions for whole meshes */
+
+    //! Calculates a metric for every element of a mesh with mixed node counts.
+    /** The nodes of element i are connectivity[offsets[i]] ... connectivity[offsets[i+1]-1],
+        so offsets holds num_elements+1 entries (VTK style).  Each connectivity
+        entry is a 0-based index into points, which holds x,y,z triples.
+        results receives one value per element.  Elements with more than
+        VERDICT_MAX_NODES_PER_ELEMENT nodes get a result of 0. */
+    VERDICT_EXPORT void mesh_quality( VerdictFunction metric,
+                                      VerdictIndex num_elements,
+                                      const double* points,
+                                      const VerdictIndex* connectivity,
+                                      const VerdictIndex* offsets,
+                                      double* results );
+
+    //! Calculates a metric for every element of a block with a fixed node count.
+    /** The nodes of element i are connectivity[i*nodes_per_element] ...
+        connectivity[(i+1)*nodes_per_element-1] (Exodus element block style).
+        Each connectivity entry is a 0-based index into points, which holds
+        x,y,z triples.  results receives one value per element.  When
+        nodes_per_element exceeds VERDICT_MAX_NODES_PER_ELEMENT all results are 0. */
+    VERDICT_EXPORT void mesh_quality( VerdictFunction metric,
+                                      VerdictIndex num_elements,
+                                      int nodes_per_element,
+                                      const double* points,
+                                      const VerdictIndex* connectivity,
+                                      double* results );
+
+/* quality functions for whole meshes, computed in parallel */
+
+  /* The functions below split the elements into blocks that are handed to
+     num_threads threads (0 means as many as the threading backend chosen
+     when verdict was configured uses by default; without a backend they
+     run serially).  Threads that finish their blocks take over blocks of
+     the others, so meshes whose elements are of very different cost keep
+     all threads busy.  The std::thread backend keeps its worker threads
+     waiting between calls, as the OpenMP and TBB runtimes do, so a call
+     does not pay for starting them; a call made while another one uses
+     them starts threads of its own.  The results are the same as those of
+     mesh_quality. */
+
+    //! Calculates a metric for every element of a mesh with mixed node counts, in parallel.
+    /** See mesh_quality for the layout of the arguments. */
+    VERDICT_EXPORT void parallel_mesh_quality( VerdictFunction metric,
+                                               VerdictIndex num_elements,
+                                               const double* points,
+                                               const VerdictIndex* connectivity,
+                                               const VerdictIndex* offsets,
+                                               double* results,
+                                               int num_threads );
+
+    //! Calculates a metric for every element of a block with a fixed node count, in parallel.
+    /** See mesh_quality for the layout of the arguments. */
+    VERDICT_EXPORT void parallel_mesh_quality( VerdictFunction metric,
+                                               VerdictIndex num_elements,
+                                               int nodes_per_element,
+                                               const double* points,
+                                               const VerdictIndex* connectivity,
+                                               double* results,
+                                               int num_threads );
+
+  /* The higher order metrics and the loops over the blocks take their
+     large temporaries from scratch memory owned by the calling thread
+     rather than from its stack, so they also run on threads with small
+     stacks.  A thread takes its scratch memory from a pool the first time
+     it needs some and returns it to the pool when it exits, so the workers
+     of successive parallel calls reuse it; the kept workers of the
+     std::thread backend hold on to theirs. */
+
+    //! The bytes of scratch memory held by the threads and the pool.
+    VERDICT_EXPORT unsigned long long scratch_memory_size();
+
+    //! Frees the scratch memory of the pool and of the calling thread.
+    /** Returns the number of bytes freed.  Threads still running keep theirs. */
+    VERDICT_EXPORT unsigned long long release_scratch_memory();
+
+  //! Largest number of histogram bins of MeshStatistics.
+  const int VERDICT_MAX_HISTOGRAM_BINS = 64;
+
+  //! Largest number of worst elements reported in MeshStatistics.
+  const int VERDICT_MAX_WORST_ELEMENTS = 64;
+
+  //! What mesh_statistics gathers besides the minimum, maximum, mean and standard deviation.
+  struct MeshStatisticsRequest
+  {
+    double acceptable_min;  //!< lower end of the acceptable range of the metric
+    double acceptable_max;  //!< upper end of the acceptable range of the metric
+    int num_bins;           //!< histogram bins splitting the acceptable range, up to VERDICT_MAX_HISTOGRAM_BINS
+    int num_worst;          //!< number of worst elements to report, up to VERDICT_MAX_WORST_ELEMENTS
+    bool smaller_is_worse;  //!< whether the worst elements have the smallest values (e.g. scaled jacobian)
+  };
+
+  //! Statistics of a metric over a mesh.
+  /** Elements whose metric is NaN are not counted in any of the fields. */
+  struct MeshStatistics
+  {
+    VerdictIndex count;          //!< number of elements
+    double minimum;
+    double maximum;
+    double mean;
+    double standard_deviation;   //!< population standard deviation
+    VerdictIndex below_acceptable;  //!< elements below acceptable_min
+    VerdictIndex above_acceptable;  //!< elements above acceptable_max
+    VerdictIndex histogram[VERDICT_MAX_HISTOGRAM_BINS];  //!< elements in each bin of the acceptable range
+    int num_worst;               //!< entries of worst_elements and worst_values
+    VerdictIndex worst_elements[VERDICT_MAX_WORST_ELEMENTS];  //!< worst elements, worst first
+    double worst_values[VERDICT_MAX_WORST_ELEMENTS];          //!< metric of each of worst_elements
+  };
+
+/* statistics of a metric over whole meshes */
+
+  /* The functions below fold each value into the statistics as soon as it
+     is computed, so no array of per element results is needed.  The
+     elements are evaluated as by parallel_mesh_quality; num_threads == 1
+     evaluates them serially.  Each thread keeps partial statistics that
+     are merged at the end, so the mean and standard deviation may differ
+     in the last bits between runs with several threads.  Ties between
+     worst elements go to the element with the smaller index. */
+
+    //! Calculates statistics of a metric over a mesh with mixed node counts.
+    /** See mesh_quality for the layout of the arguments. */
+    VERDICT_EXPORT void mesh_statistics( VerdictFunction metric,
+                                         VerdictIndex num_elements,
+                                         const double* points,
+                                         const VerdictIndex* connectivity,
+                                         const VerdictIndex* offsets,
+                                         const MeshStatisticsRequest &request,
+                                         MeshStatistics &statistics,
+                                         int num_threads );
+
+    //! Calculates statistics of a metric over a block with a fixed node count.
+    /** See mesh_quality for the layout of the arguments. */
+    VERDICT_EXPORT void mesh_statistics( VerdictFunction metric,
+                                         VerdictIndex num_elements,
+                                         int nodes_per_element,
+                                         const double* points,
+                                         const VerdictIndex* connectivity,
+                                         const MeshStatisticsRequest &request,
+                                         MeshStatistics &statistics,
+                                         int num_threads );
+
+  //! Signature of the single element quality functions relative to the average size.
+  typedef double (*VerdictSizedFunction)( int num_nodes, double coordinates[][3], double average_size );
+
+  //! Element types of the metric registry.
+  enum VerdictElementType
+  {
+    VERDICT_ELEMENT_EDGE,
+    VERDICT_ELEMENT_TRI,
+    VERDICT_ELEMENT_QUAD,
+    VERDICT_ELEMENT_TET,
+    VERDICT_ELEMENT_PYRAMID,
+    VERDICT_ELEMENT_WEDGE,
+    VERDICT_ELEMENT_KNIFE,
+    VERDICT_ELEMENT_HEX
+  };
+
+  //! The single element quality functions of verdict.h, one per enumerator.
+  /** VERDICT_METRIC_X names the function x.  hex_timestep and tet_timestep,
+      which also take material properties, and hex_nodal_jacobian_ratio2,
+      which takes its coordinates differently, are not registered, nor is
+      tri_shear, which is declared but not implemented. */
+  enum VerdictMetric
+  {
+    VERDICT_METRIC_EDGE_LENGTH,
+    VERDICT_METRIC_TRI_EDGE_RATIO,
+    VERDICT_METRIC_TRI_ASPECT_RATIO,
+    VERDICT_METRIC_TRI_RADIUS_RATIO,
+    VERDICT_METRIC_TRI_ASPECT_FROBENIUS,
+    VERDICT_METRIC_TRI_AREA,
+    VERDICT_METRIC_TRI_MINIMUM_ANGLE,
+    VERDICT_METRIC_TRI_MAXIMUM_ANGLE,
+    VERDICT_METRIC_TRI_CONDITION,
+    VERDICT_METRIC_TRI_SCALED_JACOBIAN,
+    VERDICT_METRIC_TRI_RELATIVE_SIZE_SQUARED,
+    VERDICT_METRIC_TRI_SHAPE,
+    VERDICT_METRIC_TRI_SHAPE_AND_SIZE,
+    VERDICT_METRIC_TRI_DISTORTION,
+    VERDICT_METRIC_TRI_EQUIANGLE_SKEW,
+    VERDICT_METRIC_TRI_NORMALIZED_INRADIUS,
+    VERDICT_METRIC_QUAD_EDGE_RATIO,
+    VERDICT_METRIC_QUAD_MAX_EDGE_RATIO,
+    VERDICT_METRIC_QUAD_ASPECT_RATIO,
+    VERDICT_METRIC_QUAD_RADIUS_RATIO,
+    VERDICT_METRIC_QUAD_MED_ASPECT_FROBENIUS,
+    VERDICT_METRIC_QUAD_MAX_ASPECT_FROBENIUS,
+    VERDICT_METRIC_QUAD_SKEW,
+    VERDICT_METRIC_QUAD_TAPER,
+    VERDICT_METRIC_QUAD_WARPAGE,
+    VERDICT_METRIC_QUAD_AREA,
+    VERDICT_METRIC_QUAD_STRETCH,
+    VERDICT_METRIC_QUAD_MINIMUM_ANGLE,
+    VERDICT_METRIC_QUAD_MAXIMUM_ANGLE,
+    VERDICT_METRIC_QUAD_ODDY,
+    VERDICT_METRIC_QUAD_CONDITION,
+    VERDICT_METRIC_QUAD_JACOBIAN,
+    VERDICT_METRIC_QUAD_SCALED_JACOBIAN,
+    VERDICT_METRIC_QUAD_SHEAR,
+    VERDICT_METRIC_QUAD_SHAPE,
+    VERDICT_METRIC_QUAD_RELATIVE_SIZE_SQUARED,
+    VERDICT_METRIC_QUAD_SHAPE_AND_SIZE,
+    VERDICT_METRIC_QUAD_SHEAR_AND_SIZE,
+    VERDICT_METRIC_QUAD_DISTORTION,
+    VERDICT_METRIC_QUAD_EQUIANGLE_SKEW,
+    VERDICT_METRIC_TET_INRADIUS,
+    VERDICT_METRIC_TET_EDGE_RATIO,
+    VERDICT_METRIC_TET_RADIUS_RATIO,
+    VERDICT_METRIC_TET_ASPECT_RATIO,
+    VERDICT_METRIC_TET_ASPECT_GAMMA,
+    VERDICT_METRIC_TET_ASPECT_FROBENIUS,
+    VERDICT_METRIC_TET_MINIMUM_ANGLE,
+    VERDICT_METRIC_TET_COLLAPSE_RATIO,
+    VERDICT_METRIC_TET_VOLUME,
+    VERDICT_METRIC_TET_CONDITION,
+    VERDICT_METRIC_TET_JACOBIAN,
+    VERDICT_METRIC_TET_SCALED_JACOBIAN,
+    VERDICT_METRIC_TET_MEAN_RATIO,
+    VERDICT_METRIC_TET_NORMALIZED_INRADIUS,
+    VERDICT_METRIC_TET_SHAPE,
+    VERDICT_METRIC_TET_RELATIVE_SIZE_SQUARED,
+    VERDICT_METRIC_TET_SHAPE_AND_SIZE,
+    VERDICT_METRIC_TET_DISTORTION,
+    VERDICT_METRIC_TET_EQUIVOLUME_SKEW,
+    VERDICT_METRIC_TET_SQUISH_INDEX,
+    VERDICT_METRIC_TET_EQUIANGLE_SKEW,
+    VERDICT_METRIC_PYRAMID_VOLUME,
+    VERDICT_METRIC_PYRAMID_JACOBIAN,
+    VERDICT_METRIC_PYRAMID_SCALED_JACOBIAN,
+    VERDICT_METRIC_PYRAMID_SHAPE,
+    VERDICT_METRIC_PYRAMID_EQUIANGLE_SKEW,
+    VERDICT_METRIC_WEDGE_VOLUME,
+    VERDICT_METRIC_WEDGE_EDGE_RATIO,
+    VERDICT_METRIC_WEDGE_MAX_ASPECT_FROBENIUS,
+    VERDICT_METRIC_WEDGE_MEAN_ASPECT_FROBENIUS,
+    VERDICT_METRIC_WEDGE_JACOBIAN,
+    VERDICT_METRIC_WEDGE_DISTORTION,
+    VERDICT_METRIC_WEDGE_MAX_STRETCH,
+    VERDICT_METRIC_WEDGE_SCALED_JACOBIAN,
+    VERDICT_METRIC_WEDGE_SHAPE,
+    VERDICT_METRIC_WEDGE_CONDITION,
+    VERDICT_METRIC_WEDGE_EQUIANGLE_SKEW,
+    VERDICT_METRIC_KNIFE_VOLUME,
+    VERDICT_METRIC_HEX_EDGE_RATIO,
+    VERDICT_METRIC_HEX_MAX_EDGE_RATIO,
+    VERDICT_METRIC_HEX_SKEW,
+    VERDICT_METRIC_HEX_TAPER,
+    VERDICT_METRIC_HEX_VOLUME,
+    VERDICT_METRIC_HEX_STRETCH,
+    VERDICT_METRIC_HEX_DIAGONAL,
+    VERDICT_METRIC_HEX_DIMENSION,
+    VERDICT_METRIC_HEX_ODDY,
+    VERDICT_METRIC_HEX_MED_ASPECT_FROBENIUS,
+    VERDICT_METRIC_HEX_MAX_ASPECT_FROBENIUS,
+    VERDICT_METRIC_HEX_CONDITION,
+    VERDICT_METRIC_HEX_JACOBIAN,
+    VERDICT_METRIC_HEX_SCALED_JACOBIAN,
+    VERDICT_METRIC_HEX_NODAL_JACOBIAN_RATIO,
+    VERDICT_METRIC_HEX_SHEAR,
+    VERDICT_METRIC_HEX_SHAPE,
+    VERDICT_METRIC_HEX_RELATIVE_SIZE_SQUARED,
+    VERDICT_METRIC_HEX_SHAPE_AND_SIZE,
+    VERDICT_METRIC_HEX_SHEAR_AND_SIZE,
+    VERDICT_METRIC_HEX_DISTORTION,
+    VERDICT_METRIC_HEX_EQUIANGLE_SKEW,
+    VERDICT_NUM_METRICS
+  };
+
+  //! What the registry knows about a metric.
+  /** The ranges are those of the Verdict manual: the values of acceptable
+      elements, of elements that are not degenerate, and all the values the
+      metric can take.  A range the manual leaves to the application is
+      [-VERDICT_DBL_MAX, VERDICT_DBL_MAX]. */
+  struct VerdictMetricInfo
+  {
+    VerdictMetric metric;
+    const char* name;                     //!< the name of the function, e.g. "hex_scaled_jacobian"
+    VerdictElementType element;
+    int num_corners;                      //!< nodes of the linear element; fewer nodes are not supported
+    VerdictFunction function;             //!< null for the metrics relative to the average size
+    VerdictSizedFunction sized_function;  //!< set instead of function when the metric needs an average size
+    bool smaller_is_worse;                //!< whether smaller values are worse, as in MeshStatisticsRequest
+    double acceptable_min;
+    double acceptable_max;
+    double normal_min;
+    double normal_max;
+    double full_min;
+    double full_max;
+  };
+
+/* the metric registry */
+
+  /* Metrics picked at runtime, e.g. from the name given in a configuration,
+     are resolved to an entry of the registry once.  The mesh functions
+     below taking a VerdictMetric then pick the loop for the metric and node
+     count once per call, so each element costs neither a lookup nor an
+     indirect call where a specialized loop exists.  The mesh functions
+     taking a VerdictFunction look their function up in the registry the
+     same way and run the loops that give exactly the same results. */
+
+    //! Returns the registry entry of a metric, or null when metric is not a VerdictMetric.
+    VERDICT_EXPORT const VerdictMetricInfo* metric_info( VerdictMetric metric );
+
+    //! Finds a metric by the name of its function.
+    /** The name is compared ignoring case; a "v_" prefix, as in the names of
+        the old C interface, is ignored.  Returns false for unknown names. */
+    VERDICT_EXPORT bool find_metric( const char* name, VerdictMetric &metric );
+
+    //! Finds the metric a single element function computes.
+    /** Returns false for functions that are not registered. */
+    VERDICT_EXPORT bool find_metric( VerdictFunction function, VerdictMetric &metric );
+
+    //! Returns a request of mesh_statistics over the acceptable range of a metric.
+    /** The bins split the acceptable range, and the worst elements are on
+        the side the registry gives. */
+    VERDICT_EXPORT MeshStatisticsRequest metric_statistics_request( VerdictMetric metric,
+                                                                    int num_bins,
+                                                                    int num_worst );
+
+    //! Calculates a registered metric for every element of a block with a fixed node count.
+    /** The arguments are as for mesh_quality; average_size is passed to the
+        metrics relative to the average size and ignored by the others.
+        results receives the value the single element function returns, but
+        for the metrics that have a structure-of-arrays function below, which
+        agree with it as those functions do.  All results are 0 for an
+        unknown metric and for fewer nodes_per_element than the corners of
+        its element, or more than VERDICT_MAX_NODES_PER_ELEMENT. */
+    VERDICT_EXPORT void mesh_quality( VerdictMetric metric,
+                                      VerdictIndex num_elements,
+                                      int nodes_per_element,
+                                      const double* points,
+                                      const VerdictIndex* connectivity,
+                                      double average_size,
+                                      double* results );
+
+    //! Calculates a registered metric for every element of a block with a fixed node count, in parallel.
+    /** See the serial version and parallel_mesh_quality. */
+    VERDICT_EXPORT void parallel_mesh_quality( VerdictMetric metric,
+                                               VerdictIndex num_elements,
+                                               int nodes_per_element,
+                                               const double* points,
+                                               const VerdictIndex* connectivity,
+                                               double average_size,
+                                               double* results,
+                                               int num_threads );
+
+  //! A chunk of consecutive elements of a streamed mesh.
+  /** The elements are laid out as for mesh_quality: the nodes of element i
+      of the chunk are connectivity[offsets[i]] ... connectivity[offsets[i+1]-1]
+      when offsets is not null, and connectivity[i*nodes_per_element] ...
+      connectivity[(i+1)*nodes_per_element-1] otherwise.  points must hold
+      every point the chunk refers to, with the indices of the connectivity. */
+  struct MeshChunk
+  {
+    VerdictIndex num_elements;      //!< 0 past the last element of the mesh
+    int nodes_per_element;          //!< used when offsets is null
+    const double* points;
+    const VerdictIndex* connectivity;
+    const VerdictIndex* offsets;    //!< num_elements+1 entries, or null
+  };
+
+  //! Reads the elements first_element ... first_element+max_elements-1 of a mesh, or fewer.
+  /** Fills chunk and returns true, with chunk.num_elements = 0 past the
+      last element, or returns false on a read error.  buffer alternates
+      between 0 and 1; the chunk read into a buffer must stay valid until
+      the next call with the same buffer, which is made once the chunk has
+      been evaluated.  The reader is called from another thread than the
+      caller of stream_mesh_quality, but never concurrently with itself. */
+  typedef bool (*MeshChunkReader)( void* data, int buffer, VerdictIndex first_element,
+                                   VerdictIndex max_elements, MeshChunk &chunk );
+
+  //! Receives the metric of the elements first_element ... first_element+num_elements-1.
+  /** Returns false on a write error.  Called in element order, from another
+      thread than the caller of stream_mesh_quality but never concurrently
+      with itself or the reader. */
+  typedef bool (*MeshResultWriter)( void* data, VerdictIndex first_element,
+                                    VerdictIndex num_elements, const double* results );
+
+/* quality of meshes streamed in chunks, such as meshes larger than memory */
+
+  /* stream_mesh_quality evaluates a metric over a mesh that is read one
+     chunk of at most chunk_elements elements at a time.  Only two chunks
+     are alive at once: while one is evaluated as by mesh_statistics, the
+     results of the previous one are handed to writer and the next one is
+     read, so reading, writing and evaluating overlap.  Besides what the
+     reader keeps, the memory used is two arrays of chunk_elements results.
+     The statistics are those of mesh_statistics over the whole mesh, with
+     elements numbered across the chunks. */
+
+    //! Evaluates a metric over a mesh read in chunks and gathers its statistics.
+    /** chunk_elements < 1 selects about a million elements per chunk.
+        writer may be null when only the statistics are wanted.  Returns
+        false, with the statistics of the elements evaluated so far, when
+        the reader or the writer fails or a chunk exceeds chunk_elements. */
+    VERDICT_EXPORT bool stream_mesh_quality( VerdictFunction metric,
+                                             MeshChunkReader reader,
+                                             void* reader_data,
+                                             VerdictIndex chunk_elements,
+                                             MeshResultWriter writer,
+                                             void* writer_data,
+                                             const MeshStatisticsRequest &request,
+                                             MeshStatistics &statistics,
+                                             int num_threads );
+
+    //! MeshResultWriter appending the results as native doubles to the FILE* passed as data.
+    VERDICT_EXPORT bool write_results_to_file( void* file, VerdictIndex first_element,
+                                               VerdictIndex num_elements, const double* results );
+
+  //! A mesh stored in flat binary files, read through memory maps.
+  /** The points file holds x,y,z triples of native doubles and the
+      connectivity and offsets files native VerdictIndex values, laid out
+      as the arrays of mesh_quality.  The files are mapped rather than read,
+      so the operating system pages them in as chunks are read and may
+      evict them again; read_chunk advises it to fetch the points a chunk
+      uses ahead of its evaluation and to drop the connectivity of chunks
+      already evaluated.  The sizes of the files are checked when they are
+      mapped, the connectivity of each chunk when it is read. */
+  class VERDICT_EXPORT MappedMesh
+  {
+  public:
+    //! Maps a block with a fixed node count.
+    MappedMesh( const char* points_file, const char* connectivity_file, int nodes_per_element );
+
+    //! Maps a mesh with mixed node counts, whose offsets file holds num_elements+1 entries.
+    MappedMesh( const char* points_file, const char* connectivity_file, const char* offsets_file );
+
+    ~MappedMesh();
+
+    //! Whether the files were mapped and their sizes are consistent.
+    bool is_open() const;
+
+    VerdictIndex num_points() const;
+    VerdictIndex num_elements() const;
+
+    //! MeshChunkReader of the MappedMesh passed as data.
+    /** Fails when a chunk refers to points outside the points file or its
+        offsets are out of order or out of the connectivity file. */
+    static bool read_chunk( void* mesh, int buffer, VerdictIndex first_element,
+                            VerdictIndex max_elements, MeshChunk &chunk );
+
+    struct Internals;
+
+  private:
+    MappedMesh( const MappedMesh& );
+    MappedMesh& operator=( const MappedMesh& );
+
+    Internals* internals;
+  };
+
+/* incremental quality of a mesh whose points move */
+
+  //! Metric values and statistics of a mesh, kept up to date as its points move.
+  /** The connectivity is copied, together with the elements using each
+      point, so after some points move update re-evaluates only the
+      elements that use them.  The count, histogram and acceptable range
+      counts are adjusted exactly; the mean and standard deviation are
+      adjusted by differences, so they may drift in the last bits from
+      those of mesh_statistics.  The minimum, maximum and worst elements
+      are rescanned from the cached values, without evaluating the metric,
+      only when an update may have changed them.  The points are passed
+      to each call, since the caller owns and moves them. */
+  class VERDICT_EXPORT MeshQualityCache
+  {
+  public:
+    //! Evaluates every element of a mesh with mixed node counts.
+    /** See mesh_quality for the layout of the arguments. */
+    MeshQualityCache( VerdictFunction metric,
+                      VerdictIndex num_elements,
+                      const double* points,
+                      const VerdictIndex* connectivity,
+                      const VerdictIndex* offsets,
+                      const MeshStatisticsRequest &request,
+                      int num_threads );
+
+    //! Evaluates every element of a block with a fixed node count.
+    /** See mesh_quality for the layout of the arguments. */
+    MeshQualityCache( VerdictFunction metric,
+                      VerdictIndex num_elements,
+                      int nodes_per_element,
+                      const double* points,
+                      const VerdictIndex* connectivity,
+                      const MeshStatisticsRequest &request,
+                      int num_threads );
+
+    ~MeshQualityCache();
+
+    //! Re-evaluates the elements using any of the moved points.
+    /** Returns the number of elements re-evaluated. */
+    VerdictIndex update( const double* points, const VerdictIndex* moved_points, VerdictIndex num_moved );
+
+    //! Re-evaluates every element, after most of the points moved.
+    void update_all( const double* points );
+
+    VerdictIndex num_elements() const;
+
+    //! The metric of each element.
+    const double* values() const;
+
+    //! The statistics of the current values.
+    const MeshStatistics& statistics();
+
+    struct Internals;
+
+  private:
+    MeshQualityCache( const MeshQualityCache& );
+    MeshQualityCache& operator=( const MeshQualityCache& );
+
+    Internals* internals;
+  };
+
+/* memoized quality of elements evaluated again and again */
+
+  /* Reports rerun over unchanged parts of a model evaluate the same
+     elements again and again.  A MetricResultCache keeps the values of
+     elements keyed by a 128 bit hash (MurmurHash3) of the metric, the
+     number of nodes, the average size of the size-relative metrics and
+     the bits of the node coordinates, so an element whose nodes have not
+     moved costs one hash and one lookup.  A key identifies its element
+     up to a hash collision, whose probability is neglected.  The values
+     are kept in sets of 8, and a full set replaces its least recently
+     used value.  The table can be saved to a file and loaded by later
+     runs of the same version of verdict on a machine of the same byte
+     order; the keys do not depend on where the points or elements are. */
+
+  //! A table of the values of elements, keyed by the hash of their coordinates.
+  class VERDICT_EXPORT MetricResultCache
+  {
+  public:
+    //! An empty table of at least capacity values.
+    explicit MetricResultCache( VerdictIndex capacity );
+
+    ~MetricResultCache();
+
+    //! The number of values the table holds at most.
+    VerdictIndex capacity() const;
+
+    //! The number of values it holds.
+    VerdictIndex size() const;
+
+    //! The elements found and not found since it was made or cleared.
+    VerdictIndex hits() const;
+    VerdictIndex misses() const;
+
+    //! Removes all values.
+    void clear();
+
+    //! Calculates a registered metric for every element of a block, reusing cached values.
+    /** See mesh_quality for the arguments.  The elements found in the table
+        take its values; the others are evaluated as by parallel_mesh_quality
+        and added to it.  The elements are looked up in parallel, but the
+        table must not be used by two calls at once.  Unknown metrics and
+        unsupported node counts are evaluated without the table.  Returns
+        the number of elements evaluated. */
+    VerdictIndex mesh_quality( VerdictMetric metric,
+                               VerdictIndex num_elements,
+                               int nodes_per_element,
+                               const double* points,
+                               const VerdictIndex* connectivity,
+                               double average_size,
+                               double* results,
+                               int num_threads );
+
+    //! Writes the values to a file, the least recently used first.
+    /** Returns false when the file cannot be written. */
+    bool save( const char* path ) const;
+
+    //! Adds the values of a file written by save, as if just used.
+    /** Returns false when the file cannot be read or was not written by
+        save of this version; the values read up to a truncation are kept. */
+    bool load( const char* path );
+
+    struct Internals;
+
+  private:
+    MetricResultCache( const MetricResultCache& );
+    MetricResultCache& operator=( const MetricResultCache& );
+
+    Internals* internals;
+  };
+
+/* quality of blocks evaluated while the caller goes on */
+
+  /* A MeshQualityQueue evaluates the blocks submitted to it on a thread of
+     its own, so a mesh generator can go on generating, or writing, while
+     the blocks it produced are checked.  Each block is evaluated for a set
+     of registered metrics as by parallel_mesh_quality, in the order the
+     blocks were submitted.  submit returns a ticket, numbered 1, 2, ... in
+     that order, which is complete once the results of its block are
+     written and its callback, if any, returned.  At most max_pending
+     blocks are submitted and not complete: submit then waits for the
+     oldest one, and try_submit returns false, which bounds the memory
+     held by blocks in flight.  The arrays of a block must stay valid and
+     unchanged until its ticket completes; the arrays of metrics and
+     results themselves are copied.  Without a threading backend submit
+     evaluates the block before it returns. */
+
+  //! A block of elements with a fixed node count and the metrics to evaluate on it.
+  /** See mesh_quality for the layout of the elements; average_size is passed
+      to the size-relative metrics.  results[m] receives num_elements values
+      of metrics[m]. */
+  struct QualityBlock
+  {
+    VerdictIndex num_elements;
+    int nodes_per_element;
+    const double* points;
+    const VerdictIndex* connectivity;
+    double average_size;
+    int num_metrics;
+    const VerdictMetric* metrics;
+    double* const* results;
+  };
+
+  //! Called on the thread of the queue once the results of the block of ticket are written.
+  /** Must not submit to or wait on the queue that calls it. */
+  typedef void (*QualityCallback)( void* data, VerdictIndex ticket );
+
+  //! Evaluates blocks of elements in the background, in the order they are submitted.
+  class VERDICT_EXPORT MeshQualityQueue
+  {
+  public:
+    //! A queue of at most max_pending blocks, each evaluated with num_threads threads.
+    /** max_pending < 1 is taken as 1. */
+    MeshQualityQueue( int max_pending, int num_threads );
+
+    //! Waits for every block submitted.
+    ~MeshQualityQueue();
+
+    int max_pending() const;
+
+    //! The number of blocks submitted and not complete.
+    int pending() const;
+
+    //! Queues a block, waiting while max_pending blocks are pending.
+    /** callback, when not null, is called with callback_data and the ticket
+        returned.  Returns the ticket of the block. */
+    VerdictIndex submit( const QualityBlock &block, QualityCallback callback, void* callback_data );
+
+    //! Queues a block unless max_pending blocks are pending.
+    /** Returns false, without queuing it, when the queue is full. */
+    bool try_submit( const QualityBlock &block, QualityCallback callback, void* callback_data,
+                     VerdictIndex &ticket );
+
+    //! Whether the block of a ticket is complete.
+    bool is_complete( VerdictIndex ticket ) const;
+
+    //! Waits until the block of a ticket is complete.
+    void wait( VerdictIndex ticket );
+
+    //! Waits until every block submitted is complete.
+    void wait_all();
+
+    struct Internals;
+
+  private:
+    MeshQualityQueue( const MeshQualityQueue& );
+    MeshQualityQueue& operator=( const MeshQualityQueue& );
+
+    Internals* internals;
+  };
+
+  //! Signature of the threshold predicates, such as hex_scaled_jacobian_at_least.
+  typedef bool (*VerdictPredicate)( int num_nodes, double coordinates[][3], double threshold );
+
+/* threshold checks for whole meshes */
+
+  /* failing is a bitmask of (num_elements + 63) / 64 words.  Bit e % 64 of
+     word e / 64 is set when element e fails the predicate and cleared
+     otherwise.  Elements with an invalid node count fail.  The elements are
+     evaluated as by parallel_mesh_quality; num_threads == 1 evaluates them
+     serially. */
+
+    //! Checks a predicate on every element of a mesh with mixed node counts.
+    /** See mesh_quality for the layout of the arguments.
+        Returns the number of failing elements. */
+    VERDICT_EXPORT VerdictIndex mesh_failing_elements( VerdictPredicate predicate,
+                                                       double threshold,
+                                                       VerdictIndex num_elements,
+                                                       const double* points,
+                                                       const VerdictIndex* connectivity,
+                                                       const VerdictIndex* offsets,
+                                                       unsigned long long* failing,
+                                                       int num_threads );
+
+    //! Checks a predicate on every element of a block with a fixed node count.
+    /** See mesh_quality for the layout of the arguments.
+        Returns the number of failing elements. */
+    VERDICT_EXPORT VerdictIndex mesh_failing_elements( VerdictPredicate predicate,
+                                                       double threshold,
+                                                       VerdictIndex num_elements,
+                                                       int nodes_per_element,
+                                                       const double* points,
+                                                       const VerdictIndex* connectivity,
+                                                       unsigned long long* failing,
+                                                       int num_threads );
+
+  //! Signature of the metric estimates, such as hex_jacobian_estimate.
+  typedef void (*VerdictEstimator)( int num_nodes, double coordinates[][3], MetricEstimate &estimate );
+
+/* screening of whole meshes */
+
+  /* The screens check function( element ) >= threshold on every element,
+     the exact metric of estimator, and fill failing as mesh_failing_elements
+     does.  An element whose lower bound is at least the threshold passes and
+     one whose upper bound is below it fails without evaluating function; the
+     others, and those with NaN bounds, are evaluated exactly.  Bit e % 64 of
+     word e / 64 of exact, when it is not null, is set for the elements
+     evaluated exactly.  results, when it is not null, receives the value of
+     function for those and the estimate for the others; elements with an
+     invalid node count fail with a result of 0. */
+
+    //! Screens every element of a mesh with mixed node counts.
+    /** See mesh_quality for the layout of the arguments.
+        Returns the number of failing elements. */
+    VERDICT_EXPORT VerdictIndex mesh_screen_elements( VerdictEstimator estimator,
+                                                      VerdictFunction function,
+                                                      double threshold,
+                                                      VerdictIndex num_elements,
+                                                      const double* points,
+                                                      const VerdictIndex* connectivity,
+                                                      const VerdictIndex* offsets,
+                                                      double* results,
+                                                      unsigned long long* failing,
+                                                      unsigned long long* exact,
+                                                      int num_threads );
+
+    //! Screens every element of a block with a fixed node count.
+    /** See mesh_quality for the layout of the arguments.
+        Returns the number of failing elements. */
+    VERDICT_EXPORT VerdictIndex mesh_screen_elements( VerdictEstimator estimator,
+                                                      VerdictFunction function,
+                                                      double threshold,
+                                                      VerdictIndex num_elements,
+                                                      int nodes_per_element,
+                                                      const double* points,
+                                                      const VerdictIndex* connectivity,
+                                                      double* results,
+                                                      unsigned long long* failing,
+                                                      unsigned long long* exact,
+                                                      int num_threads );
+
+  //! Space filling curves of mesh_element_order.
+  enum VerdictCurve
+  {
+    VERDICT_CURVE_MORTON,   //!< the Z curve, cheaper to compute but jumping at each power of two
+    VERDICT_CURVE_HILBERT   //!< consecutive cells of the curve always share a face
+  };
+
+/* cache-friendly traversal of meshes in file order */
+
+  /* The elements close to each other in space are often far apart in the
+     connectivity of a mesh, so gathering their nodes misses the cache and
+     the TLB on almost every element.  mesh_element_order sorts the
+     elements along a space filling curve through their centroids,
+     quantized to 2^21 cells along each side of the bounding box of the
+     centroids; elements in the same cell keep their relative order.
+     mesh_reorder copies the connectivity in that order and renumbers the
+     points in the order in which the elements first use them, so that
+     consecutive elements gather nodes from the same cache lines and pages.
+     ordered_mesh_quality evaluates the reordered mesh and writes the result
+     of each element at its original index.  The reordered copy is worth
+     making for a mesh evaluated repeatedly or with several metrics. */
+
+    //! Orders the elements of a mesh with mixed node counts along a space filling curve.
+    /** See mesh_quality for the layout of the arguments.  order receives
+        num_elements entries: the indices of the elements in curve order. */
+    VERDICT_EXPORT void mesh_element_order( VerdictCurve curve,
+                                            VerdictIndex num_elements,
+                                            const double* points,
+                                            const VerdictIndex* connectivity,
+                                            const VerdictIndex* offsets,
+                                            VerdictIndex* order,
+                                            int num_threads );
+
+    //! Orders the elements of a block with a fixed node count along a space filling curve.
+    /** See mesh_quality for the layout of the arguments.  order receives
+        num_elements entries: the indices of the elements in curve order. */
+    VERDICT_EXPORT void mesh_element_order( VerdictCurve curve,
+                                            VerdictIndex num_elements,
+                                            int nodes_per_element,
+                                            const double* points,
+                                            const VerdictIndex* connectivity,
+                                            VerdictIndex* order,
+                                            int num_threads );
+
+    //! Copies a mesh with mixed node counts with its elements in a given order.
+    /** Element i of new_connectivity and new_offsets, which holds
+        num_elements+1 entries starting at 0, is element order[i].  When
+        new_points is not null, it receives the num_points points renumbered
+        in their order of first use by the reordered elements, the points
+        no element uses last, and new_connectivity refers to them; otherwise
+        new_connectivity refers to points.  The outputs may not overlap the
+        inputs. */
+    VERDICT_EXPORT void mesh_reorder( VerdictIndex num_elements,
+                                      const double* points,
+                                      VerdictIndex num_points,
+                                      const VerdictIndex* connectivity,
+                                      const VerdictIndex* offsets,
+                                      const VerdictIndex* order,
+                                      double* new_points,
+                                      VerdictIndex* new_connectivity,
+                                      VerdictIndex* new_offsets );
+
+    //! Copies a block with a fixed node count with its elements in a given order.
+    /** See the mixed node count version. */
+    VERDICT_EXPORT void mesh_reorder( VerdictIndex num_elements,
+                                      int nodes_per_element,
+                                      const double* points,
+                                      VerdictIndex num_points,
+                                      const VerdictIndex* connectivity,
+                                      const VerdictIndex* order,
+                                      double* new_points,
+                                      VerdictIndex* new_connectivity );
+
+    //! Calculates a metric for every element of a reordered mesh with mixed node counts.
+    /** The arguments are as for parallel_mesh_quality, for a mesh copied by
+        mesh_reorder in the given order: the result of element i of the copy
+        goes to results[order[i]]. */
+    VERDICT_EXPORT void ordered_mesh_quality( VerdictFunction metric,
+                                              VerdictIndex num_elements,
+                                              const double* points,
+                                              const VerdictIndex* connectivity,
+                                              const VerdictIndex* offsets,
+                                              const VerdictIndex* order,
+                                              double* results,
+                                              int num_threads );
+
+    //! Calculates a metric for every element of a reordered block with a fixed node count.
+    /** The arguments are as for parallel_mesh_quality, for a block copied by
+        mesh_reorder in the given order: the result of element i of the copy
+        goes to results[order[i]]. */
+    VERDICT_EXPORT void ordered_mesh_quality( VerdictFunction metric,
+                                              VerdictIndex num_elements,
+                                              int nodes_per_element,
+                                              const double* points,
+                                              const VerdictIndex* connectivity,
+                                              const VerdictIndex* order,
+                                              double* results,
+                                              int num_threads );
+
+  //! Element types of the size-relative mesh functions.
+  enum VerdictSizeElement
+  {
+    VERDICT_SIZE_TRI,
+    VERDICT_SIZE_QUAD,
+    VERDICT_SIZE_TET,
+    VERDICT_SIZE_HEX
+  };
+
+  //! Size-relative metrics evaluated by mesh_size_quality.
+  enum VerdictSizeMetric
+  {
+    VERDICT_RELATIVE_SIZE_SQUARED,  //!< *_relative_size_squared
+    VERDICT_SHAPE_AND_SIZE,         //!< *_shape_and_size
+    VERDICT_SHEAR_AND_SIZE          //!< *_shear_and_size, quads and hexes only
+  };
+
+/* size-relative quality functions for whole meshes */
+
+  /* The relative size metrics compare each element with the average size
+     of the mesh.  Instead of a pass over hex_volume, tet_volume, tri_area
+     or quad_area to find that average, followed by the metric recomputing
+     each size, mesh_element_sizes measures every element once and
+     mesh_size_quality evaluates the relative size from those measures,
+     without reading the coordinates again.  The shape and shear factors
+     of the combined metrics still need the coordinates.  The results are
+     exactly those of the single element functions given the returned
+     average.  For per block averages, call the functions on each block. */
+
+    //! Measures the size of every element of a block and returns the average size.
+    /** The average is the mean of hex_volume, tet_volume, tri_area or
+        quad_area, as passed to the single element metrics.  measures
+        receives one entry per element, in the units the relative size
+        metrics compare, to be passed to mesh_size_quality.
+        Returns 0 for an empty block or an invalid nodes_per_element. */
+    VERDICT_EXPORT double mesh_element_sizes( VerdictSizeElement type,
+                                              VerdictIndex num_elements,
+                                              int nodes_per_element,
+                                              const double* points,
+                                              const VerdictIndex* connectivity,
+                                              double* measures,
+                                              int num_threads );
+
+    //! Calculates a size-relative metric from the output of mesh_element_sizes.
+    /** results may be the measures array, which is then overwritten.
+        Unsupported combinations of type and metric give 0. */
+    VERDICT_EXPORT void mesh_size_quality( VerdictSizeElement type,
+                                           VerdictSizeMetric metric,
+                                           VerdictIndex num_elements,
+                                           int nodes_per_element,
+                                           const double* points,
+                                           const VerdictIndex* connectivity,
+                                           const double* measures,
+                                           double average_size,
+                                           double* results,
+                                           int num_threads );
+
+    //! Calculates a size-relative metric relative to the average over the block.
+    /** Runs both passes, keeping the measures in results.  Returns the average size. */
+    VERDICT_EXPORT double mesh_size_quality( VerdictSizeElement type,
+                                             VerdictSizeMetric metric,
+                                             VerdictIndex num_elements,
+                                             int nodes_per_element,
+                                             const double* points,
+                                             const VerdictIndex* connectivity,
+                                             double* results,
+                                             int num_threads );
+
+  //! The stable timestep of a mesh, found by mesh_timestep.
+  struct MeshTimestep
+  {
+    double minimum;             //!< smallest timestep, VERDICT_DBL_MAX for no elements
+    VerdictIndex element;       //!< element with the smallest timestep, -1 for no elements
+    VerdictIndex num_inverted;  //!< number of inverted elements
+  };
+
+/* explicit timestep of whole meshes */
+
+  /* An explicit solver needs the stable timestep of its mesh every cycle,
+     and needs to know whether moving the mesh inverted an element.
+     Instead of a hex_timestep or tet_timestep pass followed by a scaled
+     jacobian pass, mesh_timestep reads the coordinates of each element
+     once and finds its characteristic length and whether it is inverted
+     together; for linear tets both come from the same corner jacobian.
+     Apart from the partial minima of the threads, which live in scratch
+     memory, nothing is allocated. */
+
+    //! Calculates the timestep of every element of a block and the smallest one.
+    /** type is VERDICT_ELEMENT_HEX, for which the first 8 nodes are used, or
+        VERDICT_ELEMENT_TET.  density, poissons_ratio and youngs_modulus hold
+        one entry per element.  timesteps, when not null, receives what
+        hex_timestep or tet_timestep returns for each element.  inverted,
+        when not null, receives 1 for each element with a corner jacobian
+        that is not positive, which for 10 node tets includes their subtets,
+        and 0 otherwise.  Inverted elements take part in the minimum with
+        their timestep, which may be negative for tets; NaN timesteps do not.
+        The smallest timestep goes to the element with the smaller index on
+        ties, so the result does not depend on num_threads.  Other element
+        types or too few nodes per element give num_inverted = 0, no
+        minimum and zero outputs. */
+    VERDICT_EXPORT void mesh_timestep( VerdictElementType type,
+                                       VerdictIndex num_elements,
+                                       int nodes_per_element,
+                                       const double* points,
+                                       const VerdictIndex* connectivity,
+                                       const double* density,
+                                       const double* poissons_ratio,
+                                       const double* youngs_modulus,
+                                       double* timesteps,
+                                       unsigned char* inverted,
+                                       MeshTimestep &timestep,
+                                       int num_threads );
+
+  //! Instruction sets the structure-of-arrays kernels can use.
+  enum VerdictSimdLevel
+  {
+    VERDICT_SIMD_SCALAR = 0,
+    VERDICT_SIMD_NEON,
+    VERDICT_SIMD_AVX2,
+    VERDICT_SIMD_AVX512
+  };
+
+    //! Returns the instruction set used by the structure-of-arrays kernels.
+    /** By default this is the widest one that was compiled in and that the
+        CPU supports. */
+    VERDICT_EXPORT VerdictSimdLevel simd_level();
+
+    //! Selects the instruction set used by the structure-of-arrays kernels.
+    /** Levels that are not available fall back to the next narrower one,
+        down to VERDICT_SIMD_SCALAR, which loops over the single element
+        functions.  Returns the level actually selected.  Mainly useful to
+        compare kernels in tests and benchmarks. */
+    VERDICT_EXPORT VerdictSimdLevel set_simd_level( VerdictSimdLevel level );
+
+/* quality functions for batches of linear elements in structure-of-arrays form */
+
+  /* In the functions below coordinate component c (0 = x, 1 = y, 2 = z) of
+     node n of element e is coordinates[(3*n + c)*stride + e], with
+     stride >= num_elements.  results receives one value per element, equal
+     to what the single element function returns for that element. */
+
+  /* Each function also has two overloads taking float coordinates.  The
+     one writing float results computes in single precision, with twice as
+     many elements per vector instruction; it agrees with the double
+     function to about single precision on reasonably shaped elements.  The
+     one writing double results widens the coordinates and computes in
+     double, which keeps the determinants of nearly degenerate elements
+     accurate while still halving the coordinate bandwidth. */
+
+    //! Calculates tet_volume for a batch of 4 node tets.
+    VERDICT_EXPORT void tet_volume_soa( VerdictIndex num_elements, const double* coordinates,
+                                        VerdictIndex stride, double* results );
+    VERDICT_EXPORT void tet_volume_soa( VerdictIndex num_elements, const float* coordinates,
+                                        VerdictIndex stride, float* results );
+    VERDICT_EXPORT void tet_volume_soa( VerdictIndex num_elements, const float* coordinates,
+                                        VerdictIndex stride, double* results );
+
+    //! Calculates tet_scaled_jacobian for a batch of 4 node tets.
+    VERDICT_EXPORT void tet_scaled_jacobian_soa( VerdictIndex num_elements, const double* coordinates,
+                                                 VerdictIndex stride, double* results );
+    VERDICT_EXPORT void tet_scaled_jacobian_soa( VerdictIndex num_elements, const float* coordinates,
+                                                 VerdictIndex stride, float* results );
+    VERDICT_EXPORT void tet_scaled_jacobian_soa( VerdictIndex num_elements, const float* coordinates,
+                                                 VerdictIndex stride, double* results );
+
+    //! Calculates tet_mean_ratio for a batch of 4 node tets.
+    VERDICT_EXPORT void tet_mean_ratio_soa( VerdictIndex num_elements, const double* coordinates,
+                                            VerdictIndex stride, double* results );
+    VERDICT_EXPORT void tet_mean_ratio_soa( VerdictIndex num_elements, const float* coordinates,
+                                            VerdictIndex stride, float* results );
+    VERDICT_EXPORT void tet_mean_ratio_soa( VerdictIndex num_elements, const float* coordinates,
+                                            VerdictIndex stride, double* results );
+
+    //! Calculates hex_scaled_jacobian for a batch of 8 node hexes.
+    VERDICT_EXPORT void hex_scaled_jacobian_soa( VerdictIndex num_elements, const double* coordinates,
+                                                 VerdictIndex stride, double* results );
+    VERDICT_EXPORT void hex_scaled_jacobian_soa( VerdictIndex num_elements, const float* coordinates,
+                                                 VerdictIndex stride, float* results );
+    VERDICT_EXPORT void hex_scaled_jacobian_soa( VerdictIndex num_elements, const float* coordinates,
+                                                 VerdictIndex stride, double* results );
+
+    //! Calculates hex_nodal_jacobian_ratio for a batch of 8 node hexes.
+    VERDICT_EXPORT void hex_nodal_jacobian_ratio_soa( VerdictIndex num_elements, const double* coordinates,
+                                                      VerdictIndex stride, double* results );
+    VERDICT_EXPORT void hex_nodal_jacobian_ratio_soa( VerdictIndex num_elements, const float* coordinates,
+                                                      VerdictIndex stride, float* results );
+    VERDICT_EXPORT void hex_nodal_jacobian_ratio_soa( VerdictIndex num_elements, const float* coordinates,
+                                                      VerdictIndex stride, double* results );
+
+/* surface quality functions for batches of quads and tris in structure-of-arrays form */
+
+  /* The coordinates are laid out as above.  The functions below share the
+     edges, corner normals and corner areas of each element across the
+     metrics they compute, and find the minimum angle as the largest
+     cosine, so acos is only called when the angles are asked for in
+     degrees.  They compute in double precision and agree with the single
+     element functions to rounding; the cosines the single element
+     functions round past 1 are clamped. */
+
+  //! The arrays the surface quality functions fill; null arrays are skipped.
+  struct SurfaceQualityArrays
+  {
+    double* scaled_jacobian;       //!< quad_scaled_jacobian or tri_scaled_jacobian
+    double* warpage;               //!< quad_warpage; ignored for tris
+    double* minimum_angle;         //!< quad_minimum_angle or tri_minimum_angle, in degrees
+    double* minimum_angle_cosine;  //!< the cosine of the minimum angle
+  };
+
+    //! Calculates the surface quality metrics of a batch of 4 node quads.
+    /** Quads collapsed to a tri, with node 3 on node 2, get the metrics of the
+        tri, as the single element functions give them.  The vectorized
+        kernels clamp the cosines of the angles to [-1, 1], so a quad with an
+        angle of 0 degrees, such as one with node 2 on node 0, gets 0 where
+        rounding makes quad_minimum_angle skip that angle and return one of
+        the others. */
+    VERDICT_EXPORT void quad_quality_soa( VerdictIndex num_elements, const double* coordinates,
+                                          VerdictIndex stride, const SurfaceQualityArrays &results );
+
+    //! Calculates the surface quality metrics of a batch of 3 node tris.
+    VERDICT_EXPORT void tri_quality_soa( VerdictIndex num_elements, const double* coordinates,
+                                         VerdictIndex stride, const SurfaceQualityArrays &results );
+
+    //! Calculates quad_scaled_jacobian for a batch of 4 node quads.
+    VERDICT_EXPORT void quad_scaled_jacobian_soa( VerdictIndex num_elements, const double* coordinates,
+                                                  VerdictIndex stride, double* results );
+
+    //! Calculates quad_warpage for a batch of 4 node quads.
+    VERDICT_EXPORT void quad_warpage_soa( VerdictIndex num_elements, const double* coordinates,
+                                          VerdictIndex stride, double* results );
+
+    //! Calculates quad_minimum_angle for a batch of 4 node quads.
+    /** Except for the angles of 0 degrees noted at quad_quality_soa. */
+    VERDICT_EXPORT void quad_minimum_angle_soa( VerdictIndex num_elements, const double* coordinates,
+                                                VerdictIndex stride, double* results );
+
+    //! Calculates tri_minimum_angle for a batch of 3 node tris.
+    VERDICT_EXPORT void tri_minimum_angle_soa( VerdictIndex num_elements, const double* coordinates,
+                                               VerdictIndex stride, double* results );
+
+} // namespace verdict
+
+#endif
@@ -0,0 +1,132 @@
+/*=========================================================================
+
+  Module:    verdict_mpi.h
+
+  Copyright 2003,2006,2019 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+  Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government retains certain rights in this software.
+
+  See LICENSE for details.
+
+=========================================================================*/
+
+/*! \file verdict_mpi.h
+  \brief Header file for the distributed-memory interface to the verdict library.
+ *
+ * verdict_mpi.h declares mesh-level functions over meshes decomposed
+ *           across the ranks of an MPI communicator.  Each rank passes
+ *           its part of the mesh, ghost elements included, with a mask
+ *           of the elements it owns; only owned elements are counted, so
+ *           the result is that of the whole mesh on one process.  The
+ *           functions are collective and must be called by every rank.
+ *           Built only with VERDICT_ENABLE_MPI.
+ *
+ * This file is part of VERDICT
+ *
+ */
+
+#ifndef __verdict_mpi_h
+#define __verdict_mpi_h
+
+#include "verdict_mesh.h"
+
+#include <mpi.h>
+
+namespace VERDICT_NAMESPACE
+{
+
+/* statistics of a metric over decomposed meshes */
+
+  /* Each rank evaluates its elements as by mesh_statistics and gathers
+     the statistics of the owned ones; a single MPI_Allreduce then
+     merges the statistics of all ranks, in rank order, so every rank
+     gets the same statistics.  owned[e] != 0 marks the elements the rank
+     owns; a null owned means every element is owned.  global_ids, when
+     not null, gives the number of each element in the whole mesh, which
+     numbers the worst elements; otherwise they are numbered by their
+     index on their rank, which only identifies them when the worst
+     values are distinct.  All ranks must pass the same request, and the
+     ranks are assumed to share one binary representation of doubles. */
+
+    //! Calculates statistics of a metric over a decomposed mesh with mixed node counts.
+    /** See mesh_quality for the layout of the arguments.  results, when not
+        null, receives the metric of every element, ghosts included. */
+    VERDICT_EXPORT void mpi_mesh_statistics( MPI_Comm comm,
+                                             VerdictFunction metric,
+                                             VerdictIndex num_elements,
+                                             const double* points,
+                                             const VerdictIndex* connectivity,
+                                             const VerdictIndex* offsets,
+                                             const unsigned char* owned,
+                                             const VerdictIndex* global_ids,
+                                             const MeshStatisticsRequest &request,
+                                             double* results,
+                                             MeshStatistics &statistics,
+                                             int num_threads );
+
+    //! Calculates statistics of a metric over a decomposed block with a fixed node count.
+    /** See mesh_quality for the layout of the arguments.  results, when not
+        null, receives the metric of every element, ghosts included. */
+    VERDICT_EXPORT void mpi_mesh_statistics( MPI_Comm comm,
+                                             VerdictFunction metric,
+                                             VerdictIndex num_elements,
+                                             int nodes_per_element,
+                                             const double* points,
+                                             const VerdictIndex* connectivity,
+                                             const unsigned char* owned,
+                                             const VerdictIndex* global_ids,
+                                             const MeshStatisticsRequest &request,
+                                             double* results,
+                                             MeshStatistics &statistics,
+                                             int num_threads );
+
+    //! Merges the statistics each rank gathered over its own elements.
+    /** For statistics computed otherwise, such as by stream_mesh_quality
+        over the elements a rank owns, numbered by their global ids.  On
+        return every rank holds the statistics of all ranks. */
+    VERDICT_EXPORT void mpi_reduce_statistics( MPI_Comm comm,
+                                               const MeshStatisticsRequest &request,
+                                               MeshStatistics &statistics );
+
+/* size-relative quality functions for decomposed meshes */
+
+  /* The relative size metrics compare each element with the average size
+     of the whole mesh.  Each rank measures its elements as by
+     mesh_element_sizes, a single MPI_Allreduce adds up the sizes and the
+     number of the owned elements, and each rank evaluates the metric of
+     its elements, ghosts included, relative to the global average.  The
+     results are those of mesh_size_quality on the undecomposed mesh,
+     except that the global sum of the sizes may round differently. */
+
+    //! Calculates a size-relative metric relative to the average over a decomposed block.
+    /** Keeps the measures in results.  Returns the global average size. */
+    VERDICT_EXPORT double mpi_mesh_size_quality( MPI_Comm comm,
+                                                 VerdictSizeElement type,
+                                                 VerdictSizeMetric metric,
+                                                 VerdictIndex num_elements,
+                                                 int nodes_per_element,
+                                                 const double* points,
+                                                 const VerdictIndex* connectivity,
+                                                 const unsigned char* owned,
+                                                 double* results,
+                                                 int num_threads );
+
+    //! Calculates a size-relative metric and its statistics over a decomposed block.
+    /** As the function above followed by mpi_mesh_statistics of the results,
+        in two collectives in all. */
+    VERDICT_EXPORT double mpi_mesh_size_quality( MPI_Comm comm,
+                                                 VerdictSizeElement type,
+                                                 VerdictSizeMetric metric,
+                                                 VerdictIndex num_elements,
+                                                 int nodes_per_element,
+                                                 const double* points,
+                                                 const VerdictIndex* connectivity,
+                                                 const unsigned char* owned,
+                                                 const VerdictIndex* global_ids,
+                                                 const MeshStatisticsRequest &request,
+                                                 double* results,
+                                                 MeshStatistics &statistics,
+                                                 int num_threads );
+
+} // namespace verdict
+
+#endif